@@ -148,6 +148,7 @@ int64_t getTimerFrequency()
 /************************************************************************/
 #include "../Interfaces/IApp.h"
 #include "../Interfaces/IFileSystem.h"
+#include "../Core/CpuFeatures.h"
 
 static IApp* pApp = NULL;
 
@@ -286,6 +287,9 @@ int AndroidMain(void* param, IApp* app)
 
 	FileSystem::SetCurrentDir(FileSystem::GetProgramDir());
 
+	// Kernels are bound to the CPU during static initialization, report what they picked
+	logCpuKernels();
+
 	IApp::Settings* pSettings = &pApp->mSettings;
 
 	if (!pApp->Init())
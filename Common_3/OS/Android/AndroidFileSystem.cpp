@@ -26,6 +26,7 @@
 #include "../Interfaces/IFileSystem.h"
 #include "../Interfaces/ILogManager.h"
 #include "../Interfaces/IOperatingSystem.h"
+#include "../Interfaces/IThread.h"
 #include "../Interfaces/IMemoryManager.h"
 #include <unistd.h>
 #include <android/asset_manager.h>
@@ -82,18 +83,41 @@ size_t _readFile(void *buffer, size_t byteCount, FileHandle handle)
 	return readSize;
 }
 
-bool _seekFile(FileHandle handle, long offset, int origin)
+// Assets have no positional read, seek and read are serialized and the position of the asset is restored
+static Mutex gReadAtMutex;
+
+size_t _readFileAt(void *buffer, size_t byteCount, uint64_t offset, FileHandle handle)
+{
+	AAsset* assetHandle = reinterpret_cast<AAsset*>(handle);
+	MutexLock lock(gReadAtMutex);
+	off64_t oldPos = AAsset_seek64(assetHandle, 0, SEEK_CUR);
+	if (AAsset_seek64(assetHandle, (off64_t)offset, SEEK_SET) == -1)
+		return 0;
+
+	size_t bytesRead = 0;
+	while (bytesRead < byteCount)
+	{
+		int result = AAsset_read(assetHandle, (char*)buffer + bytesRead, byteCount - bytesRead);
+		if (result <= 0)
+			break;
+		bytesRead += (size_t)result;
+	}
+
+	AAsset_seek64(assetHandle, oldPos, SEEK_SET);
+	return bytesRead;
+}
+
+bool _seekFile(FileHandle handle, int64_t offset, int origin)
 {
 	// Seek function return -s on error.
-	return AAsset_seek(reinterpret_cast<AAsset*>(handle), offset, origin) != -1;
+	return AAsset_seek64(reinterpret_cast<AAsset*>(handle), (off64_t)offset, origin) != -1;
 }
 
-long _tellFile(FileHandle handle)
+int64_t _tellFile(FileHandle handle)
 {
-	size_t total_len = AAsset_getLength(reinterpret_cast<AAsset*>(handle));
-	size_t remain_len = AAsset_getRemainingLength(reinterpret_cast<AAsset*>(handle));
-	return total_len - remain_len;
-	//AAsset_getLength(reinterpret_cast<AAsset*>(handle));
+	off64_t total_len = AAsset_getLength64(reinterpret_cast<AAsset*>(handle));
+	off64_t remain_len = AAsset_getRemainingLength64(reinterpret_cast<AAsset*>(handle));
+	return (int64_t)(total_len - remain_len);
 }
 
 size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
@@ -105,6 +129,33 @@ size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
 	return -1;
 }
 
+void* _mapFile(const char* filename, size_t* pSize, FileHandle* pMapping)
+{
+	// Assets can be compressed inside the apk and their buffers are read only, so the asset is copied instead
+	AAsset* file = AAssetManager_open(_mgr, filename, AASSET_MODE_BUFFER);
+	if (!file)
+		return NULL;
+
+	size_t size = AAsset_getLength(file);
+	void* pData = size ? conf_malloc(size) : NULL;
+	if (pData && AAsset_read(file, pData, size) != (int)size)
+	{
+		conf_free(pData);
+		pData = NULL;
+	}
+	AAsset_close(file);
+
+	*pSize = size;
+	*pMapping = NULL;
+	return pData;
+}
+
+// The asset was copied into memory, there is no mapping to release
+void _unmapFile(void* pData, size_t /*size*/, FileHandle /*mapping*/)
+{
+	conf_free(pData);
+}
+
 size_t _getFileLastModifiedTime(const char* _fileName)
 {
 	LOGERROR("FileSystem::Last Modified Time not supported in Android!");
@@ -0,0 +1,668 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif !defined(__ANDROID__)
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
+// io_uring is used through its system calls, liburing is not required
+#if defined(__linux__) && !defined(__ANDROID__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define USE_IO_URING
+#endif
+#endif
+#endif
+
+#include "../Interfaces/IFileSystem.h"
+#include "../Interfaces/IThread.h"
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+#define ASYNC_READ_NONE 0xFFFFFFFFu
+
+typedef struct AsyncFile
+{
+#if defined(_WIN32)
+	HANDLE   mHandle;
+#elif defined(__ANDROID__)
+	FileHandle pHandle;
+#else
+	int      mFd;
+#endif
+	uint64_t mSize;
+	bool     mDirectIO;
+} AsyncFile;
+
+typedef struct AsyncRead
+{
+	AsyncFile*        pFile;
+	void*             pDst;
+	AsyncReadCallback pCallback;
+	void*             pUserData;
+	uint64_t          mOffset;
+	size_t            mSize;
+	size_t            mBytesRead;
+	// Incremented when the read is recycled. Tokens with an older generation are complete
+	uint32_t          mGeneration;
+	uint32_t          mNextFree;
+	bool              mSuccess;
+	bool              mCloseFile;
+#ifdef USE_IO_URING
+	// Vectored reads are used as they are available since the first io_uring kernel
+	struct iovec      mIoVec;
+#endif
+} AsyncRead;
+
+struct AsyncFileReaderState
+{
+	AsyncFileReaderDesc       mDesc;
+	AsyncRead*                pReads;
+	uint32_t                  mFirstFree;
+	// Reads queued by ReadAsync which were not started yet
+	tinystl::vector<uint32_t> mQueued;
+	// Reads completed by the last Poll
+	tinystl::vector<uint32_t> mPolled;
+
+#ifdef USE_IO_URING
+	int                       mRingFd;
+	void*                     pSqRing;
+	size_t                    mSqRingSize;
+	void*                     pCqRing;
+	size_t                    mCqRingSize;
+	io_uring_sqe*             pSqes;
+	size_t                    mSqesSize;
+	uint32_t*                 pSqHead;
+	uint32_t*                 pSqTail;
+	uint32_t*                 pSqArray;
+	uint32_t                  mSqMask;
+	uint32_t                  mSqEntries;
+	uint32_t*                 pCqHead;
+	uint32_t*                 pCqTail;
+	io_uring_cqe*             pCqes;
+	uint32_t                  mCqMask;
+	uint32_t                  mNumInFlight;
+#endif
+
+	// Worker threads, used when io_uring is not available
+	tinystl::vector<ThreadHandle> mThreads;
+	tinystl::vector<WorkItem> mThreadItems;
+	tinystl::vector<uint32_t> mWorkQueue;
+	Mutex                     mWorkMutex;
+	ConditionVariable         mWorkCondition;
+	tinystl::vector<uint32_t> mCompleted;
+	Mutex                     mCompletedMutex;
+	ConditionVariable         mCompletedCondition;
+	volatile bool             mQuit;
+};
+
+/************************************************************************/
+// Platform file access
+/************************************************************************/
+static AsyncFile* openAsyncFile(const tinystl::string& fileName, bool directIO)
+{
+#if defined(_WIN32)
+	HANDLE handle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, directIO ? FILE_FLAG_NO_BUFFERING : FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	LARGE_INTEGER size = {};
+	GetFileSizeEx(handle, &size);
+	AsyncFile* pFile = conf_placement_new<AsyncFile>(conf_calloc(1, sizeof(AsyncFile)));
+	pFile->mHandle = handle;
+	pFile->mSize = (uint64_t)size.QuadPart;
+#elif defined(__ANDROID__)
+	FileHandle handle = _openFile(fileName.c_str(), "rb");
+	if (!handle)
+		return NULL;
+
+	AsyncFile* pFile = conf_placement_new<AsyncFile>(conf_calloc(1, sizeof(AsyncFile)));
+	pFile->pHandle = handle;
+	pFile->mSize = FileSystem::GetFileSize(handle);
+	directIO = false;
+#else
+#if defined(__APPLE__)
+	const int directFlag = 0;
+#else
+	const int directFlag = O_DIRECT;
+#endif
+	int fd = open(fileName.c_str(), O_RDONLY | (directIO ? directFlag : 0));
+	if (fd < 0 && directIO && errno == EINVAL)
+	{
+		// Some file systems like tmpfs do not support direct I/O
+		LOGWARNINGF("Direct I/O is not supported for %s, using buffered reads", fileName.c_str());
+		directIO = false;
+		fd = open(fileName.c_str(), O_RDONLY);
+	}
+	if (fd < 0)
+		return NULL;
+
+#if defined(__APPLE__)
+	if (directIO)
+		fcntl(fd, F_NOCACHE, 1);
+#endif
+
+	struct stat fileInfo;
+	if (fstat(fd, &fileInfo) != 0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	AsyncFile* pFile = conf_placement_new<AsyncFile>(conf_calloc(1, sizeof(AsyncFile)));
+	pFile->mFd = fd;
+	pFile->mSize = (uint64_t)fileInfo.st_size;
+#endif
+	pFile->mDirectIO = directIO;
+	return pFile;
+}
+
+static void closeAsyncFile(AsyncFile* pFile)
+{
+#if defined(_WIN32)
+	CloseHandle(pFile->mHandle);
+#elif defined(__ANDROID__)
+	_closeFile(pFile->pHandle);
+#else
+	close(pFile->mFd);
+#endif
+	pFile->~AsyncFile();
+	conf_free(pFile);
+}
+
+// Reads until size bytes were read or the end of the file is reached
+static bool readAsyncFile(AsyncFile* pFile, uint64_t offset, size_t size, void* pDst, size_t* pBytesRead)
+{
+	size_t bytesRead = 0;
+	bool success = true;
+#if defined(_WIN32)
+	while (bytesRead < size && offset + bytesRead < pFile->mSize)
+	{
+		// The handle is not overlapped, the offset of the OVERLAPPED makes ReadFile positional
+		const uint64_t position = offset + bytesRead;
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)position;
+		overlapped.OffsetHigh = (DWORD)(position >> 32);
+		const DWORD chunkSize = (DWORD)(size - bytesRead < (1u << 30) ? size - bytesRead : (1u << 30));
+		DWORD chunkRead = 0;
+		if (!ReadFile(pFile->mHandle, (uint8_t*)pDst + bytesRead, chunkSize, &chunkRead, &overlapped))
+		{
+			success = GetLastError() == ERROR_HANDLE_EOF;
+			break;
+		}
+		if (chunkRead == 0)
+			break;
+		bytesRead += chunkRead;
+	}
+#elif defined(__ANDROID__)
+	bytesRead = _readFileAt(pDst, size, offset, pFile->pHandle);
+#else
+	while (bytesRead < size && offset + bytesRead < pFile->mSize)
+	{
+		const ssize_t chunkRead = pread(pFile->mFd, (uint8_t*)pDst + bytesRead, size - bytesRead, (off_t)(offset + bytesRead));
+		if (chunkRead < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			success = false;
+			break;
+		}
+		if (chunkRead == 0)
+			break;
+		bytesRead += (size_t)chunkRead;
+	}
+#endif
+	*pBytesRead = bytesRead;
+	return success;
+}
+
+/************************************************************************/
+// io_uring backend
+/************************************************************************/
+#ifdef USE_IO_URING
+static bool initIoUring(AsyncFileReaderState* pState, uint32_t queueDepth)
+{
+	io_uring_params params = {};
+	const int fd = (int)syscall(__NR_io_uring_setup, queueDepth, &params);
+	// Fails on kernels before 5.1 and where io_uring is disabled
+	if (fd < 0)
+		return false;
+
+	// The rings are mapped separately, which every io_uring kernel supports
+	pState->mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	pState->mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	pState->mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* pSqRing = mmap(NULL, pState->mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	void* pCqRing = mmap(NULL, pState->mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	void* pSqes = mmap(NULL, pState->mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (pSqRing == MAP_FAILED || pCqRing == MAP_FAILED || pSqes == MAP_FAILED)
+	{
+		if (pSqRing != MAP_FAILED)
+			munmap(pSqRing, pState->mSqRingSize);
+		if (pCqRing != MAP_FAILED)
+			munmap(pCqRing, pState->mCqRingSize);
+		if (pSqes != MAP_FAILED)
+			munmap(pSqes, pState->mSqesSize);
+		close(fd);
+		return false;
+	}
+
+	uint8_t* pSq = (uint8_t*)pSqRing;
+	uint8_t* pCq = (uint8_t*)pCqRing;
+	pState->mRingFd = fd;
+	pState->pSqRing = pSqRing;
+	pState->pCqRing = pCqRing;
+	pState->pSqes = (io_uring_sqe*)pSqes;
+	pState->pSqHead = (uint32_t*)(pSq + params.sq_off.head);
+	pState->pSqTail = (uint32_t*)(pSq + params.sq_off.tail);
+	pState->pSqArray = (uint32_t*)(pSq + params.sq_off.array);
+	pState->mSqMask = *(uint32_t*)(pSq + params.sq_off.ring_mask);
+	pState->mSqEntries = params.sq_entries;
+	pState->pCqHead = (uint32_t*)(pCq + params.cq_off.head);
+	pState->pCqTail = (uint32_t*)(pCq + params.cq_off.tail);
+	pState->pCqes = (io_uring_cqe*)(pCq + params.cq_off.cqes);
+	pState->mCqMask = *(uint32_t*)(pCq + params.cq_off.ring_mask);
+	pState->mNumInFlight = 0;
+	return true;
+}
+
+static void exitIoUring(AsyncFileReaderState* pState)
+{
+	munmap(pState->pSqes, pState->mSqesSize);
+	munmap(pState->pCqRing, pState->mCqRingSize);
+	munmap(pState->pSqRing, pState->mSqRingSize);
+	close(pState->mRingFd);
+	pState->mRingFd = -1;
+}
+
+// Moves as many queued reads as fit into the submission ring and submits them with one system call
+static void submitIoUring(AsyncFileReaderState* pState)
+{
+	uint32_t tail = *pState->pSqTail;
+	uint32_t numQueued = 0;
+	while (numQueued < (uint32_t)pState->mQueued.size() && pState->mNumInFlight < pState->mSqEntries)
+	{
+		const uint32_t readIndex = pState->mQueued[numQueued++];
+		AsyncRead& read = pState->pReads[readIndex];
+		read.mIoVec.iov_base = (uint8_t*)read.pDst + read.mBytesRead;
+		read.mIoVec.iov_len = read.mSize - read.mBytesRead;
+
+		const uint32_t sqIndex = tail & pState->mSqMask;
+		io_uring_sqe* pSqe = &pState->pSqes[sqIndex];
+		memset(pSqe, 0, sizeof(*pSqe));
+		pSqe->opcode = IORING_OP_READV;
+		pSqe->fd = read.pFile->mFd;
+		pSqe->off = read.mOffset + read.mBytesRead;
+		pSqe->addr = (uint64_t)(uintptr_t)&read.mIoVec;
+		pSqe->len = 1;
+		pSqe->user_data = readIndex;
+		pState->pSqArray[sqIndex] = sqIndex;
+		++tail;
+		++pState->mNumInFlight;
+	}
+
+	if (numQueued)
+	{
+		pState->mQueued.erase(pState->mQueued.begin(), pState->mQueued.begin() + numQueued);
+		__atomic_store_n(pState->pSqTail, tail, __ATOMIC_RELEASE);
+	}
+
+	// Entries the kernel could not take on an earlier call are submitted again
+	const uint32_t toSubmit = tail - __atomic_load_n(pState->pSqHead, __ATOMIC_ACQUIRE);
+	if (toSubmit)
+		syscall(__NR_io_uring_enter, pState->mRingFd, toSubmit, 0, 0, NULL, 0);
+}
+
+// Takes the completions off the completion ring. Reads that came back short before the end of the file are queued again for the rest
+static void reapIoUring(AsyncFileReaderState* pState, tinystl::vector<uint32_t>& completed)
+{
+	uint32_t head = *pState->pCqHead;
+	const uint32_t tail = __atomic_load_n(pState->pCqTail, __ATOMIC_ACQUIRE);
+	for (; head != tail; ++head)
+	{
+		const io_uring_cqe& cqe = pState->pCqes[head & pState->mCqMask];
+		const uint32_t readIndex = (uint32_t)cqe.user_data;
+		AsyncRead& read = pState->pReads[readIndex];
+		--pState->mNumInFlight;
+
+		if (cqe.res < 0)
+		{
+			if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+			{
+				pState->mQueued.push_back(readIndex);
+				continue;
+			}
+			read.mSuccess = false;
+		}
+		else
+		{
+			read.mBytesRead += (size_t)cqe.res;
+			if (cqe.res > 0 && read.mBytesRead < read.mSize && read.mOffset + read.mBytesRead < read.pFile->mSize)
+			{
+				pState->mQueued.push_back(readIndex);
+				continue;
+			}
+		}
+		completed.push_back(readIndex);
+	}
+	__atomic_store_n(pState->pCqHead, head, __ATOMIC_RELEASE);
+}
+#endif
+
+/************************************************************************/
+// Worker thread backend
+/************************************************************************/
+static void asyncReadThread(void* pData)
+{
+	AsyncFileReaderState* pState = (AsyncFileReaderState*)pData;
+	while (true)
+	{
+		pState->mWorkMutex.Acquire();
+		while (pState->mWorkQueue.empty() && !pState->mQuit)
+			pState->mWorkCondition.Wait(pState->mWorkMutex, 100);
+		if (pState->mWorkQueue.empty())
+		{
+			pState->mWorkMutex.Release();
+			break;
+		}
+		const uint32_t readIndex = pState->mWorkQueue.front();
+		pState->mWorkQueue.erase(pState->mWorkQueue.begin());
+		pState->mWorkMutex.Release();
+
+		AsyncRead& read = pState->pReads[readIndex];
+		read.mSuccess = readAsyncFile(read.pFile, read.mOffset, read.mSize, read.pDst, &read.mBytesRead);
+
+		pState->mCompletedMutex.Acquire();
+		pState->mCompleted.push_back(readIndex);
+		pState->mCompletedCondition.Set();
+		pState->mCompletedMutex.Release();
+	}
+}
+
+// Blocks until at least one read completed or a short timeout expired
+static void waitForCompletion(AsyncFileReaderState* pState)
+{
+#ifdef USE_IO_URING
+	if (pState->mRingFd >= 0)
+	{
+		if (pState->mNumInFlight)
+			syscall(__NR_io_uring_enter, pState->mRingFd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+		return;
+	}
+#endif
+	pState->mCompletedMutex.Acquire();
+	if (pState->mCompleted.empty())
+		pState->mCompletedCondition.Wait(pState->mCompletedMutex, 10);
+	pState->mCompletedMutex.Release();
+}
+
+/************************************************************************/
+// AsyncFileReader
+/************************************************************************/
+AsyncFileReader::AsyncFileReader() :
+	pState(NULL),
+	mNumPending(0)
+{
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+	Destroy();
+}
+
+bool AsyncFileReader::Initialize(const AsyncFileReaderDesc& desc)
+{
+	ASSERT(desc.mQueueDepth > 0 && desc.mMaxReads > 0);
+
+	Destroy();
+
+	pState = conf_placement_new<AsyncFileReaderState>(conf_calloc(1, sizeof(AsyncFileReaderState)));
+	pState->mDesc = desc;
+	pState->pReads = (AsyncRead*)conf_calloc(desc.mMaxReads, sizeof(AsyncRead));
+	for (uint32_t i = 0; i < desc.mMaxReads; ++i)
+		pState->pReads[i].mNextFree = i + 1 < desc.mMaxReads ? i + 1 : ASYNC_READ_NONE;
+	pState->mFirstFree = 0;
+	pState->mQueued.reserve(desc.mMaxReads);
+	pState->mPolled.reserve(desc.mMaxReads);
+
+#ifdef USE_IO_URING
+	pState->mRingFd = -1;
+	if (!desc.mForceThreads && initIoUring(pState, desc.mQueueDepth))
+		return true;
+#endif
+
+	const uint32_t numThreads = max(1u, desc.mNumThreads);
+	pState->mWorkQueue.reserve(desc.mMaxReads);
+	pState->mCompleted.reserve(desc.mMaxReads);
+	pState->mThreadItems.resize(numThreads);
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		pState->mThreadItems[i].pFunc = asyncReadThread;
+		pState->mThreadItems[i].pData = pState;
+		pState->mThreads.push_back(_createThread(&pState->mThreadItems[i]));
+	}
+	return true;
+}
+
+void AsyncFileReader::Destroy()
+{
+	if (!pState)
+		return;
+
+	WaitAll();
+
+#ifdef USE_IO_URING
+	if (pState->mRingFd >= 0)
+		exitIoUring(pState);
+#endif
+
+	pState->mWorkMutex.Acquire();
+	pState->mQuit = true;
+	for (uint32_t i = 0; i < (uint32_t)pState->mThreads.size(); ++i)
+		pState->mWorkCondition.Set();
+	pState->mWorkMutex.Release();
+	for (uint32_t i = 0; i < (uint32_t)pState->mThreads.size(); ++i)
+		_joinThread(pState->mThreads[i]);
+
+	conf_free(pState->pReads);
+	pState->~AsyncFileReaderState();
+	conf_free(pState);
+	pState = NULL;
+}
+
+AsyncFileHandle AsyncFileReader::OpenFile(const tinystl::string& _fileName, FSRoot root, bool directIO)
+{
+	tinystl::string fileName = FileSystem::FixPath(_fileName, root);
+	AsyncFile* pFile = openAsyncFile(fileName, directIO);
+	if (!pFile)
+		LOGERRORF("Could not open file %s", fileName.c_str());
+	return pFile;
+}
+
+void AsyncFileReader::CloseFile(AsyncFileHandle file)
+{
+	if (file)
+		closeAsyncFile((AsyncFile*)file);
+}
+
+uint64_t AsyncFileReader::GetFileSize(AsyncFileHandle file) const
+{
+	return file ? ((AsyncFile*)file)->mSize : 0;
+}
+
+AsyncReadToken AsyncFileReader::ReadAsync(AsyncFileHandle file, uint64_t offset, size_t size, void* pDst, AsyncReadCallback pCallback, void* pUserData)
+{
+	AsyncFile* pFile = (AsyncFile*)file;
+	ASSERT(pState && pFile);
+	ASSERT(!pFile->mDirectIO || (((uintptr_t)pDst | (uintptr_t)offset | (uintptr_t)size) & (FILE_DIRECT_IO_ALIGNMENT - 1)) == 0);
+
+	// All reads are in use, make room by completing some
+	while (pState->mFirstFree == ASYNC_READ_NONE)
+	{
+		Submit();
+		if (!Poll())
+			waitForCompletion(pState);
+	}
+
+	const uint32_t readIndex = pState->mFirstFree;
+	AsyncRead& read = pState->pReads[readIndex];
+	pState->mFirstFree = read.mNextFree;
+
+	read.pFile = pFile;
+	read.pDst = pDst;
+	read.pCallback = pCallback;
+	read.pUserData = pUserData;
+	read.mOffset = offset;
+	read.mSize = size;
+	read.mBytesRead = 0;
+	read.mSuccess = true;
+	read.mCloseFile = false;
+	pState->mQueued.push_back(readIndex);
+	++mNumPending;
+
+	return ((uint64_t)read.mGeneration << 32) | (readIndex + 1);
+}
+
+AsyncReadToken AsyncFileReader::ReadAsync(const tinystl::string& fileName, FSRoot root, uint64_t offset, size_t size, void* pDst, AsyncReadCallback pCallback, void* pUserData)
+{
+	AsyncFileHandle file = OpenFile(fileName, root);
+	if (!file)
+		return 0;
+
+	const AsyncReadToken token = ReadAsync(file, offset, size, pDst, pCallback, pUserData);
+	pState->pReads[(uint32_t)token - 1].mCloseFile = true;
+	return token;
+}
+
+void AsyncFileReader::Submit()
+{
+	ASSERT(pState);
+#ifdef USE_IO_URING
+	if (pState->mRingFd >= 0)
+	{
+		submitIoUring(pState);
+		return;
+	}
+#endif
+	if (pState->mQueued.empty())
+		return;
+
+	pState->mWorkMutex.Acquire();
+	for (uint32_t i = 0; i < (uint32_t)pState->mQueued.size(); ++i)
+	{
+		pState->mWorkQueue.push_back(pState->mQueued[i]);
+		pState->mWorkCondition.Set();
+	}
+	pState->mWorkMutex.Release();
+	pState->mQueued.clear();
+}
+
+uint32_t AsyncFileReader::Poll()
+{
+	ASSERT(pState);
+	tinystl::vector<uint32_t>& completed = pState->mPolled;
+	completed.clear();
+
+#ifdef USE_IO_URING
+	if (pState->mRingFd >= 0)
+	{
+		reapIoUring(pState, completed);
+		// Starts the reads that did not fit into the ring and the rest of short reads
+		if (!pState->mQueued.empty())
+			submitIoUring(pState);
+	}
+	else
+#endif
+	{
+		pState->mCompletedMutex.Acquire();
+		completed.swap(pState->mCompleted);
+		pState->mCompletedMutex.Release();
+	}
+
+	const uint32_t numCompleted = (uint32_t)completed.size();
+	for (uint32_t i = 0; i < numCompleted; ++i)
+	{
+		// The read is recycled before its callback runs, so the callback can issue new reads
+		const uint32_t readIndex = completed[i];
+		AsyncRead read = pState->pReads[readIndex];
+		++pState->pReads[readIndex].mGeneration;
+		pState->pReads[readIndex].mNextFree = pState->mFirstFree;
+		pState->mFirstFree = readIndex;
+		--mNumPending;
+
+		if (!read.mSuccess)
+			LOGERRORF("Could not read %llu bytes at offset %llu", (unsigned long long)read.mSize, (unsigned long long)read.mOffset);
+		if (read.mCloseFile)
+			closeAsyncFile(read.pFile);
+		if (read.pCallback)
+			read.pCallback(read.pUserData, read.pDst, read.mBytesRead, read.mSuccess);
+	}
+	return numCompleted;
+}
+
+void AsyncFileReader::Wait(AsyncReadToken token)
+{
+	Submit();
+	while (!IsComplete(token))
+	{
+		if (!Poll())
+			waitForCompletion(pState);
+	}
+}
+
+void AsyncFileReader::WaitAll()
+{
+	Submit();
+	while (mNumPending)
+	{
+		if (!Poll())
+			waitForCompletion(pState);
+	}
+}
+
+bool AsyncFileReader::IsComplete(AsyncReadToken token) const
+{
+	const uint32_t readIndex = (uint32_t)token - 1;
+	return readIndex >= pState->mDesc.mMaxReads || pState->pReads[readIndex].mGeneration != (uint32_t)(token >> 32);
+}
+
+bool AsyncFileReader::IsUsingIoUring() const
+{
+#ifdef USE_IO_URING
+	return pState && pState->mRingFd >= 0;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+//This file contains abstractions for compiler specific atomic operations
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+typedef volatile uint32_t tfrg_atomic32_t;
+typedef volatile uint64_t tfrg_atomic64_t;
+
+//The relaxed operations are meant for counters and bump allocators where the value itself
+//is the only shared state. The acquire/release pair publishes data written before the store
+//to a thread that observes the stored value. Use a Mutex for anything more involved.
+#if defined(_MSC_VER)
+static inline uint32_t tfrg_atomic32_load_relaxed(tfrg_atomic32_t* pVar) { return *pVar; }
+static inline void tfrg_atomic32_store_relaxed(tfrg_atomic32_t* pVar, uint32_t val) { *pVar = val; }
+//x86/x64 do not reorder loads with later accesses or stores with earlier ones, only the compiler has to be fenced
+static inline uint32_t tfrg_atomic32_load_acquire(tfrg_atomic32_t* pVar) { uint32_t val = *pVar; _ReadWriteBarrier(); return val; }
+static inline void tfrg_atomic32_store_release(tfrg_atomic32_t* pVar, uint32_t val) { _ReadWriteBarrier(); *pVar = val; }
+//Returns the value before the addition
+static inline uint32_t tfrg_atomic32_add_relaxed(tfrg_atomic32_t* pVar, uint32_t val) { return (uint32_t)_InterlockedExchangeAdd((volatile long*)pVar, (long)val); }
+//Returns the value before the exchange. The exchange happened if the returned value equals cmp
+static inline uint32_t tfrg_atomic32_cas_relaxed(tfrg_atomic32_t* pVar, uint32_t cmp, uint32_t val) { return (uint32_t)_InterlockedCompareExchange((volatile long*)pVar, (long)val, (long)cmp); }
+
+static inline uint64_t tfrg_atomic64_load_relaxed(tfrg_atomic64_t* pVar) { return (uint64_t)_InterlockedCompareExchange64((volatile long long*)pVar, 0, 0); }
+static inline void tfrg_atomic64_store_relaxed(tfrg_atomic64_t* pVar, uint64_t val) { _InterlockedExchange64((volatile long long*)pVar, (long long)val); }
+static inline uint64_t tfrg_atomic64_add_relaxed(tfrg_atomic64_t* pVar, uint64_t val) { return (uint64_t)_InterlockedExchangeAdd64((volatile long long*)pVar, (long long)val); }
+static inline uint64_t tfrg_atomic64_cas_relaxed(tfrg_atomic64_t* pVar, uint64_t cmp, uint64_t val) { return (uint64_t)_InterlockedCompareExchange64((volatile long long*)pVar, (long long)val, (long long)cmp); }
+#else
+static inline uint32_t tfrg_atomic32_load_relaxed(tfrg_atomic32_t* pVar) { return __atomic_load_n(pVar, __ATOMIC_RELAXED); }
+static inline void tfrg_atomic32_store_relaxed(tfrg_atomic32_t* pVar, uint32_t val) { __atomic_store_n(pVar, val, __ATOMIC_RELAXED); }
+static inline uint32_t tfrg_atomic32_load_acquire(tfrg_atomic32_t* pVar) { return __atomic_load_n(pVar, __ATOMIC_ACQUIRE); }
+static inline void tfrg_atomic32_store_release(tfrg_atomic32_t* pVar, uint32_t val) { __atomic_store_n(pVar, val, __ATOMIC_RELEASE); }
+//Returns the value before the addition
+static inline uint32_t tfrg_atomic32_add_relaxed(tfrg_atomic32_t* pVar, uint32_t val) { return __atomic_fetch_add(pVar, val, __ATOMIC_RELAXED); }
+//Returns the value before the exchange. The exchange happened if the returned value equals cmp
+static inline uint32_t tfrg_atomic32_cas_relaxed(tfrg_atomic32_t* pVar, uint32_t cmp, uint32_t val)
+{
+	__atomic_compare_exchange_n(pVar, &cmp, val, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	return cmp;
+}
+
+static inline uint64_t tfrg_atomic64_load_relaxed(tfrg_atomic64_t* pVar) { return __atomic_load_n(pVar, __ATOMIC_RELAXED); }
+static inline void tfrg_atomic64_store_relaxed(tfrg_atomic64_t* pVar, uint64_t val) { __atomic_store_n(pVar, val, __ATOMIC_RELAXED); }
+static inline uint64_t tfrg_atomic64_add_relaxed(tfrg_atomic64_t* pVar, uint64_t val) { return __atomic_fetch_add(pVar, val, __ATOMIC_RELAXED); }
+static inline uint64_t tfrg_atomic64_cas_relaxed(tfrg_atomic64_t* pVar, uint64_t cmp, uint64_t val)
+{
+	__atomic_compare_exchange_n(pVar, &cmp, val, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	return cmp;
+}
+#endif
+
+//Stores max(*pVar, val) and returns the previous value
+static inline uint32_t tfrg_atomic32_max_relaxed(tfrg_atomic32_t* pVar, uint32_t val)
+{
+	uint32_t prev = tfrg_atomic32_load_relaxed(pVar);
+	while (prev < val)
+	{
+		const uint32_t actual = tfrg_atomic32_cas_relaxed(pVar, prev, val);
+		if (actual == prev)
+			break;
+		prev = actual;
+	}
+	return prev;
+}
+
+static inline uint64_t tfrg_atomic64_max_relaxed(tfrg_atomic64_t* pVar, uint64_t val)
+{
+	uint64_t prev = tfrg_atomic64_load_relaxed(pVar);
+	while (prev < val)
+	{
+		const uint64_t actual = tfrg_atomic64_cas_relaxed(pVar, prev, val);
+		if (actual == prev)
+			break;
+		prev = actual;
+	}
+	return prev;
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <intrin.h>
+#elif defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+#if !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+#include "CpuFeatures.h"
+#include "../Interfaces/ILogManager.h"
+
+static uint32_t    gCpuFeatures = 0;
+static bool        gCpuFeaturesDetected = false;
+static uint32_t    gCpuFeatureMask = ~0U;
+static CpuKernel*  gCpuKernels = NULL;
+
+static const struct
+{
+	uint32_t    mFlag;
+	const char* pName;
+} gCpuFeatureNames[] = {
+	{ CPU_FEATURE_SSE2, "SSE2" },
+	{ CPU_FEATURE_SSE3, "SSE3" },
+	{ CPU_FEATURE_SSSE3, "SSSE3" },
+	{ CPU_FEATURE_SSE41, "SSE4.1" },
+	{ CPU_FEATURE_SSE42, "SSE4.2" },
+	{ CPU_FEATURE_POPCNT, "POPCNT" },
+	{ CPU_FEATURE_AVX, "AVX" },
+	{ CPU_FEATURE_F16C, "F16C" },
+	{ CPU_FEATURE_FMA, "FMA" },
+	{ CPU_FEATURE_AVX2, "AVX2" },
+	{ CPU_FEATURE_BMI2, "BMI2" },
+	{ CPU_FEATURE_AVX512F, "AVX512F" },
+	{ CPU_FEATURE_AVX512DQ, "AVX512DQ" },
+	{ CPU_FEATURE_AVX512BW, "AVX512BW" },
+	{ CPU_FEATURE_AVX512VL, "AVX512VL" },
+	{ CPU_FEATURE_NEON, "NEON" },
+	{ CPU_FEATURE_NEON_FP16, "NEON_FP16" },
+	{ CPU_FEATURE_NEON_DOTPROD, "NEON_DOTPROD" },
+	{ CPU_FEATURE_CRC32, "CRC32" },
+};
+
+#if defined(CPU_X86)
+static void cpuid(uint32_t leaf, uint32_t subLeaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+	__cpuidex((int*)regs, (int)leaf, (int)subLeaf);
+#else
+	__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// State components the OS saves on context switches
+static uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	// Not using the intrinsic, it needs -mxsave for the whole file
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+static uint32_t detectCpuFeatures()
+{
+	uint32_t regs[4];
+	cpuid(0, 0, regs);
+	const uint32_t maxLeaf = regs[0];
+	if (maxLeaf < 1)
+		return CPU_FEATURE_NONE;
+
+	cpuid(1, 0, regs);
+	const uint32_t ecx1 = regs[2];
+	const uint32_t edx1 = regs[3];
+	uint32_t ebx7 = 0;
+	if (maxLeaf >= 7)
+	{
+		cpuid(7, 0, regs);
+		ebx7 = regs[1];
+	}
+
+	uint32_t features = CPU_FEATURE_NONE;
+	if (edx1 & (1U << 26)) features |= CPU_FEATURE_SSE2;
+	if (ecx1 & (1U << 0)) features |= CPU_FEATURE_SSE3;
+	if (ecx1 & (1U << 9)) features |= CPU_FEATURE_SSSE3;
+	if (ecx1 & (1U << 19)) features |= CPU_FEATURE_SSE41;
+	if (ecx1 & (1U << 20)) features |= CPU_FEATURE_SSE42;
+	if (ecx1 & (1U << 23)) features |= CPU_FEATURE_POPCNT;
+	if (ebx7 & (1U << 8)) features |= CPU_FEATURE_BMI2;
+
+	// The YMM / ZMM registers are only usable if the OS saves them
+	const bool osxsave = (ecx1 & (1U << 27)) != 0;
+	const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+	const bool ymm = (xcr0 & 0x6) == 0x6;
+	const bool zmm = (xcr0 & 0xE6) == 0xE6;
+	if (ymm)
+	{
+		if (ecx1 & (1U << 28)) features |= CPU_FEATURE_AVX;
+		if (ecx1 & (1U << 29)) features |= CPU_FEATURE_F16C;
+		if (ecx1 & (1U << 12)) features |= CPU_FEATURE_FMA;
+		if (ebx7 & (1U << 5)) features |= CPU_FEATURE_AVX2;
+	}
+	if (zmm)
+	{
+		if (ebx7 & (1U << 16)) features |= CPU_FEATURE_AVX512F;
+		if (ebx7 & (1U << 17)) features |= CPU_FEATURE_AVX512DQ;
+		if (ebx7 & (1U << 30)) features |= CPU_FEATURE_AVX512BW;
+		if (ebx7 & (1U << 31)) features |= CPU_FEATURE_AVX512VL;
+	}
+	return features;
+}
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__arm__) || defined(_M_ARM)
+#if defined(__APPLE__)
+static bool hasSysctlFeature(const char* pName)
+{
+	int value = 0;
+	size_t size = sizeof(value);
+	return sysctlbyname(pName, &value, &size, NULL, 0) == 0 && value != 0;
+}
+#endif
+
+static uint32_t detectCpuFeatures()
+{
+	uint32_t features = CPU_FEATURE_NONE;
+#if defined(__APPLE__)
+	// Every Apple ARM CPU has NEON
+	features |= CPU_FEATURE_NEON;
+	if (hasSysctlFeature("hw.optional.arm.FEAT_FP16") || hasSysctlFeature("hw.optional.neon_fp16")) features |= CPU_FEATURE_NEON_FP16;
+	if (hasSysctlFeature("hw.optional.arm.FEAT_DotProd")) features |= CPU_FEATURE_NEON_DOTPROD;
+	if (hasSysctlFeature("hw.optional.armv8_crc32")) features |= CPU_FEATURE_CRC32;
+#elif defined(_WIN32)
+	features |= CPU_FEATURE_NEON;
+#if defined(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE)
+	if (IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE)) features |= CPU_FEATURE_CRC32;
+#endif
+#if defined(PF_ARM_V82_DP_INSTRUCTIONS_AVAILABLE)
+	if (IsProcessorFeaturePresent(PF_ARM_V82_DP_INSTRUCTIONS_AVAILABLE)) features |= CPU_FEATURE_NEON_DOTPROD;
+#endif
+#elif defined(__linux__) && (!defined(__ANDROID__) || __ANDROID_API__ >= 18)
+#if defined(__aarch64__)
+	// Bits of AT_HWCAP, spelled out since older headers lack the newer ones
+	const unsigned long hwcap = getauxval(AT_HWCAP);
+	if (hwcap & (1UL << 1)) features |= CPU_FEATURE_NEON;
+	if (hwcap & (1UL << 7)) features |= CPU_FEATURE_CRC32;
+	if (hwcap & (1UL << 10)) features |= CPU_FEATURE_NEON_FP16;
+	if (hwcap & (1UL << 20)) features |= CPU_FEATURE_NEON_DOTPROD;
+#else
+	if (getauxval(AT_HWCAP) & (1UL << 12)) features |= CPU_FEATURE_NEON;
+	if (getauxval(AT_HWCAP2) & (1UL << 4)) features |= CPU_FEATURE_CRC32;
+#endif
+#else
+	// No way to ask, assume what the compiler was allowed to use
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	features |= CPU_FEATURE_NEON;
+#endif
+#endif
+	return features;
+}
+#else
+static uint32_t detectCpuFeatures() { return CPU_FEATURE_NONE; }
+#endif
+
+uint32_t getCpuFeatures()
+{
+	if (!gCpuFeaturesDetected)
+	{
+		gCpuFeatures = detectCpuFeatures();
+		gCpuFeaturesDetected = true;
+	}
+	return gCpuFeatures;
+}
+
+void getCpuFeatureNames(uint32_t flags, char* pBuffer, uint32_t bufferSize)
+{
+	ASSERT(pBuffer && bufferSize);
+	pBuffer[0] = '\0';
+	size_t length = 0;
+	for (uint32_t i = 0; i < sizeof(gCpuFeatureNames) / sizeof(gCpuFeatureNames[0]); ++i)
+	{
+		if (!(flags & gCpuFeatureNames[i].mFlag))
+			continue;
+		const size_t nameLength = strlen(gCpuFeatureNames[i].pName);
+		if (length + nameLength + 2 > bufferSize)
+			break;
+		if (length)
+			pBuffer[length++] = ' ';
+		memcpy(pBuffer + length, gCpuFeatureNames[i].pName, nameLength + 1);
+		length += nameLength;
+	}
+}
+
+static void bindCpuKernel(CpuKernel* pKernel)
+{
+	const uint32_t features = getCpuFeatures() & gCpuFeatureMask;
+	pKernel->pBoundVariant = NULL;
+	for (uint32_t i = 0; i < pKernel->mVariantCount; ++i)
+	{
+		const CpuKernelVariant* pVariant = &pKernel->pVariants[i];
+		if ((pVariant->mRequiredFeatures & features) == pVariant->mRequiredFeatures)
+		{
+			pKernel->pBoundVariant = pVariant;
+			break;
+		}
+	}
+	// The last variant is the fallback for any CPU
+	ASSERT(pKernel->pBoundVariant);
+	pKernel->pFunction = pKernel->pBoundVariant->pFunction;
+}
+
+void registerCpuKernel(CpuKernel* pKernel)
+{
+	ASSERT(pKernel && pKernel->mVariantCount);
+	bindCpuKernel(pKernel);
+	pKernel->pNext = gCpuKernels;
+	gCpuKernels = pKernel;
+}
+
+void setCpuFeatureMask(uint32_t mask)
+{
+	gCpuFeatureMask = mask;
+	for (CpuKernel* pKernel = gCpuKernels; pKernel; pKernel = pKernel->pNext)
+		bindCpuKernel(pKernel);
+}
+
+void logCpuKernels()
+{
+	char names[256];
+	getCpuFeatureNames(getCpuFeatures(), names, sizeof(names));
+	LOGINFOF("CPU features: %s", names);
+	if (gCpuFeatureMask != ~0U)
+	{
+		getCpuFeatureNames(getCpuFeatures() & ~gCpuFeatureMask, names, sizeof(names));
+		LOGINFOF("CPU features hidden from kernels: %s", names);
+	}
+	for (const CpuKernel* pKernel = gCpuKernels; pKernel; pKernel = pKernel->pNext)
+		LOGINFOF("CPU kernel %s: %s", pKernel->pName, pKernel->pBoundVariant->pName);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/// Runtime CPU feature detection and per kernel dispatch.
+/// The engine is built for the baseline of every platform (SSE2 on x86-64), so code that profits from newer instruction
+/// sets provides several variants of a kernel and the best one the CPU supports is bound when the kernel is registered.
+/// Variants for other instruction sets are compiled with CPU_TARGET_* so the rest of the translation unit keeps the baseline.
+///
+/// A kernel looks like:
+///   static const CpuKernelVariant gBlendVariants[] = {
+///       { "AVX2", CPU_FEATURE_AVX2, (CpuKernelFunction)blendAVX2 },
+///       { "Scalar", CPU_FEATURE_NONE, (CpuKernelFunction)blendScalar },
+///   };
+///   static CpuKernel gBlendKernel = { "Blend", gBlendVariants, sizeof(gBlendVariants) / sizeof(gBlendVariants[0]), NULL, NULL, NULL };
+///   static CpuKernelRegistration gBlendRegistration(&gBlendKernel);
+///   ...
+///   ((BlendFunction)gBlendKernel.pFunction)(pDst, pSrc, count);
+
+typedef enum CpuFeatureFlags
+{
+	CPU_FEATURE_NONE = 0,
+	// x86
+	CPU_FEATURE_SSE2 = 0x1,
+	CPU_FEATURE_SSE3 = 0x2,
+	CPU_FEATURE_SSSE3 = 0x4,
+	CPU_FEATURE_SSE41 = 0x8,
+	CPU_FEATURE_SSE42 = 0x10,
+	CPU_FEATURE_POPCNT = 0x20,
+	CPU_FEATURE_AVX = 0x40,
+	CPU_FEATURE_F16C = 0x80,
+	CPU_FEATURE_FMA = 0x100,
+	CPU_FEATURE_AVX2 = 0x200,
+	CPU_FEATURE_BMI2 = 0x400,
+	CPU_FEATURE_AVX512F = 0x800,
+	CPU_FEATURE_AVX512DQ = 0x1000,
+	CPU_FEATURE_AVX512BW = 0x2000,
+	CPU_FEATURE_AVX512VL = 0x4000,
+	// ARM
+	CPU_FEATURE_NEON = 0x10000,
+	CPU_FEATURE_NEON_FP16 = 0x20000,
+	CPU_FEATURE_NEON_DOTPROD = 0x40000,
+	CPU_FEATURE_CRC32 = 0x80000,
+} CpuFeatureFlags;
+
+/// Function attributes to compile a single function for a newer instruction set than the rest of the translation unit.
+/// MSVC accepts every intrinsic without them
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define CPU_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define CPU_TARGET_AVX __attribute__((target("avx")))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#define CPU_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#define CPU_TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl")))
+#else
+#define CPU_TARGET_SSSE3
+#define CPU_TARGET_SSE41
+#define CPU_TARGET_AVX
+#define CPU_TARGET_AVX2
+#define CPU_TARGET_AVX2_FMA
+#define CPU_TARGET_AVX512
+#endif
+
+/// Set when the compiler can emit the x86 intrinsics of the CPU_TARGET_* variants
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPU_X86
+#endif
+
+typedef void (*CpuKernelFunction)();
+
+typedef struct CpuKernelVariant
+{
+	const char*       pName;
+	/// All of these have to be supported for the variant to be picked
+	uint32_t          mRequiredFeatures;
+	CpuKernelFunction pFunction;
+} CpuKernelVariant;
+
+typedef struct CpuKernel
+{
+	const char*             pName;
+	/// Best variant first. The last one must not require any feature
+	const CpuKernelVariant* pVariants;
+	uint32_t                mVariantCount;
+	/// Set by registerCpuKernel
+	CpuKernelFunction       pFunction;
+	const CpuKernelVariant* pBoundVariant;
+	CpuKernel*              pNext;
+} CpuKernel;
+
+/// Features of the CPU the process runs on, detected on the first call. Includes the OS support for the wider registers
+uint32_t getCpuFeatures();
+/// Writes the names of the features in flags separated by spaces
+void getCpuFeatureNames(uint32_t flags, char* pBuffer, uint32_t bufferSize);
+
+/// Binds pKernel to the first variant whose features are supported. Only touches plain globals, so it can run during static
+/// initialization
+void registerCpuKernel(CpuKernel* pKernel);
+/// Hides features from the kernels and rebinds all registered kernels, e.g. to compare variants. ~0U restores all features.
+/// Must not be called while kernels run on other threads
+void setCpuFeatureMask(uint32_t mask);
+/// Logs the CPU features and the variant every registered kernel is bound to
+void logCpuKernels();
+
+/// Registers a kernel during static initialization of the translation unit that owns it
+struct CpuKernelRegistration
+{
+	CpuKernelRegistration(CpuKernel* pKernel) { registerCpuKernel(pKernel); }
+};
@@ -84,7 +84,7 @@ Deserializer::Deserializer() :
 {
 }
 
-Deserializer::Deserializer(unsigned size) :
+Deserializer::Deserializer(uint64_t size) :
 	mPosition(0),
 	mSize(size)
 {
@@ -414,16 +414,7 @@ bool File::Open(const tinystl::string& _fileName, FileMode mode, FSRoot root)
 	mReadSyncNeeded = false;
 	mWriteSyncNeeded = false;
 
-	size_t size = FileSystem::GetFileSize(pHandle);
-	if (size > UINT_MAX)
-	{
-		LOGERRORF("Could not open file %s which is larger than 4GB", fileName.c_str());
-		Close();
-		mSize = 0;
-		return false;
-	}
-
-	mSize = (unsigned)size;
+	mSize = FileSystem::GetFileSize(pHandle);
 	return true;
 }
 
@@ -446,7 +437,7 @@ void File::Flush()
 		_flushFile(pHandle);
 }
 
-unsigned File::Read(void* dest, unsigned size)
+uint64_t File::Read(void* dest, uint64_t size)
 {
 	if (!pHandle)
 	{
@@ -460,24 +451,57 @@ unsigned File::Read(void* dest, unsigned size)
 		return 0;
 	}
 
-	if (size + mPosition > mSize)
+	if (mPosition >= mSize)
+		return 0;
+	if (size > mSize - mPosition)
 		size = mSize - mPosition;
 	if (!size)
 		return 0;
 
 	if (mReadSyncNeeded)
 	{
-		_seekFile(pHandle, mPosition + mOffset, SEEK_SET);
+		_seekFile(pHandle, (int64_t)(mPosition + mOffset), SEEK_SET);
 		mReadSyncNeeded = false;
 	}
 
-	size = (unsigned int)_readFile(dest, size, pHandle);
+	size = _readFile(dest, (size_t)size, pHandle);
 	mWriteSyncNeeded = true;
 	mPosition += size;
 	return size;
 }
 
-unsigned File::Seek(unsigned position, SeekDir seekDir /* = SeekDir::SEEK_DIR_BEGIN*/)
+uint64_t File::ReadAt(uint64_t offset, void* dest, uint64_t size)
+{
+	if (!pHandle)
+	{
+		// Avoid spamming stderr
+		return 0;
+	}
+
+	if (IsWriteOnly())
+	{
+		LOGERROR("File not opened for reading");
+		return 0;
+	}
+
+	if (offset >= mSize)
+		return 0;
+	if (size > mSize - offset)
+		size = mSize - offset;
+	if (!size)
+		return 0;
+
+	size = _readFileAt(dest, (size_t)size, offset + mOffset, pHandle);
+#ifdef _WIN32
+	// The positional read moves the pointer of the OS handle, resync before the next Read / Write.
+	// Concurrent ReadAt calls all store true so the race is benign
+	mReadSyncNeeded = true;
+	mWriteSyncNeeded = true;
+#endif
+	return size;
+}
+
+uint64_t File::Seek(uint64_t position, SeekDir seekDir /* = SeekDir::SEEK_DIR_BEGIN*/)
 {
 	if (!pHandle)
 	{
@@ -503,14 +527,14 @@ unsigned File::Seek(unsigned position, SeekDir seekDir /* = SeekDir::SEEK_DIR_BE
 	default:
 		break;
 	}
-	_seekFile(pHandle, position + mOffset, origin);
+	_seekFile(pHandle, (int64_t)(position + mOffset), origin);
 	mPosition = position;
 	mReadSyncNeeded = false;
 	mWriteSyncNeeded = false;
 	return mPosition;
 }
 
-unsigned File::Write(const void* data, unsigned size)
+uint64_t File::Write(const void* data, uint64_t size)
 {
 	if (!pHandle)
 	{
@@ -529,17 +553,17 @@ unsigned File::Write(const void* data, unsigned size)
 
 	if (mWriteSyncNeeded)
 	{
-		_seekFile(pHandle, mPosition + mOffset, SEEK_SET);
+		_seekFile(pHandle, (int64_t)(mPosition + mOffset), SEEK_SET);
 		mWriteSyncNeeded = false;
 	}
 
 	// fwrite returns how many bytes were written.
 	// which should be the same as size.
 	// If not, then it's a write error.
-	if (_writeFile(data, size, pHandle) != 1)
+	if (_writeFile(data, (size_t)size, pHandle) != 1)
 	{
 		// Return to the position where the write began
-		_seekFile(pHandle, mPosition + mOffset, SEEK_SET);
+		_seekFile(pHandle, (int64_t)(mPosition + mOffset), SEEK_SET);
 		LOGERROR("Error while writing to file " + GetName());
 		return 0;
 	}
@@ -560,15 +584,15 @@ unsigned File::GetChecksum()
 	if (!pHandle || IsWriteOnly())
 		return 0;
 
-	unsigned oldPos = mPosition;
+	uint64_t oldPos = mPosition;
 	mChecksum = 0;
 
 	Seek(0);
 	while (!IsEof())
 	{
 		unsigned char block[1024];
-		unsigned readBytes = Read(block, 1024);
-		for (unsigned i = 0; i < readBytes; ++i)
+		uint64_t readBytes = Read(block, 1024);
+		for (uint64_t i = 0; i < readBytes; ++i)
 			mChecksum = SDBMHash(mChecksum, block[i]);
 	}
 
@@ -584,14 +608,64 @@ tinystl::string File::ReadText()
 	if (!mSize)
 		return tinystl::string();
 
-	text.resize(mSize);
+	text.resize((size_t)mSize);
 
 	Read((void*)text.c_str(), mSize);
 
 	return text;
 }
 
-MemoryBuffer::MemoryBuffer(const void* data, unsigned size) :
+/************************************************************************/
+// MappedFile implementation
+/************************************************************************/
+MappedFile::MappedFile() :
+	pData(NULL),
+	mSize(0),
+	pMapping(NULL)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const tinystl::string& _fileName, FSRoot root)
+{
+	tinystl::string fileName = FileSystem::FixPath(_fileName, root);
+
+	Close();
+
+	if (fileName.size() == 0)
+	{
+		LOGERRORF("Could not map file with empty name");
+		return false;
+	}
+
+	pData = _mapFile(fileName, &mSize, &pMapping);
+	if (!pData)
+	{
+		LOGERRORF("Could not map file %s", fileName.c_str());
+		mSize = 0;
+		return false;
+	}
+
+	mFileName = fileName;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (pData)
+	{
+		_unmapFile(pData, mSize, pMapping);
+		pData = NULL;
+		mSize = 0;
+		pMapping = NULL;
+	}
+}
+
+MemoryBuffer::MemoryBuffer(const void* data, uint64_t size) :
 	Deserializer(size),
 	pBuffer((unsigned char*)data),
 	mReadOnly(true)
@@ -600,7 +674,7 @@ MemoryBuffer::MemoryBuffer(const void* data, unsigned size) :
 		mSize = 0;
 }
 
-MemoryBuffer::MemoryBuffer(void* data, unsigned size) :
+MemoryBuffer::MemoryBuffer(void* data, uint64_t size) :
 	Deserializer(size),
 	pBuffer((unsigned char*)data),
 	mReadOnly(false)
@@ -609,9 +683,9 @@ MemoryBuffer::MemoryBuffer(void* data, unsigned size) :
 		mSize = 0;
 }
 
-unsigned MemoryBuffer::Read(void* dest, unsigned size)
+uint64_t MemoryBuffer::Read(void* dest, uint64_t size)
 {
-	if (size + mPosition > mSize)
+	if (size > mSize - mPosition)
 		size = mSize - mPosition;
 	if (!size)
 		return 0;
@@ -620,7 +694,7 @@ unsigned MemoryBuffer::Read(void* dest, unsigned size)
 	unsigned char* destPtr = (unsigned char*)dest;
 	mPosition += size;
 
-	unsigned copySize = size;
+	uint64_t copySize = size;
 	while (copySize >= sizeof(unsigned))
 	{
 		*((unsigned*)destPtr) = *((unsigned*)srcPtr);
@@ -640,7 +714,7 @@ unsigned MemoryBuffer::Read(void* dest, unsigned size)
 	return size;
 }
 
-unsigned MemoryBuffer::Seek(unsigned position, SeekDir seekDir /* = SeekDir::SEEK_DIR_BEGIN*/)
+uint64_t MemoryBuffer::Seek(uint64_t position, SeekDir seekDir /* = SeekDir::SEEK_DIR_BEGIN*/)
 {
 	UNREF_PARAM(seekDir);
 	if (position > mSize)
@@ -650,9 +724,9 @@ unsigned MemoryBuffer::Seek(unsigned position, SeekDir seekDir /* = SeekDir::SEE
 	return mPosition;
 }
 
-unsigned MemoryBuffer::Write(const void* data, unsigned size)
+uint64_t MemoryBuffer::Write(const void* data, uint64_t size)
 {
-	if (size + mPosition > mSize)
+	if (size > mSize - mPosition)
 		size = mSize - mPosition;
 	if (!size)
 		return 0;
@@ -661,7 +735,7 @@ unsigned MemoryBuffer::Write(const void* data, unsigned size)
 	unsigned char* destPtr = &pBuffer[mPosition];
 	mPosition += size;
 
-	unsigned copySize = size;
+	uint64_t copySize = size;
 	while (copySize >= sizeof(unsigned))
 	{
 		*((unsigned*)destPtr) = *((unsigned*)srcPtr);
@@ -702,13 +776,13 @@ unsigned FileSystem::GetLastModifiedTime(const tinystl::string& fileName)
 	return (unsigned)_getFileLastModifiedTime(fileName);
 }
 
-unsigned FileSystem::GetFileSize(FileHandle handle)
+uint64_t FileSystem::GetFileSize(FileHandle handle)
 {
-	long curPos = _tellFile((::FILE*)handle);
+	int64_t curPos = _tellFile(handle);
 	_seekFile(handle, 0, SEEK_END);
-	size_t length = _tellFile((::FILE*)handle);
-	_seekFile((::FILE*)handle, curPos, SEEK_SET);
-	return (unsigned)length;
+	int64_t length = _tellFile(handle);
+	_seekFile(handle, curPos, SEEK_SET);
+	return length > 0 ? (uint64_t)length : 0;
 }
 
 bool FileSystem::FileExists(const tinystl::string& _fileName, FSRoot _root)
@@ -0,0 +1,758 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "CpuFeatures.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OCCLUSION_SSE
+#endif
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+#include "OcclusionRasterizer.h"
+#include "../Interfaces/IThread.h"
+#include "../Interfaces/IProfiler.h"
+#include "../Interfaces/ILogManager.h"
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../Interfaces/IMemoryManager.h"
+
+// Jobs the occluder triangles are split in for transform and binning
+#define OCCLUSION_MAX_SETUP_JOBS 32
+#define OCCLUSION_MIN_SETUP_JOB_TRIANGLES 1024
+// Bands of tile rows rasterized by one job each
+#define OCCLUSION_MAX_BINS 32
+#define OCCLUSION_MAX_TEST_JOBS 32
+#define OCCLUSION_MIN_TEST_JOB_BOXES 256
+// Vertices nearer to the eye plane are not projected. Triangles using them are not rasterized and boxes touching them are visible
+#define OCCLUSION_MIN_W 1e-4f
+
+typedef struct OcclusionTile
+{
+	uint32_t mMask[OCCLUSION_TILE_HEIGHT];
+	float    mRefDepth;
+	float    mWorkDepth;
+} OcclusionTile;
+
+typedef struct OccluderMeshItem
+{
+	OccluderMesh mMesh;
+	float        mMvp[4][4];
+	uint32_t     mFirstTriangle;
+} OccluderMeshItem;
+
+// Triangle after projection, counter clockwise
+typedef struct BinnedTriangle
+{
+	float    mX[3];
+	float    mY[3];
+	float    mZ[3];
+	uint16_t mTileMinX;
+	uint16_t mTileMaxX;
+	uint16_t mTileMinY;
+	uint16_t mTileMaxY;
+} BinnedTriangle;
+
+typedef struct OcclusionSetupJob
+{
+	OcclusionRasterizer*             pRasterizer;
+	uint32_t                         mFirstTriangle;
+	uint32_t                         mEndTriangle;
+	tinystl::vector<BinnedTriangle>  mTriangles;
+	// Indices into mTriangles of the triangles touching every bin
+	tinystl::vector<uint32_t>        mBins[OCCLUSION_MAX_BINS];
+} OcclusionSetupJob;
+
+typedef struct OcclusionRasterJob
+{
+	OcclusionRasterizer* pRasterizer;
+	uint32_t             mBin;
+	uint32_t             mTileUpdates;
+} OcclusionRasterJob;
+
+typedef struct OcclusionTestJob
+{
+	const OcclusionRasterizer* pRasterizer;
+	uint32_t                   mFirstBox;
+	uint32_t                   mEndBox;
+	const float*               pAabbMin;
+	const float*               pAabbMax;
+	uint32_t                   mBoxStride;
+	bool*                      pOccluded;
+	uint32_t                   mOccludedBoxes;
+} OcclusionTestJob;
+
+struct OcclusionRasterizer
+{
+	ThreadPool*                       pThreadPool;
+	uint32_t                          mWidth;
+	uint32_t                          mHeight;
+	uint32_t                          mTilesX;
+	uint32_t                          mTilesY;
+	uint32_t                          mBinCount;
+	uint32_t                          mTileRowsPerBin;
+	OcclusionTile*                    pTiles;
+	float                             mViewProj[4][4];
+	tinystl::vector<OccluderMeshItem> mMeshes;
+	uint32_t                          mTriangleCount;
+	uint32_t                          mSetupJobCount;
+	OcclusionSetupJob                 mSetupJobs[OCCLUSION_MAX_SETUP_JOBS];
+	OcclusionRasterJob                mRasterJobs[OCCLUSION_MAX_BINS];
+	OcclusionTestJob                  mTestJobs[OCCLUSION_MAX_TEST_JOBS];
+	WorkItem                          mWorkItems[OCCLUSION_MAX_SETUP_JOBS + OCCLUSION_MAX_BINS + OCCLUSION_MAX_TEST_JOBS];
+	OcclusionRasterizerStats          mStats;
+};
+
+static void runOcclusionJobs(OcclusionRasterizer* pRasterizer, WorkItem* pWorkItems, uint32_t count)
+{
+	if (pRasterizer->pThreadPool && count > 1)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			pRasterizer->pThreadPool->AddWorkItem(&pWorkItems[i]);
+		pRasterizer->pThreadPool->Complete(0);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			pWorkItems[i].pFunc(pWorkItems[i].pData);
+	}
+}
+
+// Column major a * b
+static void multiplyMatrix(const float a[4][4], const float b[4][4], float result[4][4])
+{
+	for (uint32_t c = 0; c < 4; ++c)
+		for (uint32_t r = 0; r < 4; ++r)
+			result[c][r] = a[0][r] * b[c][0] + a[1][r] * b[c][1] + a[2][r] * b[c][2] + a[3][r] * b[c][3];
+}
+
+static inline void transformPosition(const float mvp[4][4], const float* p, float* pClip)
+{
+#if defined(OCCLUSION_SSE)
+	__m128 clip = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(mvp[0]), _mm_set1_ps(p[0])), _mm_loadu_ps(mvp[3]));
+	clip = _mm_add_ps(clip, _mm_mul_ps(_mm_loadu_ps(mvp[1]), _mm_set1_ps(p[1])));
+	clip = _mm_add_ps(clip, _mm_mul_ps(_mm_loadu_ps(mvp[2]), _mm_set1_ps(p[2])));
+	_mm_storeu_ps(pClip, clip);
+#else
+	for (uint32_t r = 0; r < 4; ++r)
+		pClip[r] = mvp[0][r] * p[0] + mvp[1][r] * p[1] + mvp[2][r] * p[2] + mvp[3][r];
+#endif
+}
+
+void addOcclusionRasterizer(const OcclusionRasterizerDesc* pDesc, OcclusionRasterizer** ppRasterizer)
+{
+	ASSERT(pDesc->mWidth && pDesc->mHeight);
+
+	OcclusionRasterizer* pRasterizer = conf_placement_new<OcclusionRasterizer>(conf_calloc(1, sizeof(OcclusionRasterizer)));
+	pRasterizer->pThreadPool = pDesc->pThreadPool;
+	pRasterizer->mTilesX = (pDesc->mWidth + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH;
+	pRasterizer->mTilesY = (pDesc->mHeight + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT;
+	pRasterizer->mWidth = pRasterizer->mTilesX * OCCLUSION_TILE_WIDTH;
+	pRasterizer->mHeight = pRasterizer->mTilesY * OCCLUSION_TILE_HEIGHT;
+	pRasterizer->pTiles = (OcclusionTile*)conf_calloc(pRasterizer->mTilesX * pRasterizer->mTilesY, sizeof(OcclusionTile));
+
+	const uint32_t maxBins = pDesc->pThreadPool ? min((uint32_t)OCCLUSION_MAX_BINS, (pDesc->pThreadPool->GetNumThreads() + 1) * 2) : 1U;
+	pRasterizer->mTileRowsPerBin = (pRasterizer->mTilesY + maxBins - 1) / maxBins;
+	pRasterizer->mBinCount = (pRasterizer->mTilesY + pRasterizer->mTileRowsPerBin - 1) / pRasterizer->mTileRowsPerBin;
+
+	const float identity[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+	beginOcclusionFrame(pRasterizer, &identity[0][0]);
+
+	*ppRasterizer = pRasterizer;
+}
+
+void removeOcclusionRasterizer(OcclusionRasterizer* pRasterizer)
+{
+	conf_free(pRasterizer->pTiles);
+	pRasterizer->~OcclusionRasterizer();
+	conf_free(pRasterizer);
+}
+
+void beginOcclusionFrame(OcclusionRasterizer* pRasterizer, const float* viewProj)
+{
+	memcpy(pRasterizer->mViewProj, viewProj, sizeof(pRasterizer->mViewProj));
+
+	const uint32_t tileCount = pRasterizer->mTilesX * pRasterizer->mTilesY;
+	for (uint32_t i = 0; i < tileCount; ++i)
+	{
+		OcclusionTile* pTile = &pRasterizer->pTiles[i];
+		memset(pTile->mMask, 0, sizeof(pTile->mMask));
+		pTile->mRefDepth = FLT_MAX;
+		pTile->mWorkDepth = 0.0f;
+	}
+
+	pRasterizer->mMeshes.clear();
+	pRasterizer->mTriangleCount = 0;
+	memset(&pRasterizer->mStats, 0, sizeof(pRasterizer->mStats));
+}
+
+void addOccluderMesh(OcclusionRasterizer* pRasterizer, const OccluderMesh* pMesh)
+{
+	if (!pMesh->mTriangleCount)
+		return;
+
+	OccluderMeshItem item;
+	item.mMesh = *pMesh;
+	item.mFirstTriangle = pRasterizer->mTriangleCount;
+	if (pMesh->pWorld)
+		multiplyMatrix(pRasterizer->mViewProj, (const float(*)[4])pMesh->pWorld, item.mMvp);
+	else
+		memcpy(item.mMvp, pRasterizer->mViewProj, sizeof(item.mMvp));
+
+	pRasterizer->mMeshes.push_back(item);
+	pRasterizer->mTriangleCount += pMesh->mTriangleCount;
+}
+/************************************************************************/
+// Triangle setup and binning
+/************************************************************************/
+static inline const float* getOccluderPosition(const OccluderMesh* pMesh, uint32_t triangle, uint32_t corner)
+{
+	const uint32_t index = pMesh->pIndices ? pMesh->pIndices[triangle * 3 + corner] : triangle * 3 + corner;
+	return (const float*)((const uint8_t*)pMesh->pPositions + (size_t)index * pMesh->mVertexStride);
+}
+
+// Projects the triangle to pixels. Returns false if it is rejected
+static bool setupTriangle(const OcclusionRasterizer* pRasterizer, const OccluderMeshItem* pItem, uint32_t triangle, BinnedTriangle* pTriangle)
+{
+	float screen[3][3];
+	for (uint32_t k = 0; k < 3; ++k)
+	{
+		float clip[4];
+		transformPosition(pItem->mMvp, getOccluderPosition(&pItem->mMesh, triangle, k), clip);
+		if (clip[3] < OCCLUSION_MIN_W)
+			return false;
+
+		const float invW = 1.0f / clip[3];
+		screen[k][0] = (clip[0] * invW * 0.5f + 0.5f) * pRasterizer->mWidth;
+		screen[k][1] = (clip[1] * invW * 0.5f + 0.5f) * pRasterizer->mHeight;
+		screen[k][2] = clip[2] * invW;
+	}
+
+	const float area = (screen[1][0] - screen[0][0]) * (screen[2][1] - screen[0][1]) - (screen[2][0] - screen[0][0]) * (screen[1][1] - screen[0][1]);
+	if (area == 0.0f || (area < 0.0f && !pItem->mMesh.mTwoSided))
+		return false;
+
+	// Store counter clockwise so the edge functions are positive inside
+	const uint32_t order[3] = { 0, area > 0.0f ? 1U : 2U, area > 0.0f ? 2U : 1U };
+	for (uint32_t k = 0; k < 3; ++k)
+	{
+		pTriangle->mX[k] = screen[order[k]][0];
+		pTriangle->mY[k] = screen[order[k]][1];
+		pTriangle->mZ[k] = screen[order[k]][2];
+	}
+
+	// Pixels whose center is inside the bounds
+	const float minX = min(screen[0][0], min(screen[1][0], screen[2][0]));
+	const float maxX = max(screen[0][0], max(screen[1][0], screen[2][0]));
+	const float minY = min(screen[0][1], min(screen[1][1], screen[2][1]));
+	const float maxY = max(screen[0][1], max(screen[1][1], screen[2][1]));
+	const int pixelMinX = max((int)ceilf(minX - 0.5f), 0);
+	const int pixelMaxX = min((int)floorf(maxX - 0.5f), (int)pRasterizer->mWidth - 1);
+	const int pixelMinY = max((int)ceilf(minY - 0.5f), 0);
+	const int pixelMaxY = min((int)floorf(maxY - 0.5f), (int)pRasterizer->mHeight - 1);
+	if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+		return false;
+
+	pTriangle->mTileMinX = (uint16_t)(pixelMinX / OCCLUSION_TILE_WIDTH);
+	pTriangle->mTileMaxX = (uint16_t)(pixelMaxX / OCCLUSION_TILE_WIDTH);
+	pTriangle->mTileMinY = (uint16_t)(pixelMinY / OCCLUSION_TILE_HEIGHT);
+	pTriangle->mTileMaxY = (uint16_t)(pixelMaxY / OCCLUSION_TILE_HEIGHT);
+	return true;
+}
+
+static void setupOccludersJob(void* pData)
+{
+	PROFILE_SCOPE("Occluder Setup");
+
+	OcclusionSetupJob* pJob = (OcclusionSetupJob*)pData;
+	const OcclusionRasterizer* pRasterizer = pJob->pRasterizer;
+	pJob->mTriangles.clear();
+	for (uint32_t b = 0; b < pRasterizer->mBinCount; ++b)
+		pJob->mBins[b].clear();
+
+	// Mesh holding the first triangle of the job
+	uint32_t meshIndex = 0;
+	while (meshIndex + 1 < (uint32_t)pRasterizer->mMeshes.size() && pRasterizer->mMeshes[meshIndex + 1].mFirstTriangle <= pJob->mFirstTriangle)
+		++meshIndex;
+
+	BinnedTriangle triangle;
+	for (uint32_t t = pJob->mFirstTriangle; t < pJob->mEndTriangle; ++t)
+	{
+		const OccluderMeshItem* pItem = &pRasterizer->mMeshes[meshIndex];
+		while (t >= pItem->mFirstTriangle + pItem->mMesh.mTriangleCount)
+			pItem = &pRasterizer->mMeshes[++meshIndex];
+
+		if (!setupTriangle(pRasterizer, pItem, t - pItem->mFirstTriangle, &triangle))
+			continue;
+
+		const uint32_t index = (uint32_t)pJob->mTriangles.size();
+		pJob->mTriangles.push_back(triangle);
+		const uint32_t firstBin = triangle.mTileMinY / pRasterizer->mTileRowsPerBin;
+		const uint32_t lastBin = triangle.mTileMaxY / pRasterizer->mTileRowsPerBin;
+		for (uint32_t b = firstBin; b <= lastBin; ++b)
+			pJob->mBins[b].push_back(index);
+	}
+}
+/************************************************************************/
+// Rasterization
+/************************************************************************/
+// Merges the coverage of a triangle with its farthest depth in the tile into the tile
+static inline void updateTile(OcclusionTile* pTile, const uint32_t* pMask, float depth)
+{
+	if (depth >= pTile->mRefDepth)
+		return;
+
+	uint32_t workCoverage = 0;
+	for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+		workCoverage |= pTile->mMask[r];
+
+	// A triangle much nearer than the working layer starts a new one. Merging would push it back to the far working depth
+	if (!workCoverage || pTile->mWorkDepth - depth > pTile->mRefDepth - pTile->mWorkDepth)
+	{
+		pTile->mWorkDepth = depth;
+		memcpy(pTile->mMask, pMask, sizeof(pTile->mMask));
+	}
+	else
+	{
+		pTile->mWorkDepth = max(pTile->mWorkDepth, depth);
+		for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+			pTile->mMask[r] |= pMask[r];
+	}
+
+	uint32_t fullCoverage = ~0U;
+	for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+		fullCoverage &= pTile->mMask[r];
+	if (fullCoverage == ~0U)
+	{
+		pTile->mRefDepth = pTile->mWorkDepth;
+		memset(pTile->mMask, 0, sizeof(pTile->mMask));
+	}
+}
+
+// Coverage of the pixel centers of one tile. e[i] is edge function i at the first pixel center, a[i] / b[i] its steps along x / y.
+// All variants evaluate (e + a * x) + b * y in the same order, so they report the same coverage
+typedef void (*TileCoverageFunction)(const float* e, const float* a, const float* b, uint32_t* pMask);
+
+static void getTileCoverageScalar(const float* e, const float* a, const float* b, uint32_t* pMask)
+{
+	for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+	{
+		uint32_t mask = 0;
+		for (uint32_t x = 0; x < OCCLUSION_TILE_WIDTH; ++x)
+		{
+			bool inside = true;
+			for (uint32_t i = 0; i < 3; ++i)
+				inside = inside && (e[i] + a[i] * (float)x) + b[i] * (float)r >= 0.0f;
+			mask |= (uint32_t)inside << x;
+		}
+		pMask[r] = mask;
+	}
+}
+
+#if defined(OCCLUSION_SSE)
+static void getTileCoverageSSE(const float* e, const float* a, const float* b, uint32_t* pMask)
+{
+	const __m128 zero = _mm_setzero_ps();
+	__m128 columnE[OCCLUSION_TILE_WIDTH / 4][3];
+	for (uint32_t x = 0; x < OCCLUSION_TILE_WIDTH; x += 4)
+	{
+		const __m128 columns = _mm_set_ps((float)(x + 3), (float)(x + 2), (float)(x + 1), (float)x);
+		for (uint32_t i = 0; i < 3; ++i)
+			columnE[x / 4][i] = _mm_add_ps(_mm_set1_ps(e[i]), _mm_mul_ps(_mm_set1_ps(a[i]), columns));
+	}
+
+	for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+	{
+		const __m128 rowE[3] = { _mm_set1_ps(b[0] * (float)r), _mm_set1_ps(b[1] * (float)r), _mm_set1_ps(b[2] * (float)r) };
+		uint32_t mask = 0;
+		for (uint32_t x = 0; x < OCCLUSION_TILE_WIDTH; x += 4)
+		{
+			const __m128 e0 = _mm_add_ps(columnE[x / 4][0], rowE[0]);
+			const __m128 e1 = _mm_add_ps(columnE[x / 4][1], rowE[1]);
+			const __m128 e2 = _mm_add_ps(columnE[x / 4][2], rowE[2]);
+			const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+			mask |= (uint32_t)_mm_movemask_ps(inside) << x;
+		}
+		pMask[r] = mask;
+	}
+}
+#endif
+
+#if defined(CPU_X86)
+static CPU_TARGET_AVX void getTileCoverageAVX(const float* e, const float* a, const float* b, uint32_t* pMask)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	__m256 columnE[OCCLUSION_TILE_WIDTH / 8][3];
+	for (uint32_t x = 0; x < OCCLUSION_TILE_WIDTH; x += 8)
+	{
+		const __m256 columns = _mm256_set_ps((float)(x + 7), (float)(x + 6), (float)(x + 5), (float)(x + 4), (float)(x + 3), (float)(x + 2), (float)(x + 1), (float)x);
+		for (uint32_t i = 0; i < 3; ++i)
+			columnE[x / 8][i] = _mm256_add_ps(_mm256_set1_ps(e[i]), _mm256_mul_ps(_mm256_set1_ps(a[i]), columns));
+	}
+
+	for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+	{
+		const __m256 rowE[3] = { _mm256_set1_ps(b[0] * (float)r), _mm256_set1_ps(b[1] * (float)r), _mm256_set1_ps(b[2] * (float)r) };
+		uint32_t mask = 0;
+		for (uint32_t x = 0; x < OCCLUSION_TILE_WIDTH; x += 8)
+		{
+			const __m256 e0 = _mm256_add_ps(columnE[x / 8][0], rowE[0]);
+			const __m256 e1 = _mm256_add_ps(columnE[x / 8][1], rowE[1]);
+			const __m256 e2 = _mm256_add_ps(columnE[x / 8][2], rowE[2]);
+			const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+			mask |= (uint32_t)_mm256_movemask_ps(inside) << x;
+		}
+		pMask[r] = mask;
+	}
+}
+#endif
+
+static const CpuKernelVariant gTileCoverageVariants[] = {
+#if defined(CPU_X86)
+	{ "AVX", CPU_FEATURE_AVX, (CpuKernelFunction)getTileCoverageAVX },
+#endif
+#if defined(OCCLUSION_SSE)
+	{ "SSE", CPU_FEATURE_SSE2, (CpuKernelFunction)getTileCoverageSSE },
+#endif
+	{ "Scalar", CPU_FEATURE_NONE, (CpuKernelFunction)getTileCoverageScalar },
+};
+static CpuKernel gTileCoverageKernel = { "Occlusion tile coverage", gTileCoverageVariants, sizeof(gTileCoverageVariants) / sizeof(gTileCoverageVariants[0]), NULL, NULL, NULL };
+static CpuKernelRegistration gTileCoverageRegistration(&gTileCoverageKernel);
+
+static uint32_t rasterizeTriangle(OcclusionRasterizer* pRasterizer, const BinnedTriangle* pTriangle, uint32_t tileMinY, uint32_t tileMaxY)
+{
+	const float* x = pTriangle->mX;
+	const float* y = pTriangle->mY;
+	const float* z = pTriangle->mZ;
+
+	// Edge i is opposite to vertex i
+	const float a[3] = { y[1] - y[2], y[2] - y[0], y[0] - y[1] };
+	const float b[3] = { x[2] - x[1], x[0] - x[2], x[1] - x[0] };
+	const float edgeX[3] = { x[1], x[2], x[0] };
+	const float edgeY[3] = { y[1], y[2], y[0] };
+
+	// Depth is affine in screen space after the perspective divide
+	const float area = a[0] * (x[0] - x[1]) + b[0] * (y[0] - y[1]);
+	const float dzdx = (a[0] * z[0] + a[1] * z[1] + a[2] * z[2]) / area;
+	const float dzdy = (b[0] * z[0] + b[1] * z[1] + b[2] * z[2]) / area;
+	const float maxZ = max(z[0], max(z[1], z[2]));
+
+	const float tileStepX[3] = { a[0] * (OCCLUSION_TILE_WIDTH - 1), a[1] * (OCCLUSION_TILE_WIDTH - 1), a[2] * (OCCLUSION_TILE_WIDTH - 1) };
+	const float tileStepY[3] = { b[0] * (OCCLUSION_TILE_HEIGHT - 1), b[1] * (OCCLUSION_TILE_HEIGHT - 1), b[2] * (OCCLUSION_TILE_HEIGHT - 1) };
+	const uint32_t fullMask[OCCLUSION_TILE_HEIGHT] = { ~0U, ~0U, ~0U, ~0U, ~0U, ~0U, ~0U, ~0U };
+
+	uint32_t tileUpdates = 0;
+	for (uint32_t ty = max((uint32_t)pTriangle->mTileMinY, tileMinY); ty <= min((uint32_t)pTriangle->mTileMaxY, tileMaxY); ++ty)
+	{
+		OcclusionTile* pRow = pRasterizer->pTiles + ty * pRasterizer->mTilesX;
+		const float py = (float)(ty * OCCLUSION_TILE_HEIGHT);
+		for (uint32_t tx = pTriangle->mTileMinX; tx <= pTriangle->mTileMaxX; ++tx)
+		{
+			const float px = (float)(tx * OCCLUSION_TILE_WIDTH);
+
+			// Edge functions at the first pixel center, then the corner pixel centers to accept or reject the whole tile
+			float e[3];
+			bool outside = false;
+			bool covered = true;
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				e[i] = a[i] * (px + 0.5f - edgeX[i]) + b[i] * (py + 0.5f - edgeY[i]);
+				const float e10 = e[i] + tileStepX[i];
+				const float e01 = e[i] + tileStepY[i];
+				const float e11 = e10 + tileStepY[i];
+				outside = outside || max(max(e[i], e10), max(e01, e11)) < 0.0f;
+				covered = covered && min(min(e[i], e10), min(e01, e11)) >= 0.0f;
+			}
+			if (outside)
+				continue;
+
+			uint32_t mask[OCCLUSION_TILE_HEIGHT];
+			const uint32_t* pMask = fullMask;
+			if (!covered)
+			{
+				((TileCoverageFunction)gTileCoverageKernel.pFunction)(e, a, b, mask);
+				uint32_t any = 0;
+				for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+					any |= mask[r];
+				if (!any)
+					continue;
+				pMask = mask;
+			}
+
+			// Farthest depth of the triangle plane over the tile, never farther than the farthest vertex
+			const float depth00 = z[0] + dzdx * (px - x[0]) + dzdy * (py - y[0]);
+			const float depthX = dzdx * OCCLUSION_TILE_WIDTH;
+			const float depthY = dzdy * OCCLUSION_TILE_HEIGHT;
+			const float tileMaxZ = depth00 + max(depthX, 0.0f) + max(depthY, 0.0f);
+			updateTile(&pRow[tx], pMask, min(tileMaxZ, maxZ));
+			++tileUpdates;
+		}
+	}
+	return tileUpdates;
+}
+
+static void rasterizeBinJob(void* pData)
+{
+	PROFILE_SCOPE("Occluder Rasterization");
+
+	OcclusionRasterJob* pJob = (OcclusionRasterJob*)pData;
+	OcclusionRasterizer* pRasterizer = pJob->pRasterizer;
+	const uint32_t tileMinY = pJob->mBin * pRasterizer->mTileRowsPerBin;
+	const uint32_t tileMaxY = min(tileMinY + pRasterizer->mTileRowsPerBin, pRasterizer->mTilesY) - 1;
+
+	// Setup jobs are walked in order, so the result does not depend on the thread count
+	pJob->mTileUpdates = 0;
+	for (uint32_t j = 0; j < pRasterizer->mSetupJobCount; ++j)
+	{
+		const OcclusionSetupJob* pSetupJob = &pRasterizer->mSetupJobs[j];
+		const tinystl::vector<uint32_t>& bin = pSetupJob->mBins[pJob->mBin];
+		for (uint32_t i = 0; i < (uint32_t)bin.size(); ++i)
+			pJob->mTileUpdates += rasterizeTriangle(pRasterizer, &pSetupJob->mTriangles[bin[i]], tileMinY, tileMaxY);
+	}
+}
+
+void rasterizeOccluders(OcclusionRasterizer* pRasterizer)
+{
+	PROFILE_SCOPE("Rasterize Occluders");
+
+	const uint32_t triangleCount = pRasterizer->mTriangleCount;
+	pRasterizer->mStats.mOccluderTriangles += triangleCount;
+	if (!triangleCount)
+		return;
+
+	const uint32_t maxJobs = pRasterizer->pThreadPool ? OCCLUSION_MAX_SETUP_JOBS : 1U;
+	const uint32_t trianglesPerJob = max((triangleCount + maxJobs - 1) / maxJobs, (uint32_t)OCCLUSION_MIN_SETUP_JOB_TRIANGLES);
+	pRasterizer->mSetupJobCount = (triangleCount + trianglesPerJob - 1) / trianglesPerJob;
+
+	WorkItem* pWorkItems = pRasterizer->mWorkItems;
+	for (uint32_t i = 0; i < pRasterizer->mSetupJobCount; ++i)
+	{
+		OcclusionSetupJob* pJob = &pRasterizer->mSetupJobs[i];
+		pJob->pRasterizer = pRasterizer;
+		pJob->mFirstTriangle = i * trianglesPerJob;
+		pJob->mEndTriangle = min(pJob->mFirstTriangle + trianglesPerJob, triangleCount);
+		pWorkItems[i].pFunc = setupOccludersJob;
+		pWorkItems[i].pData = pJob;
+	}
+	runOcclusionJobs(pRasterizer, pWorkItems, pRasterizer->mSetupJobCount);
+
+	for (uint32_t i = 0; i < pRasterizer->mBinCount; ++i)
+	{
+		OcclusionRasterJob* pJob = &pRasterizer->mRasterJobs[i];
+		pJob->pRasterizer = pRasterizer;
+		pJob->mBin = i;
+		pWorkItems[i].pFunc = rasterizeBinJob;
+		pWorkItems[i].pData = pJob;
+	}
+	runOcclusionJobs(pRasterizer, pWorkItems, pRasterizer->mBinCount);
+
+	for (uint32_t i = 0; i < pRasterizer->mSetupJobCount; ++i)
+		pRasterizer->mStats.mRasterizedTriangles += (uint32_t)pRasterizer->mSetupJobs[i].mTriangles.size();
+	for (uint32_t i = 0; i < pRasterizer->mBinCount; ++i)
+		pRasterizer->mStats.mTileUpdates += pRasterizer->mRasterJobs[i].mTileUpdates;
+
+	// The occluder data is only guaranteed to be valid until here
+	pRasterizer->mMeshes.clear();
+	pRasterizer->mTriangleCount = 0;
+}
+/************************************************************************/
+// Box tests
+/************************************************************************/
+// Projects the corners of the box to pixels. Returns false if a corner is too close to the eye plane
+static bool projectBox(const OcclusionRasterizer* pRasterizer, const float* aabbMin, const float* aabbMax, float* pRect, float* pMinZ)
+{
+#if defined(OCCLUSION_SSE)
+	// Four corners per iteration: x alternates, y goes in pairs, z is the same for all four
+	const __m128 cornerX = _mm_set_ps(aabbMax[0], aabbMin[0], aabbMax[0], aabbMin[0]);
+	const __m128 cornerY = _mm_set_ps(aabbMax[1], aabbMax[1], aabbMin[1], aabbMin[1]);
+	const __m128 halfWidth = _mm_set1_ps(0.5f * pRasterizer->mWidth);
+	const __m128 halfHeight = _mm_set1_ps(0.5f * pRasterizer->mHeight);
+	const float(*mvp)[4] = pRasterizer->mViewProj;
+	__m128 minX = _mm_set1_ps(FLT_MAX), minY = minX, minZ = minX;
+	__m128 maxX = _mm_set1_ps(-FLT_MAX), maxY = maxX;
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		const __m128 cornerZ = _mm_set1_ps(i ? aabbMax[2] : aabbMin[2]);
+		__m128 clip[4];
+		for (uint32_t r = 0; r < 4; ++r)
+		{
+			clip[r] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mvp[0][r]), cornerX), _mm_mul_ps(_mm_set1_ps(mvp[1][r]), cornerY));
+			clip[r] = _mm_add_ps(clip[r], _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mvp[2][r]), cornerZ), _mm_set1_ps(mvp[3][r])));
+		}
+		if (_mm_movemask_ps(_mm_cmplt_ps(clip[3], _mm_set1_ps(OCCLUSION_MIN_W))))
+			return false;
+
+		const __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), clip[3]);
+		const __m128 x = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(clip[0], invW), _mm_set1_ps(1.0f)), halfWidth);
+		const __m128 y = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(clip[1], invW), _mm_set1_ps(1.0f)), halfHeight);
+		minX = _mm_min_ps(minX, x);
+		maxX = _mm_max_ps(maxX, x);
+		minY = _mm_min_ps(minY, y);
+		maxY = _mm_max_ps(maxY, y);
+		minZ = _mm_min_ps(minZ, _mm_mul_ps(clip[2], invW));
+	}
+
+	float lanes[5][4];
+	_mm_storeu_ps(lanes[0], minX);
+	_mm_storeu_ps(lanes[1], minY);
+	_mm_storeu_ps(lanes[2], maxX);
+	_mm_storeu_ps(lanes[3], maxY);
+	_mm_storeu_ps(lanes[4], minZ);
+	pRect[0] = min(min(lanes[0][0], lanes[0][1]), min(lanes[0][2], lanes[0][3]));
+	pRect[1] = min(min(lanes[1][0], lanes[1][1]), min(lanes[1][2], lanes[1][3]));
+	pRect[2] = max(max(lanes[2][0], lanes[2][1]), max(lanes[2][2], lanes[2][3]));
+	pRect[3] = max(max(lanes[3][0], lanes[3][1]), max(lanes[3][2], lanes[3][3]));
+	*pMinZ = min(min(lanes[4][0], lanes[4][1]), min(lanes[4][2], lanes[4][3]));
+#else
+	pRect[0] = pRect[1] = *pMinZ = FLT_MAX;
+	pRect[2] = pRect[3] = -FLT_MAX;
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		const float corner[3] = { (i & 1) ? aabbMax[0] : aabbMin[0], (i & 2) ? aabbMax[1] : aabbMin[1], (i & 4) ? aabbMax[2] : aabbMin[2] };
+		float clip[4];
+		transformPosition(pRasterizer->mViewProj, corner, clip);
+		if (clip[3] < OCCLUSION_MIN_W)
+			return false;
+
+		const float invW = 1.0f / clip[3];
+		const float x = (clip[0] * invW + 1.0f) * 0.5f * pRasterizer->mWidth;
+		const float y = (clip[1] * invW + 1.0f) * 0.5f * pRasterizer->mHeight;
+		pRect[0] = min(pRect[0], x);
+		pRect[1] = min(pRect[1], y);
+		pRect[2] = max(pRect[2], x);
+		pRect[3] = max(pRect[3], y);
+		*pMinZ = min(*pMinZ, clip[2] * invW);
+	}
+#endif
+	return true;
+}
+
+bool occlusionTestBox(const OcclusionRasterizer* pRasterizer, const float* aabbMin, const float* aabbMax)
+{
+	float rect[4];
+	float minZ;
+	if (!projectBox(pRasterizer, aabbMin, aabbMax, rect, &minZ))
+		return false;
+
+	const float width = (float)pRasterizer->mWidth;
+	const float height = (float)pRasterizer->mHeight;
+	if (rect[2] < 0.0f || rect[3] < 0.0f || rect[0] >= width || rect[1] >= height)
+		return true;
+
+	// Every pixel the box overlaps
+	const uint32_t pixelMinX = (uint32_t)max(rect[0], 0.0f);
+	const uint32_t pixelMinY = (uint32_t)max(rect[1], 0.0f);
+	const uint32_t pixelMaxX = (uint32_t)min(rect[2], width - 1.0f);
+	const uint32_t pixelMaxY = (uint32_t)min(rect[3], height - 1.0f);
+
+	for (uint32_t ty = pixelMinY / OCCLUSION_TILE_HEIGHT; ty <= pixelMaxY / OCCLUSION_TILE_HEIGHT; ++ty)
+	{
+		const OcclusionTile* pRow = pRasterizer->pTiles + ty * pRasterizer->mTilesX;
+		const uint32_t rowStart = ty * OCCLUSION_TILE_HEIGHT;
+		const uint32_t firstRow = max(pixelMinY, rowStart) - rowStart;
+		const uint32_t lastRow = min(pixelMaxY, rowStart + OCCLUSION_TILE_HEIGHT - 1) - rowStart;
+		for (uint32_t tx = pixelMinX / OCCLUSION_TILE_WIDTH; tx <= pixelMaxX / OCCLUSION_TILE_WIDTH; ++tx)
+		{
+			const OcclusionTile* pTile = &pRow[tx];
+			// The working layer is always nearer than the reference
+			if (minZ > pTile->mRefDepth)
+				continue;
+
+			const uint32_t columnStart = tx * OCCLUSION_TILE_WIDTH;
+			const uint32_t firstColumn = max(pixelMinX, columnStart) - columnStart;
+			const uint32_t lastColumn = min(pixelMaxX, columnStart + OCCLUSION_TILE_WIDTH - 1) - columnStart;
+			const uint32_t columnMask = (~0U >> (OCCLUSION_TILE_WIDTH - 1 - lastColumn)) & (~0U << firstColumn);
+			for (uint32_t r = firstRow; r <= lastRow; ++r)
+			{
+				// Pixels outside of the working layer are only known to be nearer than the reference depth
+				if (columnMask & ~pTile->mMask[r])
+					return false;
+				if (minZ <= pTile->mWorkDepth)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void testBoxesJob(void* pData)
+{
+	PROFILE_SCOPE("Occlusion Tests");
+
+	OcclusionTestJob* pJob = (OcclusionTestJob*)pData;
+	pJob->mOccludedBoxes = 0;
+	for (uint32_t i = pJob->mFirstBox; i < pJob->mEndBox; ++i)
+	{
+		const size_t offset = (size_t)i * pJob->mBoxStride;
+		const float* aabbMin = (const float*)((const uint8_t*)pJob->pAabbMin + offset);
+		const float* aabbMax = (const float*)((const uint8_t*)pJob->pAabbMax + offset);
+		pJob->pOccluded[i] = occlusionTestBox(pJob->pRasterizer, aabbMin, aabbMax);
+		pJob->mOccludedBoxes += pJob->pOccluded[i];
+	}
+}
+
+uint32_t occlusionTestBoxes(OcclusionRasterizer* pRasterizer, uint32_t count, const float* pAabbMin, const float* pAabbMax, uint32_t boxStride, bool* pOccluded)
+{
+	if (!count)
+		return 0;
+
+	const uint32_t maxJobs = pRasterizer->pThreadPool ? OCCLUSION_MAX_TEST_JOBS : 1U;
+	const uint32_t boxesPerJob = max((count + maxJobs - 1) / maxJobs, (uint32_t)OCCLUSION_MIN_TEST_JOB_BOXES);
+	const uint32_t jobCount = (count + boxesPerJob - 1) / boxesPerJob;
+
+	WorkItem* pWorkItems = pRasterizer->mWorkItems;
+	for (uint32_t i = 0; i < jobCount; ++i)
+	{
+		OcclusionTestJob* pJob = &pRasterizer->mTestJobs[i];
+		pJob->pRasterizer = pRasterizer;
+		pJob->mFirstBox = i * boxesPerJob;
+		pJob->mEndBox = min(pJob->mFirstBox + boxesPerJob, count);
+		pJob->pAabbMin = pAabbMin;
+		pJob->pAabbMax = pAabbMax;
+		pJob->mBoxStride = boxStride;
+		pJob->pOccluded = pOccluded;
+		pWorkItems[i].pFunc = testBoxesJob;
+		pWorkItems[i].pData = pJob;
+	}
+	runOcclusionJobs(pRasterizer, pWorkItems, jobCount);
+
+	uint32_t occludedBoxes = 0;
+	for (uint32_t i = 0; i < jobCount; ++i)
+		occludedBoxes += pRasterizer->mTestJobs[i].mOccludedBoxes;
+
+	pRasterizer->mStats.mTestedBoxes += count;
+	pRasterizer->mStats.mOccludedBoxes += occludedBoxes;
+	return occludedBoxes;
+}
+
+void getOcclusionRasterizerStats(const OcclusionRasterizer* pRasterizer, OcclusionRasterizerStats* pStats)
+{
+	*pStats = pRasterizer->mStats;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include <stdint.h>
+
+class ThreadPool;
+
+/// Low resolution software rasterizer for CPU occlusion culling, in the style of masked occlusion culling.
+/// The buffer is split in tiles of OCCLUSION_TILE_WIDTH x OCCLUSION_TILE_HEIGHT pixels. Instead of a depth per pixel
+/// every tile keeps a coverage mask and two depths:
+/// - the reference depth, no pixel of the tile is farther than it
+/// - the working depth, no pixel in the coverage mask is farther than it
+/// Triangles are merged into the working layer. Once the working layer covers the whole tile it becomes the reference.
+/// Depth is the clip space z / w, smaller values are nearer.
+///
+/// Occluders are transformed and binned into bands of tile rows, then every band is rasterized by its own job.
+/// Tests only read the buffer, so boxes can be tested from any number of threads once the occluders are rasterized.
+/// A frame looks like: beginOcclusionFrame, addOccluderMesh for every occluder, rasterizeOccluders, occlusionTestBoxes.
+
+#define OCCLUSION_TILE_WIDTH 32
+#define OCCLUSION_TILE_HEIGHT 8
+
+typedef struct OcclusionRasterizer OcclusionRasterizer;
+
+typedef struct OccluderMesh
+{
+	/// Position of the first vertex, three floats. Vertices are mVertexStride bytes apart
+	const float*    pPositions;
+	uint32_t        mVertexStride;
+	/// Three indices per triangle. Without indices the vertices are read in order
+	const uint32_t* pIndices;
+	uint32_t        mTriangleCount;
+	/// Object to world transform, column major. Identity if NULL
+	const float*    pWorld;
+	/// Triangles that are clockwise after projection are skipped unless the mesh is two sided
+	bool            mTwoSided;
+} OccluderMesh;
+
+typedef struct OcclusionRasterizerDesc
+{
+	/// Rounded up to whole tiles
+	uint32_t    mWidth;
+	uint32_t    mHeight;
+	/// Binning, rasterization and box tests are split in jobs on this pool. Everything runs on the calling thread if NULL
+	ThreadPool* pThreadPool;
+} OcclusionRasterizerDesc;
+
+typedef struct OcclusionRasterizerStats
+{
+	uint32_t mOccluderTriangles;
+	/// Triangles left after near plane, back face and screen bounds rejection
+	uint32_t mRasterizedTriangles;
+	/// Number of tiles a triangle was merged into
+	uint32_t mTileUpdates;
+	uint32_t mTestedBoxes;
+	uint32_t mOccludedBoxes;
+} OcclusionRasterizerStats;
+
+void addOcclusionRasterizer(const OcclusionRasterizerDesc* pDesc, OcclusionRasterizer** ppRasterizer);
+void removeOcclusionRasterizer(OcclusionRasterizer* pRasterizer);
+
+/// Clears the buffer and the queued occluders. viewProj is the world to clip space transform (column major) used until the next call
+void beginOcclusionFrame(OcclusionRasterizer* pRasterizer, const float* viewProj);
+/// Queues the mesh. The vertex, index and transform data have to stay valid until rasterizeOccluders returns
+void addOccluderMesh(OcclusionRasterizer* pRasterizer, const OccluderMesh* pMesh);
+void rasterizeOccluders(OcclusionRasterizer* pRasterizer);
+
+/// Returns true if the world space box is outside of the view or hidden behind the occluders
+bool occlusionTestBox(const OcclusionRasterizer* pRasterizer, const float* aabbMin, const float* aabbMax);
+/// Tests count boxes and writes one result per box to pOccluded. The first box is at pAabbMin / pAabbMax (three floats each)
+/// and the next ones follow every boxStride bytes. Returns the number of occluded boxes
+uint32_t occlusionTestBoxes(OcclusionRasterizer* pRasterizer, uint32_t count, const float* pAabbMin, const float* pAabbMax, uint32_t boxStride, bool* pOccluded);
+
+void getOcclusionRasterizerStats(const OcclusionRasterizer* pRasterizer, OcclusionRasterizerStats* pStats);
@@ -0,0 +1,573 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_USE_RDTSC
+#endif
+#endif
+
+#include "../../ThirdParty/OpenSource/TinySTL/unordered_map.h"
+#include "../Interfaces/IProfiler.h"
+#include "../Interfaces/IThread.h"
+#include "../Interfaces/ILogManager.h"
+#include "Atomics.h"
+#include "../Interfaces/IMemoryManager.h"
+
+#if defined(_MSC_VER)
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILER_THREAD_LOCAL __thread
+#endif
+
+#define PROFILER_MAX_ZONE_DEPTH 64
+#define PROFILER_MAX_NAME_LENGTH 64
+
+typedef struct ProfileThread
+{
+	ProfileEvent*   pEvents;
+	uint64_t        mEventMask;
+	/// Only written by the owning thread. Read by export and stats
+	tfrg_atomic64_t mWriteCount;
+	/// Write index of every zone that is still open
+	uint64_t        mOpenZones[PROFILER_MAX_ZONE_DEPTH];
+	uint32_t        mDepth;
+	uint32_t        mIndex;
+	char            mName[PROFILER_MAX_NAME_LENGTH];
+} ProfileThread;
+
+typedef struct Profiler
+{
+	Mutex                          mMutex;
+	tinystl::vector<ProfileThread*> mThreads;
+	tinystl::vector<tinystl::string> mGpuTracks;
+	/// Copies of names recorded by owners which can go away before the export
+	tinystl::unordered_map<tinystl::string, char*> mInternedStrings;
+	uint32_t                       mEventsPerThread;
+	int64_t                        mStartTicks;
+	int64_t                        mTickFrequency;
+	tfrg_atomic64_t                mFrameIndex;
+} Profiler;
+
+static Profiler* pProfiler = NULL;
+// Bumped on every initProfiler so thread local pointers from a previous session are not reused
+static uint32_t gProfilerGeneration = 0;
+
+static PROFILER_THREAD_LOCAL ProfileThread* pProfileThread = NULL;
+static PROFILER_THREAD_LOCAL uint32_t gProfileThreadGeneration = 0;
+
+/************************************************************************/
+// Clock
+/************************************************************************/
+#if defined(PROFILER_USE_RDTSC)
+// clock_gettime costs about as much as the rest of a zone. The time stamp counter is read instead
+// and calibrated against CLOCK_MONOTONIC once
+static int64_t gRdtscFrequency = 0;
+
+static int64_t getMonotonicNs()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+}
+
+static int64_t calibrateRdtsc()
+{
+	const int64_t beginNs = getMonotonicNs();
+	const int64_t beginTicks = (int64_t)__rdtsc();
+	int64_t endNs = beginNs;
+	while (endNs - beginNs < 10000000)
+		endNs = getMonotonicNs();
+	const int64_t endTicks = (int64_t)__rdtsc();
+
+	return (int64_t)((double)(endTicks - beginTicks) * 1e9 / (double)(endNs - beginNs));
+}
+#endif
+
+int64_t getProfilerTicks()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+#elif defined(__APPLE__)
+	return (int64_t)mach_absolute_time();
+#elif defined(PROFILER_USE_RDTSC)
+	return (int64_t)__rdtsc();
+#else
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+#endif
+}
+
+int64_t getProfilerTickFrequency()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return frequency.QuadPart;
+#elif defined(__APPLE__)
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	return (int64_t)(1000000000.0 * (double)timebase.denom / (double)timebase.numer);
+#elif defined(PROFILER_USE_RDTSC)
+	if (gRdtscFrequency == 0)
+		gRdtscFrequency = calibrateRdtsc();
+	return gRdtscFrequency;
+#else
+	return 1000000000LL;
+#endif
+}
+/************************************************************************/
+// Thread rings
+/************************************************************************/
+static ProfileThread* registerProfileThread()
+{
+	ProfileThread* pThread = (ProfileThread*)conf_calloc(1, sizeof(ProfileThread));
+	pThread->pEvents = (ProfileEvent*)conf_calloc(pProfiler->mEventsPerThread, sizeof(ProfileEvent));
+	pThread->mEventMask = pProfiler->mEventsPerThread - 1;
+
+	{
+		MutexLock lock(pProfiler->mMutex);
+		pThread->mIndex = (uint32_t)pProfiler->mThreads.size();
+		snprintf(pThread->mName, PROFILER_MAX_NAME_LENGTH, "Thread %u", pThread->mIndex);
+		pProfiler->mThreads.push_back(pThread);
+	}
+
+	pProfileThread = pThread;
+	gProfileThreadGeneration = gProfilerGeneration;
+	return pThread;
+}
+
+static inline ProfileThread* getProfileThread()
+{
+	if (pProfileThread && gProfileThreadGeneration == gProfilerGeneration)
+		return pProfileThread;
+
+	return registerProfileThread();
+}
+
+// Reserves the next event in the ring of the calling thread. Old events are overwritten when the ring is full
+static inline ProfileEvent* pushEvent(ProfileThread* pThread, uint32_t type, const char* pName, int64_t begin, int64_t end, uint32_t track, uint32_t depth)
+{
+	const uint64_t writeIndex = tfrg_atomic64_load_relaxed(&pThread->mWriteCount);
+	ProfileEvent* pEvent = &pThread->pEvents[writeIndex & pThread->mEventMask];
+	pEvent->pName = pName;
+	pEvent->mBegin = begin;
+	pEvent->mEnd = end;
+	pEvent->mType = (uint16_t)type;
+	pEvent->mDepth = (uint16_t)depth;
+	pEvent->mTrack = track;
+	tfrg_atomic64_store_relaxed(&pThread->mWriteCount, writeIndex + 1);
+	return pEvent;
+}
+
+void initProfiler(uint32_t eventsPerThread)
+{
+	ASSERT(pProfiler == NULL && "Profiler is already initialized");
+
+	uint32_t capacity = 1;
+	while (capacity < eventsPerThread)
+		capacity <<= 1;
+
+	pProfiler = conf_placement_new<Profiler>(conf_calloc(1, sizeof(Profiler)));
+	pProfiler->mEventsPerThread = capacity;
+	pProfiler->mTickFrequency = getProfilerTickFrequency();
+	pProfiler->mStartTicks = getProfilerTicks();
+	++gProfilerGeneration;
+}
+
+void exitProfiler()
+{
+	if (!pProfiler)
+		return;
+
+	for (uint32_t i = 0; i < (uint32_t)pProfiler->mThreads.size(); ++i)
+	{
+		conf_free(pProfiler->mThreads[i]->pEvents);
+		conf_free(pProfiler->mThreads[i]);
+	}
+
+	for (tinystl::unordered_map<tinystl::string, char*>::iterator it = pProfiler->mInternedStrings.begin(); it != pProfiler->mInternedStrings.end(); ++it)
+		conf_free(it->second);
+
+	pProfiler->~Profiler();
+	conf_free(pProfiler);
+	pProfiler = NULL;
+}
+
+void setProfilerThreadName(const char* pName)
+{
+	if (!pProfiler)
+		return;
+
+	ProfileThread* pThread = getProfileThread();
+	MutexLock lock(pProfiler->mMutex);
+	strncpy(pThread->mName, pName, PROFILER_MAX_NAME_LENGTH - 1);
+	pThread->mName[PROFILER_MAX_NAME_LENGTH - 1] = '\0';
+}
+/************************************************************************/
+// Recording
+/************************************************************************/
+const char* internProfilerString(const char* pName)
+{
+	if (!pProfiler || !pName)
+		return pName;
+
+	MutexLock lock(pProfiler->mMutex);
+	tinystl::unordered_map<tinystl::string, char*>::iterator it = pProfiler->mInternedStrings.find(pName);
+	if (it != pProfiler->mInternedStrings.end())
+		return it->second;
+
+	const size_t length = strlen(pName);
+	char* pCopy = (char*)conf_malloc(length + 1);
+	memcpy(pCopy, pName, length + 1);
+	pProfiler->mInternedStrings.insert({ pName, pCopy });
+	return pCopy;
+}
+
+void profileBeginZone(const char* pName)
+{
+	if (!pProfiler)
+		return;
+
+	ProfileThread* pThread = getProfileThread();
+	const uint32_t depth = pThread->mDepth++;
+	if (depth >= PROFILER_MAX_ZONE_DEPTH)
+		return;
+
+	pThread->mOpenZones[depth] = tfrg_atomic64_load_relaxed(&pThread->mWriteCount);
+	// An end tick lower than the begin tick marks the zone as still open
+	pushEvent(pThread, PROFILE_EVENT_ZONE, pName, getProfilerTicks(), -1, 0, depth);
+}
+
+void profileEndZone()
+{
+	if (!pProfiler)
+		return;
+
+	const int64_t ticks = getProfilerTicks();
+	ProfileThread* pThread = getProfileThread();
+	if (pThread->mDepth == 0)
+	{
+		LOGWARNINGF("profileEndZone called without a matching profileBeginZone");
+		return;
+	}
+
+	const uint32_t depth = --pThread->mDepth;
+	if (depth >= PROFILER_MAX_ZONE_DEPTH)
+		return;
+
+	// The begin event is lost if the ring wrapped while the zone was open
+	const uint64_t writeIndex = pThread->mOpenZones[depth];
+	if (tfrg_atomic64_load_relaxed(&pThread->mWriteCount) - writeIndex <= pThread->mEventMask)
+		pThread->pEvents[writeIndex & pThread->mEventMask].mEnd = ticks;
+}
+
+void profileFrameMarker()
+{
+	if (!pProfiler)
+		return;
+
+	const int64_t ticks = getProfilerTicks();
+	ProfileThread* pThread = getProfileThread();
+	const uint64_t frameIndex = tfrg_atomic64_add_relaxed(&pProfiler->mFrameIndex, 1);
+	pushEvent(pThread, PROFILE_EVENT_FRAME, "Frame", ticks, (int64_t)frameIndex, 0, 0);
+
+#ifdef USE_MEMORY_TRACKING
+	const sMStats stats = m_getMemoryStatistics();
+	pushEvent(pThread, PROFILE_EVENT_COUNTER, "Memory Reported (bytes)", ticks, (int64_t)stats.totalReportedMemory, 0, 0);
+	pushEvent(pThread, PROFILE_EVENT_COUNTER, "Memory Allocations", ticks, (int64_t)stats.totalAllocUnitCount, 0, 0);
+#endif
+}
+
+void profileCounter(const char* pName, int64_t value)
+{
+	if (!pProfiler)
+		return;
+
+	pushEvent(getProfileThread(), PROFILE_EVENT_COUNTER, pName, getProfilerTicks(), value, 0, 0);
+}
+
+uint32_t addProfilerGpuTrack(const char* pName)
+{
+	if (!pProfiler)
+		return 0;
+
+	MutexLock lock(pProfiler->mMutex);
+	pProfiler->mGpuTracks.push_back(tinystl::string(pName));
+	return (uint32_t)pProfiler->mGpuTracks.size() - 1;
+}
+
+void profileGpuZone(uint32_t track, const char* pName, int64_t beginTicks, int64_t endTicks, uint32_t depth)
+{
+	if (!pProfiler)
+		return;
+
+	// Depth is clamped like the cpu zones so it fits the event
+	pushEvent(getProfileThread(), PROFILE_EVENT_GPU_ZONE, pName, beginTicks, endTicks, track, min(depth, (uint32_t)PROFILER_MAX_ZONE_DEPTH));
+}
+
+void getProfilerStats(ProfilerStats* pStats)
+{
+	ASSERT(pStats);
+	memset(pStats, 0, sizeof(*pStats));
+	if (!pProfiler)
+		return;
+
+	MutexLock lock(pProfiler->mMutex);
+	pStats->mThreadCount = (uint32_t)pProfiler->mThreads.size();
+	pStats->mGpuTrackCount = (uint32_t)pProfiler->mGpuTracks.size();
+	pStats->mFrameIndex = tfrg_atomic64_load_relaxed(&pProfiler->mFrameIndex);
+	for (uint32_t i = 0; i < pStats->mThreadCount; ++i)
+	{
+		const uint64_t count = tfrg_atomic64_load_relaxed(&pProfiler->mThreads[i]->mWriteCount);
+		const uint64_t capacity = pProfiler->mThreads[i]->mEventMask + 1;
+		pStats->mEventCount += count;
+		pStats->mDroppedEventCount += count > capacity ? count - capacity : 0;
+	}
+}
+double measureProfilerOverhead(uint32_t iterations)
+{
+	if (!pProfiler || !iterations)
+		return 0.0;
+
+	// Swap in a scratch ring so the measurement runs the same path as real zones without overwriting the history
+	ProfileThread* pThread = getProfileThread();
+	ProfileThread* pScratch = (ProfileThread*)conf_calloc(1, sizeof(ProfileThread));
+	pScratch->pEvents = (ProfileEvent*)conf_calloc(pProfiler->mEventsPerThread, sizeof(ProfileEvent));
+	pScratch->mEventMask = pProfiler->mEventsPerThread - 1;
+	pProfileThread = pScratch;
+
+	const int64_t begin = getProfilerTicks();
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		profileBeginZone("Profiler Overhead");
+		profileEndZone();
+	}
+	const int64_t end = getProfilerTicks();
+
+	pProfileThread = pThread;
+	conf_free(pScratch->pEvents);
+	conf_free(pScratch);
+
+	return (double)(end - begin) * 1e9 / ((double)pProfiler->mTickFrequency * (double)iterations);
+}
+/************************************************************************/
+// Chrome trace export
+/************************************************************************/
+typedef struct TraceWriter
+{
+	File*    pFile;
+	uint32_t mSize;
+	bool     mFirstEvent;
+	char     mBuffer[4096];
+} TraceWriter;
+
+static void flushTrace(TraceWriter* pWriter)
+{
+	if (pWriter->mSize)
+		pWriter->pFile->Write(pWriter->mBuffer, pWriter->mSize);
+	pWriter->mSize = 0;
+}
+
+static void writeTrace(TraceWriter* pWriter, const char* pFormat, ...)
+{
+	if (pWriter->mSize > sizeof(pWriter->mBuffer) - 512)
+		flushTrace(pWriter);
+
+	va_list args;
+	va_start(args, pFormat);
+	const int written = vsnprintf(pWriter->mBuffer + pWriter->mSize, sizeof(pWriter->mBuffer) - pWriter->mSize, pFormat, args);
+	va_end(args);
+
+	if (written > 0)
+	{
+		const uint32_t capacity = (uint32_t)sizeof(pWriter->mBuffer) - 1;
+		pWriter->mSize += (uint32_t)written;
+		if (pWriter->mSize > capacity)
+			pWriter->mSize = capacity;
+	}
+}
+
+// Writes pString with the characters JSON requires escaped
+static void writeTraceString(TraceWriter* pWriter, const char* pString)
+{
+	for (const char* c = pString ? pString : "(null)"; *c; ++c)
+	{
+		if (pWriter->mSize > sizeof(pWriter->mBuffer) - 8)
+			flushTrace(pWriter);
+
+		if (*c == '"' || *c == '\\')
+			pWriter->mBuffer[pWriter->mSize++] = '\\';
+		if ((unsigned char)*c >= 0x20)
+			pWriter->mBuffer[pWriter->mSize++] = *c;
+	}
+}
+
+// Starts a new event object and writes its name
+static void beginTraceEvent(TraceWriter* pWriter, const char* pName)
+{
+	writeTrace(pWriter, pWriter->mFirstEvent ? "\n{\"name\":\"" : ",\n{\"name\":\"");
+	pWriter->mFirstEvent = false;
+	writeTraceString(pWriter, pName);
+	writeTrace(pWriter, "\"");
+}
+
+bool exportProfileChromeTrace(const char* pFileName, FSRoot root)
+{
+	if (!pProfiler)
+	{
+		LOGERRORF("exportProfileChromeTrace called before initProfiler");
+		return false;
+	}
+
+	File file;
+	if (!file.Open(pFileName, FM_Write, root))
+	{
+		LOGERRORF("Failed to open %s for writing the profile", pFileName);
+		return false;
+	}
+
+	TraceWriter* pWriter = (TraceWriter*)conf_calloc(1, sizeof(TraceWriter));
+	pWriter->pFile = &file;
+	pWriter->mFirstEvent = true;
+
+	// Chrome trace timestamps are in microseconds
+	const double toUs = 1e6 / (double)pProfiler->mTickFrequency;
+	const int64_t startTicks = pProfiler->mStartTicks;
+
+	MutexLock lock(pProfiler->mMutex);
+
+	writeTrace(pWriter, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	beginTraceEvent(pWriter, "process_name");
+	writeTrace(pWriter, ",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}}");
+	beginTraceEvent(pWriter, "process_name");
+	writeTrace(pWriter, ",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}");
+
+	for (uint32_t i = 0; i < (uint32_t)pProfiler->mThreads.size(); ++i)
+	{
+		beginTraceEvent(pWriter, "thread_name");
+		writeTrace(pWriter, ",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"", i);
+		writeTraceString(pWriter, pProfiler->mThreads[i]->mName);
+		writeTrace(pWriter, "\"}}");
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)pProfiler->mGpuTracks.size(); ++i)
+	{
+		beginTraceEvent(pWriter, "thread_name");
+		writeTrace(pWriter, ",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", i);
+		writeTraceString(pWriter, pProfiler->mGpuTracks[i].c_str());
+		writeTrace(pWriter, "\"}}");
+	}
+
+	// Gpu zones are converted from the gpu clock, so rounding can move a child slightly out of its parent.
+	// They are clamped into the last zone one level up on their track so trace viewers nest them like the gpu did
+	const uint32_t gpuTrackCount = (uint32_t)pProfiler->mGpuTracks.size();
+	tinystl::vector<int64_t> gpuZoneStack(gpuTrackCount * PROFILER_MAX_ZONE_DEPTH * 2, 0);
+
+	uint64_t eventCount = 0;
+	for (uint32_t t = 0; t < (uint32_t)pProfiler->mThreads.size(); ++t)
+	{
+		const ProfileThread* pThread = pProfiler->mThreads[t];
+		const uint64_t writeCount = tfrg_atomic64_load_relaxed((tfrg_atomic64_t*)&pThread->mWriteCount);
+		const uint64_t capacity = pThread->mEventMask + 1;
+		const uint64_t first = writeCount > capacity ? writeCount - capacity : 0;
+
+		for (uint64_t e = first; e < writeCount; ++e)
+		{
+			const ProfileEvent* pEvent = &pThread->pEvents[e & pThread->mEventMask];
+			const double ts = (double)(pEvent->mBegin - startTicks) * toUs;
+
+			switch (pEvent->mType)
+			{
+			case PROFILE_EVENT_ZONE:
+				// Skip zones that are still open
+				if (pEvent->mEnd < pEvent->mBegin)
+					continue;
+				beginTraceEvent(pWriter, pEvent->pName);
+				writeTrace(pWriter, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%u}}",
+					t, ts, (double)(pEvent->mEnd - pEvent->mBegin) * toUs, (uint32_t)pEvent->mDepth);
+				break;
+			case PROFILE_EVENT_GPU_ZONE:
+			{
+				int64_t zoneBegin = pEvent->mBegin;
+				int64_t zoneEnd = max(pEvent->mEnd, pEvent->mBegin);
+				if (pEvent->mTrack < gpuTrackCount)
+				{
+					int64_t* pStack = &gpuZoneStack[pEvent->mTrack * PROFILER_MAX_ZONE_DEPTH * 2];
+					const uint32_t depth = min((uint32_t)pEvent->mDepth, (uint32_t)PROFILER_MAX_ZONE_DEPTH - 1);
+					// Only clamp into a parent that overlaps, the parent may have been skipped for invalid timestamps
+					if (depth > 0 && zoneBegin < pStack[depth * 2 - 1] && zoneEnd > pStack[depth * 2 - 2])
+					{
+						zoneBegin = max(zoneBegin, pStack[depth * 2 - 2]);
+						zoneEnd = min(zoneEnd, pStack[depth * 2 - 1]);
+					}
+					pStack[depth * 2] = zoneBegin;
+					pStack[depth * 2 + 1] = zoneEnd;
+				}
+				beginTraceEvent(pWriter, pEvent->pName);
+				writeTrace(pWriter, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%u}}",
+					pEvent->mTrack, (double)(zoneBegin - startTicks) * toUs, (double)(zoneEnd - zoneBegin) * toUs, (uint32_t)pEvent->mDepth);
+				break;
+			}
+			case PROFILE_EVENT_FRAME:
+				beginTraceEvent(pWriter, pEvent->pName);
+				writeTrace(pWriter, ",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"args\":{\"frame\":%lld}}",
+					t, ts, (long long)pEvent->mEnd);
+				break;
+			case PROFILE_EVENT_COUNTER:
+				beginTraceEvent(pWriter, pEvent->pName);
+				writeTrace(pWriter, ",\"ph\":\"C\",\"pid\":0,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+					ts, (long long)pEvent->mEnd);
+				break;
+			default:
+				continue;
+			}
+
+			++eventCount;
+		}
+	}
+
+	writeTrace(pWriter, "\n]}\n");
+	flushTrace(pWriter);
+	file.Close();
+	conf_free(pWriter);
+
+	LOGINFOF("Exported %llu profile events to %s", (unsigned long long)eventCount, pFileName);
+	return true;
+}
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <string.h>
+
+#include "RadixSort.h"
+#include "../Interfaces/IThread.h"
+#include "../Interfaces/IProfiler.h"
+#include "../Interfaces/ILogManager.h"
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../Interfaces/IMemoryManager.h"
+
+#define RADIX_SORT_PASSES 3
+#define RADIX_SORT_BUCKETS 2048
+#define RADIX_SORT_MAX_JOBS 16
+// Smaller ranges are not worth a job
+#define RADIX_SORT_MIN_JOB_KEYS 16384
+
+static const uint32_t gRadixShift[RADIX_SORT_PASSES] = { 0, 11, 22 };
+static const uint32_t gRadixMask[RADIX_SORT_PASSES] = { 0x7FF, 0x7FF, 0x3FF };
+
+typedef struct RadixSortJob
+{
+	RadixSorter* pSorter;
+	uint32_t     mBegin;
+	uint32_t     mEnd;
+	uint32_t     mHistograms[RADIX_SORT_PASSES][RADIX_SORT_BUCKETS];
+	// Where the next key of every bucket goes in the current pass
+	uint32_t     mOffsets[RADIX_SORT_BUCKETS];
+} RadixSortJob;
+
+struct RadixSorter
+{
+	ThreadPool*               pThreadPool;
+	// Keys and indices are ping-ponged between the two buffers
+	tinystl::vector<uint32_t> mKeys[2];
+	tinystl::vector<uint32_t> mIndices;
+	const float*              pInputKeys;
+	uint32_t*                 pIndexBuffers[2];
+	bool                      mDescending;
+	uint32_t                  mPass;
+	uint32_t                  mSource;
+	bool                      mFirstPass;
+	bool                      mLastPass;
+	uint32_t                  mJobCount;
+	RadixSortJob*             pJobs;
+	WorkItem                  mWorkItems[RADIX_SORT_MAX_JOBS];
+};
+
+static void runRadixSortJobs(RadixSorter* pSorter, void (*pFunc)(void*))
+{
+	for (uint32_t i = 0; i < pSorter->mJobCount; ++i)
+	{
+		pSorter->mWorkItems[i].pFunc = pFunc;
+		pSorter->mWorkItems[i].pData = &pSorter->pJobs[i];
+	}
+
+	if (pSorter->pThreadPool && pSorter->mJobCount > 1)
+	{
+		for (uint32_t i = 0; i < pSorter->mJobCount; ++i)
+			pSorter->pThreadPool->AddWorkItem(&pSorter->mWorkItems[i]);
+		pSorter->pThreadPool->Complete(0);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < pSorter->mJobCount; ++i)
+			pFunc(&pSorter->pJobs[i]);
+	}
+}
+
+// Flips the sign bit of positive floats and all bits of negative ones, so the unsigned order matches the float order.
+// Adding zero turns -0 into +0, they compare equal and have to keep their order
+static inline uint32_t getRadixKey(float value, bool descending)
+{
+	value += 0.0f;
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t key = bits ^ ((uint32_t)((int32_t)bits >> 31) | 0x80000000U);
+	return descending ? ~key : key;
+}
+
+static void radixKeysJob(void* pData)
+{
+	PROFILE_SCOPE("Radix Sort Keys");
+
+	RadixSortJob* pJob = (RadixSortJob*)pData;
+	RadixSorter* pSorter = pJob->pSorter;
+	const float* pInput = pSorter->pInputKeys;
+	uint32_t* pKeys = pSorter->mKeys[0].data();
+	const bool descending = pSorter->mDescending;
+
+	memset(pJob->mHistograms, 0, sizeof(pJob->mHistograms));
+	for (uint32_t i = pJob->mBegin; i < pJob->mEnd; ++i)
+	{
+		const uint32_t key = getRadixKey(pInput[i], descending);
+		pKeys[i] = key;
+		++pJob->mHistograms[0][key & 0x7FF];
+		++pJob->mHistograms[1][(key >> 11) & 0x7FF];
+		++pJob->mHistograms[2][key >> 22];
+	}
+}
+
+// After a pass the keys of a job's range are different ones, so every pass but the first counts them again
+static void radixCountJob(void* pData)
+{
+	PROFILE_SCOPE("Radix Sort Count");
+
+	RadixSortJob* pJob = (RadixSortJob*)pData;
+	RadixSorter* pSorter = pJob->pSorter;
+	const uint32_t shift = gRadixShift[pSorter->mPass];
+	const uint32_t mask = gRadixMask[pSorter->mPass];
+	const uint32_t* pKeys = pSorter->mKeys[pSorter->mSource].data();
+	uint32_t* pHistogram = pJob->mHistograms[pSorter->mPass];
+
+	memset(pHistogram, 0, sizeof(pJob->mHistograms[0]));
+	for (uint32_t i = pJob->mBegin; i < pJob->mEnd; ++i)
+		++pHistogram[(pKeys[i] >> shift) & mask];
+}
+
+static void radixScatterJob(void* pData)
+{
+	PROFILE_SCOPE("Radix Sort Scatter");
+
+	RadixSortJob* pJob = (RadixSortJob*)pData;
+	RadixSorter* pSorter = pJob->pSorter;
+	const uint32_t shift = gRadixShift[pSorter->mPass];
+	const uint32_t mask = gRadixMask[pSorter->mPass];
+	const uint32_t* pSrcKeys = pSorter->mKeys[pSorter->mSource].data();
+	uint32_t* pDstKeys = pSorter->mKeys[pSorter->mSource ^ 1].data();
+	const uint32_t* pSrcIndices = pSorter->pIndexBuffers[pSorter->mSource];
+	uint32_t* pDstIndices = pSorter->pIndexBuffers[pSorter->mSource ^ 1];
+	uint32_t* pOffsets = pJob->mOffsets;
+
+	// The first pass reads the keys in input order, the last one does not need to move the keys
+	if (pSorter->mFirstPass)
+	{
+		for (uint32_t i = pJob->mBegin; i < pJob->mEnd; ++i)
+		{
+			const uint32_t key = pSrcKeys[i];
+			const uint32_t dst = pOffsets[(key >> shift) & mask]++;
+			pDstKeys[dst] = key;
+			pDstIndices[dst] = i;
+		}
+	}
+	else if (pSorter->mLastPass)
+	{
+		for (uint32_t i = pJob->mBegin; i < pJob->mEnd; ++i)
+			pDstIndices[pOffsets[(pSrcKeys[i] >> shift) & mask]++] = pSrcIndices[i];
+	}
+	else
+	{
+		for (uint32_t i = pJob->mBegin; i < pJob->mEnd; ++i)
+		{
+			const uint32_t key = pSrcKeys[i];
+			const uint32_t dst = pOffsets[(key >> shift) & mask]++;
+			pDstKeys[dst] = key;
+			pDstIndices[dst] = pSrcIndices[i];
+		}
+	}
+}
+
+void addRadixSorter(ThreadPool* pThreadPool, RadixSorter** ppSorter)
+{
+	ASSERT(ppSorter);
+
+	RadixSorter* pSorter = conf_placement_new<RadixSorter>(conf_calloc(1, sizeof(RadixSorter)));
+	pSorter->pThreadPool = pThreadPool;
+	pSorter->pJobs = (RadixSortJob*)conf_calloc(RADIX_SORT_MAX_JOBS, sizeof(RadixSortJob));
+	*ppSorter = pSorter;
+}
+
+void removeRadixSorter(RadixSorter* pSorter)
+{
+	ASSERT(pSorter);
+
+	conf_free(pSorter->pJobs);
+	pSorter->~RadixSorter();
+	conf_free(pSorter);
+}
+
+void radixSortFloatKeys(RadixSorter* pSorter, const float* pKeys, uint32_t count, bool descending, uint32_t* pSortedIndices)
+{
+	ASSERT(pSorter);
+	ASSERT(pKeys || !count);
+	ASSERT(pSortedIndices || !count);
+
+	PROFILE_SCOPE("Radix Sort");
+
+	if (count < 2)
+	{
+		if (count)
+			pSortedIndices[0] = 0;
+		return;
+	}
+
+	if (pSorter->mKeys[0].size() < count)
+	{
+		pSorter->mKeys[0].resize(count);
+		pSorter->mKeys[1].resize(count);
+		pSorter->mIndices.resize(count);
+	}
+
+	uint32_t jobCount = count / RADIX_SORT_MIN_JOB_KEYS;
+	if (pSorter->pThreadPool)
+		jobCount = min(jobCount, pSorter->pThreadPool->GetNumThreads() + 1);
+	else
+		jobCount = 1;
+	jobCount = max(1U, min(jobCount, (uint32_t)RADIX_SORT_MAX_JOBS));
+
+	pSorter->pInputKeys = pKeys;
+	pSorter->mDescending = descending;
+	pSorter->mJobCount = jobCount;
+	for (uint32_t j = 0; j < jobCount; ++j)
+	{
+		RadixSortJob* pJob = &pSorter->pJobs[j];
+		pJob->pSorter = pSorter;
+		pJob->mBegin = (uint32_t)((uint64_t)count * j / jobCount);
+		pJob->mEnd = (uint32_t)((uint64_t)count * (j + 1) / jobCount);
+	}
+
+	// The histograms of all passes are built in a single read of the input. Their totals tell which passes can be skipped
+	runRadixSortJobs(pSorter, radixKeysJob);
+
+	// A pass where every key falls into the same bucket would not move anything
+	bool activePasses[RADIX_SORT_PASSES];
+	uint32_t lastActivePass = RADIX_SORT_PASSES;
+	for (uint32_t pass = 0; pass < RADIX_SORT_PASSES; ++pass)
+	{
+		activePasses[pass] = true;
+		for (uint32_t bucket = 0; bucket <= gRadixMask[pass]; ++bucket)
+		{
+			uint32_t bucketCount = 0;
+			for (uint32_t j = 0; j < jobCount; ++j)
+				bucketCount += pSorter->pJobs[j].mHistograms[pass][bucket];
+			if (bucketCount)
+			{
+				activePasses[pass] = bucketCount != count;
+				break;
+			}
+		}
+		if (activePasses[pass])
+			lastActivePass = pass;
+	}
+
+	if (lastActivePass == RADIX_SORT_PASSES)
+	{
+		// All keys are equal
+		for (uint32_t i = 0; i < count; ++i)
+			pSortedIndices[i] = i;
+		return;
+	}
+
+	// The index buffers are arranged so the last active pass writes to pSortedIndices
+	uint32_t activePassCount = 0;
+	for (uint32_t pass = 0; pass < RADIX_SORT_PASSES; ++pass)
+		activePassCount += activePasses[pass];
+	const uint32_t outputBuffer = activePassCount & 1;
+	pSorter->pIndexBuffers[outputBuffer] = pSortedIndices;
+	pSorter->pIndexBuffers[outputBuffer ^ 1] = pSorter->mIndices.data();
+
+	pSorter->mSource = 0;
+	pSorter->mFirstPass = true;
+	for (uint32_t pass = 0; pass < RADIX_SORT_PASSES; ++pass)
+	{
+		if (!activePasses[pass])
+			continue;
+
+		pSorter->mPass = pass;
+		if (!pSorter->mFirstPass && jobCount > 1)
+			runRadixSortJobs(pSorter, radixCountJob);
+
+		// Keys of bucket b start after all smaller buckets, and within the bucket after the keys of the previous jobs
+		uint32_t offset = 0;
+		for (uint32_t bucket = 0; bucket <= gRadixMask[pass]; ++bucket)
+		{
+			for (uint32_t j = 0; j < jobCount; ++j)
+			{
+				pSorter->pJobs[j].mOffsets[bucket] = offset;
+				offset += pSorter->pJobs[j].mHistograms[pass][bucket];
+			}
+		}
+
+		pSorter->mLastPass = pass == lastActivePass;
+		runRadixSortJobs(pSorter, radixScatterJob);
+		pSorter->mSource ^= 1;
+		pSorter->mFirstPass = false;
+	}
+}
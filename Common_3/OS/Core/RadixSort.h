@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+class ThreadPool;
+
+/// Sorts indices of float keys with a least significant digit radix sort, instead of sorting the elements themselves.
+/// Keys are mapped to unsigned integers with the same order and sorted in three passes of 11 / 11 / 10 bits. Passes where
+/// all keys share the digit are skipped. Elements with equal keys keep their order.
+/// Each pass is split in jobs over consecutive ranges of keys: every job counts its digits, the counts are turned into
+/// per job offsets, then every job scatters its range. The sorter keeps its buffers between calls, so sorting the same
+/// amount of keys every frame does not allocate.
+
+typedef struct RadixSorter RadixSorter;
+
+/// Jobs run on pThreadPool. Everything runs on the calling thread if it is NULL
+void addRadixSorter(ThreadPool* pThreadPool, RadixSorter** ppSorter);
+void removeRadixSorter(RadixSorter* pSorter);
+
+/// Writes to pSortedIndices the indices of the count keys in ascending order, or in descending order if descending is set
+void radixSortFloatKeys(RadixSorter* pSorter, const float* pKeys, uint32_t count, bool descending, uint32_t* pSortedIndices);
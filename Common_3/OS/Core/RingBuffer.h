@@ -27,54 +27,250 @@
 #include "../../Renderer/IRenderer.h"
 #include "../../Renderer/ResourceLoader.h"
 #include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IThread.h"
+#include "Atomics.h"
 #include "../Interfaces/IMemoryManager.h"
 /************************************************************************/
 /* RING BUFFER MANAGEMENT											  */
 /************************************************************************/
-typedef struct MeshRingBuffer
+// The ring buffers are linear allocators with one partition per frame in flight.
+// Call begin*RingBufferFrame once per frame after the fence of that frame was waited on.
+// This recycles the partition of the frame. Allocations are lock free so several
+// threads can record with the same ring buffer. When a frame runs out of space an
+// overflow buffer is created and kept alive until the same frame index comes around again.
+// The stats report the high water mark so the ring buffer can be sized accordingly.
+//
+// Ring buffers which never begin a frame keep the old behaviour and wrap around when full.
+// This is only safe if the GPU is done with the data by the time it is overwritten.
+
+typedef struct RingBufferOffset
 {
-	Renderer*   pRenderer;
-	Buffer*	 pVertexBuffer;
-	Buffer*	 pIndexBuffer;
+	Buffer*	 pBuffer;
+	uint64_t	mOffset;
+} RingBufferOffset;
 
-	uint64_t	mMaxVertexBufferSize;
-	uint64_t	mMaxIndexBufferSize;
-	uint64_t	mCurrentVertexBufferOffset;
-	uint64_t	mCurrentIndexBufferOffset;
+typedef struct RingBufferStats
+{
+	/// Size of one frame partition in bytes
+	uint64_t	mFrameSize;
+	/// Most bytes allocated in a single frame, including overflow buffers
+	uint64_t	mHighWaterMark;
+	/// Number of overflow buffers created because a frame did not fit in its partition
+	uint32_t	mOverflowCount;
+	/// Number of times a ring buffer without frames wrapped around
+	uint32_t	mWrapCount;
+} RingBufferStats;
+
+typedef struct RingBufferOverflow
+{
+	Buffer*	 pBuffer;
+	uint32_t	mFrameIndex;
+} RingBufferOverflow;
+
+typedef struct RingBufferAllocator
+{
+	Buffer*							 pBuffer;
+	BufferDesc						  mOverflowDesc;
+	uint32_t							mFrameSize;
+	uint32_t							mFrameCount;
+	uint32_t							mFrameIndex;
+	bool								mFramed;
+	/// Offset inside the partition of the current frame
+	tfrg_atomic32_t					 mOffset;
+	tfrg_atomic32_t					 mWrapCount;
+
+	Mutex							   mOverflowMutex;
+	tinystl::vector<RingBufferOverflow> mOverflowBuffers;
+	Buffer*							 pOverflowBuffer;
+	uint64_t							mOverflowSize;
+	uint64_t							mOverflowOffset;
+	uint64_t							mOverflowUsage;
+	uint64_t							mHighWaterMark;
+	uint32_t							mOverflowCount;
+} RingBufferAllocator;
+
+typedef struct MeshRingBuffer
+{
+	Renderer*		   pRenderer;
+	/// Use the buffer returned by getVertexBufferOffset / getIndexBufferOffset since it can be an overflow buffer
+	Buffer*			 pVertexBuffer;
+	Buffer*			 pIndexBuffer;
+	RingBufferAllocator mVertexAllocator;
+	RingBufferAllocator mIndexAllocator;
 } MeshRingBuffer;
 
 typedef struct UniformRingBuffer
 {
-	Renderer*   pRenderer;
-	Buffer*	 pUniformBuffer;
-	uint32_t	mUniformBufferAlignment;
-	uint32_t	mMaxUniformBufferSize;
-	uint32_t	mUniformOffset;
+	Renderer*		   pRenderer;
+	/// Use the buffer returned by getUniformBufferOffset since it can be an overflow buffer
+	Buffer*			 pUniformBuffer;
+	uint32_t			mUniformBufferAlignment;
+	RingBufferAllocator mAllocator;
 } UniformRingBuffer;
+/************************************************************************/
+// Partitioned linear allocator shared by the ring buffers
+/************************************************************************/
+static inline void addRingBufferAllocator(const BufferDesc* pDesc, uint32_t frameCount, RingBufferAllocator* pAllocator)
+{
+	ASSERT(pDesc->mSize * frameCount < UINT32_MAX);
 
-typedef struct RingBufferOffset
+	// 256 covers the uniform buffer offset alignment of all supported GPUs
+	pAllocator->mFrameSize = round_up((uint32_t)pDesc->mSize, 256U);
+	pAllocator->mFrameCount = max(1U, frameCount);
+	pAllocator->mOverflowDesc = *pDesc;
+
+	BufferLoadDesc loadDesc = {};
+	loadDesc.mDesc = *pDesc;
+	loadDesc.mDesc.mSize = (uint64_t)pAllocator->mFrameSize * pAllocator->mFrameCount;
+	loadDesc.ppBuffer = &pAllocator->pBuffer;
+	addResource(&loadDesc);
+}
+
+static inline void removeRingBufferAllocator(RingBufferAllocator* pAllocator)
 {
-	Buffer*	 pBuffer;
-	uint64_t	mOffset;
-} RingBufferOffset;
+	for (uint32_t i = 0; i < (uint32_t)pAllocator->mOverflowBuffers.size(); ++i)
+		removeResource(pAllocator->mOverflowBuffers[i].pBuffer);
+	pAllocator->mOverflowBuffers.clear();
+
+	if (pAllocator->pBuffer)
+		removeResource(pAllocator->pBuffer);
+}
+
+static inline void beginRingBufferAllocatorFrame(RingBufferAllocator* pAllocator, uint32_t frameIndex)
+{
+	if (pAllocator->mFramed)
+	{
+		const uint64_t usage = tfrg_atomic32_load_relaxed(&pAllocator->mOffset) + pAllocator->mOverflowUsage;
+		pAllocator->mHighWaterMark = max(pAllocator->mHighWaterMark, usage);
+	}
+
+	pAllocator->mFramed = true;
+	pAllocator->mFrameIndex = frameIndex % pAllocator->mFrameCount;
+	tfrg_atomic32_store_relaxed(&pAllocator->mOffset, 0);
+
+	MutexLock lock(pAllocator->mOverflowMutex);
+	pAllocator->pOverflowBuffer = NULL;
+	pAllocator->mOverflowSize = 0;
+	pAllocator->mOverflowOffset = 0;
+	pAllocator->mOverflowUsage = 0;
+
+	// The GPU is done with the frame which last used this index so its overflow buffers can go
+	for (uint32_t i = 0; i < (uint32_t)pAllocator->mOverflowBuffers.size();)
+	{
+		if (pAllocator->mOverflowBuffers[i].mFrameIndex == pAllocator->mFrameIndex)
+		{
+			removeResource(pAllocator->mOverflowBuffers[i].pBuffer);
+			pAllocator->mOverflowBuffers.erase_unordered(pAllocator->mOverflowBuffers.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+static inline RingBufferOffset allocateRingBufferOverflow(RingBufferAllocator* pAllocator, uint32_t size, uint32_t alignment)
+{
+	MutexLock lock(pAllocator->mOverflowMutex);
+
+	uint64_t offset = round_up_64(pAllocator->mOverflowOffset, alignment);
+	if (!pAllocator->pOverflowBuffer || offset + size > pAllocator->mOverflowSize)
+	{
+		pAllocator->mOverflowSize = max((uint64_t)pAllocator->mFrameSize, (uint64_t)size);
+
+		BufferLoadDesc loadDesc = {};
+		loadDesc.mDesc = pAllocator->mOverflowDesc;
+		loadDesc.mDesc.mSize = pAllocator->mOverflowSize;
+		loadDesc.ppBuffer = &pAllocator->pOverflowBuffer;
+		addResource(&loadDesc);
+
+		RingBufferOverflow overflow = { pAllocator->pOverflowBuffer, pAllocator->mFrameIndex };
+		pAllocator->mOverflowBuffers.push_back(overflow);
+		++pAllocator->mOverflowCount;
+		offset = 0;
+
+		LOGWARNINGF("Ring buffer frame size (%u bytes) exceeded. Created overflow buffer of %llu bytes", pAllocator->mFrameSize, (unsigned long long)pAllocator->mOverflowSize);
+	}
+
+	pAllocator->mOverflowOffset = offset + size;
+	pAllocator->mOverflowUsage += size;
+
+	RingBufferOffset ret = { pAllocator->pOverflowBuffer, offset };
+	return ret;
+}
 
-static inline void addMeshRingBuffer(Renderer* pRenderer, const BufferDesc* pVertexBufferDesc, const BufferDesc* pIndexBufferDesc, MeshRingBuffer** ppRingBuffer)
+static inline RingBufferOffset allocateRingBuffer(RingBufferAllocator* pAllocator, uint32_t size, uint32_t alignment)
 {
-	MeshRingBuffer* pRingBuffer = (MeshRingBuffer*)conf_calloc(1, sizeof(MeshRingBuffer));
+	const uint32_t frameSize = pAllocator->mFrameSize;
+
+	if (!pAllocator->mFramed)
+	{
+		if (size > frameSize)
+			return { NULL, 0 };
+
+		uint32_t current = tfrg_atomic32_load_relaxed(&pAllocator->mOffset);
+		for (;;)
+		{
+			uint32_t offset = round_up(current, alignment);
+			const bool wrap = offset + size > frameSize;
+			if (wrap)
+				offset = 0;
+
+			const uint32_t prev = tfrg_atomic32_cas_relaxed(&pAllocator->mOffset, current, offset + size);
+			if (prev == current)
+			{
+				if (wrap)
+					tfrg_atomic32_add_relaxed(&pAllocator->mWrapCount, 1);
+				RingBufferOffset ret = { pAllocator->pBuffer, (uint64_t)offset };
+				return ret;
+			}
+			current = prev;
+		}
+	}
+
+	const uint64_t frameBase = (uint64_t)pAllocator->mFrameIndex * frameSize;
+	uint32_t current = tfrg_atomic32_load_relaxed(&pAllocator->mOffset);
+	for (;;)
+	{
+		const uint32_t offset = round_up(current, alignment);
+		if (size > frameSize || offset > frameSize - size)
+			return allocateRingBufferOverflow(pAllocator, size, alignment);
+
+		const uint32_t prev = tfrg_atomic32_cas_relaxed(&pAllocator->mOffset, current, offset + size);
+		if (prev == current)
+		{
+			RingBufferOffset ret = { pAllocator->pBuffer, frameBase + offset };
+			return ret;
+		}
+		current = prev;
+	}
+}
+
+static inline void getRingBufferAllocatorStats(RingBufferAllocator* pAllocator, RingBufferStats* pStats)
+{
+	pStats->mFrameSize = pAllocator->mFrameSize;
+	pStats->mHighWaterMark = pAllocator->mHighWaterMark;
+	if (pAllocator->mFramed)
+		pStats->mHighWaterMark = max(pStats->mHighWaterMark, (uint64_t)tfrg_atomic32_load_relaxed(&pAllocator->mOffset) + pAllocator->mOverflowUsage);
+	pStats->mOverflowCount = pAllocator->mOverflowCount;
+	pStats->mWrapCount = tfrg_atomic32_load_relaxed(&pAllocator->mWrapCount);
+}
+/************************************************************************/
+// Mesh ring buffer
+/************************************************************************/
+/// frameCount: Number of frames in flight. Each frame gets its own partition of the size in the buffer descs
+static inline void addMeshRingBuffer(Renderer* pRenderer, const BufferDesc* pVertexBufferDesc, const BufferDesc* pIndexBufferDesc, MeshRingBuffer** ppRingBuffer, uint32_t frameCount = 1)
+{
+	MeshRingBuffer* pRingBuffer = conf_placement_new<MeshRingBuffer>(conf_calloc(1, sizeof(MeshRingBuffer)));
 	pRingBuffer->pRenderer = pRenderer;
-	pRingBuffer->mMaxVertexBufferSize = pVertexBufferDesc->mSize;
 
-	BufferLoadDesc loadDesc = {};
-	loadDesc.mDesc = *pVertexBufferDesc;
-	loadDesc.ppBuffer = &pRingBuffer->pVertexBuffer;
-	addResource(&loadDesc);
+	addRingBufferAllocator(pVertexBufferDesc, frameCount, &pRingBuffer->mVertexAllocator);
+	pRingBuffer->pVertexBuffer = pRingBuffer->mVertexAllocator.pBuffer;
 
 	if (pIndexBufferDesc)
 	{
-		pRingBuffer->mMaxIndexBufferSize = pIndexBufferDesc->mSize;
-		loadDesc.mDesc = *pIndexBufferDesc;
-		loadDesc.ppBuffer = &pRingBuffer->pIndexBuffer;
-		addResource(&loadDesc);
+		addRingBufferAllocator(pIndexBufferDesc, frameCount, &pRingBuffer->mIndexAllocator);
+		pRingBuffer->pIndexBuffer = pRingBuffer->mIndexAllocator.pBuffer;
 	}
 
 	*ppRingBuffer = pRingBuffer;
@@ -82,60 +278,57 @@ static inline void addMeshRingBuffer(Renderer* pRenderer, const BufferDesc* pVer
 
 static inline void removeMeshRingBuffer(MeshRingBuffer* pRingBuffer)
 {
-	removeResource(pRingBuffer->pVertexBuffer);
-	if (pRingBuffer->pIndexBuffer)
-		removeResource(pRingBuffer->pIndexBuffer);
+	removeRingBufferAllocator(&pRingBuffer->mVertexAllocator);
+	removeRingBufferAllocator(&pRingBuffer->mIndexAllocator);
 
+	pRingBuffer->~MeshRingBuffer();
 	conf_free(pRingBuffer);
 }
 
+static inline void beginMeshRingBufferFrame(MeshRingBuffer* pRingBuffer, uint32_t frameIndex)
+{
+	beginRingBufferAllocatorFrame(&pRingBuffer->mVertexAllocator, frameIndex);
+	if (pRingBuffer->pIndexBuffer)
+		beginRingBufferAllocatorFrame(&pRingBuffer->mIndexAllocator, frameIndex);
+}
+
+/// Recycles the partition of the current frame
 static inline void resetMeshRingBuffer(MeshRingBuffer* pRingBuffer)
 {
-	pRingBuffer->mCurrentVertexBufferOffset = 0;
-	pRingBuffer->mCurrentIndexBufferOffset = 0;
+	beginMeshRingBufferFrame(pRingBuffer, pRingBuffer->mVertexAllocator.mFrameIndex);
 }
 
 static inline RingBufferOffset getVertexBufferOffset(MeshRingBuffer* pRingBuffer, uint32_t memoryRequirement)
 {
 	uint32_t alignedSize = round_up(memoryRequirement, (uint32_t)sizeof(float[4]));
-
-	if (alignedSize > pRingBuffer->mMaxVertexBufferSize)
-		return { NULL, 0 };
-
-	if (pRingBuffer->mCurrentVertexBufferOffset + alignedSize >= pRingBuffer->mMaxVertexBufferSize)
-		pRingBuffer->mCurrentVertexBufferOffset = 0;
-
-	RingBufferOffset ret = { pRingBuffer->pVertexBuffer, pRingBuffer->mCurrentVertexBufferOffset };
-	pRingBuffer->mCurrentVertexBufferOffset += alignedSize;
-
-	return ret;
+	return allocateRingBuffer(&pRingBuffer->mVertexAllocator, alignedSize, (uint32_t)sizeof(float[4]));
 }
 
 static inline RingBufferOffset getIndexBufferOffset(MeshRingBuffer* pRingBuffer, uint32_t memoryRequirement)
 {
+	ASSERT(pRingBuffer->pIndexBuffer);
 	uint32_t alignedSize = round_up(memoryRequirement, (uint32_t)sizeof(float[4]));
-
-	if (alignedSize > pRingBuffer->mMaxIndexBufferSize)
-		return { NULL, 0 };
-
-	if (pRingBuffer->mCurrentIndexBufferOffset + alignedSize >= pRingBuffer->mMaxIndexBufferSize)
-		pRingBuffer->mCurrentIndexBufferOffset = 0;
-
-	RingBufferOffset ret = { pRingBuffer->pIndexBuffer, pRingBuffer->mCurrentIndexBufferOffset };
-	pRingBuffer->mCurrentIndexBufferOffset += alignedSize;
-
-	return ret;
+	return allocateRingBuffer(&pRingBuffer->mIndexAllocator, alignedSize, (uint32_t)sizeof(float[4]));
 }
 
-static inline void addUniformRingBuffer(Renderer* pRenderer, uint32_t requiredUniformBufferSize, UniformRingBuffer** ppRingBuffer)
+static inline void getMeshRingBufferStats(MeshRingBuffer* pRingBuffer, RingBufferStats* pVertexStats, RingBufferStats* pIndexStats)
 {
-	UniformRingBuffer* pRingBuffer = (UniformRingBuffer*)conf_calloc(1, sizeof(UniformRingBuffer));
+	if (pVertexStats)
+		getRingBufferAllocatorStats(&pRingBuffer->mVertexAllocator, pVertexStats);
+	if (pIndexStats)
+		getRingBufferAllocatorStats(&pRingBuffer->mIndexAllocator, pIndexStats);
+}
+/************************************************************************/
+// Uniform ring buffer
+/************************************************************************/
+/// frameCount: Number of frames in flight. Each frame gets its own partition of requiredUniformBufferSize bytes
+static inline void addUniformRingBuffer(Renderer* pRenderer, uint32_t requiredUniformBufferSize, UniformRingBuffer** ppRingBuffer, uint32_t frameCount = 1)
+{
+	UniformRingBuffer* pRingBuffer = conf_placement_new<UniformRingBuffer>(conf_calloc(1, sizeof(UniformRingBuffer)));
 	pRingBuffer->pRenderer = pRenderer;
 
 	const uint32_t uniformBufferAlignment = (uint32_t)pRenderer->pActiveGpuSettings->mUniformBufferAlignment;
-	const uint32_t maxUniformBufferSize = requiredUniformBufferSize;
 	pRingBuffer->mUniformBufferAlignment = uniformBufferAlignment;
-	pRingBuffer->mMaxUniformBufferSize = maxUniformBufferSize;
 
 	BufferDesc ubDesc = {};
 #if defined(DIRECT3D11)
@@ -145,43 +338,43 @@ static inline void addUniformRingBuffer(Renderer* pRenderer, uint32_t requiredUn
 	ubDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
 #endif
 	ubDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | BUFFER_CREATION_FLAG_NO_DESCRIPTOR_VIEW_CREATION;
-	ubDesc.mSize = maxUniformBufferSize;
-	BufferLoadDesc loadDesc = {};
-	loadDesc.mDesc = ubDesc;
-	loadDesc.ppBuffer = &pRingBuffer->pUniformBuffer;
-	addResource(&loadDesc);
+	ubDesc.mSize = requiredUniformBufferSize;
+	addRingBufferAllocator(&ubDesc, frameCount, &pRingBuffer->mAllocator);
+	pRingBuffer->pUniformBuffer = pRingBuffer->mAllocator.pBuffer;
 
 	*ppRingBuffer = pRingBuffer;
 }
 
 static inline void removeUniformRingBuffer(UniformRingBuffer* pRingBuffer)
 {
-	removeResource(pRingBuffer->pUniformBuffer);
+	removeRingBufferAllocator(&pRingBuffer->mAllocator);
+
+	pRingBuffer->~UniformRingBuffer();
 	conf_free(pRingBuffer);
 }
 
+static inline void beginUniformRingBufferFrame(UniformRingBuffer* pRingBuffer, uint32_t frameIndex)
+{
+	beginRingBufferAllocatorFrame(&pRingBuffer->mAllocator, frameIndex);
+}
+
+/// Recycles the partition of the current frame
 static inline void resetUniformRingBuffer(UniformRingBuffer* pRingBuffer)
 {
-	pRingBuffer->mUniformOffset = 0;
+	beginRingBufferAllocatorFrame(&pRingBuffer->mAllocator, pRingBuffer->mAllocator.mFrameIndex);
 }
 
 static inline RingBufferOffset getUniformBufferOffset(UniformRingBuffer* pRingBuffer, uint32_t memoryRequirement, uint32_t alignment = 0)
 {
-	uint32_t alignedSize = round_up(memoryRequirement, (alignment ? alignment : (uint32_t)pRingBuffer->mUniformBufferAlignment));
-
-	if (alignedSize > pRingBuffer->mMaxUniformBufferSize)
-	{
-		ASSERT(false && "Ring Buffer too small for memory requirement");
-		return { NULL, 0 };
-	}
-
-	if (pRingBuffer->mUniformOffset + alignedSize >= pRingBuffer->mMaxUniformBufferSize)
-	{
-		resetUniformRingBuffer(pRingBuffer);
-	}
-
-	RingBufferOffset ret = { pRingBuffer->pUniformBuffer, (uint64_t)pRingBuffer->mUniformOffset };
-	pRingBuffer->mUniformOffset += alignedSize;
+	const uint32_t uniformAlignment = alignment ? alignment : pRingBuffer->mUniformBufferAlignment;
+	uint32_t alignedSize = round_up(memoryRequirement, uniformAlignment);
 
+	RingBufferOffset ret = allocateRingBuffer(&pRingBuffer->mAllocator, alignedSize, uniformAlignment);
+	ASSERT(ret.pBuffer && "Ring Buffer too small for memory requirement");
 	return ret;
 }
+
+static inline void getUniformRingBufferStats(UniformRingBuffer* pRingBuffer, RingBufferStats* pStats)
+{
+	getRingBufferAllocatorStats(&pRingBuffer->mAllocator, pStats);
+}
@@ -25,6 +25,7 @@
 #include <algorithm>
 
 #include "../Interfaces/IThread.h"
+#include "../Interfaces/IProfiler.h"
 #include "../Interfaces/ILogManager.h"
 #include "../Interfaces/IMemoryManager.h"
 
@@ -216,7 +217,9 @@ void ThreadPool::Complete(unsigned priority)
 				WorkItem* item = mWorkQueue.front();
 				mWorkQueue.erase(mWorkQueue.begin());
 				mQueueMutex.Release();
+				profileBeginZone("ThreadPool Job");
 				item->pFunc(item->pData);
+				profileEndZone();
 				item->mCompleted = true;
 			}
 			else
@@ -242,7 +245,9 @@ void ThreadPool::Complete(unsigned priority)
 		{
 			WorkItem* item = mWorkQueue.front();
 			mWorkQueue.erase(mWorkQueue.begin());
+			profileBeginZone("ThreadPool Job");
 			item->pFunc(item->pData);
+			profileEndZone();
 			item->mCompleted = true;
 		}
 	}
@@ -285,7 +290,9 @@ void ThreadPool::ProcessItems(void* pData)
 				WorkItem* item = pSystem->mWorkQueue.front();
 				pSystem->mWorkQueue.erase(pSystem->mWorkQueue.begin());
 				pSystem->mQueueMutex.Release();
+				profileBeginZone("ThreadPool Job");
 				item->pFunc(item->pData);
+				profileEndZone();
 				item->mCompleted = true;
 			}
 			else
@@ -23,6 +23,13 @@
 */
 
 #include "Image.h"
+#include "../Core/CpuFeatures.h"
+#if defined(CPU_X86)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_NEON
+#endif
 #include "../Interfaces/ILogManager.h"
 #include "../Interfaces/IMemoryManager.h"
 #include "../../ThirdParty/OpenSource/TinyEXR/tinyexr.h"
@@ -1933,7 +1940,14 @@ bool Image::loadImage(const char *fileName, bool useMipmaps, memoryAllocationFun
   }
 
   // load file into memory
-  uint32_t length = file.GetSize();
+  if (file.GetSize() > UINT32_MAX)
+  {
+	LOGERRORF("\"%s\": Image file is larger than 4GB.", fileName);
+	file.Close();
+	return false;
+  }
+
+  uint32_t length = (uint32_t)file.GetSize();
   if (length == 0)
   {
 	//char output[256];
@@ -1994,6 +2008,231 @@ bool Image::loadImage(const char *fileName, bool useMipmaps, memoryAllocationFun
   return loaded;
 }
 
+// --- CONVERSION AND MIP KERNELS ---
+// Bound to the best variant for the CPU at startup, see CpuFeatures.h
+
+typedef void (*PixelConversionFunction)(ubyte* dst, const ubyte* src, uint32_t pixelCount);
+
+static void swizzleRGBA8Scalar(ubyte* dst, const ubyte* src, uint32_t pixelCount)
+{
+	for (uint32_t i = 0; i < pixelCount; ++i, dst += 4, src += 4)
+	{
+		dst[0] = src[2];
+		dst[1] = src[1];
+		dst[2] = src[0];
+		dst[3] = src[3];
+	}
+}
+
+static void expandRGB8Scalar(ubyte* dst, const ubyte* src, uint32_t pixelCount)
+{
+	for (uint32_t i = 0; i < pixelCount; ++i, dst += 4, src += 3)
+	{
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+		dst[3] = 255;
+	}
+}
+
+#if defined(CPU_X86)
+static CPU_TARGET_SSSE3 void swizzleRGBA8SSSE3(ubyte* dst, const ubyte* src, uint32_t pixelCount)
+{
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	uint32_t i = 0;
+	for (; i + 4 <= pixelCount; i += 4)
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i * 4)), shuffle));
+	swizzleRGBA8Scalar(dst + i * 4, src + i * 4, pixelCount - i);
+}
+
+static CPU_TARGET_AVX2 void swizzleRGBA8AVX2(ubyte* dst, const ubyte* src, uint32_t pixelCount)
+{
+	const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	uint32_t i = 0;
+	for (; i + 8 <= pixelCount; i += 8)
+		_mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + i * 4)), shuffle));
+	swizzleRGBA8Scalar(dst + i * 4, src + i * 4, pixelCount - i);
+}
+
+static CPU_TARGET_SSSE3 void expandRGB8SSSE3(ubyte* dst, const ubyte* src, uint32_t pixelCount)
+{
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	uint32_t i = 0;
+	// Every load reads 16 bytes for 4 pixels, so stop while the 4 bytes past them are still inside the source
+	for (; i + 6 <= pixelCount; i += 4)
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i * 3)), shuffle), alpha));
+	expandRGB8Scalar(dst + i * 4, src + i * 3, pixelCount - i);
+}
+#endif
+
+#if defined(IMAGE_NEON)
+static void swizzleRGBA8NEON(ubyte* dst, const ubyte* src, uint32_t pixelCount)
+{
+	uint32_t i = 0;
+	for (; i + 16 <= pixelCount; i += 16)
+	{
+		uint8x16x4_t pixels = vld4q_u8(src + i * 4);
+		const uint8x16_t red = pixels.val[0];
+		pixels.val[0] = pixels.val[2];
+		pixels.val[2] = red;
+		vst4q_u8(dst + i * 4, pixels);
+	}
+	swizzleRGBA8Scalar(dst + i * 4, src + i * 4, pixelCount - i);
+}
+
+static void expandRGB8NEON(ubyte* dst, const ubyte* src, uint32_t pixelCount)
+{
+	uint32_t i = 0;
+	for (; i + 16 <= pixelCount; i += 16)
+	{
+		const uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+		uint8x16x4_t rgba;
+		rgba.val[0] = rgb.val[0];
+		rgba.val[1] = rgb.val[1];
+		rgba.val[2] = rgb.val[2];
+		rgba.val[3] = vdupq_n_u8(255);
+		vst4q_u8(dst + i * 4, rgba);
+	}
+	expandRGB8Scalar(dst + i * 4, src + i * 3, pixelCount - i);
+}
+#endif
+
+static const CpuKernelVariant gSwizzleRGBA8Variants[] = {
+#if defined(CPU_X86)
+	{ "AVX2", CPU_FEATURE_AVX2, (CpuKernelFunction)swizzleRGBA8AVX2 },
+	{ "SSSE3", CPU_FEATURE_SSSE3, (CpuKernelFunction)swizzleRGBA8SSSE3 },
+#endif
+#if defined(IMAGE_NEON)
+	{ "NEON", CPU_FEATURE_NEON, (CpuKernelFunction)swizzleRGBA8NEON },
+#endif
+	{ "Scalar", CPU_FEATURE_NONE, (CpuKernelFunction)swizzleRGBA8Scalar },
+};
+static CpuKernel gSwizzleRGBA8Kernel = { "Image RGBA8 to BGRA8", gSwizzleRGBA8Variants, sizeof(gSwizzleRGBA8Variants) / sizeof(gSwizzleRGBA8Variants[0]), NULL, NULL, NULL };
+static CpuKernelRegistration gSwizzleRGBA8Registration(&gSwizzleRGBA8Kernel);
+
+static const CpuKernelVariant gExpandRGB8Variants[] = {
+#if defined(CPU_X86)
+	{ "SSSE3", CPU_FEATURE_SSSE3, (CpuKernelFunction)expandRGB8SSSE3 },
+#endif
+#if defined(IMAGE_NEON)
+	{ "NEON", CPU_FEATURE_NEON, (CpuKernelFunction)expandRGB8NEON },
+#endif
+	{ "Scalar", CPU_FEATURE_NONE, (CpuKernelFunction)expandRGB8Scalar },
+};
+static CpuKernel gExpandRGB8Kernel = { "Image RGB8 to RGBA8", gExpandRGB8Variants, sizeof(gExpandRGB8Variants) / sizeof(gExpandRGB8Variants[0]), NULL, NULL, NULL };
+static CpuKernelRegistration gExpandRGB8Registration(&gExpandRGB8Kernel);
+
+template <typename T>
+void buildMipMap(T *dst, const T *src, const uint w, const uint h, const uint d, const uint c) {
+	uint xOff = (w < 2) ? 0 : c;
+	uint yOff = (h < 2) ? 0 : c * w;
+	uint zOff = (d < 2) ? 0 : c * w * h;
+
+	for (uint z = 0; z < d; z += 2) {
+		for (uint y = 0; y < h; y += 2) {
+			for (uint x = 0; x < w; x += 2) {
+				for (uint i = 0; i < c; i++) {
+					*dst++ = (src[0] + src[xOff] + src[yOff] + src[yOff + xOff] + src[zOff] + src[zOff + xOff] + src[zOff + yOff] + src[zOff + yOff + xOff]) / 8;
+					src++;
+				}
+				src += xOff;
+			}
+			src += yOff;
+		}
+		src += zOff;
+	}
+}
+
+// Box filter of a 2D RGBA8 level with even width and height. Matches buildMipMap, which counts every texel twice for 2D
+// levels and so returns the floor of the average of the 2x2 block
+typedef void (*MipRGBA8Function)(ubyte* dst, const ubyte* src, uint32_t w, uint32_t h);
+
+static void buildMipRGBA8Scalar(ubyte* dst, const ubyte* src, uint32_t w, uint32_t h)
+{
+	buildMipMap(dst, src, w, h, 1, 4);
+}
+
+static inline void buildMipRGBA8Tail(ubyte* dst, const ubyte* src0, const ubyte* src1, uint32_t pixelCount)
+{
+	for (uint32_t x = 0; x < pixelCount; ++x, dst += 4, src0 += 8, src1 += 8)
+	{
+		for (uint32_t i = 0; i < 4; ++i)
+			dst[i] = (ubyte)((src0[i] + src0[i + 4] + src1[i] + src1[i + 4]) >> 2);
+	}
+}
+
+#if defined(CPU_X86)
+static void buildMipRGBA8SSE2(ubyte* dst, const ubyte* src, uint32_t w, uint32_t h)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const uint32_t dstWidth = w / 2;
+	for (uint32_t y = 0; y < h; y += 2, dst += dstWidth * 4)
+	{
+		const ubyte* src0 = src + (size_t)y * w * 4;
+		const ubyte* src1 = src0 + (size_t)w * 4;
+		uint32_t x = 0;
+		// 8 source pixels of both rows to 4 destination pixels
+		for (; x + 4 <= dstWidth; x += 4)
+		{
+			__m128i sums[2];
+			for (uint32_t half = 0; half < 2; ++half)
+			{
+				const __m128i row0 = _mm_loadu_si128((const __m128i*)(src0 + x * 8 + half * 16));
+				const __m128i row1 = _mm_loadu_si128((const __m128i*)(src1 + x * 8 + half * 16));
+				const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+				const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+				// Add the right pixel of every pair to the left one
+				sums[half] = _mm_unpacklo_epi64(_mm_add_epi16(lo, _mm_srli_si128(lo, 8)), _mm_add_epi16(hi, _mm_srli_si128(hi, 8)));
+				sums[half] = _mm_srli_epi16(sums[half], 2);
+			}
+			_mm_storeu_si128((__m128i*)(dst + x * 4), _mm_packus_epi16(sums[0], sums[1]));
+		}
+		buildMipRGBA8Tail(dst + x * 4, src0 + x * 8, src1 + x * 8, dstWidth - x);
+	}
+}
+
+static CPU_TARGET_AVX2 void buildMipRGBA8AVX2(ubyte* dst, const ubyte* src, uint32_t w, uint32_t h)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const uint32_t dstWidth = w / 2;
+	for (uint32_t y = 0; y < h; y += 2, dst += dstWidth * 4)
+	{
+		const ubyte* src0 = src + (size_t)y * w * 4;
+		const ubyte* src1 = src0 + (size_t)w * 4;
+		uint32_t x = 0;
+		// 16 source pixels of both rows to 8 destination pixels
+		for (; x + 8 <= dstWidth; x += 8)
+		{
+			__m256i sums[2];
+			for (uint32_t half = 0; half < 2; ++half)
+			{
+				const __m256i row0 = _mm256_loadu_si256((const __m256i*)(src0 + x * 8 + half * 32));
+				const __m256i row1 = _mm256_loadu_si256((const __m256i*)(src1 + x * 8 + half * 32));
+				const __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(row0, zero), _mm256_unpacklo_epi8(row1, zero));
+				const __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(row0, zero), _mm256_unpackhi_epi8(row1, zero));
+				sums[half] = _mm256_unpacklo_epi64(_mm256_add_epi16(lo, _mm256_srli_si256(lo, 8)), _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8)));
+				sums[half] = _mm256_srli_epi16(sums[half], 2);
+			}
+			// Packing works per 128 bit lane, the permute restores the pixel order
+			const __m256i packed = _mm256_packus_epi16(sums[0], sums[1]);
+			_mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+		}
+		buildMipRGBA8Tail(dst + x * 4, src0 + x * 8, src1 + x * 8, dstWidth - x);
+	}
+}
+#endif
+
+static const CpuKernelVariant gMipRGBA8Variants[] = {
+#if defined(CPU_X86)
+	{ "AVX2", CPU_FEATURE_AVX2, (CpuKernelFunction)buildMipRGBA8AVX2 },
+	{ "SSE2", CPU_FEATURE_SSE2, (CpuKernelFunction)buildMipRGBA8SSE2 },
+#endif
+	{ "Scalar", CPU_FEATURE_NONE, (CpuKernelFunction)buildMipRGBA8Scalar },
+};
+static CpuKernel gMipRGBA8Kernel = { "Image RGBA8 mip generation", gMipRGBA8Variants, sizeof(gMipRGBA8Variants) / sizeof(gMipRGBA8Variants[0]), NULL, NULL, NULL };
+static CpuKernelRegistration gMipRGBA8Registration(&gMipRGBA8Kernel);
+
 bool Image::Convert(const ImageFormat::Enum newFormat) {
   ubyte *newPixels;
   uint nPixels = GetNumberOfPixels(0, mMipMapCount) * mArrayCount;
@@ -2030,24 +2269,10 @@ bool Image::Convert(const ImageFormat::Enum newFormat) {
 
 	if (mFormat == ImageFormat::RGB8 && newFormat == ImageFormat::RGBA8) {
 	  // Fast path for RGB->RGBA8
-	  do {
-		dest[0] = src[0];
-		dest[1] = src[1];
-		dest[2] = src[2];
-		dest[3] = 255;
-		dest += 4;
-		src += 3;
-	  } while (--nPixels);
+	  ((PixelConversionFunction)gExpandRGB8Kernel.pFunction)(dest, src, nPixels);
 	} else if (mFormat == ImageFormat::RGBA8 && newFormat == ImageFormat::BGRA8) {
 		// Fast path for RGBA8->BGRA8 (just swizzle)
-		do {
-			dest[0] = src[2];
-			dest[1] = src[1];
-			dest[2] = src[0];
-			dest[3] = src[3];
-			dest += 4;
-			src += 4;
-		} while (--nPixels);
+		((PixelConversionFunction)gSwizzleRGBA8Kernel.pFunction)(dest, src, nPixels);
 	}
 	else {
 	  int srcSize = ImageFormat::GetBytesPerPixel(mFormat);
@@ -2122,27 +2347,6 @@ bool Image::Convert(const ImageFormat::Enum newFormat) {
   return true;
 }
 
-template <typename T>
-void buildMipMap(T *dst, const T *src, const uint w, const uint h, const uint d, const uint c) {
-	uint xOff = (w < 2) ? 0 : c;
-	uint yOff = (h < 2) ? 0 : c * w;
-	uint zOff = (d < 2) ? 0 : c * w * h;
-
-	for (uint z = 0; z < d; z += 2) {
-		for (uint y = 0; y < h; y += 2) {
-			for (uint x = 0; x < w; x += 2) {
-				for (uint i = 0; i < c; i++) {
-					*dst++ = (src[0] + src[xOff] + src[yOff] + src[yOff + xOff] + src[zOff] + src[zOff + xOff] + src[zOff + yOff] + src[zOff + yOff + xOff]) / 8;
-					src++;
-				}
-				src += xOff;
-			}
-			src += yOff;
-		}
-		src += zOff;
-	}
-}
-
 bool Image::GenerateMipMaps(const uint32_t mipMaps)
 {
 	if (ImageFormat::IsCompressedFormat(mFormat)) return false;
@@ -2196,6 +2400,9 @@ bool Image::GenerateMipMaps(const uint32_t mipMaps)
 					else if (mFormat >= ImageFormat::I16) {
 						buildMipMap((ushort *)dst, (ushort *)src, w, h, d, nChannels);
 					}
+					else if (mFormat == ImageFormat::RGBA8 && d == 1 && w >= 2 && h >= 2 && !(w & 1) && !(h & 1)) {
+						((MipRGBA8Function)gMipRGBA8Kernel.pFunction)(dst, src, w, h);
+					}
 					else {
 						buildMipMap(dst, src, w, h, d, nChannels);
 					}
@@ -2231,6 +2438,11 @@ bool Image::iSwap(const int c0, const int c1) {
 // -- IMAGE SAVING --
 
 bool Image::iSaveDDS(const char *fileName)
+{
+  return iSaveDDS(fileName, FSR_Textures);
+}
+
+bool Image::iSaveDDS(const char *fileName, FSRoot root)
 {
   DDSHeader header;
   DDSHeaderDX10 headerDX10;
@@ -2325,7 +2537,7 @@ bool Image::iSaveDDS(const char *fileName)
   header.mDWReserved2 = 0;
 
   File file;
-  if (!file.Open(fileName, FileMode::FM_WriteBinary, FSR_Textures))
+  if (!file.Open(fileName, FileMode::FM_WriteBinary, root))
 	  return false;
 
   file.Write(&header, sizeof(header));
@@ -131,6 +131,7 @@ public:
 
   // Image Format Saving
   bool iSaveDDS(const char* fileName);
+  bool iSaveDDS(const char* fileName, FSRoot root);
   bool iSaveTGA(const char* fileName);
   bool iSaveBMP(const char* fileName);
   bool iSavePNG(const char* fileName);
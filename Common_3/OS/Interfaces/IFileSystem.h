@@ -47,9 +47,15 @@ FileHandle _openFile(const char* filename, const char* flags);
 void _closeFile(FileHandle handle);
 void _flushFile(FileHandle handle);
 size_t _readFile(void *buffer, size_t byteCount, FileHandle handle);
-bool _seekFile(FileHandle handle, long offset, int origin);
-long _tellFile(FileHandle handle);
+// Reads at offset without using or moving the position of the stream, several threads can read from one handle at once.
+// Returns less than byteCount at the end of the file or on error
+size_t _readFileAt(void *buffer, size_t byteCount, uint64_t offset, FileHandle handle);
+bool _seekFile(FileHandle handle, int64_t offset, int origin);
+int64_t _tellFile(FileHandle handle);
 size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle);
+// Maps the whole file into memory. Pages are copy on write, changes are never written back to the file
+void* _mapFile(const char* filename, size_t* pSize, FileHandle* pMapping);
+void _unmapFile(void* pData, size_t size, FileHandle mapping);
 size_t _getFileLastModifiedTime(const char* _fileName);
 
 tinystl::string _getCurrentDir();
@@ -152,16 +158,16 @@ class  Deserializer
 {
 public:
 	Deserializer();
-	Deserializer(unsigned size);
+	Deserializer(uint64_t size);
 	virtual ~Deserializer();
 
-	virtual unsigned Read(void* dest, unsigned size) = 0;
-	virtual unsigned Seek(unsigned position, SeekDir seekDir = SEEK_DIR_BEGIN) = 0;
+	virtual uint64_t Read(void* dest, uint64_t size) = 0;
+	virtual uint64_t Seek(uint64_t position, SeekDir seekDir = SEEK_DIR_BEGIN) = 0;
 	virtual const tinystl::string& GetName() const = 0;
 	virtual unsigned GetChecksum();
 
-	unsigned GetPosition() const { return mPosition; }
-	unsigned GetSize() const { return mSize; }
+	uint64_t GetPosition() const { return mPosition; }
+	uint64_t GetSize() const { return mSize; }
 	bool IsEof() const { return mPosition >= mSize; }
 	int64_t ReadInt64();
 	int ReadInt();
@@ -182,8 +188,8 @@ public:
 	tinystl::string ReadLine();
 
 protected:
-	unsigned mPosition;
-	unsigned mSize;
+	uint64_t mPosition;
+	uint64_t mSize;
 };
 
 /// Abstract stream for writing
@@ -192,7 +198,7 @@ class  Serializer
 public:
 	virtual ~Serializer();
 
-	virtual unsigned Write(const void* data, unsigned size) = 0;
+	virtual uint64_t Write(const void* data, uint64_t size) = 0;
 
 	bool WriteInt64(int64_t value);
 	bool WriteInt(int value);
@@ -213,7 +219,8 @@ public:
 	bool WriteLine(const tinystl::string& value);
 };
 
-/// Text / binary file loaded from disk
+/// Text / binary file loaded from disk.
+/// A file opened for reading can be shared by several threads as long as they only read it with ReadAt
 class File : public Deserializer, public Serializer
 {
 public:
@@ -223,9 +230,11 @@ public:
 	virtual void Close();
 	virtual void Flush();
 
-	unsigned Read(void* dest, unsigned size) override;
-	unsigned Seek(unsigned position, SeekDir seekDir = SEEK_DIR_BEGIN) override;
-	unsigned Write(const void* data, unsigned size) override;
+	uint64_t Read(void* dest, uint64_t size) override;
+	uint64_t Seek(uint64_t position, SeekDir seekDir = SEEK_DIR_BEGIN) override;
+	uint64_t Write(const void* data, uint64_t size) override;
+	/// Reads at offset without seeking. Does not change the position of Read and can be called from several threads at once
+	uint64_t ReadAt(uint64_t offset, void* dest, uint64_t size);
 
 	tinystl::string ReadText();
 
@@ -241,24 +250,24 @@ protected:
 	tinystl::string mFileName;
 	FileMode mMode;
 	FileHandle pHandle;
-	unsigned mOffset;
+	uint64_t mOffset;
 	unsigned mChecksum;
-	bool mReadSyncNeeded;
-	bool mWriteSyncNeeded;
+	volatile bool mReadSyncNeeded;
+	volatile bool mWriteSyncNeeded;
 };
 
 /// Memory area simulating a stream
 class  MemoryBuffer : public Deserializer, public Serializer
 {
 public:
-	MemoryBuffer(void* data, unsigned size);
-	MemoryBuffer(const void* data, unsigned size);
+	MemoryBuffer(void* data, uint64_t size);
+	MemoryBuffer(const void* data, uint64_t size);
 
 	const tinystl::string& GetName() const override { return mName; }
 
-	unsigned Read(void* dest, unsigned size) override;
-	unsigned Seek(unsigned position, SeekDir seekDir = SEEK_DIR_BEGIN) override;
-	unsigned Write(const void* data, unsigned size) override;
+	uint64_t Read(void* dest, uint64_t size) override;
+	uint64_t Seek(uint64_t position, SeekDir seekDir = SEEK_DIR_BEGIN) override;
+	uint64_t Write(const void* data, uint64_t size) override;
 
 	unsigned char* GetData() { return pBuffer; }
 	bool IsReadOnly() { return mReadOnly; }
@@ -269,11 +278,101 @@ private:
 	bool mReadOnly;
 };
 
+/// Whole file mapped into memory. Nothing is read until the pages are accessed
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const tinystl::string& fileName, FSRoot root);
+	void Close();
+
+	void* GetData() const { return pData; }
+	size_t GetSize() const { return mSize; }
+	const tinystl::string& GetName() const { return mFileName; }
+	bool IsOpen() const { return pData != NULL; }
+
+private:
+	// Disable copy
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	tinystl::string mFileName;
+	void* pData;
+	size_t mSize;
+	FileHandle pMapping;
+};
+
+/// Offset, size and destination of reads from files opened for direct I/O have to be multiples of this
+#define FILE_DIRECT_IO_ALIGNMENT 4096
+
+typedef void* AsyncFileHandle;
+/// Identifies a read of an AsyncFileReader. 0 is never a valid token
+typedef uint64_t AsyncReadToken;
+/// Called by Poll or Wait once a read completed. bytesRead is smaller than the size of the read when it reached the end of the file
+typedef void(*AsyncReadCallback)(void* pUserData, void* pDst, size_t bytesRead, bool success);
+
+struct AsyncFileReaderDesc
+{
+	/// Reads in flight at once. Further submitted reads are started as the previous ones complete
+	uint32_t mQueueDepth = 64;
+	/// Reads that can be queued or in flight before ReadAsync has to wait for one to complete
+	uint32_t mMaxReads = 1024;
+	/// Worker threads used when io_uring is not available
+	uint32_t mNumThreads = 4;
+	/// Uses the worker threads even when io_uring is available
+	bool mForceThreads = false;
+};
+
+/// Reads byte ranges of files in the background. Uses io_uring on Linux when the kernel supports it,
+/// otherwise worker threads doing positional reads.
+/// Reads are issued, polled and waited on by one thread at a time, callbacks run on that thread.
+class AsyncFileReader
+{
+public:
+	AsyncFileReader();
+	~AsyncFileReader();
+
+	bool Initialize(const AsyncFileReaderDesc& desc = AsyncFileReaderDesc());
+	void Destroy();
+
+	/// With directIO the reads bypass the OS file cache. Falls back to buffered reads where the file system does not support it
+	AsyncFileHandle OpenFile(const tinystl::string& fileName, FSRoot root, bool directIO = false);
+	/// The reads of the file have to be complete
+	void CloseFile(AsyncFileHandle file);
+	uint64_t GetFileSize(AsyncFileHandle file) const;
+
+	/// Queues a read of size bytes at offset into pDst. Queued reads are started together by Submit
+	AsyncReadToken ReadAsync(AsyncFileHandle file, uint64_t offset, size_t size, void* pDst, AsyncReadCallback pCallback = NULL, void* pUserData = NULL);
+	/// Same as above for a file that is opened by the call and closed once the read completed. Returns 0 if the file cannot be opened
+	AsyncReadToken ReadAsync(const tinystl::string& fileName, FSRoot root, uint64_t offset, size_t size, void* pDst, AsyncReadCallback pCallback = NULL, void* pUserData = NULL);
+	/// Starts the queued reads with one system call
+	void Submit();
+	/// Runs the callbacks of the completed reads without blocking and returns their number
+	uint32_t Poll();
+	/// Submits and blocks until the read completed and its callback ran
+	void Wait(AsyncReadToken token);
+	void WaitAll();
+	bool IsComplete(AsyncReadToken token) const;
+
+	uint32_t GetNumPending() const { return mNumPending; }
+	bool IsUsingIoUring() const;
+
+private:
+	// Disable copy
+	AsyncFileReader(const AsyncFileReader&);
+	AsyncFileReader& operator=(const AsyncFileReader&);
+
+	struct AsyncFileReaderState* pState;
+	uint32_t mNumPending;
+};
+
 /// High level platform independent file system
 class FileSystem
 {
 public:
-	static unsigned GetFileSize(FileHandle handle);
+	static uint64_t GetFileSize(FileHandle handle);
 	// Allows to modify root paths at runtime
 	static void	 SetRootPath(FSRoot root, const tinystl::string& rootPath);
 	// Reverts back to App static defined pszRoots[]
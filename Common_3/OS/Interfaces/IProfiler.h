@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "IFileSystem.h"
+
+/// Frame profiler shared by the CPU and the GPU.
+/// Each thread records zones into its own fixed size event ring. Recording a zone does not take any lock,
+/// it reads the profiler clock and writes one event into the ring of the calling thread.
+/// GPU timestamps are pushed on named tracks after they have been read back (see GpuProfiler) and are
+/// converted to the same clock so both show up on one timeline.
+/// The recorded history can be written out as Chrome trace JSON which also loads in Perfetto (ui.perfetto.dev).
+
+typedef enum ProfileEventType
+{
+	PROFILE_EVENT_ZONE = 0,
+	PROFILE_EVENT_GPU_ZONE,
+	PROFILE_EVENT_FRAME,
+	PROFILE_EVENT_COUNTER,
+} ProfileEventType;
+
+typedef struct ProfileEvent
+{
+	/// Has to stay valid until the profile is exported. String literals are preferred
+	const char* pName;
+	int64_t     mBegin;
+	/// End tick for zones, value for counters
+	int64_t     mEnd;
+	uint16_t    mType;
+	/// Nesting depth for zones and gpu zones
+	uint16_t    mDepth;
+	/// Track index for gpu zones
+	uint32_t    mTrack;
+} ProfileEvent;
+
+typedef struct ProfilerStats
+{
+	uint32_t mThreadCount;
+	uint32_t mGpuTrackCount;
+	/// Number of events recorded since initProfiler across all threads
+	uint64_t mEventCount;
+	/// Number of events that were overwritten because a thread ring was full
+	uint64_t mDroppedEventCount;
+	uint64_t mFrameIndex;
+} ProfilerStats;
+
+/// eventsPerThread is rounded up to the next power of two
+void initProfiler(uint32_t eventsPerThread = 65536);
+void exitProfiler();
+
+/// Name shown for the calling thread in the exported trace
+void setProfilerThreadName(const char* pName);
+/// Returns a copy of pName owned by the profiler, valid until exitProfiler. Use it for names which do not outlive their owner
+const char* internProfilerString(const char* pName);
+
+void profileBeginZone(const char* pName);
+void profileEndZone();
+/// Marks the end of a frame. Also samples memory usage when memory tracking is enabled
+void profileFrameMarker();
+void profileCounter(const char* pName, int64_t value);
+
+/// Registers a named track for gpu zones and returns its index
+uint32_t addProfilerGpuTrack(const char* pName);
+/// beginTicks and endTicks are in profiler ticks (see getProfilerTicks). depth is the nesting level of the zone on its track
+void profileGpuZone(uint32_t track, const char* pName, int64_t beginTicks, int64_t endTicks, uint32_t depth);
+
+int64_t getProfilerTicks();
+/// Profiler ticks per second
+int64_t getProfilerTickFrequency();
+
+void getProfilerStats(ProfilerStats* pStats);
+/// Records iterations empty zones on the calling thread and returns the average cost of a begin/end pair in nanoseconds.
+/// The zones go to a scratch ring, the recorded history of the thread is kept
+double measureProfilerOverhead(uint32_t iterations = 1000000);
+
+/// Writes all events still held in the thread rings. Best called between frames so no zone is half recorded
+bool exportProfileChromeTrace(const char* pFileName, FSRoot root = FSR_OtherFiles);
+
+struct ProfileScope
+{
+	ProfileScope(const char* pName) { profileBeginZone(pName); }
+	~ProfileScope() { profileEndZone(); }
+
+private:
+	// Disable copy
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+};
+
+#define PROFILE_CONCAT_INTERNAL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INTERNAL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(name)
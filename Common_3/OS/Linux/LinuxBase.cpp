@@ -164,6 +164,7 @@ float2 getDpiScale()
 /************************************************************************/
 #include "../Interfaces/IApp.h"
 #include "../Interfaces/IFileSystem.h"
+#include "../Core/CpuFeatures.h"
 
 static IApp* pApp = NULL;
 
@@ -381,6 +382,9 @@ int LinuxMain(int argc, char** argv, IApp* app)
 
 	FileSystem::SetCurrentDir(FileSystem::GetProgramDir());
 
+	// Kernels are bound to the CPU during static initialization, report what they picked
+	logCpuKernels();
+
 	IApp::Settings* pSettings = &pApp->mSettings;
 	Timer deltaTimer;
 
@@ -31,6 +31,7 @@
 
 #include <pthread.h>
 #include <unistd.h>
+#include <sys/time.h>
 #include <sys/sysctl.h>
 
 Mutex::Mutex()
@@ -75,9 +76,13 @@ void* ThreadFunctionStatic(void* data)
 
   void ConditionVariable::Wait(const Mutex &mutex, unsigned int ms)
   {
+	  // pthread_cond_timedwait takes an absolute time
+	  timeval now;
+	  gettimeofday(&now, NULL);
+	  const uint64_t deadlineUs = (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_usec + (uint64_t)ms * 1000;
 	  timespec ts;
-	  ts.tv_sec = 0;
-	  ts.tv_nsec = ms*1000;
+	  ts.tv_sec = (time_t)(deadlineUs / 1000000);
+	  ts.tv_nsec = (long)(deadlineUs % 1000000) * 1000;
 
 	  pthread_mutex_t* mutexHandle = (pthread_mutex_t*)&mutex.pHandle;
 	  pthread_cond_timedwait(&pHandle, mutexHandle, &ts);
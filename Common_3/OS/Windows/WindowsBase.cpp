@@ -751,6 +751,7 @@ int64_t getTimerFrequency()
 /************************************************************************/
 #include "../Interfaces/IApp.h"
 #include "../Interfaces/IFileSystem.h"
+#include "../Core/CpuFeatures.h"
 
 static IApp* pApp = NULL;
 
@@ -783,6 +784,9 @@ int WindowsMain(int argc, char** argv, IApp* app)
 
 	FileSystem::SetCurrentDir(FileSystem::GetProgramDir());
 
+	// Kernels are bound to the CPU during static initialization, report what they picked
+	logCpuKernels();
+
 	IApp::Settings* pSettings = &pApp->mSettings;
 	WindowsDesc window = {};
 	Timer deltaTimer;
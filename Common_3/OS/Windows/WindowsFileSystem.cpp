@@ -27,6 +27,7 @@
 #include "../Interfaces/IFileSystem.h"
 #include "../Interfaces/ILogManager.h"
 #include "../Interfaces/IOperatingSystem.h"
+#include <io.h>
 #include "../Interfaces/IMemoryManager.h"
 
 #if defined(DIRECT3D12)
@@ -74,14 +75,40 @@ size_t _readFile(void *buffer, size_t byteCount, FileHandle handle)
 	return fread(buffer, 1, byteCount, (::FILE*)handle);
 }
 
-bool _seekFile(FileHandle handle, long offset, int origin)
+size_t _readFileAt(void *buffer, size_t byteCount, uint64_t offset, FileHandle handle)
 {
-	return fseek((::FILE*)handle, offset, origin) == 0;
+	// ReadFile with an offset does not use the position of the stream, it moves the pointer of the OS handle
+	// which File resyncs before its next sequential Read / Write
+	HANDLE file = (HANDLE)_get_osfhandle(_fileno((::FILE*)handle));
+	if (file == INVALID_HANDLE_VALUE)
+		return 0;
+
+	size_t bytesRead = 0;
+	while (bytesRead < byteCount)
+	{
+		// ReadFile takes 32 bit sizes, read large ranges in chunks
+		size_t remaining = byteCount - bytesRead;
+		DWORD chunkSize = remaining > (1U << 30) ? (DWORD)(1U << 30) : (DWORD)remaining;
+		uint64_t chunkOffset = offset + bytesRead;
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)(chunkOffset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = (DWORD)(chunkOffset >> 32);
+		DWORD chunkRead = 0;
+		if (!ReadFile(file, (char*)buffer + bytesRead, chunkSize, &chunkRead, &overlapped) || !chunkRead)
+			break;
+		bytesRead += chunkRead;
+	}
+	return bytesRead;
+}
+
+bool _seekFile(FileHandle handle, int64_t offset, int origin)
+{
+	return _fseeki64((::FILE*)handle, offset, origin) == 0;
 }
 
-long _tellFile(FileHandle handle)
+int64_t _tellFile(FileHandle handle)
 {
-	return ftell((::FILE*)handle);
+	return _ftelli64((::FILE*)handle);
 }
 
 size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
@@ -89,6 +116,41 @@ size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
 	return fwrite(buffer, byteCount, 1, (::FILE*)handle);
 }
 
+void* _mapFile(const char* filename, size_t* pSize, FileHandle* pMapping)
+{
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	LARGE_INTEGER size = {};
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	// The mapping keeps its own reference to the file
+	CloseHandle(file);
+
+	if (!mapping)
+		return NULL;
+
+	void* pData = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (!pData)
+	{
+		CloseHandle(mapping);
+		return NULL;
+	}
+
+	*pSize = (size_t)size.QuadPart;
+	*pMapping = mapping;
+	return pData;
+}
+
+void _unmapFile(void* pData, size_t size, FileHandle mapping)
+{
+	UNREF_PARAM(size);
+	UnmapViewOfFile(pData);
+	CloseHandle((HANDLE)mapping);
+}
+
 size_t _getFileLastModifiedTime(const char* _fileName)
 {
 	struct stat fileInfo;
@@ -32,6 +32,8 @@
 #include "../Interfaces/IMemoryManager.h"
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <limits.h>  // for UINT_MAX
 #include <sys/stat.h>  // for mkdir
 #include <sys/errno.h> // for errno
@@ -74,14 +76,31 @@ size_t _readFile(void *buffer, size_t byteCount, FileHandle handle)
 	return fread(buffer, byteCount, 1, (::FILE*)handle);
 }
 
-bool _seekFile(FileHandle handle, long offset, int origin)
+size_t _readFileAt(void *buffer, size_t byteCount, uint64_t offset, FileHandle handle)
 {
-	return fseek((::FILE*)handle, offset, origin) == 0;
+	// pread on the descriptor leaves the position of the stream untouched
+	int fd = fileno((::FILE*)handle);
+	size_t bytesRead = 0;
+	while (bytesRead < byteCount)
+	{
+		ssize_t result = pread(fd, (char*)buffer + bytesRead, byteCount - bytesRead, (off_t)(offset + bytesRead));
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result <= 0)
+			break;
+		bytesRead += (size_t)result;
+	}
+	return bytesRead;
 }
 
-long _tellFile(FileHandle handle)
+bool _seekFile(FileHandle handle, int64_t offset, int origin)
 {
-	return ftell((::FILE*)handle);
+	return fseeko((::FILE*)handle, (off_t)offset, origin) == 0;
+}
+
+int64_t _tellFile(FileHandle handle)
+{
+	return (int64_t)ftello((::FILE*)handle);
 }
 
 size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
@@ -89,6 +108,33 @@ size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
 	return fwrite(buffer, byteCount, 1, (::FILE*)handle);
 }
 
+void* _mapFile(const char* filename, size_t* pSize, FileHandle* pMapping)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct stat fileInfo;
+	void* pData = MAP_FAILED;
+	if (fstat(fd, &fileInfo) == 0 && fileInfo.st_size > 0)
+		pData = mmap(NULL, (size_t)fileInfo.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	close(fd);
+
+	if (pData == MAP_FAILED)
+		return NULL;
+
+	*pSize = (size_t)fileInfo.st_size;
+	*pMapping = NULL;
+	return pData;
+}
+
+// mmap needs no mapping object, _mapFile returns NULL for it
+void _unmapFile(void* pData, size_t size, FileHandle /*mapping*/)
+{
+	munmap(pData, size);
+}
+
 size_t _getFileLastModifiedTime(const char* _fileName)
 {
 	struct stat fileInfo;
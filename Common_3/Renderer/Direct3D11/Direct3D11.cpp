@@ -1300,6 +1300,29 @@ extern void d3d11_createShaderReflection(const uint8_t* shaderCode, uint32_t sha
 		SAFE_FREE(pFence);
 	}
 
+	void addTimelineFence(Renderer* pRenderer, Queue* pQueue, TimelineFence** ppFence)
+	{
+		// NOTE: Like regular fences this is only bookkeeping.
+		// The immediate context executes in submission order and Present / Map synchronize with the GPU.
+		ASSERT(pRenderer);
+		ASSERT(pQueue);
+
+		TimelineFence* pFence = (TimelineFence*)conf_calloc(1, sizeof(*pFence));
+		ASSERT(pFence);
+
+		pFence->pQueue = pQueue;
+
+		*ppFence = pFence;
+	}
+
+	void removeTimelineFence(Renderer* pRenderer, TimelineFence* pFence)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pFence);
+
+		SAFE_FREE(pFence);
+	}
+
 	void addSemaphore(Renderer* pRenderer, Semaphore** ppSemaphore)
 	{
 		// NOTE: We will still use it to be able to generate
@@ -3971,6 +3994,22 @@ extern void d3d11_createShaderReflection(const uint8_t* shaderCode, uint32_t sha
 	{
 	}
 
+	uint64_t queueSignalTimelineFence(TimelineFence* pFence)
+	{
+		pFence->mCompletedValue = ++pFence->mSignaledValue;
+		return pFence->mSignaledValue;
+	}
+
+	uint64_t getTimelineFenceCompletedValue(TimelineFence* pFence)
+	{
+		return pFence->mCompletedValue;
+	}
+
+	void waitTimelineFence(TimelineFence* pFence, uint64_t value)
+	{
+		ASSERT(value <= pFence->mSignaledValue && "Waiting for a value which was never signaled");
+	}
+
 	void toggleVSync(Renderer* pRenderer, SwapChain** ppSwapChain)
 	{
 		// Initial vsync value is passed in with the desc when client creates a swapchain.
@@ -2313,6 +2313,35 @@ namespace d3d12 {
 		SAFE_FREE(pFence);
 	}
 
+	void addTimelineFence(Renderer* pRenderer, Queue* pQueue, TimelineFence** ppFence)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pQueue);
+
+		TimelineFence* pFence = (TimelineFence*)conf_calloc(1, sizeof(*pFence));
+		ASSERT(pFence);
+
+		pFence->pQueue = pQueue;
+		// D3D12 fences are timelines, value 0 means nothing was signaled yet
+		HRESULT hres = pRenderer->pDxDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_ARGS(&pFence->pDxFence));
+		ASSERT(SUCCEEDED(hres));
+
+		pFence->pDxWaitEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+		*ppFence = pFence;
+	}
+
+	void removeTimelineFence(Renderer* pRenderer, TimelineFence* pFence)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pFence);
+
+		SAFE_RELEASE(pFence->pDxFence);
+		CloseHandle(pFence->pDxWaitEvent);
+
+		SAFE_FREE(pFence);
+	}
+
 	void addSemaphore(Renderer *pRenderer, Semaphore** ppSemaphore)
 	{
 		//ASSERT that renderer is valid
@@ -4765,6 +4794,10 @@ namespace d3d12 {
 		pCmd->mViewPosition = 0;
 		pCmd->mSamplerPosition = 0;
 		pCmd->mTransientCBVPosition = 0;
+
+		// The command buffer is only reset once the GPU is done with it so the root constants recorded into it can be overwritten
+		if (pCmd->pRootConstantRingBuffer)
+			resetUniformRingBuffer(pCmd->pRootConstantRingBuffer);
 	}
 
 	void endCmd(Cmd* pCmd)
@@ -5885,6 +5918,37 @@ namespace d3d12 {
 			*pFenceStatus = FENCE_STATUS_COMPLETE;
 	}
 
+	uint64_t queueSignalTimelineFence(TimelineFence* pFence)
+	{
+		ASSERT(pFence);
+
+		HRESULT hres = pFence->pQueue->pDxQueue->Signal(pFence->pDxFence, ++pFence->mSignaledValue);
+		ASSERT(SUCCEEDED(hres));
+
+		return pFence->mSignaledValue;
+	}
+
+	uint64_t getTimelineFenceCompletedValue(TimelineFence* pFence)
+	{
+		ASSERT(pFence);
+
+		pFence->mCompletedValue = pFence->pDxFence->GetCompletedValue();
+		return pFence->mCompletedValue;
+	}
+
+	void waitTimelineFence(TimelineFence* pFence, uint64_t value)
+	{
+		ASSERT(pFence);
+		ASSERT(value <= pFence->mSignaledValue && "Waiting for a value which was never signaled");
+
+		if (getTimelineFenceCompletedValue(pFence) >= value)
+			return;
+
+		pFence->pDxFence->SetEventOnCompletion(value, pFence->pDxWaitEvent);
+		WaitForSingleObject(pFence->pDxWaitEvent, INFINITE);
+		pFence->mCompletedValue = value;
+	}
+
 	bool fenceSetEventOnCompletion(Fence* fence, uint64_t value, HANDLE fenceEvent)
 	{
 		ASSERT(fence);
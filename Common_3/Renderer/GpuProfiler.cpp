@@ -26,6 +26,7 @@
 #include "GpuProfiler.h"
 #include "ResourceLoader.h"
 #include "../OS/Interfaces/IThread.h"
+#include "../OS/Interfaces/IProfiler.h"
 #include "../OS/Interfaces/ILogManager.h"
 #include "../OS/Interfaces/IMemoryManager.h"
 #if __linux__
@@ -95,6 +96,25 @@ static void calculateTimes(Cmd* pCmd, GpuProfiler* pGpuProfiler, GpuTimerTree* p
 		calculateTimes(pCmd, pGpuProfiler, pRoot->mChildren[i]);
 }
 
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(DIRECT3D11)
+// Converts the resolved timers to profiler ticks relative to the start of the frame they were recorded in
+static void pushProfilerZones(GpuProfiler* pGpuProfiler, GpuTimerTree* pNode, uint64_t frameStartGpuTime, uint32_t depth)
+{
+	const GpuTimer* pTimer = &pNode->mGpuTimer;
+	const double gpuToProfiler = pGpuProfiler->mProfilerTickFrequency / pGpuProfiler->mGpuTimeStampFrequency;
+	if (pTimer->mEndGpuTime > pTimer->mStartGpuTime && (uint64_t)pTimer->mStartGpuTime >= frameStartGpuTime)
+	{
+		const int64_t begin = pGpuProfiler->mReadbackStartTicks + (int64_t)((double)((uint64_t)pTimer->mStartGpuTime - frameStartGpuTime) * gpuToProfiler);
+		const int64_t end = begin + (int64_t)((double)(pTimer->mEndGpuTime - pTimer->mStartGpuTime) * gpuToProfiler);
+		// The timer name is freed with the GpuProfiler, the event has to stay valid until the profile is exported
+		profileGpuZone(pGpuProfiler->mProfilerTrack, internProfilerString(pTimer->mName.c_str()), begin, end, depth);
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)pNode->mChildren.size(); ++i)
+		pushProfilerZones(pGpuProfiler, pNode->mChildren[i], frameStartGpuTime, depth + 1);
+}
+#endif
+
 double getAverageGpuTime(struct GpuProfiler* pGpuProfiler, struct GpuTimer* pGpuTimer)
 {
 	int64_t elapsedTime = 0;
@@ -164,6 +184,10 @@ void addGpuProfiler(Renderer* pRenderer, Queue* pQueue, GpuProfiler** ppGpuProfi
 	pGpuProfiler->mCpuTimeStampFrequency = (double)getTimerFrequency();
 #endif
 
+	const char* pTrackNames[MAX_CMD_TYPE] = { "GPU Graphics", "GPU Bundle", "GPU Copy", "GPU Compute" };
+	pGpuProfiler->mProfilerTrack = addProfilerGpuTrack(pTrackNames[pQueue->mQueueDesc.mType]);
+	pGpuProfiler->mProfilerTickFrequency = (double)getProfilerTickFrequency();
+
 	pGpuProfiler->mMaxTimerCount = maxTimers;
 	pGpuProfiler->pGpuTimerPool = (GpuTimerTree*)conf_calloc(maxTimers, sizeof(*pGpuProfiler->pGpuTimerPool));
 	pGpuProfiler->pCurrentNode = &pGpuProfiler->mRoot;
@@ -281,6 +305,10 @@ void cmdBeginGpuFrameProfile(Cmd* pCmd, GpuProfiler* pGpuProfiler, bool bUseMark
 	uint32_t nextIndex = (pGpuProfiler->mBufferIndex + 1) % GpuProfiler::NUM_OF_FRAMES;
 	pGpuProfiler->mBufferIndex = nextIndex;
 
+	// The readback at the end of this frame holds the timers of the last frame that used this buffer index
+	pGpuProfiler->mReadbackStartTicks = pGpuProfiler->mFrameStartTicks[nextIndex];
+	pGpuProfiler->mFrameStartTicks[nextIndex] = getProfilerTicks();
+
 	clearChildren(&pGpuProfiler->mRoot);
 
 	pGpuProfiler->mCurrentTimerCount = 0;
@@ -316,6 +344,12 @@ void cmdEndGpuFrameProfile(Cmd* pCmd, GpuProfiler* pGpuProfiler)
 	calculateTimes(pCmd, pGpuProfiler, &pGpuProfiler->mRoot);
 
 #if defined(DIRECT3D12) || defined(VULKAN) || defined(DIRECT3D11)
+	if (pGpuProfiler->mReadbackStartTicks && pGpuProfiler->mRoot.mChildren.size())
+	{
+		GpuTimerTree* pFrameRoot = pGpuProfiler->mRoot.mChildren[0];
+		pushProfilerZones(pGpuProfiler, pFrameRoot, (uint64_t)pFrameRoot->mGpuTimer.mStartGpuTime, 0);
+	}
+
 	unmapBuffer(pCmd->pRenderer, pGpuProfiler->pReadbackBuffer[pGpuProfiler->mBufferIndex]);
 	pGpuProfiler->pTimeStamp = NULL;
 
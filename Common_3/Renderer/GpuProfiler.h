@@ -77,6 +77,13 @@ typedef struct GpuProfiler
 	double		  mCumulativeCpuTimeInternal;
 	double		  mCumulativeCpuTime;
 
+	// Frame profiler track the resolved timers are pushed to (see IProfiler.h)
+	// There is no calibrated gpu clock so each frame is anchored to the cpu time its recording started
+	uint32_t		mProfilerTrack;
+	double		  mProfilerTickFrequency;
+	int64_t		 mFrameStartTicks[NUM_OF_FRAMES];
+	int64_t		 mReadbackStartTicks;
+
 	bool			mUpdate;
 } GpuProfiler;
 
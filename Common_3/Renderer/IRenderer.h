@@ -546,6 +546,12 @@ typedef struct BufferBarrier
 	struct Buffer*  pBuffer;
 	ResourceState   mNewState;
 	bool			mSplit;
+	/// Queue family ownership transfer (Vulkan), recorded without a state change. The queue giving up the resource
+	/// records mRelease, the queue receiving it records mAcquire after waiting on the release. Other backends skip it
+	bool			mAcquire;
+	bool			mRelease;
+	/// Queue the resource is released to or acquired from
+	struct Queue*   pTransferQueue;
 } BufferBarrier;
 
 typedef struct TextureBarrier
@@ -553,6 +559,12 @@ typedef struct TextureBarrier
 	struct Texture* pTexture;
 	ResourceState   mNewState;
 	bool			mSplit;
+	/// Queue family ownership transfer (Vulkan), recorded without a state change. The queue giving up the resource
+	/// records mRelease, the queue receiving it records mAcquire after waiting on the release. Other backends skip it
+	bool			mAcquire;
+	bool			mRelease;
+	/// Queue the resource is released to or acquired from
+	struct Queue*   pTransferQueue;
 } TextureBarrier;
 
 typedef struct ReadRange
@@ -1186,6 +1198,39 @@ typedef struct Semaphore {
 #endif
 } Semaphore;
 
+#if defined(VULKAN)
+// Maximum number of timeline values which can be in flight on the GPU at the same time
+#define MAX_TIMELINE_FENCE_PENDING_SIGNALS 64
+#endif
+
+/// Monotonic counter signaled by a queue. Every signal increments the value by one and
+/// completes once all work submitted to the queue before the signal has finished.
+/// Not thread safe. Signal, wait and poll a timeline fence from one thread at a time.
+typedef struct TimelineFence {
+	struct Queue*					   pQueue;
+	/// Last value signaled on the queue
+	uint64_t							mSignaledValue;
+	/// Last value known to be completed by the GPU
+	uint64_t							mCompletedValue;
+#if defined(DIRECT3D12)
+	ID3D12Fence*						pDxFence;
+	HANDLE							  pDxWaitEvent;
+#endif
+#if defined(VULKAN)
+	// The Vulkan headers used here predate VK_KHR_timeline_semaphore so the timeline is emulated with a ring of binary fences
+	VkFence							 pVkFences[MAX_TIMELINE_FENCE_PENDING_SIGNALS];
+	uint64_t							mVkFenceValues[MAX_TIMELINE_FENCE_PENDING_SIGNALS];
+	/// Oldest pending fence in the ring
+	uint32_t							mVkFenceHead;
+	uint32_t							mVkPendingCount;
+#endif
+#if defined(METAL)
+	/// Written from the command buffer completion handlers
+	volatile uint64_t				   mMtlCompletedValue;
+	dispatch_semaphore_t				pMtlSemaphore;
+#endif
+} TimelineFence;
+
 typedef struct Queue {
 	Renderer*			   pRenderer;
 #if defined(DIRECT3D12)
@@ -1196,6 +1241,8 @@ typedef struct Queue {
 	VkQueue				 pVkQueue;
 	uint32_t				mVkQueueFamilyIndex;
 	uint32_t				mVkQueueIndex;
+	/// VkQueue access must be externally synchronized. Held only around the submit and present calls
+	Mutex*				  pSubmitMutex;
 #endif
 #if defined(METAL)
 	id<MTLCommandQueue>	 mtlCommandQueue;
@@ -1785,6 +1832,9 @@ API_INTERFACE void CALLTYPE removeRenderer(Renderer* pRenderer);
 API_INTERFACE void CALLTYPE addFence(Renderer* pRenderer, Fence** pp_fence);
 API_INTERFACE void CALLTYPE removeFence(Renderer* pRenderer, Fence* p_fence);
 
+API_INTERFACE void CALLTYPE addTimelineFence(Renderer* pRenderer, Queue* p_queue, TimelineFence** pp_fence);
+API_INTERFACE void CALLTYPE removeTimelineFence(Renderer* pRenderer, TimelineFence* p_fence);
+
 API_INTERFACE void CALLTYPE addSemaphore(Renderer* pRenderer, Semaphore** pp_semaphore);
 API_INTERFACE void CALLTYPE removeSemaphore(Renderer* pRenderer, Semaphore* p_semaphore);
 
@@ -1867,6 +1917,12 @@ API_INTERFACE void CALLTYPE queueSubmit(Queue* p_queue, uint32_t cmd_count, Cmd*
 API_INTERFACE void CALLTYPE queuePresent(Queue* p_queue, SwapChain* p_swap_chain, uint32_t swap_chain_image_index, uint32_t wait_semaphore_count, Semaphore** pp_wait_semaphores);
 API_INTERFACE void CALLTYPE getFenceStatus(Renderer* pRenderer, Fence* p_fence, FenceStatus* p_fence_status);
 API_INTERFACE void CALLTYPE waitForFences(Queue* p_queue, uint32_t fence_count, Fence** pp_fences, bool signal);
+// Signals the next value of the timeline fence on its queue after all work submitted so far. Returns the signaled value
+API_INTERFACE uint64_t CALLTYPE queueSignalTimelineFence(TimelineFence* p_fence);
+// Non blocking. Returns the last value the GPU has reached
+API_INTERFACE uint64_t CALLTYPE getTimelineFenceCompletedValue(TimelineFence* p_fence);
+// Blocks until the GPU has reached value
+API_INTERFACE void CALLTYPE waitTimelineFence(TimelineFence* p_fence, uint64_t value);
 API_INTERFACE void CALLTYPE toggleVSync(Renderer* pRenderer, SwapChain** ppSwapchain);
 
 // image related functions
@@ -37,6 +37,7 @@
 #include "MetalMemoryAllocator.h"
 #include "../../OS/Interfaces/ILogManager.h"
 #include "../../OS/Core/GPUConfig.h"
+#include "../../OS/Core/Atomics.h"
 #include "../../OS/Interfaces/IMemoryManager.h"
 
 #define MAX_BUFFER_BINDINGS 31
@@ -1269,6 +1270,29 @@ namespace RENDERER_CPP_NAMESPACE {
 		SAFE_FREE(pFence);
 	}
 
+	void addTimelineFence(Renderer* pRenderer, Queue* pQueue, TimelineFence** ppFence)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pQueue);
+
+		TimelineFence* pFence = (TimelineFence*)conf_calloc(1, sizeof(*pFence));
+		ASSERT(pFence);
+
+		pFence->pQueue = pQueue;
+		pFence->pMtlSemaphore = dispatch_semaphore_create(0);
+
+		*ppFence = pFence;
+	}
+
+	void removeTimelineFence(Renderer* pRenderer, TimelineFence* pFence)
+	{
+		ASSERT(pFence);
+		// The completion handlers reference the fence so the GPU has to be done with all signaled values
+		ASSERT(tfrg_atomic64_load_relaxed(&pFence->mMtlCompletedValue) == pFence->mSignaledValue);
+		pFence->pMtlSemaphore = nil;
+		SAFE_FREE(pFence);
+	}
+
 	void addSemaphore(Renderer *pRenderer, Semaphore** ppSemaphore)
 	{
 		ASSERT(pRenderer);
@@ -3120,6 +3144,42 @@ namespace RENDERER_CPP_NAMESPACE {
 		}
 	}
 
+	uint64_t queueSignalTimelineFence(TimelineFence* pFence)
+	{
+		ASSERT(pFence);
+		ASSERT(pFence->pQueue->mtlCommandQueue != nil);
+
+		// Command buffers of a queue complete in order so an empty command buffer completes after all previously committed work
+		const uint64_t value = ++pFence->mSignaledValue;
+		id<MTLCommandBuffer> commandBuffer = [pFence->pQueue->mtlCommandQueue commandBuffer];
+		TimelineFence* pBlockFence = pFence;
+		[commandBuffer addCompletedHandler:^(id<MTLCommandBuffer> buffer) {
+			tfrg_atomic64_max_relaxed(&pBlockFence->mMtlCompletedValue, value);
+			dispatch_semaphore_signal(pBlockFence->pMtlSemaphore);
+		}];
+		[commandBuffer commit];
+
+		return value;
+	}
+
+	uint64_t getTimelineFenceCompletedValue(TimelineFence* pFence)
+	{
+		ASSERT(pFence);
+
+		pFence->mCompletedValue = tfrg_atomic64_load_relaxed(&pFence->mMtlCompletedValue);
+		return pFence->mCompletedValue;
+	}
+
+	void waitTimelineFence(TimelineFence* pFence, uint64_t value)
+	{
+		ASSERT(pFence);
+		ASSERT(value <= pFence->mSignaledValue && "Waiting for a value which was never signaled");
+
+		// Every completion signals the semaphore once, so re-check the value after each wake up
+		while (getTimelineFenceCompletedValue(pFence) < value)
+			dispatch_semaphore_wait(pFence->pMtlSemaphore, DISPATCH_TIME_FOREVER);
+	}
+
 	void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus)
 	{
 		ASSERT(pFence);
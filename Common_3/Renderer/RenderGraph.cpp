@@ -0,0 +1,928 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <alloca.h>
+#endif
+
+#include "IRenderer.h"
+#include "RenderGraph.h"
+#include "../OS/Interfaces/ILogManager.h"
+#include "../OS/Interfaces/IMemoryManager.h"
+
+typedef enum RenderGraphResourceType
+{
+	RENDER_GRAPH_RESOURCE_RENDER_TARGET = 0,
+	RENDER_GRAPH_RESOURCE_BUFFER,
+} RenderGraphResourceType;
+
+typedef struct RenderGraphResource
+{
+	tinystl::string			 mName;
+	RenderGraphResourceType	 mType;
+	/// Creation info (transient resources only)
+	RenderTargetDesc			mDesc;
+	/// Imported resource or physical resource this transient resource is aliased to after compilation
+	RenderTarget*			   pRenderTarget;
+	Buffer*					 pBuffer;
+	ResourceState			   mInitialState;
+	ResourceState			   mFinalState;
+	uint64_t					mSize;
+	uint32_t					mPhysicalIndex;
+	uint32_t					mFirstPass;
+	uint32_t					mLastPass;
+	bool						mImported;
+	bool						mOutput;
+	bool						mAlive;
+} RenderGraphResource;
+
+typedef struct RenderGraphAccess
+{
+	RenderGraphHandle   mResource;
+	ResourceState	   mState;
+	bool				mWrite;
+} RenderGraphAccess;
+
+typedef struct RenderGraphBarrier
+{
+	RenderGraphHandle   mResource;
+	ResourceState	   mNewState;
+} RenderGraphBarrier;
+
+/// Queue family ownership transfer of a resource between the two queues
+typedef struct RenderGraphTransfer
+{
+	RenderGraphHandle	   mResource;
+	/// Queue the resource is released to or acquired from
+	RenderGraphQueueType	mQueue;
+} RenderGraphTransfer;
+
+typedef struct RenderGraphPass
+{
+	tinystl::string						mName;
+	RenderGraphQueueType				   mQueue;
+	RenderGraphPassFn					  pFn;
+	void*								  pUserData;
+	tinystl::vector<RenderGraphAccess>	 mAccesses;
+	tinystl::vector<RenderGraphBarrier>	mBarriers;
+	uint32_t							   mBatch;
+	bool								   mCulled;
+} RenderGraphPass;
+
+typedef struct RenderGraphPhysicalResource
+{
+	RenderTargetDesc	mDesc;
+	/// One render target per transient set
+	RenderTarget**	  ppRenderTargets;
+	uint64_t			mSize;
+	uint32_t			mLastPass;
+} RenderGraphPhysicalResource;
+
+/// Consecutive passes recorded into one command buffer and submitted to one queue
+typedef struct RenderGraphBatch
+{
+	RenderGraphQueueType				   mQueue;
+	tinystl::vector<uint32_t>			  mPasses;
+	/// Batches on the other queue which have to finish before this batch starts
+	tinystl::vector<uint32_t>			  mWaitBatches;
+	/// Resources received from the other queue, acquired before the first pass
+	tinystl::vector<RenderGraphTransfer>	mAcquires;
+	/// Resources handed over to the other queue, released after the last pass
+	tinystl::vector<RenderGraphTransfer>	mReleases;
+	/// Transitions of imported resources to their final state
+	tinystl::vector<RenderGraphBarrier>	mFinalBarriers;
+	Cmd**								  ppCmds;
+	Semaphore**							ppSemaphores;
+	bool								   mSignal;
+} RenderGraphBatch;
+
+typedef struct RenderGraph
+{
+	RenderGraphDesc								mDesc;
+	CmdPool*									   pCmdPools[RENDER_GRAPH_QUEUE_COUNT];
+	tinystl::vector<RenderGraphResource>		   mResources;
+	tinystl::vector<RenderGraphPass>			   mPasses;
+	tinystl::vector<RenderGraphPhysicalResource>   mPhysicalResources;
+	tinystl::vector<RenderGraphBatch>			  mBatches;
+	RenderGraphStats							   mStats;
+	/// Copies of the physical resources, one per frame in flight when both queues are used
+	uint32_t									   mTransientSetCount;
+	bool										   mCompiled;
+} RenderGraph;
+/************************************************************************/
+// Internal utility functions
+/************************************************************************/
+static uint64_t util_render_target_size(const RenderTargetDesc* pDesc)
+{
+	const uint32_t mipLevels = max(1U, pDesc->mMipLevels);
+	uint64_t texels = 0;
+	for (uint32_t mip = 0; mip < mipLevels; ++mip)
+	{
+		texels += (uint64_t)max(1U, pDesc->mWidth >> mip) * max(1U, pDesc->mHeight >> mip) * max(1U, pDesc->mDepth >> mip);
+	}
+
+	return texels * max(1U, pDesc->mArraySize) * (uint64_t)pDesc->mSampleCount * (uint64_t)ImageFormat::GetBytesPerPixel(pDesc->mFormat);
+}
+
+/// Two transient render targets can share the same physical render target if they would have been created identically
+static bool util_is_compatible(const RenderTargetDesc* pA, const RenderTargetDesc* pB)
+{
+	return pA->mFlags == pB->mFlags &&
+		pA->mWidth == pB->mWidth &&
+		pA->mHeight == pB->mHeight &&
+		pA->mDepth == pB->mDepth &&
+		pA->mArraySize == pB->mArraySize &&
+		pA->mMipLevels == pB->mMipLevels &&
+		pA->mSampleCount == pB->mSampleCount &&
+		pA->mSampleQuality == pB->mSampleQuality &&
+		pA->mFormat == pB->mFormat &&
+		pA->mDescriptors == pB->mDescriptors &&
+		pA->mNodeIndex == pB->mNodeIndex &&
+		pA->mSrgb == pB->mSrgb;
+}
+
+static int util_compare_first_pass(RenderGraphResource* const& pA, RenderGraphResource* const& pB)
+{
+	return (int)pA->mFirstPass - (int)pB->mFirstPass;
+}
+
+/// Transient resources aliased to the same physical resource share their state tracking slot
+static uint32_t util_state_slot(const RenderGraph* pGraph, RenderGraphHandle handle)
+{
+	const RenderGraphResource& res = pGraph->mResources[handle];
+	if (res.mImported)
+		return handle;
+	return (uint32_t)pGraph->mResources.size() + res.mPhysicalIndex;
+}
+
+static RenderGraphQueueType util_effective_queue(const RenderGraph* pGraph, RenderGraphQueueType queue)
+{
+	if (queue == RENDER_GRAPH_QUEUE_COMPUTE && !pGraph->mDesc.pComputeQueue)
+		return RENDER_GRAPH_QUEUE_GRAPHICS;
+	return queue;
+}
+
+static Queue* util_get_queue(const RenderGraph* pGraph, RenderGraphQueueType queue)
+{
+	return queue == RENDER_GRAPH_QUEUE_COMPUTE ? pGraph->mDesc.pComputeQueue : pGraph->mDesc.pGraphicsQueue;
+}
+
+static void util_add_unique(tinystl::vector<uint32_t>& list, uint32_t value)
+{
+	if (list.find(value) == list.end())
+		list.push_back(value);
+}
+
+static void releasePhysicalResources(RenderGraph* pGraph)
+{
+	Renderer* pRenderer = pGraph->mDesc.pRenderer;
+
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mBatches.size(); ++i)
+	{
+		RenderGraphBatch& batch = pGraph->mBatches[i];
+		for (uint32_t f = 0; f < pGraph->mDesc.mFrameCount; ++f)
+		{
+			if (batch.ppCmds && batch.ppCmds[f])
+				removeCmd(pGraph->pCmdPools[batch.mQueue], batch.ppCmds[f]);
+			if (batch.ppSemaphores && batch.ppSemaphores[f])
+				removeSemaphore(pRenderer, batch.ppSemaphores[f]);
+		}
+		if (batch.ppCmds)
+			conf_free(batch.ppCmds);
+		if (batch.ppSemaphores)
+			conf_free(batch.ppSemaphores);
+	}
+	pGraph->mBatches.clear();
+
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mPhysicalResources.size(); ++i)
+	{
+		RenderGraphPhysicalResource& physical = pGraph->mPhysicalResources[i];
+		if (!physical.ppRenderTargets)
+			continue;
+		for (uint32_t s = 0; s < pGraph->mTransientSetCount; ++s)
+		{
+			if (physical.ppRenderTargets[s])
+				removeRenderTarget(pRenderer, physical.ppRenderTargets[s]);
+		}
+		conf_free(physical.ppRenderTargets);
+	}
+	pGraph->mPhysicalResources.clear();
+	pGraph->mTransientSetCount = 0;
+}
+
+static void cmdRenderGraphBarriers(Cmd* pCmd, RenderGraph* pGraph, const tinystl::vector<RenderGraphBarrier>& barriers)
+{
+	if (barriers.empty())
+		return;
+
+	TextureBarrier* pTextureBarriers = (TextureBarrier*)alloca(barriers.size() * sizeof(TextureBarrier));
+	BufferBarrier* pBufferBarriers = (BufferBarrier*)alloca(barriers.size() * sizeof(BufferBarrier));
+	uint32_t textureBarrierCount = 0;
+	uint32_t bufferBarrierCount = 0;
+
+	for (uint32_t i = 0; i < (uint32_t)barriers.size(); ++i)
+	{
+		const RenderGraphResource& res = pGraph->mResources[barriers[i].mResource];
+		if (res.mType == RENDER_GRAPH_RESOURCE_RENDER_TARGET)
+			pTextureBarriers[textureBarrierCount++] = { res.pRenderTarget->pTexture, barriers[i].mNewState, false };
+		else
+			pBufferBarriers[bufferBarrierCount++] = { res.pBuffer, barriers[i].mNewState, false };
+	}
+
+	cmdResourceBarrier(pCmd, bufferBarrierCount, pBufferBarriers, textureBarrierCount, pTextureBarriers, false);
+}
+
+/// Ownership transfers keep the current state of the resource, so only the Vulkan backend records them
+static void cmdRenderGraphTransfers(Cmd* pCmd, RenderGraph* pGraph, const tinystl::vector<RenderGraphTransfer>& transfers, bool release)
+{
+	if (transfers.empty())
+		return;
+
+	TextureBarrier* pTextureBarriers = (TextureBarrier*)alloca(transfers.size() * sizeof(TextureBarrier));
+	BufferBarrier* pBufferBarriers = (BufferBarrier*)alloca(transfers.size() * sizeof(BufferBarrier));
+	uint32_t textureBarrierCount = 0;
+	uint32_t bufferBarrierCount = 0;
+
+	for (uint32_t i = 0; i < (uint32_t)transfers.size(); ++i)
+	{
+		const RenderGraphResource& res = pGraph->mResources[transfers[i].mResource];
+		Queue* pTransferQueue = util_get_queue(pGraph, transfers[i].mQueue);
+		if (res.mType == RENDER_GRAPH_RESOURCE_RENDER_TARGET)
+			pTextureBarriers[textureBarrierCount++] = { res.pRenderTarget->pTexture, res.pRenderTarget->pTexture->mCurrentState, false, !release, release, pTransferQueue };
+		else
+			pBufferBarriers[bufferBarrierCount++] = { res.pBuffer, res.pBuffer->mCurrentState, false, !release, release, pTransferQueue };
+	}
+
+	cmdResourceBarrier(pCmd, bufferBarrierCount, pBufferBarriers, textureBarrierCount, pTextureBarriers, false);
+}
+
+/// Releases the resource at the end of the batch which last used it and acquires it in the batch using it next,
+/// which has to wait for the release
+static void addOwnershipTransfer(RenderGraph* pGraph, RenderGraphHandle resource, uint32_t releaseBatch, uint32_t acquireBatch)
+{
+	RenderGraphBatch& releasing = pGraph->mBatches[releaseBatch];
+	RenderGraphBatch& acquiring = pGraph->mBatches[acquireBatch];
+
+	RenderGraphTransfer release = { resource, acquiring.mQueue };
+	RenderGraphTransfer acquire = { resource, releasing.mQueue };
+	releasing.mReleases.push_back(release);
+	acquiring.mAcquires.push_back(acquire);
+
+	util_add_unique(acquiring.mWaitBatches, releaseBatch);
+	releasing.mSignal = true;
+	++pGraph->mStats.mOwnershipTransferCount;
+}
+/************************************************************************/
+// Render Graph implementation
+/************************************************************************/
+void addRenderGraph(const RenderGraphDesc* pDesc, RenderGraph** ppGraph)
+{
+	ASSERT(pDesc);
+	ASSERT(ppGraph);
+
+	RenderGraph* pGraph = conf_placement_new<RenderGraph>(conf_calloc(1, sizeof(RenderGraph)));
+	pGraph->mDesc = *pDesc;
+	pGraph->mDesc.mFrameCount = max(1U, pDesc->mFrameCount);
+
+	if (pGraph->mDesc.pRenderer)
+	{
+		ASSERT(pGraph->mDesc.pGraphicsQueue);
+		addCmdPool(pGraph->mDesc.pRenderer, pGraph->mDesc.pGraphicsQueue, false, &pGraph->pCmdPools[RENDER_GRAPH_QUEUE_GRAPHICS]);
+		if (pGraph->mDesc.pComputeQueue)
+			addCmdPool(pGraph->mDesc.pRenderer, pGraph->mDesc.pComputeQueue, false, &pGraph->pCmdPools[RENDER_GRAPH_QUEUE_COMPUTE]);
+	}
+
+	*ppGraph = pGraph;
+}
+
+void removeRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+
+	releasePhysicalResources(pGraph);
+
+	for (uint32_t i = 0; i < RENDER_GRAPH_QUEUE_COUNT; ++i)
+	{
+		if (pGraph->pCmdPools[i])
+			removeCmdPool(pGraph->mDesc.pRenderer, pGraph->pCmdPools[i]);
+	}
+
+	pGraph->~RenderGraph();
+	conf_free(pGraph);
+}
+
+void resetRenderGraph(RenderGraph* pGraph)
+{
+	pGraph->mResources.clear();
+	pGraph->mPasses.clear();
+	pGraph->mCompiled = false;
+}
+
+static RenderGraphHandle addResource(RenderGraph* pGraph, const char* pName, RenderGraphResourceType type)
+{
+	RenderGraphResource res = {};
+	res.mName = pName ? pName : "";
+	res.mType = type;
+	res.mPhysicalIndex = RENDER_GRAPH_INVALID_HANDLE;
+	res.mFirstPass = RENDER_GRAPH_INVALID_HANDLE;
+	res.mLastPass = 0;
+	pGraph->mResources.push_back(res);
+	pGraph->mCompiled = false;
+	return (RenderGraphHandle)pGraph->mResources.size() - 1;
+}
+
+RenderGraphHandle rgImportRenderTarget(RenderGraph* pGraph, const char* pName, RenderTarget* pRenderTarget, ResourceState initialState, ResourceState finalState)
+{
+	RenderGraphHandle handle = addResource(pGraph, pName, RENDER_GRAPH_RESOURCE_RENDER_TARGET);
+	RenderGraphResource& res = pGraph->mResources[handle];
+	res.pRenderTarget = pRenderTarget;
+	res.mInitialState = initialState;
+	res.mFinalState = finalState;
+	res.mImported = true;
+	return handle;
+}
+
+RenderGraphHandle rgImportBuffer(RenderGraph* pGraph, const char* pName, Buffer* pBuffer, ResourceState initialState, ResourceState finalState)
+{
+	RenderGraphHandle handle = addResource(pGraph, pName, RENDER_GRAPH_RESOURCE_BUFFER);
+	RenderGraphResource& res = pGraph->mResources[handle];
+	res.pBuffer = pBuffer;
+	res.mInitialState = initialState;
+	res.mFinalState = finalState;
+	res.mImported = true;
+	return handle;
+}
+
+void rgSetImportedRenderTarget(RenderGraph* pGraph, RenderGraphHandle handle, RenderTarget* pRenderTarget)
+{
+	ASSERT(pGraph->mResources[handle].mImported && pGraph->mResources[handle].mType == RENDER_GRAPH_RESOURCE_RENDER_TARGET);
+	pGraph->mResources[handle].pRenderTarget = pRenderTarget;
+}
+
+void rgSetImportedBuffer(RenderGraph* pGraph, RenderGraphHandle handle, Buffer* pBuffer)
+{
+	ASSERT(pGraph->mResources[handle].mImported && pGraph->mResources[handle].mType == RENDER_GRAPH_RESOURCE_BUFFER);
+	pGraph->mResources[handle].pBuffer = pBuffer;
+}
+
+RenderGraphHandle rgAddRenderTarget(RenderGraph* pGraph, const char* pName, const RenderTargetDesc* pDesc)
+{
+	ASSERT(pDesc);
+
+	RenderGraphHandle handle = addResource(pGraph, pName, RENDER_GRAPH_RESOURCE_RENDER_TARGET);
+	RenderGraphResource& res = pGraph->mResources[handle];
+	res.mDesc = *pDesc;
+	res.mSize = util_render_target_size(pDesc);
+	// Render targets are created in their writable state (see addRenderTarget)
+	res.mInitialState = ImageFormat::IsDepthFormat(pDesc->mFormat) ? RESOURCE_STATE_DEPTH_WRITE : RESOURCE_STATE_RENDER_TARGET;
+	res.mFinalState = RESOURCE_STATE_UNDEFINED;
+	return handle;
+}
+
+uint32_t rgAddPass(RenderGraph* pGraph, const char* pName, RenderGraphQueueType queue, RenderGraphPassFn pFn, void* pUserData)
+{
+	RenderGraphPass pass = {};
+	pass.mName = pName ? pName : "";
+	pass.mQueue = queue;
+	pass.pFn = pFn;
+	pass.pUserData = pUserData;
+	pGraph->mPasses.push_back(pass);
+	pGraph->mCompiled = false;
+	return (uint32_t)pGraph->mPasses.size() - 1;
+}
+
+void rgPassRead(RenderGraph* pGraph, uint32_t pass, RenderGraphHandle resource, ResourceState state)
+{
+	ASSERT(pass < (uint32_t)pGraph->mPasses.size());
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	RenderGraphAccess access = { resource, state, false };
+	pGraph->mPasses[pass].mAccesses.push_back(access);
+	pGraph->mCompiled = false;
+}
+
+void rgPassWrite(RenderGraph* pGraph, uint32_t pass, RenderGraphHandle resource, ResourceState state)
+{
+	ASSERT(pass < (uint32_t)pGraph->mPasses.size());
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	RenderGraphAccess access = { resource, state, true };
+	pGraph->mPasses[pass].mAccesses.push_back(access);
+	pGraph->mCompiled = false;
+}
+
+void rgMarkOutput(RenderGraph* pGraph, RenderGraphHandle resource)
+{
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	pGraph->mResources[resource].mOutput = true;
+	pGraph->mCompiled = false;
+}
+
+/// Walk the passes backwards starting from the outputs. A pass survives if it writes a resource needed later.
+static void cullPasses(RenderGraph* pGraph)
+{
+	const uint32_t passCount = (uint32_t)pGraph->mPasses.size();
+
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+		pGraph->mResources[i].mAlive = pGraph->mResources[i].mOutput;
+
+	for (uint32_t p = passCount; p-- > 0;)
+	{
+		RenderGraphPass& pass = pGraph->mPasses[p];
+		pass.mCulled = true;
+
+		for (uint32_t a = 0; a < (uint32_t)pass.mAccesses.size(); ++a)
+		{
+			if (pass.mAccesses[a].mWrite && pGraph->mResources[pass.mAccesses[a].mResource].mAlive)
+			{
+				pass.mCulled = false;
+				break;
+			}
+		}
+
+		if (pass.mCulled)
+			continue;
+
+		for (uint32_t a = 0; a < (uint32_t)pass.mAccesses.size(); ++a)
+		{
+			if (!pass.mAccesses[a].mWrite)
+				pGraph->mResources[pass.mAccesses[a].mResource].mAlive = true;
+		}
+	}
+}
+
+/// Assign each transient resource to the first compatible physical resource which is no longer in use
+static void aliasTransientResources(RenderGraph* pGraph)
+{
+	RenderGraphStats& stats = pGraph->mStats;
+	tinystl::vector<RenderGraphResource*> transients;
+
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		const RenderGraphPass& pass = pGraph->mPasses[p];
+		if (pass.mCulled)
+			continue;
+
+		for (uint32_t a = 0; a < (uint32_t)pass.mAccesses.size(); ++a)
+		{
+			RenderGraphResource& res = pGraph->mResources[pass.mAccesses[a].mResource];
+			if (res.mImported)
+				continue;
+			if (res.mFirstPass == RENDER_GRAPH_INVALID_HANDLE)
+			{
+				res.mFirstPass = p;
+				transients.push_back(&res);
+			}
+			res.mLastPass = p;
+		}
+	}
+
+	transients.sort(util_compare_first_pass);
+
+	for (uint32_t i = 0; i < (uint32_t)transients.size(); ++i)
+	{
+		RenderGraphResource* pRes = transients[i];
+		uint32_t physicalIndex = RENDER_GRAPH_INVALID_HANDLE;
+
+		for (uint32_t j = 0; j < (uint32_t)pGraph->mPhysicalResources.size(); ++j)
+		{
+			const RenderGraphPhysicalResource& physical = pGraph->mPhysicalResources[j];
+			if (physical.mLastPass < pRes->mFirstPass && util_is_compatible(&physical.mDesc, &pRes->mDesc))
+			{
+				physicalIndex = j;
+				break;
+			}
+		}
+
+		if (physicalIndex == RENDER_GRAPH_INVALID_HANDLE)
+		{
+			RenderGraphPhysicalResource physical = {};
+			physical.mDesc = pRes->mDesc;
+			physical.mSize = pRes->mSize;
+			pGraph->mPhysicalResources.push_back(physical);
+			physicalIndex = (uint32_t)pGraph->mPhysicalResources.size() - 1;
+			stats.mTransientMemoryAllocated += physical.mSize;
+		}
+
+		pGraph->mPhysicalResources[physicalIndex].mLastPass = pRes->mLastPass;
+		pRes->mPhysicalIndex = physicalIndex;
+		stats.mTransientMemoryRequested += pRes->mSize;
+	}
+
+	// Peak of simultaneously alive transient memory (lower bound for any aliasing scheme)
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		uint64_t alive = 0;
+		for (uint32_t i = 0; i < (uint32_t)transients.size(); ++i)
+		{
+			if (transients[i]->mFirstPass <= p && transients[i]->mLastPass >= p)
+				alive += transients[i]->mSize;
+		}
+		stats.mTransientMemoryPeak = max(stats.mTransientMemoryPeak, alive);
+	}
+
+	stats.mTransientResourceCount = (uint32_t)transients.size();
+	stats.mPhysicalResourceCount = (uint32_t)pGraph->mPhysicalResources.size();
+}
+
+/// Simulate resource states through the frame to derive the barriers and split the passes into queue submissions
+static void buildBatches(RenderGraph* pGraph)
+{
+	RenderGraphStats& stats = pGraph->mStats;
+	const uint32_t slotCount = (uint32_t)pGraph->mResources.size() + (uint32_t)pGraph->mPhysicalResources.size();
+	ResourceState* pStates = (ResourceState*)conf_calloc(slotCount, sizeof(ResourceState));
+	uint32_t* pLastBatch = (uint32_t*)conf_malloc(slotCount * sizeof(uint32_t));
+	bool* pTouched = (bool*)conf_calloc(slotCount, sizeof(bool));
+	for (uint32_t i = 0; i < slotCount; ++i)
+		pLastBatch[i] = RENDER_GRAPH_INVALID_HANDLE;
+
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+	{
+		const RenderGraphResource& res = pGraph->mResources[i];
+		if (res.mImported)
+			pStates[i] = res.mInitialState;
+		else if (res.mPhysicalIndex != RENDER_GRAPH_INVALID_HANDLE && !pTouched[util_state_slot(pGraph, i)])
+		{
+			pStates[util_state_slot(pGraph, i)] = res.mInitialState;
+			pTouched[util_state_slot(pGraph, i)] = true;
+		}
+	}
+	memset(pTouched, 0, slotCount * sizeof(bool));
+
+	// Imported resources belong to the graphics queue outside of the graph. If the compute queue uses one of them first,
+	// the graph starts with a graphics batch handing it over. Graphics passes at the start of the frame join that batch
+	if (pGraph->mDesc.pComputeQueue)
+	{
+		bool computeFirst = false;
+		for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+		{
+			const RenderGraphPass& pass = pGraph->mPasses[p];
+			if (pass.mCulled)
+				continue;
+
+			for (uint32_t a = 0; a < (uint32_t)pass.mAccesses.size(); ++a)
+			{
+				const RenderGraphHandle handle = pass.mAccesses[a].mResource;
+				if (!pGraph->mResources[handle].mImported || pTouched[handle])
+					continue;
+
+				pTouched[handle] = true;
+				computeFirst |= util_effective_queue(pGraph, pass.mQueue) == RENDER_GRAPH_QUEUE_COMPUTE;
+			}
+		}
+
+		if (computeFirst)
+		{
+			RenderGraphBatch batch = {};
+			batch.mQueue = RENDER_GRAPH_QUEUE_GRAPHICS;
+			pGraph->mBatches.push_back(batch);
+
+			for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+			{
+				if (pTouched[i])
+					pLastBatch[i] = 0;
+			}
+		}
+		memset(pTouched, 0, slotCount * sizeof(bool));
+	}
+
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		RenderGraphPass& pass = pGraph->mPasses[p];
+		pass.mBarriers.clear();
+		if (pass.mCulled)
+		{
+			++stats.mCulledPassCount;
+			continue;
+		}
+
+		const RenderGraphQueueType queue = util_effective_queue(pGraph, pass.mQueue);
+		if (pGraph->mBatches.empty() || pGraph->mBatches.back().mQueue != queue)
+		{
+			RenderGraphBatch batch = {};
+			batch.mQueue = queue;
+			pGraph->mBatches.push_back(batch);
+		}
+		const uint32_t batchIndex = (uint32_t)pGraph->mBatches.size() - 1;
+		RenderGraphBatch& batch = pGraph->mBatches[batchIndex];
+		batch.mPasses.push_back(p);
+		pass.mBatch = batchIndex;
+
+		for (uint32_t a = 0; a < (uint32_t)pass.mAccesses.size(); ++a)
+		{
+			const RenderGraphAccess& access = pass.mAccesses[a];
+			const uint32_t slot = util_state_slot(pGraph, access.mResource);
+
+			// The state at the start of the frame is only known for the first frame so the first access always records a barrier.
+			// The backends skip barriers whose state already matches.
+			if (!pTouched[slot] || pStates[slot] != access.mState)
+			{
+				RenderGraphBarrier barrier = { access.mResource, access.mState };
+				pass.mBarriers.push_back(barrier);
+				if (pStates[slot] != access.mState)
+					++stats.mBarrierCount;
+				pStates[slot] = access.mState;
+				pTouched[slot] = true;
+			}
+
+			const uint32_t lastBatch = pLastBatch[slot];
+			if (lastBatch != RENDER_GRAPH_INVALID_HANDLE && lastBatch != batchIndex && pGraph->mBatches[lastBatch].mQueue != queue)
+				addOwnershipTransfer(pGraph, access.mResource, lastBatch, batchIndex);
+			pLastBatch[slot] = batchIndex;
+		}
+	}
+
+	// Hand the imported resources last used by the compute queue back to the graphics queue, in a batch of its own if the graph ends on the compute queue
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+	{
+		const RenderGraphResource& res = pGraph->mResources[i];
+		if (!res.mImported || pLastBatch[i] == RENDER_GRAPH_INVALID_HANDLE || pGraph->mBatches[pLastBatch[i]].mQueue != RENDER_GRAPH_QUEUE_COMPUTE)
+			continue;
+
+		if (pGraph->mBatches.back().mQueue != RENDER_GRAPH_QUEUE_GRAPHICS)
+		{
+			RenderGraphBatch batch = {};
+			batch.mQueue = RENDER_GRAPH_QUEUE_GRAPHICS;
+			pGraph->mBatches.push_back(batch);
+		}
+
+		const uint32_t lastIndex = (uint32_t)pGraph->mBatches.size() - 1;
+		addOwnershipTransfer(pGraph, i, pLastBatch[i], lastIndex);
+		pLastBatch[i] = lastIndex;
+	}
+
+	// Leave imported resources in the state the application expects
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+	{
+		const RenderGraphResource& res = pGraph->mResources[i];
+		if (!res.mImported || pLastBatch[i] == RENDER_GRAPH_INVALID_HANDLE || res.mFinalState == RESOURCE_STATE_UNDEFINED)
+			continue;
+
+		RenderGraphBarrier barrier = { i, res.mFinalState };
+		pGraph->mBatches[pLastBatch[i]].mFinalBarriers.push_back(barrier);
+		if (pStates[i] != res.mFinalState)
+			++stats.mBarrierCount;
+	}
+
+	// The last submission signals the frame fence so it has to wait for the tail of the other queue
+	if (pGraph->mBatches.size() > 1)
+	{
+		const uint32_t lastIndex = (uint32_t)pGraph->mBatches.size() - 1;
+		const RenderGraphQueueType lastQueue = pGraph->mBatches[lastIndex].mQueue;
+		for (uint32_t i = lastIndex; i-- > 0;)
+		{
+			if (pGraph->mBatches[i].mQueue == lastQueue)
+				continue;
+
+			bool waited = false;
+			for (uint32_t j = i + 1; j <= lastIndex && !waited; ++j)
+				waited = pGraph->mBatches[j].mQueue == lastQueue && pGraph->mBatches[j].mWaitBatches.find(i) != pGraph->mBatches[j].mWaitBatches.end();
+
+			if (!waited)
+			{
+				util_add_unique(pGraph->mBatches[lastIndex].mWaitBatches, i);
+				pGraph->mBatches[i].mSignal = true;
+			}
+			break;
+		}
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mBatches.size(); ++i)
+		stats.mCrossQueueSyncCount += (uint32_t)pGraph->mBatches[i].mWaitBatches.size();
+	stats.mSubmitCount = (uint32_t)pGraph->mBatches.size();
+
+	conf_free(pTouched);
+	conf_free(pLastBatch);
+	conf_free(pStates);
+}
+
+/// Within a frame the batches order the reuse of a physical resource by the other queue, but nothing orders the
+/// compute batches of the next frame against the graphics tail of the previous one. Each frame in flight gets its
+/// own physical resources in that case. Frames on a single queue are ordered by the barriers of the first access
+static uint32_t util_transient_set_count(const RenderGraph* pGraph)
+{
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mBatches.size(); ++i)
+	{
+		if (pGraph->mBatches[i].mQueue == RENDER_GRAPH_QUEUE_COMPUTE)
+			return pGraph->mDesc.mFrameCount;
+	}
+	return 1;
+}
+
+/// Releases everything built by rgCompile. The graph keeps its passes and resources and can be compiled again
+static void resetCompiledState(RenderGraph* pGraph)
+{
+	releasePhysicalResources(pGraph);
+	memset(&pGraph->mStats, 0, sizeof(pGraph->mStats));
+
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+	{
+		RenderGraphResource& res = pGraph->mResources[i];
+		res.mFirstPass = RENDER_GRAPH_INVALID_HANDLE;
+		res.mLastPass = 0;
+		res.mPhysicalIndex = RENDER_GRAPH_INVALID_HANDLE;
+		if (!res.mImported)
+			res.pRenderTarget = NULL;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mPasses.size(); ++i)
+	{
+		pGraph->mPasses[i].mBarriers.clear();
+		pGraph->mPasses[i].mCulled = false;
+	}
+
+	pGraph->mCompiled = false;
+}
+
+bool rgCompile(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+
+	resetCompiledState(pGraph);
+
+	cullPasses(pGraph);
+	aliasTransientResources(pGraph);
+	buildBatches(pGraph);
+
+	pGraph->mStats.mPassCount = (uint32_t)pGraph->mPasses.size();
+	pGraph->mTransientSetCount = util_transient_set_count(pGraph);
+	pGraph->mStats.mTransientSetCount = pGraph->mTransientSetCount;
+
+	// The external wait semaphores passed to rgExecute only go to the first submission, which never waits on another batch
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mBatches.size(); ++i)
+	{
+		if (pGraph->mBatches[i].mWaitBatches.size() > MAX_SUBMIT_WAIT_SEMAPHORES)
+		{
+			LOGERRORF("Submission %u waits on %u submissions of the other queue (max %u)", i, (uint32_t)pGraph->mBatches[i].mWaitBatches.size(), (uint32_t)MAX_SUBMIT_WAIT_SEMAPHORES);
+			resetCompiledState(pGraph);
+			return false;
+		}
+	}
+
+	Renderer* pRenderer = pGraph->mDesc.pRenderer;
+	if (pRenderer)
+	{
+		for (uint32_t i = 0; i < (uint32_t)pGraph->mPhysicalResources.size(); ++i)
+		{
+			RenderGraphPhysicalResource& physical = pGraph->mPhysicalResources[i];
+			physical.ppRenderTargets = (RenderTarget**)conf_calloc(pGraph->mTransientSetCount, sizeof(RenderTarget*));
+			for (uint32_t s = 0; s < pGraph->mTransientSetCount; ++s)
+			{
+				addRenderTarget(pRenderer, &physical.mDesc, &physical.ppRenderTargets[s]);
+				if (!physical.ppRenderTargets[s])
+				{
+					LOGERRORF("Failed to create transient render target %u", i);
+					resetCompiledState(pGraph);
+					return false;
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+		{
+			RenderGraphResource& res = pGraph->mResources[i];
+			if (!res.mImported && res.mPhysicalIndex != RENDER_GRAPH_INVALID_HANDLE)
+				res.pRenderTarget = pGraph->mPhysicalResources[res.mPhysicalIndex].ppRenderTargets[0];
+		}
+
+		const uint32_t frameCount = pGraph->mDesc.mFrameCount;
+		for (uint32_t i = 0; i < (uint32_t)pGraph->mBatches.size(); ++i)
+		{
+			RenderGraphBatch& batch = pGraph->mBatches[i];
+			batch.ppCmds = (Cmd**)conf_calloc(frameCount, sizeof(Cmd*));
+			batch.ppSemaphores = (Semaphore**)conf_calloc(frameCount, sizeof(Semaphore*));
+			for (uint32_t f = 0; f < frameCount; ++f)
+			{
+				addCmd(pGraph->pCmdPools[batch.mQueue], false, &batch.ppCmds[f]);
+				if (batch.mSignal)
+					addSemaphore(pRenderer, &batch.ppSemaphores[f]);
+
+				if (!batch.ppCmds[f] || (batch.mSignal && !batch.ppSemaphores[f]))
+				{
+					LOGERRORF("Failed to create the command buffer or semaphore of submission %u", i);
+					resetCompiledState(pGraph);
+					return false;
+				}
+			}
+		}
+	}
+
+	LOGINFOF("RenderGraph: %u/%u passes alive, %u submissions, %u barriers, %u ownership transfers, transient memory %llu KB -> %llu KB (%llu KB saved by aliasing) x %u sets",
+		pGraph->mStats.mPassCount - pGraph->mStats.mCulledPassCount, pGraph->mStats.mPassCount,
+		pGraph->mStats.mSubmitCount, pGraph->mStats.mBarrierCount, pGraph->mStats.mOwnershipTransferCount,
+		(unsigned long long)(pGraph->mStats.mTransientMemoryRequested >> 10),
+		(unsigned long long)(pGraph->mStats.mTransientMemoryAllocated >> 10),
+		(unsigned long long)((pGraph->mStats.mTransientMemoryRequested - pGraph->mStats.mTransientMemoryAllocated) >> 10),
+		pGraph->mStats.mTransientSetCount);
+
+	pGraph->mCompiled = true;
+	return true;
+}
+
+void rgExecute(RenderGraph* pGraph, uint32_t frameIndex, uint32_t waitSemaphoreCount, Semaphore** ppWaitSemaphores, Semaphore* pSignalSemaphore, Fence* pFence)
+{
+	ASSERT(pGraph->mCompiled && "rgCompile must be called after modifying the graph");
+	ASSERT(pGraph->mDesc.pRenderer && "Cannot execute a render graph created without a renderer");
+	ASSERT(frameIndex < pGraph->mDesc.mFrameCount);
+
+	const uint32_t transientSet = frameIndex % pGraph->mTransientSetCount;
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mResources.size(); ++i)
+	{
+		RenderGraphResource& res = pGraph->mResources[i];
+		if (!res.mImported && res.mPhysicalIndex != RENDER_GRAPH_INVALID_HANDLE)
+			res.pRenderTarget = pGraph->mPhysicalResources[res.mPhysicalIndex].ppRenderTargets[transientSet];
+	}
+
+	const uint32_t batchCount = (uint32_t)pGraph->mBatches.size();
+	for (uint32_t b = 0; b < batchCount; ++b)
+	{
+		RenderGraphBatch& batch = pGraph->mBatches[b];
+		Cmd* pCmd = batch.ppCmds[frameIndex];
+
+		beginCmd(pCmd);
+		cmdRenderGraphTransfers(pCmd, pGraph, batch.mAcquires, false);
+		for (uint32_t i = 0; i < (uint32_t)batch.mPasses.size(); ++i)
+		{
+			RenderGraphPass& pass = pGraph->mPasses[batch.mPasses[i]];
+			cmdRenderGraphBarriers(pCmd, pGraph, pass.mBarriers);
+			cmdBeginDebugMarker(pCmd, 1, 1, 0, pass.mName.c_str());
+			if (pass.pFn)
+				pass.pFn(pCmd, pGraph, pass.pUserData);
+			cmdEndDebugMarker(pCmd);
+		}
+		cmdRenderGraphTransfers(pCmd, pGraph, batch.mReleases, true);
+		cmdRenderGraphBarriers(pCmd, pGraph, batch.mFinalBarriers);
+		endCmd(pCmd);
+
+		// rgCompile limits the waits on other batches. The external waits only go to the first batch, which has none
+		const uint32_t externalWaitCount = (b == 0) ? waitSemaphoreCount : 0;
+		const uint32_t maxWaitCount = externalWaitCount + (uint32_t)batch.mWaitBatches.size();
+		if (maxWaitCount > MAX_SUBMIT_WAIT_SEMAPHORES)
+			LOGERRORF("Submission %u waits on %u semaphores (max %u)", b, maxWaitCount, (uint32_t)MAX_SUBMIT_WAIT_SEMAPHORES);
+		ASSERT(maxWaitCount <= MAX_SUBMIT_WAIT_SEMAPHORES);
+
+		Semaphore** pWaitSemaphores = (Semaphore**)alloca(max(1U, maxWaitCount) * sizeof(Semaphore*));
+		Semaphore* pSignalSemaphores[MAX_SUBMIT_SIGNAL_SEMAPHORES];
+		uint32_t waitCount = 0;
+		uint32_t signalCount = 0;
+
+		for (uint32_t i = 0; i < externalWaitCount; ++i)
+			pWaitSemaphores[waitCount++] = ppWaitSemaphores[i];
+		for (uint32_t i = 0; i < (uint32_t)batch.mWaitBatches.size(); ++i)
+			pWaitSemaphores[waitCount++] = pGraph->mBatches[batch.mWaitBatches[i]].ppSemaphores[frameIndex];
+
+		if (batch.mSignal)
+			pSignalSemaphores[signalCount++] = batch.ppSemaphores[frameIndex];
+		const bool lastBatch = (b == batchCount - 1);
+		if (lastBatch && pSignalSemaphore)
+			pSignalSemaphores[signalCount++] = pSignalSemaphore;
+
+		queueSubmit(util_get_queue(pGraph, batch.mQueue), 1, &pCmd, lastBatch ? pFence : NULL, waitCount, pWaitSemaphores, signalCount, pSignalSemaphores);
+	}
+}
+
+RenderTarget* rgGetRenderTarget(RenderGraph* pGraph, RenderGraphHandle resource)
+{
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	return pGraph->mResources[resource].pRenderTarget;
+}
+
+Buffer* rgGetBuffer(RenderGraph* pGraph, RenderGraphHandle resource)
+{
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	return pGraph->mResources[resource].pBuffer;
+}
+
+bool rgIsPassCulled(RenderGraph* pGraph, uint32_t pass)
+{
+	ASSERT(pass < (uint32_t)pGraph->mPasses.size());
+	return pGraph->mPasses[pass].mCulled;
+}
+
+void rgGetStats(RenderGraph* pGraph, RenderGraphStats* pStats)
+{
+	ASSERT(pStats);
+	*pStats = pGraph->mStats;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// ***************************************************
+// NOTE:
+// "IRenderer.h" MUST be included before this header!
+// ***************************************************
+
+#pragma once
+
+/************************************************************************/
+// Render Graph
+// Passes declare the resources they read and write. The graph culls passes
+// which do not contribute to an output, derives the resource barriers and
+// the semaphores needed between the graphics and async compute queue and
+// lets transient render targets with non overlapping lifetimes share the
+// same physical render target.
+//
+// Usage:
+//   addRenderGraph         (once, in Load)
+//   rgAdd* / rgImport*     (declare resources and passes)
+//   rgCompile              (cull, alias, build barriers and submissions)
+//   rgExecute              (every frame)
+//
+// rgCompile does not touch the renderer when RenderGraphDesc::pRenderer is NULL.
+// This allows validating a graph (culling, aliasing, barrier count) headless.
+// If rgCompile fails, everything it built is released and the graph is left uncompiled.
+//
+// Resources used by both queues are released by one queue and acquired by the other.
+// Imported resources belong to the graphics queue before and after the graph.
+// Graphs using both queues allocate their transient render targets once per frame in flight,
+// since nothing orders the compute queue of one frame against the graphics queue of the previous one.
+/************************************************************************/
+
+typedef uint32_t RenderGraphHandle;
+#define RENDER_GRAPH_INVALID_HANDLE 0xFFFFFFFFU
+
+typedef enum RenderGraphQueueType
+{
+	RENDER_GRAPH_QUEUE_GRAPHICS = 0,
+	RENDER_GRAPH_QUEUE_COMPUTE,
+	RENDER_GRAPH_QUEUE_COUNT,
+} RenderGraphQueueType;
+
+struct RenderGraph;
+
+/// Called during rgExecute to record the commands of a pass
+/// All barriers for the resources declared by the pass have already been recorded into pCmd
+typedef void(*RenderGraphPassFn)(Cmd* pCmd, struct RenderGraph* pGraph, void* pUserData);
+
+typedef struct RenderGraphDesc
+{
+	/// Can be NULL to only compile the graph (no physical resources or command buffers are created)
+	Renderer*   pRenderer;
+	Queue*	  pGraphicsQueue;
+	/// Optional. If NULL compute passes are recorded on the graphics queue
+	Queue*	  pComputeQueue;
+	/// Number of frames in flight (one command buffer and semaphore set per frame)
+	uint32_t	mFrameCount;
+} RenderGraphDesc;
+
+typedef struct RenderGraphStats
+{
+	uint32_t	mPassCount;
+	uint32_t	mCulledPassCount;
+	uint32_t	mTransientResourceCount;
+	uint32_t	mPhysicalResourceCount;
+	uint32_t	mBarrierCount;
+	uint32_t	mSubmitCount;
+	uint32_t	mCrossQueueSyncCount;
+	/// Resources handed over between the graphics and the compute queue (queue family ownership transfers on Vulkan)
+	uint32_t	mOwnershipTransferCount;
+	/// Memory needed by all transient render targets if each of them had its own allocation
+	uint64_t	mTransientMemoryRequested;
+	/// Memory actually allocated for one set of transient render targets after aliasing
+	uint64_t	mTransientMemoryAllocated;
+	/// Highest amount of transient memory alive at any pass
+	uint64_t	mTransientMemoryPeak;
+	/// Number of transient render target sets: one per frame in flight if the graph uses the compute queue, otherwise one
+	uint32_t	mTransientSetCount;
+} RenderGraphStats;
+
+void addRenderGraph(const RenderGraphDesc* pDesc, struct RenderGraph** ppGraph);
+void removeRenderGraph(struct RenderGraph* pGraph);
+/// Removes all passes and resources. Physical resources are released on the next rgCompile
+void resetRenderGraph(struct RenderGraph* pGraph);
+
+/// Resources owned by the application. The graph transitions them from initialState and leaves them in finalState
+RenderGraphHandle rgImportRenderTarget(struct RenderGraph* pGraph, const char* pName, RenderTarget* pRenderTarget, ResourceState initialState, ResourceState finalState);
+RenderGraphHandle rgImportBuffer(struct RenderGraph* pGraph, const char* pName, Buffer* pBuffer, ResourceState initialState, ResourceState finalState);
+/// Swap an imported resource (e.g. the current swapchain image) before rgExecute
+void rgSetImportedRenderTarget(struct RenderGraph* pGraph, RenderGraphHandle handle, RenderTarget* pRenderTarget);
+void rgSetImportedBuffer(struct RenderGraph* pGraph, RenderGraphHandle handle, Buffer* pBuffer);
+
+/// Transient render target owned by the graph. Its contents are undefined before the first pass writing it
+RenderGraphHandle rgAddRenderTarget(struct RenderGraph* pGraph, const char* pName, const RenderTargetDesc* pDesc);
+
+uint32_t rgAddPass(struct RenderGraph* pGraph, const char* pName, RenderGraphQueueType queue, RenderGraphPassFn pFn, void* pUserData);
+void rgPassRead(struct RenderGraph* pGraph, uint32_t pass, RenderGraphHandle resource, ResourceState state);
+void rgPassWrite(struct RenderGraph* pGraph, uint32_t pass, RenderGraphHandle resource, ResourceState state);
+/// Passes contributing (directly or indirectly) to an output are never culled
+void rgMarkOutput(struct RenderGraph* pGraph, RenderGraphHandle resource);
+
+/// Returns false and releases everything built so far if a physical resource cannot be created
+bool rgCompile(struct RenderGraph* pGraph);
+/// Records and submits all passes. ppWaitSemaphores are waited on by the first submission,
+/// pSignalSemaphore and pFence are signaled by the last one
+void rgExecute(struct RenderGraph* pGraph, uint32_t frameIndex, uint32_t waitSemaphoreCount, Semaphore** ppWaitSemaphores, Semaphore* pSignalSemaphore, Fence* pFence);
+
+RenderTarget* rgGetRenderTarget(struct RenderGraph* pGraph, RenderGraphHandle resource);
+Buffer* rgGetBuffer(struct RenderGraph* pGraph, RenderGraphHandle resource);
+bool rgIsPassCulled(struct RenderGraph* pGraph, uint32_t pass);
+void rgGetStats(struct RenderGraph* pGraph, RenderGraphStats* pStats);
@@ -64,6 +64,8 @@ extern const RendererShaderDefinesDesc get_renderer_shaderdefines(Renderer* pRen
 
 #define MAX_LOAD_THREADS 3U
 #define MAX_COPY_THREADS 1U
+// Texture files addResources keeps reading ahead of the one it uploads
+#define MAX_TEXTURE_FILE_READS 32U
 //////////////////////////////////////////////////////////////////////////
 // Resource Loader Structures
 //////////////////////////////////////////////////////////////////////////
@@ -75,6 +77,27 @@ typedef struct MappedMemoryRange
 	uint64_t mSize;
 } MappedMemoryRange;
 
+/// Batched buffer update waiting for flushResourceUpdates. The data is copied into ResourceLoader::mPendingUpdateData.
+typedef struct PendingBufferUpdate
+{
+	Buffer* pBuffer;
+	uint64_t mDstOffset;
+	uint64_t mSize;
+	uint64_t mDataOffset;
+	/// Submission order. Later updates overwrite earlier ones where they overlap
+	uint32_t mIndex;
+} PendingBufferUpdate;
+
+/// Contents of a texture file read by addResources
+typedef struct TextureFileRead
+{
+	AsyncFileHandle pFile;
+	AsyncReadToken mToken;
+	void* pData;
+	uint32_t mSize;
+	bool mSuccess;
+} TextureFileRead;
+
 typedef struct ResourceLoader
 {
 	Renderer* pRenderer;
@@ -90,6 +113,9 @@ typedef struct ResourceLoader
 	tinystl::vector<void*>  mTempStagingData;
 #endif
 
+	tinystl::vector<PendingBufferUpdate> mPendingBufferUpdates;
+	tinystl::vector<uint8_t> mPendingUpdateData;
+
 	bool mOpen = false;
 } ResourceLoader;
 
@@ -152,6 +178,8 @@ static void removeResourceLoader(ResourceLoader* pLoader)
 	}
 
 	pLoader->mTempStagingBuffers.~vector();
+	pLoader->mPendingBufferUpdates.~vector();
+	pLoader->mPendingUpdateData.~vector();
 
 	conf_free(pLoader);
 }
@@ -440,13 +468,19 @@ static void cmd_upload_texture_data(Cmd* pCmd, ResourceLoader* pLoader, Texture*
 #endif
 }
 
-static void cmdLoadTextureFile(Cmd* pCmd, TextureLoadDesc* pTextureFileDesc, ResourceLoader* pLoader)
+static void cmdLoadTextureFile(Cmd* pCmd, TextureLoadDesc* pTextureFileDesc, ResourceLoader* pLoader, const TextureFileRead* pFileRead)
 {
 	ASSERT (pTextureFileDesc->ppTexture);
 
 	Image img;
 
-	bool res = img.loadImage(pTextureFileDesc->pFilename, pTextureFileDesc->mUseMipmaps, imageLoadAllocationFunc, pLoader, pTextureFileDesc->mRoot);
+	// Files read by addResources are decoded from memory. Loading the file covers the rest, including the iOS fallback to uncompressed images
+	bool res = false;
+	const char* extension = strrchr(pTextureFileDesc->pFilename, '.');
+	if (pFileRead && extension)
+		res = img.loadFromMemory(pFileRead->pData, pFileRead->mSize, pTextureFileDesc->mUseMipmaps, extension, imageLoadAllocationFunc, pLoader);
+	if (!res)
+		res = img.loadImage(pTextureFileDesc->pFilename, pTextureFileDesc->mUseMipmaps, imageLoadAllocationFunc, pLoader, pTextureFileDesc->mRoot);
 	if (res)
 	{
 		TextureDesc desc = {};
@@ -474,7 +508,7 @@ static void cmdLoadTextureFile(Cmd* pCmd, TextureLoadDesc* pTextureFileDesc, Res
 		}
 
 		wchar_t debugName[MAX_PATH] = {};
-		tinystl::string filename = FileSystem::GetFileNameAndExtension(img.GetName());
+		tinystl::string filename = FileSystem::GetFileNameAndExtension(pTextureFileDesc->pFilename);
 		mbstowcs(debugName, filename.c_str(), min((size_t)MAX_PATH, filename.size()));
 		desc.pDebugName = debugName;
 
@@ -571,7 +605,7 @@ static void cmdLoadEmptyTexture(Cmd* pCmd, TextureLoadDesc* pEmptyTexture, Resou
 	}
 }
 
-static void cmdLoadResource(Cmd* pCmd, ResourceLoadDesc* pResourceLoadDesc, ResourceLoader* pLoader)
+static void cmdLoadResource(Cmd* pCmd, ResourceLoadDesc* pResourceLoadDesc, ResourceLoader* pLoader, const TextureFileRead* pFileRead = NULL)
 {
 	switch (pResourceLoadDesc->mType)
 	{
@@ -580,7 +614,7 @@ static void cmdLoadResource(Cmd* pCmd, ResourceLoadDesc* pResourceLoadDesc, Reso
 		break;
 	case RESOURCE_TYPE_TEXTURE:
 		if (pResourceLoadDesc->tex.pFilename)
-			cmdLoadTextureFile(pCmd, &pResourceLoadDesc->tex, pLoader);
+			cmdLoadTextureFile(pCmd, &pResourceLoadDesc->tex, pLoader, pFileRead);
 		else if (pResourceLoadDesc->tex.pImage)
 			cmdLoadTextureImage(pCmd, &pResourceLoadDesc->tex, pLoader);
 		else
@@ -655,6 +689,153 @@ static void cmdUpdateResource(Cmd* pCmd, BufferUpdateDesc* pBufferUpdate, Resour
 	}
 }
 
+/// Defers a buffer update which needs a GPU copy until flushResourceUpdates
+static void queueBufferUpdate(BufferUpdateDesc* pBufferUpdate, ResourceLoader* pLoader)
+{
+	Buffer* pBuffer = pBufferUpdate->pBuffer;
+	const uint64_t bufferSize = (pBufferUpdate->mSize > 0) ? pBufferUpdate->mSize : pBuffer->mDesc.mSize;
+	const uint64_t alignment = pBuffer->mDesc.mDescriptors & DESCRIPTOR_TYPE_UNIFORM_BUFFER ? pLoader->pRenderer->pActiveGpuSettings->mUniformBufferAlignment : 1;
+
+	PendingBufferUpdate update = {};
+	update.pBuffer = pBuffer;
+	update.mDstOffset = round_up_64(pBufferUpdate->mDstOffset, alignment);
+	update.mSize = bufferSize;
+	update.mDataOffset = pLoader->mPendingUpdateData.size();
+	update.mIndex = (uint32_t)pLoader->mPendingBufferUpdates.size();
+	pLoader->mPendingBufferUpdates.push_back(update);
+
+	pLoader->mPendingUpdateData.resize((size_t)(update.mDataOffset + bufferSize));
+	uint8_t* pDst = pLoader->mPendingUpdateData.data() + update.mDataOffset;
+	if (pBufferUpdate->pData)
+		memcpy(pDst, (uint8_t*)(pBufferUpdate->pData) + pBufferUpdate->mSrcOffset, bufferSize);
+	else
+		memset(pDst, 0, bufferSize);
+}
+
+static int comparePendingBufferUpdates(const PendingBufferUpdate& lhs, const PendingBufferUpdate& rhs)
+{
+	if (lhs.pBuffer != rhs.pBuffer)
+		return lhs.pBuffer < rhs.pBuffer ? -1 : 1;
+	if (lhs.mDstOffset != rhs.mDstOffset)
+		return lhs.mDstOffset < rhs.mDstOffset ? -1 : 1;
+	return (int)lhs.mIndex - (int)rhs.mIndex;
+}
+
+static int comparePendingBufferUpdateOrder(const PendingBufferUpdate& lhs, const PendingBufferUpdate& rhs)
+{
+	return (int)lhs.mIndex - (int)rhs.mIndex;
+}
+
+/// Writes the part [partStart, partEnd) of a merged range. pUpdates are in submission order where they overlap
+static void writeBufferUpdates(uint8_t* pDst, uint64_t partStart, uint64_t partEnd, const PendingBufferUpdate* pUpdates, uint32_t updateCount, const uint8_t* pData)
+{
+	for (uint32_t k = 0; k < updateCount; ++k)
+	{
+		const uint64_t start = max(pUpdates[k].mDstOffset, partStart);
+		const uint64_t end = min(pUpdates[k].mDstOffset + pUpdates[k].mSize, partEnd);
+		if (start < end)
+			memcpy(pDst + (start - partStart), pData + pUpdates[k].mDataOffset + (start - pUpdates[k].mDstOffset), (size_t)(end - start));
+	}
+}
+
+/// Submits the batch recorded so far and waits for it, so the staging buffer can be filled again from its start
+static void restartBatchCopyCmd(Cmd* pCmd, ResourceLoader* pLoader, Queue* pQueue, Fence* pFence)
+{
+#if defined(DIRECT3D11)
+	unmapBuffer(pLoader->pRenderer, pLoader->pStagingBuffer);
+#endif
+	endCmd(pCmd);
+	queueSubmit(pQueue, 1, &pCmd, pFence, 0, 0, 0, 0);
+	waitForFences(pQueue, 1, &pFence, false);
+	cleanupResourceLoader(pLoader);
+	pLoader->mCurrentPos = 0;
+
+	beginCmd(pCmd);
+#if defined(DIRECT3D11)
+	mapBuffer(pLoader->pRenderer, pLoader->pStagingBuffer, NULL);
+#endif
+}
+
+/// Merges adjacent and overlapping pending updates of the same buffer and records one copy per merged range.
+/// The ranges are packed into the staging buffer. When it is full the batch is submitted and waited for before
+/// the staging buffer is reused, and ranges larger than the whole staging buffer are copied in parts
+static void cmdFlushBufferUpdates(Cmd* pCmd, ResourceLoader* pLoader, Queue* pQueue, Fence* pFence, ResourceUpdateStats* pStats)
+{
+	tinystl::vector<PendingBufferUpdate>& updates = pLoader->mPendingBufferUpdates;
+	if (updates.empty())
+		return;
+
+	const uint32_t updateCount = (uint32_t)updates.size();
+	const uint64_t stagingSize = pLoader->pStagingBuffer->mDesc.mSize;
+	updates.sort(comparePendingBufferUpdates);
+
+#if defined(DIRECT3D11)
+	mapBuffer(pLoader->pRenderer, pLoader->pStagingBuffer, NULL);
+#endif
+	tinystl::vector<PendingBufferUpdate> rangeUpdates;
+	for (uint32_t i = 0; i < updateCount;)
+	{
+		const uint64_t rangeStart = updates[i].mDstOffset;
+		uint64_t rangeEnd = rangeStart + updates[i].mSize;
+		uint32_t j = i + 1;
+		while (j < updateCount && updates[j].pBuffer == updates[i].pBuffer && updates[j].mDstOffset <= rangeEnd)
+		{
+			rangeEnd = max(rangeEnd, updates[j].mDstOffset + updates[j].mSize);
+			++j;
+		}
+
+		// Updates inside the range are sorted by offset, so overlaps need to be resolved by submission order
+		bool overlapping = false;
+		for (uint32_t k = i + 1; k < j && !overlapping; ++k)
+			overlapping = updates[k].mDstOffset < updates[k - 1].mDstOffset + updates[k - 1].mSize;
+
+		const PendingBufferUpdate* pRangeUpdates = updates.data() + i;
+		if (overlapping)
+		{
+			rangeUpdates = tinystl::vector<PendingBufferUpdate>(updates.begin() + i, updates.begin() + j);
+			rangeUpdates.sort(comparePendingBufferUpdateOrder);
+			pRangeUpdates = rangeUpdates.data();
+		}
+
+		Buffer* pBuffer = updates[i].pBuffer;
+		for (uint64_t partStart = rangeStart; partStart < rangeEnd;)
+		{
+			const uint64_t stagingPos = round_up_64(pLoader->mCurrentPos, RESOURCE_BUFFER_ALIGNMENT);
+			const uint64_t available = stagingPos < stagingSize ? stagingSize - stagingPos : 0;
+			if (available < rangeEnd - partStart && pLoader->mCurrentPos > 0)
+			{
+				// Earlier copies of the batch still read the staging buffer
+				restartBatchCopyCmd(pCmd, pLoader, pQueue, pFence);
+				++pStats->mBatchRestartCount;
+				continue;
+			}
+
+			const uint64_t partEnd = partStart + min(rangeEnd - partStart, available);
+			MappedMemoryRange block = consumeResourceUpdateMemory(partEnd - partStart, RESOURCE_BUFFER_ALIGNMENT, pLoader);
+			ASSERT(block.pData);
+
+			writeBufferUpdates((uint8_t*)block.pData, partStart, partEnd, pRangeUpdates, j - i, pLoader->mPendingUpdateData.data());
+			cmdUpdateBuffer(pCmd, block.mOffset, pBuffer->mPositionInHeap + partStart, partEnd - partStart, block.pBuffer, pBuffer);
+
+			++pStats->mBufferCopyCount;
+			pStats->mBufferCopySize += partEnd - partStart;
+			partStart = partEnd;
+		}
+
+		i = j;
+	}
+#if defined(DIRECT3D11)
+	unmapBuffer(pLoader->pRenderer, pLoader->pStagingBuffer);
+#endif
+
+	for (uint32_t i = 0; i < updateCount; ++i)
+		pStats->mBufferUpdateSize += updates[i].mSize;
+	pStats->mBufferUpdateCount += updateCount;
+
+	updates.clear();
+	pLoader->mPendingUpdateData.clear();
+}
+
 static void cmdUpdateResource(Cmd* pCmd, TextureUpdateDesc* pTextureUpdate, ResourceLoader* pLoader)
 {
 #if defined(DIRECT3D11)
@@ -688,11 +869,15 @@ static Fence* pWaitFence[MAX_GPUS] = { NULL };
 
 static ResourceLoader* pMainResourceLoader = NULL;
 static ThreadPool* pThreadPool = NULL;
+static AsyncFileReader* pFileReader = NULL;
+// Serializes addResources and the creation of pFileReader, which starts its reader threads on first use
+static Mutex gFileReaderMutex;
 static tinystl::vector <ResourceThread*> gResourceThreads;
 static tinystl::vector <ResourceLoadDesc*> gResourceQueue;
 static Mutex gResourceQueueMutex;
 static bool gFinishLoading = false;
 static bool gUseThreads = false;
+static ResourceUpdateStats gResourceUpdateStats = {};
 //////////////////////////////////////////////////////////////////////////
 // Resource Loader Implementation
 //////////////////////////////////////////////////////////////////////////
@@ -787,6 +972,13 @@ void removeResourceLoaderInterface(Renderer* pRenderer)
 	gResourceThreads.clear();
 	removeResourceLoader(pMainResourceLoader);
 
+	if (pFileReader)
+	{
+		pFileReader->~AsyncFileReader();
+		conf_free(pFileReader);
+		pFileReader = NULL;
+	}
+
 	for (uint32_t i = 0; i < MAX_GPUS; ++i)
 	{
 		if (pCopyQueue[i])
@@ -796,6 +988,50 @@ void removeResourceLoaderInterface(Renderer* pRenderer)
 	}
 }
 
+/// Loads the resource on the calling thread and waits until it is uploaded
+static void loadResource(ResourceLoadDesc* pResourceLoadDesc, const TextureFileRead* pFileRead)
+{
+	uint32_t nodeIndex = 0;
+	if (pResourceLoadDesc->mType == RESOURCE_TYPE_BUFFER)
+	{
+		nodeIndex = pResourceLoadDesc->buf.mDesc.mNodeIndex;
+	}
+	else if (pResourceLoadDesc->mType == RESOURCE_TYPE_TEXTURE)
+	{
+		if (pResourceLoadDesc->tex.pFilename || pResourceLoadDesc->tex.pImage)
+			nodeIndex = pResourceLoadDesc->tex.mNodeIndex;
+		else
+			nodeIndex = pResourceLoadDesc->tex.pDesc->mNodeIndex;
+	}
+
+	gResourceQueueMutex.Acquire();
+	if (!pCopyQueue[nodeIndex])
+	{
+		QueueDesc queueDesc = {};
+		queueDesc.mType = CMD_POOL_COPY;
+		queueDesc.mNodeIndex = nodeIndex;
+		addQueue(pMainResourceLoader->pRenderer, &queueDesc, &pCopyQueue[nodeIndex]);
+		addCmdPool(pMainResourceLoader->pRenderer, pCopyQueue[nodeIndex], false, &pMainResourceLoader->pCopyCmdPool[nodeIndex]);
+		addCmd(pMainResourceLoader->pCopyCmdPool[nodeIndex], false, &pMainResourceLoader->pCopyCmd[nodeIndex]);
+	}
+	if (!pWaitFence[nodeIndex])
+		addFence(pMainResourceLoader->pRenderer, &pWaitFence[nodeIndex]);
+
+	Queue* pQueue = pCopyQueue[nodeIndex];
+	Cmd* pCmd = pMainResourceLoader->pCopyCmd[nodeIndex];
+	Fence* pFence = pWaitFence[nodeIndex];
+	beginCmd(pCmd);
+	cmdLoadResource(pCmd, pResourceLoadDesc, pMainResourceLoader, pFileRead);
+	endCmd(pCmd);
+
+	queueSubmit(pQueue, 1, &pCmd, pFence, 0, 0, 0, 0);
+	waitForFences(pQueue, 1, &pFence, false);
+	cleanupResourceLoader(pMainResourceLoader);
+
+	pMainResourceLoader->mCurrentPos = 0;
+	gResourceQueueMutex.Release();
+}
+
 void addResource(ResourceLoadDesc* pResourceLoadDesc, bool threaded /* = false */)
 {
 #ifndef DIRECT3D11 // We can dismiss this msg for D3D11 as we will always load single threaded
@@ -807,45 +1043,7 @@ void addResource(ResourceLoadDesc* pResourceLoadDesc, bool threaded /* = false *
 
 	if (!threaded || !gUseThreads)
 	{
-		uint32_t nodeIndex = 0;
-		if (pResourceLoadDesc->mType == RESOURCE_TYPE_BUFFER)
-		{
-			nodeIndex = pResourceLoadDesc->buf.mDesc.mNodeIndex;
-		}
-		else if (pResourceLoadDesc->mType == RESOURCE_TYPE_TEXTURE)
-		{
-			if (pResourceLoadDesc->tex.pFilename || pResourceLoadDesc->tex.pImage)
-				nodeIndex = pResourceLoadDesc->tex.mNodeIndex;
-			else
-				nodeIndex = pResourceLoadDesc->tex.pDesc->mNodeIndex;
-		}
-
-		gResourceQueueMutex.Acquire();
-		if (!pCopyQueue[nodeIndex])
-		{
-			QueueDesc queueDesc = {};
-			queueDesc.mType = CMD_POOL_COPY;
-			queueDesc.mNodeIndex = nodeIndex;
-			addQueue(pMainResourceLoader->pRenderer, &queueDesc, &pCopyQueue[nodeIndex]);
-			addCmdPool(pMainResourceLoader->pRenderer, pCopyQueue[nodeIndex], false, &pMainResourceLoader->pCopyCmdPool[nodeIndex]);
-			addCmd(pMainResourceLoader->pCopyCmdPool[nodeIndex], false, &pMainResourceLoader->pCopyCmd[nodeIndex]);
-		}
-		if (!pWaitFence[nodeIndex])
-			addFence(pMainResourceLoader->pRenderer, &pWaitFence[nodeIndex]);
-
-		Queue* pQueue = pCopyQueue[nodeIndex];
-		Cmd* pCmd = pMainResourceLoader->pCopyCmd[nodeIndex];
-		Fence* pFence = pWaitFence[nodeIndex];
-		beginCmd(pCmd);
-		cmdLoadResource(pCmd, pResourceLoadDesc, pMainResourceLoader);
-		endCmd(pCmd);
-
-		queueSubmit(pQueue, 1, &pCmd, pFence, 0, 0, 0, 0);
-		waitForFences(pQueue, 1, &pFence, false);
-		cleanupResourceLoader(pMainResourceLoader);
-
-		pMainResourceLoader->mCurrentPos = 0;
-		gResourceQueueMutex.Release();
+		loadResource(pResourceLoadDesc, NULL);
 	}
 	else
 	{
@@ -893,6 +1091,70 @@ void addResource(TextureLoadDesc* pTexture, bool threaded)
 	}
 }
 
+static void textureFileReadCallback(void* pUserData, void* pDst, size_t bytesRead, bool success)
+{
+	UNREF_PARAM(pDst);
+	TextureFileRead* pRead = (TextureFileRead*)pUserData;
+	pRead->mSuccess = success && bytesRead == pRead->mSize;
+}
+
+static void readTextureFile(TextureLoadDesc* pTexture, TextureFileRead* pRead)
+{
+	if (!pTexture->pFilename)
+		return;
+
+	// Files which cannot be read here are left to the regular loading, which reports the error
+	AsyncFileHandle file = pFileReader->OpenFile(pTexture->pFilename, pTexture->mRoot);
+	if (!file)
+		return;
+
+	const uint64_t fileSize = pFileReader->GetFileSize(file);
+	if (fileSize == 0 || fileSize > UINT32_MAX)
+	{
+		pFileReader->CloseFile(file);
+		return;
+	}
+
+	pRead->pFile = file;
+	pRead->pData = conf_malloc((size_t)fileSize);
+	pRead->mSize = (uint32_t)fileSize;
+	pRead->mToken = pFileReader->ReadAsync(file, 0, (size_t)fileSize, pRead->pData, textureFileReadCallback, pRead);
+}
+
+void addResources(uint32_t textureCount, TextureLoadDesc* pTextures)
+{
+	MutexLock lock(gFileReaderMutex);
+	if (!pFileReader)
+	{
+		pFileReader = conf_placement_new<AsyncFileReader>(conf_calloc(1, sizeof(AsyncFileReader)));
+		pFileReader->Initialize();
+	}
+
+	TextureFileRead* pReads = (TextureFileRead*)conf_calloc(textureCount, sizeof(TextureFileRead));
+	uint32_t readCount = 0;
+
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		// Keeps the reads of the next files in flight while this texture is decoded and uploaded
+		for (; readCount < textureCount && readCount < i + MAX_TEXTURE_FILE_READS; ++readCount)
+			readTextureFile(&pTextures[readCount], &pReads[readCount]);
+		pFileReader->Submit();
+
+		TextureFileRead* pRead = &pReads[i];
+		if (pRead->mToken)
+		{
+			pFileReader->Wait(pRead->mToken);
+			pFileReader->CloseFile(pRead->pFile);
+		}
+
+		ResourceLoadDesc resourceDesc = pTextures[i];
+		loadResource(&resourceDesc, pRead->mSuccess ? pRead : NULL);
+		conf_free(pRead->pData);
+	}
+
+	conf_free(pReads);
+}
+
 void updateResource(BufferUpdateDesc* pBufferUpdate, bool batch /* = false*/)
 {
 	if (pBufferUpdate->pBuffer->mDesc.mMemoryUsage == RESOURCE_MEMORY_USAGE_GPU_ONLY || pBufferUpdate->pBuffer->mDesc.mMemoryUsage == RESOURCE_MEMORY_USAGE_GPU_TO_CPU)
@@ -914,15 +1176,7 @@ void updateResource(BufferUpdateDesc* pBufferUpdate, bool batch /* = false*/)
 		}
 		else
 		{
-			Cmd* pCmd = pMainResourceLoader->pBatchCopyCmd[0];
-
-			if (!pMainResourceLoader->mOpen)
-			{
-				beginCmd(pCmd);
-				pMainResourceLoader->mOpen = true;
-			}
-
-			cmdUpdateResource(pCmd, pBufferUpdate, pMainResourceLoader);
+			queueBufferUpdate(pBufferUpdate, pMainResourceLoader);
 		}
 	}
 	else
@@ -958,6 +1212,8 @@ void updateResource(TextureUpdateDesc* pTextureUpdate, bool batch)
 			pMainResourceLoader->mOpen = true;
 		}
 
+		// Keep the texture update after the buffer updates batched before it
+		cmdFlushBufferUpdates(pCmd, pMainResourceLoader, pCopyQueue[0], pWaitFence[0], &gResourceUpdateStats);
 		cmdUpdateResource(pCmd, pTextureUpdate, pMainResourceLoader);
 	}
 }
@@ -982,18 +1238,42 @@ void updateResources(uint32_t resourceCount, ResourceUpdateDesc* pResources)
 
 void flushResourceUpdates()
 {
+	if (!pMainResourceLoader->mPendingBufferUpdates.empty())
+	{
+		if (!pMainResourceLoader->mOpen)
+		{
+			beginCmd(pMainResourceLoader->pBatchCopyCmd[0]);
+			pMainResourceLoader->mOpen = true;
+		}
+
+		cmdFlushBufferUpdates(pMainResourceLoader->pBatchCopyCmd[0], pMainResourceLoader, pCopyQueue[0], pWaitFence[0], &gResourceUpdateStats);
+	}
+
 	if (pMainResourceLoader->mOpen)
 	{
+		++gResourceUpdateStats.mFlushCount;
 		endCmd(pMainResourceLoader->pBatchCopyCmd[0]);
 
 		queueSubmit(pCopyQueue[0], 1, &pMainResourceLoader->pBatchCopyCmd[0], pWaitFence[0], 0, 0, 0, 0);
 		waitForFences(pCopyQueue[0], 1, &pWaitFence[0], false);
 
 		cleanupResourceLoader(pMainResourceLoader);
+		pMainResourceLoader->mCurrentPos = 0;
 		pMainResourceLoader->mOpen = false;
 	}
 }
 
+void getResourceUpdateStats(ResourceUpdateStats* pStats)
+{
+	ASSERT(pStats);
+	*pStats = gResourceUpdateStats;
+}
+
+void resetResourceUpdateStats()
+{
+	memset(&gResourceUpdateStats, 0, sizeof(gResourceUpdateStats));
+}
+
 void removeResource(Texture* pTexture)
 {
 	removeTexture(pMainResourceLoader->pRenderer, pTexture);
@@ -1141,7 +1421,7 @@ void vk_compileShader(Renderer* pRenderer, ShaderTarget target, const tinystl::s
 		File file = {};
 		file.Open(outFile, FileMode::FM_ReadBinary, FSRoot::FSR_Absolute);
 		ASSERT(file.IsOpen());
-		pByteCode->resize(file.GetSize());
+		pByteCode->resize((size_t)file.GetSize());
 		memcpy(pByteCode->data(), file.ReadText().c_str(), pByteCode->size());
 		file.Close();
 	}
@@ -1221,7 +1501,7 @@ void mtl_compileShader(Renderer* pRenderer, const tinystl::string& fileName, con
 			File file = {};
 			file.Open(outFile, FileMode::FM_ReadBinary, FSRoot::FSR_Absolute);
 			ASSERT(file.IsOpen());
-			pByteCode->resize(file.GetSize());
+			pByteCode->resize((size_t)file.GetSize());
 			memcpy(pByteCode->data(), file.ReadText().c_str(), pByteCode->size());
 			file.Close();
 		}
@@ -1347,7 +1627,7 @@ bool check_for_byte_code(const tinystl::string& binaryShaderName, uint32_t sourc
 		return false;
 	}
 
-	byteCode.resize(file.GetSize());
+	byteCode.resize((size_t)file.GetSize());
 	memcpy(byteCode.data(), file.ReadText().c_str(), byteCode.size());
 	return true;
 }
@@ -124,17 +124,38 @@ typedef struct ShaderLoadDesc
 	ShaderTarget mTarget;
 } ShaderLoadDesc;
 
+typedef struct ResourceUpdateStats
+{
+	/// Number of batched buffer updates recorded with updateResource(pBuffer, true)
+	uint32_t mBufferUpdateCount;
+	/// Number of copy commands emitted for them after coalescing adjacent and overlapping ranges
+	uint32_t mBufferCopyCount;
+	uint64_t mBufferUpdateSize;
+	uint64_t mBufferCopySize;
+	uint32_t mFlushCount;
+	/// Number of times a flush filled the staging buffer and had to submit and wait before reusing it
+	uint32_t mBatchRestartCount;
+} ResourceUpdateStats;
+
 void initResourceLoaderInterface(Renderer* pRenderer, uint64_t memoryBudget = DEFAULT_MEMORY_BUDGET, bool useThreads = false);
 void removeResourceLoaderInterface(Renderer* pRenderer);
 
 void addResource(BufferLoadDesc* pBuffer, bool threaded = false);
 void addResource(TextureLoadDesc* pTexture, bool threaded = false);
+/// Loads the texture files on the calling thread. Their files are read asynchronously, ahead of the texture being decoded and uploaded.
+/// The file reader threads are started by the first call. Concurrent calls are serialized
+void addResources(uint32_t textureCount, TextureLoadDesc* pTextures);
 
 void updateResource(BufferUpdateDesc* pBuffer, bool batch = false);
 void updateResource(TextureUpdateDesc* pTexture, bool batch = false);
 void updateResources(uint32_t resourceCount, ResourceUpdateDesc* pResources);
 
+/// Submits all batched updates. Batched buffer updates to the same buffer are coalesced into as few copies as possible.
+/// Batched texture updates are recorded after the buffer updates batched before them
 void flushResourceUpdates();
+/// Counters are accumulated until resetResourceUpdateStats is called
+void getResourceUpdateStats(ResourceUpdateStats* pStats);
+void resetResourceUpdateStats();
 
 void removeResource(Buffer* pBuffer);
 void removeResource(Texture* pTexture);
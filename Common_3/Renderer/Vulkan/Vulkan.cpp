@@ -2486,6 +2486,42 @@ namespace vk {
 		SAFE_FREE(pFence);
 	}
 
+	void addTimelineFence(Renderer* pRenderer, Queue* pQueue, TimelineFence** ppFence)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pQueue);
+		ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
+
+		TimelineFence* pFence = (TimelineFence*)conf_calloc(1, sizeof(*pFence));
+		ASSERT(pFence);
+
+		pFence->pQueue = pQueue;
+
+		DECLARE_ZERO(VkFenceCreateInfo, add_info);
+		add_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		add_info.pNext = NULL;
+		add_info.flags = 0;
+		for (uint32_t i = 0; i < MAX_TIMELINE_FENCE_PENDING_SIGNALS; ++i)
+		{
+			VkResult vk_res = vkCreateFence(pRenderer->pVkDevice, &add_info, NULL, &pFence->pVkFences[i]);
+			ASSERT(VK_SUCCESS == vk_res);
+		}
+
+		*ppFence = pFence;
+	}
+
+	void removeTimelineFence(Renderer* pRenderer, TimelineFence* pFence)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pFence);
+		ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
+
+		for (uint32_t i = 0; i < MAX_TIMELINE_FENCE_PENDING_SIGNALS; ++i)
+			vkDestroyFence(pRenderer->pVkDevice, pFence->pVkFences[i], NULL);
+
+		SAFE_FREE(pFence);
+	}
+
 	void addSemaphore(Renderer *pRenderer, Semaphore** ppSemaphore)
 	{
 		ASSERT(pRenderer);
@@ -2577,6 +2613,7 @@ namespace vk {
 			//get queue handle
 			vkGetDeviceQueue(pRenderer->pVkDevice, pQueueToCreate->mVkQueueFamilyIndex, pQueueToCreate->mVkQueueIndex, &(pQueueToCreate->pVkQueue));
 			ASSERT(VK_NULL_HANDLE != pQueueToCreate->pVkQueue);
+			pQueueToCreate->pSubmitMutex = conf_placement_new<Mutex>(conf_calloc(1, sizeof(Mutex)));
 			*ppQueue = pQueueToCreate;
 
 			++pRenderer->mVkUsedQueueCount[nodeIndex][queueFlags];
@@ -2593,6 +2630,8 @@ namespace vk {
 		const uint32_t nodeIndex = pQueue->mQueueDesc.mNodeIndex;
 		VkQueueFlags queueFlags = pQueue->pRenderer->mVkQueueFamilyProperties[nodeIndex][pQueue->mVkQueueFamilyIndex].queueFlags;
 		--pQueue->pRenderer->mVkUsedQueueCount[nodeIndex][queueFlags];
+		pQueue->pSubmitMutex->~Mutex();
+		conf_free(pQueue->pSubmitMutex);
 		SAFE_FREE(pQueue);
 	}
 
@@ -5362,7 +5401,30 @@ namespace vk {
 		{
 			BufferBarrier* pTrans = &pBufferBarriers[i];
 			Buffer* pBuffer = pTrans->pBuffer;
-			if (!(pTrans->mNewState & pBuffer->mCurrentState))
+			if (pTrans->mAcquire || pTrans->mRelease)
+			{
+				// Queues of the same family share ownership
+				const uint32_t cmdQueueFamily = pCmd->pCmdPool->pQueue->mVkQueueFamilyIndex;
+				const uint32_t transferQueueFamily = pTrans->pTransferQueue->mVkQueueFamilyIndex;
+				if (cmdQueueFamily == transferQueueFamily)
+					continue;
+
+				VkBufferMemoryBarrier* pBufferBarrier = &bufferBarriers[bufferBarrierCount++];
+				pBufferBarrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				pBufferBarrier->pNext = NULL;
+
+				pBufferBarrier->buffer = pBuffer->pVkBuffer;
+				pBufferBarrier->size = VK_WHOLE_SIZE;
+				pBufferBarrier->offset = 0;
+
+				// The release makes the writes available, the acquire makes them visible
+				pBufferBarrier->srcAccessMask = pTrans->mRelease ? util_to_vk_access_flags(pBuffer->mCurrentState) : 0;
+				pBufferBarrier->dstAccessMask = pTrans->mAcquire ? util_to_vk_access_flags(pBuffer->mCurrentState) : 0;
+
+				pBufferBarrier->srcQueueFamilyIndex = pTrans->mRelease ? cmdQueueFamily : transferQueueFamily;
+				pBufferBarrier->dstQueueFamilyIndex = pTrans->mRelease ? transferQueueFamily : cmdQueueFamily;
+			}
+			else if (!(pTrans->mNewState & pBuffer->mCurrentState))
 			{
 				VkBufferMemoryBarrier* pBufferBarrier = &bufferBarriers[bufferBarrierCount++];
 				pBufferBarrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
@@ -5385,7 +5447,35 @@ namespace vk {
 		{
 			TextureBarrier* pTrans = &pTextureBarriers[i];
 			Texture* pTexture = pTrans->pTexture;
-			if (!(pTrans->mNewState & pTexture->mCurrentState))
+			if (pTrans->mAcquire || pTrans->mRelease)
+			{
+				// Queues of the same family share ownership
+				const uint32_t cmdQueueFamily = pCmd->pCmdPool->pQueue->mVkQueueFamilyIndex;
+				const uint32_t transferQueueFamily = pTrans->pTransferQueue->mVkQueueFamilyIndex;
+				if (cmdQueueFamily == transferQueueFamily)
+					continue;
+
+				VkImageMemoryBarrier* pImageBarrier = &imageBarriers[imageBarrierCount++];
+				pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				pImageBarrier->pNext = NULL;
+
+				pImageBarrier->image = pTexture->pVkImage;
+				pImageBarrier->subresourceRange.aspectMask = pTexture->mVkAspectMask;
+				pImageBarrier->subresourceRange.baseMipLevel = 0;
+				pImageBarrier->subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+				pImageBarrier->subresourceRange.baseArrayLayer = 0;
+				pImageBarrier->subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+				// The release makes the writes available, the acquire makes them visible. The layout is kept, the release and the acquire must match
+				pImageBarrier->srcAccessMask = pTrans->mRelease ? util_to_vk_access_flags(pTexture->mCurrentState) : 0;
+				pImageBarrier->dstAccessMask = pTrans->mAcquire ? util_to_vk_access_flags(pTexture->mCurrentState) : 0;
+				pImageBarrier->oldLayout = util_to_vk_image_layout(pTexture->mCurrentState);
+				pImageBarrier->newLayout = util_to_vk_image_layout(pTexture->mCurrentState);
+
+				pImageBarrier->srcQueueFamilyIndex = pTrans->mRelease ? cmdQueueFamily : transferQueueFamily;
+				pImageBarrier->dstQueueFamilyIndex = pTrans->mRelease ? transferQueueFamily : cmdQueueFamily;
+			}
+			else if (!(pTrans->mNewState & pTexture->mCurrentState))
 			{
 				VkImageMemoryBarrier* pImageBarrier = &imageBarriers[imageBarrierCount++];
 				pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -5716,7 +5806,9 @@ namespace vk {
 			submit_info.pNext = &deviceGroupSubmitInfo;
 		}
 
+		pQueue->pSubmitMutex->Acquire();
 		VkResult vk_res = vkQueueSubmit(pQueue->pVkQueue, 1, &submit_info, pFence->pVkFence);
+		pQueue->pSubmitMutex->Release();
 		ASSERT(VK_SUCCESS == vk_res);
 
 		pFence->mSubmitted = true;
@@ -5753,7 +5845,9 @@ namespace vk {
 		present_info.pImageIndices = &(swapChainImageIndex);
 		present_info.pResults = NULL;
 
+		pQueue->pSubmitMutex->Acquire();
 		VkResult vk_res = vkQueuePresentKHR(pSwapChain->pPresentQueue ? pSwapChain->pPresentQueue : pQueue->pVkQueue, &present_info);
+		pQueue->pSubmitMutex->Release();
 		if (vk_res == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			// TODO : Fix bug where we get this error if window is closed before able to present queue.
@@ -5769,7 +5863,23 @@ namespace vk {
 		ASSERT(ppFences);
 
 		if (signal)
-			vkQueueWaitIdle(pQueue->pVkQueue);
+		{
+			// Wait on a fence signaled by an empty submission instead of vkQueueWaitIdle,
+			// so other threads can keep submitting to this queue while the GPU drains it
+			DECLARE_ZERO(VkFenceCreateInfo, idle_info);
+			idle_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VkFence idleFence = VK_NULL_HANDLE;
+			VkResult vk_res = vkCreateFence(pQueue->pRenderer->pVkDevice, &idle_info, NULL, &idleFence);
+			ASSERT(VK_SUCCESS == vk_res);
+
+			pQueue->pSubmitMutex->Acquire();
+			vk_res = vkQueueSubmit(pQueue->pVkQueue, 0, NULL, idleFence);
+			pQueue->pSubmitMutex->Release();
+			ASSERT(VK_SUCCESS == vk_res);
+
+			vkWaitForFences(pQueue->pRenderer->pVkDevice, 1, &idleFence, VK_TRUE, UINT64_MAX);
+			vkDestroyFence(pQueue->pRenderer->pVkDevice, idleFence, NULL);
+		}
 
 		VkFence* pFences = (VkFence*)alloca(fenceCount * sizeof(VkFence));
 		uint32_t numValidFences = 0;
@@ -5789,6 +5899,68 @@ namespace vk {
 			ppFences[i]->mSubmitted = false;
 	}
 
+	/// Retires the pending fences which have been signaled. Fences signal in submission order so this stops at the first pending one.
+	static void util_update_timeline_fence(TimelineFence* pFence, bool wait, uint64_t value)
+	{
+		VkDevice device = pFence->pQueue->pRenderer->pVkDevice;
+
+		while (pFence->mVkPendingCount)
+		{
+			const uint32_t head = pFence->mVkFenceHead;
+			VkResult vk_res = vkGetFenceStatus(device, pFence->pVkFences[head]);
+			if (vk_res != VK_SUCCESS)
+			{
+				if (!wait || pFence->mCompletedValue >= value)
+					break;
+
+				vk_res = vkWaitForFences(device, 1, &pFence->pVkFences[head], VK_TRUE, UINT64_MAX);
+				ASSERT(VK_SUCCESS == vk_res);
+			}
+
+			vkResetFences(device, 1, &pFence->pVkFences[head]);
+			pFence->mCompletedValue = pFence->mVkFenceValues[head];
+			pFence->mVkFenceHead = (head + 1) % MAX_TIMELINE_FENCE_PENDING_SIGNALS;
+			--pFence->mVkPendingCount;
+		}
+	}
+
+	uint64_t queueSignalTimelineFence(TimelineFence* pFence)
+	{
+		ASSERT(pFence);
+
+		// Ring is full, retire the oldest value to free a fence
+		if (pFence->mVkPendingCount == MAX_TIMELINE_FENCE_PENDING_SIGNALS)
+			util_update_timeline_fence(pFence, true, pFence->mVkFenceValues[pFence->mVkFenceHead]);
+
+		const uint32_t slot = (pFence->mVkFenceHead + pFence->mVkPendingCount) % MAX_TIMELINE_FENCE_PENDING_SIGNALS;
+		// An empty submission signals its fence once all previously submitted work on the queue has completed
+		pFence->pQueue->pSubmitMutex->Acquire();
+		VkResult vk_res = vkQueueSubmit(pFence->pQueue->pVkQueue, 0, NULL, pFence->pVkFences[slot]);
+		pFence->pQueue->pSubmitMutex->Release();
+		ASSERT(VK_SUCCESS == vk_res);
+
+		pFence->mVkFenceValues[slot] = ++pFence->mSignaledValue;
+		++pFence->mVkPendingCount;
+
+		return pFence->mSignaledValue;
+	}
+
+	uint64_t getTimelineFenceCompletedValue(TimelineFence* pFence)
+	{
+		ASSERT(pFence);
+
+		util_update_timeline_fence(pFence, false, 0);
+		return pFence->mCompletedValue;
+	}
+
+	void waitTimelineFence(TimelineFence* pFence, uint64_t value)
+	{
+		ASSERT(pFence);
+		ASSERT(value <= pFence->mSignaledValue && "Waiting for a value which was never signaled");
+
+		util_update_timeline_fence(pFence, true, value);
+	}
+
 	void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus)
 	{
 		*pFenceStatus = FENCE_STATUS_COMPLETE;
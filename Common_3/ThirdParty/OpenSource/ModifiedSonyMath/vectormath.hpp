@@ -60,6 +60,10 @@
 using namespace Vectormath::Soa;
 
 //========================================= #ConfettiAnimationMathExtensionsEnd =======================================
+
+// Templated SoA types as wide as the target's SIMD registers (AVX-512, AVX2, SSE, NEON), in Vectormath::Wide
+#include "wide/wide.hpp"
+
 //========================================= #ConfettiMathExtensionsEnd ================================================
 
 #include "vec2d.hpp"  // - Extended 2D vector and point classes; not aligned and always in scalar floats mode.
@@ -0,0 +1,135 @@
+//========================================= #ConfettiMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018 Confetti Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#ifndef VECTORMATH_WIDE_BATCH_HPP
+#define VECTORMATH_WIDE_BATCH_HPP
+
+// Batch helpers over SoA component arrays. The bulk of every batch is
+// processed FloatN::Width elements at a time, the remainder with T = float,
+// so counts do not need to be padded and arrays do not need to be aligned.
+
+namespace Vectormath
+{
+namespace Wide
+{
+
+namespace internal
+{
+template <typename T>
+inline void TransformPoints(const WideFloat4x4<T>& _m, const float* _inX, const float* _inY, const float* _inZ,
+                            float* _outX, float* _outY, float* _outZ, uint32_t _begin, uint32_t _end) {
+  const uint32_t width = LaneTraits<T>::Width;
+  for (uint32_t i = _begin; i + width <= _end; i += width) {
+    const WideFloat3<T> p = WideFloat3<T>::LoadU(_inX + i, _inY + i, _inZ + i);
+    TransformPoint(_m, p).StoreU(_outX + i, _outY + i, _outZ + i);
+  }
+}
+
+template <typename T>
+inline void TransformVectors(const WideFloat4x4<T>& _m, const float* _inX, const float* _inY, const float* _inZ,
+                             float* _outX, float* _outY, float* _outZ, uint32_t _begin, uint32_t _end) {
+  const uint32_t width = LaneTraits<T>::Width;
+  for (uint32_t i = _begin; i + width <= _end; i += width) {
+    const WideFloat3<T> v = WideFloat3<T>::LoadU(_inX + i, _inY + i, _inZ + i);
+    TransformVector(_m, v).StoreU(_outX + i, _outY + i, _outZ + i);
+  }
+}
+
+template <typename T>
+inline void TransformPointsIndexed(const Matrix4* _matrices, const uint32_t* _indices, const float* _inX, const float* _inY,
+                                   const float* _inZ, float* _outX, float* _outY, float* _outZ, uint32_t _begin, uint32_t _end) {
+  const uint32_t width = LaneTraits<T>::Width;
+  for (uint32_t i = _begin; i + width <= _end; i += width) {
+    const WideFloat4x4<T> m = WideFloat4x4<T>::Gather(_matrices, _indices + i);
+    const WideFloat3<T> p = WideFloat3<T>::LoadU(_inX + i, _inY + i, _inZ + i);
+    TransformPoint(m, p).StoreU(_outX + i, _outY + i, _outZ + i);
+  }
+}
+
+template <typename T>
+inline void MultiplyMatrices(const Matrix4* _a, const Matrix4* _b, Matrix4* _out, uint32_t _begin, uint32_t _end) {
+  const uint32_t width = LaneTraits<T>::Width;
+  for (uint32_t i = _begin; i + width <= _end; i += width) {
+    const WideFloat4x4<T> a = WideFloat4x4<T>::Gather(_a + i);
+    const WideFloat4x4<T> b = WideFloat4x4<T>::Gather(_b + i);
+    (a * b).Scatter(_out + i);
+  }
+}
+
+// Returns the first element the FloatN loop leaves to the scalar tail.
+inline uint32_t WideEnd(uint32_t _count) { return _count - _count % FloatN::Width; }
+} // namespace internal
+
+// Transforms _count points by the affine matrix _m. In and out arrays may alias.
+inline void TransformPoints(const Matrix4& _m, const float* _inX, const float* _inY, const float* _inZ,
+                            float* _outX, float* _outY, float* _outZ, uint32_t _count) {
+  const uint32_t end = internal::WideEnd(_count);
+  internal::TransformPoints(WideFloat4x4N::Broadcast(_m), _inX, _inY, _inZ, _outX, _outY, _outZ, 0, end);
+  internal::TransformPoints(WideFloat4x4<float>::Broadcast(_m), _inX, _inY, _inZ, _outX, _outY, _outZ, end, _count);
+}
+
+// Transforms the same _count points by each of the _matrixCount affine
+// matrices. The points transformed by _matrices[j] are written starting at
+// element j * _count of the out arrays.
+inline void TransformPoints(const Matrix4* _matrices, uint32_t _matrixCount, const float* _inX, const float* _inY,
+                            const float* _inZ, float* _outX, float* _outY, float* _outZ, uint32_t _count) {
+  for (uint32_t j = 0; j < _matrixCount; ++j) {
+    const size_t offset = (size_t)j * _count;
+    TransformPoints(_matrices[j], _inX, _inY, _inZ, _outX + offset, _outY + offset, _outZ + offset, _count);
+  }
+}
+
+// Transforms _count directions by the upper 3x3 of _m.
+inline void TransformVectors(const Matrix4& _m, const float* _inX, const float* _inY, const float* _inZ,
+                             float* _outX, float* _outY, float* _outZ, uint32_t _count) {
+  const uint32_t end = internal::WideEnd(_count);
+  internal::TransformVectors(WideFloat4x4N::Broadcast(_m), _inX, _inY, _inZ, _outX, _outY, _outZ, 0, end);
+  internal::TransformVectors(WideFloat4x4<float>::Broadcast(_m), _inX, _inY, _inZ, _outX, _outY, _outZ, end, _count);
+}
+
+// Transforms point i by _matrices[_indices[i]], e.g. rigid skinning of
+// vertices to their bone.
+inline void TransformPointsIndexed(const Matrix4* _matrices, const uint32_t* _indices, const float* _inX, const float* _inY,
+                                   const float* _inZ, float* _outX, float* _outY, float* _outZ, uint32_t _count) {
+  const uint32_t end = internal::WideEnd(_count);
+  internal::TransformPointsIndexed<FloatN>(_matrices, _indices, _inX, _inY, _inZ, _outX, _outY, _outZ, 0, end);
+  internal::TransformPointsIndexed<float>(_matrices, _indices, _inX, _inY, _inZ, _outX, _outY, _outZ, end, _count);
+}
+
+// Computes _out[i] = _a[i] * _b[i] for _count matrices. _out may alias _a or _b.
+inline void MultiplyMatrices(const Matrix4* _a, const Matrix4* _b, Matrix4* _out, uint32_t _count) {
+  const uint32_t end = internal::WideEnd(_count);
+  internal::MultiplyMatrices<FloatN>(_a, _b, _out, 0, end);
+  internal::MultiplyMatrices<float>(_a, _b, _out, end, _count);
+}
+
+} // namespace Wide
+} // namespace Vectormath
+
+#endif // VECTORMATH_WIDE_BATCH_HPP
+
+//========================================= #ConfettiMathExtensionsEnd ================================================
@@ -0,0 +1,508 @@
+//========================================= #ConfettiMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018 Confetti Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#ifndef VECTORMATH_WIDE_FLOATN_HPP
+#define VECTORMATH_WIDE_FLOATN_HPP
+
+// FloatN holds VECTORMATH_WIDE_WIDTH floats in the widest register the target
+// was compiled for, MaskN holds the result of a comparison of two FloatN.
+// Backends: AVX-512 (16), AVX / AVX2 (8), SSE2 (4), NEON (4) and scalar (1).
+// Define VECTORMATH_WIDE_MAX_WIDTH to cap the width, e.g. to 8 to stay on AVX2
+// on AVX-512 capable builds.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+
+#ifndef VECTORMATH_WIDE_MAX_WIDTH
+#define VECTORMATH_WIDE_MAX_WIDTH 16
+#endif
+
+#if defined(__AVX512F__) && VECTORMATH_WIDE_MAX_WIDTH >= 16
+  #include <immintrin.h>
+  #define VECTORMATH_WIDE_WIDTH 16
+  #define VECTORMATH_WIDE_AVX512 1
+#elif (defined(__AVX__) || defined(__AVX2__)) && VECTORMATH_WIDE_MAX_WIDTH >= 8
+  #include <immintrin.h>
+  #define VECTORMATH_WIDE_WIDTH 8
+  #define VECTORMATH_WIDE_AVX 1
+#elif (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && VECTORMATH_WIDE_MAX_WIDTH >= 4
+  #include <emmintrin.h>
+  #define VECTORMATH_WIDE_WIDTH 4
+  #define VECTORMATH_WIDE_SSE 1
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && VECTORMATH_WIDE_MAX_WIDTH >= 4
+  #include <arm_neon.h>
+  #define VECTORMATH_WIDE_WIDTH 4
+  #define VECTORMATH_WIDE_NEON 1
+#else
+  #define VECTORMATH_WIDE_WIDTH 1
+  #define VECTORMATH_WIDE_SCALAR 1
+#endif
+
+// AVX without AVX2 does not guarantee FMA (e.g. XBoxOne)
+#if defined(VECTORMATH_WIDE_AVX512) || (defined(VECTORMATH_WIDE_AVX) && (defined(__FMA__) || defined(__AVX2__)))
+  #define VECTORMATH_WIDE_FMA 1
+#endif
+
+namespace Vectormath
+{
+namespace Wide
+{
+
+#if defined(VECTORMATH_WIDE_AVX512)
+typedef __m512 NativeFloatN;
+typedef __mmask16 NativeMaskN;
+#elif defined(VECTORMATH_WIDE_AVX)
+typedef __m256 NativeFloatN;
+typedef __m256 NativeMaskN;
+#elif defined(VECTORMATH_WIDE_SSE)
+typedef __m128 NativeFloatN;
+typedef __m128 NativeMaskN;
+#elif defined(VECTORMATH_WIDE_NEON)
+typedef float32x4_t NativeFloatN;
+typedef uint32x4_t NativeMaskN;
+#else
+typedef float NativeFloatN;
+typedef bool NativeMaskN;
+#endif
+
+//----------------------------------------------------------------------------
+// MaskN
+//----------------------------------------------------------------------------
+
+class MaskN {
+
+public:
+
+  NativeMaskN m;
+
+  inline MaskN() {}
+  inline MaskN(NativeMaskN _m) : m(_m) {}
+};
+
+// Returns per lane and, or, exclusive or of _a and _b.
+inline MaskN operator&(const MaskN& _a, const MaskN& _b);
+inline MaskN operator|(const MaskN& _a, const MaskN& _b);
+inline MaskN operator^(const MaskN& _a, const MaskN& _b);
+
+// Returns the lanes set in _a and not in _b.
+inline MaskN AndNot(const MaskN& _a, const MaskN& _b);
+
+// Returns one bit per lane, lane 0 in bit 0.
+inline uint32_t MoveMask(const MaskN& _m);
+
+// Returns true if any / all lanes of _m are set.
+inline bool Any(const MaskN& _m);
+inline bool All(const MaskN& _m);
+
+//----------------------------------------------------------------------------
+// FloatN
+//----------------------------------------------------------------------------
+
+class FloatN {
+
+public:
+
+  static const uint32_t Width = VECTORMATH_WIDE_WIDTH;
+
+  NativeFloatN v;
+
+  inline FloatN() {}
+#if !defined(VECTORMATH_WIDE_SCALAR)
+  inline FloatN(NativeFloatN _v) : v(_v) {}
+#endif
+
+  // Sets all lanes to _f.
+  inline explicit FloatN(float _f);
+
+  static inline FloatN zero();
+
+  static inline FloatN one();
+
+  // Loads Width floats from _p, which has to be aligned to Width floats.
+  static inline FloatN Load(const float* _p);
+
+  // Loads Width floats from _p without alignment requirement.
+  static inline FloatN LoadU(const float* _p);
+
+  // Stores Width floats to _p, which has to be aligned to Width floats.
+  inline void Store(float* _p) const;
+
+  // Stores Width floats to _p without alignment requirement.
+  inline void StoreU(float* _p) const;
+
+  inline FloatN& operator+=(const FloatN& _f);
+  inline FloatN& operator-=(const FloatN& _f);
+  inline FloatN& operator*=(const FloatN& _f);
+  inline FloatN& operator/=(const FloatN& _f);
+};
+
+// Returns per lane arithmetic of _a and _b.
+inline FloatN operator+(const FloatN& _a, const FloatN& _b);
+inline FloatN operator-(const FloatN& _a, const FloatN& _b);
+inline FloatN operator*(const FloatN& _a, const FloatN& _b);
+inline FloatN operator/(const FloatN& _a, const FloatN& _b);
+inline FloatN operator-(const FloatN& _f);
+
+// Returns per lane comparisons of _a and _b.
+inline MaskN operator<(const FloatN& _a, const FloatN& _b);
+inline MaskN operator<=(const FloatN& _a, const FloatN& _b);
+inline MaskN operator>(const FloatN& _a, const FloatN& _b);
+inline MaskN operator>=(const FloatN& _a, const FloatN& _b);
+inline MaskN operator==(const FloatN& _a, const FloatN& _b);
+inline MaskN operator!=(const FloatN& _a, const FloatN& _b);
+
+// Returns _a * _b + _c, fused where the target supports it.
+inline FloatN MulAdd(const FloatN& _a, const FloatN& _b, const FloatN& _c);
+
+// Returns _a for the lanes set in _m and _b for the others.
+inline FloatN Select(const MaskN& _m, const FloatN& _a, const FloatN& _b);
+
+inline FloatN Min(const FloatN& _a, const FloatN& _b);
+inline FloatN Max(const FloatN& _a, const FloatN& _b);
+inline FloatN Abs(const FloatN& _f);
+inline FloatN Floor(const FloatN& _f);
+inline FloatN Sqrt(const FloatN& _f);
+
+// Returns 1 / _f.
+inline FloatN Rcp(const FloatN& _f);
+
+// Returns 1 / sqrt(_f).
+inline FloatN RSqrt(const FloatN& _f);
+
+// Returns an estimate of 1 / sqrt(_f), about 12 bits precise.
+inline FloatN RSqrtEst(const FloatN& _f);
+
+// Returns the sum of all lanes.
+inline float HAdd(const FloatN& _f);
+
+//----------------------------------------------------------------------------
+// Scalar overloads, so the templated SoA types and helpers also work on float
+//----------------------------------------------------------------------------
+
+inline float MulAdd(float _a, float _b, float _c) { return _a * _b + _c; }
+inline float Select(bool _m, float _a, float _b) { return _m ? _a : _b; }
+inline float Min(float _a, float _b) { return _a < _b ? _a : _b; }
+inline float Max(float _a, float _b) { return _a > _b ? _a : _b; }
+inline float Abs(float _f) { return fabsf(_f); }
+inline float Floor(float _f) { return floorf(_f); }
+inline float Sqrt(float _f) { return sqrtf(_f); }
+inline float Rcp(float _f) { return 1.0f / _f; }
+inline float RSqrt(float _f) { return 1.0f / sqrtf(_f); }
+inline float RSqrtEst(float _f) { return 1.0f / sqrtf(_f); }
+inline float HAdd(float _f) { return _f; }
+inline uint32_t MoveMask(bool _m) { return _m ? 1U : 0U; }
+inline bool Any(bool _m) { return _m; }
+inline bool All(bool _m) { return _m; }
+
+// Lane count and memory access for the types the SoA templates are used with.
+template <typename T> struct LaneTraits;
+
+template <> struct LaneTraits<float> {
+  static const uint32_t Width = 1;
+  static inline float LoadU(const float* _p) { return *_p; }
+  static inline void StoreU(float* _p, float _f) { *_p = _f; }
+};
+
+template <> struct LaneTraits<FloatN> {
+  static const uint32_t Width = FloatN::Width;
+  static inline FloatN LoadU(const float* _p) { return FloatN::LoadU(_p); }
+  static inline void StoreU(float* _p, const FloatN& _f) { _f.StoreU(_p); }
+};
+
+//----------------------------------------------------------------------------
+// Implementation
+//----------------------------------------------------------------------------
+
+inline FloatN& FloatN::operator+=(const FloatN& _f) { *this = *this + _f; return *this; }
+inline FloatN& FloatN::operator-=(const FloatN& _f) { *this = *this - _f; return *this; }
+inline FloatN& FloatN::operator*=(const FloatN& _f) { *this = *this * _f; return *this; }
+inline FloatN& FloatN::operator/=(const FloatN& _f) { *this = *this / _f; return *this; }
+inline FloatN FloatN::one() { return FloatN(1.0f); }
+
+#if defined(VECTORMATH_WIDE_AVX512)
+
+inline MaskN operator&(const MaskN& _a, const MaskN& _b) { return MaskN((__mmask16)(_a.m & _b.m)); }
+inline MaskN operator|(const MaskN& _a, const MaskN& _b) { return MaskN((__mmask16)(_a.m | _b.m)); }
+inline MaskN operator^(const MaskN& _a, const MaskN& _b) { return MaskN((__mmask16)(_a.m ^ _b.m)); }
+inline MaskN AndNot(const MaskN& _a, const MaskN& _b) { return MaskN((__mmask16)(_a.m & ~_b.m)); }
+inline uint32_t MoveMask(const MaskN& _m) { return (uint32_t)_m.m; }
+inline bool Any(const MaskN& _m) { return _m.m != 0; }
+inline bool All(const MaskN& _m) { return _m.m == 0xFFFF; }
+
+inline FloatN::FloatN(float _f) : v(_mm512_set1_ps(_f)) {}
+inline FloatN FloatN::zero() { return FloatN(_mm512_setzero_ps()); }
+inline FloatN FloatN::Load(const float* _p) { return FloatN(_mm512_load_ps(_p)); }
+inline FloatN FloatN::LoadU(const float* _p) { return FloatN(_mm512_loadu_ps(_p)); }
+inline void FloatN::Store(float* _p) const { _mm512_store_ps(_p, v); }
+inline void FloatN::StoreU(float* _p) const { _mm512_storeu_ps(_p, v); }
+
+inline FloatN operator+(const FloatN& _a, const FloatN& _b) { return FloatN(_mm512_add_ps(_a.v, _b.v)); }
+inline FloatN operator-(const FloatN& _a, const FloatN& _b) { return FloatN(_mm512_sub_ps(_a.v, _b.v)); }
+inline FloatN operator*(const FloatN& _a, const FloatN& _b) { return FloatN(_mm512_mul_ps(_a.v, _b.v)); }
+inline FloatN operator/(const FloatN& _a, const FloatN& _b) { return FloatN(_mm512_div_ps(_a.v, _b.v)); }
+inline FloatN operator-(const FloatN& _f) { return FloatN(_mm512_sub_ps(_mm512_setzero_ps(), _f.v)); }
+
+inline MaskN operator<(const FloatN& _a, const FloatN& _b) { return MaskN(_mm512_cmp_ps_mask(_a.v, _b.v, _CMP_LT_OQ)); }
+inline MaskN operator<=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm512_cmp_ps_mask(_a.v, _b.v, _CMP_LE_OQ)); }
+inline MaskN operator>(const FloatN& _a, const FloatN& _b) { return MaskN(_mm512_cmp_ps_mask(_a.v, _b.v, _CMP_GT_OQ)); }
+inline MaskN operator>=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm512_cmp_ps_mask(_a.v, _b.v, _CMP_GE_OQ)); }
+inline MaskN operator==(const FloatN& _a, const FloatN& _b) { return MaskN(_mm512_cmp_ps_mask(_a.v, _b.v, _CMP_EQ_OQ)); }
+inline MaskN operator!=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm512_cmp_ps_mask(_a.v, _b.v, _CMP_NEQ_UQ)); }
+
+inline FloatN MulAdd(const FloatN& _a, const FloatN& _b, const FloatN& _c) { return FloatN(_mm512_fmadd_ps(_a.v, _b.v, _c.v)); }
+inline FloatN Select(const MaskN& _m, const FloatN& _a, const FloatN& _b) { return FloatN(_mm512_mask_blend_ps(_m.m, _b.v, _a.v)); }
+inline FloatN Min(const FloatN& _a, const FloatN& _b) { return FloatN(_mm512_min_ps(_a.v, _b.v)); }
+inline FloatN Max(const FloatN& _a, const FloatN& _b) { return FloatN(_mm512_max_ps(_a.v, _b.v)); }
+inline FloatN Abs(const FloatN& _f) { return FloatN(_mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(_f.v), _mm512_set1_epi32(0x7FFFFFFF)))); }
+inline FloatN Floor(const FloatN& _f) { return FloatN(_mm512_roundscale_ps(_f.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)); }
+inline FloatN Sqrt(const FloatN& _f) { return FloatN(_mm512_sqrt_ps(_f.v)); }
+inline FloatN Rcp(const FloatN& _f) { return FloatN(_mm512_div_ps(_mm512_set1_ps(1.0f), _f.v)); }
+inline FloatN RSqrt(const FloatN& _f) { return FloatN(_mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(_f.v))); }
+inline FloatN RSqrtEst(const FloatN& _f) { return FloatN(_mm512_rsqrt14_ps(_f.v)); }
+inline float HAdd(const FloatN& _f) { return _mm512_reduce_add_ps(_f.v); }
+
+#elif defined(VECTORMATH_WIDE_AVX)
+
+inline MaskN operator&(const MaskN& _a, const MaskN& _b) { return MaskN(_mm256_and_ps(_a.m, _b.m)); }
+inline MaskN operator|(const MaskN& _a, const MaskN& _b) { return MaskN(_mm256_or_ps(_a.m, _b.m)); }
+inline MaskN operator^(const MaskN& _a, const MaskN& _b) { return MaskN(_mm256_xor_ps(_a.m, _b.m)); }
+inline MaskN AndNot(const MaskN& _a, const MaskN& _b) { return MaskN(_mm256_andnot_ps(_b.m, _a.m)); }
+inline uint32_t MoveMask(const MaskN& _m) { return (uint32_t)_mm256_movemask_ps(_m.m); }
+inline bool Any(const MaskN& _m) { return _mm256_movemask_ps(_m.m) != 0; }
+inline bool All(const MaskN& _m) { return _mm256_movemask_ps(_m.m) == 0xFF; }
+
+inline FloatN::FloatN(float _f) : v(_mm256_set1_ps(_f)) {}
+inline FloatN FloatN::zero() { return FloatN(_mm256_setzero_ps()); }
+inline FloatN FloatN::Load(const float* _p) { return FloatN(_mm256_load_ps(_p)); }
+inline FloatN FloatN::LoadU(const float* _p) { return FloatN(_mm256_loadu_ps(_p)); }
+inline void FloatN::Store(float* _p) const { _mm256_store_ps(_p, v); }
+inline void FloatN::StoreU(float* _p) const { _mm256_storeu_ps(_p, v); }
+
+inline FloatN operator+(const FloatN& _a, const FloatN& _b) { return FloatN(_mm256_add_ps(_a.v, _b.v)); }
+inline FloatN operator-(const FloatN& _a, const FloatN& _b) { return FloatN(_mm256_sub_ps(_a.v, _b.v)); }
+inline FloatN operator*(const FloatN& _a, const FloatN& _b) { return FloatN(_mm256_mul_ps(_a.v, _b.v)); }
+inline FloatN operator/(const FloatN& _a, const FloatN& _b) { return FloatN(_mm256_div_ps(_a.v, _b.v)); }
+inline FloatN operator-(const FloatN& _f) { return FloatN(_mm256_xor_ps(_f.v, _mm256_set1_ps(-0.0f))); }
+
+inline MaskN operator<(const FloatN& _a, const FloatN& _b) { return MaskN(_mm256_cmp_ps(_a.v, _b.v, _CMP_LT_OQ)); }
+inline MaskN operator<=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm256_cmp_ps(_a.v, _b.v, _CMP_LE_OQ)); }
+inline MaskN operator>(const FloatN& _a, const FloatN& _b) { return MaskN(_mm256_cmp_ps(_a.v, _b.v, _CMP_GT_OQ)); }
+inline MaskN operator>=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm256_cmp_ps(_a.v, _b.v, _CMP_GE_OQ)); }
+inline MaskN operator==(const FloatN& _a, const FloatN& _b) { return MaskN(_mm256_cmp_ps(_a.v, _b.v, _CMP_EQ_OQ)); }
+inline MaskN operator!=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm256_cmp_ps(_a.v, _b.v, _CMP_NEQ_UQ)); }
+
+#if defined(VECTORMATH_WIDE_FMA)
+inline FloatN MulAdd(const FloatN& _a, const FloatN& _b, const FloatN& _c) { return FloatN(_mm256_fmadd_ps(_a.v, _b.v, _c.v)); }
+#else
+inline FloatN MulAdd(const FloatN& _a, const FloatN& _b, const FloatN& _c) { return FloatN(_mm256_add_ps(_mm256_mul_ps(_a.v, _b.v), _c.v)); }
+#endif
+inline FloatN Select(const MaskN& _m, const FloatN& _a, const FloatN& _b) { return FloatN(_mm256_blendv_ps(_b.v, _a.v, _m.m)); }
+inline FloatN Min(const FloatN& _a, const FloatN& _b) { return FloatN(_mm256_min_ps(_a.v, _b.v)); }
+inline FloatN Max(const FloatN& _a, const FloatN& _b) { return FloatN(_mm256_max_ps(_a.v, _b.v)); }
+inline FloatN Abs(const FloatN& _f) { return FloatN(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), _f.v)); }
+inline FloatN Floor(const FloatN& _f) { return FloatN(_mm256_round_ps(_f.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)); }
+inline FloatN Sqrt(const FloatN& _f) { return FloatN(_mm256_sqrt_ps(_f.v)); }
+inline FloatN Rcp(const FloatN& _f) { return FloatN(_mm256_div_ps(_mm256_set1_ps(1.0f), _f.v)); }
+inline FloatN RSqrt(const FloatN& _f) { return FloatN(_mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(_f.v))); }
+inline FloatN RSqrtEst(const FloatN& _f) { return FloatN(_mm256_rsqrt_ps(_f.v)); }
+inline float HAdd(const FloatN& _f) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(_f.v), _mm256_extractf128_ps(_f.v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+#elif defined(VECTORMATH_WIDE_SSE)
+
+inline MaskN operator&(const MaskN& _a, const MaskN& _b) { return MaskN(_mm_and_ps(_a.m, _b.m)); }
+inline MaskN operator|(const MaskN& _a, const MaskN& _b) { return MaskN(_mm_or_ps(_a.m, _b.m)); }
+inline MaskN operator^(const MaskN& _a, const MaskN& _b) { return MaskN(_mm_xor_ps(_a.m, _b.m)); }
+inline MaskN AndNot(const MaskN& _a, const MaskN& _b) { return MaskN(_mm_andnot_ps(_b.m, _a.m)); }
+inline uint32_t MoveMask(const MaskN& _m) { return (uint32_t)_mm_movemask_ps(_m.m); }
+inline bool Any(const MaskN& _m) { return _mm_movemask_ps(_m.m) != 0; }
+inline bool All(const MaskN& _m) { return _mm_movemask_ps(_m.m) == 0xF; }
+
+inline FloatN::FloatN(float _f) : v(_mm_set1_ps(_f)) {}
+inline FloatN FloatN::zero() { return FloatN(_mm_setzero_ps()); }
+inline FloatN FloatN::Load(const float* _p) { return FloatN(_mm_load_ps(_p)); }
+inline FloatN FloatN::LoadU(const float* _p) { return FloatN(_mm_loadu_ps(_p)); }
+inline void FloatN::Store(float* _p) const { _mm_store_ps(_p, v); }
+inline void FloatN::StoreU(float* _p) const { _mm_storeu_ps(_p, v); }
+
+inline FloatN operator+(const FloatN& _a, const FloatN& _b) { return FloatN(_mm_add_ps(_a.v, _b.v)); }
+inline FloatN operator-(const FloatN& _a, const FloatN& _b) { return FloatN(_mm_sub_ps(_a.v, _b.v)); }
+inline FloatN operator*(const FloatN& _a, const FloatN& _b) { return FloatN(_mm_mul_ps(_a.v, _b.v)); }
+inline FloatN operator/(const FloatN& _a, const FloatN& _b) { return FloatN(_mm_div_ps(_a.v, _b.v)); }
+inline FloatN operator-(const FloatN& _f) { return FloatN(_mm_xor_ps(_f.v, _mm_set1_ps(-0.0f))); }
+
+inline MaskN operator<(const FloatN& _a, const FloatN& _b) { return MaskN(_mm_cmplt_ps(_a.v, _b.v)); }
+inline MaskN operator<=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm_cmple_ps(_a.v, _b.v)); }
+inline MaskN operator>(const FloatN& _a, const FloatN& _b) { return MaskN(_mm_cmpgt_ps(_a.v, _b.v)); }
+inline MaskN operator>=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm_cmpge_ps(_a.v, _b.v)); }
+inline MaskN operator==(const FloatN& _a, const FloatN& _b) { return MaskN(_mm_cmpeq_ps(_a.v, _b.v)); }
+inline MaskN operator!=(const FloatN& _a, const FloatN& _b) { return MaskN(_mm_cmpneq_ps(_a.v, _b.v)); }
+
+inline FloatN MulAdd(const FloatN& _a, const FloatN& _b, const FloatN& _c) { return FloatN(_mm_add_ps(_mm_mul_ps(_a.v, _b.v), _c.v)); }
+inline FloatN Select(const MaskN& _m, const FloatN& _a, const FloatN& _b) { return FloatN(_mm_or_ps(_mm_and_ps(_m.m, _a.v), _mm_andnot_ps(_m.m, _b.v))); }
+inline FloatN Min(const FloatN& _a, const FloatN& _b) { return FloatN(_mm_min_ps(_a.v, _b.v)); }
+inline FloatN Max(const FloatN& _a, const FloatN& _b) { return FloatN(_mm_max_ps(_a.v, _b.v)); }
+inline FloatN Abs(const FloatN& _f) { return FloatN(_mm_andnot_ps(_mm_set1_ps(-0.0f), _f.v)); }
+inline FloatN Floor(const FloatN& _f) {
+  // SSE2 has no floor. Truncate and step down where that rounded up. Only valid within the int32 range
+  const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(_f.v));
+  return FloatN(_mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, _f.v), _mm_set1_ps(1.0f))));
+}
+inline FloatN Sqrt(const FloatN& _f) { return FloatN(_mm_sqrt_ps(_f.v)); }
+inline FloatN Rcp(const FloatN& _f) { return FloatN(_mm_div_ps(_mm_set1_ps(1.0f), _f.v)); }
+inline FloatN RSqrt(const FloatN& _f) { return FloatN(_mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_f.v))); }
+inline FloatN RSqrtEst(const FloatN& _f) { return FloatN(_mm_rsqrt_ps(_f.v)); }
+inline float HAdd(const FloatN& _f) {
+  const __m128 sum = _mm_add_ps(_f.v, _mm_movehl_ps(_f.v, _f.v));
+  return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+#elif defined(VECTORMATH_WIDE_NEON)
+
+inline MaskN operator&(const MaskN& _a, const MaskN& _b) { return MaskN(vandq_u32(_a.m, _b.m)); }
+inline MaskN operator|(const MaskN& _a, const MaskN& _b) { return MaskN(vorrq_u32(_a.m, _b.m)); }
+inline MaskN operator^(const MaskN& _a, const MaskN& _b) { return MaskN(veorq_u32(_a.m, _b.m)); }
+inline MaskN AndNot(const MaskN& _a, const MaskN& _b) { return MaskN(vbicq_u32(_a.m, _b.m)); }
+inline uint32_t MoveMask(const MaskN& _m) {
+  return (vgetq_lane_u32(_m.m, 0) & 1U) | (vgetq_lane_u32(_m.m, 1) & 2U) | (vgetq_lane_u32(_m.m, 2) & 4U) | (vgetq_lane_u32(_m.m, 3) & 8U);
+}
+inline bool Any(const MaskN& _m) { return MoveMask(_m) != 0; }
+inline bool All(const MaskN& _m) { return MoveMask(_m) == 0xF; }
+
+inline FloatN::FloatN(float _f) : v(vdupq_n_f32(_f)) {}
+inline FloatN FloatN::zero() { return FloatN(vdupq_n_f32(0.0f)); }
+inline FloatN FloatN::Load(const float* _p) { return FloatN(vld1q_f32(_p)); }
+inline FloatN FloatN::LoadU(const float* _p) { return FloatN(vld1q_f32(_p)); }
+inline void FloatN::Store(float* _p) const { vst1q_f32(_p, v); }
+inline void FloatN::StoreU(float* _p) const { vst1q_f32(_p, v); }
+
+inline FloatN operator+(const FloatN& _a, const FloatN& _b) { return FloatN(vaddq_f32(_a.v, _b.v)); }
+inline FloatN operator-(const FloatN& _a, const FloatN& _b) { return FloatN(vsubq_f32(_a.v, _b.v)); }
+inline FloatN operator*(const FloatN& _a, const FloatN& _b) { return FloatN(vmulq_f32(_a.v, _b.v)); }
+inline FloatN operator-(const FloatN& _f) { return FloatN(vnegq_f32(_f.v)); }
+
+inline MaskN operator<(const FloatN& _a, const FloatN& _b) { return MaskN(vcltq_f32(_a.v, _b.v)); }
+inline MaskN operator<=(const FloatN& _a, const FloatN& _b) { return MaskN(vcleq_f32(_a.v, _b.v)); }
+inline MaskN operator>(const FloatN& _a, const FloatN& _b) { return MaskN(vcgtq_f32(_a.v, _b.v)); }
+inline MaskN operator>=(const FloatN& _a, const FloatN& _b) { return MaskN(vcgeq_f32(_a.v, _b.v)); }
+inline MaskN operator==(const FloatN& _a, const FloatN& _b) { return MaskN(vceqq_f32(_a.v, _b.v)); }
+inline MaskN operator!=(const FloatN& _a, const FloatN& _b) { return MaskN(vmvnq_u32(vceqq_f32(_a.v, _b.v))); }
+
+inline FloatN MulAdd(const FloatN& _a, const FloatN& _b, const FloatN& _c) { return FloatN(vmlaq_f32(_c.v, _a.v, _b.v)); }
+inline FloatN Select(const MaskN& _m, const FloatN& _a, const FloatN& _b) { return FloatN(vbslq_f32(_m.m, _a.v, _b.v)); }
+inline FloatN Min(const FloatN& _a, const FloatN& _b) { return FloatN(vminq_f32(_a.v, _b.v)); }
+inline FloatN Max(const FloatN& _a, const FloatN& _b) { return FloatN(vmaxq_f32(_a.v, _b.v)); }
+inline FloatN Abs(const FloatN& _f) { return FloatN(vabsq_f32(_f.v)); }
+inline FloatN Floor(const FloatN& _f) {
+  // Truncate and step down where that rounded up. Only valid within the int32 range
+  const float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(_f.v));
+  return FloatN(vsubq_f32(t, vreinterpretq_f32_u32(vandq_u32(vcgtq_f32(t, _f.v), vreinterpretq_u32_f32(vdupq_n_f32(1.0f))))));
+}
+inline FloatN RSqrtEst(const FloatN& _f) { return FloatN(vrsqrteq_f32(_f.v)); }
+#if defined(__aarch64__)
+inline FloatN operator/(const FloatN& _a, const FloatN& _b) { return FloatN(vdivq_f32(_a.v, _b.v)); }
+inline FloatN Sqrt(const FloatN& _f) { return FloatN(vsqrtq_f32(_f.v)); }
+inline FloatN Rcp(const FloatN& _f) { return FloatN(vdivq_f32(vdupq_n_f32(1.0f), _f.v)); }
+inline FloatN RSqrt(const FloatN& _f) { return FloatN(vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(_f.v))); }
+inline float HAdd(const FloatN& _f) { return vaddvq_f32(_f.v); }
+#else
+// ARMv7 has no divide or square root, refine the estimates with two Newton-Raphson steps
+inline FloatN Rcp(const FloatN& _f) {
+  float32x4_t e = vrecpeq_f32(_f.v);
+  e = vmulq_f32(e, vrecpsq_f32(_f.v, e));
+  return FloatN(vmulq_f32(e, vrecpsq_f32(_f.v, e)));
+}
+inline FloatN RSqrt(const FloatN& _f) {
+  float32x4_t e = vrsqrteq_f32(_f.v);
+  e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(_f.v, e), e));
+  return FloatN(vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(_f.v, e), e)));
+}
+inline FloatN operator/(const FloatN& _a, const FloatN& _b) { return _a * Rcp(_b); }
+inline FloatN Sqrt(const FloatN& _f) {
+  // sqrt(0) would be 0 * inf
+  return Select(_f == FloatN::zero(), FloatN::zero(), _f * RSqrt(_f));
+}
+inline float HAdd(const FloatN& _f) {
+  const float32x2_t sum = vadd_f32(vget_low_f32(_f.v), vget_high_f32(_f.v));
+  return vget_lane_f32(vpadd_f32(sum, sum), 0);
+}
+#endif
+
+#else // VECTORMATH_WIDE_SCALAR
+
+inline MaskN operator&(const MaskN& _a, const MaskN& _b) { return MaskN(_a.m && _b.m); }
+inline MaskN operator|(const MaskN& _a, const MaskN& _b) { return MaskN(_a.m || _b.m); }
+inline MaskN operator^(const MaskN& _a, const MaskN& _b) { return MaskN(_a.m != _b.m); }
+inline MaskN AndNot(const MaskN& _a, const MaskN& _b) { return MaskN(_a.m && !_b.m); }
+inline uint32_t MoveMask(const MaskN& _m) { return _m.m ? 1U : 0U; }
+inline bool Any(const MaskN& _m) { return _m.m; }
+inline bool All(const MaskN& _m) { return _m.m; }
+
+inline FloatN::FloatN(float _f) : v(_f) {}
+inline FloatN FloatN::zero() { return FloatN(0.0f); }
+inline FloatN FloatN::Load(const float* _p) { return FloatN(*_p); }
+inline FloatN FloatN::LoadU(const float* _p) { return FloatN(*_p); }
+inline void FloatN::Store(float* _p) const { *_p = v; }
+inline void FloatN::StoreU(float* _p) const { *_p = v; }
+
+inline FloatN operator+(const FloatN& _a, const FloatN& _b) { return FloatN(_a.v + _b.v); }
+inline FloatN operator-(const FloatN& _a, const FloatN& _b) { return FloatN(_a.v - _b.v); }
+inline FloatN operator*(const FloatN& _a, const FloatN& _b) { return FloatN(_a.v * _b.v); }
+inline FloatN operator/(const FloatN& _a, const FloatN& _b) { return FloatN(_a.v / _b.v); }
+inline FloatN operator-(const FloatN& _f) { return FloatN(-_f.v); }
+
+inline MaskN operator<(const FloatN& _a, const FloatN& _b) { return MaskN(_a.v < _b.v); }
+inline MaskN operator<=(const FloatN& _a, const FloatN& _b) { return MaskN(_a.v <= _b.v); }
+inline MaskN operator>(const FloatN& _a, const FloatN& _b) { return MaskN(_a.v > _b.v); }
+inline MaskN operator>=(const FloatN& _a, const FloatN& _b) { return MaskN(_a.v >= _b.v); }
+inline MaskN operator==(const FloatN& _a, const FloatN& _b) { return MaskN(_a.v == _b.v); }
+inline MaskN operator!=(const FloatN& _a, const FloatN& _b) { return MaskN(_a.v != _b.v); }
+
+inline FloatN MulAdd(const FloatN& _a, const FloatN& _b, const FloatN& _c) { return FloatN(_a.v * _b.v + _c.v); }
+inline FloatN Select(const MaskN& _m, const FloatN& _a, const FloatN& _b) { return _m.m ? _a : _b; }
+inline FloatN Min(const FloatN& _a, const FloatN& _b) { return FloatN(Min(_a.v, _b.v)); }
+inline FloatN Max(const FloatN& _a, const FloatN& _b) { return FloatN(Max(_a.v, _b.v)); }
+inline FloatN Abs(const FloatN& _f) { return FloatN(fabsf(_f.v)); }
+inline FloatN Floor(const FloatN& _f) { return FloatN(floorf(_f.v)); }
+inline FloatN Sqrt(const FloatN& _f) { return FloatN(sqrtf(_f.v)); }
+inline FloatN Rcp(const FloatN& _f) { return FloatN(1.0f / _f.v); }
+inline FloatN RSqrt(const FloatN& _f) { return FloatN(1.0f / sqrtf(_f.v)); }
+inline FloatN RSqrtEst(const FloatN& _f) { return FloatN(1.0f / sqrtf(_f.v)); }
+inline float HAdd(const FloatN& _f) { return _f.v; }
+
+#endif
+
+} // namespace Wide
+} // namespace Vectormath
+
+#endif // VECTORMATH_WIDE_FLOATN_HPP
+
+//========================================= #ConfettiMathExtensionsEnd ================================================
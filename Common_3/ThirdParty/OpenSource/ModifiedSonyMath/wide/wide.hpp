@@ -0,0 +1,492 @@
+//========================================= #ConfettiMathExtensionsBegin ================================================
+
+/*
+* Copyright (c) 2018 Confetti Interactive Inc.
+*
+* This file is part of The-Forge
+* (see https://github.com/ConfettiFX/The-Forge).
+*
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+* KIND, either express or implied.  See the License for the
+* specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#ifndef VECTORMATH_WIDE_HPP
+#define VECTORMATH_WIDE_HPP
+
+// Templated SoA vector, quaternion and matrix types. Every member holds one
+// component of LaneTraits<T>::Width elements, T being either FloatN (the
+// widest register of the target, see floatn.hpp) or float, which is used to
+// process the elements that are left over at the end of a batch.
+// Unlike soa/, which is fixed to the 4 lanes of Vector4, these types scale to
+// the 8 lanes of AVX2 and the 16 lanes of AVX-512.
+
+#include "floatn.hpp"
+
+namespace Vectormath
+{
+namespace Wide
+{
+
+template <typename T>
+struct WideFloat3 {
+  T x, y, z;
+
+  // Loads Width elements from the component arrays _x, _y and _z.
+  static inline WideFloat3 LoadU(const float* _x, const float* _y, const float* _z) {
+    const WideFloat3 r = {LaneTraits<T>::LoadU(_x), LaneTraits<T>::LoadU(_y), LaneTraits<T>::LoadU(_z)};
+    return r;
+  }
+
+  // Stores Width elements to the component arrays _x, _y and _z.
+  inline void StoreU(float* _x, float* _y, float* _z) const {
+    LaneTraits<T>::StoreU(_x, x);
+    LaneTraits<T>::StoreU(_y, y);
+    LaneTraits<T>::StoreU(_z, z);
+  }
+
+  static inline WideFloat3 Load(const T& _x, const T& _y, const T& _z) {
+    const WideFloat3 r = {_x, _y, _z};
+    return r;
+  }
+
+  static inline WideFloat3 zero() {
+    const WideFloat3 r = {T(0.0f), T(0.0f), T(0.0f)};
+    return r;
+  }
+
+  static inline WideFloat3 one() {
+    const WideFloat3 r = {T(1.0f), T(1.0f), T(1.0f)};
+    return r;
+  }
+};
+
+template <typename T>
+struct WideFloat4 {
+  T x, y, z, w;
+
+  // Loads Width elements from the component arrays _x, _y, _z and _w.
+  static inline WideFloat4 LoadU(const float* _x, const float* _y, const float* _z, const float* _w) {
+    const WideFloat4 r = {LaneTraits<T>::LoadU(_x), LaneTraits<T>::LoadU(_y), LaneTraits<T>::LoadU(_z), LaneTraits<T>::LoadU(_w)};
+    return r;
+  }
+
+  // Stores Width elements to the component arrays _x, _y, _z and _w.
+  inline void StoreU(float* _x, float* _y, float* _z, float* _w) const {
+    LaneTraits<T>::StoreU(_x, x);
+    LaneTraits<T>::StoreU(_y, y);
+    LaneTraits<T>::StoreU(_z, z);
+    LaneTraits<T>::StoreU(_w, w);
+  }
+
+  static inline WideFloat4 Load(const T& _x, const T& _y, const T& _z, const T& _w) {
+    const WideFloat4 r = {_x, _y, _z, _w};
+    return r;
+  }
+
+  static inline WideFloat4 Load(const WideFloat3<T>& _v, const T& _w) {
+    const WideFloat4 r = {_v.x, _v.y, _v.z, _w};
+    return r;
+  }
+
+  static inline WideFloat4 zero() {
+    const WideFloat4 r = {T(0.0f), T(0.0f), T(0.0f), T(0.0f)};
+    return r;
+  }
+
+  static inline WideFloat4 one() {
+    const WideFloat4 r = {T(1.0f), T(1.0f), T(1.0f), T(1.0f)};
+    return r;
+  }
+};
+
+template <typename T>
+struct WideQuaternion {
+  T x, y, z, w;
+
+  // Loads Width quaternions from the component arrays _x, _y, _z and _w.
+  static inline WideQuaternion LoadU(const float* _x, const float* _y, const float* _z, const float* _w) {
+    const WideQuaternion r = {LaneTraits<T>::LoadU(_x), LaneTraits<T>::LoadU(_y), LaneTraits<T>::LoadU(_z), LaneTraits<T>::LoadU(_w)};
+    return r;
+  }
+
+  // Stores Width quaternions to the component arrays _x, _y, _z and _w.
+  inline void StoreU(float* _x, float* _y, float* _z, float* _w) const {
+    LaneTraits<T>::StoreU(_x, x);
+    LaneTraits<T>::StoreU(_y, y);
+    LaneTraits<T>::StoreU(_z, z);
+    LaneTraits<T>::StoreU(_w, w);
+  }
+
+  static inline WideQuaternion identity() {
+    const WideQuaternion r = {T(0.0f), T(0.0f), T(0.0f), T(1.0f)};
+    return r;
+  }
+};
+
+// Column major like Matrix4, cols[3] holds the translation.
+template <typename T>
+struct WideFloat4x4 {
+  WideFloat4<T> cols[4];
+
+  static inline WideFloat4x4 identity() {
+    const T zero(0.0f), one(1.0f);
+    const WideFloat4x4 r = {{{one, zero, zero, zero},
+                             {zero, one, zero, zero},
+                             {zero, zero, one, zero},
+                             {zero, zero, zero, one}}};
+    return r;
+  }
+
+  // Returns _m in all lanes.
+  static inline WideFloat4x4 Broadcast(const Matrix4& _m) {
+    WideFloat4x4 r;
+    for (int c = 0; c < 4; ++c) {
+      const Vector4 col = _m.getCol(c);
+      r.cols[c] = WideFloat4<T>::Load(T((float)col.getX()), T((float)col.getY()), T((float)col.getZ()), T((float)col.getW()));
+    }
+    return r;
+  }
+
+  // Transposes Width matrices into the lanes, lane i is read from
+  // _m[_indices[i]], or from _m[i] if _indices is NULL.
+  static inline WideFloat4x4 Gather(const Matrix4* _m, const uint32_t* _indices = NULL) {
+    const uint32_t width = LaneTraits<T>::Width;
+    float lanes[16 * width];
+    for (uint32_t i = 0; i < width; ++i) {
+      const float* src = reinterpret_cast<const float*>(_m + (_indices ? _indices[i] : i));
+      for (uint32_t f = 0; f < 16; ++f) lanes[f * width + i] = src[f];
+    }
+    WideFloat4x4 r;
+    for (uint32_t c = 0; c < 4; ++c) {
+      const float* col = lanes + c * 4 * width;
+      r.cols[c] = WideFloat4<T>::LoadU(col, col + width, col + 2 * width, col + 3 * width);
+    }
+    return r;
+  }
+
+  // Transposes the lanes back to Width consecutive matrices at _m.
+  inline void Scatter(Matrix4* _m) const {
+    const uint32_t width = LaneTraits<T>::Width;
+    float lanes[16 * width];
+    for (uint32_t c = 0; c < 4; ++c) {
+      float* col = lanes + c * 4 * width;
+      cols[c].StoreU(col, col + width, col + 2 * width, col + 3 * width);
+    }
+    for (uint32_t i = 0; i < width; ++i) {
+      float* dst = reinterpret_cast<float*>(_m + i);
+      for (uint32_t f = 0; f < 16; ++f) dst[f] = lanes[f * width + i];
+    }
+  }
+};
+
+typedef WideFloat3<FloatN> WideFloat3N;
+typedef WideFloat4<FloatN> WideFloat4N;
+typedef WideQuaternion<FloatN> WideQuaternionN;
+typedef WideFloat4x4<FloatN> WideFloat4x4N;
+
+//----------------------------------------------------------------------------
+// WideFloat3 / WideFloat4
+//----------------------------------------------------------------------------
+
+template <typename T>
+inline WideFloat3<T> operator+(const WideFloat3<T>& _a, const WideFloat3<T>& _b) {
+  const WideFloat3<T> r = {_a.x + _b.x, _a.y + _b.y, _a.z + _b.z};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> operator+(const WideFloat4<T>& _a, const WideFloat4<T>& _b) {
+  const WideFloat4<T> r = {_a.x + _b.x, _a.y + _b.y, _a.z + _b.z, _a.w + _b.w};
+  return r;
+}
+
+template <typename T>
+inline WideFloat3<T> operator-(const WideFloat3<T>& _a, const WideFloat3<T>& _b) {
+  const WideFloat3<T> r = {_a.x - _b.x, _a.y - _b.y, _a.z - _b.z};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> operator-(const WideFloat4<T>& _a, const WideFloat4<T>& _b) {
+  const WideFloat4<T> r = {_a.x - _b.x, _a.y - _b.y, _a.z - _b.z, _a.w - _b.w};
+  return r;
+}
+
+template <typename T>
+inline WideFloat3<T> operator-(const WideFloat3<T>& _v) {
+  const WideFloat3<T> r = {-_v.x, -_v.y, -_v.z};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> operator-(const WideFloat4<T>& _v) {
+  const WideFloat4<T> r = {-_v.x, -_v.y, -_v.z, -_v.w};
+  return r;
+}
+
+// Returns the per component product of _a and _b.
+template <typename T>
+inline WideFloat3<T> operator*(const WideFloat3<T>& _a, const WideFloat3<T>& _b) {
+  const WideFloat3<T> r = {_a.x * _b.x, _a.y * _b.y, _a.z * _b.z};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> operator*(const WideFloat4<T>& _a, const WideFloat4<T>& _b) {
+  const WideFloat4<T> r = {_a.x * _b.x, _a.y * _b.y, _a.z * _b.z, _a.w * _b.w};
+  return r;
+}
+
+// Returns _a scaled by _f.
+template <typename T>
+inline WideFloat3<T> operator*(const WideFloat3<T>& _a, const T& _f) {
+  const WideFloat3<T> r = {_a.x * _f, _a.y * _f, _a.z * _f};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> operator*(const WideFloat4<T>& _a, const T& _f) {
+  const WideFloat4<T> r = {_a.x * _f, _a.y * _f, _a.z * _f, _a.w * _f};
+  return r;
+}
+
+template <typename T>
+inline T Dot(const WideFloat3<T>& _a, const WideFloat3<T>& _b) {
+  return MulAdd(_a.x, _b.x, MulAdd(_a.y, _b.y, _a.z * _b.z));
+}
+
+template <typename T>
+inline T Dot(const WideFloat4<T>& _a, const WideFloat4<T>& _b) {
+  return MulAdd(_a.x, _b.x, MulAdd(_a.y, _b.y, MulAdd(_a.z, _b.z, _a.w * _b.w)));
+}
+
+template <typename T>
+inline WideFloat3<T> CrossProduct(const WideFloat3<T>& _a, const WideFloat3<T>& _b) {
+  const WideFloat3<T> r = {_a.y * _b.z - _b.y * _a.z, _a.z * _b.x - _b.z * _a.x, _a.x * _b.y - _b.x * _a.y};
+  return r;
+}
+
+template <typename T>
+inline T LengthSqr(const WideFloat3<T>& _v) { return Dot(_v, _v); }
+
+template <typename T>
+inline T LengthSqr(const WideFloat4<T>& _v) { return Dot(_v, _v); }
+
+template <typename T>
+inline T Length(const WideFloat3<T>& _v) { return Sqrt(Dot(_v, _v)); }
+
+template <typename T>
+inline T Length(const WideFloat4<T>& _v) { return Sqrt(Dot(_v, _v)); }
+
+// Returns _v normalized, _v must not be zero length.
+template <typename T>
+inline WideFloat3<T> Normalize(const WideFloat3<T>& _v) {
+  return _v * RSqrt(Dot(_v, _v));
+}
+
+template <typename T>
+inline WideFloat4<T> Normalize(const WideFloat4<T>& _v) {
+  return _v * RSqrt(Dot(_v, _v));
+}
+
+// Returns _v normalized with the reciprocal square root estimate.
+template <typename T>
+inline WideFloat3<T> NormalizeEst(const WideFloat3<T>& _v) {
+  return _v * RSqrtEst(Dot(_v, _v));
+}
+
+template <typename T>
+inline WideFloat4<T> NormalizeEst(const WideFloat4<T>& _v) {
+  return _v * RSqrtEst(Dot(_v, _v));
+}
+
+// Returns _a + (_b - _a) * _alpha.
+template <typename T>
+inline WideFloat3<T> Lerp(const WideFloat3<T>& _a, const WideFloat3<T>& _b, const T& _alpha) {
+  const WideFloat3<T> r = {MulAdd(_b.x - _a.x, _alpha, _a.x), MulAdd(_b.y - _a.y, _alpha, _a.y), MulAdd(_b.z - _a.z, _alpha, _a.z)};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> Lerp(const WideFloat4<T>& _a, const WideFloat4<T>& _b, const T& _alpha) {
+  const WideFloat4<T> r = {MulAdd(_b.x - _a.x, _alpha, _a.x), MulAdd(_b.y - _a.y, _alpha, _a.y), MulAdd(_b.z - _a.z, _alpha, _a.z),
+                           MulAdd(_b.w - _a.w, _alpha, _a.w)};
+  return r;
+}
+
+template <typename T>
+inline WideFloat3<T> Min(const WideFloat3<T>& _a, const WideFloat3<T>& _b) {
+  const WideFloat3<T> r = {Min(_a.x, _b.x), Min(_a.y, _b.y), Min(_a.z, _b.z)};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> Min(const WideFloat4<T>& _a, const WideFloat4<T>& _b) {
+  const WideFloat4<T> r = {Min(_a.x, _b.x), Min(_a.y, _b.y), Min(_a.z, _b.z), Min(_a.w, _b.w)};
+  return r;
+}
+
+template <typename T>
+inline WideFloat3<T> Max(const WideFloat3<T>& _a, const WideFloat3<T>& _b) {
+  const WideFloat3<T> r = {Max(_a.x, _b.x), Max(_a.y, _b.y), Max(_a.z, _b.z)};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> Max(const WideFloat4<T>& _a, const WideFloat4<T>& _b) {
+  const WideFloat4<T> r = {Max(_a.x, _b.x), Max(_a.y, _b.y), Max(_a.z, _b.z), Max(_a.w, _b.w)};
+  return r;
+}
+
+// Returns _v clamped to [_a, _b].
+template <typename T>
+inline WideFloat3<T> Clamp(const WideFloat3<T>& _a, const WideFloat3<T>& _v, const WideFloat3<T>& _b) {
+  return Max(_a, Min(_v, _b));
+}
+
+template <typename T>
+inline WideFloat4<T> Clamp(const WideFloat4<T>& _a, const WideFloat4<T>& _v, const WideFloat4<T>& _b) {
+  return Max(_a, Min(_v, _b));
+}
+
+//----------------------------------------------------------------------------
+// WideQuaternion
+//----------------------------------------------------------------------------
+
+// Returns the rotation _b followed by _a, as Quat::operator*.
+template <typename T>
+inline WideQuaternion<T> operator*(const WideQuaternion<T>& _a, const WideQuaternion<T>& _b) {
+  const WideQuaternion<T> r = {
+    MulAdd(_a.w, _b.x, MulAdd(_a.x, _b.w, _a.y * _b.z - _a.z * _b.y)),
+    MulAdd(_a.w, _b.y, MulAdd(_a.y, _b.w, _a.z * _b.x - _a.x * _b.z)),
+    MulAdd(_a.w, _b.z, MulAdd(_a.z, _b.w, _a.x * _b.y - _a.y * _b.x)),
+    _a.w * _b.w - MulAdd(_a.x, _b.x, MulAdd(_a.y, _b.y, _a.z * _b.z))};
+  return r;
+}
+
+template <typename T>
+inline WideQuaternion<T> Conjugate(const WideQuaternion<T>& _q) {
+  const WideQuaternion<T> r = {-_q.x, -_q.y, -_q.z, _q.w};
+  return r;
+}
+
+template <typename T>
+inline T Dot(const WideQuaternion<T>& _a, const WideQuaternion<T>& _b) {
+  return MulAdd(_a.x, _b.x, MulAdd(_a.y, _b.y, MulAdd(_a.z, _b.z, _a.w * _b.w)));
+}
+
+template <typename T>
+inline WideQuaternion<T> Normalize(const WideQuaternion<T>& _q) {
+  const T inv = RSqrt(Dot(_q, _q));
+  const WideQuaternion<T> r = {_q.x * inv, _q.y * inv, _q.z * inv, _q.w * inv};
+  return r;
+}
+
+// Returns the normalized linear interpolation of _a and _b along the shortest
+// path.
+template <typename T>
+inline WideQuaternion<T> NLerp(const WideQuaternion<T>& _a, const WideQuaternion<T>& _b, const T& _alpha) {
+  const T sign = Select(Dot(_a, _b) < T(0.0f), T(-1.0f), T(1.0f));
+  const T alpha = _alpha * sign;
+  const T beta = T(1.0f) - _alpha;
+  const WideQuaternion<T> r = {MulAdd(_b.x, alpha, _a.x * beta), MulAdd(_b.y, alpha, _a.y * beta), MulAdd(_b.z, alpha, _a.z * beta),
+                               MulAdd(_b.w, alpha, _a.w * beta)};
+  return Normalize(r);
+}
+
+// Returns _v rotated by the unit quaternion _q.
+template <typename T>
+inline WideFloat3<T> TransformVector(const WideQuaternion<T>& _q, const WideFloat3<T>& _v) {
+  const WideFloat3<T> axis = {_q.x, _q.y, _q.z};
+  const WideFloat3<T> t = CrossProduct(axis, _v) * T(2.0f);
+  return _v + t * _q.w + CrossProduct(axis, t);
+}
+
+//----------------------------------------------------------------------------
+// WideFloat4x4
+//----------------------------------------------------------------------------
+
+// Returns the affine transform scaling by _s, rotating by the unit quaternion
+// _r and translating by _t, as Matrix4(Quat, Vector3) * Matrix4::scale.
+template <typename T>
+inline WideFloat4x4<T> FromAffine(const WideFloat3<T>& _t, const WideQuaternion<T>& _r, const WideFloat3<T>& _s) {
+  const T x2 = _r.x + _r.x, y2 = _r.y + _r.y, z2 = _r.z + _r.z;
+  const T xx = _r.x * x2, yy = _r.y * y2, zz = _r.z * z2;
+  const T xy = _r.x * y2, xz = _r.x * z2, yz = _r.y * z2;
+  const T wx = _r.w * x2, wy = _r.w * y2, wz = _r.w * z2;
+  const T one(1.0f), zero(0.0f);
+  const WideFloat4x4<T> r = {{{(one - yy - zz) * _s.x, (xy + wz) * _s.x, (xz - wy) * _s.x, zero},
+                              {(xy - wz) * _s.y, (one - xx - zz) * _s.y, (yz + wx) * _s.y, zero},
+                              {(xz + wy) * _s.z, (yz - wx) * _s.z, (one - xx - yy) * _s.z, zero},
+                              {_t.x, _t.y, _t.z, one}}};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4<T> operator*(const WideFloat4x4<T>& _m, const WideFloat4<T>& _v) {
+  const WideFloat4<T> r = {
+    MulAdd(_m.cols[0].x, _v.x, MulAdd(_m.cols[1].x, _v.y, MulAdd(_m.cols[2].x, _v.z, _m.cols[3].x * _v.w))),
+    MulAdd(_m.cols[0].y, _v.x, MulAdd(_m.cols[1].y, _v.y, MulAdd(_m.cols[2].y, _v.z, _m.cols[3].y * _v.w))),
+    MulAdd(_m.cols[0].z, _v.x, MulAdd(_m.cols[1].z, _v.y, MulAdd(_m.cols[2].z, _v.z, _m.cols[3].z * _v.w))),
+    MulAdd(_m.cols[0].w, _v.x, MulAdd(_m.cols[1].w, _v.y, MulAdd(_m.cols[2].w, _v.z, _m.cols[3].w * _v.w)))};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4x4<T> operator*(const WideFloat4x4<T>& _a, const WideFloat4x4<T>& _b) {
+  const WideFloat4x4<T> r = {{_a * _b.cols[0], _a * _b.cols[1], _a * _b.cols[2], _a * _b.cols[3]}};
+  return r;
+}
+
+// Returns _p transformed by the affine matrix _m, the projective row is ignored.
+template <typename T>
+inline WideFloat3<T> TransformPoint(const WideFloat4x4<T>& _m, const WideFloat3<T>& _p) {
+  const WideFloat3<T> r = {
+    MulAdd(_m.cols[0].x, _p.x, MulAdd(_m.cols[1].x, _p.y, MulAdd(_m.cols[2].x, _p.z, _m.cols[3].x))),
+    MulAdd(_m.cols[0].y, _p.x, MulAdd(_m.cols[1].y, _p.y, MulAdd(_m.cols[2].y, _p.z, _m.cols[3].y))),
+    MulAdd(_m.cols[0].z, _p.x, MulAdd(_m.cols[1].z, _p.y, MulAdd(_m.cols[2].z, _p.z, _m.cols[3].z)))};
+  return r;
+}
+
+// Returns _v transformed by the upper 3x3 of _m.
+template <typename T>
+inline WideFloat3<T> TransformVector(const WideFloat4x4<T>& _m, const WideFloat3<T>& _v) {
+  const WideFloat3<T> r = {
+    MulAdd(_m.cols[0].x, _v.x, MulAdd(_m.cols[1].x, _v.y, _m.cols[2].x * _v.z)),
+    MulAdd(_m.cols[0].y, _v.x, MulAdd(_m.cols[1].y, _v.y, _m.cols[2].y * _v.z)),
+    MulAdd(_m.cols[0].z, _v.x, MulAdd(_m.cols[1].z, _v.y, _m.cols[2].z * _v.z))};
+  return r;
+}
+
+template <typename T>
+inline WideFloat4x4<T> Transpose(const WideFloat4x4<T>& _m) {
+  const WideFloat4x4<T> r = {{{_m.cols[0].x, _m.cols[1].x, _m.cols[2].x, _m.cols[3].x},
+                              {_m.cols[0].y, _m.cols[1].y, _m.cols[2].y, _m.cols[3].y},
+                              {_m.cols[0].z, _m.cols[1].z, _m.cols[2].z, _m.cols[3].z},
+                              {_m.cols[0].w, _m.cols[1].w, _m.cols[2].w, _m.cols[3].w}}};
+  return r;
+}
+
+} // namespace Wide
+} // namespace Vectormath
+
+#include "batch.hpp"
+
+#endif // VECTORMATH_WIDE_HPP
+
+//========================================= #ConfettiMathExtensionsEnd ================================================
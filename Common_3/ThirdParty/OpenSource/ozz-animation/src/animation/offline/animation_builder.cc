@@ -44,7 +44,7 @@
 
 // Internal include file
 #define OZZ_INCLUDE_PRIVATE_HEADER  // Allows to include private headers.
-#include "animation/runtime/animation_keyframe.h"
+#include "../runtime/animation_keyframe.h" //CONFFX_BEGIN - relative include, src is not an include path of the projects
 
 namespace ozz {
 namespace animation {
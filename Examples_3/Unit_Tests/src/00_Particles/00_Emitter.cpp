@@ -8,6 +8,9 @@
 #undef max
 #undef min
 
+using Vectormath::Wide::FloatN;
+using Vectormath::Wide::MulAdd;
+
 namespace
 {
 
@@ -51,8 +54,10 @@ const auto FLOATS_PER_OUT_ELEMENT = 4;
 
 } // namespace
 
-Emitter::Emitter(const int _maxParticlesCount, const int _stylesCount)
+Emitter::Emitter(const int _maxParticlesCount, const int _stylesCount, ThreadPool* const threadPool)
 	:
+	sorted(false),
+	sorter(nullptr),
 	maxParticlesCount(_maxParticlesCount), 
 	stylesCount(_stylesCount),
 	timeRest(0.0)
@@ -60,53 +65,160 @@ Emitter::Emitter(const int _maxParticlesCount, const int _stylesCount)
 	ASSERT(0 < maxParticlesCount);
 	ASSERT(0 < stylesCount);
 
-	particles.reserve(_maxParticlesCount);
+	positionsX.reserve(_maxParticlesCount);
+	positionsY.reserve(_maxParticlesCount);
+	positionsZ.reserve(_maxParticlesCount);
+	aliveTimes.reserve(_maxParticlesCount);
+	styleNumbers.reserve(_maxParticlesCount);
+
+	sortKeys.reserve(_maxParticlesCount);
+	sortedIndices.reserve(_maxParticlesCount);
+	addRadixSorter(threadPool, &sorter);
 
 	outPositions.reserve(_maxParticlesCount * FLOATS_PER_OUT_ELEMENT);
 	outBehaviors.reserve(_maxParticlesCount * FLOATS_PER_OUT_ELEMENT);
 }
 
-void Emitter::emitParticle(const int index, const float startTime)
+Emitter::~Emitter()
 {
-	ASSERT(0 <= index && checkedCast(particles.size()) > index);
+	removeRadixSorter(sorter);
+}
 
-	auto& particle = particles[index];
-	particle.aliveTime = startTime;
-	particle.styleNumber = static_cast<float>(rand() % stylesCount);
-	particle.position = EMITTER_POSITION + randomShift(EMITTER_EMIT_CUBE_HALF_SIZE) + PARTICLES_VELOCITY * startTime;
+void Emitter::emitParticle(const int index, const float startTime)
+{
+	ASSERT(0 <= index && checkedCast(aliveTimes.size()) > index);
+
+	const auto position = EMITTER_POSITION + randomShift(EMITTER_EMIT_CUBE_HALF_SIZE) + PARTICLES_VELOCITY * startTime;
+	positionsX[index] = position.getX();
+	positionsY[index] = position.getY();
+	positionsZ[index] = position.getZ();
+	aliveTimes[index] = startTime;
+	styleNumbers[index] = static_cast<float>(rand() % stylesCount);
 }
 
-void Emitter::removeDeadParticles()
+void Emitter::moveParticles(const float timeDeltaSeconds)
 {
-	ASSERT( std::is_sorted(dead.begin(), dead.end()) );
+	// Dead particles move as well: they are emitted again or removed right after
+	const auto count = aliveTimes.size();
+	const auto moveX = PARTICLES_VELOCITY.getX() * timeDeltaSeconds;
+	const auto moveY = PARTICLES_VELOCITY.getY() * timeDeltaSeconds;
+	const auto moveZ = PARTICLES_VELOCITY.getZ() * timeDeltaSeconds;
+
+	const FloatN timeDelta(timeDeltaSeconds);
+	const FloatN moveXN(moveX);
+	const FloatN moveYN(moveY);
+	const FloatN moveZN(moveZ);
+
+	auto i = 0u;
+	for (; i + FloatN::Width <= count; i += FloatN::Width)
+	{
+		(FloatN::LoadU(&aliveTimes[i]) + timeDelta).StoreU(&aliveTimes[i]);
+		(FloatN::LoadU(&positionsX[i]) + moveXN).StoreU(&positionsX[i]);
+		(FloatN::LoadU(&positionsY[i]) + moveYN).StoreU(&positionsY[i]);
+		(FloatN::LoadU(&positionsZ[i]) + moveZN).StoreU(&positionsZ[i]);
+	}
 
-	for (int i = checkedCast(dead.size()) - 1; i >= 0; --i)
+	for (; i < count; ++i)
 	{
-		if (i != checkedCast(particles.size()) - 1)
+		aliveTimes[i] += timeDeltaSeconds;
+		positionsX[i] += moveX;
+		positionsY[i] += moveY;
+		positionsZ[i] += moveZ;
+	}
+}
+
+int Emitter::removeDeadParticles(int particlesToEmit)
+{
+	// Dead particles are emitted again in place while there are particles to emit, the rest of them are compacted out.
+	// Alive particles keep their order
+	const auto count = checkedCast(aliveTimes.size());
+	const FloatN lifeLength(LIFE_LENGTH_SECONDS);
+
+	auto write = 0;
+	auto i = 0;
+	while (i < count)
+	{
+		auto deadMask = 0u;
+		auto chunkSize = 1;
+
+		if (i + static_cast<int>(FloatN::Width) <= count)
 		{
-			particles[i] = particles.back();
+			deadMask = MoveMask(FloatN::LoadU(&aliveTimes[i]) > lifeLength);
+			chunkSize = FloatN::Width;
+
+			if (0 == deadMask && write == i)
+			{
+				write += chunkSize;
+				i += chunkSize;
+				continue;
+			}
+		}
+		else
+		{
+			deadMask = LIFE_LENGTH_SECONDS < aliveTimes[i] ? 1u : 0u;
+		}
+
+		for (auto lane = 0; lane < chunkSize; ++lane, ++i)
+		{
+			if (0 == (deadMask & (1u << lane)))
+			{
+				if (write != i)
+				{
+					positionsX[write] = positionsX[i];
+					positionsY[write] = positionsY[i];
+					positionsZ[write] = positionsZ[i];
+					aliveTimes[write] = aliveTimes[i];
+					styleNumbers[write] = styleNumbers[i];
+				}
+				++write;
+			}
+			else if (0 < particlesToEmit)
+			{
+				emitParticle(write, (particlesToEmit - 1) * PARTICLE_EMIT_PERIOD);
+				--particlesToEmit;
+				++write;
+			}
 		}
 	}
 
-	particles.resize(particles.size() - dead.size());
+	positionsX.resize(write);
+	positionsY.resize(write);
+	positionsZ.resize(write);
+	aliveTimes.resize(write);
+	styleNumbers.resize(write);
+
+	return particlesToEmit;
 }
 
 void Emitter::sort(const mat4& viewerFrame)
 {
 	const auto Z_AXIS = 2;
+	const auto axis = viewerFrame[Z_AXIS];
+
+	const auto count = aliveTimes.size();
+	sortKeys.resize(count);
+	sortedIndices.resize(count);
 
-	for (auto& particle : particles)
+	const FloatN axisX(axis.getX());
+	const FloatN axisY(axis.getY());
+	const FloatN axisZ(axis.getZ());
+	const FloatN axisW(axis.getW());
+
+	auto i = 0u;
+	for (; i + FloatN::Width <= count; i += FloatN::Width)
 	{
-		particle.cameraSpaceZ = dot(viewerFrame[Z_AXIS], vec4{particle.position, 1.0f});
+		const auto z = MulAdd(FloatN::LoadU(&positionsZ[i]), axisZ,
+			MulAdd(FloatN::LoadU(&positionsY[i]), axisY, MulAdd(FloatN::LoadU(&positionsX[i]), axisX, axisW)));
+		z.StoreU(&sortKeys[i]);
 	}
 
-	std::sort(particles.begin(), particles.end()
-	, 
-		[](const auto& left, const auto& right)
-		{
-			return left.cameraSpaceZ < right.cameraSpaceZ;
-		}
-	);
+	for (; i < count; ++i)
+	{
+		sortKeys[i] = MulAdd(positionsZ[i], axis.getZ(), MulAdd(positionsY[i], axis.getY(), MulAdd(positionsX[i], axis.getX(), axis.getW())));
+	}
+
+	radixSortFloatKeys(sorter, sortKeys.data(), static_cast<uint32_t>(count), false, sortedIndices.data());
+	sorted = true;
 }
 
 void Emitter::update(const float timeDeltaSeconds)
@@ -118,48 +230,31 @@ void Emitter::update(const float timeDeltaSeconds)
 		return;
 	}
 
-	dead.clear();
+	sorted = false;
 
 	const auto effectiveTimeDelta = std::min(timeDeltaSeconds, MAX_TIME_DELTA) + timeRest;
 	auto particlesToEmit = static_cast<int>(effectiveTimeDelta * PARTICLES_PER_SECOND);
 
 	timeRest = effectiveTimeDelta - (particlesToEmit * PARTICLE_EMIT_PERIOD);
 
-	if (checkedCast(particles.size()) + particlesToEmit > maxParticlesCount)
+	if (getAliveParticlesCount() + particlesToEmit > maxParticlesCount)
 	{
-		particlesToEmit = maxParticlesCount - checkedCast(particles.size());
+		particlesToEmit = maxParticlesCount - getAliveParticlesCount();
 	}
 
-	for (auto i = 0u; i < particles.size(); ++i)
-	{
-		auto& particle = particles[i];
-
-		particle.aliveTime += timeDeltaSeconds;
-
-		if (LIFE_LENGTH_SECONDS < particle.aliveTime)
-		{
-			if (0 < particlesToEmit)
-			{
-				emitParticle(i, (particlesToEmit - 1) * PARTICLE_EMIT_PERIOD);
-				--particlesToEmit;
-			}
-			else
-			{
-				dead.push_back(i);
-			}
-		}
-		else
-		{
-			particle.position += PARTICLES_VELOCITY * timeDeltaSeconds;
-		}
-	}
+	moveParticles(timeDeltaSeconds);
+	particlesToEmit = removeDeadParticles(particlesToEmit);
 
 	if (0 < particlesToEmit)
 	{
-		ASSERT(dead.empty());
+		auto emitIndex = aliveTimes.size();
+		const auto newCount = aliveTimes.size() + particlesToEmit;
 
-		auto emitIndex = particles.size();
-		particles.resize(particles.size() + particlesToEmit);
+		positionsX.resize(newCount);
+		positionsY.resize(newCount);
+		positionsZ.resize(newCount);
+		aliveTimes.resize(newCount);
+		styleNumbers.resize(newCount);
 
 		while (0 < particlesToEmit)
 		{
@@ -168,26 +263,24 @@ void Emitter::update(const float timeDeltaSeconds)
 			--particlesToEmit;
 		}
 	}
-	else
-	{
-		removeDeadParticles();
-	}
 }
 
 int Emitter::getAliveParticlesCount() const
 {
-	return checkedCast(particles.size());
+	return checkedCast(aliveTimes.size());
 }
 
 const float* Emitter::getPositions()
 {
 	outPositions.clear();
 
-	for (auto& particle : particles)
+	for (auto i = 0u; i < aliveTimes.size(); ++i)
 	{
-		outPositions.push_back(particle.position.getX());
-		outPositions.push_back(particle.position.getY());
-		outPositions.push_back(particle.position.getZ());
+		const auto particle = sorted ? sortedIndices[i] : i;
+
+		outPositions.push_back(positionsX[particle]);
+		outPositions.push_back(positionsY[particle]);
+		outPositions.push_back(positionsZ[particle]);
 		outPositions.push_back(0.0f);
 	}
 
@@ -197,11 +290,13 @@ const float* Emitter::getPositions()
 const float* Emitter::getBehaviors()
 {
 	outBehaviors.clear();
-	
-	for (auto& particle : particles)
+
+	for (auto i = 0u; i < aliveTimes.size(); ++i)
 	{
-		outBehaviors.push_back(particle.aliveTime);
-		outBehaviors.push_back(particle.styleNumber);
+		const auto particle = sorted ? sortedIndices[i] : i;
+
+		outBehaviors.push_back(aliveTimes[particle]);
+		outBehaviors.push_back(styleNumbers[particle]);
 		outBehaviors.push_back(0.0f);
 		outBehaviors.push_back(0.0f);
 	}
@@ -3,57 +3,59 @@
 #include <vector>
 
 #include "../../../../Common_3/OS/Math/MathTypes.h"
+#include "../../../../Common_3/OS/Core/RadixSort.h"
+
+class ThreadPool;
 
 class Emitter final
 {
 private:
 
-	struct Particle final
-	{
-		Particle()
-			:
-			position(0),
-			cameraSpaceZ(0),
-			aliveTime(0),
-			styleNumber(0)
-		{
-		}
-
-		vec3 position;
-		
-		float cameraSpaceZ;
-		float aliveTime;
-		float styleNumber;
-	};
-
-	std::vector<Particle> particles;
+	// Particles are stored as one array per component, so the update and the sort keys are computed FloatN::Width
+	// particles at a time
+	std::vector<float> positionsX;
+	std::vector<float> positionsY;
+	std::vector<float> positionsZ;
+	std::vector<float> aliveTimes;
+	std::vector<float> styleNumbers;
+
+	// Particle order of the last sort, only the indices are sorted
+	std::vector<float> sortKeys;
+	std::vector<uint32_t> sortedIndices;
+	bool sorted;
+	RadixSorter* sorter;
 
 	std::vector<float> outPositions;
 	std::vector<float> outBehaviors;
 
-	std::vector<int> dead;
-
 	const int maxParticlesCount;
 	const int stylesCount;
 
 	float timeRest;
 
 	void emitParticle(int index, float startTime);
-	void removeDeadParticles();
+	void moveParticles(float timeDeltaSeconds);
+	int removeDeadParticles(int particlesToEmit);
 
 public:
 
 	static constexpr auto LIFE_LENGTH_SECONDS = 8.0f;
 
-	Emitter(int maxParticlesCount, int stylesCount);
+	// The sort runs its jobs on threadPool if there is one
+	Emitter(int maxParticlesCount, int stylesCount, ThreadPool* threadPool = nullptr);
+	~Emitter();
+
+	Emitter(const Emitter&) = delete;
+	Emitter& operator=(const Emitter&) = delete;
 
 	void update(float timeDeltaSeconds);
 
 	int getAliveParticlesCount() const;
 
+	// Orders the particles by their z in the camera frame for getPositions and getBehaviors, until the next update
 	void sort(const mat4& camera);
 
 	const float* getPositions();
 	const float* getBehaviors();
 
-};
\ No newline at end of file
+};
@@ -163,6 +163,14 @@ struct ThreadData
 	float mDeltaTime;
 };
 
+struct AsteroidUpdateData
+{
+	vec3 mCameraPosition;
+	uint32_t mStartIndex;
+	uint32_t mEndIndex;
+	float mDeltaTime;
+};
+
 struct Vertex
 {
 	vec4 mPosition;
@@ -182,12 +190,17 @@ const uint32_t		  gNumAsteroids = 50000U;   // 50000 is optimal.
 const uint32_t		  gNumSubsets = 1;		 // 4 is optimal. Also equivalent to the number of threads used.
 const uint32_t		  gNumAsteroidsPerSubset = (gNumAsteroids + gNumSubsets - 1) / gNumSubsets;
 const uint32_t		  gTextureCount = 10;
+// The CPU update is split in more tasks than threads so the pool can balance them
+const uint32_t		  gNumAsteroidUpdateTasks = 64;
 
 const uint32_t		  gImageCount = 3;
 
 AsteroidSimulation	  gAsteroidSim;
 tinystl::vector<Subset> gAsteroidSubsets;
 ThreadData			  gThreadData[gNumSubsets];
+AsteroidUpdateData	  gAsteroidUpdateData[gNumAsteroidUpdateTasks];
+WorkItem				gAsteroidUpdateWorkItems[gNumAsteroidUpdateTasks];
+HiresTimer			  gAsteroidUpdateTimer;
 Texture*				pAsteroidTex = NULL;
 bool					gUseThreads = true;
 bool					gToggleVSync = false;
@@ -379,7 +392,7 @@ public:
 
 		CreateSubsets();
 
-		gThreadSystem.CreateThreads(gNumSubsets);
+		gThreadSystem.CreateThreads(max(gNumSubsets, Thread::GetNumCPUCores() - 1));
 
 		ShaderLoadDesc instanceShader = {};
 		instanceShader.mStages[0] = { "basic.vert", NULL, 0, FSR_SrcShaders };
@@ -1060,6 +1073,10 @@ public:
 		/************************************************************************/
 		if (gRenderingMode != RenderingMode_GPUUpdate)
 		{
+			gAsteroidUpdateTimer.Reset();
+			UpdateAsteroids(frameTime, pCameraController->getViewPosition());
+			gAsteroidUpdateTimer.GetUSec(true);
+
 			if (gUseThreads)
 			{
 				// With Multithreading
@@ -1240,6 +1257,8 @@ public:
 
 		sprintf(buff, "SPACE - Rendering mode - %s", modeStr);
 		drawDebugText(cmd, 8, 65, buff, NULL);
+		if (gRenderingMode != RenderingMode_GPUUpdate)
+			drawDebugText(cmd, 300, 15, tinystl::string::format("Asteroid Update %f ms", gAsteroidUpdateTimer.GetUSecAverage() / 1000.0f), &gFrameTimeDraw);
 
 #ifndef TARGET_IOS
 		drawDebugText(cmd, 8, 80, "F1 - Toggle UI", NULL);
@@ -1677,8 +1696,6 @@ public:
 
 		beginCmd(cmd);
 
-		gAsteroidSim.update(deltaTime, startIdx, endIdx, pCameraController->getViewPosition());
-
 		vec4 frustumPlanes[6];
 		mat4::extractFrustumClipPlanes(viewProj, frustumPlanes[0], frustumPlanes[1], frustumPlanes[2], frustumPlanes[3],
 			frustumPlanes[4], frustumPlanes[5], true);
@@ -1814,6 +1831,38 @@ public:
 		endCmd(cmd);
 	}
 
+	static void UpdateAsteroidsTask(void* pData)
+	{
+		AsteroidUpdateData* data = (AsteroidUpdateData*)pData;
+		gAsteroidSim.update(data->mDeltaTime, data->mStartIndex, data->mEndIndex, data->mCameraPosition);
+	}
+
+	static void UpdateAsteroids(float deltaTime, const vec3& cameraPosition)
+	{
+		if (!gUseThreads)
+		{
+			gAsteroidSim.update(deltaTime, 0, gNumAsteroids, cameraPosition);
+			return;
+		}
+
+		// Task ranges start on a multiple of 8 so every task runs full SIMD iterations
+		const uint32_t asteroidsPerTask = ((gNumAsteroids + gNumAsteroidUpdateTasks - 1) / gNumAsteroidUpdateTasks + 7) & ~7U;
+		uint32_t taskCount = 0;
+		for (uint32_t startIdx = 0; startIdx < gNumAsteroids; startIdx += asteroidsPerTask, ++taskCount)
+		{
+			AsteroidUpdateData& data = gAsteroidUpdateData[taskCount];
+			data.mCameraPosition = cameraPosition;
+			data.mStartIndex = startIdx;
+			data.mEndIndex = min(startIdx + asteroidsPerTask, gNumAsteroids);
+			data.mDeltaTime = deltaTime;
+			gAsteroidUpdateWorkItems[taskCount].pFunc = UpdateAsteroidsTask;
+			gAsteroidUpdateWorkItems[taskCount].pData = &data;
+			gThreadSystem.AddWorkItem(&gAsteroidUpdateWorkItems[taskCount]);
+		}
+
+		gThreadSystem.Complete(0);
+	}
+
 	static void RenderSubset(void* pData)
 	{
 		// For multithreading call
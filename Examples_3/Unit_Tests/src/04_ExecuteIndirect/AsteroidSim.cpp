@@ -50,19 +50,22 @@
 
 #include "AsteroidSim.h"
 #include "Random.h"
-#if !defined(TARGET_IOS)
+
+// The update runs on as many asteroids per instruction as the target allows. Asteroids left over at the end of a range use the scalar path
+#if defined(__AVX__)
 #include <immintrin.h>
+#define ASTEROID_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ASTEROID_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ASTEROID_NEON
 #endif
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
-#if defined(_MSC_VER)
-#define ALIGNED_(x) __declspec(align(x))
-#else
-#define ALIGNED_(x) __attribute__ ((aligned(x)))
-#endif
-
 vec3 RandomPointOnSphere(MyRandom& rng)
 {
 	float angleDist = rng.GetUniformDistribution(-PI, PI);
@@ -111,6 +114,15 @@ void AsteroidSimulation::Init(
 
 	uint32_t instancesPerMesh = MAX(1, numAsteroids / numMeshes);
 
+	asteroidsStatic.reserve(numAsteroids);
+	asteroidsDynamic.reserve(numAsteroids);
+
+	float** stateArrays = &state.orbitCos;
+	const uint32_t stateArrayCount = sizeof(AsteroidState) / sizeof(float*);
+	stateStorage.resize(stateArrayCount * numAsteroids);
+	for (uint32_t i = 0; i < stateArrayCount; ++i)
+		stateArrays[i] = stateStorage.data() + i * numAsteroids;
+
 	for (unsigned i = 0; i < numAsteroids; ++i)
 	{
 		float orbitRadiusDist = rng.GetNormalDistribution(orbitRadius, 0.6f * discRadius);
@@ -154,6 +166,21 @@ void AsteroidSimulation::Init(
 		mat4 orbit = mat4::rotation(orbitAngle, vec3(0, 1, 0));
 		dynamicAsteroid.transform = orbit * translate * scaleMat;
 		asteroidsDynamic.push_back(dynamicAsteroid);
+
+		state.orbitCos[i] = cosf(orbitAngle);
+		state.orbitSin[i] = sinf(orbitAngle);
+		state.orbitRadius[i] = orbitRadius;
+		state.orbitHeight[i] = height;
+		state.orbitSpeed[i] = staticAsteroid.orbitSpeed;
+		state.spinX[i] = 0.0f;
+		state.spinY[i] = 0.0f;
+		state.spinZ[i] = 0.0f;
+		state.spinW[i] = 1.0f;
+		state.axisX[i] = staticAsteroid.rotationAxis.getX();
+		state.axisY[i] = staticAsteroid.rotationAxis.getY();
+		state.axisZ[i] = staticAsteroid.rotationAxis.getZ();
+		state.rotationSpeed[i] = staticAsteroid.rotationSpeed;
+		state.scale[i] = staticAsteroid.scale;
 	}
 }
 
@@ -165,111 +192,261 @@ static inline float VeryApproxLog2f(float x)
 	return (float)ux.i * 1.1920928955078125e-7f - 126.94269504f;
 }
 
-void AsteroidSimulation::update(float deltaTime, unsigned startIdx, unsigned endIdx, const vec3& cameraPosition)
+// Operations the update is written with. Every instruction set provides the same functions on its own register type
+struct ScalarLanes
 {
-	//taken from intel demo
-	static const float minSubdivSizeLog2 = log2f(0.0019f);
+	typedef float Float;
+	static const uint32_t Count = 1;
+
+	static inline Float load(const float* p) { return *p; }
+	static inline void store(float* p, Float a) { *p = a; }
+	static inline Float set(float a) { return a; }
+	static inline Float add(Float a, Float b) { return a + b; }
+	static inline Float sub(Float a, Float b) { return a - b; }
+	static inline Float mul(Float a, Float b) { return a * b; }
+	static inline Float mulAdd(Float a, Float b, Float c) { return a * b + c; }
+	static inline Float max(Float a, Float b) { return MAX(a, b); }
+	static inline Float abs(Float a) { return fabsf(a); }
+	static inline Float round(Float a) { return floorf(a + 0.5f); }
+	static inline Float invSqrt(Float a) { return 1.0f / sqrtf(a); }
+	static inline Float approxLog2(Float a) { return VeryApproxLog2f(a); }
+	static inline void storeTruncated(int32_t* p, Float a) { *p = (int32_t)a; }
+};
 
-	for (unsigned i = startIdx; i < endIdx; ++i)
+#if defined(ASTEROID_AVX)
+struct SimdLanes
+{
+	typedef __m256 Float;
+	static const uint32_t Count = 8;
+
+	static inline Float load(const float* p) { return _mm256_loadu_ps(p); }
+	static inline void store(float* p, Float a) { _mm256_storeu_ps(p, a); }
+	static inline Float set(float a) { return _mm256_set1_ps(a); }
+	static inline Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	static inline Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	static inline Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+#if defined(__FMA__) || defined(__AVX2__)
+	static inline Float mulAdd(Float a, Float b, Float c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+	// XBoxOne has AVX without FMA
+	static inline Float mulAdd(Float a, Float b, Float c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+	static inline Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+	static inline Float abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static inline Float round(Float a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static inline Float invSqrt(Float a) { return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(a)); }
+	static inline Float approxLog2(Float a)
 	{
-		AsteroidStatic& staticAsteroid = asteroidsStatic[i];
-		AsteroidDynamic& dynamicAsteroid = asteroidsDynamic[i];
-
-		ALIGNED_(16) mat4 orbit = mat4::rotation(staticAsteroid.orbitSpeed * deltaTime, vec3(0, 1, 0));
-		ALIGNED_(16) mat4 rotate = mat4::rotation(staticAsteroid.rotationSpeed * deltaTime,
-			vec3(staticAsteroid.rotationAxis.getX(), staticAsteroid.rotationAxis.getY(), staticAsteroid.rotationAxis.getZ()));
+		return mulAdd(_mm256_cvtepi32_ps(_mm256_castps_si256(a)), _mm256_set1_ps(1.1920928955078125e-7f), _mm256_set1_ps(-126.94269504f));
+	}
+	static inline void storeTruncated(int32_t* p, Float a) { _mm256_storeu_si256((__m256i*)p, _mm256_cvttps_epi32(a)); }
+};
+#elif defined(ASTEROID_SSE)
+struct SimdLanes
+{
+	typedef __m128 Float;
+	static const uint32_t Count = 4;
+
+	static inline Float load(const float* p) { return _mm_loadu_ps(p); }
+	static inline void store(float* p, Float a) { _mm_storeu_ps(p, a); }
+	static inline Float set(float a) { return _mm_set1_ps(a); }
+	static inline Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static inline Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static inline Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static inline Float mulAdd(Float a, Float b, Float c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	static inline Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+	static inline Float abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	// Conversion rounds to nearest in the default rounding mode
+	static inline Float round(Float a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+	static inline Float invSqrt(Float a) { return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a)); }
+	static inline Float approxLog2(Float a)
+	{
+		return mulAdd(_mm_cvtepi32_ps(_mm_castps_si128(a)), _mm_set1_ps(1.1920928955078125e-7f), _mm_set1_ps(-126.94269504f));
+	}
+	static inline void storeTruncated(int32_t* p, Float a) { _mm_storeu_si128((__m128i*)p, _mm_cvttps_epi32(a)); }
+};
+#elif defined(ASTEROID_NEON)
+struct SimdLanes
+{
+	typedef float32x4_t Float;
+	static const uint32_t Count = 4;
+
+	static inline Float load(const float* p) { return vld1q_f32(p); }
+	static inline void store(float* p, Float a) { vst1q_f32(p, a); }
+	static inline Float set(float a) { return vdupq_n_f32(a); }
+	static inline Float add(Float a, Float b) { return vaddq_f32(a, b); }
+	static inline Float sub(Float a, Float b) { return vsubq_f32(a, b); }
+	static inline Float mul(Float a, Float b) { return vmulq_f32(a, b); }
+	static inline Float mulAdd(Float a, Float b, Float c) { return vmlaq_f32(c, a, b); }
+	static inline Float max(Float a, Float b) { return vmaxq_f32(a, b); }
+	static inline Float abs(Float a) { return vabsq_f32(a); }
+	static inline Float round(Float a)
+	{
+		// Conversion truncates, step down where that rounded up
+		const Float t = vaddq_f32(a, vdupq_n_f32(0.5f));
+		const Float r = vcvtq_f32_s32(vcvtq_s32_f32(t));
+		return vsubq_f32(r, vreinterpretq_f32_u32(vandq_u32(vcgtq_f32(r, t), vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+	}
+	static inline Float invSqrt(Float a)
+	{
+		Float e = vrsqrteq_f32(a);
+		e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+		return vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+	}
+	static inline Float approxLog2(Float a)
+	{
+		return mulAdd(vcvtq_f32_s32(vreinterpretq_s32_f32(a)), vdupq_n_f32(1.1920928955078125e-7f), vdupq_n_f32(-126.94269504f));
+	}
+	static inline void storeTruncated(int32_t* p, Float a) { vst1q_s32(p, vcvtq_s32_f32(a)); }
+};
+#else
+typedef ScalarLanes SimdLanes;
+#endif
 
-#if defined(_DURANGO) || defined(TARGET_IOS)
-		// XBoxOne/iOS don't support some of these SSE instructions.
-		// 0xC000001D: Illegal Instruction
-		// Implement it without SSE
+// Sine and cosine of half of the angle. The angle is wrapped to [-pi, pi] first, which describes the same rotation
+template <typename Lanes>
+static inline void sinCosHalfAngle(typename Lanes::Float angle, typename Lanes::Float* pSin, typename Lanes::Float* pCos)
+{
+	typedef typename Lanes::Float Float;
+
+	// 2 * pi is split in two so the wrapping stays precise for the large angles of fast asteroids
+	const Float turns = Lanes::round(Lanes::mul(angle, Lanes::set(0.5f / PI)));
+	Float x = Lanes::mulAdd(turns, Lanes::set(-6.28125f), angle);
+	x = Lanes::mul(Lanes::mulAdd(turns, Lanes::set(-1.9353071795864769e-3f), x), Lanes::set(0.5f));
+	const Float x2 = Lanes::mul(x, x);
+
+	// Taylor series, the error is below 1e-5 on [-pi / 2, pi / 2]
+	Float s = Lanes::mulAdd(x2, Lanes::set(1.0f / 362880.0f), Lanes::set(-1.0f / 5040.0f));
+	s = Lanes::mulAdd(x2, s, Lanes::set(1.0f / 120.0f));
+	s = Lanes::mulAdd(x2, s, Lanes::set(-1.0f / 6.0f));
+	s = Lanes::mulAdd(x2, s, Lanes::set(1.0f));
+	*pSin = Lanes::mul(x, s);
+
+	Float c = Lanes::mulAdd(x2, Lanes::set(1.0f / 40320.0f), Lanes::set(-1.0f / 720.0f));
+	c = Lanes::mulAdd(x2, c, Lanes::set(1.0f / 24.0f));
+	c = Lanes::mulAdd(x2, c, Lanes::set(-0.5f));
+	*pCos = Lanes::mulAdd(x2, c, Lanes::set(1.0f));
+}
 
-		dynamicAsteroid.transform = orbit * dynamicAsteroid.transform * rotate;
-#else
-		ALIGNED_(16)float orbit0[4] = { orbit[0][0], orbit[0][1], orbit[0][2], orbit[0][3] };
-		ALIGNED_(16)float orbit1[4] = { orbit[1][0], orbit[1][1], orbit[1][2], orbit[1][3] };
-		ALIGNED_(16)float orbit2[4] = { orbit[2][0], orbit[2][1], orbit[2][2], orbit[2][3] };
-		ALIGNED_(16)float orbit3[4] = { orbit[3][0], orbit[3][1], orbit[3][2], orbit[3][3] };
-
-		ALIGNED_(16)float rotate0[4] = { rotate[0][0], rotate[0][1], rotate[0][2], rotate[0][3] };
-		ALIGNED_(16)float rotate1[4] = { rotate[1][0], rotate[1][1], rotate[1][2], rotate[1][3] };
-		ALIGNED_(16)float rotate2[4] = { rotate[2][0], rotate[2][1], rotate[2][2], rotate[2][3] };
-		ALIGNED_(16)float rotate3[4] = { rotate[3][0], rotate[3][1], rotate[3][2], rotate[3][3] };
-
-		ALIGNED_(16)float transform0[4] = { dynamicAsteroid.transform[0][0], dynamicAsteroid.transform[0][1], dynamicAsteroid.transform[0][2], dynamicAsteroid.transform[0][3] };
-		ALIGNED_(16)float transform1[4] = { dynamicAsteroid.transform[1][0], dynamicAsteroid.transform[1][1], dynamicAsteroid.transform[1][2], dynamicAsteroid.transform[1][3] };
-		ALIGNED_(16)float transform2[4] = { dynamicAsteroid.transform[2][0], dynamicAsteroid.transform[2][1], dynamicAsteroid.transform[2][2], dynamicAsteroid.transform[2][3] };
-		ALIGNED_(16)float transform3[4] = { dynamicAsteroid.transform[3][0], dynamicAsteroid.transform[3][1], dynamicAsteroid.transform[3][2], dynamicAsteroid.transform[3][3] };
-
-		// Need to guarantee that passed pointer is 16-bit aligned for _mm_load_ps
-		const __m128 orbitSSE[4] = {
-			_mm_load_ps(orbit0),
-			_mm_load_ps(orbit1),
-			_mm_load_ps(orbit2),
-			_mm_load_ps(orbit3) };
-
-		const __m128 rotateSSE[4] = {
-			_mm_load_ps(rotate0),
-			_mm_load_ps(rotate1),
-			_mm_load_ps(rotate2),
-			_mm_load_ps(rotate3) };
-
-		__m128 transformSSE[4] = {
-			_mm_loadu_ps(transform0),
-			_mm_loadu_ps(transform1),
-			_mm_loadu_ps(transform2),
-			_mm_loadu_ps(transform3)
+template <typename Lanes>
+static void updateAsteroids(AsteroidSimulation& sim, unsigned startIdx, unsigned endIdx, float deltaTime, const vec3& cameraPosition, float minSubdivSizeLog2)
+{
+	typedef typename Lanes::Float Float;
+
+	const AsteroidState& state = sim.state;
+	const Float dt = Lanes::set(deltaTime);
+	const Float zero = Lanes::set(0.0f);
+	const Float one = Lanes::set(1.0f);
+	const Float two = Lanes::set(2.0f);
+	const Float cameraX = Lanes::set(cameraPosition.getX());
+	const Float cameraY = Lanes::set(cameraPosition.getY());
+	const Float cameraZ = Lanes::set(cameraPosition.getZ());
+
+	for (unsigned i = startIdx; i < endIdx; i += Lanes::Count)
+	{
+		// Orbit: rotate the stored angle by orbitSpeed * deltaTime
+		Float halfSin, halfCos;
+		sinCosHalfAngle<Lanes>(Lanes::mul(Lanes::load(state.orbitSpeed + i), dt), &halfSin, &halfCos);
+		const Float deltaSin = Lanes::mul(two, Lanes::mul(halfSin, halfCos));
+		const Float deltaCos = Lanes::sub(one, Lanes::mul(two, Lanes::mul(halfSin, halfSin)));
+
+		const Float prevCos = Lanes::load(state.orbitCos + i);
+		const Float prevSin = Lanes::load(state.orbitSin + i);
+		Float orbitCos = Lanes::sub(Lanes::mul(prevCos, deltaCos), Lanes::mul(prevSin, deltaSin));
+		Float orbitSin = Lanes::mulAdd(prevSin, deltaCos, Lanes::mul(prevCos, deltaSin));
+		// Renormalize so rounding errors do not build up from frame to frame
+		const Float orbitNorm = Lanes::invSqrt(Lanes::mulAdd(orbitCos, orbitCos, Lanes::mul(orbitSin, orbitSin)));
+		orbitCos = Lanes::mul(orbitCos, orbitNorm);
+		orbitSin = Lanes::mul(orbitSin, orbitNorm);
+		Lanes::store(state.orbitCos + i, orbitCos);
+		Lanes::store(state.orbitSin + i, orbitSin);
+
+		// Spin: spin * rotation(rotationSpeed * deltaTime, axis)
+		sinCosHalfAngle<Lanes>(Lanes::mul(Lanes::load(state.rotationSpeed + i), dt), &halfSin, &halfCos);
+		const Float dx = Lanes::mul(Lanes::load(state.axisX + i), halfSin);
+		const Float dy = Lanes::mul(Lanes::load(state.axisY + i), halfSin);
+		const Float dz = Lanes::mul(Lanes::load(state.axisZ + i), halfSin);
+		const Float dw = halfCos;
+
+		const Float qx = Lanes::load(state.spinX + i);
+		const Float qy = Lanes::load(state.spinY + i);
+		const Float qz = Lanes::load(state.spinZ + i);
+		const Float qw = Lanes::load(state.spinW + i);
+		Float x = Lanes::mulAdd(qw, dx, Lanes::mulAdd(qx, dw, Lanes::sub(Lanes::mul(qy, dz), Lanes::mul(qz, dy))));
+		Float y = Lanes::mulAdd(qw, dy, Lanes::mulAdd(qy, dw, Lanes::sub(Lanes::mul(qz, dx), Lanes::mul(qx, dz))));
+		Float z = Lanes::mulAdd(qw, dz, Lanes::mulAdd(qz, dw, Lanes::sub(Lanes::mul(qx, dy), Lanes::mul(qy, dx))));
+		Float w = Lanes::sub(Lanes::mul(qw, dw), Lanes::mulAdd(qx, dx, Lanes::mulAdd(qy, dy, Lanes::mul(qz, dz))));
+		const Float spinNorm = Lanes::invSqrt(Lanes::mulAdd(x, x, Lanes::mulAdd(y, y, Lanes::mulAdd(z, z, Lanes::mul(w, w)))));
+		x = Lanes::mul(x, spinNorm);
+		y = Lanes::mul(y, spinNorm);
+		z = Lanes::mul(z, spinNorm);
+		w = Lanes::mul(w, spinNorm);
+		Lanes::store(state.spinX + i, x);
+		Lanes::store(state.spinY + i, y);
+		Lanes::store(state.spinZ + i, z);
+		Lanes::store(state.spinW + i, w);
+
+		// Spin matrix columns
+		const Float x2 = Lanes::add(x, x), y2 = Lanes::add(y, y), z2 = Lanes::add(z, z);
+		const Float xx = Lanes::mul(x, x2), yy = Lanes::mul(y, y2), zz = Lanes::mul(z, z2);
+		const Float xy = Lanes::mul(x, y2), xz = Lanes::mul(x, z2), yz = Lanes::mul(y, z2);
+		const Float wx = Lanes::mul(w, x2), wy = Lanes::mul(w, y2), wz = Lanes::mul(w, z2);
+		const Float spin[3][3] = {
+			{ Lanes::sub(one, Lanes::add(yy, zz)), Lanes::add(xy, wz), Lanes::sub(xz, wy) },
+			{ Lanes::sub(xy, wz), Lanes::sub(one, Lanes::add(xx, zz)), Lanes::add(yz, wx) },
+			{ Lanes::add(xz, wy), Lanes::sub(yz, wx), Lanes::sub(one, Lanes::add(xx, yy)) },
 		};
-		__m128 intermediateSSE[4];
 
-		for(int i = 0; i < 4; ++i)
+		// transform = orbit rotation around y * translation(orbitRadius, orbitHeight, 0) * spin * scale
+		const Float scale = Lanes::load(state.scale + i);
+		const Float scaledCos = Lanes::mul(orbitCos, scale);
+		const Float scaledSin = Lanes::mul(orbitSin, scale);
+		float transform[12][Lanes::Count];
+		for (uint32_t c = 0; c < 3; ++c)
 		{
-			//From GLM
-			const __m128 v = transformSSE[i];
-			const __m128 vx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
-			const __m128 vy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
-			const __m128 vz = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
-			const __m128 vw = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
-			intermediateSSE[i] =
-				_mm_fmadd_ps(orbitSSE[0], vx,
-					_mm_fmadd_ps(orbitSSE[1], vy,
-						_mm_fmadd_ps(orbitSSE[2], vz,
-							_mm_mul_ps(orbitSSE[3], vw))));
+			Lanes::store(transform[c * 3 + 0], Lanes::mulAdd(scaledCos, spin[c][0], Lanes::mul(scaledSin, spin[c][2])));
+			Lanes::store(transform[c * 3 + 1], Lanes::mul(scale, spin[c][1]));
+			Lanes::store(transform[c * 3 + 2], Lanes::sub(Lanes::mul(scaledCos, spin[c][2]), Lanes::mul(scaledSin, spin[c][0])));
 		}
-		for (int i = 0; i < 4; ++i)
+		const Float orbitRadius = Lanes::load(state.orbitRadius + i);
+		const Float positionX = Lanes::mul(orbitCos, orbitRadius);
+		const Float positionY = Lanes::load(state.orbitHeight + i);
+		const Float positionZ = Lanes::mul(Lanes::sub(zero, orbitSin), orbitRadius);
+		Lanes::store(transform[9], positionX);
+		Lanes::store(transform[10], positionY);
+		Lanes::store(transform[11], positionZ);
+
+		// LOD from the approximate relative screen size
+		const Float toEyeX = Lanes::sub(positionX, cameraX);
+		const Float toEyeY = Lanes::sub(positionY, cameraY);
+		const Float toEyeZ = Lanes::sub(positionZ, cameraZ);
+		const Float invDistanceToEye = Lanes::invSqrt(Lanes::mulAdd(toEyeX, toEyeX, Lanes::mulAdd(toEyeY, toEyeY, Lanes::mul(toEyeZ, toEyeZ))));
+		const Float relativeScreenSizeLog2 = Lanes::approxLog2(Lanes::mul(Lanes::abs(scale), invDistanceToEye));
+		int32_t lods[Lanes::Count];
+		Lanes::storeTruncated(lods, Lanes::max(zero, Lanes::sub(relativeScreenSizeLog2, Lanes::set(minSubdivSizeLog2))));
+
+		for (uint32_t j = 0; j < Lanes::Count; ++j)
 		{
-			//From GLM
-			const __m128 v = rotateSSE[i];
-			const __m128 vx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
-			const __m128 vy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
-			const __m128 vz = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
-			const __m128 vw = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
-			transformSSE[i] =
-				_mm_fmadd_ps(intermediateSSE[0], vx,
-					_mm_fmadd_ps(intermediateSSE[1], vy,
-						_mm_fmadd_ps(intermediateSSE[2], vz,
-							_mm_mul_ps(intermediateSSE[3], vw))));
+			AsteroidDynamic& dynamicAsteroid = sim.asteroidsDynamic[i + j];
+			dynamicAsteroid.transform = mat4(
+				vec4(transform[0][j], transform[1][j], transform[2][j], 0.0f),
+				vec4(transform[3][j], transform[4][j], transform[5][j], 0.0f),
+				vec4(transform[6][j], transform[7][j], transform[8][j], 0.0f),
+				vec4(transform[9][j], transform[10][j], transform[11][j], 1.0f));
+
+			unsigned LOD = MIN(sim.numLODs - 1, (unsigned)lods[j]);
+			dynamicAsteroid.indexStart = sim.indexOffsets[LOD];
+			dynamicAsteroid.indexCount = sim.indexOffsets[LOD + 1] - dynamicAsteroid.indexStart;
 		}
-		_mm_store_ps(transform0, transformSSE[0]);
-		_mm_store_ps(transform1, transformSSE[1]);
-		_mm_store_ps(transform2, transformSSE[2]);
-		_mm_store_ps(transform3, transformSSE[3]);
-
-		for (uint32_t i = 0; i < 4; i++)
-		{
-			dynamicAsteroid.transform[0][i] = transform0[i];
-			dynamicAsteroid.transform[1][i] = transform1[i];
-			dynamicAsteroid.transform[2][i] = transform2[i];
-			dynamicAsteroid.transform[3][i] = transform3[i];
-		}
-#endif
-		vec3 position = dynamicAsteroid.transform.getTranslation();
-		float distanceToEye = length(position - cameraPosition);
-		float relativeScreenSizeLog2 = VeryApproxLog2f(staticAsteroid.scale / distanceToEye);
-		float LODfloat = max(0.f, relativeScreenSizeLog2 - minSubdivSizeLog2);
-		unsigned LOD = min(numLODs - 1, unsigned(LODfloat));
-
-		dynamicAsteroid.indexStart = indexOffsets[LOD];
-		dynamicAsteroid.indexCount = indexOffsets[LOD + 1] - dynamicAsteroid.indexStart;
 	}
 }
+
+void AsteroidSimulation::update(float deltaTime, unsigned startIdx, unsigned endIdx, const vec3& cameraPosition)
+{
+	//taken from intel demo
+	static const float minSubdivSizeLog2 = log2f(0.0019f);
+
+	const unsigned simdEndIdx = startIdx + (endIdx - startIdx) / SimdLanes::Count * SimdLanes::Count;
+	updateAsteroids<SimdLanes>(*this, startIdx, simdEndIdx, deltaTime, cameraPosition, minSubdivSizeLog2);
+	updateAsteroids<ScalarLanes>(*this, simdEndIdx, endIdx, deltaTime, cameraPosition, minSubdivSizeLog2);
+}
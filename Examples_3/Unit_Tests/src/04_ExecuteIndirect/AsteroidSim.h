@@ -77,6 +77,27 @@ struct AsteroidDynamic
 	uint32_t padding[2];
 };
 
+// Simulation state of the CPU update, one array per component so the update can run on several asteroids per instruction
+struct AsteroidState
+{
+	// Orbit angle stored as its cosine and sine, advanced by a rotation every frame
+	float* orbitCos;
+	float* orbitSin;
+	float* orbitRadius;
+	float* orbitHeight;
+	float* orbitSpeed;
+	// Spin as a unit quaternion, advanced by a rotation around the fixed axis every frame
+	float* spinX;
+	float* spinY;
+	float* spinZ;
+	float* spinW;
+	float* axisX;
+	float* axisY;
+	float* axisZ;
+	float* rotationSpeed;
+	float* scale;
+};
+
 struct AsteroidSimulation
 {
 public:
@@ -88,11 +109,15 @@ public:
 		uint32_t vertexCountPerMesh,
 		uint32_t textureCount);
 
+	// Advances asteroids [startIdx, endIdx) and writes their transform and LOD to asteroidsDynamic.
+	// Disjoint ranges can be updated from different threads
 	void update(float deltaTime, unsigned startIdx, unsigned endIdx, const vec3& cameraPosition);
 
 	tinystl::vector<AsteroidStatic> asteroidsStatic;
 	tinystl::vector<AsteroidDynamic> asteroidsDynamic;
 	//tinystl::vector<Asteroid> asteroids;
+	AsteroidState state;
+	tinystl::vector<float> stateStorage;
 	int* indexOffsets;
 	unsigned numLODs;
 };
\ No newline at end of file
@@ -102,8 +102,10 @@ LogManager		  gLogManager;
 UIApp			   gAppUI;
 GuiComponent*	   pStandaloneControlsGUIWindow = NULL;
 GuiComponent*	   pGroupedGUIWindow = NULL;
+GuiComponent*	   pBenchmarkGUIWindow = NULL;
 
 TextDrawDesc gFrameTimeDraw = TextDrawDesc(0, 0xff00dddd, 18);
+HiresTimer		  gUITimer;
 
 
 //--------------------------------------------------------------------------------------------
@@ -132,6 +134,14 @@ struct UserInterfaceUnitTestingData
 		uint		mColorForSlider;
 		const char** mContextItems;
 	} mStandalone;
+
+	// Data for the Benchmark Window
+	static const unsigned BENCHMARK_WIDGET_COUNT = 1000;
+	struct Benchmark
+	{
+		float	   mValues[BENCHMARK_WIDGET_COUNT];
+		bool		mImmediateUI;
+	} mBenchmark;
 };
 UserInterfaceUnitTestingData gUIData;
 
@@ -334,6 +344,26 @@ public:
 		// Let's show the UI demo window
 		gAppUI.mShowDemoUiWindow = true;
 
+		//-----------------------------------------------------------------------
+		// Benchmark GUI Controls
+		//  Windows are only rebuilt when their widgets or the input changed.
+		//  Compare the UI CPU time of this window with and without
+		//  GUI_COMPONENT_FLAGS_IMMEDIATE while the mouse is outside of it.
+		//-----------------------------------------------------------------------
+		{
+			vec2 BenchmarkPosition = { mSettings.mWidth * 0.6f, mSettings.mHeight * 0.05f };
+			vec2 BenchmarkSize = { 400, 800 };
+			GuiDesc benchmarkDesc(BenchmarkPosition, BenchmarkSize, UIPanelWindowTitleTextDesc);
+			pBenchmarkGUIWindow = gAppUI.AddGuiComponent("Benchmark", &benchmarkDesc);
+			pBenchmarkGUIWindow->mActive = false;
+
+			for (unsigned i = 0; i < UserInterfaceUnitTestingData::BENCHMARK_WIDGET_COUNT; ++i)
+			{
+				gUIData.mBenchmark.mValues[i] = 0.0f;
+				pBenchmarkGUIWindow->AddWidget(SliderFloatWidget(tinystl::string::format("[Slider<float>] %u", i), &gUIData.mBenchmark.mValues[i], 0.0f, 1.0f));
+			}
+		}
+
 		{
 			// Drop Down
 			gFrameTimeDraw.mFontColor = dropDownItemValues[5];  // initial value
@@ -416,6 +446,15 @@ public:
 			pStandaloneControlsGUIWindow->AddWidget(CollapsingSliderWidgets);
 			pStandaloneControlsGUIWindow->AddWidget(SeparatorWidget());
 			pStandaloneControlsGUIWindow->AddWidget(CollapsingColorWidgets);
+
+			// Benchmark
+			gUIData.mBenchmark.mImmediateUI = false;
+			CollapsingHeaderWidget CollapsingBenchmarkWidgets("BENCHMARK");
+			CollapsingBenchmarkWidgets.AddSubWidget(CheckboxWidget("[Checkbox] Show Benchmark Window", &pBenchmarkGUIWindow->mActive));
+			CollapsingBenchmarkWidgets.AddSubWidget(CheckboxWidget("[Checkbox] Rebuild UI Every Frame", &gUIData.mBenchmark.mImmediateUI));
+			CollapsingBenchmarkWidgets.AddSubWidget(CheckboxWidget("[Checkbox] Show Demo Window", &gAppUI.mShowDemoUiWindow));
+			pStandaloneControlsGUIWindow->AddWidget(SeparatorWidget());
+			pStandaloneControlsGUIWindow->AddWidget(CollapsingBenchmarkWidgets);
 		}
 
 		return true;
@@ -527,6 +566,15 @@ public:
 		/************************************************************************/
 		// GUI
 		/************************************************************************/
+		GuiComponent* pGuiWindows[] = { pStandaloneControlsGUIWindow, pBenchmarkGUIWindow };
+		for (uint32_t i = 0; i < sizeof(pGuiWindows) / sizeof(pGuiWindows[0]); ++i)
+		{
+			if (gUIData.mBenchmark.mImmediateUI)
+				pGuiWindows[i]->mFlags |= GUI_COMPONENT_FLAGS_IMMEDIATE;
+			else
+				pGuiWindows[i]->mFlags &= ~GUI_COMPONENT_FLAGS_IMMEDIATE;
+		}
+
 		gAppUI.Update(deltaTime);
 		gProgressBarAnim.Update(deltaTime);
 	}
@@ -592,8 +640,12 @@ public:
 #endif
 
 		gAppUI.Gui(pStandaloneControlsGUIWindow); // adds the gui element to AppUI::ComponentsToUpdate list
+		gAppUI.Gui(pBenchmarkGUIWindow);
 		drawDebugText(cmd, 8, 15, tinystl::string::format("CPU %f ms", gTimer.GetUSecAverage() / 1000.0f), &gFrameTimeDraw);
+		drawDebugText(cmd, 8, 40, tinystl::string::format("UI CPU %f ms", gUITimer.GetUSecAverage() / 1000.0f), &gFrameTimeDraw);
+		gUITimer.Reset();
 		gAppUI.Draw(cmd);
+		gUITimer.GetUSec(false);
 
 		cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
 		cmdEndDebugMarker(cmd);
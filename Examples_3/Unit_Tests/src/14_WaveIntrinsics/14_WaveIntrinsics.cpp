@@ -37,6 +37,7 @@
 #include "../../../../Common_3/OS/Core/DebugRenderer.h"
 #include "../../../../Common_3/Renderer/IRenderer.h"
 #include "../../../../Common_3/Renderer/ResourceLoader.h"
+#include "../../../../Common_3/Renderer/RenderGraph.h"
 
 #include "../../../../Middleware_3/Input/InputSystem.h"
 #include "../../../../Middleware_3/Input/InputMappings.h"
@@ -62,15 +63,16 @@ const uint32_t	  gImageCount = 3;
 Renderer*		   pRenderer = NULL;
 
 Queue*			  pGraphicsQueue = NULL;
-CmdPool*			pCmdPool = NULL;
-Cmd**			   ppCmds = NULL;
 
 SwapChain*		  pSwapChain = NULL;
 Fence*			  pRenderCompleteFences[gImageCount] = { NULL };
 Semaphore*		  pImageAcquiredSemaphore = NULL;
 Semaphore*		  pRenderCompleteSemaphores[gImageCount] = { NULL };
 
-RenderTarget*	   pRenderTargetIntermediate = NULL;
+// The wave pass renders into a transient render target of the graph, magnified into the swapchain image
+RenderGraph*		pRenderGraph = NULL;
+RenderGraphHandle   gIntermediateHandle = RENDER_GRAPH_INVALID_HANDLE;
+RenderGraphHandle   gSwapchainHandle = RENDER_GRAPH_INVALID_HANDLE;
 
 Shader*			 pShaderWave = NULL;
 Pipeline*		   pPipelineWave = NULL;
@@ -163,8 +165,6 @@ public:
 		QueueDesc queueDesc = {};
 		queueDesc.mType = CMD_POOL_DIRECT;
 		addQueue(pRenderer, &queueDesc, &pGraphicsQueue);
-		addCmdPool(pRenderer, pGraphicsQueue, false, &pCmdPool);
-		addCmd_n(pCmdPool, false, gImageCount, &ppCmds);
 
 		for (uint32_t i = 0; i < gImageCount; ++i)
 		{
@@ -346,9 +346,6 @@ public:
 		}
 		removeSemaphore(pRenderer, pImageAcquiredSemaphore);
 
-		removeCmd_n(pCmdPool, gImageCount, ppCmds);
-		removeCmdPool(pRenderer, pCmdPool);
-
 		removeResourceLoaderInterface(pRenderer);
 		removeQueue(pGraphicsQueue);
 		removeRenderer(pRenderer);
@@ -359,7 +356,7 @@ public:
 		if (!addSwapChain())
 			return false;
 
-		if (!addIntermediateRenderTarget())
+		if (!addRenderGraph())
 			return false;
 
 		if (!gAppUI.Load(pSwapChain->ppSwapchainRenderTargets))
@@ -428,7 +425,7 @@ public:
 		removePipeline(pRenderer, pPipelineMagnify);
 		removePipeline(pRenderer, pPipelineWave);
 
-		removeRenderTarget(pRenderer, pRenderTargetIntermediate);
+		removeRenderGraph(pRenderGraph);
 		removeSwapChain(pRenderer, pSwapChain);
 	}
 
@@ -468,32 +465,86 @@ public:
 		if (fenceStatus == FENCE_STATUS_INCOMPLETE)
 			waitForFences(pGraphicsQueue, 1, &pNextFence, false);
 
-		RenderTarget* pRenderTarget = pRenderTargetIntermediate;
-		RenderTarget* pScreenRenderTarget = pSwapChain->ppSwapchainRenderTargets[gFrameIndex];
-
 		Semaphore* pRenderCompleteSemaphore = pRenderCompleteSemaphores[gFrameIndex];
 		Fence* pRenderCompleteFence = pRenderCompleteFences[gFrameIndex];
 
+		// The graph records the barriers between the passes and leaves the swapchain image in the present state
+		rgSetImportedRenderTarget(pRenderGraph, gSwapchainHandle, pSwapChain->ppSwapchainRenderTargets[gFrameIndex]);
+		rgExecute(pRenderGraph, gFrameIndex, 1, &pImageAcquiredSemaphore, pRenderCompleteSemaphore, pRenderCompleteFence);
+
+		queuePresent(pGraphicsQueue, pSwapChain, gFrameIndex, 1, &pRenderCompleteSemaphore);
+	}
+
+	tinystl::string GetName()
+	{
+		return "14_WaveIntrinsics";
+	}
+
+	bool addSwapChain()
+	{
+		SwapChainDesc swapChainDesc = {};
+		swapChainDesc.pWindow = pWindow;
+		swapChainDesc.mPresentQueueCount = 1;
+		swapChainDesc.ppPresentQueues = &pGraphicsQueue;
+		swapChainDesc.mWidth = mSettings.mWidth;
+		swapChainDesc.mHeight = mSettings.mHeight;
+		swapChainDesc.mImageCount = gImageCount;
+		swapChainDesc.mSampleCount = SAMPLE_COUNT_1;
+		swapChainDesc.mColorFormat = getRecommendedSwapchainFormat(true);
+		swapChainDesc.mEnableVsync = false;
+		::addSwapChain(pRenderer, &swapChainDesc, &pSwapChain);
+
+		return pSwapChain != NULL;
+	}
+
+	bool addRenderGraph()
+	{
+		RenderGraphDesc graphDesc = {};
+		graphDesc.pRenderer = pRenderer;
+		graphDesc.pGraphicsQueue = pGraphicsQueue;
+		graphDesc.mFrameCount = gImageCount;
+		::addRenderGraph(&graphDesc, &pRenderGraph);
+
+		RenderTargetDesc intermediateRT = {};
+		intermediateRT.mArraySize = 1;
+		intermediateRT.mClearValue = { 0.0f, 0.0f, 0.0f, 0.0f };
+		intermediateRT.mDepth = 1;
+		intermediateRT.mFormat = getRecommendedSwapchainFormat(true);
+		intermediateRT.mHeight = mSettings.mHeight;
+		intermediateRT.mSampleCount = SAMPLE_COUNT_1;
+		intermediateRT.mSampleQuality = 0;
+		intermediateRT.mWidth = mSettings.mWidth;
+		gIntermediateHandle = rgAddRenderTarget(pRenderGraph, "Intermediate", &intermediateRT);
+		gSwapchainHandle = rgImportRenderTarget(pRenderGraph, "Swapchain", pSwapChain->ppSwapchainRenderTargets[0], RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+		rgMarkOutput(pRenderGraph, gSwapchainHandle);
+
+		uint32_t wavePass = rgAddPass(pRenderGraph, "Wave Shader", RENDER_GRAPH_QUEUE_GRAPHICS, drawWavePass, NULL);
+		rgPassWrite(pRenderGraph, wavePass, gIntermediateHandle, RESOURCE_STATE_RENDER_TARGET);
+
+		uint32_t magnifyPass = rgAddPass(pRenderGraph, "Magnify", RENDER_GRAPH_QUEUE_GRAPHICS, drawMagnifyPass, NULL);
+		rgPassRead(pRenderGraph, magnifyPass, gIntermediateHandle, RESOURCE_STATE_SHADER_RESOURCE);
+		rgPassWrite(pRenderGraph, magnifyPass, gSwapchainHandle, RESOURCE_STATE_RENDER_TARGET);
+
+		uint32_t uiPass = rgAddPass(pRenderGraph, "Draw UI", RENDER_GRAPH_QUEUE_GRAPHICS, drawUIPass, NULL);
+		rgPassWrite(pRenderGraph, uiPass, gSwapchainHandle, RESOURCE_STATE_RENDER_TARGET);
+
+		return rgCompile(pRenderGraph);
+	}
+
+	static void drawWavePass(Cmd* cmd, RenderGraph* pGraph, void* pUserData)
+	{
+		RenderTarget* pRenderTarget = rgGetRenderTarget(pGraph, gIntermediateHandle);
+
 		// simply record the screen cleaning command
 		LoadActionsDesc loadActions = {};
 		loadActions.mLoadActionsColor[0] = LOAD_ACTION_CLEAR;
 		loadActions.mClearColorValues[0] = pRenderTarget->mDesc.mClearValue;
 
-		Cmd* cmd = ppCmds[gFrameIndex];
-		beginCmd(cmd);
-
-		TextureBarrier rtBarrier[] = {
-			{ pRenderTarget->pTexture, RESOURCE_STATE_RENDER_TARGET },
-			{ pScreenRenderTarget->pTexture, RESOURCE_STATE_RENDER_TARGET },
-		};
-		cmdResourceBarrier(cmd, 0, NULL, 2, rtBarrier, false);
-
 		cmdBindRenderTargets(cmd, 1, &pRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
 		cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mDesc.mWidth, (float)pRenderTarget->mDesc.mHeight, 0.0f, 1.0f);
 		cmdSetScissor(cmd, 0, 0, pRenderTarget->mDesc.mWidth, pRenderTarget->mDesc.mHeight);
 
 		// wave debug
-		cmdBeginDebugMarker(cmd, 0, 0, 1, "Wave Shader");
 		cmdBindPipeline(cmd, pPipelineWave);
 		DescriptorData params[1] = {};
 		params[0].pName = "SceneConstantBuffer";
@@ -502,17 +553,19 @@ public:
 		cmdBindVertexBuffer(cmd, 1, &pVertexBufferTriangle, NULL);
 		cmdDraw(cmd, 3, 0);
 		cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
-		cmdEndDebugMarker(cmd);
+	}
 
-		// magnify
-		cmdBeginDebugMarker(cmd, 1, 0, 1, "Magnify");
-		TextureBarrier srvBarrier[] = {
-			{ pRenderTarget->pTexture, RESOURCE_STATE_SHADER_RESOURCE },
-		};
-		cmdResourceBarrier(cmd, 0, NULL, 1, srvBarrier, false);
+	static void drawMagnifyPass(Cmd* cmd, RenderGraph* pGraph, void* pUserData)
+	{
+		RenderTarget* pRenderTarget = rgGetRenderTarget(pGraph, gIntermediateHandle);
+		RenderTarget* pScreenRenderTarget = rgGetRenderTarget(pGraph, gSwapchainHandle);
 
+		LoadActionsDesc loadActions = {};
+		loadActions.mLoadActionsColor[0] = LOAD_ACTION_CLEAR;
 		loadActions.mClearColorValues[0] = pScreenRenderTarget->mDesc.mClearValue;
 		cmdBindRenderTargets(cmd, 1, &pScreenRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
+		cmdSetViewport(cmd, 0.0f, 0.0f, (float)pScreenRenderTarget->mDesc.mWidth, (float)pScreenRenderTarget->mDesc.mHeight, 0.0f, 1.0f);
+		cmdSetScissor(cmd, 0, 0, pScreenRenderTarget->mDesc.mWidth, pScreenRenderTarget->mDesc.mHeight);
 
 		DescriptorData magnifyParams[2] = {};
 		magnifyParams[0].pName = "SceneConstantBuffer";
@@ -523,10 +576,19 @@ public:
 		cmdBindPipeline(cmd, pPipelineMagnify);
 		cmdBindVertexBuffer(cmd, 1, &pVertexBufferQuad, NULL);
 		cmdDrawInstanced(cmd, 6, 0, 2, 0);
+		cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+	}
 
-		cmdEndDebugMarker(cmd);
+	static void drawUIPass(Cmd* cmd, RenderGraph* pGraph, void* pUserData)
+	{
+		RenderTarget* pScreenRenderTarget = rgGetRenderTarget(pGraph, gSwapchainHandle);
+
+		LoadActionsDesc loadActions = {};
+		loadActions.mLoadActionsColor[0] = LOAD_ACTION_LOAD;
+		cmdBindRenderTargets(cmd, 1, &pScreenRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
+		cmdSetViewport(cmd, 0.0f, 0.0f, (float)pScreenRenderTarget->mDesc.mWidth, (float)pScreenRenderTarget->mDesc.mHeight, 0.0f, 1.0f);
+		cmdSetScissor(cmd, 0, 0, pScreenRenderTarget->mDesc.mWidth, pScreenRenderTarget->mDesc.mHeight);
 
-		cmdBeginDebugMarker(cmd, 0, 1, 0, "Draw UI");
 		static HiresTimer gTimer;
 		gTimer.GetUSec(true);
 
@@ -539,53 +601,6 @@ public:
 		gAppUI.Gui(pGui);
 		gAppUI.Draw(cmd);
 		cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
-		cmdEndDebugMarker(cmd);
-
-		TextureBarrier presentBarrier = { pScreenRenderTarget->pTexture, RESOURCE_STATE_PRESENT };
-		cmdResourceBarrier(cmd, 0, NULL, 1, &presentBarrier, true);
-		endCmd(cmd);
-
-		queueSubmit(pGraphicsQueue, 1, &cmd, pRenderCompleteFence, 1, &pImageAcquiredSemaphore, 1, &pRenderCompleteSemaphore);
-		queuePresent(pGraphicsQueue, pSwapChain, gFrameIndex, 1, &pRenderCompleteSemaphore);
-	}
-
-	tinystl::string GetName()
-	{
-		return "14_WaveIntrinsics";
-	}
-
-	bool addSwapChain()
-	{
-		SwapChainDesc swapChainDesc = {};
-		swapChainDesc.pWindow = pWindow;
-		swapChainDesc.mPresentQueueCount = 1;
-		swapChainDesc.ppPresentQueues = &pGraphicsQueue;
-		swapChainDesc.mWidth = mSettings.mWidth;
-		swapChainDesc.mHeight = mSettings.mHeight;
-		swapChainDesc.mImageCount = gImageCount;
-		swapChainDesc.mSampleCount = SAMPLE_COUNT_1;
-		swapChainDesc.mColorFormat = getRecommendedSwapchainFormat(true);
-		swapChainDesc.mEnableVsync = false;
-		::addSwapChain(pRenderer, &swapChainDesc, &pSwapChain);
-
-		return pSwapChain != NULL;
-	}
-
-	bool addIntermediateRenderTarget()
-	{
-		// Add depth buffer
-		RenderTargetDesc depthRT = {};
-		depthRT.mArraySize = 1;
-		depthRT.mClearValue = { 0.0f, 0.0f, 0.0f, 0.0f };
-		depthRT.mDepth = 1;
-		depthRT.mFormat = getRecommendedSwapchainFormat(true);
-		depthRT.mHeight = mSettings.mHeight;
-		depthRT.mSampleCount = SAMPLE_COUNT_1;
-		depthRT.mSampleQuality = 0;
-		depthRT.mWidth = mSettings.mWidth;
-		addRenderTarget(pRenderer, &depthRT, &pRenderTargetIntermediate);
-
-		return pRenderTargetIntermediate != NULL;
 	}
 
 	static bool onInput(const ButtonData* pData)
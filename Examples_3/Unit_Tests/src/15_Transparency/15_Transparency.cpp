@@ -51,6 +51,7 @@
 #include "../../../../Common_3/OS/Interfaces/ITimeManager.h"
 #include "../../../../Middleware_3/UI/AppUI.h"
 #include "../../../../Common_3/OS/Core/DebugRenderer.h"
+#include "../../../../Common_3/OS/Core/RadixSort.h"
 #include "../../../../Common_3/Renderer/IRenderer.h"
 #include "../../../../Common_3/Renderer/ResourceLoader.h"
 #include "../../../../Common_3/Tools/AssimpImporter/AssimpImporter.h"
@@ -453,6 +454,7 @@ VirtualJoystickUI   gVirtualJoystick;
 // Constants
 uint32_t				gFrameIndex = 0;
 GpuProfiler*			pGpuProfiler = NULL;
+RadixSorter*			pParticleSorter = NULL;
 float				   gCurrentTime = 0.0f;
 
 MaterialUniformBlock	gMaterialUniformData;
@@ -701,6 +703,8 @@ public:
 		CreateScene();
 		finishResourceLoading();
 
+		addRadixSorter(NULL, &pParticleSorter);
+
 		if (!gAppUI.Init(pRenderer))
 			return false;
 		gAppUI.LoadFont("TitilliumText/TitilliumText-Bold.otf", FSR_Builtin_Fonts);
@@ -739,6 +743,7 @@ public:
 
 		for (size_t i = 0; i < gScene.mParticleSystems.size(); ++i)
 			removeResource(gScene.mParticleSystems[i].pParticleBuffer);
+		removeRadixSorter(pParticleSorter);
 
 
 #ifdef TARGET_IOS
@@ -920,16 +925,18 @@ public:
 			// Update vertex buffers
 			if (gTransparencyType == TRANSPARENCY_TYPE_ALPHA_BLEND && gAlphaBlendSettings.mSortParticles)
 			{
-				tinystl::vector<float2> sortedArray;
+				// Back to front: descending distance to the camera
+				float distances[MAX_NUM_PARTICLES];
+				uint32_t sortedIndices[MAX_NUM_PARTICLES];
 
 				for (size_t j = 0; j < pParticleSystem->mLifeParticleCount; ++j)
-					sortedArray.push_back({ (float)distSqr(Point3(camPos), Point3(pParticleSystem->mParticlePositions[j])), (float)j });
+					distances[j] = (float)distSqr(Point3(camPos), Point3(pParticleSystem->mParticlePositions[j]));
 
-				sortedArray.sort(MeshCompare);
+				radixSortFloatKeys(pParticleSorter, distances, (uint32_t)pParticleSystem->mLifeParticleCount, true, sortedIndices);
 
-				for (uint j = 0; j < sortedArray.size(); ++j)
+				for (uint j = 0; j < pParticleSystem->mLifeParticleCount; ++j)
 				{
-					vec3 pos = pParticleSystem->mParticlePositions[(int)sortedArray[sortedArray.size() - j - 1][1]];
+					vec3 pos = pParticleSystem->mParticlePositions[sortedIndices[j]];
 					tempVertexBuffer[j * 6 + 0] = { v3ToF3(pos - camUp - camRight), float3(0.0f, 1.0f, 0.0f), float2(0.0f, 0.0f) };
 					tempVertexBuffer[j * 6 + 1] = { v3ToF3(pos + camUp - camRight), float3(0.0f, 1.0f, 0.0f), float2(0.0f, 1.0f) };
 					tempVertexBuffer[j * 6 + 2] = { v3ToF3(pos - camUp + camRight), float3(0.0f, 1.0f, 0.0f), float2(1.0f, 0.0f) };
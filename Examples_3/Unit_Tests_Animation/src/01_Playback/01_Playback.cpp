@@ -27,7 +27,7 @@
 * The Forge - ANIMATION - PLAYBACK UNIT TEST
 *
 * The purpose of this demo is to show how to playback a clip using the
-* animnation middleware
+* animnation middleware, and to skin a mesh to the animated rig on the CPU and on the GPU
 *
 *********************************************************************************************************/
 
@@ -37,6 +37,7 @@
 #include "../../../../Common_3/OS/Interfaces/ILogManager.h"
 #include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
 #include "../../../../Common_3/OS/Interfaces/ITimeManager.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
 
 // Rendering
 #include "../../../../Common_3/OS/Core/DebugRenderer.h"
@@ -51,6 +52,7 @@
 #include "../../../../Middleware_3/Animation/Clip.h"
 #include "../../../../Middleware_3/Animation/ClipController.h"
 #include "../../../../Middleware_3/Animation/Rig.h"
+#include "../../../../Middleware_3/Animation/SkinnedMesh.h"
 
 #include "../../../../Middleware_3/UI/AppUI.h"
 #include "../../../../Middleware_3/Input/InputSystem.h"
@@ -70,8 +72,8 @@ const char* pszBases[] =
 {
 	"../../../src/01_Playback/",										// FSR_BinShaders
 	"../../../src/01_Playback/",									// FSR_SrcShaders
-	"",																		// FSR_BinShaders_Common
-	"",																		// FSR_SrcShaders_Common
+	"../../../../../Middleware_3/Animation/",								// FSR_BinShaders_Common
+	"../../../../../Middleware_3/Animation/",								// FSR_SrcShaders_Common
 	"../../../UnitTestResources/",											// FSR_Textures
 	"../../../UnitTestResources/",											// FSR_Meshes
 	"../../../UnitTestResources/",											// FSR_Builtin_Fonts
@@ -127,6 +129,33 @@ UniformBlockPlane		gUniformDataPlane;
 
 Buffer*				pPlaneUniformBuffer[gImageCount] = { NULL };
 
+Shader*				pSkinShader = NULL;
+Buffer*				pSkinIndexBuffer = NULL;
+Pipeline*			pSkinPipeline = NULL;
+uint32_t			gNumSkinIndices = 0;
+
+struct UniformBlockSkin
+{
+	mat4 mProjectView;
+	mat4 mToWorldMat;
+	vec4 mColor;
+
+	// Point Light Information
+	vec4 mLightPosition;
+	vec4 mLightColor;
+};
+UniformBlockSkin	gUniformDataSkin;
+
+Buffer*				pSkinUniformBuffer[gImageCount] = { NULL };
+
+// Skinning compute shader of Middleware_3/Animation
+Shader*				pSkinningShader = NULL;
+RootSignature*		pSkinningRootSignature = NULL;
+Pipeline*			pSkinningPipeline = NULL;
+
+// Vertices skinned on the CPU, drawn when the GPU skinning is disabled
+Buffer*				pCpuSkinnedVertexBuffers[gImageCount] = { NULL };
+
 //--------------------------------------------------------------------------------------------
 // CAMERA CONTROLLER & SYSTEMS (File/Log/UI)
 //--------------------------------------------------------------------------------------------
@@ -141,6 +170,9 @@ GuiComponent*		pStandaloneControlsGUIWindow = NULL;
 TextDrawDesc gFrameTimeDraw = TextDrawDesc(0, 0xff00ffff, 18);
 GpuProfiler*		pGpuProfiler = NULL;
 
+// Runs the CPU skinning jobs
+ThreadPool			gThreadSystem;
+
 
 //--------------------------------------------------------------------------------------------
 // ANIMATION DATA
@@ -164,6 +196,23 @@ Rig					gStickFigureRig;
 // SkeletonBatcher
 SkeletonBatcher		gSkeletonBatcher;
 
+// Skin generated around the bones of the rig, skinned on both the CPU and the GPU every frame
+SkinnedMesh			gStickFigureSkin;
+
+// CPU skinning result of each frame index, compared with the GPU skinning once the frame has completed
+tinystl::vector<SkinnedVertex>	gCpuSkinnedVertices[gImageCount];
+bool				gSkinReadbackPending[gImageCount] = { false };
+
+// Largest difference between a CPU and a GPU skinned vertex component in the last compared frame
+float				gSkinningMaxError = 0.0f;
+
+// Largest difference allowed between the CPU and the GPU skinning
+const float			gSkinningTolerance = 1e-3f;
+
+// Timers of the CPU and the GPU skinning
+static HiresTimer	gCpuSkinningTimer;
+GpuTimer*			pGpuSkinningTimer = NULL;
+
 // Filenames
 const char*			gStickFigureName = "stickFigure/skeleton.ozz";
 const char*			gStandClipName = "stickFigure/animations/stand.ozz";
@@ -173,6 +222,10 @@ const int			gSphereResolution = 30; // Increase for higher resolution joint sphe
 const float			gBoneWidthRatio = 0.2f; // Determines how far along the bone to put the max width [0,1]
 const float			gJointRadius = gBoneWidthRatio * 0.5f; // set to replicate Ozz skeleton
 
+const int			gSkinRings = 32; // Rings of vertices along each bone of the skin
+const int			gSkinSegments = 32; // Vertices around each ring of the skin
+const float			gSkinRadiusRatio = 0.15f; // Radius of the skin relative to the length of the bone
+
 // Timer to get animationsystem update time
 static HiresTimer	gAnimationUpdateTimer;
 
@@ -202,6 +255,8 @@ struct UIData
 	{
 		bool		mShowBindPose = false;
 		bool		mDrawPlane = true;
+		bool		mDrawSkin = true;
+		bool		mGpuSkinning = true;
 	};
 	GeneralSettingsData mGeneralSettings;
 };
@@ -213,6 +268,103 @@ void StandClipTimeChangeCallback()
 	gStandClipController.SetTimeRatioHard(gUIData.mStandClip.mAnimationTime);
 }
 
+// Generates a tube around each bone of the rig, which must be posed in its bind pose.
+// The middle of a bone follows its parent joint, its ends blend with the neighbouring joints so the skin bends at the joints
+void generateSkin(Rig* pRig, tinystl::vector<float>& positions, tinystl::vector<float>& normals,
+	tinystl::vector<uint16_t>& jointIndices, tinystl::vector<float>& jointWeights, tinystl::vector<uint32_t>& indices)
+{
+	ozz::Range<Matrix4> jointModelMats = pRig->GetJointModelMats();
+	ozz::Range<const ozz::animation::Skeleton::JointProperties> jointProperties = pRig->GetSkeleton()->joint_properties();
+
+	for (unsigned int childIndex = 0; childIndex < pRig->GetNumJoints(); childIndex++)
+	{
+		const unsigned int parentIndex = jointProperties[childIndex].parent;
+		if (parentIndex == ozz::animation::Skeleton::kNoParentIndex)
+			continue;
+
+		// Start joint of the bone ending at the parent, the parent itself for the bones of the root
+		const unsigned int grandParentIndex = jointProperties[parentIndex].parent == ozz::animation::Skeleton::kNoParentIndex ?
+			parentIndex : jointProperties[parentIndex].parent;
+
+		const vec3 parentPos = jointModelMats[parentIndex].getCol3().getXYZ();
+		const vec3 boneDir = jointModelMats[childIndex].getCol3().getXYZ() - parentPos;
+		const float boneLen = length(boneDir);
+		if (boneLen <= 0.0f)
+			continue;
+
+		// Frame around the bone
+		const vec3 axis = boneDir / boneLen;
+		const vec3 up = fabsf(axis.getY()) < 0.9f ? vec3(0.0f, 1.0f, 0.0f) : vec3(1.0f, 0.0f, 0.0f);
+		const vec3 tangent = normalize(cross(up, axis));
+		const vec3 bitangent = cross(axis, tangent);
+		const float radius = gSkinRadiusRatio * boneLen;
+
+		const uint32_t firstVertex = (uint32_t)positions.size() / 3;
+		for (int ring = 0; ring <= gSkinRings; ring++)
+		{
+			const float t = (float)ring / (float)gSkinRings;
+
+			// Same weights at both ends of a joint: half its parent joint and half the joint
+			const float grandParentWeight = max(0.5f - t, 0.0f);
+			const float childWeight = max(t - 0.5f, 0.0f);
+
+			for (int segment = 0; segment < gSkinSegments; segment++)
+			{
+				const float angle = 2.0f * PI * (float)segment / (float)gSkinSegments;
+				const vec3 normal = cosf(angle) * tangent + sinf(angle) * bitangent;
+				const vec3 position = parentPos + t * boneDir + radius * normal;
+
+				positions.push_back(position.getX());
+				positions.push_back(position.getY());
+				positions.push_back(position.getZ());
+				normals.push_back(normal.getX());
+				normals.push_back(normal.getY());
+				normals.push_back(normal.getZ());
+
+				jointIndices.push_back((uint16_t)grandParentIndex);
+				jointIndices.push_back((uint16_t)parentIndex);
+				jointIndices.push_back((uint16_t)childIndex);
+				jointWeights.push_back(grandParentWeight);
+				jointWeights.push_back(1.0f - grandParentWeight - childWeight);
+				jointWeights.push_back(childWeight);
+			}
+		}
+
+		for (int ring = 0; ring < gSkinRings; ring++)
+		{
+			for (int segment = 0; segment < gSkinSegments; segment++)
+			{
+				const uint32_t v0 = firstVertex + ring * gSkinSegments + segment;
+				const uint32_t v1 = firstVertex + ring * gSkinSegments + (segment + 1) % gSkinSegments;
+				const uint32_t v2 = v0 + gSkinSegments;
+				const uint32_t v3 = v1 + gSkinSegments;
+
+				indices.push_back(v0);
+				indices.push_back(v1);
+				indices.push_back(v2);
+				indices.push_back(v1);
+				indices.push_back(v3);
+				indices.push_back(v2);
+			}
+		}
+	}
+}
+
+// Largest difference between the components of two arrays of skinned vertices
+float compareSkinnedVertices(const SkinnedVertex* pLhs, const SkinnedVertex* pRhs, unsigned int numVertices)
+{
+	float maxError = 0.0f;
+	for (unsigned int vertexIndex = 0; vertexIndex < numVertices; vertexIndex++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			maxError = max(maxError, fabsf(pLhs[vertexIndex].mPosition[i] - pRhs[vertexIndex].mPosition[i]));
+			maxError = max(maxError, fabsf(pLhs[vertexIndex].mNormal[i] - pRhs[vertexIndex].mNormal[i]));
+		}
+	}
+	return maxError;
+}
+
 
 
 //--------------------------------------------------------------------------------------------
@@ -267,15 +419,34 @@ public:
 		basicShader.mStages[0] = { "basic.vert", NULL, 0, FSR_SrcShaders };
 		basicShader.mStages[1] = { "basic.frag", NULL, 0, FSR_SrcShaders };
 
+		ShaderLoadDesc skinShader = {};
+		skinShader.mStages[0] = { "skin.vert", NULL, 0, FSR_SrcShaders };
+		skinShader.mStages[1] = { "skin.frag", NULL, 0, FSR_SrcShaders };
+		// The skinning shader is shared by the samples in Middleware_3/Animation/Shaders
+		ShaderLoadDesc skinningShader = {};
+		skinningShader.mStages[0] = { "skinning.comp", NULL, 0, FSR_SrcShaders_Common };
+
 		addShader(pRenderer, &planeShader, &pPlaneDrawShader);
 		addShader(pRenderer, &basicShader, &pSkeletonShader);
+		addShader(pRenderer, &skinShader, &pSkinShader);
+		addShader(pRenderer, &skinningShader, &pSkinningShader);
 
-		Shader* shaders[] = { pSkeletonShader, pPlaneDrawShader };
+		Shader* shaders[] = { pSkeletonShader, pPlaneDrawShader, pSkinShader };
 		RootSignatureDesc rootDesc = {};
-		rootDesc.mShaderCount = 2;
+		rootDesc.mShaderCount = 3;
 		rootDesc.ppShaders = shaders;
 		addRootSignature(pRenderer, &rootDesc, &pRootSignature);
 
+		RootSignatureDesc skinningRootDesc = {};
+		skinningRootDesc.mShaderCount = 1;
+		skinningRootDesc.ppShaders = &pSkinningShader;
+		addRootSignature(pRenderer, &skinningRootDesc, &pSkinningRootSignature);
+
+		ComputePipelineDesc skinningPipelineDesc = {};
+		skinningPipelineDesc.pRootSignature = pSkinningRootSignature;
+		skinningPipelineDesc.pShaderProgram = pSkinningShader;
+		addComputePipeline(pRenderer, &skinningPipelineDesc, &pSkinningPipeline);
+
 		RasterizerStateDesc rasterizerStateDesc = {};
 		rasterizerStateDesc.mCullMode = CULL_MODE_NONE;
 		addRasterizerState(pRenderer, &rasterizerStateDesc, &pPlaneRast);
@@ -359,6 +530,13 @@ public:
 			addResource(&ubDesc);
 		}
 
+		ubDesc.mDesc.mSize = sizeof(UniformBlockSkin);
+		for (uint32_t i = 0; i < gImageCount; ++i)
+		{
+			ubDesc.ppBuffer = &pSkinUniformBuffer[i];
+			addResource(&ubDesc);
+		}
+
 		/************************************************************************/
 		// SETUP ANIMATION STRUCTURES
 		/************************************************************************/
@@ -414,10 +592,70 @@ public:
 		//
 		gStickFigureAnimObject.Initialize(&gStickFigureRig, &gStandAnimation);
 
+		// SKINNED MESH
+		//
+		// Generate the skin around the bones of the rig in its bind pose
+		gStickFigureAnimObject.PoseRigInBind();
+
+		tinystl::vector<float> skinPositions;
+		tinystl::vector<float> skinNormals;
+		tinystl::vector<uint16_t> skinJointIndices;
+		tinystl::vector<float> skinJointWeights;
+		tinystl::vector<uint32_t> skinIndices;
+		generateSkin(&gStickFigureRig, skinPositions, skinNormals, skinJointIndices, skinJointWeights, skinIndices);
+
+		SkinnedMeshDesc skinnedMeshDesc = {};
+		skinnedMeshDesc.mRig = &gStickFigureRig;
+		skinnedMeshDesc.mNumVertices = (unsigned int)skinPositions.size() / 3;
+		skinnedMeshDesc.mNumInfluences = 3;
+		skinnedMeshDesc.mPositions = skinPositions.data();
+		skinnedMeshDesc.mNormals = skinNormals.data();
+		skinnedMeshDesc.mJointIndices = skinJointIndices.data();
+		skinnedMeshDesc.mJointWeights = skinJointWeights.data();
+		skinnedMeshDesc.mInverseBindMats = NULL;
+		gStickFigureSkin.Initialize(skinnedMeshDesc);
+
+		SkinnedMeshGpuDesc skinnedMeshGpuDesc = {};
+		skinnedMeshGpuDesc.mRenderer = pRenderer;
+		skinnedMeshGpuDesc.mSkinningPipeline = pSkinningPipeline;
+		skinnedMeshGpuDesc.mRootSignature = pSkinningRootSignature;
+		gStickFigureSkin.InitializeGpu(skinnedMeshGpuDesc);
+
+		gNumSkinIndices = (uint32_t)skinIndices.size();
+		BufferLoadDesc skinIbDesc = {};
+		skinIbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDEX_BUFFER;
+		skinIbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+		skinIbDesc.mDesc.mIndexType = INDEX_TYPE_UINT32;
+		skinIbDesc.mDesc.mSize = gNumSkinIndices * sizeof(uint32_t);
+		skinIbDesc.pData = skinIndices.data();
+		skinIbDesc.ppBuffer = &pSkinIndexBuffer;
+		addResource(&skinIbDesc);
+
+		BufferLoadDesc cpuSkinnedVbDesc = {};
+		cpuSkinnedVbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
+		cpuSkinnedVbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+		cpuSkinnedVbDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+		cpuSkinnedVbDesc.mDesc.mSize = gStickFigureSkin.GetNumVertices() * sizeof(SkinnedVertex);
+		cpuSkinnedVbDesc.mDesc.mVertexStride = sizeof(SkinnedVertex);
+		cpuSkinnedVbDesc.pData = NULL;
+		for (uint32_t i = 0; i < gImageCount; ++i)
+		{
+			cpuSkinnedVbDesc.ppBuffer = &pCpuSkinnedVertexBuffers[i];
+			addResource(&cpuSkinnedVbDesc);
+
+			gCpuSkinnedVertices[i] = tinystl::vector<SkinnedVertex>(gStickFigureSkin.GetNumVertices());
+		}
+
 		/************************************************************************/
 
 		finishResourceLoading();
 
+		gThreadSystem.CreateThreads(Thread::GetNumCPUCores() - 1);
+
+		// Skin a pose on both the CPU and the GPU before the first frame, a mismatch fails the test
+		if (!ValidateSkinning())
+			return false;
+
 		// SETUP THE MAIN CAMERA
 		//
 		CameraMotionParameters cmp{ 50.0f, 75.0f, 150.0f };
@@ -531,6 +769,14 @@ public:
 			// DrawPlane - Checkbox
 			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
 			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("Draw Plane", &gUIData.mGeneralSettings.mDrawPlane));
+
+			// DrawSkin - Checkbox
+			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
+			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("Draw Skin", &gUIData.mGeneralSettings.mDrawSkin));
+
+			// GpuSkinning - Checkbox
+			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
+			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("GPU Skinning", &gUIData.mGeneralSettings.mGpuSkinning));
 			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
 
 
@@ -549,6 +795,8 @@ public:
 		waitForFences(pGraphicsQueue, 1, &pRenderCompleteFences[gFrameIndex], true);
 
 		// Animation data
+		gStickFigureSkin.DestroyGpu();
+		gStickFigureSkin.Destroy();
 		gSkeletonBatcher.Destroy();
 		gStickFigureRig.Destroy();
 		gStandClip.Destroy();
@@ -570,15 +818,23 @@ public:
 		for (uint32_t i = 0; i < gImageCount; ++i)
 		{
 			removeResource(pPlaneUniformBuffer[i]);
+			removeResource(pSkinUniformBuffer[i]);
+			removeResource(pCpuSkinnedVertexBuffers[i]);
 		}
 
 		removeResource(pJointVertexBuffer);
 		removeResource(pBoneVertexBuffer);
 		removeResource(pPlaneVertexBuffer);
+		removeResource(pSkinIndexBuffer);
+
+		removePipeline(pRenderer, pSkinningPipeline);
 
 		removeShader(pRenderer, pSkeletonShader);
 		removeShader(pRenderer, pPlaneDrawShader);
+		removeShader(pRenderer, pSkinShader);
+		removeShader(pRenderer, pSkinningShader);
 		removeRootSignature(pRenderer, pRootSignature);
+		removeRootSignature(pRenderer, pSkinningRootSignature);
 
 		removeDepthState(pDepth);
 
@@ -651,6 +907,24 @@ public:
 		// Update the mSkeletonPipeline pointer now that the pipeline has been loaded
 		gSkeletonBatcher.LoadPipeline(pSkeletonPipeline);
 
+		//layout and pipeline for skin draw, from the SkinnedVertex written by the CPU and the GPU skinning
+		vertexLayout = {};
+		vertexLayout.mAttribCount = 2;
+		vertexLayout.mAttribs[0].mSemantic = SEMANTIC_POSITION;
+		vertexLayout.mAttribs[0].mFormat = ImageFormat::RGBA32F;
+		vertexLayout.mAttribs[0].mBinding = 0;
+		vertexLayout.mAttribs[0].mLocation = 0;
+		vertexLayout.mAttribs[0].mOffset = 0;
+		vertexLayout.mAttribs[1].mSemantic = SEMANTIC_NORMAL;
+		vertexLayout.mAttribs[1].mFormat = ImageFormat::RGBA32F;
+		vertexLayout.mAttribs[1].mBinding = 0;
+		vertexLayout.mAttribs[1].mLocation = 1;
+		vertexLayout.mAttribs[1].mOffset = 4 * sizeof(float);
+
+		pipelineSettings.pRasterizerState = pPlaneRast;
+		pipelineSettings.pShaderProgram = pSkinShader;
+		addPipeline(pRenderer, &pipelineSettings, &pSkinPipeline);
+
 		//layout and pipeline for plane draw
 		vertexLayout = {};
 		vertexLayout.mAttribCount = 2;
@@ -684,6 +958,7 @@ public:
 #endif
 
 		removePipeline(pRenderer, pPlaneDrawPipeline);
+		removePipeline(pRenderer, pSkinPipeline);
 		removePipeline(pRenderer, pSkeletonPipeline);
 
 		removeSwapChain(pRenderer, pSwapChain);
@@ -741,6 +1016,12 @@ public:
 		// Record animation update time
 		gAnimationUpdateTimer.GetUSec(true);
 
+		// Skin the mesh to the pose on the CPU, the GPU skins it in Draw
+		gCpuSkinningTimer.Reset();
+		gStickFigureSkin.UpdatePalette();
+		gStickFigureSkin.SkinCpu(&gThreadSystem);
+		gCpuSkinningTimer.GetUSec(true);
+
 		// Update uniforms that will be shared between all skeletons
 		gSkeletonBatcher.SetSharedUniforms(projViewMat, lightPos, lightColor);
 
@@ -750,6 +1031,15 @@ public:
 		gUniformDataPlane.mProjectView = projViewMat;
 		gUniformDataPlane.mToWorldMat = mat4::identity();
 
+		/************************************************************************/
+		// Skin
+		/************************************************************************/
+		gUniformDataSkin.mProjectView = projViewMat;
+		gUniformDataSkin.mToWorldMat = gStickFigureAnimObject.GetRootTransform();
+		gUniformDataSkin.mColor = vec4(0.9f, 0.6f, 0.4f, 1.0f);
+		gUniformDataSkin.mLightPosition = vec4(lightPos, 1.0f);
+		gUniformDataSkin.mLightColor = vec4(lightColor, 1.0f);
+
 		/************************************************************************/
 		// GUI
 		/************************************************************************/
@@ -781,6 +1071,30 @@ public:
 		if (fenceStatus == FENCE_STATUS_INCOMPLETE)
 			waitForFences(pGraphicsQueue, 1, &pNextFence, false);
 
+		// COMPARE AND UPDATE THE SKINNING
+		//
+		// The last commands of this frame index have completed, compare their GPU skinning with the CPU skinning of that frame
+		const unsigned int numSkinVertices = gStickFigureSkin.GetNumVertices();
+		if (gSkinReadbackPending[gFrameIndex])
+		{
+			gSkinningMaxError = compareSkinnedVertices(gCpuSkinnedVertices[gFrameIndex].data(), gStickFigureSkin.MapGpuReadback(gFrameIndex), numSkinVertices);
+			gStickFigureSkin.UnmapGpuReadback(gFrameIndex);
+
+			if (gSkinningMaxError > gSkinningTolerance)
+				LOGERRORF("GPU skinning differs from the CPU skinning by %f", gSkinningMaxError);
+		}
+
+		// Keep the CPU skinning of this frame to compare it once the GPU has skinned it too
+		memcpy(gCpuSkinnedVertices[gFrameIndex].data(), gStickFigureSkin.GetSkinnedVertices(), numSkinVertices * sizeof(SkinnedVertex));
+
+		BufferUpdateDesc cpuSkinnedVerticesUpdate = { pCpuSkinnedVertexBuffers[gFrameIndex], gStickFigureSkin.GetSkinnedVertices() };
+		updateResource(&cpuSkinnedVerticesUpdate);
+
+		BufferUpdateDesc skinUniformUpdate = { pSkinUniformBuffer[gFrameIndex], &gUniformDataSkin };
+		updateResource(&skinUniformUpdate);
+
+		gStickFigureSkin.UpdateGpuPalette(gFrameIndex);
+
 		// Acquire the main render target from the swapchain
 		RenderTarget* pRenderTarget = pSwapChain->ppSwapchainRenderTargets[gFrameIndex];
 		Semaphore* pRenderCompleteSemaphore = pRenderCompleteSemaphores[gFrameIndex];
@@ -791,6 +1105,13 @@ public:
 		// start gpu frame profiler
 		cmdBeginGpuFrameProfile(cmd, pGpuProfiler);
 
+		// Skin the mesh on the GPU and copy the result for the comparison with the CPU skinning
+		cmdBeginGpuTimestampQuery(cmd, pGpuProfiler, "Skinning", true);
+		gStickFigureSkin.Dispatch(cmd, gFrameIndex);
+		cmdEndGpuTimestampQuery(cmd, pGpuProfiler, &pGpuSkinningTimer);
+		gStickFigureSkin.ReadbackGpu(cmd, gFrameIndex);
+		gSkinReadbackPending[gFrameIndex] = true;
+
 		TextureBarrier barriers[] =		// wait for resource transition
 		{
 			{ pRenderTarget->pTexture, RESOURCE_STATE_RENDER_TARGET },
@@ -828,6 +1149,24 @@ public:
 		gSkeletonBatcher.Draw(cmd, gFrameIndex);
 		cmdEndDebugMarker(cmd);
 
+		//// draw the skin, skinned either on the GPU or on the CPU
+		if (gUIData.mGeneralSettings.mDrawSkin)
+		{
+			cmdBeginDebugMarker(cmd, 1, 0, 1, "Draw Skin");
+			cmdBindPipeline(cmd, pSkinPipeline);
+
+			DescriptorData params[1] = {};
+			params[0].pName = "uniformBlock";
+			params[0].ppBuffers = &pSkinUniformBuffer[gFrameIndex];
+			cmdBindDescriptors(cmd, pRootSignature, 1, params);
+
+			Buffer* pSkinVertexBuffer = gUIData.mGeneralSettings.mGpuSkinning ? gStickFigureSkin.GetSkinnedVertexBuffer() : pCpuSkinnedVertexBuffers[gFrameIndex];
+			cmdBindVertexBuffer(cmd, 1, &pSkinVertexBuffer, NULL);
+			cmdBindIndexBuffer(cmd, pSkinIndexBuffer, 0);
+			cmdDrawIndexed(cmd, gNumSkinIndices, 0, 0);
+			cmdEndDebugMarker(cmd);
+		}
+
 		//// draw the UI
 		cmdBeginDebugMarker(cmd, 0, 1, 0, "Draw UI");
 		gTimer.GetUSec(true);
@@ -841,6 +1180,17 @@ public:
 #ifndef METAL // Metal doesn't support GPU profilers
 		drawDebugText(cmd, 8, 40, tinystl::string::format("GPU %f ms", (float)pGpuProfiler->mCumulativeTime * 1000.0f), &gFrameTimeDraw);
 #endif
+
+		// Skinning throughput of both back ends
+		const float cpuSkinningMs = gCpuSkinningTimer.GetUSecAverage() / 1000.0f;
+		drawDebugText(cmd, 8, 90, tinystl::string::format("CPU Skinning %f ms (%.0f vertices/ms)", cpuSkinningMs,
+			cpuSkinningMs > 0.0f ? numSkinVertices / cpuSkinningMs : 0.0f), &gFrameTimeDraw);
+#ifndef METAL // Metal doesn't support GPU profilers
+		const float gpuSkinningMs = pGpuSkinningTimer ? (float)getAverageGpuTime(pGpuProfiler, pGpuSkinningTimer) * 1000.0f : 0.0f;
+		drawDebugText(cmd, 8, 115, tinystl::string::format("GPU Skinning %f ms (%.0f vertices/ms)", gpuSkinningMs,
+			gpuSkinningMs > 0.0f ? numSkinVertices / gpuSkinningMs : 0.0f), &gFrameTimeDraw);
+#endif
+		drawDebugText(cmd, 8, 140, tinystl::string::format("CPU/GPU Skinning Difference %f", gSkinningMaxError), &gFrameTimeDraw);
 		gAppUI.Draw(cmd);
 		
 		cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
@@ -862,6 +1212,38 @@ public:
 		return "01_Playback";
 	}
 
+	bool ValidateSkinning()
+	{
+		// Pose the rig away from its bind pose, where every skinning matrix would be the identity
+		gStickFigureAnimObject.Update(gStandClip.GetDuration() * 0.5f);
+		gStickFigureAnimObject.PoseRig();
+
+		gStickFigureSkin.UpdatePalette();
+		gStickFigureSkin.SkinCpu(&gThreadSystem);
+		gStickFigureSkin.UpdateGpuPalette(0);
+
+		Cmd* cmd = ppCmds[0];
+		beginCmd(cmd);
+		gStickFigureSkin.Dispatch(cmd, 0);
+		gStickFigureSkin.ReadbackGpu(cmd, 0);
+		endCmd(cmd);
+
+		queueSubmit(pGraphicsQueue, 1, &cmd, pRenderCompleteFences[0], 0, NULL, 0, NULL);
+		waitForFences(pGraphicsQueue, 1, &pRenderCompleteFences[0], false);
+
+		const float maxError = compareSkinnedVertices(gStickFigureSkin.GetSkinnedVertices(), gStickFigureSkin.MapGpuReadback(0), gStickFigureSkin.GetNumVertices());
+		gStickFigureSkin.UnmapGpuReadback(0);
+
+		if (maxError > gSkinningTolerance)
+		{
+			LOGERRORF("GPU skinning of %u vertices differs from the CPU skinning by %f", gStickFigureSkin.GetNumVertices(), maxError);
+			return false;
+		}
+
+		LOGINFOF("GPU skinning of %u vertices matches the CPU skinning, largest difference %f", gStickFigureSkin.GetNumVertices(), maxError);
+		return true;
+	}
+
 	bool addSwapChain()
 	{
 		SwapChainDesc swapChainDesc = {};
@@ -0,0 +1,63 @@
+#version 450 core
+
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Shades the mesh skinned by SkinnedMesh in Middleware_3/Animation. The vertices are read in the SkinnedVertex layout
+// written by both the CPU and the GPU skinning
+
+layout(location = 0) in vec4 Position;
+layout(location = 1) in vec4 Normal;
+
+layout(location = 0) out vec4 Color;
+
+layout (std140, set=0, binding=0) uniform uniformBlock {
+	uniform mat4 mvp;
+	uniform mat4 toWorld;
+	uniform vec4 color;
+
+	// Point Light Information
+	uniform vec4 lightPosition;
+	uniform vec4 lightColor;
+};
+
+void main ()
+{
+	vec4 pos = toWorld * vec4(Position.xyz, 1.0f);
+	gl_Position = mvp * pos;
+
+	// The skinning renormalizes the normals
+	vec4 normal = toWorld * vec4(Normal.xyz, 0.0f); // Assume uniform scaling
+
+	float lightIntensity = 1.0f;
+	float ambientCoeff = 0.4;
+
+	vec3 lightDir = normalize(lightPosition.xyz - pos.xyz);
+
+	vec3 baseColor = color.xyz;
+	vec3 blendedColor = lightColor.xyz * baseColor * lightIntensity;
+	vec3 diffuse = blendedColor * max(dot(normal.xyz, lightDir), 0.0);
+	vec3 ambient = baseColor * ambientCoeff;
+	Color = vec4(diffuse + ambient, 1.0);
+}
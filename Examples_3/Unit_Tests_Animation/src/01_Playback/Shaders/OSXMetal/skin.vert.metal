@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <metal_stdlib>
+using namespace metal;
+
+// Shades the mesh skinned by SkinnedMesh in Middleware_3/Animation. The vertices are read in the SkinnedVertex layout
+// written by both the CPU and the GPU skinning
+
+struct Uniforms_uniformBlock
+{
+	float4x4 mvp;
+	float4x4 toWorld;
+	float4 color;
+
+	// Point Light Information
+	float4 lightPosition;
+	float4 lightColor;
+};
+
+struct VSInput
+{
+	float4 Position [[attribute(0)]];
+	float4 Normal [[attribute(1)]];
+};
+
+struct VSOutput
+{
+	float4 Position [[position]];
+	float4 Color;
+};
+
+vertex VSOutput stageMain(VSInput input                                      [[stage_in]],
+                          constant Uniforms_uniformBlock& uniformBlock       [[buffer(1)]])
+{
+	VSOutput result;
+
+	float4 pos = uniformBlock.toWorld * float4(input.Position.xyz, 1.0);
+	result.Position = uniformBlock.mvp * pos;
+
+	// The skinning renormalizes the normals
+	float4 normal = uniformBlock.toWorld * float4(input.Normal.xyz, 0.0); // Assume uniform scaling
+
+	float lightIntensity = 1.0;
+	float ambientCoeff = 0.4;
+
+	float3 lightDir = normalize(uniformBlock.lightPosition.xyz - pos.xyz);
+
+	float3 baseColor = uniformBlock.color.xyz;
+	float3 blendedColor = uniformBlock.lightColor.xyz * baseColor * lightIntensity;
+	float3 diffuse = blendedColor * max(dot(normal.xyz, lightDir), 0.0);
+	float3 ambient = baseColor * ambientCoeff;
+	result.Color = float4(diffuse + ambient, 1.0);
+
+	return result;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Shades the mesh skinned by SkinnedMesh in Middleware_3/Animation. The vertices are read in the SkinnedVertex layout
+// written by both the CPU and the GPU skinning
+
+cbuffer uniformBlock : register(b0)
+{
+    float4x4 mvp;
+    float4x4 toWorld;
+    float4 color;
+
+    // Point Light Information
+    float4 lightPosition;
+    float4 lightColor;
+};
+
+struct VSInput
+{
+    float4 Position : POSITION;
+    float4 Normal : NORMAL;
+};
+
+struct VSOutput {
+    float4 Position : SV_POSITION;
+    float4 Color : COLOR;
+};
+
+VSOutput main(VSInput input)
+{
+    VSOutput result;
+
+    float4 pos = mul(toWorld, float4(input.Position.xyz, 1.0f));
+    result.Position = mul(mvp, pos);
+
+    // The skinning renormalizes the normals
+    float4 normal = mul(toWorld, float4(input.Normal.xyz, 0.0f)); // Assume uniform scaling
+
+    float lightIntensity = 1.0f;
+    float ambientCoeff = 0.4;
+
+    float3 lightDir = normalize(lightPosition.xyz - pos.xyz);
+
+    float3 baseColor = color.xyz;
+    float3 blendedColor = lightColor.xyz * baseColor * lightIntensity;
+    float3 diffuse = blendedColor * max(dot(normal.xyz, lightDir), 0.0);
+    float3 ambient = baseColor * ambientCoeff;
+    result.Color = float4(diffuse + ambient, 1.0);
+
+    return result;
+}
@@ -217,6 +217,7 @@ struct UIData
 	{
 		bool		mShowBindPose = false;
 		bool		mDrawPlane = true;
+		bool*		mBlendFastPaths;
 	};
 	GeneralSettingsData mGeneralSettings;
 };
@@ -607,6 +608,9 @@ public:
 
 		gUIData.mBlendParams.mThreshold = gBlendedAnimation.GetThresholdPtr();
 
+		// General Settings
+		gUIData.mGeneralSettings.mBlendFastPaths = gBlendedAnimation.GetBlendFastPathsPtr();
+
 		// Walk Clip
 		gUIData.mWalkClip.mPlaybackSpeed = gWalkClipController.GetPlaybackSpeedPtr();
 
@@ -794,6 +798,10 @@ public:
 			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("Draw Plane", &gUIData.mGeneralSettings.mDrawPlane));
 			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
 
+			// BlendFastPaths - Checkbox
+			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("Blend Fast Paths", gUIData.mGeneralSettings.mBlendFastPaths));
+			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
+
 			// Add all widgets to the window
 			pStandaloneControlsGUIWindow->AddWidget(CollapsingBlendParamsWidgets);
 			pStandaloneControlsGUIWindow->AddWidget(CollapsingWalkClipWidgets);
@@ -223,6 +223,7 @@ struct UIData
 	{
 		bool		mShowBindPose = false;
 		bool		mDrawPlane = true;
+		bool*		mBlendFastPaths;
 	};
 	GeneralSettingsData mGeneralSettings;
 };
@@ -577,6 +578,9 @@ public:
 		gUIData.mBlendParams.mWalkClipWeight = gWalkClipController.GetWeightPtr();
 		gUIData.mBlendParams.mThreshold = gBlendedAnimation.GetThresholdPtr();
 
+		// General Settings
+		gUIData.mGeneralSettings.mBlendFastPaths = gBlendedAnimation.GetBlendFastPathsPtr();
+
 		// Stand Clip
 		gUIData.mStandClip.mPlay = gStandClipController.GetPlayPtr();
 		gUIData.mStandClip.mLoop = gStandClipController.GetLoopPtr();
@@ -746,6 +750,10 @@ public:
 			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("Draw Plane", &gUIData.mGeneralSettings.mDrawPlane));
 			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
 
+			// BlendFastPaths - Checkbox
+			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("Blend Fast Paths", gUIData.mGeneralSettings.mBlendFastPaths));
+			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
+
 
 			// Add all widgets to the window
 			pStandaloneControlsGUIWindow->AddWidget(CollapsingBlendParamsWidgets);
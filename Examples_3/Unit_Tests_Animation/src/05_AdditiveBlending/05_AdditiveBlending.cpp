@@ -223,6 +223,7 @@ struct UIData
 	{
 		bool		mShowBindPose = false;
 		bool		mDrawPlane = true;
+		bool*		mBlendFastPaths;
 	};
 	GeneralSettingsData mGeneralSettings;
 };
@@ -542,6 +543,9 @@ public:
 		gUIData.mBlendParams.mNeckCrackClipWeight = gNeckCrackClipController.GetWeightPtr();
 		gUIData.mBlendParams.mThreshold = gBlendedAnimation.GetThresholdPtr();
 
+		// General Settings
+		gUIData.mGeneralSettings.mBlendFastPaths = gBlendedAnimation.GetBlendFastPathsPtr();
+
 		// Walk Clip
 		gUIData.mWalkClip.mPlay = gWalkClipController.GetPlayPtr();
 		gUIData.mWalkClip.mLoop = gWalkClipController.GetLoopPtr();
@@ -691,6 +695,10 @@ public:
 			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("Draw Plane", &gUIData.mGeneralSettings.mDrawPlane));
 			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
 
+			// BlendFastPaths - Checkbox
+			CollapsingGeneralSettingsWidgets.AddSubWidget(CheckboxWidget("Blend Fast Paths", gUIData.mGeneralSettings.mBlendFastPaths));
+			CollapsingGeneralSettingsWidgets.AddSubWidget(SeparatorWidget());
+
 			
 			// Add all widgets to the window
 			pStandaloneControlsGUIWindow->AddWidget(CollapsingBlendParamsWidgets);
@@ -49,9 +49,15 @@
 #include "../../../../Middleware_3/Animation/SkeletonBatcher.h"
 #include "../../../../Middleware_3/Animation/AnimatedObject.h"
 #include "../../../../Middleware_3/Animation/Animation.h"
+#include "../../../../Middleware_3/Animation/AnimationInstancer.h"
+#include "../../../../Middleware_3/Animation/AnimationScheduler.h"
+#include "../../../../Middleware_3/Animation/AnimationSystem.h"
 #include "../../../../Middleware_3/Animation/Clip.h"
+#include "../../../../Middleware_3/Animation/ClipLoader.h"
 #include "../../../../Middleware_3/Animation/ClipController.h"
+#include "../../../../Middleware_3/Animation/ClipOptimizer.h"
 #include "../../../../Middleware_3/Animation/Rig.h"
+#include "../../../../Middleware_3/Animation/VertexAnimationTexture.h"
 
 #include "../../../../Middleware_3/UI/AppUI.h"
 #include "../../../../Middleware_3/Input/InputSystem.h"
@@ -128,6 +134,30 @@ UniformBlockPlane		gUniformDataPlane;
 
 Buffer*				pPlaneUniformBuffer[gImageCount] = { NULL };
 
+Shader*				pVATShader = NULL;
+Pipeline*			pVATPipeline = NULL;
+Sampler*			pVATSampler = NULL;
+Texture*			pVATTexture = NULL;
+Buffer*				pVATInstanceBuffer = NULL;
+
+struct UniformBlockVAT
+{
+	mat4 mProjectView;
+	vec4 mJointColor[2];
+	vec4 mBoneColor[2];
+	vec4 mLightPosition;
+	vec4 mLightColor;
+
+	// x: time of the crowd, y: duration of the clip, z: number of frames - 1
+	vec4 mTime;
+
+	// x: number of joints, y: width of the texture, z: rows per frame
+	uint32_t mLayout[4];
+};
+UniformBlockVAT		gUniformDataVAT;
+
+Buffer*				pVATUniformBuffer[gImageCount] = { NULL };
+
 //--------------------------------------------------------------------------------------------
 // CAMERA CONTROLLER & SYSTEMS (File/Log/UI)
 //--------------------------------------------------------------------------------------------
@@ -150,8 +180,11 @@ GpuProfiler*		pGpuProfiler = NULL;
 unsigned int		gNumRigs = 50; // Determines the number of rigs to update and draw
 const unsigned int	kMaxNumRigs = 4096;
 
-// AnimatedObjects
-AnimatedObject		gStickFigureAnimObjects[kMaxNumRigs];
+// AnimationSystem owns the AnimatedObjects and updates all of them in parallel
+AnimationSystem		gAnimationSystem;
+
+// Time step of the frame, the animation is updated in Draw once the instance buffers of the frame are free
+float				gAnimationDeltaTime = 0.0f;
 
 // Animations
 Animation			gWalkAnimations[kMaxNumRigs];
@@ -162,6 +195,47 @@ ClipController		gWalkClipControllers[kMaxNumRigs];
 // Clips
 Clip				gWalkClip;
 
+// ClipLoader loading gWalkClip while the rigs are loaded
+ClipLoader			gClipLoader;
+
+// Tolerance in millimeters of the walk clip optimization, adjusted by the UI
+float				gClipOptimizerToleranceMm = 5.0f;
+
+// Set by the UI to optimize the walk clip into gOptimizedWalkClipName on the next update
+bool				gOptimizeWalkClip = false;
+
+// Results of the last optimization of the walk clip, gWalkClipOptimizeMs is 0 until the clip is optimized
+ClipOptimizerStats	gWalkClipOptimizerStats = {};
+float				gWalkClipOptimizeMs = 0.0f;
+
+// LodMask leaving out the end joints of the rigs far from the camera
+LodMask				gStickFigureLodMask;
+
+// AnimationScheduler picks the level of detail of each rig and which ones are updated each frame
+AnimationScheduler	gAnimationScheduler;
+
+// CPU budget of the animation update in milliseconds adjusted by the UI, 0 for no budget
+float				gAnimationBudgetMs = 0.0f;
+
+// AnimationInstancer shares the sampling of gWalkClip between the rigs
+AnimationInstancer	gWalkAnimationInstancer;
+
+// Error bound of the instancer in milliseconds, adjusted by the UI
+float				gMaxTimeErrorMs = 1000.0f / 120.0f;
+
+// Walk clip baked into a texture, the rigs are played back from it on the GPU when gEnableVAT is set
+VertexAnimationTexture		gWalkVAT;
+VertexAnimationTextureStats	gWalkVATStats;
+
+// Toggle for the GPU playback through UI, which skips the CPU animation update
+bool				gEnableVAT = false;
+
+// Set by the UI to save gWalkVAT to gWalkVATName on the next update
+bool				gExportWalkVAT = false;
+
+// Time of the crowd played back from gWalkVAT
+float				gVATTime = 0.0f;
+
 // Rigs
 Rig					gStickFigureRigs[kMaxNumRigs];
 
@@ -171,6 +245,8 @@ SkeletonBatcher		gSkeletonBatcher;
 // Filenames
 const char*			gStickFigureName = "stickFigure/skeleton.ozz";
 const char*			gWalkClipName = "stickFigure/animations/walk.ozz";
+const char*			gWalkVATName = "walkVAT.dds";
+const char*			gOptimizedWalkClipName = "walkOptimized.ozz";
 const char*			pPlaneImageFileName = "Skybox_right1.png";
 
 const int			gSphereResolution = 3; // Increase for higher resolution joint spheres
@@ -187,19 +263,8 @@ static HiresTimer	gAnimationUpdateTimer;
 // Toggle for enabling/disabling threading through UI
 bool					gEnableThreading = true;
 
-// Maximum number of tasks to be threaded
-const unsigned int		kMaxTaskCount = kMaxNumRigs;
-
-// Number of rigs per task that will be adjusted by the UI
-unsigned int			gGrainSize = 32;
-
-struct ThreadData
-{
-	AnimatedObject*	mAnimatedObject;
-	float				mDeltaTime;
-	unsigned int		mNumberSystems;
-};
-ThreadData				gThreadData[kMaxTaskCount];
+// Number of rigs per task that will be adjusted by the UI, 0 lets the AnimationSystem pick it
+unsigned int			gGrainSize = 0;
 
 ThreadPool				gThreadSystem;
 
@@ -218,6 +283,12 @@ struct UIData
 	struct SampleControlData
 	{
 		unsigned int* mNumberOfRigs = &gNumRigs;
+		bool*		  mEnableLod = nullptr;
+		float*		  mAnimationBudgetMs = &gAnimationBudgetMs;
+		bool*		  mEnableInstancing = nullptr;
+		float*		  mMaxTimeErrorMs = &gMaxTimeErrorMs;
+		bool*		  mEnableVAT = &gEnableVAT;
+		float*		  mClipOptimizerToleranceMm = &gClipOptimizerToleranceMm;
 	};
 	SampleControlData mSampleControl;
 
@@ -281,14 +352,32 @@ public:
 		ShaderLoadDesc basicShader = {};
 		basicShader.mStages[0] = { "basic.vert", NULL, 0, FSR_SrcShaders };
 		basicShader.mStages[1] = { "basic.frag", NULL, 0, FSR_SrcShaders };
+		ShaderLoadDesc vatShader = {};
+		vatShader.mStages[0] = { "vat.vert", NULL, 0, FSR_SrcShaders };
+		vatShader.mStages[1] = { "vat.frag", NULL, 0, FSR_SrcShaders };
 
 		addShader(pRenderer, &planeShader, &pPlaneDrawShader);
 		addShader(pRenderer, &basicShader, &pSkeletonShader);
-
-		Shader* shaders[] = { pSkeletonShader, pPlaneDrawShader };
+		addShader(pRenderer, &vatShader, &pVATShader);
+
+		// The vertex animation texture is read texel by texel
+		SamplerDesc vatSamplerDesc = {};
+		vatSamplerDesc.mMinFilter = FILTER_NEAREST;
+		vatSamplerDesc.mMagFilter = FILTER_NEAREST;
+		vatSamplerDesc.mMipMapMode = MIPMAP_MODE_NEAREST;
+		vatSamplerDesc.mAddressU = ADDRESS_MODE_CLAMP_TO_EDGE;
+		vatSamplerDesc.mAddressV = ADDRESS_MODE_CLAMP_TO_EDGE;
+		vatSamplerDesc.mAddressW = ADDRESS_MODE_CLAMP_TO_EDGE;
+		addSampler(pRenderer, &vatSamplerDesc, &pVATSampler);
+
+		const char* pVATSamplerName = "vatSampler";
+		Shader* shaders[] = { pSkeletonShader, pPlaneDrawShader, pVATShader };
 		RootSignatureDesc rootDesc = {};
-		rootDesc.mShaderCount = 2;
+		rootDesc.mShaderCount = 3;
 		rootDesc.ppShaders = shaders;
+		rootDesc.ppStaticSamplerNames = &pVATSamplerName;
+		rootDesc.ppStaticSamplers = &pVATSampler;
+		rootDesc.mStaticSamplerCount = 1;
 		addRootSignature(pRenderer, &rootDesc, &pRootSignature);
 
 		RasterizerStateDesc rasterizerStateDesc = {};
@@ -374,6 +463,13 @@ public:
 			addResource(&ubDesc);
 		}
 
+		ubDesc.mDesc.mSize = sizeof(UniformBlockVAT);
+		for (uint32_t i = 0; i < gImageCount; ++i)
+		{
+			ubDesc.ppBuffer = &pVATUniformBuffer[i];
+			addResource(&ubDesc);
+		}
+
 		/************************************************************************/
 		// SETUP ANIMATION STRUCTURES
 		/************************************************************************/
@@ -393,18 +489,22 @@ public:
 
 		gSkeletonBatcher.Initialize(skeletonRenderDesc);
 
+		// CLIPS
+		//
+		// Start loading the clip on the loader thread, all the skeletons are the same so the first one is used
+		gClipLoader.Initialize();
+		tinystl::string fullPath = FileSystem::FixPath(gWalkClipName, FSR_Animation);
+		gClipLoader.LoadClip(&gWalkClip, fullPath.c_str(), &gStickFigureRigs[0]);
+
 		// RIGS
 		//
-		tinystl::string fullPath = FileSystem::FixPath(gStickFigureName, FSR_Animation);
+		fullPath = FileSystem::FixPath(gStickFigureName, FSR_Animation);
 
 		// Initialize the rig with the path to its ozz file and its rendering details
 		for (unsigned int i = 0; i < kMaxNumRigs; i++)
 		{
 			gStickFigureRigs[i].Initialize(fullPath.c_str());
 
-			// Add the rig to the list of skeletons to render
-			gSkeletonBatcher.AddRig(&gStickFigureRigs[i]);
-
 			// alternate the rig colors
 			if (i % 2 == 1)
 			{
@@ -413,12 +513,26 @@ public:
 			}
 		}
 
-		// CLIPS
+		// Wait for the clip, its duration is needed by the clip controllers
+		gClipLoader.WaitIdle();
+		if (!gWalkClip.IsLoaded())
+			return false;
+
+		// VERTEX ANIMATION TEXTURE
 		//
-		fullPath = FileSystem::FixPath(gWalkClipName, FSR_Animation);
+		// Bake the walk clip for the GPU playback, the playback needs neither the clip nor the rigs
+		VertexAnimationTextureDesc vertexAnimationTextureDesc{};
+		vertexAnimationTextureDesc.mType = VAT_TYPE_SKELETON;
+		vertexAnimationTextureDesc.mRig = &gStickFigureRigs[0];
+		vertexAnimationTextureDesc.mClip = &gWalkClip;
 
-		// Since all the skeletons are the same we can just initialize with the first one
-		gWalkClip.Initialize(fullPath.c_str(), &gStickFigureRigs[0]);
+		if (!gWalkVAT.Bake(vertexAnimationTextureDesc, &gWalkVATStats))
+			return false;
+
+		TextureLoadDesc vatTextureDesc = {};
+		vatTextureDesc.pImage = gWalkVAT.GetImage();
+		vatTextureDesc.ppTexture = &pVATTexture;
+		addResource(&vatTextureDesc);
 
 		// CLIP CONTROLLERS
 		//
@@ -426,8 +540,19 @@ public:
 		for (unsigned int i = 0; i < kMaxNumRigs; i++)
 		{
 			gWalkClipControllers[i].Initialize(gWalkClip.GetDuration());
+
+			// Spread the rigs over the clip so they are not all at the same time
+			gWalkClipControllers[i].SetTimeRatio((float)i * 0.618034f);
 		}
 
+		// ANIMATION INSTANCER
+		//
+		AnimationInstancerDesc animationInstancerDesc{};
+		animationInstancerDesc.mRig = &gStickFigureRigs[0];
+		animationInstancerDesc.mMaxTimeError = gMaxTimeErrorMs / 1000.0f;
+
+		gWalkAnimationInstancer.Initialize(animationInstancerDesc);
+
 		// ANIMATIONS
 		//
 		for (unsigned int i = 0; i < kMaxNumRigs; i++)
@@ -437,21 +562,82 @@ public:
 			animationDesc.mNumLayers = 1;
 			animationDesc.mLayerProperties[0].mClip = &gWalkClip;
 			animationDesc.mLayerProperties[0].mClipController = &gWalkClipControllers[i];
+			animationDesc.mInstancer = &gWalkAnimationInstancer;
 			
 			gWalkAnimations[i].Initialize(animationDesc);
 		}
 
+		// LOD MASK
+		//
+		// Far away rigs only evaluate the joints that have children
+		gStickFigureLodMask.Initialize(&gStickFigureRigs[0]);
+		{
+			ozz::Range<const ozz::animation::Skeleton::JointProperties> jointProperties = gStickFigureRigs[0].GetSkeleton()->joint_properties();
+			tinystl::vector<bool> hasChildren(gStickFigureRigs[0].GetNumJoints(), false);
+			for (unsigned int i = 0; i < gStickFigureRigs[0].GetNumJoints(); i++)
+			{
+				if (jointProperties[i].parent != ozz::animation::Skeleton::kNoParentIndex)
+					hasChildren[jointProperties[i].parent] = true;
+			}
+			for (unsigned int i = 0; i < gStickFigureRigs[0].GetNumJoints(); i++)
+			{
+				if (!hasChildren[i])
+					gStickFigureLodMask.SetAllChildrenOf(i, false);
+			}
+		}
+
+		// ANIMATION SCHEDULER
+		//
+		AnimationSchedulerDesc animationSchedulerDesc{};
+		animationSchedulerDesc.mNumLodLevels = 3;
+		animationSchedulerDesc.mLodLevels[0].mMaxDistance = 15.0f;
+		animationSchedulerDesc.mLodLevels[0].mUpdatePeriod = 1;
+		animationSchedulerDesc.mLodLevels[1].mMaxDistance = 40.0f;
+		animationSchedulerDesc.mLodLevels[1].mUpdatePeriod = 2;
+		animationSchedulerDesc.mLodLevels[2].mUpdatePeriod = 4;
+		animationSchedulerDesc.mLodLevels[2].mLodMask = &gStickFigureLodMask;
+		animationSchedulerDesc.mOffscreenUpdatePeriod = 8;
+		animationSchedulerDesc.mBoundingRadius = 1.0f;
+		animationSchedulerDesc.mBudgetMs = gAnimationBudgetMs;
+
+		gAnimationScheduler.Initialize(animationSchedulerDesc);
+
+		// ANIMATION SYSTEM
+		//
+		// The objects are added to the scheduler and their rigs to the list of skeletons to render
+		AnimationSystemDesc animationSystemDesc{};
+		animationSystemDesc.mMaxNumObjects = kMaxNumRigs;
+		animationSystemDesc.mScheduler = &gAnimationScheduler;
+		animationSystemDesc.mSkeletonBatcher = &gSkeletonBatcher;
+
+		gAnimationSystem.Initialize(animationSystemDesc);
+
 		// ANIMATED OBJECTS
 		//
+		// The GPU playback places the rigs at the same offsets and times as the clip controllers
+		tinystl::vector<vec4> vatInstances(kMaxNumRigs);
 		for (unsigned int i = 0; i < kMaxNumRigs; i++)
 		{
-			gStickFigureAnimObjects[i].Initialize(&gStickFigureRigs[i], &gWalkAnimations[i]);
+			AnimatedObject* animatedObject = gAnimationSystem.AddObject(&gStickFigureRigs[i], &gWalkAnimations[i]);
 
 			// Calculate and set offset for each rig
 			vec3 offset = vec3(-8.75f + 0.75f * (i % 25), 0.0f, 6.0f - 2 * (i / 25));
-			gStickFigureAnimObjects[i].SetRootTransform(mat4::translation(offset));
+			animatedObject->SetRootTransform(mat4::translation(offset));
+
+			vatInstances[i] = vec4(offset, fmodf((float)i * 0.618034f, 1.0f) * gWalkVAT.GetDuration());
 		}
 
+		BufferLoadDesc vatInstanceDesc = {};
+		vatInstanceDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+		vatInstanceDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+		vatInstanceDesc.mDesc.mFirstElement = 0;
+		vatInstanceDesc.mDesc.mElementCount = kMaxNumRigs;
+		vatInstanceDesc.mDesc.mStructStride = sizeof(vec4);
+		vatInstanceDesc.mDesc.mSize = vatInstanceDesc.mDesc.mElementCount * vatInstanceDesc.mDesc.mStructStride;
+		vatInstanceDesc.pData = vatInstances.data();
+		vatInstanceDesc.ppBuffer = &pVATInstanceBuffer;
+		addResource(&vatInstanceDesc);
+
 		/************************************************************************/
 
 		finishResourceLoading();
@@ -489,6 +675,8 @@ public:
 
 		// SET gUIData MEMBERS THAT NEED POINTERS TO ANIMATION DATA
 		//
+		gUIData.mSampleControl.mEnableLod = gAnimationScheduler.GetEnabledPtr();
+		gUIData.mSampleControl.mEnableInstancing = gWalkAnimationInstancer.GetEnabledPtr();
 
 		// SET UP GUI BASED ON gUIData STRUCT
 		//
@@ -501,8 +689,8 @@ public:
 			CollapsingThreadingControlWidgets.AddSubWidget(SeparatorWidget());
 			CollapsingThreadingControlWidgets.AddSubWidget(CheckboxWidget("Enable Threading", gUIData.mThreadingControl.mEnableThreading));
 
-			// GrainSize - Slider
-			unsigned uintValMin = 1;
+			// GrainSize - Slider, 0 for automatic
+			unsigned uintValMin = 0;
 			unsigned uintValMax = kMaxNumRigs;
 			unsigned sliderStepSizeUint = 1;
 
@@ -523,6 +711,42 @@ public:
 			CollapsingSampleControlWidgets.AddSubWidget(SliderUintWidget("Number of Rigs", gUIData.mSampleControl.mNumberOfRigs, uintValMin, uintValMax, sliderStepSizeUint));
 			CollapsingSampleControlWidgets.AddSubWidget(SeparatorWidget());
 
+			// EnableLod - Checkbox
+			CollapsingSampleControlWidgets.AddSubWidget(CheckboxWidget("Animation LOD", gUIData.mSampleControl.mEnableLod));
+
+			// AnimationBudget - Slider
+			CollapsingSampleControlWidgets.AddSubWidget(SliderFloatWidget("Animation Budget (ms)", gUIData.mSampleControl.mAnimationBudgetMs, 0.0f, 20.0f, 0.25f));
+			CollapsingSampleControlWidgets.AddSubWidget(SeparatorWidget());
+
+			// EnableInstancing - Checkbox
+			CollapsingSampleControlWidgets.AddSubWidget(CheckboxWidget("Animation Instancing", gUIData.mSampleControl.mEnableInstancing));
+
+			// MaxTimeError - Slider
+			float floatValMin = 0.5f;
+			float floatValMax = 50.0f;
+			float sliderStepSizeFloat = 0.5f;
+
+			CollapsingSampleControlWidgets.AddSubWidget(SliderFloatWidget("Max Time Error (ms)", gUIData.mSampleControl.mMaxTimeErrorMs, floatValMin, floatValMax, sliderStepSizeFloat));
+			CollapsingSampleControlWidgets.AddSubWidget(SeparatorWidget());
+
+			// EnableVAT - Checkbox
+			CollapsingSampleControlWidgets.AddSubWidget(CheckboxWidget("Baked Crowd (VAT)", gUIData.mSampleControl.mEnableVAT));
+
+			// ExportWalkVAT - Button
+			ButtonWidget exportWalkVAT("Export Walk VAT");
+			exportWalkVAT.pOnEdited = []() { gExportWalkVAT = true; };
+			CollapsingSampleControlWidgets.AddSubWidget(exportWalkVAT);
+			CollapsingSampleControlWidgets.AddSubWidget(SeparatorWidget());
+
+			// ClipOptimizerTolerance - Slider
+			CollapsingSampleControlWidgets.AddSubWidget(SliderFloatWidget("Clip Optimizer Tolerance (mm)", gUIData.mSampleControl.mClipOptimizerToleranceMm, 0.1f, 20.0f, 0.1f));
+
+			// OptimizeWalkClip - Button
+			ButtonWidget optimizeWalkClip("Optimize Walk Clip");
+			optimizeWalkClip.pOnEdited = []() { gOptimizeWalkClip = true; };
+			CollapsingSampleControlWidgets.AddSubWidget(optimizeWalkClip);
+			CollapsingSampleControlWidgets.AddSubWidget(SeparatorWidget());
+
 
 			// GENERAL SETTINGS
 			//
@@ -559,19 +783,25 @@ public:
 		}
 
 		// Clips
+		gClipLoader.Destroy();
 		gWalkClip.Destroy();
+		gWalkVAT.Destroy();
 		
 		// Animations
 		for (unsigned int i = 0; i < kMaxNumRigs; i++)
 		{
 			gWalkAnimations[i].Destroy();
 		}
-		
-		// AnimatedObjects
-		for (unsigned int i = 0; i < kMaxNumRigs; i++)
-		{
-			gStickFigureAnimObjects[i].Destroy();
-		}
+
+		// AnimationInstancer
+		gWalkAnimationInstancer.Destroy();
+
+		// AnimationSystem
+		gAnimationSystem.Destroy();
+
+		// AnimationScheduler
+		gAnimationScheduler.Destroy();
+		gStickFigureLodMask.Destroy();
 
 		destroyCameraController(pCameraController);
 
@@ -588,15 +818,21 @@ public:
 		for (uint32_t i = 0; i < gImageCount; ++i)
 		{
 			removeResource(pPlaneUniformBuffer[i]);
+			removeResource(pVATUniformBuffer[i]);
 		}
 
+		removeResource(pVATInstanceBuffer);
+		removeResource(pVATTexture);
+
 		removeResource(pJointVertexBuffer);
 		removeResource(pBoneVertexBuffer);
 		removeResource(pPlaneVertexBuffer);
 
 		removeShader(pRenderer, pSkeletonShader);
 		removeShader(pRenderer, pPlaneDrawShader);
+		removeShader(pRenderer, pVATShader);
 		removeRootSignature(pRenderer, pRootSignature);
+		removeSampler(pRenderer, pVATSampler);
 
 		removeDepthState(pDepth);
 
@@ -669,6 +905,10 @@ public:
 		// Update the mSkeletonPipeline pointer now that the pipeline has been loaded
 		gSkeletonBatcher.LoadPipeline(pSkeletonPipeline);
 
+		// The skeletons played back from the vertex animation texture use the same layout and states
+		pipelineSettings.pShaderProgram = pVATShader;
+		addPipeline(pRenderer, &pipelineSettings, &pVATPipeline);
+
 		//layout and pipeline for plane draw
 		vertexLayout = {};
 		vertexLayout.mAttribCount = 2;
@@ -703,6 +943,7 @@ public:
 
 		removePipeline(pRenderer, pPlaneDrawPipeline);
 		removePipeline(pRenderer, pSkeletonPipeline);
+		removePipeline(pRenderer, pVATPipeline);
 
 		removeSwapChain(pRenderer, pSwapChain);
 		removeRenderTarget(pRenderer, pDepthBuffer);
@@ -738,62 +979,63 @@ public:
 		/************************************************************************/
 		// Animation
 		/************************************************************************/
-		gAnimationUpdateTimer.Reset();
+		// The objects are updated in Draw, straight into the instance buffers of the frame
+		gAnimationDeltaTime = deltaTime;
 
-		// Update the animated objects amd pose the rigs based on the animated object's updated values for this frame
+		// Update uniforms that will be shared between all skeletons
+		gSkeletonBatcher.SetSharedUniforms(projViewMat, lightPos, lightColor);
 
-		// Threading
-		if (gEnableThreading)
+		// Optimize the walk clip offline and save it next to the other outputs of the sample, the rigs keep playing the source clip
+		if (gOptimizeWalkClip)
 		{
-			WorkItem pWorkGroups[kMaxTaskCount];
+			gOptimizeWalkClip = false;
 
-			unsigned int taskCount = gNumRigs / gGrainSize;
+			ClipOptimizerDesc clipOptimizerDesc;
+			clipOptimizerDesc.mTranslationTolerance = gClipOptimizerToleranceMm / 1000.0f;
+			clipOptimizerDesc.mHierarchicalTolerance = gClipOptimizerToleranceMm / 1000.0f;
 
-			// Submit taskCount number of jobs
-			for (unsigned int i = 0; i < taskCount; i++)
+			const tinystl::string sourcePath = FileSystem::FixPath(gWalkClipName, FSR_Animation);
+			const tinystl::string destinationPath = FileSystem::FixPath(gOptimizedWalkClipName, FSR_OtherFiles);
+			HiresTimer optimizeTimer;
+			if (ClipOptimizer::OptimizeClip(&gStickFigureRigs[0], sourcePath.c_str(), destinationPath.c_str(), clipOptimizerDesc, &gWalkClipOptimizerStats))
 			{
-				gThreadData[i].mAnimatedObject = &gStickFigureAnimObjects[gGrainSize * i];
-				gThreadData[i].mDeltaTime = deltaTime;
-				gThreadData[i].mNumberSystems = gGrainSize;
-
-				pWorkGroups[i].pData = &gThreadData[i];
-				pWorkGroups[i].pFunc = AnimatedObjectThreadedUpdate;
-				gThreadSystem.AddWorkItem(&pWorkGroups[i]);
+				gWalkClipOptimizeMs = optimizeTimer.GetUSec(false) / 1000.0f;
+				LOGINFOF("Optimized %s into %s, %u -> %u keys, max error %.2f mm", gWalkClipName, destinationPath.c_str(),
+					gWalkClipOptimizerStats.mNumSampledKeys, gWalkClipOptimizerStats.mNumOptimizedKeys, gWalkClipOptimizerStats.mMaxJointError * 1000.0f);
 			}
-
-			// If there is a remainder, submit another job to finish it
-			unsigned int remainder = gNumRigs - (taskCount * gGrainSize);
-			if (remainder != 0)
+			else
 			{
-				gThreadData[taskCount].mAnimatedObject = &gStickFigureAnimObjects[gGrainSize * taskCount];
-				gThreadData[taskCount].mDeltaTime = deltaTime;
-				gThreadData[taskCount].mNumberSystems = remainder;
-
-				pWorkGroups[taskCount].pData = &gThreadData[taskCount];
-				pWorkGroups[taskCount].pFunc = AnimatedObjectThreadedUpdate;
-				gThreadSystem.AddWorkItem(&pWorkGroups[taskCount]);
+				LOGERRORF("Could not optimize %s into %s", gWalkClipName, destinationPath.c_str());
 			}
-
-			// Ensure all jobs are finished before proceeding
-			gThreadSystem.Complete(0);
 		}
-		// Naive
-		else
+
+		// Save the baked walk clip so it can be loaded without the clip and the rigs
+		if (gExportWalkVAT)
 		{
-			for (unsigned int i = 0; i < gNumRigs; i++)
-			{
-				if (!gStickFigureAnimObjects[i].Update(deltaTime))
-					ErrorMsg("Animation NOT Updating!");
+			gExportWalkVAT = false;
 
-				gStickFigureAnimObjects[i].PoseRig();
-			}
+			if (gWalkVAT.Save(gWalkVATName, FSR_OtherFiles))
+				LOGINFOF("Saved %s", FileSystem::FixPath(gWalkVATName, FSR_OtherFiles).c_str());
+			else
+				LOGERRORF("Could not save %s", FileSystem::FixPath(gWalkVATName, FSR_OtherFiles).c_str());
 		}
 
-		// Record animation update time
-		gAnimationUpdateTimer.GetUSec(true);
-
-		// Update uniforms that will be shared between all skeletons
-		gSkeletonBatcher.SetSharedUniforms(projViewMat, lightPos, lightColor);
+		// The crowd played back from the vertex animation texture only advances its time on the CPU
+		if (gEnableVAT)
+			gVATTime = fmodf(gVATTime + deltaTime, gWalkVAT.GetDuration());
+
+		gUniformDataVAT.mProjectView = projViewMat;
+		gUniformDataVAT.mJointColor[0] = gStickFigureRigs[0].GetJointColor();
+		gUniformDataVAT.mJointColor[1] = gStickFigureRigs[1].GetJointColor();
+		gUniformDataVAT.mBoneColor[0] = gStickFigureRigs[0].GetBoneColor();
+		gUniformDataVAT.mBoneColor[1] = gStickFigureRigs[1].GetBoneColor();
+		gUniformDataVAT.mLightPosition = vec4(lightPos, 1.0f);
+		gUniformDataVAT.mLightColor = vec4(lightColor, 1.0f);
+		gUniformDataVAT.mTime = vec4(gVATTime, gWalkVAT.GetDuration(), (float)(gWalkVAT.GetNumFrames() - 1), 0.0f);
+		gUniformDataVAT.mLayout[0] = gStickFigureRigs[0].GetNumJoints();
+		gUniformDataVAT.mLayout[1] = gWalkVAT.GetWidth();
+		gUniformDataVAT.mLayout[2] = gWalkVAT.GetRowsPerFrame();
+		gUniformDataVAT.mLayout[3] = 0;
 
 		/************************************************************************/
 		// Plane
@@ -814,15 +1056,6 @@ public:
 
 		acquireNextImage(pRenderer, pSwapChain, pImageAcquiredSemaphore, NULL, &gFrameIndex);
 
-		// UPDATE UNIFORM BUFFERS
-		//
-
-		// Update all the instanced uniform data for each batch of joints and bones
-		gSkeletonBatcher.SetPerInstanceUniforms(gFrameIndex, gNumRigs);
-
-		BufferUpdateDesc planeViewProjCbv = { pPlaneUniformBuffer[gFrameIndex], &gUniformDataPlane };
-		updateResource(&planeViewProjCbv);
-
 		// FRAME SYNC & ACQUIRE SWAPCHAIN RENDER TARGET
 		//
 		// Stall if CPU is running "Swap Chain Buffer Count" frames ahead of GPU
@@ -832,6 +1065,41 @@ public:
 		if (fenceStatus == FENCE_STATUS_INCOMPLETE)
 			waitForFences(pGraphicsQueue, 1, &pNextFence, false);
 
+		// ANIMATION
+		//
+		gAnimationUpdateTimer.Reset();
+
+		// The GPU playback of the vertex animation texture needs no CPU animation work
+		if (!gEnableVAT)
+		{
+			// Apply the error bound from the UI and start a new frame so the shared poses get sampled again
+			if (gWalkAnimationInstancer.GetMaxTimeError() != gMaxTimeErrorMs / 1000.0f)
+				gWalkAnimationInstancer.SetMaxTimeError(gMaxTimeErrorMs / 1000.0f);
+			gWalkAnimationInstancer.BeginFrame();
+
+			// Update the animated objects, pose the rigs and write the instanced uniform data for each batch of joints and bones.
+			// The scheduler decides which objects are sampled, the others are extrapolated
+			*gAnimationScheduler.GetBudgetMsPtr() = gAnimationBudgetMs;
+			*gAnimationSystem.GetGrainSizeOverridePtr() = gGrainSize;
+			gAnimationSystem.SetNumActiveObjects(gNumRigs);
+			if (!gAnimationSystem.Update(gAnimationDeltaTime, pCameraController->getViewPosition(), gUniformDataPlane.mProjectView, gFrameIndex, gEnableThreading ? &gThreadSystem : NULL))
+				ErrorMsg("Animation NOT Updating!");
+		}
+
+		// Record animation update time
+		gAnimationUpdateTimer.GetUSec(true);
+
+		// UPDATE UNIFORM BUFFERS
+		//
+		BufferUpdateDesc planeViewProjCbv = { pPlaneUniformBuffer[gFrameIndex], &gUniformDataPlane };
+		updateResource(&planeViewProjCbv);
+
+		if (gEnableVAT)
+		{
+			BufferUpdateDesc vatCbv = { pVATUniformBuffer[gFrameIndex], &gUniformDataVAT };
+			updateResource(&vatCbv);
+		}
+
 		// Acquire the main render target from the swapchain
 		RenderTarget* pRenderTarget = pSwapChain->ppSwapchainRenderTargets[gFrameIndex];
 		Semaphore* pRenderCompleteSemaphore = pRenderCompleteSemaphores[gFrameIndex];
@@ -876,7 +1144,38 @@ public:
 
 		//// draw the skeleton of the rigs
 		cmdBeginDebugMarker(cmd, 1, 0, 1, "Draw Skeletons");
-		gSkeletonBatcher.Draw(cmd, gFrameIndex);
+		if (gEnableVAT)
+		{
+			// One instance per joint then per bone of every rig, the shader finds the rig, its time and the frames to interpolate
+			const unsigned int numJoints = gStickFigureRigs[0].GetNumJoints();
+			uint32_t elementOffset = 0;
+
+			cmdBindPipeline(cmd, pVATPipeline);
+
+			DescriptorData params[4] = {};
+			params[0].pName = "uniformBlock";
+			params[0].ppBuffers = &pVATUniformBuffer[gFrameIndex];
+			params[1].pName = "vatTexture";
+			params[1].ppTextures = &pVATTexture;
+			params[2].pName = "vatInstances";
+			params[2].ppBuffers = &pVATInstanceBuffer;
+			params[3].pName = "VATRootConstants";
+			params[3].pRootConstant = &elementOffset;
+			cmdBindDescriptors(cmd, pRootSignature, 4, params);
+			cmdBindVertexBuffer(cmd, 1, &pJointVertexBuffer, NULL);
+			cmdDrawInstanced(cmd, gNumberOfJointPoints / 6, 0, gNumRigs * numJoints, 0);
+
+			elementOffset = numJoints;
+			params[0].pName = "VATRootConstants";
+			params[0].pRootConstant = &elementOffset;
+			cmdBindDescriptors(cmd, pRootSignature, 1, params);
+			cmdBindVertexBuffer(cmd, 1, &pBoneVertexBuffer, NULL);
+			cmdDrawInstanced(cmd, gNumberOfBonePoints / 6, 0, gNumRigs * numJoints, 0);
+		}
+		else
+		{
+			gSkeletonBatcher.Draw(cmd, gFrameIndex);
+		}
 		cmdEndDebugMarker(cmd);
 
 		//// draw the UI
@@ -889,6 +1188,20 @@ public:
 		gAppUI.Gui(pStandaloneControlsGUIWindow); // adds the gui element to AppUI::ComponentsToUpdate list
 		drawDebugText(cmd, 8, 15, tinystl::string::format("CPU %f ms", gTimer.GetUSecAverage() / 1000.0f), &gFrameTimeDraw);
 		drawDebugText(cmd, 8, 65, tinystl::string::format("Animation Update %f ms", gAnimationUpdateTimer.GetUSecAverage() / 1000.0f), &gFrameTimeDraw);
+		drawDebugText(cmd, 8, 90, tinystl::string::format("Clip Samples %u", gWalkAnimationInstancer.IsEnabled() ? gWalkAnimationInstancer.GetNumSamples() : gAnimationScheduler.GetNumUpdated()), &gFrameTimeDraw);
+		drawDebugText(cmd, 8, 115, tinystl::string::format("Animation Updates %u, Deferred %u", gAnimationScheduler.GetNumUpdated(), gAnimationScheduler.GetNumDeferred()), &gFrameTimeDraw);
+		drawDebugText(cmd, 8, 140, tinystl::string::format("Sample %.2f ms, Local To Model %.2f ms, Extrapolate %.2f ms, Pose %.2f ms, Write %.2f ms, Grain Size %u",
+			gAnimationSystem.GetStageMs(ANIMATION_STAGE_SAMPLE), gAnimationSystem.GetStageMs(ANIMATION_STAGE_LOCAL_TO_MODEL), gAnimationSystem.GetStageMs(ANIMATION_STAGE_EXTRAPOLATE),
+			gAnimationSystem.GetStageMs(ANIMATION_STAGE_POSE), gAnimationSystem.GetStageMs(ANIMATION_STAGE_WRITE_INSTANCES), gAnimationSystem.GetGrainSize()), &gFrameTimeDraw);
+		drawDebugText(cmd, 8, 165, tinystl::string::format("Walk Clip %.1f KB, Loaded in %.2f ms", gWalkClip.GetMemorySize() / 1024.0f, gWalkClip.GetLoadMs()), &gFrameTimeDraw);
+		drawDebugText(cmd, 8, 190, tinystl::string::format("Walk VAT %.1f KB, Max Error %.2f mm, Baked in %.2f ms, Live Update of %u Rigs %.2f ms",
+			gWalkVATStats.mTextureSize / 1024.0f, gWalkVATStats.mMaxError * 1000.0f, gWalkVATStats.mBakeMs, gNumRigs, gWalkVATStats.mLiveUpdateUs * gNumRigs / 1000.0f), &gFrameTimeDraw);
+		if (gWalkClipOptimizeMs > 0.0f)
+		{
+			drawDebugText(cmd, 8, 215, tinystl::string::format("Optimized Walk Clip %.1f KB -> %.1f KB, Keys %u -> %u, Max Error %.2f mm, Optimized in %.2f ms",
+				gWalkClipOptimizerStats.mSourceSize / 1024.0f, gWalkClipOptimizerStats.mOptimizedSize / 1024.0f, gWalkClipOptimizerStats.mNumSampledKeys,
+				gWalkClipOptimizerStats.mNumOptimizedKeys, gWalkClipOptimizerStats.mMaxJointError * 1000.0f, gWalkClipOptimizeMs), &gFrameTimeDraw);
+		}
 #ifndef METAL // Metal doesn't support GPU profilers
 		drawDebugText(cmd, 8, 40, tinystl::string::format("GPU %f ms", (float)pGpuProfiler->mCumulativeTime * 1000.0f), &gFrameTimeDraw);
 #endif
@@ -968,25 +1281,6 @@ public:
 		pCameraController->onInputEvent(data);
 		return true;
 	}
-
-	// Threaded animated object update call
-	static void AnimatedObjectThreadedUpdate(void* pData)
-	{
-		// Unpack data
-		ThreadData* data = (ThreadData*)pData;
-		AnimatedObject* animSystem = data->mAnimatedObject;
-		float deltaTime = data->mDeltaTime;
-		unsigned int numberSystems = data->mNumberSystems;
-
-		// Update the systems
-		for (unsigned int i = 0; i < numberSystems; i++)
-		{
-			if (!(animSystem[i].Update(deltaTime)))
-				ErrorMsg("Animation NOT Updating!");
-
-			animSystem[i].PoseRig();
-		}
-	}
 };
 
 DEFINE_APPLICATION_MAIN(MultiThread)
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <metal_stdlib>
+using namespace metal;
+
+// Plays back the skeletons of a crowd from a vertex animation texture baked with VAT_TYPE_SKELETON:
+// each frame holds the first 3 rows of the instance matrix of every joint, then of every bone.
+// Must match the layout of VertexAnimationTexture in Middleware_3/Animation
+
+struct Uniforms_uniformBlock
+{
+	float4x4 mvp;
+
+	// Colors of the even and odd rigs
+	float4 jointColor[2];
+	float4 boneColor[2];
+
+	// Point Light Information
+	float4 lightPosition;
+	float4 lightColor;
+
+	// x: time of the crowd, y: duration of the clip, z: number of frames - 1
+	float4 vatTime;
+
+	// x: number of joints, y: width of the texture, z: rows per frame
+	uint4 vatLayout;
+};
+
+struct VATConstants
+{
+	// Element of the first instance: 0 for the joints, the number of joints for the bones
+	uint elementOffset;
+};
+
+struct VSInput
+{
+	float4 Position [[attribute(0)]];
+	float4 Normal [[attribute(1)]];
+};
+
+struct VSOutput
+{
+	float4 Position [[position]];
+	float4 Color;
+};
+
+// Row of the matrix of element at frame, the first row of the texture is the header
+float4 LoadRow(texture2d<float, access::read> vatTexture, constant Uniforms_uniformBlock& uniformBlock, uint frame, uint element, uint row)
+{
+	uint frameTexel = element * 3 + row;
+	return vatTexture.read(uint2(frameTexel % uniformBlock.vatLayout.y, 1 + frame * uniformBlock.vatLayout.z + frameTexel / uniformBlock.vatLayout.y));
+}
+
+vertex VSOutput stageMain(VSInput input                                      [[stage_in]],
+                          uint InstanceID                                    [[instance_id]],
+                          constant Uniforms_uniformBlock& uniformBlock       [[buffer(1)]],
+                          constant VATConstants& VATRootConstants            [[buffer(2)]],
+                          constant float4* vatInstances                      [[buffer(3)]],
+                          texture2d<float, access::read> vatTexture          [[texture(0)]])
+{
+	VSOutput result;
+
+	uint rig = InstanceID / uniformBlock.vatLayout.x;
+	uint element = VATRootConstants.elementOffset + InstanceID % uniformBlock.vatLayout.x;
+	float4 instance = vatInstances[rig];
+
+	// Interpolate between the frames around the time of the rig, the last frame holds the end of the clip
+	float frame = fract((uniformBlock.vatTime.x + instance.w) / uniformBlock.vatTime.y) * uniformBlock.vatTime.z;
+	uint frame0 = uint(frame);
+	uint frame1 = min(frame0 + 1, uint(uniformBlock.vatTime.z));
+	float weight = frame - float(frame0);
+
+	float4 row0 = mix(LoadRow(vatTexture, uniformBlock, frame0, element, 0), LoadRow(vatTexture, uniformBlock, frame1, element, 0), weight);
+	float4 row1 = mix(LoadRow(vatTexture, uniformBlock, frame0, element, 1), LoadRow(vatTexture, uniformBlock, frame1, element, 1), weight);
+	float4 row2 = mix(LoadRow(vatTexture, uniformBlock, frame0, element, 2), LoadRow(vatTexture, uniformBlock, frame1, element, 2), weight);
+
+	float4 position = float4(input.Position.xyz, 1.0);
+	float4 pos = float4(dot(row0, position), dot(row1, position), dot(row2, position), 1.0) + float4(instance.xyz, 0.0);
+	result.Position = uniformBlock.mvp * pos;
+
+	float4 normal = float4(input.Normal.xyz, 0.0);
+	normal = normalize(float4(dot(row0, normal), dot(row1, normal), dot(row2, normal), 0.0)); // Assume uniform scaling
+
+	float lightIntensity = 1.0;
+	float ambientCoeff = 0.4;
+
+	float3 lightDir = normalize(uniformBlock.lightPosition.xyz - pos.xyz);
+
+	float3 baseColor = element < uniformBlock.vatLayout.x ? uniformBlock.jointColor[rig % 2].xyz : uniformBlock.boneColor[rig % 2].xyz;
+	float3 blendedColor = uniformBlock.lightColor.xyz * baseColor * lightIntensity;
+	float3 diffuse = blendedColor * max(dot(normal.xyz, lightDir), 0.0);
+	float3 ambient = baseColor * ambientCoeff;
+	result.Color = float4(diffuse + ambient, 1.0);
+
+	return result;
+}
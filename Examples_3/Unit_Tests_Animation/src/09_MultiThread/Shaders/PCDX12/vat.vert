@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Plays back the skeletons of a crowd from a vertex animation texture baked with VAT_TYPE_SKELETON:
+// each frame holds the first 3 rows of the instance matrix of every joint, then of every bone.
+// Must match the layout of VertexAnimationTexture in Middleware_3/Animation
+
+cbuffer uniformBlock : register(b0)
+{
+    float4x4 mvp;
+
+    // Colors of the even and odd rigs
+    float4 jointColor[2];
+    float4 boneColor[2];
+
+    // Point Light Information
+    float4 lightPosition;
+    float4 lightColor;
+
+    // x: time of the crowd, y: duration of the clip, z: number of frames - 1
+    float4 vatTime;
+
+    // x: number of joints, y: width of the texture, z: rows per frame
+    uint4 vatLayout;
+};
+
+struct VATConstants
+{
+    // Element of the first instance: 0 for the joints, the number of joints for the bones
+    uint elementOffset;
+};
+
+ConstantBuffer<VATConstants> VATRootConstants : register(b1);
+
+Texture2D<float4> vatTexture : register(t0);
+
+// xyz: root position of each rig, w: time offset
+StructuredBuffer<float4> vatInstances : register(t1);
+
+struct VSInput
+{
+    float4 Position : POSITION;
+    float4 Normal : NORMAL;
+};
+
+struct VSOutput {
+	float4 Position : SV_POSITION;
+    float4 Color : COLOR;
+};
+
+// Row of the matrix of element at frame, the first row of the texture is the header
+float4 LoadRow(uint frame, uint element, uint row)
+{
+    uint frameTexel = element * 3 + row;
+    return vatTexture.Load(int3(frameTexel % vatLayout.y, 1 + frame * vatLayout.z + frameTexel / vatLayout.y, 0));
+}
+
+VSOutput main(VSInput input, uint InstanceID : SV_InstanceID)
+{
+    VSOutput result;
+
+    uint rig = InstanceID / vatLayout.x;
+    uint element = VATRootConstants.elementOffset + InstanceID % vatLayout.x;
+    float4 instance = vatInstances[rig];
+
+    // Interpolate between the frames around the time of the rig, the last frame holds the end of the clip
+    float frame = frac((vatTime.x + instance.w) / vatTime.y) * vatTime.z;
+    uint frame0 = (uint)frame;
+    uint frame1 = min(frame0 + 1, (uint)vatTime.z);
+    float weight = frame - frame0;
+
+    float4 row0 = lerp(LoadRow(frame0, element, 0), LoadRow(frame1, element, 0), weight);
+    float4 row1 = lerp(LoadRow(frame0, element, 1), LoadRow(frame1, element, 1), weight);
+    float4 row2 = lerp(LoadRow(frame0, element, 2), LoadRow(frame1, element, 2), weight);
+
+    float4 position = float4(input.Position.xyz, 1.0f);
+    float4 pos = float4(dot(row0, position), dot(row1, position), dot(row2, position), 1.0f) + float4(instance.xyz, 0.0f);
+    result.Position = mul(mvp, pos);
+
+    float4 normal = float4(input.Normal.xyz, 0.0f);
+    normal = normalize(float4(dot(row0, normal), dot(row1, normal), dot(row2, normal), 0.0f)); // Assume uniform scaling
+
+    float lightIntensity = 1.0f;
+    float ambientCoeff = 0.4;
+
+    float3 lightDir = normalize(lightPosition.xyz - pos.xyz);
+
+    float3 baseColor = element < vatLayout.x ? jointColor[rig % 2].xyz : boneColor[rig % 2].xyz;
+    float3 blendedColor = lightColor.xyz * baseColor * lightIntensity;
+    float3 diffuse = blendedColor * max(dot(normal.xyz, lightDir), 0.0);
+    float3 ambient = baseColor * ambientCoeff;
+    result.Color = float4(diffuse + ambient, 1.0);
+
+    return result;
+}
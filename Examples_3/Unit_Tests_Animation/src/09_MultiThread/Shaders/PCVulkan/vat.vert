@@ -0,0 +1,109 @@
+#version 450 core
+
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Plays back the skeletons of a crowd from a vertex animation texture baked with VAT_TYPE_SKELETON:
+// each frame holds the first 3 rows of the instance matrix of every joint, then of every bone.
+// Must match the layout of VertexAnimationTexture in Middleware_3/Animation
+
+layout(location = 0) in vec4 Position;
+layout(location = 1) in vec4 Normal;
+
+layout(location = 0) out vec4 Color;
+
+layout (std140, set=0, binding=0) uniform uniformBlock {
+	uniform mat4 mvp;
+
+    // Colors of the even and odd rigs
+    uniform vec4 jointColor[2];
+    uniform vec4 boneColor[2];
+
+    // Point Light Information
+    uniform vec4 lightPosition;
+    uniform vec4 lightColor;
+
+    // x: time of the crowd, y: duration of the clip, z: number of frames - 1
+    uniform vec4 vatTime;
+
+    // x: number of joints, y: width of the texture, z: rows per frame
+    uniform uvec4 vatLayout;
+};
+
+layout(push_constant, std430) uniform VATConstants
+{
+    // Element of the first instance: 0 for the joints, the number of joints for the bones
+    uint elementOffset;
+} VATRootConstants;
+
+layout(set=0, binding=1) uniform texture2D vatTexture;
+layout(set=0, binding=2) uniform sampler vatSampler;
+
+// xyz: root position of each rig, w: time offset
+layout (std430, set=0, binding=3) readonly buffer vatInstances
+{
+	vec4 vatInstancesBuffer[];
+};
+
+// Row of the matrix of element at frame, the first row of the texture is the header
+vec4 LoadRow(uint frame, uint element, uint row)
+{
+	uint frameTexel = element * 3 + row;
+	return texelFetch(sampler2D(vatTexture, vatSampler), ivec2(frameTexel % vatLayout.y, 1 + frame * vatLayout.z + frameTexel / vatLayout.y), 0);
+}
+
+void main ()
+{
+	uint rig = gl_InstanceIndex / vatLayout.x;
+	uint element = VATRootConstants.elementOffset + gl_InstanceIndex % vatLayout.x;
+	vec4 instance = vatInstancesBuffer[rig];
+
+	// Interpolate between the frames around the time of the rig, the last frame holds the end of the clip
+	float frame = fract((vatTime.x + instance.w) / vatTime.y) * vatTime.z;
+	uint frame0 = uint(frame);
+	uint frame1 = min(frame0 + 1, uint(vatTime.z));
+	float weight = frame - float(frame0);
+
+	vec4 row0 = mix(LoadRow(frame0, element, 0), LoadRow(frame1, element, 0), weight);
+	vec4 row1 = mix(LoadRow(frame0, element, 1), LoadRow(frame1, element, 1), weight);
+	vec4 row2 = mix(LoadRow(frame0, element, 2), LoadRow(frame1, element, 2), weight);
+
+	vec4 position = vec4(Position.xyz, 1.0f);
+	vec4 pos = vec4(dot(row0, position), dot(row1, position), dot(row2, position), 1.0f) + vec4(instance.xyz, 0.0f);
+	gl_Position = mvp * pos;
+
+	vec4 normal = vec4(Normal.xyz, 0.0f);
+	normal = normalize(vec4(dot(row0, normal), dot(row1, normal), dot(row2, normal), 0.0f)); // Assume uniform scaling
+
+	float lightIntensity = 1.0f;
+    float ambientCoeff = 0.4;
+
+	vec3 lightDir = normalize(lightPosition.xyz - pos.xyz);
+
+    vec3 baseColor = element < vatLayout.x ? jointColor[rig % 2].xyz : boneColor[rig % 2].xyz;
+    vec3 blendedColor = lightColor.xyz * baseColor * lightIntensity;
+    vec3 diffuse = blendedColor * max(dot(normal.xyz, lightDir), 0.0);
+    vec3 ambient = baseColor * ambientCoeff;
+    Color = vec4(diffuse + ambient, 1.0);
+}
@@ -31,7 +31,17 @@
 #include "../../../Common_3/ThirdParty/OpenSource/assimp/4.1.0/include/assimp/postprocess.h"
 #include "../../../Common_3/OS/Interfaces/IFileSystem.h"
 #include "../../../Common_3/OS/Interfaces/ILogManager.h"
+#include "../../../Common_3/OS/Interfaces/ITimeManager.h"
 #include "../../../Common_3/OS/Core/Compiler.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CLUSTER_CULL_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CLUSTER_CULL_NEON
+#endif
+
 #include "../../../Common_3/OS/Interfaces/IMemoryManager.h"
 
 static void SetAlphaTestMaterials(tinystl::unordered_set<tinystl::string>& mats)
@@ -158,7 +168,6 @@ static void SetTwoSidedMaterials(tinystl::unordered_set<tinystl::string>& mats)
 	mats.insert("Tela_Mesa_D");
 }
 
-#if !defined(METAL)
 static inline float2 abs(const float2& v)
 {
 	return float2(fabsf(v.getX()), fabsf(v.getY()));
@@ -275,17 +284,595 @@ static inline uint encodeDir(const float3& n)
 
 	return packUnorm2x16(float2(enc.getX(), enc.getY()));
 }
+
+/************************************************************************/
+// Cluster builder
+/************************************************************************/
+vec3 makeVec3(const SceneVertexPos& v);
+
+typedef struct ClusterBuildStats
+{
+	uint32_t clusterCount;
+	uint32_t validCount;
+	double coneCosineSum;
+} ClusterBuildStats;
+
+typedef struct WeldVertex
+{
+	float x, y, z;
+	uint32_t corner;
+} WeldVertex;
+
+static inline uint32_t getMeshTriangleCount(const Mesh* mesh)
+{
+#if defined(METAL)
+	return mesh->triangleCount;
+#else
+	return mesh->indexCount / 3;
 #endif
+}
 
-// Loads a scene using ASSIMP and returns a Scene object with scene information
-Scene* loadScene(const char* fileName)
+static inline const SceneVertexPos& getCornerPosition(const Scene* pScene, const Mesh* mesh, uint32_t corner)
 {
-#if TARGET_IOS
-	NSString *fileUrl = [[NSBundle mainBundle] pathForResource:[NSString stringWithUTF8String : fileName] ofType : @""];
-	fileName = [fileUrl fileSystemRepresentation];
+#if defined(METAL)
+	return pScene->positions[mesh->startVertex + corner];
+#else
+	return pScene->positions[pScene->indices[mesh->startIndex + corner]];
 #endif
+}
 
-	Scene* scene = (Scene*)conf_calloc(1, sizeof(Scene));
+static int compareWeldVertex(const void* lhs, const void* rhs)
+{
+	const WeldVertex* a = (const WeldVertex*)lhs;
+	const WeldVertex* b = (const WeldVertex*)rhs;
+	if (a->x != b->x)
+		return a->x < b->x ? -1 : 1;
+	if (a->y != b->y)
+		return a->y < b->y ? -1 : 1;
+	if (a->z != b->z)
+		return a->z < b->z ? -1 : 1;
+	return 0;
+}
+
+// Greedily grows every cluster over shared vertices, preferring triangles that reuse the vertices already in the cluster,
+// share an edge with the previous triangle (vertex cache) and face the same way as the cluster (tight normal cone).
+// Only the last cluster of the mesh has less than CLUSTER_SIZE triangles, so the clusters stay contiguous ranges
+// of the reordered triangles. Writes the new order to pTriangleOrder (new position -> old triangle)
+static void buildMeshTriangleOrder(const Scene* pScene, const Mesh* mesh, bool twoSided, uint32_t* pTriangleOrder)
+{
+	const uint32_t triangleCount = getMeshTriangleCount(mesh);
+	const uint32_t cornerCount = triangleCount * 3;
+	const uint32_t invalid = ~0u;
+	if (!triangleCount)
+		return;
+
+	// Weld corners by position so adjacency also crosses uv and normal seams
+	WeldVertex* pWeld = (WeldVertex*)conf_malloc(cornerCount * sizeof(WeldVertex));
+	for (uint32_t c = 0; c < cornerCount; ++c)
+	{
+		const SceneVertexPos& pos = getCornerPosition(pScene, mesh, c);
+		pWeld[c] = { pos.x, pos.y, pos.z, c };
+	}
+	qsort(pWeld, cornerCount, sizeof(WeldVertex), compareWeldVertex);
+
+	uint32_t* pCornerVertex = (uint32_t*)conf_malloc(cornerCount * sizeof(uint32_t));
+	uint32_t vertexCount = 0;
+	for (uint32_t i = 0; i < cornerCount; ++i)
+	{
+		if (i > 0 && compareWeldVertex(&pWeld[i - 1], &pWeld[i]) != 0)
+			++vertexCount;
+		pCornerVertex[pWeld[i].corner] = vertexCount;
+	}
+	++vertexCount;
+	conf_free(pWeld);
+
+	// Triangles using each vertex
+	uint32_t* pVertexTriangleOffsets = (uint32_t*)conf_calloc(vertexCount + 1, sizeof(uint32_t));
+	uint32_t* pVertexTriangleCursor = (uint32_t*)conf_malloc(vertexCount * sizeof(uint32_t));
+	uint32_t* pVertexTriangles = (uint32_t*)conf_malloc(cornerCount * sizeof(uint32_t));
+	for (uint32_t c = 0; c < cornerCount; ++c)
+		++pVertexTriangleOffsets[pCornerVertex[c] + 1];
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		pVertexTriangleOffsets[v + 1] += pVertexTriangleOffsets[v];
+		pVertexTriangleCursor[v] = pVertexTriangleOffsets[v];
+	}
+	for (uint32_t c = 0; c < cornerCount; ++c)
+		pVertexTriangles[pVertexTriangleCursor[pCornerVertex[c]]++] = c / 3;
+	conf_free(pVertexTriangleCursor);
+
+	vec3* pNormals = (vec3*)conf_malloc(triangleCount * sizeof(vec3));
+	vec3* pCentroids = (vec3*)conf_malloc(triangleCount * sizeof(vec3));
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		const vec3 v0 = makeVec3(getCornerPosition(pScene, mesh, t * 3));
+		const vec3 v1 = makeVec3(getCornerPosition(pScene, mesh, t * 3 + 1));
+		const vec3 v2 = makeVec3(getCornerPosition(pScene, mesh, t * 3 + 2));
+		vec3 normal = cross(v1 - v0, v2 - v0);
+		if (!(normal == vec3(0, 0, 0)))
+			normal = normalize(normal);
+		pNormals[t] = normal;
+		pCentroids[t] = (v0 + v1 + v2) / 3.0f;
+	}
+
+	uint32_t* pTriangleCluster = (uint32_t*)conf_malloc(triangleCount * sizeof(uint32_t));
+	uint32_t* pCandidateStamp = (uint32_t*)conf_malloc(triangleCount * sizeof(uint32_t));
+	uint32_t* pVertexCluster = (uint32_t*)conf_malloc(vertexCount * sizeof(uint32_t));
+	memset(pTriangleCluster, 0xff, triangleCount * sizeof(uint32_t));
+	memset(pCandidateStamp, 0xff, triangleCount * sizeof(uint32_t));
+	memset(pVertexCluster, 0xff, vertexCount * sizeof(uint32_t));
+
+	tinystl::vector<uint32_t> candidates;
+	uint32_t written = 0;
+	uint32_t seedCursor = 0;
+	for (uint32_t clusterIndex = 0; written < triangleCount; ++clusterIndex)
+	{
+		vec3 axis(0.0f, 0.0f, 0.0f);
+		vec3 centroidSum(0.0f, 0.0f, 0.0f);
+		uint32_t clusterTriangles = 0;
+		uint32_t lastTriangle = invalid;
+		candidates.clear();
+
+		while (clusterTriangles < CLUSTER_SIZE && written < triangleCount)
+		{
+			uint32_t best = invalid;
+			if (candidates.empty())
+			{
+				// The patch ran out of neighbours. Continue with the unassigned triangle closest to the cluster
+				// among the next few in index order, which is usually spatially coherent as well
+				while (pTriangleCluster[seedCursor] != invalid)
+					++seedCursor;
+				best = seedCursor;
+
+				if (clusterTriangles)
+				{
+					const vec3 centroid = centroidSum / (float)clusterTriangles;
+					float bestDistance = lengthSqr(pCentroids[best] - centroid);
+					for (uint32_t t = seedCursor + 1, scanned = 0; t < triangleCount && scanned < 64; ++t)
+					{
+						if (pTriangleCluster[t] != invalid)
+							continue;
+						++scanned;
+						const float distance = lengthSqr(pCentroids[t] - centroid);
+						if (distance < bestDistance)
+						{
+							bestDistance = distance;
+							best = t;
+						}
+					}
+				}
+			}
+			else
+			{
+				const float axisLength = length(axis);
+				const vec3 axisDir = axisLength > 0.0f ? axis / axisLength : axis;
+
+				float bestScore = -INFINITY;
+				uint32_t bestCandidate = 0;
+				for (uint32_t i = 0; i < (uint32_t)candidates.size(); ++i)
+				{
+					const uint32_t t = candidates[i];
+					float score = 0.0f;
+					for (uint32_t k = 0; k < 3; ++k)
+					{
+						const uint32_t v = pCornerVertex[t * 3 + k];
+						if (pVertexCluster[v] == clusterIndex)
+							score += 1.0f;
+						if (lastTriangle != invalid &&
+							(v == pCornerVertex[lastTriangle * 3] || v == pCornerVertex[lastTriangle * 3 + 1] || v == pCornerVertex[lastTriangle * 3 + 2]))
+							score += 0.5f;
+					}
+					// Two sided clusters are never cone culled
+					if (!twoSided)
+						score += dot(pNormals[t], axisDir);
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestCandidate = i;
+					}
+				}
+
+				best = candidates[bestCandidate];
+				candidates[bestCandidate] = candidates.back();
+				candidates.pop_back();
+			}
+
+			pTriangleCluster[best] = clusterIndex;
+			pTriangleOrder[written++] = best;
+			++clusterTriangles;
+			axis += pNormals[best];
+			centroidSum += pCentroids[best];
+			lastTriangle = best;
+
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				const uint32_t v = pCornerVertex[best * 3 + k];
+				pVertexCluster[v] = clusterIndex;
+				for (uint32_t i = pVertexTriangleOffsets[v]; i < pVertexTriangleOffsets[v + 1]; ++i)
+				{
+					const uint32_t t = pVertexTriangles[i];
+					if (pTriangleCluster[t] == invalid && pCandidateStamp[t] != clusterIndex)
+					{
+						pCandidateStamp[t] = clusterIndex;
+						candidates.push_back(t);
+					}
+				}
+			}
+		}
+	}
+
+	conf_free(pVertexCluster);
+	conf_free(pCandidateStamp);
+	conf_free(pTriangleCluster);
+	conf_free(pCentroids);
+	conf_free(pNormals);
+	conf_free(pVertexTriangles);
+	conf_free(pVertexTriangleOffsets);
+	conf_free(pCornerVertex);
+}
+
+template <typename T>
+static void reorderTriangles(T* pData, uint32_t triangleCount, const uint32_t* pTriangleOrder)
+{
+	T* pCopy = (T*)conf_malloc(triangleCount * 3 * sizeof(T));
+	memcpy(pCopy, pData, triangleCount * 3 * sizeof(T));
+	for (uint32_t i = 0; i < triangleCount; ++i)
+	{
+		for (uint32_t k = 0; k < 3; ++k)
+			pData[i * 3 + k] = pCopy[pTriangleOrder[i] * 3 + k];
+	}
+	conf_free(pCopy);
+}
+
+static void applyMeshTriangleOrder(Scene* pScene, const Mesh* mesh, const uint32_t* pTriangleOrder)
+{
+	const uint32_t triangleCount = getMeshTriangleCount(mesh);
+#if defined(METAL)
+	reorderTriangles(pScene->positions + mesh->startVertex, triangleCount, pTriangleOrder);
+	reorderTriangles(pScene->texCoords + mesh->startVertex, triangleCount, pTriangleOrder);
+	reorderTriangles(pScene->normals + mesh->startVertex, triangleCount, pTriangleOrder);
+	reorderTriangles(pScene->tangents + mesh->startVertex, triangleCount, pTriangleOrder);
+#else
+	reorderTriangles(pScene->indices + mesh->startIndex, triangleCount, pTriangleOrder);
+#endif
+}
+
+static void accumulateClusterStats(const Mesh* mesh, ClusterBuildStats* pStats)
+{
+	pStats->clusterCount += mesh->clusterCount;
+	for (uint32_t i = 0; i < mesh->clusterCount; ++i)
+	{
+		if (mesh->clusters[i].valid)
+		{
+			++pStats->validCount;
+			pStats->coneCosineSum += mesh->clusters[i].coneAngleCosine;
+		}
+	}
+}
+
+// Reorders the triangles of every mesh into adjacency based clusters and computes their bounds
+static void buildClusters(Scene* pScene)
+{
+	HiresTimer buildTimer;
+	ClusterBuildStats indexOrderStats = {};
+	ClusterBuildStats builtStats = {};
+
+	tinystl::vector<uint32_t> triangleOrder;
+	for (uint32_t i = 0; i < pScene->numMeshes; ++i)
+	{
+		Mesh* mesh = &pScene->meshes[i];
+		const bool twoSided = pScene->materials[mesh->materialId].twoSided;
+		const uint32_t triangleCount = getMeshTriangleCount(mesh);
+
+		// Index order clusters, only kept for the report
+		CreateClusters(twoSided, pScene, mesh);
+		accumulateClusterStats(mesh, &indexOrderStats);
+		conf_free(mesh->clusters);
+		conf_free(mesh->clusterCompacts);
+
+		triangleOrder.resize(triangleCount);
+		buildMeshTriangleOrder(pScene, mesh, twoSided, triangleOrder.data());
+		applyMeshTriangleOrder(pScene, mesh, triangleOrder.data());
+		CreateClusters(twoSided, pScene, mesh);
+		accumulateClusterStats(mesh, &builtStats);
+	}
+
+	LOGINFOF("Built %u clusters in %f ms", builtStats.clusterCount, buildTimer.GetUSec(false) / 1000.0f);
+	LOGINFOF("Clusters with a cullable cone: index order %u (%.1f%%), adjacency %u (%.1f%%)",
+		indexOrderStats.validCount, 100.0 * indexOrderStats.validCount / max(indexOrderStats.clusterCount, 1U),
+		builtStats.validCount, 100.0 * builtStats.validCount / max(builtStats.clusterCount, 1U));
+	LOGINFOF("Average cone cosine: index order %.3f, adjacency %.3f",
+		indexOrderStats.coneCosineSum / max(indexOrderStats.validCount, 1U),
+		builtStats.coneCosineSum / max(builtStats.validCount, 1U));
+}
+
+/************************************************************************/
+// Scene file
+/************************************************************************/
+// The scene file holds everything loadScene returns in the layout it is uploaded and used with.
+// Sections are aligned so the mapped file is used in place. The vertex formats are platform dependent,
+// so every platform converts its own scene file from the source scene
+#define SCENE_FILE_MAGIC 0x43534256 // VBSC
+#define SCENE_FILE_VERSION 3
+#define SCENE_FILE_ALIGNMENT 64
+#define SCENE_FILE_EXTENSION ".vbscene"
+
+#define SCENE_MATERIAL_TWO_SIDED 0x1
+#define SCENE_MATERIAL_ALPHA_TESTED 0x2
+
+// Quantized positions are stored relative to the bounds of blocks of consecutive vertices
+#define SCENE_POSITION_BLOCK_SIZE 1024
+
+enum SceneFileSection
+{
+	SCENE_SECTION_INDICES = 0,
+	SCENE_SECTION_POSITIONS,
+	SCENE_SECTION_POSITION_BOUNDS,
+	SCENE_SECTION_TEXCOORDS,
+	SCENE_SECTION_NORMALS,
+	SCENE_SECTION_TANGENTS,
+	SCENE_SECTION_MESHES,
+	SCENE_SECTION_MATERIALS,
+	SCENE_SECTION_CLUSTERS,
+	SCENE_SECTION_CLUSTER_COMPACTS,
+	SCENE_SECTION_STRINGS,
+	SCENE_SECTION_COUNT
+};
+
+typedef struct SceneFileSectionDesc
+{
+	uint32_t offset;
+	uint32_t size;
+} SceneFileSectionDesc;
+
+typedef struct SceneFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t layout;
+	uint32_t clusterSize;
+	uint32_t fileSize;
+	// Checksum of everything after the header
+	uint32_t checksum;
+	// Size and modification time of the source scene the file was converted from
+	uint32_t sourceSize;
+	uint32_t sourceModifiedTime;
+	// SceneFileFlags the sections are encoded with
+	uint32_t flags;
+	uint32_t numMeshes;
+	uint32_t numMaterials;
+	uint32_t totalTriangles;
+	uint32_t totalVertices;
+	uint32_t totalClusters;
+	uint32_t stringsSize;
+	SceneFileSectionDesc sections[SCENE_SECTION_COUNT];
+} SceneFileHeader;
+
+typedef struct SceneFileMesh
+{
+	// First vertex and triangle count on Metal, first index and index count otherwise
+	uint32_t start;
+	uint32_t count;
+	uint32_t vertexCount;
+	uint32_t materialId;
+	uint32_t firstCluster;
+	uint32_t clusterCount;
+	float minBBox[3];
+	float maxBBox[3];
+} SceneFileMesh;
+
+typedef struct SceneFileMaterial
+{
+	uint32_t flags;
+	// Offsets of the texture names in the string section
+	uint32_t texture;
+	uint32_t normalMap;
+	uint32_t specularMap;
+} SceneFileMaterial;
+
+typedef struct ScenePositionBounds
+{
+	float min[3];
+	float max[3];
+} ScenePositionBounds;
+
+// Changes whenever one of the platform dependent types stored in the file changes
+static uint32_t getSceneFileLayout()
+{
+	uint32_t layout = (uint32_t)(sizeof(SceneVertexTexCoord) | (sizeof(SceneVertexNormal) << 6) |
+		(sizeof(SceneVertexTangent) << 12) | (sizeof(Cluster) << 18));
+#if defined(METAL)
+	layout |= 1u << 31;
+#endif
+	return layout;
+}
+
+// Identifies the version of the source scene a scene file was converted from.
+// Modification times are not available for packaged assets, they are left at 0 and only the size is compared there
+typedef struct SceneSourceStamp
+{
+	uint32_t size;
+	uint32_t modifiedTime;
+} SceneSourceStamp;
+
+static bool getSceneSourceStamp(const char* fileName, SceneSourceStamp* pStamp)
+{
+	File sourceFile = {};
+	if (!FileSystem::FileExists(fileName, FSR_Absolute) || !sourceFile.Open(fileName, FM_ReadBinary, FSR_Absolute))
+		return false;
+	pStamp->size = (uint32_t)sourceFile.GetSize();
+	sourceFile.Close();
+#if defined(__ANDROID__) || defined(TARGET_IOS)
+	pStamp->modifiedTime = 0;
+#else
+	pStamp->modifiedTime = FileSystem::GetLastModifiedTime(fileName);
+#endif
+	return true;
+}
+
+// FNV-1a over 32 bit words. Sections are aligned so the payload is always a multiple of 4 bytes
+static uint32_t getSceneFileChecksum(const void* pData, uint32_t size)
+{
+	const uint32_t* pWords = (const uint32_t*)pData;
+	uint32_t hash = 2166136261u;
+	for (uint32_t i = 0; i < size / sizeof(uint32_t); ++i)
+		hash = (hash ^ pWords[i]) * 16777619u;
+	return hash;
+}
+
+static uint32_t appendSceneString(tinystl::vector<char>& strings, const tinystl::string& str)
+{
+	const uint32_t offset = (uint32_t)strings.size();
+	strings.insert(strings.end(), str.c_str(), str.c_str() + str.size() + 1);
+	return offset;
+}
+
+static inline void writeVarint(tinystl::vector<uint8_t>& out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static inline bool readVarint(const uint8_t*& pData, const uint8_t* pEnd, uint32_t* pValue)
+{
+	uint32_t value = 0;
+	for (uint32_t shift = 0; shift < 35 && pData != pEnd; shift += 7)
+	{
+		const uint8_t byte = *pData++;
+		value |= (uint32_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+		{
+			*pValue = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline uint32_t zigzagEncode(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+static inline int32_t zigzagDecode(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+// Every index is stored as the difference to the previous one. Clustered triangles reference vertices close
+// to each other, so most indices take a single byte
+static void encodeIndices(const uint32_t* pIndices, uint32_t count, tinystl::vector<uint8_t>& out)
+{
+	uint32_t previous = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		writeVarint(out, zigzagEncode((int32_t)(pIndices[i] - previous)));
+		previous = pIndices[i];
+	}
+}
+
+static bool decodeIndices(const uint8_t* pData, uint32_t size, uint32_t* pIndices, uint32_t count)
+{
+	const uint8_t* pEnd = pData + size;
+	uint32_t previous = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t delta = 0;
+		if (!readVarint(pData, pEnd, &delta))
+			return false;
+		previous += (uint32_t)zigzagDecode(delta);
+		pIndices[i] = previous;
+	}
+	return pData == pEnd;
+}
+
+// Vertices are split into 16 bit components and every component is stored as the difference to the same component
+// of the previous vertex. Neighbouring vertices are close in position, direction and texture space, so the differences are small
+#define MAX_VERTEX_STREAM_COMPONENTS 8
+
+static void encodeVertexStream(const void* pVertices, uint32_t count, uint32_t stride, tinystl::vector<uint8_t>& out)
+{
+	ASSERT(stride % sizeof(uint16_t) == 0 && stride / sizeof(uint16_t) <= MAX_VERTEX_STREAM_COMPONENTS);
+	const uint32_t componentCount = stride / sizeof(uint16_t);
+	const uint16_t* pComponents = (const uint16_t*)pVertices;
+	uint16_t previous[MAX_VERTEX_STREAM_COMPONENTS] = {};
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		for (uint32_t c = 0; c < componentCount; ++c, ++pComponents)
+		{
+			writeVarint(out, zigzagEncode((int16_t)(uint16_t)(*pComponents - previous[c])));
+			previous[c] = *pComponents;
+		}
+	}
+}
+
+static bool decodeVertexStream(const uint8_t* pData, uint32_t size, void* pVertices, uint32_t count, uint32_t stride)
+{
+	ASSERT(stride % sizeof(uint16_t) == 0 && stride / sizeof(uint16_t) <= MAX_VERTEX_STREAM_COMPONENTS);
+	const uint32_t componentCount = stride / sizeof(uint16_t);
+	const uint8_t* pEnd = pData + size;
+	uint16_t* pComponents = (uint16_t*)pVertices;
+	uint16_t previous[MAX_VERTEX_STREAM_COMPONENTS] = {};
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		for (uint32_t c = 0; c < componentCount; ++c, ++pComponents)
+		{
+			uint32_t delta = 0;
+			if (!readVarint(pData, pEnd, &delta))
+				return false;
+			previous[c] = (uint16_t)(previous[c] + zigzagDecode(delta));
+			*pComponents = previous[c];
+		}
+	}
+	return pData == pEnd;
+}
+
+static void quantizePositions(const SceneVertexPos* pPositions, uint32_t count, ScenePositionBounds* pBounds, uint16_t* pQuantized)
+{
+	for (uint32_t block = 0; block * SCENE_POSITION_BLOCK_SIZE < count; ++block)
+	{
+		const uint32_t start = block * SCENE_POSITION_BLOCK_SIZE;
+		const uint32_t end = min(start + SCENE_POSITION_BLOCK_SIZE, count);
+		ScenePositionBounds& bounds = pBounds[block];
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			bounds.min[k] = INFINITY;
+			bounds.max[k] = -INFINITY;
+		}
+		for (uint32_t v = start; v < end; ++v)
+		{
+			const float* pPos = &pPositions[v].x;
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				bounds.min[k] = min(bounds.min[k], pPos[k]);
+				bounds.max[k] = max(bounds.max[k], pPos[k]);
+			}
+		}
+		for (uint32_t v = start; v < end; ++v)
+		{
+			const float* pPos = &pPositions[v].x;
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				const float extent = bounds.max[k] - bounds.min[k];
+				const float t = extent > 0.0f ? (pPos[k] - bounds.min[k]) / extent : 0.0f;
+				pQuantized[v * 3 + k] = (uint16_t)(t * 65535.0f + 0.5f);
+			}
+		}
+	}
+}
+
+static void dequantizePositions(const uint16_t* pQuantized, uint32_t count, const ScenePositionBounds* pBounds, SceneVertexPos* pPositions)
+{
+	for (uint32_t v = 0; v < count; ++v)
+	{
+		const ScenePositionBounds& bounds = pBounds[v / SCENE_POSITION_BLOCK_SIZE];
+		float* pPos = &pPositions[v].x;
+		for (uint32_t k = 0; k < 3; ++k)
+			pPos[k] = bounds.min[k] + (bounds.max[k] - bounds.min[k]) * (pQuantized[v * 3 + k] * (1.0f / 65535.0f));
+	}
+}
+
+// Reads the source scene, applies all load time processing and returns the scene file contents allocated with conf_malloc
+static void* buildSceneFile(const char* fileName, uint32_t flags, uint32_t* pFileSize)
+{
 	File assimpScene = {};
 	assimpScene.Open(fileName, FileMode::FM_ReadBinary, FSRoot::FSR_Absolute);
 	if (!assimpScene.IsOpen())
@@ -293,56 +880,44 @@ Scene* loadScene(const char* fileName)
 		ErrorMsg("Could not open scene %s.\nPlease make sure you have downloaded the art assets by using the PRE_BUILD command in the root directory", fileName);
 		return NULL;
 	}
-	ASSERT(assimpScene.IsOpen());
 
-	assimpScene.Read(&scene->numMeshes, sizeof(uint32_t));
-	assimpScene.Read(&scene->totalVertices, sizeof(uint32_t));
-	assimpScene.Read(&scene->totalTriangles, sizeof(uint32_t));
+	HiresTimer convertTimer;
+	Scene scene = {};
+	assimpScene.Read(&scene.numMeshes, sizeof(uint32_t));
+	assimpScene.Read(&scene.totalVertices, sizeof(uint32_t));
+	assimpScene.Read(&scene.totalTriangles, sizeof(uint32_t));
+
+	scene.meshes = (Mesh*)conf_calloc(scene.numMeshes, sizeof(Mesh));
+	tinystl::vector<uint32_t> indices(scene.totalTriangles, uint32_t(0));
+	tinystl::vector<SceneVertexPos> positions(scene.totalVertices, SceneVertexPos{ 0 });
+	tinystl::vector<SceneVertexTexCoord> texCoords(scene.totalVertices, SceneVertexTexCoord{ 0 });
+	tinystl::vector<SceneVertexNormal> normals(scene.totalVertices, SceneVertexNormal{ 0 });
+	tinystl::vector<SceneVertexTangent> tangents(scene.totalVertices, SceneVertexTangent{ 0 });
+
+	tinystl::vector<float2> sourceTexCoords(scene.totalVertices);
+	tinystl::vector<float3> sourceNormals(scene.totalVertices);
+	tinystl::vector<float3> sourceTangents(scene.totalVertices);
+
+	assimpScene.Read(indices.data(), sizeof(uint32_t) * scene.totalTriangles);
+	assimpScene.Read(positions.data(), sizeof(float3) * scene.totalVertices);
+	assimpScene.Read(sourceTexCoords.data(), sizeof(float2) * scene.totalVertices);
+	assimpScene.Read(sourceNormals.data(), sizeof(float3) * scene.totalVertices);
+	assimpScene.Read(sourceTangents.data(), sizeof(float3) * scene.totalVertices);
+
+	for (uint32_t v = 0; v < scene.totalVertices; v++)
+	{
+		const float3& normal = sourceNormals[v];
+		const float3& tangent = sourceTangents[v];
+		const float2& tc = sourceTexCoords[v];
 
-	scene->meshes = (Mesh*)conf_calloc(scene->numMeshes, sizeof(Mesh));
-	scene->indices = tinystl::vector<uint32>(scene->totalTriangles, uint32_t(0));
-	scene->positions = tinystl::vector<SceneVertexPos>(scene->totalVertices, SceneVertexPos{ 0 });
-	scene->texCoords = tinystl::vector<SceneVertexTexCoord>(scene->totalVertices, SceneVertexTexCoord{ 0 });
-	scene->normals = tinystl::vector<SceneVertexNormal>(scene->totalVertices, SceneVertexNormal{ 0 });
-	scene->tangents = tinystl::vector<SceneVertexTangent>(scene->totalVertices, SceneVertexTangent{ 0 });
-
-	tinystl::vector<float2> texcoords(scene->totalVertices);
-	tinystl::vector<float3> normals(scene->totalVertices);
-	tinystl::vector<float3> tangents(scene->totalVertices);
-
-	assimpScene.Read(scene->indices.data(), sizeof(uint32_t) * scene->totalTriangles);
-	assimpScene.Read(scene->positions.data(), sizeof(float3) * scene->totalVertices);
-	assimpScene.Read(texcoords.data(), sizeof(float2) * scene->totalVertices);
-	assimpScene.Read(normals.data(), sizeof(float3) * scene->totalVertices);
-	assimpScene.Read(tangents.data(), sizeof(float3) * scene->totalVertices);
-
-	for (uint32_t v = 0; v < scene->totalVertices; v++)
-	{
-		const float3& normal = normals[v];
-		const float3& tangent = tangents[v];
-		const float2& tc = texcoords[v];
-
-#if defined(METAL) || defined(__linux__)
-		scene->normals[v].nx = normal.x;
-		scene->normals[v].ny = normal.y;
-		scene->normals[v].nz = normal.z;
-
-		scene->tangents[v].tx = tangent.x;
-		scene->tangents[v].ty = tangent.y;
-		scene->tangents[v].tz = tangent.z;
-
-		scene->texCoords[v].u = tc.x;
-		scene->texCoords[v].v = 1.0f - tc.y;
-#else
-		scene->normals[v].normal = encodeDir(normal);
-		scene->tangents[v].tangent = encodeDir(tangent);
-		scene->texCoords[v].texCoord = pack2Floats(float2(tc.x, 1.0f - tc.y));
-#endif
+		normals[v].normal = encodeDir(normal);
+		tangents[v].tangent = encodeDir(tangent);
+		texCoords[v].texCoord = pack2Floats(float2(tc.x, 1.0f - tc.y));
 	}
 
-	for (uint32_t i = 0; i < scene->numMeshes; ++i)
+	for (uint32_t i = 0; i < scene.numMeshes; ++i)
 	{
-		Mesh& batch = scene->meshes[i];
+		Mesh& batch = scene.meshes[i];
 
 		assimpScene.Read(&batch.materialId, sizeof(uint32_t));
 		assimpScene.Read(&batch.vertexCount, sizeof(uint32_t));
@@ -350,7 +925,7 @@ Scene* loadScene(const char* fileName)
 		assimpScene.Read(&batch.startVertex, sizeof(uint32_t));
 		assimpScene.Read(&batch.vertexCount, sizeof(uint32_t));
 #else
-	assimpScene.Read(&batch.startIndex, sizeof(uint32_t));
+		assimpScene.Read(&batch.startIndex, sizeof(uint32_t));
 		assimpScene.Read(&batch.indexCount, sizeof(uint32_t));
 #endif
 	}
@@ -361,11 +936,10 @@ Scene* loadScene(const char* fileName)
 	tinystl::unordered_set<tinystl::string> alphaTestMaterials;
 	SetAlphaTestMaterials(alphaTestMaterials);
 
-	assimpScene.Read(&scene->numMaterials, sizeof(uint32_t));
-	scene->materials = (Material*)conf_calloc(scene->numMaterials, sizeof(Material));
-	scene->textures = (char**)conf_calloc(scene->numMaterials, sizeof(char*));
-	scene->normalMaps = (char**)conf_calloc(scene->numMaterials, sizeof(char*));
-	scene->specularMaps = (char**)conf_calloc(scene->numMaterials, sizeof(char*));
+	assimpScene.Read(&scene.numMaterials, sizeof(uint32_t));
+	scene.materials = (Material*)conf_calloc(scene.numMaterials, sizeof(Material));
+	tinystl::vector<SceneFileMaterial> fileMaterials(scene.numMaterials);
+	tinystl::vector<char> strings;
 
 #ifdef ORBIS
 #define DEFAULT_ALBEDO "default.gnf"
@@ -377,9 +951,9 @@ Scene* loadScene(const char* fileName)
 #define DEFAULT_SPEC "default.dds"
 #endif
 
-	for (uint32_t i = 0; i < scene->numMaterials; i++)
+	for (uint32_t i = 0; i < scene.numMaterials; i++)
 	{
-		Material& m = scene->materials[i];
+		Material& m = scene.materials[i];
 		m.twoSided = false;
 
 		uint32_t matNameLength = 0;
@@ -394,6 +968,10 @@ Scene* loadScene(const char* fileName)
 		tinystl::vector<char> albedoName(albedoNameLength);
 		assimpScene.Read(albedoName.data(), sizeof(char)*albedoNameLength);
 
+		// Texture names are resolved here so loading the scene file never probes the file system
+		tinystl::string texture(DEFAULT_ALBEDO);
+		tinystl::string normalMap(DEFAULT_NORMAL);
+		tinystl::string specMap(DEFAULT_SPEC);
 		if (albedoName[0] != '\0')
 		{
 			tinystl::string path(albedoName.data());
@@ -405,45 +983,28 @@ Scene* loadScene(const char* fileName)
 			path[dotPos] = '\0';
 			path.append(".gnf", 4);
 #endif
-			tinystl::string base_filename = FileSystem::GetFileNameAndExtension(path);
-			scene->textures[i] = (char*)conf_calloc(base_filename.size() + 1, sizeof(char));
-			strcpy(scene->textures[i], base_filename.c_str());
+			texture = FileSystem::GetFileNameAndExtension(path);
 
 			// try load the associated normal map
-			tinystl::string normalMap(base_filename);
+			normalMap = texture;
 			normalMap.rfind('.', -1, &dotPos);
 			normalMap.insert(dotPos, "_NRM", 4);
 
 			if (!FileSystem::FileExists(normalMap, FSR_Textures))
 				normalMap = DEFAULT_NORMAL;
 
-			scene->normalMaps[i] = (char*)conf_calloc(normalMap.size() + 1, sizeof(char));
-			strcpy(scene->normalMaps[i], normalMap.c_str());
-
 			// try load the associated spec map
-			tinystl::string specMap(base_filename);
+			specMap = texture;
 			dotPos = 0;
 			specMap.rfind('.', -1, &dotPos);
 			specMap.insert(dotPos, "_SPEC", 5);
 
 			if (!FileSystem::FileExists(specMap, FSR_Textures))
 				specMap = DEFAULT_SPEC;
-
-			scene->specularMaps[i] = (char*)conf_calloc(specMap.size() + 1, sizeof(char));
-			strcpy(scene->specularMaps[i], specMap.c_str());
-		}
-		else
-		{
-			// default textures
-			scene->textures[i] = (char*)conf_calloc(strlen(DEFAULT_ALBEDO) + 1, sizeof(char));
-			strcpy(scene->textures[i], DEFAULT_ALBEDO);
-
-			scene->normalMaps[i] = (char*)conf_calloc(strlen(DEFAULT_NORMAL) + 1, sizeof(char));
-			strcpy(scene->normalMaps[i], DEFAULT_NORMAL);
-
-			scene->specularMaps[i] = (char*)conf_calloc(strlen(DEFAULT_SPEC) + 1, sizeof(char));
-			strcpy(scene->specularMaps[i], DEFAULT_SPEC);
 		}
+		fileMaterials[i].texture = appendSceneString(strings, texture);
+		fileMaterials[i].normalMap = appendSceneString(strings, normalMap);
+		fileMaterials[i].specularMap = appendSceneString(strings, specMap);
 
 		float ns = 0.0f;
 		assimpScene.Read(&ns, sizeof(float));  // load shininess
@@ -457,67 +1018,531 @@ Scene* loadScene(const char* fileName)
 			m.twoSided = true;
 
 		m.alphaTested = (alphaTestMaterials.find(tinyMatName) != alphaTestMaterials.end());
+
+		fileMaterials[i].flags = (m.twoSided ? SCENE_MATERIAL_TWO_SIDED : 0) | (m.alphaTested ? SCENE_MATERIAL_ALPHA_TESTED : 0);
 	}
 
 	assimpScene.Close();
 
 #ifdef METAL
 	// Once we have read all the geometry from the original asset, expand indices into vertices so the models are compatible with Metal implementation.
-	Scene originalScene = *scene;
-
-	scene->totalTriangles = 0;
-	scene->totalVertices = 0;
-	scene->positions.clear();
-	scene->texCoords.clear();
-	scene->normals.clear();
-	scene->tangents.clear();
+	tinystl::vector<SceneVertexPos> indexedPositions;
+	tinystl::vector<SceneVertexTexCoord> indexedTexCoords;
+	tinystl::vector<SceneVertexNormal> indexedNormals;
+	tinystl::vector<SceneVertexTangent> indexedTangents;
+	indexedPositions.swap(positions);
+	indexedTexCoords.swap(texCoords);
+	indexedNormals.swap(normals);
+	indexedTangents.swap(tangents);
+
+	scene.totalTriangles = 0;
+	scene.totalVertices = 0;
 
 	uint32_t originalIdx = 0;
-	for (uint32_t i = 0; i < scene->numMeshes; i++)
+	for (uint32_t i = 0; i < scene.numMeshes; i++)
 	{
-		scene->meshes[i].startVertex = (uint32_t)scene->positions.size();
+		scene.meshes[i].startVertex = (uint32_t)positions.size();
 
-		uint32_t idxCount = originalScene.meshes[i].vertexCount; // Index count is stored in the vertex count member when reading the mesh on Metal.
+		uint32_t idxCount = scene.meshes[i].vertexCount; // Index count is stored in the vertex count member when reading the mesh on Metal.
 		for (uint32_t j = 0; j < idxCount; j++)
 		{
-			uint32_t idx = originalScene.indices[originalIdx++];
-			scene->positions.push_back(originalScene.positions[idx]);
-			scene->texCoords.push_back(originalScene.texCoords[idx]);
-			scene->normals.push_back(originalScene.normals[idx]);
-			scene->tangents.push_back(originalScene.tangents[idx]);
+			uint32_t idx = indices[originalIdx++];
+			positions.push_back(indexedPositions[idx]);
+			texCoords.push_back(indexedTexCoords[idx]);
+			normals.push_back(indexedNormals[idx]);
+			tangents.push_back(indexedTangents[idx]);
 		}
-		scene->meshes[i].vertexCount = (uint32_t)scene->positions.size() - scene->meshes[i].startVertex;
-		scene->meshes[i].triangleCount = scene->meshes[i].vertexCount / 3;
-		scene->totalTriangles += scene->meshes[i].triangleCount;
-		scene->totalVertices += scene->meshes[i].vertexCount;
+		scene.meshes[i].vertexCount = (uint32_t)positions.size() - scene.meshes[i].startVertex;
+		scene.meshes[i].triangleCount = scene.meshes[i].vertexCount / 3;
+		scene.totalTriangles += scene.meshes[i].triangleCount;
+		scene.totalVertices += scene.meshes[i].vertexCount;
 	}
+	indices.clear();
+	// No index buffer left to compress
+	flags &= ~SCENE_FILE_FLAG_COMPRESS_INDICES;
 #endif
 
-	return scene;
+	scene.indices = indices.data();
+	scene.positions = positions.data();
+	scene.texCoords = texCoords.data();
+	scene.normals = normals.data();
+	scene.tangents = tangents.data();
+
+	buildClusters(&scene);
+
+	// Lay out the file
+	uint32_t totalClusters = 0;
+	for (uint32_t i = 0; i < scene.numMeshes; ++i)
+		totalClusters += scene.meshes[i].clusterCount;
+
+	SceneFileHeader header = {};
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	header.layout = getSceneFileLayout();
+	header.clusterSize = CLUSTER_SIZE;
+	SceneSourceStamp sourceStamp = {};
+	getSceneSourceStamp(fileName, &sourceStamp);
+	header.sourceSize = sourceStamp.size;
+	header.sourceModifiedTime = sourceStamp.modifiedTime;
+	header.numMeshes = scene.numMeshes;
+	header.numMaterials = scene.numMaterials;
+	header.totalTriangles = scene.totalTriangles;
+	header.totalVertices = scene.totalVertices;
+	header.totalClusters = totalClusters;
+	header.stringsSize = (uint32_t)strings.size();
+	header.flags = flags;
+
+	// Optional encodings
+	tinystl::vector<uint8_t> encodedIndices;
+	if (flags & SCENE_FILE_FLAG_COMPRESS_INDICES)
+		encodeIndices(indices.data(), (uint32_t)indices.size(), encodedIndices);
+
+	const uint32_t positionBlockCount = (scene.totalVertices + SCENE_POSITION_BLOCK_SIZE - 1) / SCENE_POSITION_BLOCK_SIZE;
+	tinystl::vector<ScenePositionBounds> positionBounds;
+	tinystl::vector<uint16_t> quantizedPositions;
+	const void* pPositionData = positions.data();
+	uint32_t positionStride = sizeof(SceneVertexPos);
+	if (flags & SCENE_FILE_FLAG_QUANTIZE_POSITIONS)
+	{
+		positionBounds.resize(positionBlockCount);
+		quantizedPositions.resize(scene.totalVertices * 3);
+		quantizePositions(positions.data(), scene.totalVertices, positionBounds.data(), quantizedPositions.data());
+		pPositionData = quantizedPositions.data();
+		positionStride = 3 * sizeof(uint16_t);
+	}
+
+	tinystl::vector<uint8_t> encodedVertices[4];
+	if (flags & SCENE_FILE_FLAG_COMPRESS_VERTICES)
+	{
+		encodeVertexStream(pPositionData, scene.totalVertices, positionStride, encodedVertices[0]);
+		encodeVertexStream(texCoords.data(), scene.totalVertices, sizeof(SceneVertexTexCoord), encodedVertices[1]);
+		encodeVertexStream(normals.data(), scene.totalVertices, sizeof(SceneVertexNormal), encodedVertices[2]);
+		encodeVertexStream(tangents.data(), scene.totalVertices, sizeof(SceneVertexTangent), encodedVertices[3]);
+	}
+
+	const bool compressIndices = (flags & SCENE_FILE_FLAG_COMPRESS_INDICES) != 0;
+	const bool compressVertices = (flags & SCENE_FILE_FLAG_COMPRESS_VERTICES) != 0;
+	const void* pSectionData[SCENE_SECTION_COUNT] = {
+		compressIndices ? (const void*)encodedIndices.data() : indices.data(),
+		compressVertices ? (const void*)encodedVertices[0].data() : pPositionData,
+		positionBounds.data(),
+		compressVertices ? (const void*)encodedVertices[1].data() : texCoords.data(),
+		compressVertices ? (const void*)encodedVertices[2].data() : normals.data(),
+		compressVertices ? (const void*)encodedVertices[3].data() : tangents.data(),
+		NULL,
+		fileMaterials.data(),
+		NULL,
+		NULL,
+		strings.data(),
+	};
+	const uint32_t sectionSizes[SCENE_SECTION_COUNT] = {
+		compressIndices ? (uint32_t)encodedIndices.size() : (uint32_t)(indices.size() * sizeof(uint32_t)),
+		compressVertices ? (uint32_t)encodedVertices[0].size() : scene.totalVertices * positionStride,
+		(uint32_t)(positionBounds.size() * sizeof(ScenePositionBounds)),
+		compressVertices ? (uint32_t)encodedVertices[1].size() : scene.totalVertices * (uint32_t)sizeof(SceneVertexTexCoord),
+		compressVertices ? (uint32_t)encodedVertices[2].size() : scene.totalVertices * (uint32_t)sizeof(SceneVertexNormal),
+		compressVertices ? (uint32_t)encodedVertices[3].size() : scene.totalVertices * (uint32_t)sizeof(SceneVertexTangent),
+		scene.numMeshes * (uint32_t)sizeof(SceneFileMesh),
+		scene.numMaterials * (uint32_t)sizeof(SceneFileMaterial),
+		totalClusters * (uint32_t)sizeof(Cluster),
+		totalClusters * (uint32_t)sizeof(ClusterCompact),
+		(uint32_t)strings.size(),
+	};
+
+	uint32_t fileSize = round_up((uint32_t)sizeof(SceneFileHeader), SCENE_FILE_ALIGNMENT);
+	for (uint32_t i = 0; i < SCENE_SECTION_COUNT; ++i)
+	{
+		header.sections[i].offset = fileSize;
+		header.sections[i].size = sectionSizes[i];
+		fileSize = round_up(fileSize + sectionSizes[i], SCENE_FILE_ALIGNMENT);
+	}
+	header.fileSize = fileSize;
+
+	uint8_t* pFileData = (uint8_t*)conf_calloc(fileSize, 1);
+	for (uint32_t i = 0; i < SCENE_SECTION_COUNT; ++i)
+	{
+		if (pSectionData[i] && sectionSizes[i])
+			memcpy(pFileData + header.sections[i].offset, pSectionData[i], sectionSizes[i]);
+	}
+
+	SceneFileMesh* pFileMeshes = (SceneFileMesh*)(pFileData + header.sections[SCENE_SECTION_MESHES].offset);
+	Cluster* pFileClusters = (Cluster*)(pFileData + header.sections[SCENE_SECTION_CLUSTERS].offset);
+	ClusterCompact* pFileClusterCompacts = (ClusterCompact*)(pFileData + header.sections[SCENE_SECTION_CLUSTER_COMPACTS].offset);
+	uint32_t firstCluster = 0;
+	for (uint32_t i = 0; i < scene.numMeshes; ++i)
+	{
+		Mesh* mesh = &scene.meshes[i];
+		SceneFileMesh& fileMesh = pFileMeshes[i];
+#if defined(METAL)
+		fileMesh.start = mesh->startVertex;
+		fileMesh.count = mesh->triangleCount;
+#else
+		fileMesh.start = mesh->startIndex;
+		fileMesh.count = mesh->indexCount;
+#endif
+		fileMesh.vertexCount = mesh->vertexCount;
+		fileMesh.materialId = mesh->materialId;
+		fileMesh.firstCluster = firstCluster;
+		fileMesh.clusterCount = mesh->clusterCount;
+
+		vec3 aabbMin(INFINITY, INFINITY, INFINITY);
+		vec3 aabbMax = -aabbMin;
+		for (uint32_t c = 0; c < getMeshTriangleCount(mesh) * 3; ++c)
+		{
+			const vec3 pos = makeVec3(getCornerPosition(&scene, mesh, c));
+			aabbMin = minPerElem(aabbMin, pos);
+			aabbMax = maxPerElem(aabbMax, pos);
+		}
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			fileMesh.minBBox[k] = aabbMin[k];
+			fileMesh.maxBBox[k] = aabbMax[k];
+		}
+
+		memcpy(pFileClusters + firstCluster, mesh->clusters, mesh->clusterCount * sizeof(Cluster));
+		memcpy(pFileClusterCompacts + firstCluster, mesh->clusterCompacts, mesh->clusterCount * sizeof(ClusterCompact));
+		firstCluster += mesh->clusterCount;
+
+		conf_free(mesh->clusters);
+		conf_free(mesh->clusterCompacts);
+	}
+
+	header.checksum = getSceneFileChecksum(pFileData + sizeof(SceneFileHeader), fileSize - (uint32_t)sizeof(SceneFileHeader));
+	memcpy(pFileData, &header, sizeof(SceneFileHeader));
+
+	conf_free(scene.meshes);
+	conf_free(scene.materials);
+
+	LOGINFOF("Converted scene %s : %f ms", fileName, convertTimer.GetUSec(false) / 1000.0f);
+
+	*pFileSize = fileSize;
+	return pFileData;
 }
 
-void removeScene(Scene* scene)
+#define SCENE_SECTION_ANY_SIZE 0xffffffff
+
+static void* getSceneFileSection(void* pFileData, SceneFileSection section, uint32_t size)
+{
+	const SceneFileHeader* pHeader = (const SceneFileHeader*)pFileData;
+	const SceneFileSectionDesc& desc = pHeader->sections[section];
+	if ((size != SCENE_SECTION_ANY_SIZE && desc.size != size) || desc.offset % SCENE_FILE_ALIGNMENT || desc.offset > pHeader->fileSize ||
+		desc.size > pHeader->fileSize - desc.offset)
+		return NULL;
+	return (uint8_t*)pFileData + desc.offset;
+}
+
+// Decodes the sections that were stored encoded into pDecodedData. Sections stored as they are used are left in the file
+static bool decodeSceneFileSections(void* pFileData, void** pSections, void* pDecodedData)
+{
+	const SceneFileHeader* pHeader = (const SceneFileHeader*)pFileData;
+	const uint32_t vertexCount = pHeader->totalVertices;
+	uint8_t* pDecoded = (uint8_t*)pDecodedData;
+
+	if (pHeader->flags & SCENE_FILE_FLAG_COMPRESS_INDICES)
+	{
+		const uint32_t indexCount = pHeader->totalTriangles;
+		if (!decodeIndices((const uint8_t*)pSections[SCENE_SECTION_INDICES], pHeader->sections[SCENE_SECTION_INDICES].size, (uint32_t*)pDecoded, indexCount))
+			return false;
+		pSections[SCENE_SECTION_INDICES] = pDecoded;
+		pDecoded += round_up(indexCount * (uint32_t)sizeof(uint32_t), SCENE_FILE_ALIGNMENT);
+	}
+
+	if (pHeader->flags & SCENE_FILE_FLAG_COMPRESS_VERTICES)
+	{
+		const SceneFileSection sections[3] = { SCENE_SECTION_TEXCOORDS, SCENE_SECTION_NORMALS, SCENE_SECTION_TANGENTS };
+		const uint32_t strides[3] = { sizeof(SceneVertexTexCoord), sizeof(SceneVertexNormal), sizeof(SceneVertexTangent) };
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			if (!decodeVertexStream((const uint8_t*)pSections[sections[i]], pHeader->sections[sections[i]].size, pDecoded, vertexCount, strides[i]))
+				return false;
+			pSections[sections[i]] = pDecoded;
+			pDecoded += round_up(vertexCount * strides[i], SCENE_FILE_ALIGNMENT);
+		}
+	}
+
+	if (pHeader->flags & (SCENE_FILE_FLAG_QUANTIZE_POSITIONS | SCENE_FILE_FLAG_COMPRESS_VERTICES))
+	{
+		SceneVertexPos* pPositions = (SceneVertexPos*)pDecoded;
+		const uint8_t* pPositionData = (const uint8_t*)pSections[SCENE_SECTION_POSITIONS];
+		const uint32_t positionDataSize = pHeader->sections[SCENE_SECTION_POSITIONS].size;
+		if (pHeader->flags & SCENE_FILE_FLAG_QUANTIZE_POSITIONS)
+		{
+			const uint32_t quantizedSize = vertexCount * 3 * (uint32_t)sizeof(uint16_t);
+			uint16_t* pQuantized = (uint16_t*)pPositionData;
+			if (pHeader->flags & SCENE_FILE_FLAG_COMPRESS_VERTICES)
+			{
+				// Decoded right behind the positions they expand to
+				pQuantized = (uint16_t*)(pDecoded + round_up(vertexCount * (uint32_t)sizeof(SceneVertexPos), SCENE_FILE_ALIGNMENT));
+				if (!decodeVertexStream(pPositionData, positionDataSize, pQuantized, vertexCount, 3 * sizeof(uint16_t)))
+					return false;
+			}
+			else if (positionDataSize != quantizedSize)
+			{
+				return false;
+			}
+			dequantizePositions(pQuantized, vertexCount, (const ScenePositionBounds*)pSections[SCENE_SECTION_POSITION_BOUNDS], pPositions);
+		}
+		else if (!decodeVertexStream(pPositionData, positionDataSize, pPositions, vertexCount, sizeof(SceneVertexPos)))
+		{
+			return false;
+		}
+		pSections[SCENE_SECTION_POSITIONS] = pPositions;
+	}
+
+	return true;
+}
+
+static uint32_t getSceneFileDecodedSize(const SceneFileHeader* pHeader)
+{
+	uint32_t size = 0;
+	if (pHeader->flags & SCENE_FILE_FLAG_COMPRESS_INDICES)
+		size += round_up(pHeader->totalTriangles * (uint32_t)sizeof(uint32_t), SCENE_FILE_ALIGNMENT);
+	if (pHeader->flags & SCENE_FILE_FLAG_COMPRESS_VERTICES)
+	{
+		size += round_up(pHeader->totalVertices * (uint32_t)sizeof(SceneVertexTexCoord), SCENE_FILE_ALIGNMENT);
+		size += round_up(pHeader->totalVertices * (uint32_t)sizeof(SceneVertexNormal), SCENE_FILE_ALIGNMENT);
+		size += round_up(pHeader->totalVertices * (uint32_t)sizeof(SceneVertexTangent), SCENE_FILE_ALIGNMENT);
+	}
+	if (pHeader->flags & (SCENE_FILE_FLAG_QUANTIZE_POSITIONS | SCENE_FILE_FLAG_COMPRESS_VERTICES))
+		size += round_up(pHeader->totalVertices * (uint32_t)sizeof(SceneVertexPos), SCENE_FILE_ALIGNMENT);
+	if ((pHeader->flags & SCENE_FILE_FLAG_QUANTIZE_POSITIONS) && (pHeader->flags & SCENE_FILE_FLAG_COMPRESS_VERTICES))
+		size += pHeader->totalVertices * 3 * (uint32_t)sizeof(uint16_t);
+	return size;
+}
+
+// Points a new scene at the sections of the scene file. Returns NULL if the file is not a valid scene file for this platform
+// or, when pSourceStamp is given, was converted from another version of the source scene
+static Scene* createScene(void* pFileData, size_t fileSize, const char* fileName, const SceneSourceStamp* pSourceStamp)
 {
+	const SceneFileHeader* pHeader = (const SceneFileHeader*)pFileData;
+	if (fileSize < sizeof(SceneFileHeader) || pHeader->magic != SCENE_FILE_MAGIC)
+	{
+		LOGWARNINGF("%s is not a scene file", fileName);
+		return NULL;
+	}
+	if (pHeader->version != SCENE_FILE_VERSION || pHeader->layout != getSceneFileLayout() || pHeader->clusterSize != CLUSTER_SIZE)
+	{
+		LOGINFOF("Scene file %s was written by another version or for another platform", fileName);
+		return NULL;
+	}
+	if (pSourceStamp && (pHeader->sourceSize != pSourceStamp->size ||
+						 (pSourceStamp->modifiedTime && pHeader->sourceModifiedTime != pSourceStamp->modifiedTime)))
+	{
+		LOGINFOF("Scene file %s is out of date, the source scene changed", fileName);
+		return NULL;
+	}
+	if (pHeader->fileSize != fileSize ||
+		pHeader->checksum != getSceneFileChecksum((uint8_t*)pFileData + sizeof(SceneFileHeader), pHeader->fileSize - (uint32_t)sizeof(SceneFileHeader)))
+	{
+		LOGWARNINGF("Scene file %s is corrupted", fileName);
+		return NULL;
+	}
+
+	HiresTimer decodeTimer;
+#if defined(METAL)
+	const uint32_t indexCount = 0;
+#else
+	const uint32_t indexCount = pHeader->totalTriangles;
+#endif
+	const uint32_t vertexCount = pHeader->totalVertices;
+	const bool compressIndices = (pHeader->flags & SCENE_FILE_FLAG_COMPRESS_INDICES) != 0;
+	const bool compressVertices = (pHeader->flags & SCENE_FILE_FLAG_COMPRESS_VERTICES) != 0;
+	const bool quantizePositions = (pHeader->flags & SCENE_FILE_FLAG_QUANTIZE_POSITIONS) != 0;
+	const uint32_t positionBlockCount = quantizePositions ? (vertexCount + SCENE_POSITION_BLOCK_SIZE - 1) / SCENE_POSITION_BLOCK_SIZE : 0;
+	void* pSections[SCENE_SECTION_COUNT] = {
+		getSceneFileSection(pFileData, SCENE_SECTION_INDICES, compressIndices ? SCENE_SECTION_ANY_SIZE : indexCount * (uint32_t)sizeof(uint32_t)),
+		getSceneFileSection(pFileData, SCENE_SECTION_POSITIONS, compressVertices || quantizePositions ? SCENE_SECTION_ANY_SIZE : vertexCount * (uint32_t)sizeof(SceneVertexPos)),
+		getSceneFileSection(pFileData, SCENE_SECTION_POSITION_BOUNDS, positionBlockCount * (uint32_t)sizeof(ScenePositionBounds)),
+		getSceneFileSection(pFileData, SCENE_SECTION_TEXCOORDS, compressVertices ? SCENE_SECTION_ANY_SIZE : vertexCount * (uint32_t)sizeof(SceneVertexTexCoord)),
+		getSceneFileSection(pFileData, SCENE_SECTION_NORMALS, compressVertices ? SCENE_SECTION_ANY_SIZE : vertexCount * (uint32_t)sizeof(SceneVertexNormal)),
+		getSceneFileSection(pFileData, SCENE_SECTION_TANGENTS, compressVertices ? SCENE_SECTION_ANY_SIZE : vertexCount * (uint32_t)sizeof(SceneVertexTangent)),
+		getSceneFileSection(pFileData, SCENE_SECTION_MESHES, pHeader->numMeshes * (uint32_t)sizeof(SceneFileMesh)),
+		getSceneFileSection(pFileData, SCENE_SECTION_MATERIALS, pHeader->numMaterials * (uint32_t)sizeof(SceneFileMaterial)),
+		getSceneFileSection(pFileData, SCENE_SECTION_CLUSTERS, pHeader->totalClusters * (uint32_t)sizeof(Cluster)),
+		getSceneFileSection(pFileData, SCENE_SECTION_CLUSTER_COMPACTS, pHeader->totalClusters * (uint32_t)sizeof(ClusterCompact)),
+		getSceneFileSection(pFileData, SCENE_SECTION_STRINGS, pHeader->stringsSize),
+	};
+	for (uint32_t i = 0; i < SCENE_SECTION_COUNT; ++i)
+	{
+		if (!pSections[i])
+		{
+			LOGWARNINGF("Scene file %s is corrupted", fileName);
+			return NULL;
+		}
+	}
+
+	const uint32_t decodedSize = getSceneFileDecodedSize(pHeader);
+	void* pDecodedData = decodedSize ? conf_malloc(decodedSize) : NULL;
+	if (decodedSize)
+	{
+		if (!decodeSceneFileSections(pFileData, pSections, pDecodedData))
+		{
+			LOGWARNINGF("Scene file %s is corrupted", fileName);
+			conf_free(pDecodedData);
+			return NULL;
+		}
+		LOGINFOF("Decoded scene file sections : %f ms", decodeTimer.GetUSec(false) / 1000.0f);
+	}
+
+	Scene* scene = (Scene*)conf_calloc(1, sizeof(Scene));
+	scene->numMeshes = pHeader->numMeshes;
+	scene->numMaterials = pHeader->numMaterials;
+	scene->totalTriangles = pHeader->totalTriangles;
+	scene->totalVertices = pHeader->totalVertices;
+	scene->pDecodedData = pDecodedData;
+	scene->indices = indexCount ? (uint32_t*)pSections[SCENE_SECTION_INDICES] : NULL;
+	scene->positions = (SceneVertexPos*)pSections[SCENE_SECTION_POSITIONS];
+	scene->texCoords = (SceneVertexTexCoord*)pSections[SCENE_SECTION_TEXCOORDS];
+	scene->normals = (SceneVertexNormal*)pSections[SCENE_SECTION_NORMALS];
+	scene->tangents = (SceneVertexTangent*)pSections[SCENE_SECTION_TANGENTS];
+
+	// Meshes and materials carry runtime state, everything they reference stays in the file
+	const SceneFileMesh* pFileMeshes = (const SceneFileMesh*)pSections[SCENE_SECTION_MESHES];
+	Cluster* pClusters = (Cluster*)pSections[SCENE_SECTION_CLUSTERS];
+	ClusterCompact* pClusterCompacts = (ClusterCompact*)pSections[SCENE_SECTION_CLUSTER_COMPACTS];
+	scene->meshes = (Mesh*)conf_calloc(scene->numMeshes, sizeof(Mesh));
+	for (uint32_t i = 0; i < scene->numMeshes; ++i)
+	{
+		const SceneFileMesh& fileMesh = pFileMeshes[i];
+		Mesh* mesh = &scene->meshes[i];
+#if defined(METAL)
+		mesh->startVertex = fileMesh.start;
+		mesh->triangleCount = fileMesh.count;
+#else
+		mesh->startIndex = fileMesh.start;
+		mesh->indexCount = fileMesh.count;
+#endif
+		mesh->vertexCount = fileMesh.vertexCount;
+		mesh->materialId = fileMesh.materialId;
+		mesh->minBBox = float3(fileMesh.minBBox[0], fileMesh.minBBox[1], fileMesh.minBBox[2]);
+		mesh->maxBBox = float3(fileMesh.maxBBox[0], fileMesh.maxBBox[1], fileMesh.maxBBox[2]);
+		mesh->clusterCount = fileMesh.clusterCount;
+		mesh->clusters = pClusters + fileMesh.firstCluster;
+		mesh->clusterCompacts = pClusterCompacts + fileMesh.firstCluster;
+	}
+
+	const SceneFileMaterial* pFileMaterials = (const SceneFileMaterial*)pSections[SCENE_SECTION_MATERIALS];
+	const char* pStrings = (const char*)pSections[SCENE_SECTION_STRINGS];
+	scene->materials = (Material*)conf_calloc(scene->numMaterials, sizeof(Material));
+	scene->textures = (const char**)conf_calloc(scene->numMaterials, sizeof(char*));
+	scene->normalMaps = (const char**)conf_calloc(scene->numMaterials, sizeof(char*));
+	scene->specularMaps = (const char**)conf_calloc(scene->numMaterials, sizeof(char*));
 	for (uint32_t i = 0; i < scene->numMaterials; ++i)
 	{
-		conf_free(scene->textures[i]);
-		conf_free(scene->normalMaps[i]);
-		conf_free(scene->specularMaps[i]);
+		const SceneFileMaterial& fileMaterial = pFileMaterials[i];
+		scene->materials[i].twoSided = (fileMaterial.flags & SCENE_MATERIAL_TWO_SIDED) != 0;
+		scene->materials[i].alphaTested = (fileMaterial.flags & SCENE_MATERIAL_ALPHA_TESTED) != 0;
+		scene->textures[i] = pStrings + fileMaterial.texture;
+		scene->normalMaps[i] = pStrings + fileMaterial.normalMap;
+		scene->specularMaps[i] = pStrings + fileMaterial.specularMap;
 	}
 
-	scene->positions.~vector();
-	scene->texCoords.~vector();
-	scene->normals.~vector();
-	scene->tangents.~vector();
-#ifndef METAL
-	scene->indices.~vector();
+	// Memory the vertex and index buffers take on the GPU, which is also what the geometry passes read per frame at most
+	const uint32_t vertexStride = sizeof(SceneVertexPos) + sizeof(SceneVertexTexCoord) + sizeof(SceneVertexNormal) + sizeof(SceneVertexTangent);
+	const uint32_t unpackedVertexStride = 3 * sizeof(float) + 2 * sizeof(float) + 3 * sizeof(float) + 3 * sizeof(float);
+	LOGINFOF(
+		"Scene %s : %u vertices, %u bytes per vertex (%u unpacked), vertex buffers %.2f MB (%.2f MB unpacked), index buffer %.2f MB",
+		fileName, vertexCount, vertexStride, unpackedVertexStride, (float)vertexCount * vertexStride / (1024.0f * 1024.0f),
+		(float)vertexCount * unpackedVertexStride / (1024.0f * 1024.0f), (float)indexCount * sizeof(uint32_t) / (1024.0f * 1024.0f));
+	LOGINFOF(
+		"Scene file %s : %.2f MB on disk, %.2f MB decoded on load. Quantized positions %s, compressed vertices %s, compressed indices %s",
+		fileName, (float)fileSize / (1024.0f * 1024.0f), (float)decodedSize / (1024.0f * 1024.0f), quantizePositions ? "on" : "off",
+		compressVertices ? "on" : "off", compressIndices ? "on" : "off");
+
+	return scene;
+}
+
+static bool writeSceneFile(const tinystl::string& fileName, const void* pFileData, uint32_t fileSize)
+{
+	File sceneFile = {};
+	if (!sceneFile.Open(fileName, FM_WriteBinary, FSR_Absolute))
+		return false;
+	const bool written = sceneFile.Write(pFileData, fileSize) == fileSize;
+	sceneFile.Close();
+	return written;
+}
+
+bool convertScene(const char* srcFileName, const char* dstFileName, uint32_t flags)
+{
+	uint32_t fileSize = 0;
+	void* pFileData = buildSceneFile(srcFileName, flags, &fileSize);
+	if (!pFileData)
+		return false;
+
+	const bool written = writeSceneFile(dstFileName, pFileData, fileSize);
+	conf_free(pFileData);
+	return written;
+}
+
+// Loads the scene file stored next to the source scene. The source scene is converted when the scene file is missing or out of date
+Scene* loadScene(const char* fileName, uint32_t convertFlags)
+{
+#if TARGET_IOS
+	NSString *fileUrl = [[NSBundle mainBundle] pathForResource:[NSString stringWithUTF8String : fileName] ofType : @""];
+	fileName = [fileUrl fileSystemRepresentation];
 #endif
 
+	tinystl::string sceneFileName = FileSystem::ReplaceExtension(fileName, SCENE_FILE_EXTENSION);
+	Scene* scene = NULL;
+	if (FileSystem::FileExists(sceneFileName, FSR_Absolute))
+	{
+		HiresTimer mapTimer;
+		// Without the source scene the shipped scene file is all there is, so it is used as is
+		SceneSourceStamp sourceStamp = {};
+		const bool hasSource = getSceneSourceStamp(fileName, &sourceStamp);
+		MappedFile* pSceneFile = conf_placement_new<MappedFile>(conf_calloc(1, sizeof(MappedFile)));
+		if (pSceneFile->Open(sceneFileName, FSR_Absolute))
+			scene = createScene(pSceneFile->GetData(), pSceneFile->GetSize(), sceneFileName.c_str(), hasSource ? &sourceStamp : NULL);
+
+		if (scene)
+		{
+			scene->pSceneFile = pSceneFile;
+			LOGINFOF("Mapped scene file %s (%u MB) : %f ms", sceneFileName.c_str(), (uint32_t)(pSceneFile->GetSize() >> 20), mapTimer.GetUSec(false) / 1000.0f);
+		}
+		else
+		{
+			pSceneFile->~MappedFile();
+			conf_free(pSceneFile);
+		}
+	}
+
+	if (!scene)
+	{
+		uint32_t fileSize = 0;
+		void* pFileData = buildSceneFile(fileName, convertFlags, &fileSize);
+		if (!pFileData)
+			return NULL;
+
+#if defined(__ANDROID__) || defined(TARGET_IOS)
+		// Assets are read only, the scene file has to be shipped with them
+#else
+		if (!writeSceneFile(sceneFileName, pFileData, fileSize))
+			LOGWARNINGF("Could not write scene file %s. The scene will be converted on every load", sceneFileName.c_str());
+#endif
+
+		scene = createScene(pFileData, fileSize, sceneFileName.c_str(), NULL);
+		ASSERT(scene);
+		scene->pSceneData = pFileData;
+	}
+
+	return scene;
+}
+
+void removeScene(Scene* scene)
+{
 	conf_free(scene->textures);
 	conf_free(scene->normalMaps);
 	conf_free(scene->specularMaps);
 	conf_free(scene->meshes);
 	conf_free(scene->materials);
+
+	if (scene->pSceneFile)
+	{
+		scene->pSceneFile->~MappedFile();
+		conf_free(scene->pSceneFile);
+	}
+	conf_free(scene->pSceneData);
+	conf_free(scene->pDecodedData);
 	conf_free(scene);
 }
 
@@ -784,6 +1809,251 @@ void CreateClusters(bool twoSided, const Scene* pScene, Mesh* mesh)
 #endif
 }
 
+void createClusterCullData(Scene* pScene)
+{
+	ClusterCullData* pData = &pScene->clusterCullData;
+
+	uint32_t clusterCount = 0;
+	for (uint32_t i = 0; i < pScene->numMeshes; ++i)
+	{
+		pScene->meshes[i].clusterCullOffset = clusterCount;
+		clusterCount += round_up(pScene->meshes[i].clusterCount, CLUSTER_CULL_LANES);
+	}
+
+	const uint32_t arrayCount = 13;
+	pData->clusterCount = clusterCount;
+	pData->storage = (float*)conf_calloc(max(clusterCount, 1U) * arrayCount, sizeof(float));
+
+	float** arrays[arrayCount] = {
+		&pData->coneCenterX, &pData->coneCenterY, &pData->coneCenterZ,
+		&pData->coneAxisX, &pData->coneAxisY, &pData->coneAxisZ,
+		&pData->coneAngleCosine,
+		&pData->aabbMinX, &pData->aabbMinY, &pData->aabbMinZ,
+		&pData->aabbMaxX, &pData->aabbMaxY, &pData->aabbMaxZ,
+	};
+	for (uint32_t i = 0; i < arrayCount; ++i)
+		*arrays[i] = pData->storage + i * clusterCount;
+
+	// Padding lanes keep a zero sized box at the origin and are never reported by cullClusters
+	for (uint32_t i = 0; i < clusterCount; ++i)
+		pData->coneAngleCosine[i] = INFINITY;
+
+	for (uint32_t i = 0; i < pScene->numMeshes; ++i)
+	{
+		const Mesh* mesh = &pScene->meshes[i];
+		for (uint32_t j = 0; j < mesh->clusterCount; ++j)
+		{
+			const Cluster* cluster = &mesh->clusters[j];
+			const uint32_t index = mesh->clusterCullOffset + j;
+
+			pData->coneCenterX[index] = cluster->coneCenter.x;
+			pData->coneCenterY[index] = cluster->coneCenter.y;
+			pData->coneCenterZ[index] = cluster->coneCenter.z;
+			pData->coneAxisX[index] = cluster->coneAxis.x;
+			pData->coneAxisY[index] = cluster->coneAxis.y;
+			pData->coneAxisZ[index] = cluster->coneAxis.z;
+			// Invalid clusters can't be safely culled using the cone based test.
+			// An infinite cosine makes the test fail without a branch in the culling loop
+			pData->coneAngleCosine[index] = cluster->valid ? cluster->coneAngleCosine : INFINITY;
+			pData->aabbMinX[index] = cluster->aabbMin.x;
+			pData->aabbMinY[index] = cluster->aabbMin.y;
+			pData->aabbMinZ[index] = cluster->aabbMin.z;
+			pData->aabbMaxX[index] = cluster->aabbMax.x;
+			pData->aabbMaxY[index] = cluster->aabbMax.y;
+			pData->aabbMaxZ[index] = cluster->aabbMax.z;
+		}
+	}
+}
+
+void destroyClusterCullData(Scene* pScene)
+{
+	conf_free(pScene->clusterCullData.storage);
+	memset(&pScene->clusterCullData, 0, sizeof(pScene->clusterCullData));
+}
+
+#if defined(CLUSTER_CULL_SSE)
+// Returns one bit per lane for the clusters starting at index that are visible from at least one view
+static inline int cullClusterLanes(const ClusterCullData* pData, uint32_t index, const ClusterCullViews* pViews)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 cx = _mm_load_ps(pData->coneCenterX + index);
+	const __m128 cy = _mm_load_ps(pData->coneCenterY + index);
+	const __m128 cz = _mm_load_ps(pData->coneCenterZ + index);
+	const __m128 ax = _mm_load_ps(pData->coneAxisX + index);
+	const __m128 ay = _mm_load_ps(pData->coneAxisY + index);
+	const __m128 az = _mm_load_ps(pData->coneAxisZ + index);
+	const __m128 coneCos = _mm_load_ps(pData->coneAngleCosine + index);
+	const __m128 minX = _mm_load_ps(pData->aabbMinX + index);
+	const __m128 minY = _mm_load_ps(pData->aabbMinY + index);
+	const __m128 minZ = _mm_load_ps(pData->aabbMinZ + index);
+	const __m128 maxX = _mm_load_ps(pData->aabbMaxX + index);
+	const __m128 maxY = _mm_load_ps(pData->aabbMaxY + index);
+	const __m128 maxZ = _mm_load_ps(pData->aabbMaxZ + index);
+
+	__m128 culled = _mm_cmpeq_ps(zero, zero);
+	for (uint32_t v = 0; v < NUM_CULLING_VIEWPORTS; ++v)
+	{
+		// Vector from the cone center to the eye
+		const __m128 dx = _mm_sub_ps(_mm_set1_ps(pViews->eye[v][0]), cx);
+		const __m128 dy = _mm_sub_ps(_mm_set1_ps(pViews->eye[v][1]), cy);
+		const __m128 dz = _mm_sub_ps(_mm_set1_ps(pViews->eye[v][2]), cz);
+		const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ax), _mm_mul_ps(dy, ay)), _mm_mul_ps(dz, az));
+
+		// dot(normalize(eye - center), axis) >= cosine without the division. The eye is inside the cone
+		__m128 outside = _mm_cmpge_ps(d, _mm_mul_ps(coneCos, _mm_sqrt_ps(lengthSq)));
+
+		// Box corner furthest along each plane normal
+		for (uint32_t p = 0; p < 4; ++p)
+		{
+			const float* plane = pViews->planes[v][p];
+			const __m128 px = plane[0] >= 0.0f ? maxX : minX;
+			const __m128 py = plane[1] >= 0.0f ? maxY : minY;
+			const __m128 pz = plane[2] >= 0.0f ? maxZ : minZ;
+			const __m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), px), _mm_mul_ps(_mm_set1_ps(plane[1]), py)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[2]), pz), _mm_set1_ps(plane[3])));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+		}
+
+		culled = _mm_and_ps(culled, outside);
+	}
+
+	return ~_mm_movemask_ps(culled) & 0xf;
+}
+#elif defined(CLUSTER_CULL_NEON)
+static inline int cullClusterLanes(const ClusterCullData* pData, uint32_t index, const ClusterCullViews* pViews)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t cx = vld1q_f32(pData->coneCenterX + index);
+	const float32x4_t cy = vld1q_f32(pData->coneCenterY + index);
+	const float32x4_t cz = vld1q_f32(pData->coneCenterZ + index);
+	const float32x4_t ax = vld1q_f32(pData->coneAxisX + index);
+	const float32x4_t ay = vld1q_f32(pData->coneAxisY + index);
+	const float32x4_t az = vld1q_f32(pData->coneAxisZ + index);
+	const float32x4_t coneCos = vld1q_f32(pData->coneAngleCosine + index);
+	const float32x4_t minX = vld1q_f32(pData->aabbMinX + index);
+	const float32x4_t minY = vld1q_f32(pData->aabbMinY + index);
+	const float32x4_t minZ = vld1q_f32(pData->aabbMinZ + index);
+	const float32x4_t maxX = vld1q_f32(pData->aabbMaxX + index);
+	const float32x4_t maxY = vld1q_f32(pData->aabbMaxY + index);
+	const float32x4_t maxZ = vld1q_f32(pData->aabbMaxZ + index);
+
+	uint32x4_t culled = vdupq_n_u32(0xffffffff);
+	for (uint32_t v = 0; v < NUM_CULLING_VIEWPORTS; ++v)
+	{
+		const float32x4_t dx = vsubq_f32(vdupq_n_f32(pViews->eye[v][0]), cx);
+		const float32x4_t dy = vsubq_f32(vdupq_n_f32(pViews->eye[v][1]), cy);
+		const float32x4_t dz = vsubq_f32(vdupq_n_f32(pViews->eye[v][2]), cz);
+		const float32x4_t lengthSq = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, dx), dy, dy), dz, dz);
+		const float32x4_t d = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, ax), dy, ay), dz, az);
+
+		// sqrt(x) = x * rsqrt(x), refined twice to stay as exact as the SSE path
+		float32x4_t rsqrt = vrsqrteq_f32(lengthSq);
+		rsqrt = vmulq_f32(rsqrt, vrsqrtsq_f32(vmulq_f32(lengthSq, rsqrt), rsqrt));
+		rsqrt = vmulq_f32(rsqrt, vrsqrtsq_f32(vmulq_f32(lengthSq, rsqrt), rsqrt));
+		const float32x4_t length = vmulq_f32(lengthSq, rsqrt);
+
+		uint32x4_t outside = vcgeq_f32(d, vmulq_f32(coneCos, length));
+
+		for (uint32_t p = 0; p < 4; ++p)
+		{
+			const float* plane = pViews->planes[v][p];
+			const float32x4_t px = plane[0] >= 0.0f ? maxX : minX;
+			const float32x4_t py = plane[1] >= 0.0f ? maxY : minY;
+			const float32x4_t pz = plane[2] >= 0.0f ? maxZ : minZ;
+			float32x4_t distance = vdupq_n_f32(plane[3]);
+			distance = vmlaq_n_f32(distance, px, plane[0]);
+			distance = vmlaq_n_f32(distance, py, plane[1]);
+			distance = vmlaq_n_f32(distance, pz, plane[2]);
+			outside = vorrq_u32(outside, vcltq_f32(distance, zero));
+		}
+
+		culled = vandq_u32(culled, outside);
+	}
+
+	const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+	const uint32x4_t bits = vandq_u32(vmvnq_u32(culled), vld1q_u32(laneBits));
+	const uint32x2_t sum = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+	return (int)vget_lane_u32(vpadd_u32(sum, sum), 0);
+}
+#else
+static inline int cullClusterLanes(const ClusterCullData* pData, uint32_t index, const ClusterCullViews* pViews)
+{
+	int visibleMask = 0;
+	for (uint32_t lane = 0; lane < CLUSTER_CULL_LANES; ++lane)
+	{
+		const uint32_t i = index + lane;
+		const float box[2][3] = {
+			{ pData->aabbMinX[i], pData->aabbMinY[i], pData->aabbMinZ[i] },
+			{ pData->aabbMaxX[i], pData->aabbMaxY[i], pData->aabbMaxZ[i] },
+		};
+
+		for (uint32_t v = 0; v < NUM_CULLING_VIEWPORTS; ++v)
+		{
+			const float dx = pViews->eye[v][0] - pData->coneCenterX[i];
+			const float dy = pViews->eye[v][1] - pData->coneCenterY[i];
+			const float dz = pViews->eye[v][2] - pData->coneCenterZ[i];
+			const float d = dx * pData->coneAxisX[i] + dy * pData->coneAxisY[i] + dz * pData->coneAxisZ[i];
+			bool outside = d >= pData->coneAngleCosine[i] * sqrtf(dx * dx + dy * dy + dz * dz);
+
+			for (uint32_t p = 0; p < 4 && !outside; ++p)
+			{
+				const float* plane = pViews->planes[v][p];
+				const float distance =
+					plane[0] * box[plane[0] >= 0.0f][0] +
+					plane[1] * box[plane[1] >= 0.0f][1] +
+					plane[2] * box[plane[2] >= 0.0f][2] + plane[3];
+				outside = distance < 0.0f;
+			}
+
+			if (!outside)
+			{
+				visibleMask |= 1 << lane;
+				break;
+			}
+		}
+	}
+	return visibleMask;
+}
+#endif
+
+uint32_t cullClusters(const ClusterCullData* pData, const Mesh* pMesh, const ClusterCullViews* pViews, uint32_t* pVisibleClusters)
+{
+	uint32_t visibleCount = 0;
+	for (uint32_t j = 0; j < pMesh->clusterCount; j += CLUSTER_CULL_LANES)
+	{
+		int visibleMask = cullClusterLanes(pData, pMesh->clusterCullOffset + j, pViews);
+
+		// Drop the padding lanes after the last cluster of the mesh
+		const uint32_t laneCount = min(pMesh->clusterCount - j, (uint32_t)CLUSTER_CULL_LANES);
+		visibleMask &= (1 << laneCount) - 1;
+
+		for (uint32_t lane = 0; visibleMask; ++lane, visibleMask >>= 1)
+		{
+			if (visibleMask & 1)
+				pVisibleClusters[visibleCount++] = j + lane;
+		}
+	}
+	return visibleCount;
+}
+
+void getClusterOccluderMesh(const Scene* pScene, const Mesh* pMesh, const ClusterCompact* pCluster, OccluderMesh* pOccluder)
+{
+	memset(pOccluder, 0, sizeof(OccluderMesh));
+#if defined(METAL)
+	// Without an index buffer the triangles of the cluster are consecutive vertices
+	pOccluder->pPositions = &pScene->positions[pMesh->startVertex + pCluster->clusterStart * 3].x;
+#else
+	pOccluder->pPositions = &pScene->positions[0].x;
+	pOccluder->pIndices = pScene->indices + pMesh->startIndex + pCluster->clusterStart * 3;
+#endif
+	pOccluder->mVertexStride = sizeof(SceneVertexPos);
+	pOccluder->mTriangleCount = pCluster->triangleCount;
+	// The back side of an open mesh hides what is behind it just as well, so both windings are rasterized
+	pOccluder->mTwoSided = true;
+}
+
 #if defined(METAL)
 void addClusterToBatchChunk(const ClusterCompact* cluster, const Mesh* mesh, uint32_t meshIdx, bool isTwoSided, FilterBatchChunk* batchChunk)
 {
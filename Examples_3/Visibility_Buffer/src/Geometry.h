@@ -27,6 +27,8 @@
 
 #include "../../../Common_3/Renderer/IRenderer.h"
 #include "../../../Common_3/Renderer/ResourceLoader.h"
+#include "../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../Common_3/OS/Core/OcclusionRasterizer.h"
 
 #if defined(METAL)
 #include "Shaders/OSXMetal/shader_defs.h"
@@ -47,31 +49,20 @@ typedef struct SceneVertexPos
 	float x,y,z;
 } SceneVertexPos;
 
+// Texture coordinates are stored as half2, normals and tangents as octahedral unorm16x2 on every platform
 typedef struct SceneVertexTexCoord
 {
-#if defined(METAL) || defined(__linux__)
-	float u,v;	// texture coords
-#else
 	uint32_t texCoord;
-#endif
 } SceneVertexTexCoord;
 
 typedef struct SceneVertexNormal
 {
-#if defined(METAL) || defined(__linux__)
-	float nx, ny, nz; // normals
-#else
 	uint32_t normal;
-#endif
 } SceneVertexNormal;
 
 typedef struct SceneVertexTangent
 {
-#if defined(METAL) || defined(__linux__)
-	float tx, ty, tz; // tangents
-#else
 	uint32_t tangent;
-#endif
 } SceneVertexTangent;
 
 typedef struct ClusterCompact
@@ -89,6 +80,38 @@ typedef struct Cluster
 	bool valid;
 } Cluster;
 
+// Number of clusters tested at once by cullClusters. Every mesh starts at a multiple of it in ClusterCullData
+#define CLUSTER_CULL_LANES 4
+
+// Cluster bounds of every mesh in structure of arrays layout for the CPU cluster culling
+typedef struct ClusterCullData
+{
+	float* coneCenterX;
+	float* coneCenterY;
+	float* coneCenterZ;
+	float* coneAxisX;
+	float* coneAxisY;
+	float* coneAxisZ;
+	// Infinity for clusters the cone test can't cull
+	float* coneAngleCosine;
+	float* aabbMinX;
+	float* aabbMinY;
+	float* aabbMinZ;
+	float* aabbMaxX;
+	float* aabbMaxY;
+	float* aabbMaxZ;
+	uint32_t clusterCount; // including padding
+	float* storage;
+} ClusterCullData;
+
+// Object space views a cluster has to be invisible from to be culled
+typedef struct ClusterCullViews
+{
+	float eye[NUM_CULLING_VIEWPORTS][4];
+	// Left, right, bottom, top. A point p is inside when dot(plane.xyz, p) + plane.w >= 0
+	float planes[NUM_CULLING_VIEWPORTS][4][4];
+} ClusterCullViews;
+
 typedef struct Mesh
 {
 #if defined(METAL)
@@ -103,6 +126,7 @@ typedef struct Mesh
 	uint32_t clusterCount;
 	ClusterCompact* clusterCompacts;
 	Cluster* clusters;
+	uint32_t clusterCullOffset; // first cluster of this mesh in ClusterCullData
 	uint32_t materialId;
 } Mesh;
 
@@ -120,15 +144,24 @@ typedef struct Scene
 	uint32_t totalVertices;
 	Mesh* meshes;
 	Material* materials;
-	tinystl::vector<SceneVertexPos> positions;
-	tinystl::vector<SceneVertexTexCoord> texCoords;
-	tinystl::vector<SceneVertexNormal> normals;
-	tinystl::vector<SceneVertexTangent> tangents;
-	char** textures;
-	char** normalMaps;
-	char** specularMaps;
-
-	tinystl::vector<uint32_t>		   indices;
+	// Vertex data, indices, clusters and texture names point into the scene file
+	SceneVertexPos* positions;
+	SceneVertexTexCoord* texCoords;
+	SceneVertexNormal* normals;
+	SceneVertexTangent* tangents;
+	const char** textures;
+	const char** normalMaps;
+	const char** specularMaps;
+
+	uint32_t*		   indices;
+
+	MappedFile* pSceneFile;
+	// Scene file contents when the scene was converted during this load
+	void* pSceneData;
+	// Sections of the scene file that were stored encoded
+	void* pDecodedData;
+
+	ClusterCullData clusterCullData;
 } Scene;
 
 typedef struct FilterBatchData
@@ -161,11 +194,35 @@ typedef struct FilterBatchChunk
 #endif
 } FilterBatchChunk;
 
+// Encodings of the scene file. Sections without encoding are used in place from the mapped file
+typedef enum SceneFileFlags
+{
+	SCENE_FILE_FLAG_NONE = 0,
+	// Positions are stored as unorm16 relative to the bounds of blocks of vertices
+	SCENE_FILE_FLAG_QUANTIZE_POSITIONS = 0x1,
+	// Vertex streams are delta encoded per 16 bit component and stored as variable length integers
+	SCENE_FILE_FLAG_COMPRESS_VERTICES = 0x2,
+	// Indices are delta encoded and stored as variable length integers
+	SCENE_FILE_FLAG_COMPRESS_INDICES = 0x4,
+} SceneFileFlags;
+
 // Exposed functions
 
-Scene* loadScene(const char* fileName);
+// convertFlags are the SceneFileFlags used when the scene file has to be converted
+Scene* loadScene(const char* fileName, uint32_t convertFlags = SCENE_FILE_FLAG_NONE);
+// Converts a source scene (.cmesh) to the scene file loadScene maps for this platform
+bool convertScene(const char* srcFileName, const char* dstFileName, uint32_t flags);
 void removeScene(Scene* scene);
 void CreateClusters(bool twoSided, const Scene* pScene, Mesh* mesh);
+// Copies the clusters of all meshes to pScene->clusterCullData. Call after CreateClusters was called for every mesh
+void createClusterCullData(Scene* pScene);
+void destroyClusterCullData(Scene* pScene);
+// Writes the mesh relative index of every cluster of the mesh that is visible from any of the views to pVisibleClusters
+// and returns the number of visible clusters
+uint32_t cullClusters(const ClusterCullData* pData, const Mesh* pMesh, const ClusterCullViews* pViews, uint32_t* pVisibleClusters);
+
+// Describes the triangles of the cluster as an occluder for the OcclusionRasterizer. The scene positions and indices are read in place
+void getClusterOccluderMesh(const Scene* pScene, const Mesh* pMesh, const ClusterCompact* pCluster, OccluderMesh* pOccluder);
 #if defined(METAL)
 void addClusterToBatchChunk(const ClusterCompact* cluster, const Mesh* mesh, uint32_t meshIdx, bool isTwoSided, FilterBatchChunk* batchChunk);
 #else
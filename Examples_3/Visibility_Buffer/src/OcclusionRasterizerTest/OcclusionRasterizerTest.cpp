@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Headless test and benchmark of the OcclusionRasterizer the Visibility Buffer culls its clusters with.
+// Random occluders are rasterized by the OcclusionRasterizer and by a scalar depth buffer that keeps the nearest depth of
+// every pixel. The tile layers only keep conservative depths, so they may find fewer boxes occluded than the reference
+// but never a box the reference sees. Every kernel variant and thread count has to report the same boxes.
+// Returns 0 when all checks pass, so the automated Linux tests run it like the samples.
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../../../Common_3/OS/Core/OcclusionRasterizer.h"
+#include "../../../../Common_3/OS/Core/CpuFeatures.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/ITimeManager.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+// Whole tiles, so the reference and the rasterizer use the same pixels
+#define TEST_WIDTH 256
+#define TEST_HEIGHT 128
+#define TEST_SCENES 8
+#define TEST_MESHES_PER_SCENE 40
+#define TEST_TRIANGLES_PER_MESH 100
+#define TEST_BOXES_PER_SCENE 20000
+#define BENCHMARK_ITERATIONS 20
+// Same as the rasterizer. Vertices nearer to the eye plane are not projected
+#define TEST_MIN_W 1e-4f
+// Reference depths are interpolated per pixel and the rasterizer derives its tile depths differently, so depths that
+// only differ by rounding are not counted as a false occlusion
+#define TEST_DEPTH_EPSILON 1e-6f
+
+typedef struct TestMesh
+{
+	tinystl::vector<float>    mPositions;
+	tinystl::vector<uint32_t> mIndices;
+	float                     mWorld[4][4];
+	bool                      mTwoSided;
+} TestMesh;
+
+typedef struct TestScene
+{
+	TestMesh              mMeshes[TEST_MESHES_PER_SCENE];
+	tinystl::vector<float> mBoxes;
+} TestScene;
+
+typedef struct TestConfig
+{
+	const char* pName;
+	uint32_t    mFeatureMask;
+	bool        mThreaded;
+} TestConfig;
+
+static ThreadPool gThreadPool;
+
+// Column major projection with the eye at the origin looking down +z and the near plane at z = 1: clip = (x, y, z - 1, z).
+// All its entries are 0 or 1, so every way of evaluating the transform gives the same clip coordinates
+static const float gViewProj[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 1 }, { 0, 0, -1, 0 } };
+
+static uint32_t gRandomState = 1;
+
+static float randomFloat(float minValue, float maxValue)
+{
+	gRandomState = gRandomState * 1664525u + 1013904223u;
+	return minValue + (maxValue - minValue) * (float)(gRandomState >> 8) / (float)(1 << 24);
+}
+
+// World position that projects to the normalized device coordinates x, y at depth z
+static void addPoint(tinystl::vector<float>& positions, float x, float y, float z)
+{
+	positions.push_back(x * z);
+	positions.push_back(y * z);
+	positions.push_back(z);
+}
+
+static void createScene(TestScene* pScene)
+{
+	for (uint32_t m = 0; m < TEST_MESHES_PER_SCENE; ++m)
+	{
+		TestMesh& mesh = pScene->mMeshes[m];
+		mesh.mPositions.clear();
+		mesh.mIndices.clear();
+		mesh.mTwoSided = (m % 3) == 0;
+
+		// A few meshes are moved by their world transform, a whole number so the transform stays exact
+		memset(mesh.mWorld, 0, sizeof(mesh.mWorld));
+		for (uint32_t i = 0; i < 4; ++i)
+			mesh.mWorld[i][i] = 1.0f;
+		if ((m % 4) == 1)
+			mesh.mWorld[3][2] = 2.0f;
+
+		for (uint32_t t = 0; t < TEST_TRIANGLES_PER_MESH; ++t)
+		{
+			// Mostly small triangles, some covering many tiles and some crossing the eye plane
+			const float z = randomFloat(2.0f, 40.0f);
+			const float size = (t % 10) == 0 ? randomFloat(0.3f, 1.2f) : randomFloat(0.01f, 0.2f);
+			const float x = randomFloat(-1.2f, 1.2f);
+			const float y = randomFloat(-1.2f, 1.2f);
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				const float vertexZ = (t % 50) == 7 && k == 0 ? -z : z * randomFloat(0.9f, 1.1f);
+				addPoint(mesh.mPositions, x + randomFloat(-size, size), y + randomFloat(-size, size), vertexZ);
+			}
+		}
+
+		// Odd meshes are indexed, with the triangles in reverse order
+		if (m & 1)
+		{
+			for (uint32_t t = 0; t < TEST_TRIANGLES_PER_MESH; ++t)
+			{
+				const uint32_t triangle = TEST_TRIANGLES_PER_MESH - 1 - t;
+				mesh.mIndices.push_back(triangle * 3);
+				mesh.mIndices.push_back(triangle * 3 + 1);
+				mesh.mIndices.push_back(triangle * 3 + 2);
+			}
+		}
+	}
+
+	pScene->mBoxes.resize(TEST_BOXES_PER_SCENE * 6);
+	for (uint32_t i = 0; i < TEST_BOXES_PER_SCENE; ++i)
+	{
+		float* pBox = &pScene->mBoxes[i * 6];
+		const float z = randomFloat(1.5f, 60.0f);
+		const float size = randomFloat(0.05f, 2.0f);
+		const float center[3] = { randomFloat(-1.3f, 1.3f) * z, randomFloat(-1.3f, 1.3f) * z, z };
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			pBox[k] = center[k] - size * randomFloat(0.2f, 1.0f);
+			pBox[3 + k] = center[k] + size * randomFloat(0.2f, 1.0f);
+		}
+	}
+}
+
+static void addSceneOccluders(OcclusionRasterizer* pRasterizer, const TestScene* pScene)
+{
+	for (uint32_t m = 0; m < TEST_MESHES_PER_SCENE; ++m)
+	{
+		const TestMesh& mesh = pScene->mMeshes[m];
+		OccluderMesh occluder = {};
+		occluder.pPositions = mesh.mPositions.data();
+		occluder.mVertexStride = 3 * sizeof(float);
+		occluder.pIndices = mesh.mIndices.empty() ? NULL : mesh.mIndices.data();
+		occluder.mTriangleCount = TEST_TRIANGLES_PER_MESH;
+		occluder.pWorld = &mesh.mWorld[0][0];
+		occluder.mTwoSided = mesh.mTwoSided;
+		addOccluderMesh(pRasterizer, &occluder);
+	}
+}
+/************************************************************************/
+// Scalar reference
+/************************************************************************/
+static bool projectReference(const float world[4][4], const float* p, float* pScreen)
+{
+	float worldPos[3];
+	for (uint32_t r = 0; r < 3; ++r)
+		worldPos[r] = world[0][r] * p[0] + world[1][r] * p[1] + world[2][r] * p[2] + world[3][r];
+
+	float clip[4];
+	for (uint32_t r = 0; r < 4; ++r)
+		clip[r] = gViewProj[0][r] * worldPos[0] + gViewProj[1][r] * worldPos[1] + gViewProj[2][r] * worldPos[2] + gViewProj[3][r];
+	if (clip[3] < TEST_MIN_W)
+		return false;
+
+	const float invW = 1.0f / clip[3];
+	pScreen[0] = (clip[0] * invW * 0.5f + 0.5f) * TEST_WIDTH;
+	pScreen[1] = (clip[1] * invW * 0.5f + 0.5f) * TEST_HEIGHT;
+	pScreen[2] = clip[2] * invW;
+	return true;
+}
+
+// Keeps the nearest depth at every pixel center the triangle covers. Coverage is evaluated like the rasterizer does,
+// from the edge functions at the first pixel center of the tile, so both agree on the pixels of a triangle
+static void rasterizeReferenceTriangle(float* pDepth, const float* v0, const float* v1, const float* v2, bool twoSided)
+{
+	float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+	if (area == 0.0f || (area < 0.0f && !twoSided))
+		return;
+	if (area < 0.0f)
+	{
+		const float* temp = v1;
+		v1 = v2;
+		v2 = temp;
+	}
+
+	const float x[3] = { v0[0], v1[0], v2[0] };
+	const float y[3] = { v0[1], v1[1], v2[1] };
+	const float z[3] = { v0[2], v1[2], v2[2] };
+	const float a[3] = { y[1] - y[2], y[2] - y[0], y[0] - y[1] };
+	const float b[3] = { x[2] - x[1], x[0] - x[2], x[1] - x[0] };
+	const float edgeX[3] = { x[1], x[2], x[0] };
+	const float edgeY[3] = { y[1], y[2], y[0] };
+	const float triangleArea = a[0] * (x[0] - x[1]) + b[0] * (y[0] - y[1]);
+
+	const int minX = (int)fmaxf(ceilf(fminf(x[0], fminf(x[1], x[2])) - 0.5f), 0.0f);
+	const int maxX = (int)fminf(floorf(fmaxf(x[0], fmaxf(x[1], x[2])) - 0.5f), TEST_WIDTH - 1.0f);
+	const int minY = (int)fmaxf(ceilf(fminf(y[0], fminf(y[1], y[2])) - 0.5f), 0.0f);
+	const int maxY = (int)fminf(floorf(fmaxf(y[0], fmaxf(y[1], y[2])) - 0.5f), TEST_HEIGHT - 1.0f);
+
+	for (int py = minY; py <= maxY; ++py)
+	{
+		const int tileY = py - py % OCCLUSION_TILE_HEIGHT;
+		for (int px = minX; px <= maxX; ++px)
+		{
+			const int tileX = px - px % OCCLUSION_TILE_WIDTH;
+			bool inside = true;
+			float w[3];
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				const float e = a[i] * ((float)tileX + 0.5f - edgeX[i]) + b[i] * ((float)tileY + 0.5f - edgeY[i]);
+				w[i] = (e + a[i] * (float)(px - tileX)) + b[i] * (float)(py - tileY);
+				inside = inside && w[i] >= 0.0f;
+			}
+			if (!inside)
+				continue;
+
+			// Barycentric interpolation, the depth after the perspective divide is affine in screen space
+			const float depth = (w[0] * z[0] + w[1] * z[1] + w[2] * z[2]) / triangleArea;
+			float& pixel = pDepth[py * TEST_WIDTH + px];
+			pixel = fminf(pixel, depth);
+		}
+	}
+}
+
+static void rasterizeReference(float* pDepth, const TestScene* pScene)
+{
+	for (uint32_t i = 0; i < TEST_WIDTH * TEST_HEIGHT; ++i)
+		pDepth[i] = FLT_MAX;
+
+	for (uint32_t m = 0; m < TEST_MESHES_PER_SCENE; ++m)
+	{
+		const TestMesh& mesh = pScene->mMeshes[m];
+		for (uint32_t t = 0; t < TEST_TRIANGLES_PER_MESH; ++t)
+		{
+			float screen[3][3];
+			bool projected = true;
+			for (uint32_t k = 0; k < 3 && projected; ++k)
+			{
+				const uint32_t index = mesh.mIndices.empty() ? t * 3 + k : mesh.mIndices[t * 3 + k];
+				projected = projectReference(mesh.mWorld, &mesh.mPositions[index * 3], screen[k]);
+			}
+			if (projected)
+				rasterizeReferenceTriangle(pDepth, screen[0], screen[1], screen[2], mesh.mTwoSided);
+		}
+	}
+}
+
+// Same rules as occlusionTestBox: boxes crossing the eye plane are visible, boxes outside of the view are occluded
+static bool testReferenceBox(const float* pDepth, const float* aabbMin, const float* aabbMax)
+{
+	const float identity[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+	float rect[4] = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+	float minZ = FLT_MAX;
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		const float corner[3] = { (i & 1) ? aabbMax[0] : aabbMin[0], (i & 2) ? aabbMax[1] : aabbMin[1], (i & 4) ? aabbMax[2] : aabbMin[2] };
+		float screen[3];
+		if (!projectReference(identity, corner, screen))
+			return false;
+		rect[0] = fminf(rect[0], screen[0]);
+		rect[1] = fminf(rect[1], screen[1]);
+		rect[2] = fmaxf(rect[2], screen[0]);
+		rect[3] = fmaxf(rect[3], screen[1]);
+		minZ = fminf(minZ, screen[2]);
+	}
+
+	if (rect[2] < 0.0f || rect[3] < 0.0f || rect[0] >= TEST_WIDTH || rect[1] >= TEST_HEIGHT)
+		return true;
+
+	const uint32_t pixelMinX = (uint32_t)fmaxf(rect[0], 0.0f);
+	const uint32_t pixelMinY = (uint32_t)fmaxf(rect[1], 0.0f);
+	const uint32_t pixelMaxX = (uint32_t)fminf(rect[2], TEST_WIDTH - 1.0f);
+	const uint32_t pixelMaxY = (uint32_t)fminf(rect[3], TEST_HEIGHT - 1.0f);
+	for (uint32_t y = pixelMinY; y <= pixelMaxY; ++y)
+	{
+		for (uint32_t x = pixelMinX; x <= pixelMaxX; ++x)
+		{
+			if (minZ + TEST_DEPTH_EPSILON <= pDepth[y * TEST_WIDTH + x])
+				return false;
+		}
+	}
+	return true;
+}
+/************************************************************************/
+// Test and benchmark
+/************************************************************************/
+static void runConfig(const TestConfig* pConfig, const TestScene* pScene, bool* pOccluded, float* pRasterizeMs, float* pTestMs)
+{
+	setCpuFeatureMask(pConfig->mFeatureMask);
+
+	OcclusionRasterizerDesc desc = {};
+	desc.mWidth = TEST_WIDTH;
+	desc.mHeight = TEST_HEIGHT;
+	desc.pThreadPool = pConfig->mThreaded ? &gThreadPool : NULL;
+	OcclusionRasterizer* pRasterizer = NULL;
+	addOcclusionRasterizer(&desc, &pRasterizer);
+
+	HiresTimer timer;
+	int64_t rasterizeUSec = 0;
+	int64_t testUSec = 0;
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; ++i)
+	{
+		timer.Reset();
+		beginOcclusionFrame(pRasterizer, &gViewProj[0][0]);
+		addSceneOccluders(pRasterizer, pScene);
+		rasterizeOccluders(pRasterizer);
+		rasterizeUSec += timer.GetUSec(true);
+		occlusionTestBoxes(pRasterizer, TEST_BOXES_PER_SCENE, &pScene->mBoxes[0], &pScene->mBoxes[3], 6 * sizeof(float), pOccluded);
+		testUSec += timer.GetUSec(true);
+	}
+
+	removeOcclusionRasterizer(pRasterizer);
+	setCpuFeatureMask(~0U);
+
+	*pRasterizeMs = (float)rasterizeUSec / (1000.0f * BENCHMARK_ITERATIONS);
+	*pTestMs = (float)testUSec / (1000.0f * BENCHMARK_ITERATIONS);
+}
+
+int main(int argc, char** argv)
+{
+	Thread::SetMainThread();
+	gThreadPool.CreateThreads(Thread::GetNumCPUCores() - 1);
+
+	const TestConfig configs[] = {
+		{ "Scalar, 1 thread", CPU_FEATURE_NONE, false },
+		{ "SSE, 1 thread", CPU_FEATURE_SSE2, false },
+		{ "Best, 1 thread", ~0U, false },
+		{ "Best, thread pool", ~0U, true },
+	};
+	const uint32_t configCount = sizeof(configs) / sizeof(configs[0]);
+	const uint32_t triangleCount = TEST_MESHES_PER_SCENE * TEST_TRIANGLES_PER_MESH;
+
+	TestScene* pScene = conf_placement_new<TestScene>(conf_calloc(1, sizeof(TestScene)));
+	float* pReferenceDepth = (float*)conf_malloc(TEST_WIDTH * TEST_HEIGHT * sizeof(float));
+	bool* pOccluded[configCount];
+	for (uint32_t c = 0; c < configCount; ++c)
+		pOccluded[c] = (bool*)conf_malloc(TEST_BOXES_PER_SCENE * sizeof(bool));
+
+	uint32_t falseOcclusions = 0;
+	uint32_t mismatches = 0;
+	uint32_t referenceOccluded = 0;
+	uint32_t occluded = 0;
+	float rasterizeMs[configCount] = {};
+	float testMs[configCount] = {};
+	float referenceMs = 0.0f;
+
+	for (uint32_t s = 0; s < TEST_SCENES; ++s)
+	{
+		gRandomState = s + 1;
+		createScene(pScene);
+
+		for (uint32_t c = 0; c < configCount; ++c)
+		{
+			float sceneRasterizeMs, sceneTestMs;
+			runConfig(&configs[c], pScene, pOccluded[c], &sceneRasterizeMs, &sceneTestMs);
+			rasterizeMs[c] += sceneRasterizeMs / TEST_SCENES;
+			testMs[c] += sceneTestMs / TEST_SCENES;
+		}
+
+		HiresTimer referenceTimer;
+		rasterizeReference(pReferenceDepth, pScene);
+		referenceMs += referenceTimer.GetUSec(false) / (1000.0f * TEST_SCENES);
+
+		for (uint32_t i = 0; i < TEST_BOXES_PER_SCENE; ++i)
+		{
+			const bool reference = testReferenceBox(pReferenceDepth, &pScene->mBoxes[i * 6], &pScene->mBoxes[i * 6 + 3]);
+			referenceOccluded += reference;
+			occluded += pOccluded[0][i];
+			if (pOccluded[0][i] && !reference)
+			{
+				if (falseOcclusions < 10)
+					printf("Scene %u box %u is occluded by the rasterizer but visible in the reference\n", s, i);
+				++falseOcclusions;
+			}
+			for (uint32_t c = 1; c < configCount; ++c)
+				mismatches += pOccluded[c][i] != pOccluded[0][i];
+		}
+	}
+
+	printf("%u scenes, %u occluder triangles and %u boxes each, %ux%u pixels\n", TEST_SCENES, triangleCount, TEST_BOXES_PER_SCENE, TEST_WIDTH, TEST_HEIGHT);
+	printf("Occluded boxes: %u reference, %u rasterizer (%.1f%% of the reference)\n", referenceOccluded, occluded,
+		100.0f * occluded / (float)(referenceOccluded ? referenceOccluded : 1));
+	printf("Scalar per pixel reference: %.3f ms rasterization, %.0f triangles/ms\n", referenceMs, triangleCount / referenceMs);
+	for (uint32_t c = 0; c < configCount; ++c)
+	{
+		printf("%-18s: %.3f ms rasterization (%.0f triangles/ms), %.3f ms box tests (%.0f boxes/ms)\n", configs[c].pName, rasterizeMs[c],
+			triangleCount / rasterizeMs[c], testMs[c], TEST_BOXES_PER_SCENE / testMs[c]);
+	}
+
+	for (uint32_t c = 0; c < configCount; ++c)
+		conf_free(pOccluded[c]);
+	conf_free(pReferenceDepth);
+	pScene->~TestScene();
+	conf_free(pScene);
+
+	bool passed = true;
+	if (falseOcclusions)
+	{
+		printf("FAILED: %u boxes the reference sees were occluded\n", falseOcclusions);
+		passed = false;
+	}
+	if (mismatches)
+	{
+		printf("FAILED: %u box results differ between kernel variants or thread counts\n", mismatches);
+		passed = false;
+	}
+	if (!referenceOccluded || !occluded)
+	{
+		printf("FAILED: the scenes do not occlude anything\n");
+		passed = false;
+	}
+	if (passed)
+		printf("PASSED\n");
+	return passed ? 0 : 1;
+}
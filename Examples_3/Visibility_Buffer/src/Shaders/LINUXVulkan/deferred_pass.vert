@@ -37,9 +37,9 @@ layout(set = 0, binding = 0) uniform uniforms
 };
 
 layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec2 iTexCoord;
-layout(location = 2) in vec3 iNormal;
-layout(location = 3) in vec3 iTangent;
+layout(location = 1) in uint iTexCoord;
+layout(location = 2) in uint iNormal;
+layout(location = 3) in uint iTangent;
 
 layout(location = 0) out vec2 oTexCoord;
 layout(location = 1) out vec3 oNormal;
@@ -50,9 +50,9 @@ void main()
 {
 	uint drawId = gl_DrawIDARB;
 	gl_Position = uniformsData.transform[VIEW_CAMERA].mvp * vec4(iPosition, 1);
-	oTexCoord = (iTexCoord);
-	oNormal = ((iNormal));
-	oTangent = ((iTangent));
+	oTexCoord = unpack2Floats(iTexCoord);
+	oNormal = decodeDir(unpackUnorm2x16(iNormal));
+	oTangent = decodeDir(unpackUnorm2x16(iTangent));
 	oDrawId = drawId;
 }
 
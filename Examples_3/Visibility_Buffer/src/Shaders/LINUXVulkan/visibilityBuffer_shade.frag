@@ -109,16 +109,6 @@ struct VertexPos
 	float x, y, z;
 };
 
-struct VertexNormal
-{
-	float x, y, z;
-};
-
-struct VertexTangent
-{
-	float x, y, z;
-};
-
 layout(std430, set = 0, binding = 0) readonly buffer vertexPos
 {
 	VertexPos vertexPosData[];
@@ -126,17 +116,17 @@ layout(std430, set = 0, binding = 0) readonly buffer vertexPos
 
 layout(std430, set = 0, binding = 1) readonly buffer vertexTexCoord
 {
-	vec2 vertexTexCoordData[];
+	uint vertexTexCoordData[];
 };
 
 layout(std430, set = 0, binding = 2) readonly buffer vertexNormal
 {
-	VertexNormal vertexNormalData[];
+	uint vertexNormalData[];
 };
 
 layout(std430, set = 0, binding = 3) readonly buffer vertexTangent
 {
-	VertexTangent vertexTangentData[];
+	uint vertexTangentData[];
 };
 
 layout(std430, set = 0, binding = 4) readonly buffer filteredIndexBuffer
@@ -278,9 +268,9 @@ void main()
 		// Apply perspective correction to texture coordinates
 		mat3x2 texCoords =
 		{
-			vertexTexCoordData[index0] * one_over_w[0],
-			vertexTexCoordData[index1] * one_over_w[1],
-			vertexTexCoordData[index2] * one_over_w[2]
+			unpack2Floats(vertexTexCoordData[index0]) * one_over_w[0],
+			unpack2Floats(vertexTexCoordData[index1]) * one_over_w[1],
+			unpack2Floats(vertexTexCoordData[index2]) * one_over_w[2]
 		};
 
 		// Interpolate texture coordinates and calculate the gradients for texture sampling with mipmapping support
@@ -291,31 +281,21 @@ void main()
 
 		// NORMAL INTERPOLATION
 		// Apply perspective division to normals
-		// Load normals
-		vec3 v0normal = vec3(vertexNormalData[index0].x, vertexNormalData[index0].y, vertexNormalData[index0].z);
-		vec3 v1normal = vec3(vertexNormalData[index1].x, vertexNormalData[index1].y, vertexNormalData[index1].z);
-		vec3 v2normal = vec3(vertexNormalData[index2].x, vertexNormalData[index2].y, vertexNormalData[index2].z);
-		
 		mat3x3 normals =
 		{
-			v0normal * one_over_w[0],
-			v1normal * one_over_w[1],
-			v2normal * one_over_w[2]
+			decodeDir(unpackUnorm2x16(vertexNormalData[index0])) * one_over_w[0],
+			decodeDir(unpackUnorm2x16(vertexNormalData[index1])) * one_over_w[1],
+			decodeDir(unpackUnorm2x16(vertexNormalData[index2])) * one_over_w[2]
 		};
 
 		vec3 normal = normalize(interpolateAttribute(normals, derivativesOut.db_dx, derivativesOut.db_dy, d));
 		// TANGENT INTERPOLATION
 		// Apply perspective division to tangents
-		// Load tangents
-		vec3 v0tan = vec3(vertexTangentData[index0].x, vertexTangentData[index0].y, vertexTangentData[index0].z);
-		vec3 v1tan = vec3(vertexTangentData[index1].x, vertexTangentData[index1].y, vertexTangentData[index1].z);
-		vec3 v2tan = vec3(vertexTangentData[index2].x, vertexTangentData[index2].y, vertexTangentData[index2].z);
-		
 		mat3x3 tangents =
 		{
-			v0tan * one_over_w[0],
-			v1tan * one_over_w[1],
-			v2tan * one_over_w[2]
+			decodeDir(unpackUnorm2x16(vertexTangentData[index0])) * one_over_w[0],
+			decodeDir(unpackUnorm2x16(vertexTangentData[index1])) * one_over_w[1],
+			decodeDir(unpackUnorm2x16(vertexTangentData[index2])) * one_over_w[2]
 		};
 
 		vec3 tangent = normalize(interpolateAttribute(tangents, derivativesOut.db_dx, derivativesOut.db_dy, d));
@@ -34,17 +34,32 @@ struct PackedVertexPosData {
 };
 
 struct PackedVertexTexcoord {
-    packed_float2 texCoord;
+    uint texCoord;
 };
 
 struct PackedVertexNormal {
-    packed_float3 normal;
+    uint normal;
 };
 
 struct PackedVertexTangent {
-    packed_float3 tangent;
+    uint tangent;
 };
 
+// Texture coordinates are stored as half2, normals and tangents as octahedral unorm16x2
+float2 unpackTexCoord(uint texCoord)
+{
+    return float2(as_type<half2>(texCoord));
+}
+
+float3 decodeDir(uint packedDir)
+{
+    float2 encN = unpack_unorm2x16_to_float(packedDir) * 2.0 - 1.0;
+    float3 n = float3(encN, 1.0 - abs(encN.x) - abs(encN.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * select(float2(-1.0), float2(1.0), n.xy >= 0.0);
+    return normalize(n);
+}
+
 struct VSOutput {
 	float4 position [[position]];
     float2 texCoord;
@@ -109,9 +124,9 @@ vertex VSOutput stageMain(uint vertexId                                     [[ve
     // Output data to the pixel shader
 	VSOutput result;
     result.position = uniforms.transform[VIEW_CAMERA].mvp * float4(vertPos.position, 1.0f);
-    result.texCoord = vertTexcoord.texCoord;
-    result.normal = vertNormal.normal;
-    result.tangent = vertTangent.tangent;
+    result.texCoord = unpackTexCoord(vertTexcoord.texCoord);
+    result.normal = decodeDir(vertNormal.normal);
+    result.tangent = decodeDir(vertTangent.tangent);
     result.twoSided = perBatch.twoSided;
 	return result;
 }
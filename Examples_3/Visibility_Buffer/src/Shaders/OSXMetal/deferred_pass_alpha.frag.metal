@@ -32,15 +32,15 @@ struct PackedVertexPosData {
 };
 
 struct PackedVertexTexcoord {
-    packed_float2 texCoord;
+    uint texCoord;
 };
 
 struct PackedVertexNormal {
-    packed_float3 normal;
+    uint normal;
 };
 
 struct PackedVertexTangent {
-    packed_float3 tangent;
+    uint tangent;
 };
 
 struct VSOutput {
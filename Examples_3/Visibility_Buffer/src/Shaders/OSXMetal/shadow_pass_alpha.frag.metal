@@ -30,7 +30,7 @@ struct PackedVertexPosData {
 };
 
 struct PackedVertexTexcoord {
-    packed_float2 texCoord;
+    uint texCoord;
 };
 
 struct VSOut {
@@ -32,9 +32,15 @@ struct PackedVertexPosData {
 };
 
 struct PackedVertexTexcoord {
-    packed_float2 texCoord;
+    uint texCoord;
 };
 
+// Texture coordinates are stored as half2
+float2 unpackTexCoord(uint texCoord)
+{
+    return float2(as_type<half2>(texCoord));
+}
+
 struct VSOut {
     float4 position [[position]];
     float2 texCoord;
@@ -82,6 +88,6 @@ vertex VSOut stageMain(uint vertexId                                    [[vertex
     
     VSOut output;
     output.position = uniforms.transform[VIEW_SHADOW].mvp * float4(vertPos.position, 1.0f);
-    output.texCoord = vertTexcoord.texCoord;
+    output.texCoord = unpackTexCoord(vertTexcoord.texCoord);
     return output;
 }
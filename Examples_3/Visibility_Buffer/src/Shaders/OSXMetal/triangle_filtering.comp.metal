@@ -48,9 +48,9 @@ struct SceneVertexPos
 
 struct SceneVertexAttr
 {
-    packed_float2 texCoord;
-    packed_float3 normal;
-    packed_float3 tangents;
+    uint texCoord;
+    uint normal;
+    uint tangents;
 };
 
 struct BatchData
@@ -34,9 +34,15 @@ struct PackedVertexPosData {
 };
 
 struct PackedVertexTexcoord {
-    packed_float2 texCoord;
+    uint texCoord;
 };
 
+// Texture coordinates are stored as half2
+float2 unpackTexCoord(uint texCoord)
+{
+    return float2(as_type<half2>(texCoord));
+}
+
 struct VSOutput {
 	float4 position [[position]];
     float2 texCoord;
@@ -87,7 +93,7 @@ vertex VSOutput stageMain(uint vertexId                                    [[ver
     // Output data to the pixel shader
 	VSOutput result;
     result.position = uniforms.transform[VIEW_CAMERA].mvp * float4(vertPos.position, 1.0f);
-    result.texCoord = vertTexcoord.texCoord;
+    result.texCoord = unpackTexCoord(vertTexcoord.texCoord);
     result.triangleID = triangleId;
 	return result;
 }
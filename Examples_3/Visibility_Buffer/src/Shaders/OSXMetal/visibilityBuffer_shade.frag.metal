@@ -39,17 +39,32 @@ struct SceneVertexPos
 };
 
 struct SceneVertexTexcoord {
-    packed_float2 texCoord;
+    uint texCoord;
 };
 
 struct SceneVertexNormal {
-    packed_float3 normal;
+    uint normal;
 };
 
 struct SceneVertexTangent {
-    packed_float3 tangent;
+    uint tangent;
 };
 
+// Texture coordinates are stored as half2, normals and tangents as octahedral unorm16x2
+float2 unpackTexCoord(uint texCoord)
+{
+    return float2(as_type<half2>(texCoord));
+}
+
+float3 decodeDir(uint packedDir)
+{
+    float2 encN = unpack_unorm2x16_to_float(packedDir) * 2.0 - 1.0;
+    float3 n = float3(encN, 1.0 - abs(encN.x) - abs(encN.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * select(float2(-1.0), float2(1.0), n.xy >= 0.0);
+    return normalize(n);
+}
+
 struct VSOutput {
 	float4 position [[position]];
     float2 screenPos;
@@ -228,9 +243,9 @@ fragment float4 stageMain(VSOutput input                                       [
         // TEXTURE COORD INTERPOLATION
         // Apply perspective correction to texture coordinates
         float3x2 texCoords = {
-            float2(vertexTexCoord[vertexId0].texCoord) * one_over_w[0],
-            float2(vertexTexCoord[vertexId1].texCoord) * one_over_w[1],
-            float2(vertexTexCoord[vertexId2].texCoord) * one_over_w[2]
+            unpackTexCoord(vertexTexCoord[vertexId0].texCoord) * one_over_w[0],
+            unpackTexCoord(vertexTexCoord[vertexId1].texCoord) * one_over_w[1],
+            unpackTexCoord(vertexTexCoord[vertexId2].texCoord) * one_over_w[2]
         };
         
         // Interpolate texture coordinates and calculate the gradients for texture sampling with mipmapping support
@@ -242,9 +257,9 @@ fragment float4 stageMain(VSOutput input                                       [
         // NORMAL INTERPOLATION
         // Apply perspective division to normals
         float3x3 normals = {
-            float3(vertexNormal[vertexId0].normal) * one_over_w[0],
-            float3(vertexNormal[vertexId1].normal) * one_over_w[1],
-            float3(vertexNormal[vertexId2].normal) * one_over_w[2]
+            decodeDir(vertexNormal[vertexId0].normal) * one_over_w[0],
+            decodeDir(vertexNormal[vertexId1].normal) * one_over_w[1],
+            decodeDir(vertexNormal[vertexId2].normal) * one_over_w[2]
         };
         
         float3 normal = normalize(interpolateAttribute(normals, derivativesOut.db_dx, derivativesOut.db_dy, d));
@@ -252,9 +267,9 @@ fragment float4 stageMain(VSOutput input                                       [
         // TANGENT INTERPOLATION
         // Apply perspective division to tangents
         float3x3 tangents = {
-            float3(vertexTangent[vertexId0].tangent) * one_over_w[0],
-            float3(vertexTangent[vertexId1].tangent) * one_over_w[1],
-            float3(vertexTangent[vertexId2].tangent) * one_over_w[2]
+            decodeDir(vertexTangent[vertexId0].tangent) * one_over_w[0],
+            decodeDir(vertexTangent[vertexId1].tangent) * one_over_w[1],
+            decodeDir(vertexTangent[vertexId2].tangent) * one_over_w[2]
         };
         
         float3 tangent = normalize(interpolateAttribute(tangents, derivativesOut.db_dx, derivativesOut.db_dy, d));
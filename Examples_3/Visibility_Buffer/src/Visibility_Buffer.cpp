@@ -34,6 +34,7 @@
 #include "../../../Common_3/OS/Interfaces/ILogManager.h"
 #include "../../../Common_3/OS/Interfaces/IFileSystem.h"
 #include "../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../Common_3/OS/Interfaces/IProfiler.h"
 #include "../../../Common_3/OS/Interfaces/ITimeManager.h"
 #include "../../../Common_3/OS/Interfaces/ICameraController.h"
 #include "../../../Common_3/OS/Interfaces/IApp.h"
@@ -155,6 +156,8 @@ typedef struct AppSettings
 	// Turns off cluster culling by default
 	// Cluster culling increases CPU time and does not provide enough benefit in terms of culling results to keep it enabled by default
 	bool mClusterCulling = false;
+	// Culls the clusters hidden behind the occluders rasterized on the CPU. Only applies when cluster culling is enabled
+	bool mOcclusionCulling = false;
 
 	bool mAsyncCompute = true;
 
@@ -218,6 +221,7 @@ struct PerFrameData
 	// These are just used for statistical information
 	uint32_t gTotalClusters = 0;
 	uint32_t gCulledClusters = 0;
+	uint32_t gOcclusionCulledClusters = 0;
 	uint32_t gDrawCount[gNumGeomSets];
 };
 
@@ -441,6 +445,45 @@ FilterBatchChunk*			   pFilterBatchChunk[gImageCount][gSmallBatchChunkCount] = {
 UniformRingBuffer*			  pFilterBatchDataBuffer[gImageCount] = { nullptr };
 #endif
 /************************************************************************/
+// CPU cluster culling data
+/************************************************************************/
+typedef struct ClusterCullTask
+{
+	uint32_t mMeshStart;
+	uint32_t mMeshEnd;
+	uint32_t mCulledClusters;
+	uint32_t mOccludedClusters;
+} ClusterCullTask;
+
+const uint32_t				  gMaxClusterCullTasks = 64;
+// Below this many clusters the culling runs on the calling thread
+const uint32_t				  gMinParallelCullClusters = 4096;
+ThreadPool					  gThreadSystem;
+ClusterCullTask				 gClusterCullTasks[gMaxClusterCullTasks] = {};
+WorkItem						gClusterCullWorkItems[gMaxClusterCullTasks];
+uint32_t						gClusterCullTaskCount = 0;
+ClusterCullViews				gClusterCullViews = {};
+bool							gClusterCullEnabled = false;
+// Visible clusters of every mesh starting at mesh->clusterCullOffset, written by the task owning the mesh
+uint32_t*					   pVisibleClusters = nullptr;
+uint32_t*					   pVisibleClusterCounts = nullptr;
+/************************************************************************/
+// CPU occlusion culling data
+/************************************************************************/
+// Size of the occlusion buffer of each view
+const uint32_t				  gOcclusionBufferSize[gNumViews][2] = { { 256, 256 }, { 256, 128 } };
+// Occluder triangles rasterized per view and frame
+const uint32_t				  gMaxOccluderTriangles = 128 * 1024;
+OcclusionRasterizer*			pOcclusionRasterizers[gNumViews] = {};
+// False until the occluders of a frame were rasterized into the buffer of the view
+bool							gOcclusionBufferValid[gNumViews] = {};
+bool							gOcclusionCullEnabled = false;
+WorkItem						gClusterRetestWorkItems[gMaxClusterCullTasks];
+// Clusters of every mesh rejected by the occlusion buffers of the last frame, stored like pVisibleClusters.
+// After the retest only the ones that turned out visible are left
+uint32_t*					   pOccludedClusters = nullptr;
+uint32_t*					   pOccludedClusterCounts = nullptr;
+/************************************************************************/
 // GPU Profilers
 /************************************************************************/
 GpuProfiler*					pGraphicsGpuProfiler =  nullptr;
@@ -464,6 +507,11 @@ uint32_t						gResolutionIndex = 0;
 bool							gResolutionChange = false;
 #endif
 /************************************************************************/
+// Frame profiler capture
+/************************************************************************/
+bool							gExportProfile = false;
+bool							gMeasureProfilerOverhead = false;
+/************************************************************************/
 /************************************************************************/
 class VisibilityBuffer*		 pVisibilityBuffer = nullptr;
 /************************************************************************/
@@ -519,6 +567,11 @@ class VisibilityBuffer : public IApp
 public:
 	bool Init()
 	{
+		initProfiler();
+		setProfilerThreadName("Main");
+
+		gThreadSystem.CreateThreads(Thread::GetNumCPUCores() - 1);
+
 		// Overwrite rootpath is required because Textures and meshes are not in /Textures and /Meshes.
 		// We need to set the modified root path so that filesystem can find the meshes and textures.
 		FileSystem::SetRootPath(FSRoot::FSR_Meshes, "/");
@@ -628,14 +681,14 @@ public:
 		addSampler(pRenderer, &bilinearDesc, &pSamplerBilinear);
 		addSampler(pRenderer, &pointDesc, &pSamplerPointClamp);
 		/************************************************************************/
-		// Load the scene using the SceneLoader class, which uses Assimp
+		// Load the scene file. The source scene is converted the first time
 		/************************************************************************/
 		HiresTimer sceneLoadTimer;
 		tinystl::string sceneFullPath = FileSystem::FixPath(gSceneName, FSRoot::FSR_Meshes);
 		pScene = loadScene(sceneFullPath.c_str());
 		if (!pScene)
 			return false;
-		LOGINFOF("Load assimp scene : %f ms", sceneLoadTimer.GetUSec(true) / 1000.0f);
+		LOGINFOF("Load scene : %f ms", sceneLoadTimer.GetUSec(true) / 1000.0f);
 		/************************************************************************/
 		// IA buffers
 		/************************************************************************/
@@ -650,7 +703,7 @@ public:
 		ibDesc.mDesc.mElementCount = pScene->totalTriangles;
 		ibDesc.mDesc.mStructStride = sizeof(uint32_t);
 		ibDesc.mDesc.mSize = ibDesc.mDesc.mElementCount * ibDesc.mDesc.mStructStride;
-		ibDesc.pData = pScene->indices.data();
+		ibDesc.pData = pScene->indices;
 		ibDesc.ppBuffer = &pIndexBufferAll;
 		ibDesc.mDesc.pDebugName = L"Non-filtered Index Buffer Desc";
 		addResource(&ibDesc);
@@ -685,7 +738,7 @@ public:
 		vbPosDesc.mDesc.mElementCount = pScene->totalVertices;
 		vbPosDesc.mDesc.mStructStride = sizeof(SceneVertexPos);
 		vbPosDesc.mDesc.mSize = vbPosDesc.mDesc.mElementCount * vbPosDesc.mDesc.mStructStride;
-		vbPosDesc.pData = pScene->positions.data();
+		vbPosDesc.pData = pScene->positions;
 		vbPosDesc.ppBuffer = &pVertexBufferPosition;
 		vbPosDesc.mDesc.pDebugName = L"Vertex Position Buffer Desc";
 		addResource(&vbPosDesc);
@@ -698,7 +751,7 @@ public:
 		vbTexCoordDesc.mDesc.mElementCount = pScene->totalVertices * (sizeof(SceneVertexTexCoord) / sizeof(uint32_t));
 		vbTexCoordDesc.mDesc.mStructStride = sizeof(uint32_t);
 		vbTexCoordDesc.mDesc.mSize = vbTexCoordDesc.mDesc.mElementCount * vbTexCoordDesc.mDesc.mStructStride;
-		vbTexCoordDesc.pData = pScene->texCoords.data();
+		vbTexCoordDesc.pData = pScene->texCoords;
 		vbTexCoordDesc.ppBuffer = &pVertexBufferTexCoord;
 		vbTexCoordDesc.mDesc.pDebugName = L"Vertex TexCoord Buffer Desc";
 		addResource(&vbTexCoordDesc);
@@ -711,7 +764,7 @@ public:
 		vbNormalDesc.mDesc.mElementCount = pScene->totalVertices * (sizeof(SceneVertexNormal) / sizeof(uint32_t));
 		vbNormalDesc.mDesc.mStructStride = sizeof(uint32_t);
 		vbNormalDesc.mDesc.mSize = vbNormalDesc.mDesc.mElementCount * vbNormalDesc.mDesc.mStructStride;
-		vbNormalDesc.pData = pScene->normals.data();
+		vbNormalDesc.pData = pScene->normals;
 		vbNormalDesc.ppBuffer = &pVertexBufferNormal;
 		vbNormalDesc.mDesc.pDebugName = L"Vertex Normal Buffer Desc";
 		addResource(&vbNormalDesc);
@@ -724,7 +777,7 @@ public:
 		vbTangentDesc.mDesc.mElementCount = pScene->totalVertices * (sizeof(SceneVertexTangent) / sizeof(uint32_t));
 		vbTangentDesc.mDesc.mStructStride = sizeof(uint32_t);
 		vbTangentDesc.mDesc.mSize = vbTangentDesc.mDesc.mElementCount * vbTangentDesc.mDesc.mStructStride;
-		vbTangentDesc.pData = pScene->tangents.data();
+		vbTangentDesc.pData = pScene->tangents;
 		vbTangentDesc.ppBuffer = &pVertexBufferTangent;
 		vbTangentDesc.mDesc.pDebugName = L"Vertex Tangent Buffer Desc";
 		addResource(&vbTangentDesc);
@@ -733,15 +786,19 @@ public:
 		/************************************************************************/
 		// Cluster creation
 		/************************************************************************/
+		// Clusters and their bounds come with the scene. Only the culling layout is set up here
 		HiresTimer clusterTimer;
-		// Calculate clusters
-		for (uint32_t i = 0; i < pScene->numMeshes; ++i)
+		createClusterCullData(pScene);
+		createClusterCullTasks();
+		for (uint32_t i = 0; i < gNumViews; ++i)
 		{
-			Mesh* mesh = pScene->meshes + i;
-			Material* material = pScene->materials + mesh->materialId;
-			CreateClusters(material->twoSided, pScene, mesh);
+			OcclusionRasterizerDesc occlusionDesc = {};
+			occlusionDesc.mWidth = gOcclusionBufferSize[i][0];
+			occlusionDesc.mHeight = gOcclusionBufferSize[i][1];
+			occlusionDesc.pThreadPool = &gThreadSystem;
+			addOcclusionRasterizer(&occlusionDesc, &pOcclusionRasterizers[i]);
 		}
-		LOGINFOF("Load clusters : %f ms", clusterTimer.GetUSec(true) / 1000.0f);
+		LOGINFOF("Setup cluster culling : %f ms", clusterTimer.GetUSec(true) / 1000.0f);
 		/************************************************************************/
 		// Texture loading
 		/************************************************************************/
@@ -750,30 +807,33 @@ public:
 		gNormalMaps = tinystl::vector<Texture*>(pScene->numMaterials);
 		gSpecularMaps = tinystl::vector<Texture*>(pScene->numMaterials);
 
+		// The texture files are read asynchronously while the previous textures are decoded and uploaded
+		tinystl::vector<TextureLoadDesc> textureLoadDescs(pScene->numMaterials * 3);
 		for (uint32_t i = 0; i < pScene->numMaterials; ++i)
 		{
-			TextureLoadDesc diffuse = {};
+			TextureLoadDesc& diffuse = textureLoadDescs[i * 3 + 0];
+			diffuse = {};
 			diffuse.pFilename = pScene->textures[i];
 			diffuse.mRoot = FSR_Textures;
 			diffuse.mUseMipmaps = true;
 			diffuse.ppTexture = &gDiffuseMaps[i];
 			diffuse.mSrgb = true;
-			addResource(&diffuse);
 
-			TextureLoadDesc normal = {};
+			TextureLoadDesc& normal = textureLoadDescs[i * 3 + 1];
+			normal = {};
 			normal.pFilename = pScene->normalMaps[i];
 			normal.mRoot = FSR_Textures;
 			normal.mUseMipmaps = true;
 			normal.ppTexture = &gNormalMaps[i];
-			addResource(&normal);
 
-			TextureLoadDesc specular = {};
+			TextureLoadDesc& specular = textureLoadDescs[i * 3 + 2];
+			specular = {};
 			specular.pFilename = pScene->specularMaps[i];
 			specular.mRoot = FSR_Textures;
 			specular.mUseMipmaps = true;
 			specular.ppTexture = &gSpecularMaps[i];
-			addResource(&specular);
 		}
+		addResources((uint32_t)textureLoadDescs.size(), textureLoadDescs.data());
 
 		LOGINFOF("Load textures : %f ms", textureLoadTimer.GetUSec(true) / 1000.0f);
 		/************************************************************************/
@@ -988,6 +1048,9 @@ public:
 		CheckboxWidget cluster("Cluster Culling", &gAppSettings.mClusterCulling);
 		pGuiWindow->AddWidget(cluster);
 
+		CheckboxWidget occlusion("Occlusion Culling", &gAppSettings.mOcclusionCulling);
+		pGuiWindow->AddWidget(occlusion);
+
 		CheckboxWidget asyncCompute("Async Compute", &gAppSettings.mAsyncCompute);
 		pGuiWindow->AddWidget(asyncCompute);
 
@@ -1009,6 +1072,14 @@ public:
 		if (gAppSettings.mEnableHDAO)
 			gAppSettings.mDynamicUIControlsAO.ShowDynamicProperties(pGuiWindow);
 
+		ButtonWidget exportProfile("Export Profile (Chrome Trace)");
+		exportProfile.pOnEdited = []() { gExportProfile = true; };
+		pGuiWindow->AddWidget(exportProfile);
+
+		ButtonWidget measureProfiler("Measure Profiler Overhead");
+		measureProfiler.pOnEdited = []() { gMeasureProfilerOverhead = true; };
+		pGuiWindow->AddWidget(measureProfiler);
+
 #if !defined(_DURANGO) && !defined(METAL) && !defined(__linux__)
 		if (!pWindow->fullScreen)
 			pGuiWindow->RemoveWidget(gResolutionProperty);
@@ -1126,11 +1197,13 @@ public:
 		removeResource(pVertexBufferTangent);
 
 		// Destroy clusters
-		for (uint32_t i = 0; i < pScene->numMeshes; ++i)
-		{
-			conf_free(pScene->meshes[i].clusters);
-			conf_free(pScene->meshes[i].clusterCompacts);
-		}
+		destroyClusterCullData(pScene);
+		conf_free(pVisibleClusters);
+		conf_free(pVisibleClusterCounts);
+		conf_free(pOccludedClusters);
+		conf_free(pOccludedClusterCounts);
+		for (uint32_t i = 0; i < gNumViews; ++i)
+			removeOcclusionRasterizer(pOcclusionRasterizers[i]);
 		// Remove Textures
 		for (uint32_t i = 0; i < pScene->numMaterials; ++i)
 		{
@@ -1188,6 +1261,8 @@ public:
 
 		removeResourceLoaderInterface(pRenderer);
 		removeRenderer(pRenderer);
+
+		exitProfiler();
 	}
 
 	// Setup the render targets used in this demo.
@@ -1209,46 +1284,6 @@ public:
 		// Vertex layout used by all geometry passes (shadow, visibility, deferred)
 		/************************************************************************/
 #if !defined(METAL)
-#if defined(__linux__)
-		VertexLayout vertexLayout = {};
-		vertexLayout.mAttribCount = 4;
-		vertexLayout.mAttribs[0].mSemantic = SEMANTIC_POSITION;
-		vertexLayout.mAttribs[0].mFormat = ImageFormat::RGB32F;
-		vertexLayout.mAttribs[0].mBinding = 0;
-		vertexLayout.mAttribs[0].mLocation = 0;
-		vertexLayout.mAttribs[1].mSemantic = SEMANTIC_TEXCOORD0;
-		vertexLayout.mAttribs[1].mFormat = ImageFormat::RG32F;
-		vertexLayout.mAttribs[1].mBinding = 1;
-		vertexLayout.mAttribs[1].mLocation = 1;
-		vertexLayout.mAttribs[2].mSemantic = SEMANTIC_NORMAL;
-		vertexLayout.mAttribs[2].mFormat = ImageFormat::RGB32F;
-		vertexLayout.mAttribs[2].mBinding = 2;
-		vertexLayout.mAttribs[2].mLocation = 2;
-		vertexLayout.mAttribs[3].mSemantic = SEMANTIC_TANGENT;
-		vertexLayout.mAttribs[3].mFormat = ImageFormat::RGB32F;
-		vertexLayout.mAttribs[3].mBinding = 3;
-		vertexLayout.mAttribs[3].mLocation = 3;
-
-		VertexLayout vertexLayoutPosAndTex = {};
-		vertexLayoutPosAndTex.mAttribCount = 2;
-		vertexLayoutPosAndTex.mAttribs[0].mSemantic = SEMANTIC_POSITION;
-		vertexLayoutPosAndTex.mAttribs[0].mFormat = ImageFormat::RGB32F;
-		vertexLayoutPosAndTex.mAttribs[0].mBinding = 0;
-		vertexLayoutPosAndTex.mAttribs[0].mLocation = 0;
-		vertexLayoutPosAndTex.mAttribs[1].mSemantic = SEMANTIC_TEXCOORD0;
-		vertexLayoutPosAndTex.mAttribs[1].mFormat = ImageFormat::RG32F;
-		vertexLayoutPosAndTex.mAttribs[1].mBinding = 1;
-		vertexLayoutPosAndTex.mAttribs[1].mLocation = 1;
-
-		// Position only vertex stream that is used in shadow opaque pass
-		VertexLayout vertexLayoutPositionOnly = {};
-		vertexLayoutPositionOnly.mAttribCount = 1;
-		vertexLayoutPositionOnly.mAttribs[0].mSemantic = SEMANTIC_POSITION;
-		vertexLayoutPositionOnly.mAttribs[0].mFormat = ImageFormat::RGB32F;
-		vertexLayoutPositionOnly.mAttribs[0].mBinding = 0;
-		vertexLayoutPositionOnly.mAttribs[0].mLocation = 0;
-		vertexLayoutPositionOnly.mAttribs[0].mOffset = 0;
-#else
 		VertexLayout vertexLayout = {};
 		vertexLayout.mAttribCount = 4;
 		vertexLayout.mAttribs[0].mSemantic = SEMANTIC_POSITION;
@@ -1287,7 +1322,6 @@ public:
 		vertexLayoutPositionOnly.mAttribs[0].mBinding = 0;
 		vertexLayoutPositionOnly.mAttribs[0].mLocation = 0;
 		vertexLayoutPositionOnly.mAttribs[0].mOffset = 0;
-#endif
 #endif
 		/************************************************************************/
 		// Setup the Shadow Pass Pipeline
@@ -1598,6 +1632,21 @@ public:
 
 	void Update(float deltaTime)
 	{
+		// Export between frames so no zone is half recorded
+		if (gExportProfile)
+		{
+			gExportProfile = false;
+			exportProfileChromeTrace("VisibilityBuffer.trace.json");
+		}
+
+		if (gMeasureProfilerOverhead)
+		{
+			gMeasureProfilerOverhead = false;
+			LOGINFOF("Profiler zone overhead: %.1f ns per begin/end pair", measureProfilerOverhead());
+		}
+
+		PROFILE_SCOPE("Update");
+
 #if !defined(TARGET_IOS) && !defined(_DURANGO)
 		if (pSwapChain->mDesc.mEnableVsync != gToggleVSync)
 		{
@@ -1631,6 +1680,8 @@ public:
 
 	void Draw()
 	{
+		PROFILE_SCOPE("Draw");
+
 		gRenderFrameIdx = (gRenderFrameIdx + 1) % gImageCount;
 
 		if (!gAppSettings.mAsyncCompute || gFrameCount > 0)
@@ -1833,6 +1884,7 @@ public:
 		}
 
 		++gFrameCount;
+		profileFrameMarker();
 	}
 
 	tinystl::string GetName()
@@ -3451,28 +3503,250 @@ public:
 	}
 #endif
 
-	// Determines if the cluster can be safely culled performing quick cone-based test on the CPU.
-	// Since the triangle filtering kernel operates with 2 views in the same pass, this method must
-	// only cull those clusters that are not visible from ANY of the views (camera and shadow views).
-	bool cullCluster(const Cluster* cluster, vec3 eyes[gNumViews])
+	// Splits the meshes in ranges of about the same cluster count. Each range is culled by one work item
+	void createClusterCullTasks()
+	{
+		const uint32_t totalClusters = pScene->clusterCullData.clusterCount;
+		const uint32_t taskCount = min(gMaxClusterCullTasks, (gThreadSystem.GetNumThreads() + 1) * 4);
+		const uint32_t clustersPerTask = max(totalClusters / taskCount, 1U);
+
+		gClusterCullTaskCount = 0;
+		uint32_t meshStart = 0;
+		uint32_t clusterCount = 0;
+		for (uint32_t i = 0; i < pScene->numMeshes; ++i)
+		{
+			clusterCount += pScene->meshes[i].clusterCount;
+			if (clusterCount >= clustersPerTask && gClusterCullTaskCount < gMaxClusterCullTasks - 1)
+			{
+				gClusterCullTasks[gClusterCullTaskCount++] = { meshStart, i + 1, 0, 0 };
+				meshStart = i + 1;
+				clusterCount = 0;
+			}
+		}
+		if (meshStart < pScene->numMeshes)
+			gClusterCullTasks[gClusterCullTaskCount++] = { meshStart, pScene->numMeshes, 0, 0 };
+
+		for (uint32_t i = 0; i < gClusterCullTaskCount; ++i)
+		{
+			gClusterCullWorkItems[i].pFunc = cullClustersTask;
+			gClusterCullWorkItems[i].pData = &gClusterCullTasks[i];
+			gClusterRetestWorkItems[i].pFunc = retestOccludedClustersTask;
+			gClusterRetestWorkItems[i].pData = &gClusterCullTasks[i];
+		}
+
+		pVisibleClusters = (uint32_t*)conf_malloc(max(totalClusters, 1U) * sizeof(uint32_t));
+		pVisibleClusterCounts = (uint32_t*)conf_calloc(max(pScene->numMeshes, 1U), sizeof(uint32_t));
+		pOccludedClusters = (uint32_t*)conf_malloc(max(totalClusters, 1U) * sizeof(uint32_t));
+		pOccludedClusterCounts = (uint32_t*)conf_calloc(max(pScene->numMeshes, 1U), sizeof(uint32_t));
+	}
+
+	// A box is hidden when it is outside of or occluded in every view, since the views share the filtered clusters
+	static bool isBoxOccludedInAllViews(const float3& aabbMin, const float3& aabbMax)
+	{
+		for (uint32_t v = 0; v < gNumViews; ++v)
+		{
+			if (!gOcclusionBufferValid[v] || !occlusionTestBox(pOcclusionRasterizers[v], &aabbMin.x, &aabbMax.x))
+				return false;
+		}
+		return true;
+	}
+
+	static void cullClustersTask(void* pData)
+	{
+		ClusterCullTask* pTask = (ClusterCullTask*)pData;
+		pTask->mCulledClusters = 0;
+
+		for (uint32_t i = pTask->mMeshStart; i < pTask->mMeshEnd; ++i)
+		{
+			const Mesh* mesh = &pScene->meshes[i];
+			uint32_t* pMeshVisibleClusters = pVisibleClusters + mesh->clusterCullOffset;
+
+			if (gClusterCullEnabled)
+			{
+				pVisibleClusterCounts[i] = cullClusters(&pScene->clusterCullData, mesh, &gClusterCullViews, pMeshVisibleClusters);
+			}
+			else
+			{
+				for (uint32_t j = 0; j < mesh->clusterCount; ++j)
+					pMeshVisibleClusters[j] = j;
+				pVisibleClusterCounts[i] = mesh->clusterCount;
+			}
+
+			pTask->mCulledClusters += mesh->clusterCount - pVisibleClusterCounts[i];
+
+			// First phase of the occlusion culling: the occlusion buffers still hold the occluders of the last frame.
+			// The rejected clusters are tested again once the buffers were rebuilt from the clusters visible now
+			pOccludedClusterCounts[i] = 0;
+			if (gOcclusionCullEnabled)
+			{
+				const bool meshOccluded = isBoxOccludedInAllViews(mesh->minBBox, mesh->maxBBox);
+				uint32_t* pMeshOccludedClusters = pOccludedClusters + mesh->clusterCullOffset;
+				uint32_t visibleCount = 0;
+				for (uint32_t j = 0; j < pVisibleClusterCounts[i]; ++j)
+				{
+					const uint32_t clusterIndex = pMeshVisibleClusters[j];
+					const Cluster* cluster = &mesh->clusters[clusterIndex];
+					if (meshOccluded || isBoxOccludedInAllViews(cluster->aabbMin, cluster->aabbMax))
+						pMeshOccludedClusters[pOccludedClusterCounts[i]++] = clusterIndex;
+					else
+						pMeshVisibleClusters[visibleCount++] = clusterIndex;
+				}
+				pVisibleClusterCounts[i] = visibleCount;
+			}
+		}
+	}
+
+	// Second phase of the occlusion culling: tests the clusters rejected by the last frame's occlusion buffers against the current ones.
+	// The clusters that became visible are appended to the visible clusters and kept in pOccludedClusters to be rasterized as occluders
+	static void retestOccludedClustersTask(void* pData)
+	{
+		ClusterCullTask* pTask = (ClusterCullTask*)pData;
+		pTask->mOccludedClusters = 0;
+
+		for (uint32_t i = pTask->mMeshStart; i < pTask->mMeshEnd; ++i)
+		{
+			const Mesh* mesh = &pScene->meshes[i];
+			if (!pOccludedClusterCounts[i])
+				continue;
+
+			uint32_t* pMeshVisibleClusters = pVisibleClusters + mesh->clusterCullOffset;
+			uint32_t* pMeshOccludedClusters = pOccludedClusters + mesh->clusterCullOffset;
+			const bool meshOccluded = isBoxOccludedInAllViews(mesh->minBBox, mesh->maxBBox);
+			uint32_t newlyVisibleCount = 0;
+			for (uint32_t j = 0; j < pOccludedClusterCounts[i]; ++j)
+			{
+				const uint32_t clusterIndex = pMeshOccludedClusters[j];
+				const Cluster* cluster = &mesh->clusters[clusterIndex];
+				if (meshOccluded || isBoxOccludedInAllViews(cluster->aabbMin, cluster->aabbMax))
+				{
+					++pTask->mOccludedClusters;
+					continue;
+				}
+				pMeshVisibleClusters[pVisibleClusterCounts[i]++] = clusterIndex;
+				pMeshOccludedClusters[newlyVisibleCount++] = clusterIndex;
+			}
+			pOccludedClusterCounts[i] = newlyVisibleCount;
+		}
+	}
+
+	// Rasterizes the opaque visible clusters into the occlusion buffer of every view. Alpha tested geometry is not a reliable occluder.
+	// Before the retest these are the clusters that passed the first phase, after it the ones that became visible
+	void rasterizeOccluderClusters(bool retest)
 	{
-		// Invalid clusters can't be safely culled using the cone based test
-		if (cluster->valid)
+		const uint32_t* pClusters = retest ? pOccludedClusters : pVisibleClusters;
+		const uint32_t* pClusterCounts = retest ? pOccludedClusterCounts : pVisibleClusterCounts;
+
+		for (uint32_t v = 0; v < gNumViews; ++v)
 		{
-			uint visibility = 0;
-			for (uint32_t i = 0; i < gNumViews; i++)
+			OcclusionRasterizer* pRasterizer = pOcclusionRasterizers[v];
+			OcclusionRasterizerStats stats;
+			getOcclusionRasterizerStats(pRasterizer, &stats);
+			uint32_t triangleCount = stats.mOccluderTriangles;
+
+			for (uint32_t i = 0; i < pScene->numMeshes && triangleCount < gMaxOccluderTriangles; ++i)
 			{
-				// We move camera position into object space
-				vec3 testVec = normalize(eyes[i] - f3Tov3(cluster->coneCenter));
+				const Mesh* mesh = &pScene->meshes[i];
+				if (pScene->materials[mesh->materialId].alphaTested)
+					continue;
 
-				// Check if we are inside the cone
-				if (dot(testVec, f3Tov3(cluster->coneAxis)) < cluster->coneAngleCosine)
-					visibility |= (1 << i);
+				const uint32_t* pMeshClusters = pClusters + mesh->clusterCullOffset;
+				for (uint32_t j = 0; j < pClusterCounts[i] && triangleCount < gMaxOccluderTriangles; ++j)
+				{
+					OccluderMesh occluder;
+					getClusterOccluderMesh(pScene, mesh, &mesh->clusterCompacts[pMeshClusters[j]], &occluder);
+					occluder.mTriangleCount = min(occluder.mTriangleCount, gMaxOccluderTriangles - triangleCount);
+					addOccluderMesh(pRasterizer, &occluder);
+					triangleCount += occluder.mTriangleCount;
+				}
 			}
-			return (visibility == 0);
 
+			rasterizeOccluders(pRasterizer);
+			gOcclusionBufferValid[v] = true;
 		}
-		return false;
+	}
+
+	void runClusterCullTasks(WorkItem* pWorkItems, void (*pFunc)(void*))
+	{
+		if (gClusterCullTaskCount > 1 && pScene->clusterCullData.clusterCount >= gMinParallelCullClusters)
+		{
+			for (uint32_t i = 0; i < gClusterCullTaskCount; ++i)
+				gThreadSystem.AddWorkItem(&pWorkItems[i]);
+			gThreadSystem.Complete(0);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < gClusterCullTaskCount; ++i)
+				pFunc(&gClusterCullTasks[i]);
+		}
+	}
+
+	// Culls the clusters against the camera and shadow views on the thread pool.
+	// Clusters are culled with a cone test (all triangles back facing) and a frustum test against the object space side planes.
+	// Since the triangle filtering kernel operates with 2 views in the same pass, only clusters that are not visible from ANY of the views are culled.
+	// The visible clusters are read back in mesh order afterwards so the batches come out the same for any thread count.
+	// With occlusion culling the clusters are also tested against an occlusion buffer per view in two phases:
+	// - the buffers of the last frame reject clusters, the others are rasterized as occluders into the buffers of this frame
+	// - the rejected clusters are tested again with the new buffers, the ones that became visible are added as occluders for the next frame
+	void cullSceneClusters(uint32_t frameIdx, bool enabled)
+	{
+		PROFILE_SCOPE("Cluster Culling");
+
+		gClusterCullEnabled = enabled;
+		gOcclusionCullEnabled = enabled && gAppSettings.mOcclusionCulling;
+		if (!gOcclusionCullEnabled)
+		{
+			// Stale occluders would hide clusters that are visible when occlusion culling is turned on again
+			for (uint32_t v = 0; v < gNumViews; ++v)
+				gOcclusionBufferValid[v] = false;
+		}
+		for (uint32_t v = 0; v < gNumViews; ++v)
+		{
+			const vec3& eye = gPerFrame[frameIdx].gEyeObjectSpace[v];
+			gClusterCullViews.eye[v][0] = eye.getX();
+			gClusterCullViews.eye[v][1] = eye.getY();
+			gClusterCullViews.eye[v][2] = eye.getZ();
+			gClusterCullViews.eye[v][3] = 1.0f;
+
+			// Side planes of the clip space volume -w <= x,y <= w moved to object space
+			const mat4& mvp = gPerFrame[frameIdx].gPerFrameUniformData.transform[v].mvp;
+			for (uint32_t p = 0; p < 4; ++p)
+			{
+				const uint32_t row = p / 2;
+				const float sign = (p & 1) ? -1.0f : 1.0f;
+				for (uint32_t c = 0; c < 4; ++c)
+					gClusterCullViews.planes[v][p][c] = mvp[c][3] + sign * mvp[c][row];
+			}
+		}
+
+		runClusterCullTasks(gClusterCullWorkItems, cullClustersTask);
+
+		if (gOcclusionCullEnabled)
+		{
+			PROFILE_SCOPE("Occlusion Culling");
+
+			for (uint32_t v = 0; v < gNumViews; ++v)
+			{
+				const mat4& mvp = gPerFrame[frameIdx].gPerFrameUniformData.transform[v].mvp;
+				float occluderMvp[4][4];
+				for (uint32_t c = 0; c < 4; ++c)
+					for (uint32_t r = 0; r < 4; ++r)
+						occluderMvp[c][r] = mvp[c][r];
+				beginOcclusionFrame(pOcclusionRasterizers[v], &occluderMvp[0][0]);
+				gOcclusionBufferValid[v] = false;
+			}
+
+			rasterizeOccluderClusters(false);
+			runClusterCullTasks(gClusterRetestWorkItems, retestOccludedClustersTask);
+			rasterizeOccluderClusters(true);
+
+			for (uint32_t i = 0; i < gClusterCullTaskCount; ++i)
+				gPerFrame[frameIdx].gOcclusionCulledClusters += gClusterCullTasks[i].mOccludedClusters;
+		}
+
+		for (uint32_t i = 0; i < gClusterCullTaskCount; ++i)
+			gPerFrame[frameIdx].gCulledClusters += gClusterCullTasks[i].mCulledClusters;
+		for (uint32_t i = 0; i < pScene->numMeshes; ++i)
+			gPerFrame[frameIdx].gTotalClusters += pScene->meshes[i].clusterCount;
 	}
 
 	static inline int genClipMask(__m128 v)
@@ -3579,6 +3853,7 @@ public:
 
 		gPerFrame[frameIdx].gTotalClusters = 0;
 		gPerFrame[frameIdx].gCulledClusters = 0;
+		gPerFrame[frameIdx].gOcclusionCulledClusters = 0;
 
 #if defined(METAL)
 		/************************************************************************/
@@ -3619,24 +3894,18 @@ public:
 		filterParams[5].ppBuffers = &pFilteredIndexBuffer[frameIdx][VIEW_SHADOW];
 		cmdBindDescriptors(cmd, pRootSignatureTriangleFiltering, 6, filterParams);
 
-		// Iterate mesh clusters and perform cluster culling
+		// Perform CPU-based cluster culling before adding the clusters for GPU filtering
+		cullSceneClusters(frameIdx, true);
+
 		uint32_t batchBufferOffset = 0;
 		for (uint32_t i = 0; i < pScene->numMeshes; i++)
 		{
 			const Mesh* mesh = pScene->meshes + i;
 			const Material* material = pScene->materials + mesh->materialId;
-			gPerFrame[frameIdx].gTotalClusters += mesh->clusterCount;
-			for (uint32_t j = 0; j < mesh->clusterCount; j++)
+			const uint32_t* pMeshVisibleClusters = pVisibleClusters + mesh->clusterCullOffset;
+			for (uint32_t j = 0; j < pVisibleClusterCounts[i]; j++)
 			{
-				const Cluster* cluster = mesh->clusters + j;
-				const ClusterCompact* pClusterCompact = &mesh->clusterCompacts[j];
-
-				// Perform CPU-based cluster culling before adding the cluster for GPU filtering
-				if (cullCluster(cluster, gPerFrame[frameIdx].gEyeObjectSpace))
-				{
-					gPerFrame[frameIdx].gCulledClusters++;
-					continue;
-				}
+				const ClusterCompact* pClusterCompact = &mesh->clusterCompacts[pMeshVisibleClusters[j]];
 
 				// The cluster was not culled: add cluster to the cluster batch chunk for the GPU filtering step
 				addClusterToBatchChunk(pClusterCompact, mesh, i, material->twoSided, pFilterBatchChunk[frameIdx]);
@@ -3657,6 +3926,8 @@ public:
 		// Flush the pending resource updates.
 		flushResourceUpdates();
 #else
+		// The fence of this frame was waited on, the GPU is done with the previous batch data of this frame
+		resetUniformRingBuffer(pFilterBatchDataBuffer[frameIdx]);
 		/************************************************************************/
 		// Barriers to transition uncompacted draw buffer to uav
 		/************************************************************************/
@@ -3725,6 +3996,8 @@ public:
 		filterParams[5].pName = "uniforms";
 		filterParams[5].ppBuffers = &pPerFrameUniformBuffers[frameIdx];
 		cmdBindDescriptors(cmd, pRootSignatureTriangleFiltering, 6, filterParams);
+
+		cullSceneClusters(frameIdx, gAppSettings.mClusterCulling);
 #if 0
 #define SORT_CLUSTERS 1
 
@@ -3868,18 +4141,14 @@ public:
 		{
 			Mesh* drawBatch = &pScene->meshes[i];
 			FilterBatchChunk* batchChunk = pFilterBatchChunk[frameIdx][currentSmallBatchChunk];
-			for (uint32_t j = 0; j < drawBatch->clusterCount; ++j)
+			const uint32_t* pMeshVisibleClusters = pVisibleClusters + drawBatch->clusterCullOffset;
+			for (uint32_t j = 0; j < pVisibleClusterCounts[i]; ++j)
 			{
-				++gPerFrame[frameIdx].gTotalClusters;
-				const ClusterCompact* clusterCompactInfo = &drawBatch->clusterCompacts[j];
-				// Run cluster culling
-				if (!gAppSettings.mClusterCulling || !cullCluster(&drawBatch->clusters[j], gPerFrame[frameIdx].gEyeObjectSpace))
-				{
-					// cluster culling passed or is turned off
-					// We will now add the cluster to the batch to be triangle filtered
-					addClusterToBatchChunk(clusterCompactInfo, batchStart, accumDrawCount, accumNumTrianglesAtStartOfBatch, i, batchChunk);
-					accumNumTriangles += clusterCompactInfo->triangleCount;
-				}
+				// cluster culling passed or is turned off
+				// We will now add the cluster to the batch to be triangle filtered
+				const ClusterCompact* clusterCompactInfo = &drawBatch->clusterCompacts[pMeshVisibleClusters[j]];
+				addClusterToBatchChunk(clusterCompactInfo, batchStart, accumDrawCount, accumNumTrianglesAtStartOfBatch, i, batchChunk);
+				accumNumTriangles += clusterCompactInfo->triangleCount;
 
 				// check to see if we filled the batch
 				if (batchChunk->currentBatchCount >= BATCH_COUNT)
@@ -4070,6 +4339,14 @@ public:
 		gTimer.GetUSec(true);
 		drawDebugText(cmd, 8.0f, 15.0f, tinystl::string::format("CPU %f ms", gTimer.GetUSecAverage() / 1000.0f), &gFrameTimeDraw);
 
+		const uint32_t totalClusters = gPerFrame[frameIdx].gTotalClusters;
+		const uint32_t culledClusters = gPerFrame[frameIdx].gCulledClusters;
+		drawDebugText(cmd, 300.0f, 15.0f, tinystl::string::format("Culled Clusters %u / %u (%.1f%%)", culledClusters, totalClusters,
+			100.0f * culledClusters / max(totalClusters, 1U)), &gFrameTimeDraw);
+		const uint32_t occludedClusters = gPerFrame[frameIdx].gOcclusionCulledClusters;
+		drawDebugText(cmd, 300.0f, 40.0f, tinystl::string::format("Occluded Clusters %u / %u (%.1f%%)", occludedClusters, totalClusters,
+			100.0f * occludedClusters / max(totalClusters, 1U)), &gFrameTimeDraw);
+
 #if 1
 		// NOTE: Realtime GPU Profiling is not supported on Metal.
 #ifndef METAL
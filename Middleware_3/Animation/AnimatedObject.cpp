@@ -39,29 +39,108 @@ void AnimatedObject::Destroy()
 {
 	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
 	allocator->Deallocate(mLocalTrans);
+	allocator->Deallocate(mPrevLocalTrans);
+	allocator->Deallocate(mLastLocalTrans);
 }
 
 bool AnimatedObject::Update(float dt)
 {
+	if (!Sample(dt))
+		return false;
+
+	return LocalToModel();
+}
+
+bool AnimatedObject::Sample(float dt)
+{
+	// Catch up with the frames that were extrapolated
+	dt += mTimeSinceUpdate;
+
 	// sample the current animation to get mCurrLocalTrans
 	if (!mAnimation->Sample(dt, mLocalTrans))
 		return false;
 
-	// Local to model job
+	mUpdateInterval = dt;
+	mTimeSinceUpdate = 0.f;
 
-	// Setup local-to-model conversion job.
-	ozz::animation::LocalToModelJob ltmJob;
-	ltmJob.skeleton = mRig->GetSkeleton();
-	ltmJob.input = mLocalTrans;
-	ltmJob.output = mRig->GetJointModelMats(); // Save results in mRig's model mat buffer
+	// Keep the last two updates to extrapolate from
+	if (mLastLocalTrans.begin)
+	{
+		ozz::Range<SoaTransform> prevLocalTrans = mPrevLocalTrans;
+		mPrevLocalTrans = mLastLocalTrans;
+		mLastLocalTrans = prevLocalTrans;
 
-	// Runs ltm job.
-	if (!ltmJob.Run())
-		return false;
+		memcpy(mLastLocalTrans.begin, mLocalTrans.begin, mRig->GetNumSoaJoints() * sizeof(SoaTransform));
+	}
+
+	return true;
+}
+
+bool AnimatedObject::LocalToModel()
+{
+	if (mLodMask)
+	{
+		// Only the joints enabled in the mask are evaluated
+		if (!mLodMask->LocalToModel(mLocalTrans, mRig->GetJointModelMats()))
+			return false;
+	}
+	else
+	{
+		// Setup local-to-model conversion job.
+		ozz::animation::LocalToModelJob ltmJob;
+		ltmJob.skeleton = mRig->GetSkeleton();
+		ltmJob.input = mLocalTrans;
+		ltmJob.output = mRig->GetJointModelMats(); // Save results in mRig's model mat buffer
+
+		// Runs ltm job.
+		if (!ltmJob.Run())
+			return false;
+	}
 
 	return true;
 }
 
+bool AnimatedObject::Extrapolate(float dt)
+{
+	// Start keeping updates, until the next one the joints hold their pose
+	if (!mLastLocalTrans.begin)
+	{
+		ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+		mPrevLocalTrans = allocator->AllocateRange<SoaTransform>(mRig->GetNumSoaJoints());
+		mLastLocalTrans = allocator->AllocateRange<SoaTransform>(mRig->GetNumSoaJoints());
+
+		memcpy(mPrevLocalTrans.begin, mLocalTrans.begin, mRig->GetNumSoaJoints() * sizeof(SoaTransform));
+		memcpy(mLastLocalTrans.begin, mLocalTrans.begin, mRig->GetNumSoaJoints() * sizeof(SoaTransform));
+		mUpdateInterval = 0.f;
+	}
+
+	mTimeSinceUpdate += dt;
+
+	if ((mUpdateInterval <= 0.f) || (mUpdateInterval > mMaxExtrapolationInterval))
+		return true;
+
+	// Extrapolating the local transforms keeps the joints on the arcs of their parent's rotation, where
+	// moving the model matrices in a straight line shears them. Translation, rotation and scale are
+	// continued separately, for at most one update interval so late updates don't overshoot
+	const Vector4 t(1.f + min(mTimeSinceUpdate / mUpdateInterval, 1.f));
+	for (unsigned int i = 0; i < mRig->GetNumSoaJoints(); i++)
+	{
+		const SoaTransform& prev = mPrevLocalTrans[i];
+		const SoaTransform& last = mLastLocalTrans[i];
+
+		// Take the rotation from the hemisphere of the last one so the extrapolation follows the shortest arc
+		const Vector4 cosAngle = mulPerElem(prev.rotation.x, last.rotation.x) + mulPerElem(prev.rotation.y, last.rotation.y) +
+								 mulPerElem(prev.rotation.z, last.rotation.z) + mulPerElem(prev.rotation.w, last.rotation.w);
+		const SoaQuaternion prevRotation = prev.rotation * copySignPerElem(Vector4(1.f), cosAngle);
+
+		mLocalTrans[i].translation = Lerp(prev.translation, last.translation, t);
+		mLocalTrans[i].rotation = NLerp(prevRotation, last.rotation, t);
+		mLocalTrans[i].scale = Lerp(prev.scale, last.scale, t);
+	}
+
+	return LocalToModel();
+}
+
 void AnimatedObject::PoseRigInBind()
 {
 	// Setup local-to-model conversion job.
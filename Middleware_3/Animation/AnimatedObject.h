@@ -31,6 +31,7 @@
 
 #include "Rig.h"
 #include "Animation.h"
+#include "LodMask.h"
 
 // Responsible for coordinating the posing of a Rig by an Animation
 class AnimatedObject 
@@ -44,9 +45,23 @@ public:
 	// Must be called to clean up the system if it has been initialized
 	void Destroy();
 
-	// To be called every frame of the main application, handles sampling and updating the current animation
+	// To be called every frame of the main application, handles sampling and updating the current animation.
+	// Time passed to Extrapolate since the previous update is added to dt
 	bool Update(float dt);
 
+	// First step of Update, samples and blends the animation into the local transforms
+	bool Sample(float dt);
+
+	// Second step of Update, computes the joint model matrices of the rig from the local transforms
+	bool LocalToModel();
+
+	// Can be called instead of Update on frames the animation is not sampled, continues the motion
+	// of the local transforms between the last two updates and computes the joint model matrices
+	bool Extrapolate(float dt);
+
+	// Can be called instead of Update on frames the object is not displayed, the next update catches up
+	inline void Skip(float dt) { mTimeSinceUpdate += dt; };
+
 	// Update mRigs world matricies
 	inline void PoseRig() { mRig->Pose(mRootTransform); };
 
@@ -59,6 +74,18 @@ public:
 	// Set the root transform of the object
 	inline void SetRootTransform(const Matrix4& rootTransform) { mRootTransform = rootTransform; };
 
+	// Get the root transform of the object
+	inline const Matrix4& GetRootTransform() { return mRootTransform; };
+
+	// Set the longest update interval Extrapolate continues the motion over, past it the joints hold their pose
+	inline void SetMaxExtrapolationInterval(float maxExtrapolationInterval) { mMaxExtrapolationInterval = maxExtrapolationInterval; };
+
+	// Set the mask of the joints evaluated by Update, NULL evaluates all of them
+	inline void SetLodMask(LodMask* lodMask) { mLodMask = lodMask; };
+
+	// Get the animation
+	inline Animation* GetAnimation() { return mAnimation; };
+
 	// Get the rig of this animated object
 	inline Rig* GetRig() { return mRig; };
 
@@ -75,4 +102,21 @@ private:
 
 	// Transform to apply to entire rig
 	Matrix4 mRootTransform = Matrix4::identity();
+
+	// Mask of the joints evaluated by Update
+	LodMask* mLodMask = nullptr;
+
+	// Local transforms of the last two updates, only allocated once Extrapolate is used
+	ozz::Range<SoaTransform> mPrevLocalTrans;
+	ozz::Range<SoaTransform> mLastLocalTrans;
+
+	// Time between the last two updates
+	float mUpdateInterval = 0.f;
+
+	// Time passed to Extrapolate since the last update
+	float mTimeSinceUpdate = 0.f;
+
+	// Motion sampled further apart is too coarse to continue, over eight 60 Hz frames (0.13 s) extrapolating
+	// already errs more than holding the pose
+	float mMaxExtrapolationInterval = 0.1f;
 };
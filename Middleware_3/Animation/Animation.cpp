@@ -29,6 +29,7 @@ void Animation::Initialize(AnimationDesc animationDesc)
 	mRig = animationDesc.mRig;
 	mNumClips = min(animationDesc.mNumLayers, MAX_NUM_CLIPS);
 	mBlendType = animationDesc.mBlendType;
+	mInstancer = animationDesc.mInstancer;
 
 	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
 
@@ -51,13 +52,18 @@ void Animation::Initialize(AnimationDesc animationDesc)
 			mLongestClipIndex = i;
 		}
 
-		// Prepare input and output of clip sampling
+		// Share the clip through the instancer if there is one
+		mClipInstanceIndices[i] = mInstancer ? mInstancer->AddClip(mClips[i]) : -1;
+
+		// Prepare input and output of clip sampling, still needed for shared clips when the instancer is disabled
 
 		// Allocates sampler runtime buffers.
 		mClipLocalTrans[i] = allocator->AllocateRange<SoaTransform>(mRig->GetNumSoaJoints());
 
 		// Allocates a cache that matches animation requirements.
 		mClipSamplingCaches[i] = allocator->New<ozz::animation::SamplingCache>(mRig->GetNumJoints());
+
+		mClipPoses[i] = mClipLocalTrans[i];
 	}
 
 	// Allocate the blend layers that will be set each sampling based on each clip's properties
@@ -93,11 +99,22 @@ bool Animation::Sample(float dt, ozz::Range<SoaTransform>& localTrans)
 		mClipControllers[i]->Update(dt);
 
 		// Early out if this layers weight makes it irrelevant during blending.
-		if (mClipControllers[i]->GetWeight() != 0.f)
+		if ((mClipControllers[i]->GetWeight() != 0.f) && !IsLayerSkipped(i))
 		{
-			//if (!mClips[i]->Sample(mClipControllers[i]->GetTimeRatio()))
-			if (!mClips[i]->Sample(mClipSamplingCaches[i], mClipLocalTrans[i], mClipControllers[i]->GetTimeRatio()))
-				return false;
+			if ((mClipInstanceIndices[i] >= 0) && mInstancer->IsEnabled())
+			{
+				// Use the pose shared by the other animations in the same time bucket
+				if (!mInstancer->GetPose(mClipInstanceIndices[i], mClipControllers[i]->GetTimeRatio(), mClipPoses[i]))
+					return false;
+			}
+			else
+			{
+				//if (!mClips[i]->Sample(mClipControllers[i]->GetTimeRatio()))
+				if (!mClips[i]->Sample(mClipSamplingCaches[i], mClipLocalTrans[i], mClipControllers[i]->GetTimeRatio()))
+					return false;
+
+				mClipPoses[i] = mClipLocalTrans[i];
+			}
 		}
 	}
 
@@ -188,12 +205,37 @@ void Animation::UpdateBlendParameters()
 
 bool Animation::Blend(ozz::Range<SoaTransform>& localTrans)
 {
+	if (mBlendFastPaths)
+	{
+		unsigned int poseLayerIndex = 0;
+		unsigned int additivePoseIndex = 0;
+		for (unsigned int i = 0; i < mNumClips; i++)
+		{
+			// Skipped layers were not sampled this frame
+			if (IsLayerSkipped(i))
+				continue;
+
+			PoseBlendLayer& poseLayer = mClipControllers[i]->IsAdditive() ? mAdditivePoseLayers[additivePoseIndex++] : mPoseLayers[poseLayerIndex++];
+			poseLayer.mTransforms = mClipPoses[i];
+			poseLayer.mWeight = mClipControllers[i]->GetWeight();
+			poseLayer.mClipMask = mClipMasks[i];
+		}
+
+		return PoseBlender::Blend(
+			mPoseLayers, poseLayerIndex, mAdditivePoseLayers, additivePoseIndex, mThreshold, mRig->GetSkeleton()->bind_pose(), localTrans);
+	}
+
+	unsigned int layerIndex = 0;
 	unsigned int additiveIndex = 0;
 	for (unsigned int i = 0; i < mNumClips; i++) {
 
+		// Skipped layers were not sampled this frame
+		if (IsLayerSkipped(i))
+			continue;
+
 		if (mClipControllers[i]->IsAdditive())
 		{
-			mAdditiveLayers[additiveIndex].transform = mClipLocalTrans[i];
+			mAdditiveLayers[additiveIndex].transform = mClipPoses[i];
 			mAdditiveLayers[additiveIndex].weight = mClipControllers[i]->GetWeight();
 
 			if (mClipMasks[i])
@@ -205,21 +247,23 @@ bool Animation::Blend(ozz::Range<SoaTransform>& localTrans)
 		}
 		else
 		{
-			mLayers[i].transform = mClipLocalTrans[i];
-			mLayers[i].weight = mClipControllers[i]->GetWeight();
+			mLayers[layerIndex].transform = mClipPoses[i];
+			mLayers[layerIndex].weight = mClipControllers[i]->GetWeight();
 
 			if (mClipMasks[i])
-				mLayers[i].joint_weights = mClipMasks[i]->GetJointWeights();
+				mLayers[layerIndex].joint_weights = mClipMasks[i]->GetJointWeights();
 			else
-				mLayers[i].joint_weights = ozz::Range<const Vector4>();
+				mLayers[layerIndex].joint_weights = ozz::Range<const Vector4>();
+
+			layerIndex++;
 		}
 	}
 
 	// Setups blending job.
 	ozz::animation::BlendingJob blendJob;
 	blendJob.threshold = mThreshold;
-	blendJob.layers = mLayers;
-	if (mNumAdditiveClips > 0) blendJob.additive_layers = mAdditiveLayers;
+	blendJob.layers = ozz::Range<const ozz::animation::BlendingJob::Layer>(mLayers.begin, layerIndex);
+	if (additiveIndex > 0) blendJob.additive_layers = ozz::Range<const ozz::animation::BlendingJob::Layer>(mAdditiveLayers.begin, additiveIndex);
 	blendJob.bind_pose = mRig->GetSkeleton()->bind_pose();
 	blendJob.output = localTrans;
 
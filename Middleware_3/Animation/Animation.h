@@ -34,6 +34,8 @@
 #include "Clip.h"
 #include "ClipMask.h"
 #include "ClipController.h"
+#include "PoseBlender.h"
+#include "AnimationInstancer.h"
 
 // Maximum number of clips that can make up one animation
 const unsigned int MAX_NUM_CLIPS = 10;
@@ -63,6 +65,9 @@ struct AnimationDesc
 	unsigned int mNumLayers;
 	LayerProperty mLayerProperties[MAX_NUM_CLIPS];
 	BlendType mBlendType = BlendType::EQUAL;
+
+	// When set, clips are sampled once per time bucket through the instancer and the poses are shared with the other animations using it
+	AnimationInstancer* mInstancer = nullptr;
 };
 
 
@@ -102,6 +107,15 @@ public:
 	// Gets the address of mThreshold so it can be edited externally
 	inline float* GetThresholdPtr() { return &mThreshold; };
 
+	// Set the weight below which additive and masked layers are neither sampled nor blended, used for level of detail
+	inline void SetLodWeightThreshold(float lodWeightThreshold) { mLodWeightThreshold = lodWeightThreshold; };
+
+	// Get the weight below which additive and masked layers are skipped
+	inline float GetLodWeightThreshold() { return mLodWeightThreshold; };
+
+	// Gets the address of mBlendFastPaths so it can be edited externally
+	inline bool* GetBlendFastPathsPtr() { return &mBlendFastPaths; };
+
 private:
 
 	// Sets the various blend parameters based on the type of blend set
@@ -110,6 +124,12 @@ private:
 	// Blend the sampled clips together based on their blend parameters
 	bool Blend(ozz::Range<SoaTransform>& localTrans);
 
+	// Indicates if the layer of the clip at index is left out at the current level of detail
+	inline bool IsLayerSkipped(unsigned int index)
+	{
+		return (mClipControllers[index]->IsAdditive() || mClipMasks[index]) && (mClipControllers[index]->GetWeight() < mLodWeightThreshold);
+	};
+
 	// Pointer to the rig that this animation corresponds to
 	Rig* mRig;
 
@@ -128,10 +148,23 @@ private:
 	// The buffer of local transforms that will be updated as output when each clip is sampled
 	ozz::Range<SoaTransform> mClipLocalTrans[MAX_NUM_CLIPS];
 
+	// The sampled pose of each clip that is blended, either mClipLocalTrans or a pose shared by mInstancer
+	ozz::Range<const SoaTransform> mClipPoses[MAX_NUM_CLIPS];
+
+	// Instancer sharing the clip poses, NULL if each clip is sampled by this animation
+	AnimationInstancer* mInstancer = nullptr;
+
+	// Index of each clip in mInstancer, -1 for clips it could not add
+	int mClipInstanceIndices[MAX_NUM_CLIPS];
+
 	// The blend layers that will be set each sampling based on each clip's properties
 	ozz::Range<ozz::animation::BlendingJob::Layer> mLayers;
 	ozz::Range<ozz::animation::BlendingJob::Layer> mAdditiveLayers;
 
+	// The blend layers given to PoseBlender when mBlendFastPaths is true
+	PoseBlendLayer mPoseLayers[MAX_NUM_CLIPS];
+	PoseBlendLayer mAdditivePoseLayers[MAX_NUM_CLIPS];
+
 	// Number of clips that make up this animation
 	unsigned int mNumClips = 0;
 
@@ -153,6 +186,10 @@ private:
 	// Set to Ozz's default min value
 	float mThreshold = ozz::animation::BlendingJob().threshold;
 
+	// Additive and masked layers with a weight below this are skipped.
+	// 0 keeps every layer
+	float mLodWeightThreshold = 0.f;
+
 	// Type of blend that defines how the clips blend parameters will be managed
 	BlendType mBlendType;
 
@@ -162,6 +199,10 @@ private:
 	// Initialized in the middle to represet the maximum amount of clips
 	float mBlendRatio = 0.5f;
 
+	// Blends with PoseBlender, which skips the joints masked out by the clip masks and copies single full layers.
+	// A value of false blends with ozz's generic BlendingJob
+	bool mBlendFastPaths = true;
+
 	// Controls if the UpdateBlendParameters() function gets called or not
 	// A value of false implies that all blend parameters will be set externally
 	bool mAutoSetBlendParams = true;
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "AnimationInstancer.h"
+
+void AnimationInstancer::Initialize(const AnimationInstancerDesc& animationInstancerDesc)
+{
+	ASSERT(animationInstancerDesc.mMaxTimeError > 0.f);
+
+	mRig = animationInstancerDesc.mRig;
+	mMaxTimeError = animationInstancerDesc.mMaxTimeError;
+}
+
+void AnimationInstancer::Destroy()
+{
+	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+
+	for (unsigned int i = 0; i < mNumClips; i++)
+	{
+		for (unsigned int j = 0; j < mClips[i].mBuckets.size(); j++)
+		{
+			allocator->Deallocate(mClips[i].mBuckets[j].mLocalTrans);
+			allocator->Delete(mClips[i].mBuckets[j].mSamplingCache);
+		}
+		mClips[i].mBuckets.clear();
+	}
+	mNumClips = 0;
+}
+
+int AnimationInstancer::AddClip(Clip* clip)
+{
+	for (unsigned int i = 0; i < mNumClips; i++)
+	{
+		if (mClips[i].mClip == clip)
+			return i;
+	}
+
+	if (mNumClips == MAX_NUM_INSTANCED_CLIPS)
+		return -1;
+
+	InstancedClip& instancedClip = mClips[mNumClips];
+	instancedClip.mClip = clip;
+	instancedClip.mNumSamples = 0;
+	ResetBuckets(instancedClip);
+
+	return mNumClips++;
+}
+
+void AnimationInstancer::BeginFrame()
+{
+	mFrame++;
+
+	for (unsigned int i = 0; i < mNumClips; i++)
+	{
+		mClips[i].mNumSamples = 0;
+	}
+}
+
+bool AnimationInstancer::GetPose(int clipIndex, float timeRatio, ozz::Range<const SoaTransform>& pose)
+{
+	ASSERT((0 <= clipIndex) && ((unsigned int)clipIndex < mNumClips));
+
+	InstancedClip& instancedClip = mClips[clipIndex];
+	const unsigned int numBuckets = (unsigned int)instancedClip.mBuckets.size();
+
+	// Find the bucket of timeRatio, the last bucket can be shorter than the others
+	const float bucketLength = mMaxTimeError * 2.f;
+	const float duration = instancedClip.mClip->GetDuration();
+	const unsigned int bucketIndex = min((unsigned int)(max(timeRatio, 0.f) * duration / bucketLength), numBuckets - 1);
+	Bucket& bucket = instancedClip.mBuckets[bucketIndex];
+
+	// Most calls land in a bucket another instance already sampled this frame
+	if (tfrg_atomic32_load_acquire(&bucket.mFrame) != mFrame)
+	{
+		MutexLock lock(instancedClip.mMutex);
+
+		// Another thread may have sampled the bucket while this one waited for the lock
+		if (tfrg_atomic32_load_relaxed(&bucket.mFrame) != mFrame)
+		{
+			if (!bucket.mLocalTrans.begin)
+			{
+				ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+				bucket.mLocalTrans = allocator->AllocateRange<SoaTransform>(mRig->GetNumSoaJoints());
+				bucket.mSamplingCache = allocator->New<ozz::animation::SamplingCache>(mRig->GetNumJoints());
+			}
+
+			const float bucketCenter = min((bucketIndex + 0.5f) * bucketLength, duration);
+			const float bucketTimeRatio = (duration > 0.f) ? bucketCenter / duration : 0.f;
+			if (!instancedClip.mClip->Sample(bucket.mSamplingCache, bucket.mLocalTrans, bucketTimeRatio))
+				return false;
+
+			tfrg_atomic32_store_release(&bucket.mFrame, mFrame);
+			instancedClip.mNumSamples++;
+		}
+	}
+
+	pose = bucket.mLocalTrans;
+	return true;
+}
+
+void AnimationInstancer::SetMaxTimeError(float maxTimeError)
+{
+	ASSERT(maxTimeError > 0.f);
+
+	if (maxTimeError == mMaxTimeError)
+		return;
+
+	mMaxTimeError = maxTimeError;
+	for (unsigned int i = 0; i < mNumClips; i++)
+	{
+		ResetBuckets(mClips[i]);
+	}
+}
+
+unsigned int AnimationInstancer::GetNumSamples()
+{
+	unsigned int numSamples = 0;
+	for (unsigned int i = 0; i < mNumClips; i++)
+	{
+		numSamples += mClips[i].mNumSamples;
+	}
+	return numSamples;
+}
+
+void AnimationInstancer::ResetBuckets(InstancedClip& instancedClip)
+{
+	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+
+	for (unsigned int j = 0; j < instancedClip.mBuckets.size(); j++)
+	{
+		allocator->Deallocate(instancedClip.mBuckets[j].mLocalTrans);
+		allocator->Delete(instancedClip.mBuckets[j].mSamplingCache);
+	}
+
+	// Buckets of maxTimeError * 2 seconds sampled at their center, their poses are allocated when first needed
+	const unsigned int numBuckets = max(1u, (unsigned int)ceilf(instancedClip.mClip->GetDuration() / (mMaxTimeError * 2.f)));
+	instancedClip.mBuckets = tinystl::vector<Bucket>(numBuckets);
+	for (unsigned int j = 0; j < numBuckets; j++)
+	{
+		instancedClip.mBuckets[j].mLocalTrans = ozz::Range<SoaTransform>();
+		instancedClip.mBuckets[j].mSamplingCache = NULL;
+		tfrg_atomic32_store_relaxed(&instancedClip.mBuckets[j].mFrame, 0);
+	}
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Interfaces/IThread.h"
+#include "../../Common_3/OS/Core/Atomics.h"
+
+#include "Rig.h"
+#include "Clip.h"
+
+// Maximum number of clips that can be shared through one instancer
+const unsigned int MAX_NUM_INSTANCED_CLIPS = 16;
+
+// User will have to predefine to pass into AnimationInstancer's initialize function
+struct AnimationInstancerDesc
+{
+	// Rig the clips are sampled for, every Animation using the instancer must have the same skeleton
+	Rig* mRig;
+
+	// Largest difference in seconds between an object's playback time and the time its shared pose was sampled at.
+	// Playback times are quantized into buckets twice this long
+	float mMaxTimeError = 1.0f / 120.0f;
+};
+
+// Shares clip sampling between the Animations of a crowd: playback times of each clip are quantized into buckets,
+// and every (clip, bucket) pair is sampled at most once per frame no matter how many objects play it.
+// Animations opt in through AnimationDesc::mInstancer, so they read the shared pose instead of sampling their own
+class AnimationInstancer
+{
+
+public:
+
+	// Set up the instancer for the rig with the error bound of the description
+	void Initialize(const AnimationInstancerDesc& animationInstancerDesc);
+
+	// Must be called to clean up the object if it was initialized
+	void Destroy();
+
+	// Gets the index of clip, adding it if it isn't shared yet. Returns -1 if there are already MAX_NUM_INSTANCED_CLIPS
+	int AddClip(Clip* clip);
+
+	// Must be called once per frame before the Animations are sampled, so poses of the previous frame get sampled again
+	void BeginFrame();
+
+	// Gets the pose of the clip at clipIndex for the bucket of timeRatio, sampling it if no object needed it yet this frame.
+	// Can be called from several threads at once
+	bool GetPose(int clipIndex, float timeRatio, ozz::Range<const SoaTransform>& pose);
+
+	// Set the error bound, poses sampled with the previous one are sampled again
+	void SetMaxTimeError(float maxTimeError);
+
+	// Gets the error bound in seconds
+	inline float GetMaxTimeError() { return mMaxTimeError; };
+
+	// Toggle whether or not the Animations using the instancer share poses, they sample their own clips when disabled
+	inline void SetEnabled(bool setValue) { mEnabled = setValue; };
+
+	// Indicates if the Animations using the instancer share poses
+	inline bool IsEnabled() { return mEnabled; };
+
+	// Gets the address of mEnabled so it can be edited externally
+	inline bool* GetEnabledPtr() { return &mEnabled; };
+
+	// Gets the number of clip samples done during the current frame
+	unsigned int GetNumSamples();
+
+private:
+
+	// Pose of a clip at a bucket's time
+	struct Bucket
+	{
+		ozz::Range<SoaTransform> mLocalTrans;
+
+		// Each bucket is always sampled at the same time, so its own cache never has to seek through the clip
+		ozz::animation::SamplingCache* mSamplingCache;
+
+		// Frame the pose was last sampled for, stored with release once mLocalTrans holds that frame's pose
+		tfrg_atomic32_t mFrame;
+	};
+
+	struct InstancedClip
+	{
+		Clip* mClip;
+
+		// Bucket count depends on the clip duration and the error bound
+		tinystl::vector<Bucket> mBuckets;
+
+		// Number of buckets sampled during the current frame
+		unsigned int mNumSamples;
+
+		// Serializes the sampling of the clip's buckets, readers of an up to date bucket do not take it
+		Mutex mMutex;
+	};
+
+	// Frees the buckets of the clip and sizes them for the current error bound
+	void ResetBuckets(InstancedClip& instancedClip);
+
+	// Pointer to the rig the clips are sampled for
+	Rig* mRig;
+
+	InstancedClip mClips[MAX_NUM_INSTANCED_CLIPS];
+
+	unsigned int mNumClips = 0;
+
+	float mMaxTimeError;
+
+	// Toggle on whether or not the Animations share poses
+	bool mEnabled = true;
+
+	// Current frame, bucket poses sampled for an older frame are stale. Starts at 1 so new buckets are stale
+	unsigned int mFrame = 1;
+};
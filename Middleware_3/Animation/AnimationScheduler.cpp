@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "AnimationScheduler.h"
+
+void AnimationScheduler::Initialize(const AnimationSchedulerDesc& animationSchedulerDesc)
+{
+	ASSERT((0 < animationSchedulerDesc.mNumLodLevels) && (animationSchedulerDesc.mNumLodLevels <= MAX_NUM_LOD_LEVELS));
+
+	mNumLodLevels = animationSchedulerDesc.mNumLodLevels;
+	for (unsigned int i = 0; i < mNumLodLevels; i++)
+	{
+		mLodLevels[i] = animationSchedulerDesc.mLodLevels[i];
+		mLodLevels[i].mUpdatePeriod = max(mLodLevels[i].mUpdatePeriod, 1u);
+	}
+
+	mOffscreenUpdatePeriod = max(animationSchedulerDesc.mOffscreenUpdatePeriod, 1u);
+	mBoundingRadius = animationSchedulerDesc.mBoundingRadius;
+	mBudgetMs = animationSchedulerDesc.mBudgetMs;
+}
+
+void AnimationScheduler::Destroy()
+{
+	mObjects.clear();
+	mDueObjects.clear();
+	mWorkItems.clear();
+	mJobData.clear();
+	mNumActiveObjects = 0;
+}
+
+void AnimationScheduler::AddObject(AnimatedObject* animatedObject)
+{
+	ScheduledObject scheduledObject = {};
+	scheduledObject.mAnimatedObject = animatedObject;
+	scheduledObject.mUpdatePeriod = 1;
+	scheduledObject.mFramesSinceUpdate = UINT_MAX;
+	scheduledObject.mPhase = (unsigned int)mObjects.size();
+	mObjects.push_back(scheduledObject);
+
+	mNumActiveObjects = (unsigned int)mObjects.size();
+}
+
+void AnimationScheduler::Schedule(const Vector3& eyePosition, const Matrix4& viewProjMat)
+{
+	// Side planes of the view frustum, the distance to the eye takes care of near and far
+	Vector4 frustumPlanes[4] =
+	{
+		viewProjMat.getRow(3) + viewProjMat.getRow(0),
+		viewProjMat.getRow(3) - viewProjMat.getRow(0),
+		viewProjMat.getRow(3) + viewProjMat.getRow(1),
+		viewProjMat.getRow(3) - viewProjMat.getRow(1),
+	};
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		frustumPlanes[i] /= length(frustumPlanes[i].getXYZ());
+	}
+
+	mDueObjects.clear();
+	mNumOffscreen = 0;
+
+	unsigned int numForced = 0;
+	for (unsigned int i = 0; i < mNumActiveObjects; i++)
+	{
+		ScheduledObject& scheduledObject = mObjects[i];
+		AnimatedObject* animatedObject = scheduledObject.mAnimatedObject;
+		scheduledObject.mUpdate = false;
+
+		const Vector3 rootPosition = animatedObject->GetRootTransform().getTranslation();
+		scheduledObject.mDistance = length(rootPosition - eyePosition);
+
+		scheduledObject.mOnScreen = true;
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			if (dot(frustumPlanes[j], Vector4(rootPosition, 1.f)) < -mBoundingRadius)
+				scheduledObject.mOnScreen = false;
+		}
+
+		// Pick the level of detail
+		unsigned int lodLevel = 0;
+		while ((lodLevel + 1 < mNumLodLevels) && (mLodLevels[lodLevel].mMaxDistance <= scheduledObject.mDistance))
+			lodLevel++;
+
+		const LodLevel& level = mLodLevels[lodLevel];
+		animatedObject->SetLodMask(level.mLodMask);
+		animatedObject->GetAnimation()->SetLodWeightThreshold(level.mLayerWeightThreshold);
+
+		if (scheduledObject.mOnScreen)
+		{
+			scheduledObject.mUpdatePeriod = level.mUpdatePeriod;
+		}
+		else
+		{
+			scheduledObject.mUpdatePeriod = max(level.mUpdatePeriod, mOffscreenUpdatePeriod);
+			mNumOffscreen++;
+		}
+
+		// Objects that were never updated have no pose to extrapolate from, they are updated whatever the budget
+		if (scheduledObject.mFramesSinceUpdate == UINT_MAX)
+		{
+			scheduledObject.mUpdate = true;
+			numForced++;
+			continue;
+		}
+
+		// Objects are due on the frames of their phase, or as soon as possible once they are late
+		if (((mFrame + scheduledObject.mPhase) % scheduledObject.mUpdatePeriod == 0) ||
+			(scheduledObject.mFramesSinceUpdate >= scheduledObject.mUpdatePeriod))
+		{
+			DueObject dueObject;
+			dueObject.mIndex = i;
+			dueObject.mLateness = (float)(scheduledObject.mFramesSinceUpdate + 1) / (float)scheduledObject.mUpdatePeriod;
+			dueObject.mDistance = scheduledObject.mDistance;
+			mDueObjects.push_back(dueObject);
+		}
+	}
+
+	// Number of updates that fit in the budget, given what the other objects cost to extrapolate
+	unsigned int numUpdates = (unsigned int)mDueObjects.size();
+	if ((mBudgetMs > 0.f) && (mUpdateCostMs > mExtrapolateCostMs))
+	{
+		const float extrapolateMs = (mNumActiveObjects - numForced) * mExtrapolateCostMs;
+		const float updatesMs = mBudgetMs - extrapolateMs - numForced * mUpdateCostMs;
+		const unsigned int budgetUpdates = (updatesMs > 0.f) ? (unsigned int)(updatesMs / (mUpdateCostMs - mExtrapolateCostMs)) : 0;
+
+		// Keep at least one update per frame so the latest objects always catch up
+		numUpdates = min(numUpdates, max(budgetUpdates, 1u));
+	}
+
+	// Latest and closest objects get the updates that fit in the budget
+	if (numUpdates < mDueObjects.size())
+	{
+		qsort(mDueObjects.data(), mDueObjects.size(), sizeof(DueObject), [](const void* lhs, const void* rhs)
+		{
+			const DueObject* pLhs = (const DueObject*)lhs;
+			const DueObject* pRhs = (const DueObject*)rhs;
+			if (pLhs->mLateness != pRhs->mLateness)
+				return (pLhs->mLateness > pRhs->mLateness) ? -1 : 1;
+			if (pLhs->mDistance != pRhs->mDistance)
+				return (pLhs->mDistance < pRhs->mDistance) ? -1 : 1;
+			return 0;
+		});
+	}
+
+	for (unsigned int i = 0; i < numUpdates; i++)
+	{
+		mObjects[mDueObjects[i].mIndex].mUpdate = true;
+	}
+
+	mNumUpdated = numForced + numUpdates;
+	mNumDeferred = (unsigned int)mDueObjects.size() - numUpdates;
+}
+
+void AnimationScheduler::UpdateObjects(UpdateJobData& jobData)
+{
+	jobData.mSuccess = true;
+
+	int64_t startTime = getUSec();
+	for (unsigned int i = jobData.mBegin; i < jobData.mEnd; i++)
+	{
+		ScheduledObject& scheduledObject = mObjects[i];
+		if (scheduledObject.mUpdate)
+		{
+			if (!scheduledObject.mAnimatedObject->Update(mDeltaTime))
+				jobData.mSuccess = false;
+			scheduledObject.mAnimatedObject->PoseRig();
+		}
+	}
+
+	int64_t endTime = getUSec();
+	jobData.mUpdateUSec = endTime - startTime;
+	startTime = endTime;
+
+	for (unsigned int i = jobData.mBegin; i < jobData.mEnd; i++)
+	{
+		ScheduledObject& scheduledObject = mObjects[i];
+		if (!scheduledObject.mUpdate)
+		{
+			// Off screen rigs are not displayed until their next update
+			if (scheduledObject.mOnScreen)
+			{
+				if (!scheduledObject.mAnimatedObject->Extrapolate(mDeltaTime))
+					jobData.mSuccess = false;
+				scheduledObject.mAnimatedObject->PoseRig();
+			}
+			else
+			{
+				scheduledObject.mAnimatedObject->Skip(mDeltaTime);
+			}
+		}
+	}
+
+	jobData.mExtrapolateUSec = getUSec() - startTime;
+}
+
+void AnimationScheduler::UpdateObjectsJob(void* pData)
+{
+	UpdateJobData* jobData = (UpdateJobData*)pData;
+	jobData->mAnimationScheduler->UpdateObjects(*jobData);
+}
+
+void AnimationScheduler::BeginFrame(const Vector3& eyePosition, const Matrix4& viewProjMat)
+{
+	if (mEnabled)
+	{
+		Schedule(eyePosition, viewProjMat);
+	}
+	else
+	{
+		// Every object fully updated and evaluated
+		for (unsigned int i = 0; i < mNumActiveObjects; i++)
+		{
+			mObjects[i].mUpdate = true;
+			mObjects[i].mOnScreen = true;
+			mObjects[i].mAnimatedObject->SetLodMask(NULL);
+			mObjects[i].mAnimatedObject->GetAnimation()->SetLodWeightThreshold(0.f);
+		}
+		mNumUpdated = mNumActiveObjects;
+		mNumDeferred = 0;
+		mNumOffscreen = 0;
+	}
+}
+
+void AnimationScheduler::EndFrame(int64_t updateUSec, int64_t extrapolateUSec)
+{
+	// Measure what the objects cost for the budget of the next frames
+	const float runningAverageWeight = 0.1f;
+	if (mNumUpdated > 0)
+	{
+		const float updateCostMs = updateUSec / 1000.f / mNumUpdated;
+		mUpdateCostMs = (mUpdateCostMs > 0.f) ? mUpdateCostMs + (updateCostMs - mUpdateCostMs) * runningAverageWeight : updateCostMs;
+	}
+	if (mNumActiveObjects > mNumUpdated)
+	{
+		const float extrapolateCostMs = extrapolateUSec / 1000.f / (mNumActiveObjects - mNumUpdated);
+		mExtrapolateCostMs = (mExtrapolateCostMs > 0.f) ? mExtrapolateCostMs + (extrapolateCostMs - mExtrapolateCostMs) * runningAverageWeight : extrapolateCostMs;
+	}
+	mCpuTimeMs = (updateUSec + extrapolateUSec) / 1000.f;
+
+	// Advance the frame counters of the objects
+	for (unsigned int i = 0; i < mNumActiveObjects; i++)
+	{
+		ScheduledObject& scheduledObject = mObjects[i];
+		if (scheduledObject.mUpdate)
+			scheduledObject.mFramesSinceUpdate = 0;
+		else
+			scheduledObject.mFramesSinceUpdate++;
+	}
+	mFrame++;
+}
+
+bool AnimationScheduler::Update(float dt, const Vector3& eyePosition, const Matrix4& viewProjMat, ThreadPool* threadPool, unsigned int grainSize)
+{
+	ASSERT(0 < grainSize);
+
+	mDeltaTime = dt;
+
+	BeginFrame(eyePosition, viewProjMat);
+
+	const unsigned int numJobs = (mNumActiveObjects + grainSize - 1) / grainSize;
+	if (mJobData.size() < numJobs)
+	{
+		mWorkItems.resize(numJobs);
+		mJobData.resize(numJobs);
+	}
+
+	for (unsigned int jobIndex = 0; jobIndex < numJobs; jobIndex++)
+	{
+		UpdateJobData& jobData = mJobData[jobIndex];
+		jobData.mAnimationScheduler = this;
+		jobData.mBegin = jobIndex * grainSize;
+		jobData.mEnd = (jobData.mBegin + grainSize < mNumActiveObjects) ? jobData.mBegin + grainSize : mNumActiveObjects;
+
+		if (threadPool)
+		{
+			mWorkItems[jobIndex] = WorkItem();
+			mWorkItems[jobIndex].pFunc = UpdateObjectsJob;
+			mWorkItems[jobIndex].pData = &jobData;
+			threadPool->AddWorkItem(&mWorkItems[jobIndex]);
+		}
+		else
+		{
+			UpdateObjects(jobData);
+		}
+	}
+
+	// Ensure all jobs are finished before the rigs are used
+	if (threadPool)
+		threadPool->Complete(0);
+
+	bool success = true;
+	int64_t updateUSec = 0;
+	int64_t extrapolateUSec = 0;
+	for (unsigned int jobIndex = 0; jobIndex < numJobs; jobIndex++)
+	{
+		success &= mJobData[jobIndex].mSuccess;
+		updateUSec += mJobData[jobIndex].mUpdateUSec;
+		extrapolateUSec += mJobData[jobIndex].mExtrapolateUSec;
+	}
+
+	EndFrame(updateUSec, extrapolateUSec);
+
+	return success;
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include <float.h>
+#include <limits.h>
+
+#include "../../Common_3/OS/Interfaces/IOperatingSystem.h"
+#include "../../Common_3/OS/Interfaces/IThread.h"
+
+#include "AnimatedObject.h"
+#include "LodMask.h"
+
+// Maximum number of levels of detail of an AnimationScheduler
+const unsigned int MAX_NUM_LOD_LEVELS = 4;
+
+// Describes how objects are animated at one level of detail
+struct LodLevel
+{
+	// Objects closer to the eye than this use the level, the last level is used for all objects further away
+	float mMaxDistance = FLT_MAX;
+
+	// Objects are sampled every mUpdatePeriod frames and extrapolated in between
+	unsigned int mUpdatePeriod = 1;
+
+	// Joints evaluated at this level, NULL evaluates all of them
+	LodMask* mLodMask = nullptr;
+
+	// Additive and masked layers with a weight below this are skipped
+	float mLayerWeightThreshold = 0.f;
+};
+
+// User will have to predefine to pass into AnimationScheduler's initialize function
+struct AnimationSchedulerDesc
+{
+	// Levels of detail sorted by mMaxDistance
+	unsigned int mNumLodLevels = 1;
+	LodLevel mLodLevels[MAX_NUM_LOD_LEVELS];
+
+	// Minimum update period of the objects whose bounding sphere is outside of the view frustum
+	unsigned int mOffscreenUpdatePeriod = 8;
+
+	// Radius of the bounding sphere around the root of each object
+	float mBoundingRadius = 1.f;
+
+	// CPU time in milliseconds, summed over all threads, the animation of all the objects may take per frame.
+	// Updates that do not fit are deferred to the next frames. 0 disables the budget
+	float mBudgetMs = 0.f;
+};
+
+// Schedules the updates of AnimatedObjects. Each frame objects get a level of detail from their distance to the eye
+// and whether they are on screen. Objects due for an update given the update period of their level are sampled
+// while the others are extrapolated, the updates of objects sharing a period are staggered across frames
+class AnimationScheduler
+{
+
+public:
+
+	// Set up the scheduler with the levels of detail of the description
+	void Initialize(const AnimationSchedulerDesc& animationSchedulerDesc);
+
+	// Must be called to clean up the object if it was initialized
+	void Destroy();
+
+	// Add an object to schedule, it is updated on the next Update
+	void AddObject(AnimatedObject* animatedObject);
+
+	// Updates the active objects and poses their rigs, viewProjMat is used to find the objects that are on screen.
+	// Jobs of grainSize objects are run on threadPool if there is one
+	bool Update(float dt, const Vector3& eyePosition, const Matrix4& viewProjMat, ThreadPool* threadPool = NULL, unsigned int grainSize = 32);
+
+	// Selects the objects sampled this frame and sets their level of detail. For users running the objects themselves
+	// instead of calling Update, with IsUpdated and IsOnScreen, then EndFrame with the time spent
+	void BeginFrame(const Vector3& eyePosition, const Matrix4& viewProjMat);
+
+	// Ends the frame started by BeginFrame, updateUSec and extrapolateUSec are the CPU time spent on the objects
+	// that were sampled and on the others, used to apply the budget
+	void EndFrame(int64_t updateUSec, int64_t extrapolateUSec);
+
+	// Indicates if the object at index is sampled this frame, extrapolated otherwise
+	inline bool IsUpdated(unsigned int index) { return mObjects[index].mUpdate; };
+
+	// Indicates if the object at index is on screen this frame, its rig only needs to be posed if it is or if it is sampled
+	inline bool IsOnScreen(unsigned int index) { return mObjects[index].mOnScreen; };
+
+	// Set how many of the objects, in the order they were added, are updated. All of them by default
+	inline void SetNumActiveObjects(unsigned int numActiveObjects) { mNumActiveObjects = min(numActiveObjects, (unsigned int)mObjects.size()); };
+
+	// Gets the address of mEnabled so it can be edited externally. When disabled every object is fully updated every frame
+	inline bool* GetEnabledPtr() { return &mEnabled; };
+
+	// Gets the address of mBudgetMs so it can be edited externally
+	inline float* GetBudgetMsPtr() { return &mBudgetMs; };
+
+	// Gets the number of objects sampled during the last Update
+	inline unsigned int GetNumUpdated() { return mNumUpdated; };
+
+	// Gets the number of objects that were due for an update during the last Update but exceeded the budget
+	inline unsigned int GetNumDeferred() { return mNumDeferred; };
+
+	// Gets the number of objects that were off screen during the last Update
+	inline unsigned int GetNumOffscreen() { return mNumOffscreen; };
+
+	// Gets the CPU time in milliseconds, summed over all threads, spent by the last Update on the objects
+	inline float GetCpuTimeMs() { return mCpuTimeMs; };
+
+private:
+
+	struct ScheduledObject
+	{
+		AnimatedObject* mAnimatedObject;
+
+		// Distance from the root of the object to the eye
+		float mDistance;
+
+		// Frames between the updates of the object at its current level of detail
+		unsigned int mUpdatePeriod;
+
+		// Frames since the object was last updated, UINT_MAX if it never was
+		unsigned int mFramesSinceUpdate;
+
+		// Offset of the frames the object is updated on, staggers the objects sharing a period
+		unsigned int mPhase;
+
+		// Whether the object is sampled or extrapolated this frame
+		bool mUpdate;
+
+		// Whether the bounding sphere of the object is in the view frustum, the rigs of objects
+		// that are off screen are only posed when they are sampled
+		bool mOnScreen;
+	};
+
+	struct DueObject
+	{
+		unsigned int mIndex;
+
+		// Frames since the last update relative to the update period, late objects come first
+		float mLateness;
+
+		// Closer objects come first among the ones as late
+		float mDistance;
+	};
+
+	struct UpdateJobData
+	{
+		AnimationScheduler* mAnimationScheduler;
+		unsigned int mBegin;
+		unsigned int mEnd;
+
+		// Time spent updating and extrapolating the objects of the job
+		int64_t mUpdateUSec;
+		int64_t mExtrapolateUSec;
+
+		bool mSuccess;
+	};
+
+	// Selects the objects updated this frame and their level of detail based on the view
+	void Schedule(const Vector3& eyePosition, const Matrix4& viewProjMat);
+
+	// Updates or extrapolates the objects of the job, then poses the rigs of the updated and on screen ones
+	void UpdateObjects(UpdateJobData& jobData);
+
+	// Job function for a range of objects
+	static void UpdateObjectsJob(void* pData);
+
+	LodLevel mLodLevels[MAX_NUM_LOD_LEVELS];
+
+	unsigned int mNumLodLevels;
+
+	unsigned int mOffscreenUpdatePeriod;
+
+	float mBoundingRadius;
+
+	float mBudgetMs;
+
+	// Toggle on whether or not levels of detail and the budget are used
+	bool mEnabled = true;
+
+	tinystl::vector<ScheduledObject> mObjects;
+
+	unsigned int mNumActiveObjects = 0;
+
+	// Objects due for an update this frame
+	tinystl::vector<DueObject> mDueObjects;
+
+	// Jobs of the last Update, kept to avoid allocating every frame
+	tinystl::vector<WorkItem> mWorkItems;
+	tinystl::vector<UpdateJobData> mJobData;
+
+	// Frames since Initialize
+	unsigned int mFrame = 0;
+
+	// Time step of the current Update
+	float mDeltaTime = 0.f;
+
+	// Running averages of the time in milliseconds to update, or to extrapolate, one object. Used to apply the budget
+	float mUpdateCostMs = 0.f;
+	float mExtrapolateCostMs = 0.f;
+
+	// Statistics of the last Update
+	unsigned int mNumUpdated = 0;
+	unsigned int mNumDeferred = 0;
+	unsigned int mNumOffscreen = 0;
+	float mCpuTimeMs = 0.f;
+};
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "AnimationSystem.h"
+
+// Jobs should take at least this long so the cost of running them stays small
+const float kMinJobUSec = 50.f;
+
+// Number of jobs per thread, more jobs balance the load better
+const unsigned int kJobsPerThread = 4;
+
+void AnimationSystem::Initialize(const AnimationSystemDesc& animationSystemDesc)
+{
+	mScheduler = animationSystemDesc.mScheduler;
+	mSkeletonBatcher = animationSystemDesc.mSkeletonBatcher;
+
+	// Objects never move so the pointers given by AddObject stay valid
+	mObjects.resize(animationSystemDesc.mMaxNumObjects);
+}
+
+void AnimationSystem::Destroy()
+{
+	for (unsigned int i = 0; i < mNumObjects; i++)
+	{
+		mObjects[i].Destroy();
+	}
+
+	mObjects.clear();
+	mWorkItems.clear();
+	mJobData.clear();
+	mNumObjects = 0;
+	mNumActiveObjects = 0;
+}
+
+AnimatedObject* AnimationSystem::AddObject(Rig* rig, Animation* animation)
+{
+	if (mNumObjects == mObjects.size())
+		return NULL;
+
+	AnimatedObject* animatedObject = &mObjects[mNumObjects++];
+	animatedObject->Initialize(rig, animation);
+
+	if (mScheduler)
+		mScheduler->AddObject(animatedObject);
+
+	if (mSkeletonBatcher)
+		mSkeletonBatcher->AddRig(rig);
+
+	mNumActiveObjects = mNumObjects;
+
+	return animatedObject;
+}
+
+void AnimationSystem::SetNumActiveObjects(unsigned int numActiveObjects)
+{
+	mNumActiveObjects = min(numActiveObjects, mNumObjects);
+
+	if (mScheduler)
+		mScheduler->SetNumActiveObjects(mNumActiveObjects);
+}
+
+void AnimationSystem::UpdateObjects(UpdateJobData& jobData)
+{
+	jobData.mSuccess = true;
+	jobData.mNumPosed = 0;
+
+	int64_t stageStartTime = getUSec();
+	int64_t stageEndTime;
+
+	// Sample and blend
+	for (unsigned int i = jobData.mBegin; i < jobData.mEnd; i++)
+	{
+		if (!mScheduler || mScheduler->IsUpdated(i))
+			jobData.mSuccess &= mObjects[i].Sample(mDeltaTime);
+	}
+
+	stageEndTime = getUSec();
+	jobData.mStageUSec[ANIMATION_STAGE_SAMPLE] = stageEndTime - stageStartTime;
+	stageStartTime = stageEndTime;
+
+	// Local to model
+	for (unsigned int i = jobData.mBegin; i < jobData.mEnd; i++)
+	{
+		if (!mScheduler || mScheduler->IsUpdated(i))
+			jobData.mSuccess &= mObjects[i].LocalToModel();
+	}
+
+	stageEndTime = getUSec();
+	jobData.mStageUSec[ANIMATION_STAGE_LOCAL_TO_MODEL] = stageEndTime - stageStartTime;
+	stageStartTime = stageEndTime;
+
+	// Extrapolate
+	if (mScheduler)
+	{
+		for (unsigned int i = jobData.mBegin; i < jobData.mEnd; i++)
+		{
+			if (mScheduler->IsUpdated(i))
+				continue;
+
+			// Off screen rigs are not posed, only their time has to be caught up by the next update
+			if (mScheduler->IsOnScreen(i))
+				jobData.mSuccess &= mObjects[i].Extrapolate(mDeltaTime);
+			else
+				mObjects[i].Skip(mDeltaTime);
+		}
+	}
+
+	stageEndTime = getUSec();
+	jobData.mStageUSec[ANIMATION_STAGE_EXTRAPOLATE] = stageEndTime - stageStartTime;
+	stageStartTime = stageEndTime;
+
+	// Pose the rigs, the ones of objects off screen are left as they are until they get sampled
+	for (unsigned int i = jobData.mBegin; i < jobData.mEnd; i++)
+	{
+		if (!mScheduler || mScheduler->IsUpdated(i) || mScheduler->IsOnScreen(i))
+		{
+			mObjects[i].PoseRig();
+			jobData.mNumPosed++;
+		}
+	}
+
+	stageEndTime = getUSec();
+	jobData.mStageUSec[ANIMATION_STAGE_POSE] = stageEndTime - stageStartTime;
+	stageStartTime = stageEndTime;
+
+	// Write the instance data while the rigs are still in cache
+	if (mWriteInstances)
+	{
+		for (unsigned int i = jobData.mBegin; i < jobData.mEnd; i++)
+		{
+			mSkeletonBatcher->WriteRigInstances(mFrameIndex, i);
+		}
+	}
+
+	jobData.mStageUSec[ANIMATION_STAGE_WRITE_INSTANCES] = getUSec() - stageStartTime;
+}
+
+void AnimationSystem::UpdateObjectsJob(void* pData)
+{
+	UpdateJobData* jobData = (UpdateJobData*)pData;
+	jobData->mAnimationSystem->UpdateObjects(*jobData);
+}
+
+bool AnimationSystem::Update(float dt, const Vector3& eyePosition, const Matrix4& viewProjMat, uint32_t frameIndex, ThreadPool* threadPool)
+{
+	const int64_t updateStartTime = getUSec();
+
+	mDeltaTime = dt;
+	mFrameIndex = frameIndex;
+	mWriteInstances = mSkeletonBatcher && mSkeletonBatcher->IsPersistentlyMapped();
+
+	if (mScheduler)
+		mScheduler->BeginFrame(eyePosition, viewProjMat);
+
+	// Enough jobs to balance the load between the threads, as long as they are not too short
+	if (mGrainSizeOverride > 0)
+	{
+		mGrainSize = mGrainSizeOverride;
+	}
+	else
+	{
+		const unsigned int numThreads = threadPool ? threadPool->GetNumThreads() + 1 : 1;
+		mGrainSize = (mNumActiveObjects + numThreads * kJobsPerThread - 1) / (numThreads * kJobsPerThread);
+		if (mObjectCostUSec > 0.f)
+			mGrainSize = max(mGrainSize, (unsigned int)(kMinJobUSec / mObjectCostUSec));
+		mGrainSize = max(mGrainSize, 1u);
+	}
+
+	const unsigned int numJobs = (mNumActiveObjects + mGrainSize - 1) / mGrainSize;
+	if (mJobData.size() < numJobs)
+	{
+		mWorkItems.resize(numJobs);
+		mJobData.resize(numJobs);
+	}
+
+	for (unsigned int jobIndex = 0; jobIndex < numJobs; jobIndex++)
+	{
+		UpdateJobData& jobData = mJobData[jobIndex];
+		jobData.mAnimationSystem = this;
+		jobData.mBegin = jobIndex * mGrainSize;
+		jobData.mEnd = (jobData.mBegin + mGrainSize < mNumActiveObjects) ? jobData.mBegin + mGrainSize : mNumActiveObjects;
+
+		if (threadPool && (numJobs > 1))
+		{
+			mWorkItems[jobIndex] = WorkItem();
+			mWorkItems[jobIndex].pFunc = UpdateObjectsJob;
+			mWorkItems[jobIndex].pData = &jobData;
+			threadPool->AddWorkItem(&mWorkItems[jobIndex]);
+		}
+		else
+		{
+			UpdateObjects(jobData);
+		}
+	}
+
+	// Ensure all jobs are finished before the rigs are used
+	if (threadPool && (numJobs > 1))
+		threadPool->Complete(0);
+
+	// Gather the timings of the jobs
+	bool success = true;
+	unsigned int numPosed = 0;
+	int64_t stageUSec[ANIMATION_STAGE_COUNT] = {};
+	for (unsigned int jobIndex = 0; jobIndex < numJobs; jobIndex++)
+	{
+		success &= mJobData[jobIndex].mSuccess;
+		numPosed += mJobData[jobIndex].mNumPosed;
+		for (unsigned int stage = 0; stage < ANIMATION_STAGE_COUNT; stage++)
+		{
+			stageUSec[stage] += mJobData[jobIndex].mStageUSec[stage];
+		}
+	}
+
+	// Instance data is written on this thread when the buffers are not mapped
+	if (mSkeletonBatcher)
+	{
+		const int64_t writeStartTime = getUSec();
+
+		if (mWriteInstances)
+			mSkeletonBatcher->FinalizeRigInstances(frameIndex, mNumActiveObjects);
+		else
+			mSkeletonBatcher->SetPerInstanceUniforms(frameIndex, (int)mNumActiveObjects);
+
+		stageUSec[ANIMATION_STAGE_WRITE_INSTANCES] += getUSec() - writeStartTime;
+	}
+
+	int64_t totalUSec = 0;
+	for (unsigned int stage = 0; stage < ANIMATION_STAGE_COUNT; stage++)
+	{
+		mStageMs[stage] = stageUSec[stage] / 1000.f;
+		totalUSec += stageUSec[stage];
+	}
+
+	if (mNumActiveObjects > 0)
+	{
+		const float runningAverageWeight = 0.1f;
+		const float objectCostUSec = (float)totalUSec / mNumActiveObjects;
+		mObjectCostUSec = (mObjectCostUSec > 0.f) ? mObjectCostUSec + (objectCostUSec - mObjectCostUSec) * runningAverageWeight : objectCostUSec;
+	}
+
+	// Split the cost of the shared stages between the sampled and the extrapolated objects for the budget
+	if (mScheduler)
+	{
+		const unsigned int numUpdated = mScheduler->GetNumUpdated();
+		const float poseShare = numPosed ? (float)numUpdated / numPosed : 0.f;
+		const float writeShare = mNumActiveObjects ? (float)numUpdated / mNumActiveObjects : 0.f;
+
+		const int64_t updateUSec = stageUSec[ANIMATION_STAGE_SAMPLE] + stageUSec[ANIMATION_STAGE_LOCAL_TO_MODEL] +
+			(int64_t)(stageUSec[ANIMATION_STAGE_POSE] * poseShare) + (int64_t)(stageUSec[ANIMATION_STAGE_WRITE_INSTANCES] * writeShare);
+		mScheduler->EndFrame(updateUSec, totalUSec - updateUSec);
+	}
+
+	mUpdateMs = (getUSec() - updateStartTime) / 1000.f;
+
+	return success;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Interfaces/IOperatingSystem.h"
+#include "../../Common_3/OS/Interfaces/IThread.h"
+
+#include "AnimatedObject.h"
+#include "AnimationScheduler.h"
+#include "SkeletonBatcher.h"
+
+// Stages of the animation pipeline run by AnimationSystem::Update for each object
+enum AnimationStage
+{
+	ANIMATION_STAGE_SAMPLE,				// Sampling and blending of the clips
+	ANIMATION_STAGE_LOCAL_TO_MODEL,		// Local to model conversion of the sampled objects
+	ANIMATION_STAGE_EXTRAPOLATE,		// Extrapolation of the objects that were not sampled
+	ANIMATION_STAGE_POSE,				// World matrices of the rigs
+	ANIMATION_STAGE_WRITE_INSTANCES,	// Instance data of the rigs written to the SkeletonBatcher
+	ANIMATION_STAGE_COUNT
+};
+
+// User will have to predefine to pass into AnimationSystem's initialize function
+struct AnimationSystemDesc
+{
+	// Storage for this many objects is allocated up front
+	unsigned int mMaxNumObjects;
+
+	// When set, picks the objects sampled each frame, the others are extrapolated
+	AnimationScheduler* mScheduler = nullptr;
+
+	// When set, the rigs of the objects are added to it and their instance data is written every Update
+	SkeletonBatcher* mSkeletonBatcher = nullptr;
+};
+
+// Owns the AnimatedObjects of a scene in contiguous storage and updates all of them with one parallel pipeline.
+// Each job takes a range of objects through sampling, local to model, posing and the writing of the instance data,
+// the number of objects per job is picked from the number of threads and the measured cost of an object
+class AnimationSystem
+{
+
+public:
+
+	// Allocate the storage of the objects
+	void Initialize(const AnimationSystemDesc& animationSystemDesc);
+
+	// Must be called to clean up the system if it was initialized, destroys the objects
+	void Destroy();
+
+	// Initialize a new object with the Rig it will be posing and its Animation. Returns NULL if there is no storage left
+	AnimatedObject* AddObject(Rig* rig, Animation* animation);
+
+	// Updates the active objects and writes their instance data for frameIndex.
+	// The eye position and view projection matrix are used by the scheduler
+	bool Update(float dt, const Vector3& eyePosition, const Matrix4& viewProjMat, uint32_t frameIndex, ThreadPool* threadPool = NULL);
+
+	// Set how many of the objects, in the order they were added, are updated and drawn. All of them by default
+	void SetNumActiveObjects(unsigned int numActiveObjects);
+
+	// Get the object at index
+	inline AnimatedObject* GetObject(unsigned int index) { return &mObjects[index]; };
+
+	// Get the number of objects added
+	inline unsigned int GetNumObjects() { return mNumObjects; };
+
+	// Gets the CPU time in milliseconds, summed over all threads, the last Update spent in stage
+	inline float GetStageMs(AnimationStage stage) { return mStageMs[stage]; };
+
+	// Gets the time in milliseconds the last Update took
+	inline float GetUpdateMs() { return mUpdateMs; };
+
+	// Gets the number of objects per job of the last Update
+	inline unsigned int GetGrainSize() { return mGrainSize; };
+
+	// Gets the address of mGrainSizeOverride so it can be edited externally. When 0 the grain size is picked automatically
+	inline unsigned int* GetGrainSizeOverridePtr() { return &mGrainSizeOverride; };
+
+private:
+
+	struct UpdateJobData
+	{
+		AnimationSystem* mAnimationSystem;
+		unsigned int mBegin;
+		unsigned int mEnd;
+
+		// Time spent in each stage for the objects of the job
+		int64_t mStageUSec[ANIMATION_STAGE_COUNT];
+
+		// Number of rigs posed by the job
+		unsigned int mNumPosed;
+
+		bool mSuccess;
+	};
+
+	// Runs the pipeline for the objects of the job
+	void UpdateObjects(UpdateJobData& jobData);
+
+	// Job function for a range of objects
+	static void UpdateObjectsJob(void* pData);
+
+	// Contiguous storage of the objects
+	tinystl::vector<AnimatedObject> mObjects;
+
+	unsigned int mNumObjects = 0;
+
+	unsigned int mNumActiveObjects = 0;
+
+	AnimationScheduler* mScheduler;
+
+	SkeletonBatcher* mSkeletonBatcher;
+
+	// Jobs of the last Update, kept to avoid allocating every frame
+	tinystl::vector<WorkItem> mWorkItems;
+	tinystl::vector<UpdateJobData> mJobData;
+
+	// Parameters of the current Update read by the jobs
+	float mDeltaTime = 0.f;
+	uint32_t mFrameIndex = 0;
+	bool mWriteInstances = false;
+
+	// Number of objects per job, 0 to pick it from the number of threads and the cost of the objects
+	unsigned int mGrainSizeOverride = 0;
+
+	// Running average of the CPU time in microseconds of one object, used to size the jobs
+	float mObjectCostUSec = 0.f;
+
+	// Statistics of the last Update
+	float mStageMs[ANIMATION_STAGE_COUNT] = {};
+	float mUpdateMs = 0.f;
+	unsigned int mGrainSize = 0;
+};
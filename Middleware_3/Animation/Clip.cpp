@@ -26,11 +26,16 @@
 
 void Clip::Initialize(const char* animationFile, Rig* rig)
 {
-	LoadClip(animationFile); 
+	const int64_t loadStartTime = getUSec();
+	const bool loaded = LoadClip(animationFile);
+	mLoadMs = (getUSec() - loadStartTime) / 1000.0f;
+
+	mLoaded = loaded;
 }
 
 void Clip::Destroy()
 {
+	mLoaded = false;
 	mAnimation.Deallocate();
 }
 
@@ -52,7 +57,8 @@ bool Clip::Sample(ozz::animation::SamplingCache* cacheInput, ozz::Range<SoaTrans
 
 bool Clip::LoadClip(const char* fileName)
 {
-	ozz::io::File file(fileName, "rb");
+	// The archive is read straight out of the mapped file
+	MappedStream file(fileName);
 	if (!file.opened())
 	{
 		ozz::log::Err() << "Cannot open file " << fileName << "." << std::endl;
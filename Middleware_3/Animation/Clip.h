@@ -54,6 +54,15 @@ public:
 	// Get the length of the clip
 	inline float GetDuration() { return mAnimation.duration(); };
 
+	// Returns true once the clip is loaded, can be polled while it loads asynchronously
+	inline bool IsLoaded() { return mLoaded; };
+
+	// Get the size in bytes of the runtime animation of the clip
+	inline size_t GetMemorySize() { return mAnimation.size(); };
+
+	// Get the time in milliseconds it took to load the clip
+	inline float GetLoadMs() { return mLoadMs; };
+
 private:
 
 	// Load a clip from an ozz animation file
@@ -61,4 +70,9 @@ private:
 
 	// Runtime animation.
 	ozz::animation::Animation mAnimation;
+
+	// Set once the clip is loaded, loads can happen on a ClipLoader thread
+	volatile bool mLoaded = false;
+
+	float mLoadMs = 0.0f;
 };
\ No newline at end of file
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "ClipLoader.h"
+
+// ConditionVariable::Wait needs a timeout, the waits are ended by the conditions being set
+const unsigned int CLIP_LOADER_WAIT_MS = 1000;
+
+void ClipLoader::Initialize()
+{
+	mShutDown = false;
+	mNumPending = 0;
+
+	mThreadItem.pFunc = LoaderThreadFunc;
+	mThreadItem.pData = this;
+	pThread = _createThread(&mThreadItem);
+}
+
+void ClipLoader::Destroy()
+{
+	WaitIdle();
+
+	mRequestMutex.Acquire();
+	mShutDown = true;
+	mRequestCondition.Set();
+	mRequestMutex.Release();
+
+	_joinThread(pThread);
+}
+
+void ClipLoader::LoadClip(Clip* clip, const char* animationFile, Rig* rig, ClipLoadedCallback callback, void* pUserData)
+{
+	ASSERT(!mShutDown);
+
+	LoadRequest request;
+	request.mClip = clip;
+	request.mFileName = animationFile;
+	request.mRig = rig;
+	request.mCallback = callback;
+	request.pUserData = pUserData;
+
+	MutexLock lock(mRequestMutex);
+	mRequests.push_back(request);
+	mNumPending++;
+	mRequestCondition.Set();
+}
+
+void ClipLoader::WaitIdle()
+{
+	MutexLock lock(mRequestMutex);
+	while (mNumPending > 0)
+		mIdleCondition.Wait(mRequestMutex, CLIP_LOADER_WAIT_MS);
+
+	// Set only wakes one waiter, pass it on to the others
+	mIdleCondition.Set();
+}
+
+void ClipLoader::LoaderThreadFunc(void* pData)
+{
+	ClipLoader* loader = (ClipLoader*)pData;
+
+	while (true)
+	{
+		// Sleep until a request is queued or the loader is destroyed, then take the oldest request
+		loader->mRequestMutex.Acquire();
+		while (loader->mRequests.empty() && !loader->mShutDown)
+			loader->mRequestCondition.Wait(loader->mRequestMutex, CLIP_LOADER_WAIT_MS);
+		if (loader->mRequests.empty())
+		{
+			loader->mRequestMutex.Release();
+			break;
+		}
+		LoadRequest request = loader->mRequests[0];
+		loader->mRequests.erase(loader->mRequests.begin());
+		loader->mRequestMutex.Release();
+
+		request.mClip->Initialize(request.mFileName.c_str(), request.mRig);
+
+		if (request.mCallback)
+			request.mCallback(request.mClip, request.mClip->IsLoaded(), request.pUserData);
+
+		loader->mRequestMutex.Acquire();
+		if (--loader->mNumPending == 0)
+			loader->mIdleCondition.Set();
+		loader->mRequestMutex.Release();
+	}
+}
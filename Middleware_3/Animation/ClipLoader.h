@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Interfaces/IThread.h"
+#include "../../Common_3/ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../../Common_3/ThirdParty/OpenSource/TinySTL/string.h"
+
+#include "Clip.h"
+
+// Called from the loader thread once a clip requested from a ClipLoader is loaded
+typedef void(*ClipLoadedCallback)(Clip* clip, bool success, void* pUserData);
+
+// Loads clips on its own thread so the thread requesting them does not wait on the files.
+// Clips must not be used before they are loaded, see Clip::IsLoaded and the callback of LoadClip
+class ClipLoader
+{
+
+public:
+
+	// Starts the loader thread
+	void Initialize();
+
+	// Must be called to clean up if the loader was initialized, finishes the pending loads first
+	void Destroy();
+
+	// Queues the load of the clip at animationFile into clip. callback is called from the loader thread once it is loaded
+	void LoadClip(Clip* clip, const char* animationFile, Rig* rig, ClipLoadedCallback callback = NULL, void* pUserData = NULL);
+
+	// Waits for all the queued loads to finish
+	void WaitIdle();
+
+	// Get the number of loads queued or in progress
+	inline unsigned int GetNumPending() { return mNumPending; };
+
+private:
+
+	struct LoadRequest
+	{
+		Clip* mClip;
+		tinystl::string mFileName;
+		Rig* mRig;
+		ClipLoadedCallback mCallback;
+		void* pUserData;
+	};
+
+	// Loads the queued clips until the loader is destroyed
+	static void LoaderThreadFunc(void* pData);
+
+	// Queued loads
+	tinystl::vector<LoadRequest> mRequests;
+	Mutex mRequestMutex;
+
+	// Set when a load is queued or the loader is destroyed, the loader thread sleeps on it
+	ConditionVariable mRequestCondition;
+
+	// Set when the last pending load finishes, WaitIdle sleeps on it
+	ConditionVariable mIdleCondition;
+
+	// Thread the clips are loaded on
+	WorkItem mThreadItem;
+	ThreadHandle pThread;
+
+	volatile unsigned int mNumPending = 0;
+	volatile bool mShutDown = false;
+};
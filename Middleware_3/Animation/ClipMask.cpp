@@ -33,6 +33,7 @@ void ClipMask::Initialize(Rig* rig)
 	// Allocates per-joint weights used to mask the animation. Note that
 	// this is a Soa structure.
 	mJointWeights = allocator->AllocateRange<Vector4>(rig->GetNumSoaJoints());
+	mSoaJointActive.resize(rig->GetNumSoaJoints());
 
 	EnableAllJoints();
 }
@@ -50,6 +51,8 @@ void ClipMask::EnableAllJoints()
 	for (unsigned int i = 0; i < mRig->GetNumSoaJoints(); i++) {
 		mJointWeights[i] = Vector4::one();
 	}
+
+	UpdateActiveJoints();
 }
 
 void ClipMask::DisableAllJoints()
@@ -58,6 +61,8 @@ void ClipMask::DisableAllJoints()
 	for (unsigned int i = 0; i < mRig->GetNumSoaJoints(); i++) {
 		mJointWeights[i] = Vector4::zero();
 	}
+
+	UpdateActiveJoints();
 }
 
 void ClipMask::SetAllChildrenOf(int jointIndex, float setValue)
@@ -73,4 +78,31 @@ void ClipMask::SetAllChildrenOf(int jointIndex, float setValue)
 		
 		mJointWeights[jointId / 4].setElem(jointId % 4, setValue);
 	}
-}
\ No newline at end of file
+
+	UpdateActiveJoints();
+}
+
+void ClipMask::UpdateActiveJoints()
+{
+	const unsigned int numJoints = mRig->GetNumJoints();
+	const unsigned int numSoaJoints = mRig->GetNumSoaJoints();
+
+	mNumActiveSoaJoints = 0;
+	mFull = true;
+
+	for (unsigned int i = 0; i < numSoaJoints; i++)
+	{
+		// Padding joints of the last block are not part of the skeleton and are ignored
+		bool active = false;
+		for (unsigned int j = 0; j < 4 && (i * 4 + j) < numJoints; j++)
+		{
+			const float weight = mJointWeights[i].getElem(j);
+			active |= (weight > 0.0f);
+			mFull &= (weight == 1.0f);
+		}
+
+		mSoaJointActive[i] = active ? 1 : 0;
+		if (active)
+			mNumActiveSoaJoints++;
+	}
+}
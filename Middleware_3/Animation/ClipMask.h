@@ -54,10 +54,22 @@ public:
 	void SetAllChildrenOf(int jointIndex, float setValue);
 
 	// Get the joint weights
-	inline ozz::Range<Vector4> GetJointWeights() { return mJointWeights; };
+	inline ozz::Range<const Vector4> GetJointWeights() { return mJointWeights; };
+
+	// Indicates if any joint of the SoA block of 4 joints at soaJointIndex has a weight above zero
+	inline bool IsSoaJointActive(unsigned int soaJointIndex) { return mSoaJointActive[soaJointIndex] != 0; };
+
+	// Get the number of SoA blocks with a weight above zero
+	inline unsigned int GetNumActiveSoaJoints() { return mNumActiveSoaJoints; };
+
+	// Indicates if every joint has a weight of 1.0f, in which case the mask has no effect
+	inline bool IsFull() { return mFull; };
 
 private:
 
+	// Updates the active SoA blocks after the joint weights changed
+	void UpdateActiveJoints();
+
 	// Pointer to the rig that this clip mask corresponds to
 	Rig * mRig;
 
@@ -66,4 +78,13 @@ private:
 	// weight_setting.
 	ozz::Range<Vector4> mJointWeights;
 
+	// Non zero for each SoA block of 4 joints with a weight above zero
+	tinystl::vector<unsigned char> mSoaJointActive;
+
+	// Number of SoA blocks with a weight above zero
+	unsigned int mNumActiveSoaJoints = 0;
+
+	// True when every joint has a weight of 1.0f
+	bool mFull = false;
+
 };
\ No newline at end of file
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "ClipOptimizer.h"
+
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/offline/raw_animation.h"
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/offline/animation_builder.h"
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/offline/animation_optimizer.h"
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/runtime/local_to_model_job.h"
+
+// Model space matrices of the joints of rig for the clip at timeRatio
+static bool SampleModelMats(Rig* rig, Clip* clip, ozz::animation::SamplingCache* cache, ozz::Range<SoaTransform>& localTrans, ozz::Range<Matrix4>& modelMats, float timeRatio)
+{
+	if (!clip->Sample(cache, localTrans, timeRatio))
+		return false;
+
+	ozz::animation::LocalToModelJob ltmJob;
+	ltmJob.skeleton = rig->GetSkeleton();
+	ltmJob.input = localTrans;
+	ltmJob.output = modelMats;
+	return ltmJob.Run();
+}
+
+bool ClipOptimizer::OptimizeClip(Rig* rig, const char* sourceFile, const char* destinationFile, const ClipOptimizerDesc& clipOptimizerDesc, ClipOptimizerStats* pStats)
+{
+	ASSERT(clipOptimizerDesc.mSampleRate > 0.0f);
+
+	Clip sourceClip;
+	sourceClip.Initialize(sourceFile, rig);
+	if (!sourceClip.IsLoaded())
+		return false;
+
+	const float duration = sourceClip.GetDuration();
+	const unsigned int numJoints = rig->GetNumJoints();
+	const unsigned int numSamples = (unsigned int)ceilf(duration * clipOptimizerDesc.mSampleRate) + 1;
+
+	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+	ozz::animation::SamplingCache* cache = allocator->New<ozz::animation::SamplingCache>(numJoints);
+	ozz::Range<SoaTransform> localTrans = allocator->AllocateRange<SoaTransform>(rig->GetNumSoaJoints());
+
+	// Rebuild the keyframes of the source clip by sampling it
+	ozz::animation::offline::RawAnimation rawAnimation;
+	rawAnimation.duration = duration;
+	rawAnimation.tracks.resize(numJoints);
+
+	for (unsigned int sample = 0; sample < numSamples; sample++)
+	{
+		const float time = min(sample / clipOptimizerDesc.mSampleRate, duration);
+		sourceClip.Sample(cache, localTrans, time / duration);
+
+		for (unsigned int joint = 0; joint < numJoints; joint++)
+		{
+			const SoaTransform& transform = localTrans[joint / 4];
+			const int lane = joint % 4;
+			ozz::animation::offline::RawAnimation::JointTrack& track = rawAnimation.tracks[joint];
+
+			const ozz::animation::offline::RawAnimation::TranslationKey translationKey = { time,
+				ozz::math::Float3(transform.translation.x[lane], transform.translation.y[lane], transform.translation.z[lane]) };
+			track.translations.push_back(translationKey);
+
+			ozz::animation::offline::RawAnimation::RotationKey rotationKey = { time,
+				ozz::math::Quaternion(transform.rotation.x[lane], transform.rotation.y[lane], transform.rotation.z[lane], transform.rotation.w[lane]) };
+
+			// Keeps the rotations in the same hemisphere so they interpolate along the shortest path
+			if (!track.rotations.empty())
+			{
+				const ozz::math::Quaternion& previous = track.rotations.back().value;
+				if (previous.x * rotationKey.value.x + previous.y * rotationKey.value.y + previous.z * rotationKey.value.z + previous.w * rotationKey.value.w < 0.0f)
+					rotationKey.value = -rotationKey.value;
+			}
+			track.rotations.push_back(rotationKey);
+
+			const ozz::animation::offline::RawAnimation::ScaleKey scaleKey = { time,
+				ozz::math::Float3(transform.scale.x[lane], transform.scale.y[lane], transform.scale.z[lane]) };
+			track.scales.push_back(scaleKey);
+		}
+	}
+
+	// Reduce the keyframes within the error bounds, measured along the hierarchy of the rig
+	ozz::animation::offline::AnimationOptimizer optimizer;
+	optimizer.translation_tolerance = clipOptimizerDesc.mTranslationTolerance;
+	optimizer.rotation_tolerance = clipOptimizerDesc.mRotationTolerance;
+	optimizer.scale_tolerance = clipOptimizerDesc.mScaleTolerance;
+	optimizer.hierarchical_tolerance = clipOptimizerDesc.mHierarchicalTolerance;
+
+	ozz::animation::offline::RawAnimation optimizedRawAnimation;
+	bool success = optimizer(rawAnimation, *rig->GetSkeleton(), &optimizedRawAnimation);
+
+	// Build the runtime animation, which quantizes the keyframes, and save it
+	ozz::animation::Animation* optimizedAnimation = NULL;
+	if (success)
+	{
+		ozz::animation::offline::AnimationBuilder builder;
+		optimizedAnimation = builder(optimizedRawAnimation);
+		success = optimizedAnimation != NULL;
+	}
+
+	if (success)
+	{
+		ozz::io::File file(destinationFile, "wb");
+		if (file.opened())
+		{
+			ozz::io::OArchive archive(&file);
+			archive << *optimizedAnimation;
+		}
+		else
+		{
+			ErrorMsg("Cannot open optimized clip file");
+			success = false;
+		}
+	}
+
+	// Measure the error of the saved clip in model space, between the sampled keyframes as well
+	if (success && pStats)
+	{
+		pStats->mSourceSize = sourceClip.GetMemorySize();
+		pStats->mOptimizedSize = optimizedAnimation->size();
+		pStats->mNumSampledKeys = 0;
+		pStats->mNumOptimizedKeys = 0;
+		for (unsigned int joint = 0; joint < numJoints; joint++)
+		{
+			pStats->mNumSampledKeys += (unsigned int)(rawAnimation.tracks[joint].translations.size() + rawAnimation.tracks[joint].rotations.size() + rawAnimation.tracks[joint].scales.size());
+			pStats->mNumOptimizedKeys += (unsigned int)(optimizedRawAnimation.tracks[joint].translations.size() + optimizedRawAnimation.tracks[joint].rotations.size() + optimizedRawAnimation.tracks[joint].scales.size());
+		}
+		pStats->mMaxJointError = 0.0f;
+
+		Clip optimizedClip;
+		optimizedClip.Initialize(destinationFile, rig);
+		success = optimizedClip.IsLoaded();
+
+		if (success)
+		{
+			ozz::animation::SamplingCache* optimizedCache = allocator->New<ozz::animation::SamplingCache>(numJoints);
+			ozz::Range<SoaTransform> optimizedLocalTrans = allocator->AllocateRange<SoaTransform>(rig->GetNumSoaJoints());
+			ozz::Range<Matrix4> modelMats = allocator->AllocateRange<Matrix4>(numJoints);
+			ozz::Range<Matrix4> optimizedModelMats = allocator->AllocateRange<Matrix4>(numJoints);
+
+			const unsigned int numErrorSamples = (numSamples - 1) * 4 + 1;
+			for (unsigned int sample = 0; sample < numErrorSamples; sample++)
+			{
+				const float timeRatio = (float)sample / (numErrorSamples - 1);
+				SampleModelMats(rig, &sourceClip, cache, localTrans, modelMats, timeRatio);
+				SampleModelMats(rig, &optimizedClip, optimizedCache, optimizedLocalTrans, optimizedModelMats, timeRatio);
+
+				for (unsigned int joint = 0; joint < numJoints; joint++)
+				{
+					const float error = length(modelMats[joint].getTranslation() - optimizedModelMats[joint].getTranslation());
+					pStats->mMaxJointError = max(pStats->mMaxJointError, error);
+				}
+			}
+
+			allocator->Deallocate(optimizedModelMats);
+			allocator->Deallocate(modelMats);
+			allocator->Deallocate(optimizedLocalTrans);
+			allocator->Delete(optimizedCache);
+		}
+
+		optimizedClip.Destroy();
+	}
+
+	if (optimizedAnimation)
+	{
+		optimizedAnimation->Deallocate();
+		allocator->Delete(optimizedAnimation);
+	}
+	allocator->Deallocate(localTrans);
+	allocator->Delete(cache);
+	sourceClip.Destroy();
+
+	return success;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "Clip.h"
+
+// User will have to predefine to pass into ClipOptimizer's OptimizeClip function.
+// The defaults are the tolerances of the ozz optimizer, favoring quality
+struct ClipOptimizerDesc
+{
+	// Rate in Hz the source clip is sampled at to rebuild its keyframes
+	float mSampleRate = 30.0f;
+
+	// Error allowed on the translations of a joint in meters
+	float mTranslationTolerance = 1e-3f;
+
+	// Error allowed on the rotations of a joint in radians
+	float mRotationTolerance = 0.1f * PI / 180.0f;
+
+	// Error allowed on the scales of a joint
+	float mScaleTolerance = 1e-3f;
+
+	// Error in meters that the optimization of a joint is allowed to cause on its whole child hierarchy
+	float mHierarchicalTolerance = 1e-3f;
+};
+
+// Results of ClipOptimizer::OptimizeClip
+struct ClipOptimizerStats
+{
+	// Size in bytes of the runtime animation before and after the optimization
+	size_t mSourceSize;
+	size_t mOptimizedSize;
+
+	// Number of keyframes sampled from the source clip and kept by the optimization
+	unsigned int mNumSampledKeys;
+	unsigned int mNumOptimizedKeys;
+
+	// Largest distance in meters between a joint of the source and of the optimized clip, in model space
+	float mMaxJointError;
+};
+
+// Offline optimization of the clips of a rig. The keyframes of each track are reduced within error bounds that
+// account for the joint hierarchy of the rig, the rotations of the saved clip are quantized to 16 bits per component
+class ClipOptimizer
+{
+
+public:
+
+	// Optimizes the clip at sourceFile for rig and saves it to destinationFile
+	static bool OptimizeClip(Rig* rig, const char* sourceFile, const char* destinationFile, const ClipOptimizerDesc& clipOptimizerDesc, ClipOptimizerStats* pStats = NULL);
+};
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "LodMask.h"
+
+void LodMask::Initialize(Rig* rig)
+{
+	mRig = rig;
+
+	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+
+	mSoaJointMasks = tinystl::vector<unsigned char>(rig->GetNumSoaJoints());
+	mBindLocalMats = allocator->AllocateRange<Matrix4>(rig->GetNumSoaJoints() * 4);
+
+	// Converts the bind pose to local matrices once, 4 joints at a time
+	ozz::Range<const SoaTransform> bindPose = rig->GetSkeleton()->bind_pose();
+	for (unsigned int i = 0; i < rig->GetNumSoaJoints(); i++)
+	{
+		const SoaFloat4x4 soaMatrices = SoaFloat4x4::FromAffine(bindPose[i].translation, bindPose[i].rotation, bindPose[i].scale);
+		Vector4 aosMatrices[16];
+		transpose16x16(&soaMatrices.cols[0].x, aosMatrices);
+
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			mBindLocalMats[i * 4 + j] = Matrix4(aosMatrices[j * 4], aosMatrices[j * 4 + 1], aosMatrices[j * 4 + 2], aosMatrices[j * 4 + 3]);
+		}
+	}
+
+	EnableAllJoints();
+}
+
+void LodMask::Destroy()
+{
+	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+	allocator->Deallocate(mBindLocalMats);
+	mSoaJointMasks.clear();
+}
+
+void LodMask::EnableAllJoints()
+{
+	for (unsigned int i = 0; i < mSoaJointMasks.size(); i++) {
+		mSoaJointMasks[i] = 0xf;
+	}
+}
+
+void LodMask::DisableAllJoints()
+{
+	for (unsigned int i = 0; i < mSoaJointMasks.size(); i++) {
+		mSoaJointMasks[i] = 0;
+	}
+}
+
+void LodMask::SetAllChildrenOf(int jointIndex, bool setValue)
+{
+	// Extracts the list of children of the joint at jointIndex.
+	ozz::animation::JointsIterator it;
+	ozz::animation::IterateJointsDF(*mRig->GetSkeleton(), jointIndex, &it);
+
+	for (int i = 0; i < it.num_joints; i++) {
+		const int jointId = it.joints[i];
+
+		if (setValue)
+			mSoaJointMasks[jointId / 4] |= (unsigned char)(1u << (jointId % 4));
+		else
+			mSoaJointMasks[jointId / 4] &= (unsigned char)~(1u << (jointId % 4));
+	}
+}
+
+unsigned int LodMask::GetNumEnabledJoints()
+{
+	unsigned int numEnabledJoints = 0;
+	for (unsigned int i = 0; i < mRig->GetNumJoints(); i++)
+	{
+		if (IsJointEnabled(i))
+			numEnabledJoints++;
+	}
+	return numEnabledJoints;
+}
+
+bool LodMask::LocalToModel(ozz::Range<const SoaTransform> localTrans, ozz::Range<Matrix4> modelMats)
+{
+	const unsigned int numJoints = mRig->GetNumJoints();
+	if ((localTrans.count() < mRig->GetNumSoaJoints()) || (modelMats.count() < numJoints))
+		return false;
+
+	ozz::Range<const ozz::animation::Skeleton::JointProperties> properties = mRig->GetSkeleton()->joint_properties();
+
+	for (unsigned int soaJoint = 0; soaJoint < mRig->GetNumSoaJoints(); soaJoint++)
+	{
+		const unsigned char mask = mSoaJointMasks[soaJoint];
+		const Matrix4* bindLocalMats = &mBindLocalMats[soaJoint * 4];
+
+		// Builds the local matrices of the block, only if one of its joints is enabled
+		Vector4 aosMatrices[16];
+		if (mask)
+		{
+			const SoaTransform& transform = localTrans[soaJoint];
+			const SoaFloat4x4 soaMatrices = SoaFloat4x4::FromAffine(transform.translation, transform.rotation, transform.scale);
+			transpose16x16(&soaMatrices.cols[0].x, aosMatrices);
+		}
+
+		// Applies hierarchical transformation, joints are sorted so parents come first
+		const unsigned int firstJoint = soaJoint * 4;
+		const unsigned int lastJoint = min(firstJoint + 4, numJoints);
+		for (unsigned int joint = firstJoint; joint < lastJoint; joint++)
+		{
+			const unsigned int lane = joint - firstJoint;
+			const Matrix4 localMat = (mask & (1u << lane)) ?
+				Matrix4(aosMatrices[lane * 4], aosMatrices[lane * 4 + 1], aosMatrices[lane * 4 + 2], aosMatrices[lane * 4 + 3]) :
+				bindLocalMats[lane];
+
+			const int parent = properties[joint].parent;
+			if (parent == ozz::animation::Skeleton::kNoParentIndex)
+				modelMats[joint] = localMat;
+			else
+				modelMats[joint] = modelMats[parent] * localMat;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Math/MathTypes.h"
+
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/base/memory/allocator.h"
+
+#include "Rig.h"
+
+
+// Selects the joints of a Rig that are evaluated at a level of detail.
+// Disabled joints are not converted to model space from the animation, they follow their parent in bind pose
+class LodMask 
+{
+
+public:
+
+	// Set up a mask associated with a rig, all joints start enabled
+	void Initialize(Rig* rig);
+
+	// Must be called to clean up if the lod mask was initialized
+	void Destroy();
+
+	// Will enable all joints
+	void EnableAllJoints();
+
+	// Will disable all joints
+	void DisableAllJoints();
+
+	// Will enable or disable the joint at jointIndex and all of its children.
+	// Other joints are left as they are
+	void SetAllChildrenOf(int jointIndex, bool setValue);
+
+	// Indicates if the joint at jointIndex is evaluated
+	inline bool IsJointEnabled(unsigned int jointIndex) { return (mSoaJointMasks[jointIndex / 4] & (1u << (jointIndex % 4))) != 0; };
+
+	// Get the number of enabled joints
+	unsigned int GetNumEnabledJoints();
+
+	// Computes the model matrices of the rig from localTrans. SoA blocks of 4 joints that are all disabled
+	// skip the conversion of their local transforms and use the bind pose
+	bool LocalToModel(ozz::Range<const SoaTransform> localTrans, ozz::Range<Matrix4> modelMats);
+
+private:
+
+	// Pointer to the rig that this lod mask corresponds to
+	Rig* mRig;
+
+	// One bit per joint of each SoA block of 4 joints
+	tinystl::vector<unsigned char> mSoaJointMasks;
+
+	// Local matrices of the skeleton's bind pose, used for the disabled joints
+	ozz::Range<Matrix4> mBindLocalMats;
+};
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "MappedStream.h"
+
+MappedStream::MappedStream(const char* fileName)
+{
+	mFile.Open(fileName, FSR_Absolute);
+}
+
+MappedStream::~MappedStream()
+{
+	mFile.Close();
+}
+
+bool MappedStream::opened() const
+{
+	return mFile.IsOpen();
+}
+
+size_t MappedStream::Read(void* buffer, size_t size)
+{
+	if (mPosition >= mFile.GetSize())
+		return 0;
+
+	const size_t readSize = (size < mFile.GetSize() - mPosition) ? size : mFile.GetSize() - mPosition;
+	memcpy(buffer, (const char*)mFile.GetData() + mPosition, readSize);
+	mPosition += readSize;
+	return readSize;
+}
+
+size_t MappedStream::Write(const void*, size_t)
+{
+	return 0;
+}
+
+int MappedStream::Seek(int offset, Origin origin)
+{
+	int64_t position;
+	switch (origin)
+	{
+	case kCurrent: position = (int64_t)mPosition + offset; break;
+	case kEnd: position = (int64_t)mFile.GetSize() + offset; break;
+	case kSet: position = offset; break;
+	default: return -1;
+	}
+
+	// Like a file, the position can be past the end but not before the beginning
+	if (position < 0)
+		return -1;
+
+	mPosition = (size_t)position;
+	return 0;
+}
+
+int MappedStream::Tell() const
+{
+	return (int)mPosition;
+}
+
+size_t MappedStream::Size() const
+{
+	return mFile.GetSize();
+}
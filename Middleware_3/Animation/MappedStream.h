@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Interfaces/IFileSystem.h"
+
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/base/io/stream.h"
+
+// Read only ozz stream over a file mapped into memory, used to load the ozz archives of rigs and clips.
+// Reads are copies out of the mapping instead of buffered file reads. The pages are only loaded when first
+// read and, as they are never written, are shared with every other process and load mapping the same file
+class MappedStream : public ozz::io::Stream
+{
+
+public:
+
+	// Maps the file at the full path fileName
+	MappedStream(const char* fileName);
+
+	virtual ~MappedStream();
+
+	// Tests whether the file could be mapped
+	virtual bool opened() const;
+
+	// Copies size bytes out of the mapping to buffer. Returns the number of bytes read
+	virtual size_t Read(void* buffer, size_t size);
+
+	// The stream is read only, always returns 0
+	virtual size_t Write(const void* buffer, size_t size);
+
+	// Moves the read position, returns 0 if successful
+	virtual int Seek(int offset, Origin origin);
+
+	// Returns the read position
+	virtual int Tell() const;
+
+	// Returns the size of the file
+	virtual size_t Size() const;
+
+private:
+
+	// The mapped file
+	MappedFile mFile;
+
+	// Read position in the mapping
+	size_t mPosition = 0;
+};
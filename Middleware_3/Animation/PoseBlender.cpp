@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "PoseBlender.h"
+
+// The passes below are the ones of ozz's BlendingJob, applied to a single SoA block of 4 joints
+
+static OZZ_INLINE void BlendFirstPass(const SoaTransform& src, const Vector4& weight, SoaTransform& dest)
+{
+	dest.translation = src.translation * weight;
+	dest.rotation = src.rotation * weight;
+	dest.scale = src.scale * weight;
+}
+
+static OZZ_INLINE void BlendPass(const SoaTransform& src, const Vector4& weight, SoaTransform& dest)
+{
+	dest.translation = dest.translation + src.translation * weight;
+
+	// Negates opposed quaternions to take the shortest path between the two
+	const Vector4 dot =
+		mulPerElem(dest.rotation.x, src.rotation.x) + mulPerElem(dest.rotation.y, src.rotation.y) +
+		mulPerElem(dest.rotation.z, src.rotation.z) + mulPerElem(dest.rotation.w, src.rotation.w);
+	const Vector4Int sign = signBit(dot);
+	const SoaQuaternion rotation = {
+		xorPerElem(src.rotation.x, sign), xorPerElem(src.rotation.y, sign),
+		xorPerElem(src.rotation.z, sign), xorPerElem(src.rotation.w, sign) };
+	dest.rotation = dest.rotation + rotation * weight;
+
+	dest.scale = dest.scale + src.scale * weight;
+}
+
+static OZZ_INLINE void Normalize(const Vector4& ratio, SoaTransform& dest)
+{
+	dest.rotation = NormalizeEst(dest.rotation);
+	dest.translation = dest.translation * ratio;
+	dest.scale = dest.scale * ratio;
+}
+
+// Rotation between identity and the rotation of src at weight, the sign is fixed up so that the lerp takes the shortest path
+static OZZ_INLINE SoaQuaternion AdditiveRotation(const SoaTransform& src, const Vector4& weight)
+{
+	const Vector4 one = Vector4::one();
+	const Vector4Int sign = signBit(src.rotation.w);
+	const SoaQuaternion rotation = {
+		xorPerElem(src.rotation.x, sign), xorPerElem(src.rotation.y, sign),
+		xorPerElem(src.rotation.z, sign), xorPerElem(src.rotation.w, sign) };
+	const SoaQuaternion interpQuat = {
+		mulPerElem(rotation.x, weight), mulPerElem(rotation.y, weight),
+		mulPerElem(rotation.z, weight), mulPerElem((rotation.w - one), weight) + one };
+	return NormalizeEst(interpQuat);
+}
+
+static OZZ_INLINE void AddPass(const SoaTransform& src, const Vector4& weight, SoaTransform& dest)
+{
+	const Vector4 oneMinusWeight = Vector4::one() - weight;
+	const SoaFloat3 oneMinusWeightF3 = { oneMinusWeight, oneMinusWeight, oneMinusWeight };
+
+	dest.translation = dest.translation + src.translation * weight;
+	dest.rotation = AdditiveRotation(src, weight) * dest.rotation;
+	dest.scale = dest.scale * (oneMinusWeightF3 + (src.scale * weight));
+}
+
+static OZZ_INLINE void SubtractPass(const SoaTransform& src, const Vector4& weight, SoaTransform& dest)
+{
+	const Vector4 oneMinusWeight = Vector4::one() - weight;
+	const SoaFloat3 rcpScale = {
+		rcpEst(oneMinusWeight + mulPerElem(src.scale.x, weight)),
+		rcpEst(oneMinusWeight + mulPerElem(src.scale.y, weight)),
+		rcpEst(oneMinusWeight + mulPerElem(src.scale.z, weight)) };
+
+	dest.translation = dest.translation - src.translation * weight;
+	dest.rotation = Conjugate(AdditiveRotation(src, weight)) * dest.rotation;
+	dest.scale = dest.scale * rcpScale;
+}
+
+// Layer that contributes to the blend, with the values that are used for every SoA block
+struct ActivePoseBlendLayer
+{
+	const SoaTransform* mTransforms;
+	Vector4 mWeight;
+	// NULL if all joints use mWeight
+	ClipMask* mClipMask;
+	bool mSubtract;
+};
+
+// Gathers layer to activeLayers if it has a weight in at least one joint
+static inline bool AddActiveLayer(const PoseBlendLayer& layer, ActivePoseBlendLayer* activeLayers, unsigned int& numActiveLayers)
+{
+	if (layer.mWeight == 0.0f || (layer.mClipMask && layer.mClipMask->GetNumActiveSoaJoints() == 0))
+		return false;
+
+	ActivePoseBlendLayer& activeLayer = activeLayers[numActiveLayers++];
+	activeLayer.mTransforms = layer.mTransforms.begin;
+	activeLayer.mWeight = Vector4(fabsf(layer.mWeight));
+	activeLayer.mClipMask = (layer.mClipMask && !layer.mClipMask->IsFull()) ? layer.mClipMask : nullptr;
+	activeLayer.mSubtract = layer.mWeight < 0.0f;
+	return true;
+}
+
+// Weight of layer for the SoA block at index, false if all joints of the block have a weight of zero
+static inline bool GetBlockWeight(const ActivePoseBlendLayer& layer, size_t index, Vector4& weight)
+{
+	if (!layer.mClipMask)
+	{
+		weight = layer.mWeight;
+		return true;
+	}
+
+	if (!layer.mClipMask->IsSoaJointActive((unsigned int)index))
+		return false;
+
+	weight = mulPerElem(layer.mWeight, maxPerElem(layer.mClipMask->GetJointWeights()[index], Vector4::zero()));
+	return true;
+}
+
+bool PoseBlender::Blend(
+	const PoseBlendLayer* layers, unsigned int numLayers, const PoseBlendLayer* additiveLayers, unsigned int numAdditiveLayers,
+	float threshold, ozz::Range<const SoaTransform> bindPose, ozz::Range<SoaTransform> output)
+{
+	// The bind pose defines the number of transforms to blend, all other buffers have to be as big
+	const size_t numSoaJoints = bindPose.end - bindPose.begin;
+	if ((threshold <= 0.0f) || !bindPose.begin || (size_t)(output.end - output.begin) < numSoaJoints)
+		return false;
+	if (numLayers > MAX_NUM_BLEND_LAYERS || numAdditiveLayers > MAX_NUM_BLEND_LAYERS)
+		return false;
+
+	// Gathers the normal layers that contribute to the blend, negative weights are ignored as in ozz
+	ActivePoseBlendLayer activeLayers[MAX_NUM_BLEND_LAYERS];
+	unsigned int numActiveLayers = 0;
+	bool partial = false;
+	float accumulatedWeight = 0.0f;
+	for (unsigned int i = 0; i < numLayers; i++)
+	{
+		if ((size_t)(layers[i].mTransforms.end - layers[i].mTransforms.begin) < numSoaJoints)
+			return false;
+
+		if (layers[i].mWeight > 0.0f && AddActiveLayer(layers[i], activeLayers, numActiveLayers))
+		{
+			partial |= (activeLayers[numActiveLayers - 1].mClipMask != nullptr);
+			accumulatedWeight += layers[i].mWeight;
+		}
+	}
+
+	ActivePoseBlendLayer activeAdditiveLayers[MAX_NUM_BLEND_LAYERS];
+	unsigned int numActiveAdditiveLayers = 0;
+	for (unsigned int i = 0; i < numAdditiveLayers; i++)
+	{
+		if ((size_t)(additiveLayers[i].mTransforms.end - additiveLayers[i].mTransforms.begin) < numSoaJoints)
+			return false;
+
+		AddActiveLayer(additiveLayers[i], activeAdditiveLayers, numActiveAdditiveLayers);
+	}
+
+	// Without partial layers the bind pose weight and the normalization are the same for every joint
+	const float bindPoseWeight = threshold - accumulatedWeight;
+	const Vector4 simdBindPoseWeight = Vector4(bindPoseWeight);
+	const Vector4 ratio = Vector4(1.0f / ((bindPoseWeight > 0.0f) ? threshold : accumulatedWeight));
+
+	// A single full layer that needs no bind pose is the output as is
+	const bool copyLayer = (numActiveLayers == 1) && !partial && (bindPoseWeight <= 0.0f);
+
+	const Vector4 zero = Vector4::zero();
+	const Vector4 one = Vector4::one();
+	const Vector4 simdThreshold = Vector4(threshold);
+
+	// Accumulated weights of the partial blend, and if any layer was blended to each block
+	Vector4 accumulatedWeights[ozz::animation::Skeleton::kMaxSoAJoints];
+	bool blockBlended[ozz::animation::Skeleton::kMaxSoAJoints];
+
+	if (copyLayer)
+	{
+		for (size_t i = 0; i < numSoaJoints; i++)
+			output.begin[i] = activeLayers[0].mTransforms[i];
+	}
+	else if (!partial)
+	{
+		for (unsigned int l = 0; l < numActiveLayers; l++)
+		{
+			const ActivePoseBlendLayer& layer = activeLayers[l];
+			if (l == 0)
+			{
+				for (size_t i = 0; i < numSoaJoints; i++)
+					BlendFirstPass(layer.mTransforms[i], layer.mWeight, output.begin[i]);
+			}
+			else
+			{
+				for (size_t i = 0; i < numSoaJoints; i++)
+					BlendPass(layer.mTransforms[i], layer.mWeight, output.begin[i]);
+			}
+		}
+	}
+	else
+	{
+		// Masked layers only visit the blocks where they have a weight. A block's first layer stores instead of accumulating
+		memset(blockBlended, 0, numSoaJoints * sizeof(bool));
+
+		for (unsigned int l = 0; l < numActiveLayers; l++)
+		{
+			const ActivePoseBlendLayer& layer = activeLayers[l];
+			for (size_t i = 0; i < numSoaJoints; i++)
+			{
+				Vector4 weight;
+				if (!GetBlockWeight(layer, i, weight))
+					continue;
+
+				if (!blockBlended[i])
+				{
+					BlendFirstPass(layer.mTransforms[i], weight, output.begin[i]);
+					accumulatedWeights[i] = weight;
+					blockBlended[i] = true;
+				}
+				else
+				{
+					BlendPass(layer.mTransforms[i], weight, output.begin[i]);
+					accumulatedWeights[i] = accumulatedWeights[i] + weight;
+				}
+			}
+		}
+	}
+
+	// The bind pose, the normalization and all the additive layers are applied in one pass over the output
+	for (size_t i = 0; i < numSoaJoints; i++)
+	{
+		SoaTransform& dest = output.begin[i];
+
+		if (copyLayer)
+		{
+			// Already in the output
+		}
+		else if (numActiveLayers == 0)
+		{
+			dest = bindPose.begin[i];
+		}
+		else if (!partial)
+		{
+			if (bindPoseWeight > 0.0f)
+				BlendPass(bindPose.begin[i], simdBindPoseWeight, dest);
+
+			Normalize(ratio, dest);
+		}
+		else if (!blockBlended[i])
+		{
+			// No layer has a weight in this block, which is only the bind pose
+			dest = bindPose.begin[i];
+		}
+		else
+		{
+			const Vector4 blockBindPoseWeight = maxPerElem(simdThreshold - accumulatedWeights[i], zero);
+			BlendPass(bindPose.begin[i], blockBindPoseWeight, dest);
+
+			Normalize(divPerElem(one, maxPerElem(simdThreshold, accumulatedWeights[i])), dest);
+		}
+
+		for (unsigned int l = 0; l < numActiveAdditiveLayers; l++)
+		{
+			Vector4 weight;
+			if (!GetBlockWeight(activeAdditiveLayers[l], i, weight))
+				continue;
+
+			if (activeAdditiveLayers[l].mSubtract)
+				SubtractPass(activeAdditiveLayers[l].mTransforms[i], weight, dest);
+			else
+				AddPass(activeAdditiveLayers[l].mTransforms[i], weight, dest);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Math/MathTypes.h"
+
+#include "ClipMask.h"
+
+// Maximum number of normal and of additive layers that PoseBlender blends at once
+const unsigned int MAX_NUM_BLEND_LAYERS = 16;
+
+// One pose to blend with PoseBlender
+struct PoseBlendLayer
+{
+	// Sampled local transforms of the pose
+	ozz::Range<const SoaTransform> mTransforms;
+
+	// Weight of the whole pose, negative weights subtract additive poses
+	float mWeight = 0.0f;
+
+	// Optional per joint weights, NULL when all joints use mWeight
+	ClipMask* mClipMask = nullptr;
+};
+
+// Blends the sampled poses of an Animation, producing the same pose as ozz's BlendingJob.
+// Masked layers only visit the SoA blocks of 4 joints their ClipMask has a weight in and a single full layer that needs
+// no bind pose is copied. The bind pose, the normalization and the additive layers are then applied in a single pass
+class PoseBlender
+{
+
+public:
+
+	// Blends layers, then additiveLayers, to output. The bind pose fills joints whose accumulated weight is below threshold
+	static bool Blend(
+		const PoseBlendLayer* layers, unsigned int numLayers, const PoseBlendLayer* additiveLayers, unsigned int numAdditiveLayers,
+		float threshold, ozz::Range<const SoaTransform> bindPose, ozz::Range<SoaTransform> output);
+};
@@ -131,7 +131,8 @@ void Rig::Pose(const Matrix4& rootTransform)
 bool Rig::LoadSkeleton(const char* fileName)
 {	
 
-	ozz::io::File file(fileName, "rb");
+	// The archive is read straight out of the mapped file
+	MappedStream file(fileName);
 	if (!file.opened()) 
 	{
 		ErrorMsg("Cannot open skeleton file");
@@ -38,6 +38,8 @@
 
 #include "../../Common_3/OS/Interfaces/ILogManager.h"
 
+#include "MappedStream.h"
+
 // Stores skeleton properties and posable by animations
 class Rig
 {
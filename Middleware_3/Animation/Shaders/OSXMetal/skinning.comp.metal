@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <metal_stdlib>
+using namespace metal;
+
+// Matrix palette skinning: each thread blends the palette matrices of the joints influencing a vertex and
+// transforms its position and normal. Must match SkinningVertex, SkinnedVertex, MAX_SKINNING_INFLUENCES and
+// SKINNING_THREAD_GROUP_SIZE in SkinnedMesh.h
+
+struct SkinningVertex
+{
+	float4 position;
+	float4 normal;
+	uint4 jointIndices;
+	float4 jointWeights;
+};
+
+struct SkinnedVertex
+{
+	float4 position;
+	float4 normal;
+};
+
+struct SkinningConstants
+{
+	uint numVertices;
+	uint numInfluences;
+};
+
+//[numthreads(64,1,1)]
+kernel void stageMain(uint3 threadID                                      [[thread_position_in_grid]],
+                      constant SkinningConstants& SkinningRootConstants   [[buffer(0)]],
+                      constant SkinningVertex* vertices                   [[buffer(1)]],
+                      constant float4x4* palette                          [[buffer(2)]],
+                      device SkinnedVertex* skinnedVertices               [[buffer(3)]])
+{
+	uint vertexIndex = threadID.x;
+	if (vertexIndex >= SkinningRootConstants.numVertices)
+		return;
+
+	SkinningVertex vertex = vertices[vertexIndex];
+
+	float4x4 transform = palette[vertex.jointIndices[0]] * vertex.jointWeights[0];
+	for (uint i = 1; i < SkinningRootConstants.numInfluences; ++i)
+		transform += palette[vertex.jointIndices[i]] * vertex.jointWeights[i];
+
+	SkinnedVertex skinnedVertex;
+	skinnedVertex.position = float4((transform * float4(vertex.position.xyz, 1.0f)).xyz, 1.0f);
+
+	// Blended matrices scale the normals, renormalize them. Meshes without normals keep zero normals
+	float3 normal = (transform * float4(vertex.normal.xyz, 0.0f)).xyz;
+	float normalLengthSqr = dot(normal, normal);
+	skinnedVertex.normal = float4(normalLengthSqr > 0.0f ? normal * rsqrt(normalLengthSqr) : normal, 0.0f);
+	skinnedVertices[vertexIndex] = skinnedVertex;
+}
@@ -171,11 +171,74 @@ void SkeletonBatcher::SetPerInstanceUniforms(const uint32_t& frameIndex, int num
 }
 
 
+void SkeletonBatcher::WriteRigInstances(const uint32_t& frameIndex, unsigned int rigIndex)
+{
+	Rig* rig = mRigs[rigIndex];
+	const unsigned int numJoints = rig->GetNumJoints();
+	const unsigned int firstInstance = mRigInstanceOffsets[rigIndex];
+
+	for (unsigned int jointIndex = 0; jointIndex < numJoints; jointIndex++)
+	{
+		// Instances are packed in the same order as SetPerInstanceUniforms does
+		const unsigned int batch = (firstInstance + jointIndex) / MAX_INSTANCES;
+		const unsigned int instance = (firstInstance + jointIndex) % MAX_INSTANCES;
+
+		UniformSkeletonBlock* uniformDataJoints = (UniformSkeletonBlock*)mProjViewUniformBufferJoints[batch][frameIndex]->pCpuMappedAddress;
+
+		if (mDrawBones)
+		{
+			UniformSkeletonBlock* uniformDataBones = (UniformSkeletonBlock*)mProjViewUniformBufferBones[batch][frameIndex]->pCpuMappedAddress;
+
+			// add bones data to the uniform
+			uniformDataBones->mToWorldMat[instance] = rig->GetBoneWorldMat(jointIndex);
+			uniformDataBones->mColor[instance] = rig->GetBoneColor();
+
+			// add joint data to the uniform while scaling the joints by their determined chlid bone length
+			uniformDataJoints->mToWorldMat[instance] = rig->GetJointWorldMat(jointIndex) * mat4::scale(rig->GetJointScale(jointIndex));
+		}
+		else
+		{
+			// add joint data to the uniform without scaling
+			uniformDataJoints->mToWorldMat[instance] = rig->GetJointWorldMat(jointIndex);
+		}
+		uniformDataJoints->mColor[instance] = rig->GetJointColor();
+	}
+}
+
+void SkeletonBatcher::FinalizeRigInstances(const uint32_t& frameIndex, unsigned int numRigs)
+{
+	const unsigned int numInstances = mRigInstanceOffsets[numRigs];
+	ASSERT(numInstances <= MAX_BATCHES * MAX_INSTANCES);
+
+	mBatchCounts[frameIndex] = (numInstances + MAX_INSTANCES - 1) / MAX_INSTANCES;
+	mLastBatchSize[frameIndex] = (numInstances > 0) ? numInstances - (mBatchCounts[frameIndex] - 1) * MAX_INSTANCES : 0;
+
+	// Only the shared part of the blocks is left to write
+	for (unsigned int batch = 0; batch < mBatchCounts[frameIndex]; batch++)
+	{
+		UniformSkeletonBlock* uniformDataJoints = (UniformSkeletonBlock*)mProjViewUniformBufferJoints[batch][frameIndex]->pCpuMappedAddress;
+		uniformDataJoints->mProjectView = mUniformDataJoints.mProjectView;
+		uniformDataJoints->mLightPosition = mUniformDataJoints.mLightPosition;
+		uniformDataJoints->mLightColor = mUniformDataJoints.mLightColor;
+
+		if (mDrawBones)
+		{
+			UniformSkeletonBlock* uniformDataBones = (UniformSkeletonBlock*)mProjViewUniformBufferBones[batch][frameIndex]->pCpuMappedAddress;
+			uniformDataBones->mProjectView = mUniformDataBones.mProjectView;
+			uniformDataBones->mLightPosition = mUniformDataBones.mLightPosition;
+			uniformDataBones->mLightColor = mUniformDataBones.mLightColor;
+		}
+	}
+}
+
 void SkeletonBatcher::AddRig(Rig* rig)
 {
 	// Adds the rig so its data can be used and increments the rig count
 	mRigs.push_back(rig);
 	mNumRigs++;
+
+	// Instances of the rig follow the ones of the previous rigs
+	mRigInstanceOffsets.push_back(mRigInstanceOffsets[mNumRigs - 1] + rig->GetNumJoints());
 }
 
 void SkeletonBatcher::Draw(Cmd* cmd, const uint32_t& frameIndex)
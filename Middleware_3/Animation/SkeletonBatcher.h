@@ -84,6 +84,17 @@ public:
 	// Update all the instanced uniform data for each batch of joints and bones
 	void SetPerInstanceUniforms(const uint32_t& frameIndex, int numRigs = -1);
 
+	// Indicates if the uniform buffers stay mapped, which WriteRigInstances needs. Otherwise SetPerInstanceUniforms must be used
+	inline bool IsPersistentlyMapped() { return mProjViewUniformBufferJoints[0][0]->pCpuMappedAddress != NULL; };
+
+	// Write the instance data of the joints and bones of the rig at rigIndex straight into the mapped uniform buffers.
+	// Each rig has its own instances, so rigs can be written from several threads at once
+	void WriteRigInstances(const uint32_t& frameIndex, unsigned int rigIndex);
+
+	// Write the shared uniforms of the batches once WriteRigInstances was called for the first numRigs rigs,
+	// and set the batches to draw
+	void FinalizeRigInstances(const uint32_t& frameIndex, unsigned int numRigs);
+
 	// Instance draw all the skeletons
 	void Draw(Cmd* cmd, const uint32_t& frameIndex);
 
@@ -93,6 +104,9 @@ private:
 	tinystl::vector<Rig*> mRigs;
 	unsigned int mNumRigs = 0;
 
+	// Index of the first instance of each rig, followed by the total number of instances
+	tinystl::vector<unsigned int> mRigInstanceOffsets = tinystl::vector<unsigned int>(1, 0);
+
 	// Application variables used to be able to update buffers
 	Pipeline* mSkeletonPipeline;
 	RootSignature* mRootSignature;
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "SkinnedMesh.h"
+
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/runtime/local_to_model_job.h"
+
+#if !defined(ENABLE_RENDERER_RUNTIME_SWITCH)
+extern void cmdUpdateBuffer(Cmd* p_cmd, uint64_t srcOffset, uint64_t dstOffset, uint64_t size, Buffer* p_src_buffer, Buffer* p_buffer);
+extern void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange);
+extern void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
+#endif
+
+void SkinnedMesh::Initialize(const SkinnedMeshDesc& skinnedMeshDesc)
+{
+	ASSERT(skinnedMeshDesc.mRig);
+	ASSERT(skinnedMeshDesc.mPositions && skinnedMeshDesc.mJointIndices && skinnedMeshDesc.mJointWeights);
+	ASSERT((0 < skinnedMeshDesc.mNumInfluences) && (skinnedMeshDesc.mNumInfluences <= MAX_SKINNING_INFLUENCES));
+
+	mRig = skinnedMeshDesc.mRig;
+	mNumVertices = skinnedMeshDesc.mNumVertices;
+	mNumInfluences = skinnedMeshDesc.mNumInfluences;
+
+	// Interleave the streams, unused influences get a zero weight on joint 0
+	mVertices = tinystl::vector<SkinningVertex>(mNumVertices);
+	for (unsigned int vertexIndex = 0; vertexIndex < mNumVertices; vertexIndex++)
+	{
+		SkinningVertex& vertex = mVertices[vertexIndex];
+
+		const float* position = &skinnedMeshDesc.mPositions[vertexIndex * 3];
+		const float* normal = skinnedMeshDesc.mNormals ? &skinnedMeshDesc.mNormals[vertexIndex * 3] : NULL;
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			vertex.mPosition[i] = position[i];
+			vertex.mNormal[i] = normal ? normal[i] : 0.0f;
+		}
+		vertex.mPosition[3] = 1.0f;
+		vertex.mNormal[3] = 0.0f;
+
+		for (unsigned int i = 0; i < MAX_SKINNING_INFLUENCES; i++)
+		{
+			const bool used = i < mNumInfluences;
+			vertex.mJointIndices[i] = used ? skinnedMeshDesc.mJointIndices[vertexIndex * mNumInfluences + i] : 0;
+			vertex.mJointWeights[i] = used ? skinnedMeshDesc.mJointWeights[vertexIndex * mNumInfluences + i] : 0.0f;
+
+			ASSERT(vertex.mJointIndices[i] < mRig->GetNumJoints());
+		}
+	}
+
+	const unsigned int numJoints = mRig->GetNumJoints();
+
+	if (skinnedMeshDesc.mInverseBindMats)
+	{
+		mInverseBindMats = tinystl::vector<Matrix4>(skinnedMeshDesc.mInverseBindMats, skinnedMeshDesc.mInverseBindMats + numJoints);
+	}
+	else
+	{
+		// Compute the model space bind pose of the skeleton and invert it
+		ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+		ozz::Range<Matrix4> bindModelMats = allocator->AllocateRange<Matrix4>(numJoints);
+
+		ozz::animation::LocalToModelJob ltmJob;
+		ltmJob.skeleton = mRig->GetSkeleton();
+		ltmJob.input = mRig->GetSkeleton()->bind_pose();
+		ltmJob.output = bindModelMats;
+
+		if (!ltmJob.Run())
+			ErrorMsg("Cannot compute the bind pose of the skinned mesh's skeleton");
+
+		mInverseBindMats = tinystl::vector<Matrix4>(numJoints);
+		for (unsigned int jointIndex = 0; jointIndex < numJoints; jointIndex++)
+		{
+			mInverseBindMats[jointIndex] = inverse(bindModelMats[jointIndex]);
+		}
+
+		allocator->Deallocate(bindModelMats);
+	}
+
+	mPalette = tinystl::vector<Matrix4>(numJoints, Matrix4::identity());
+	mSkinnedVertices = tinystl::vector<SkinnedVertex>(mNumVertices);
+}
+
+void SkinnedMesh::Destroy()
+{
+	mVertices.clear();
+	mInverseBindMats.clear();
+	mPalette.clear();
+	mSkinnedVertices.clear();
+	mWorkItems.clear();
+	mJobData.clear();
+}
+
+void SkinnedMesh::InitializeGpu(const SkinnedMeshGpuDesc& skinnedMeshGpuDesc)
+{
+	mRenderer = skinnedMeshGpuDesc.mRenderer;
+	mSkinningPipeline = skinnedMeshGpuDesc.mSkinningPipeline;
+	mRootSignature = skinnedMeshGpuDesc.mRootSignature;
+
+	// Bind pose vertices, read only
+	BufferLoadDesc vertexDesc = {};
+	vertexDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+	vertexDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	vertexDesc.mDesc.mFirstElement = 0;
+	vertexDesc.mDesc.mElementCount = mNumVertices;
+	vertexDesc.mDesc.mStructStride = sizeof(SkinningVertex);
+	vertexDesc.mDesc.mSize = vertexDesc.mDesc.mElementCount * vertexDesc.mDesc.mStructStride;
+	vertexDesc.pData = mVertices.data();
+	vertexDesc.ppBuffer = &mVertexBuffer;
+	addResource(&vertexDesc);
+
+	// Palettes, updated every frame
+	BufferLoadDesc paletteDesc = {};
+	paletteDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+	paletteDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	paletteDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+	paletteDesc.mDesc.mFirstElement = 0;
+	paletteDesc.mDesc.mElementCount = mPalette.size();
+	paletteDesc.mDesc.mStructStride = sizeof(Matrix4);
+	paletteDesc.mDesc.mSize = paletteDesc.mDesc.mElementCount * paletteDesc.mDesc.mStructStride;
+	paletteDesc.pData = NULL;
+	for (uint32_t i = 0; i < ImageCount; ++i)
+	{
+		paletteDesc.ppBuffer = &mPaletteBuffers[i];
+		addResource(&paletteDesc);
+	}
+
+	// Skinned vertices, written by the compute shader and read as a vertex buffer
+	BufferLoadDesc skinnedDesc = {};
+	skinnedDesc.mDesc.mDescriptors = (DescriptorType)(DESCRIPTOR_TYPE_RW_BUFFER | DESCRIPTOR_TYPE_VERTEX_BUFFER);
+	skinnedDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	skinnedDesc.mDesc.mFirstElement = 0;
+	skinnedDesc.mDesc.mElementCount = mNumVertices;
+	skinnedDesc.mDesc.mStructStride = sizeof(SkinnedVertex);
+	skinnedDesc.mDesc.mVertexStride = sizeof(SkinnedVertex);
+	skinnedDesc.mDesc.mSize = skinnedDesc.mDesc.mElementCount * skinnedDesc.mDesc.mStructStride;
+	skinnedDesc.pData = NULL;
+	skinnedDesc.ppBuffer = &mSkinnedVertexBuffer;
+	addResource(&skinnedDesc);
+
+	// Readback copies of the skinned vertices, to compare them with the CPU skinning
+	BufferLoadDesc readbackDesc = {};
+	readbackDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_TO_CPU;
+	readbackDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
+	readbackDesc.mDesc.mStartState = RESOURCE_STATE_COPY_DEST;
+	readbackDesc.mDesc.mSize = skinnedDesc.mDesc.mSize;
+	readbackDesc.pData = NULL;
+	for (uint32_t i = 0; i < ImageCount; ++i)
+	{
+		readbackDesc.ppBuffer = &mReadbackBuffers[i];
+		addResource(&readbackDesc);
+	}
+}
+
+void SkinnedMesh::DestroyGpu()
+{
+	removeResource(mVertexBuffer);
+	for (uint32_t i = 0; i < ImageCount; ++i)
+	{
+		removeResource(mPaletteBuffers[i]);
+	}
+	removeResource(mSkinnedVertexBuffer);
+	for (uint32_t i = 0; i < ImageCount; ++i)
+	{
+		removeResource(mReadbackBuffers[i]);
+	}
+}
+
+void SkinnedMesh::UpdatePalette()
+{
+	ozz::Range<Matrix4> jointModelMats = mRig->GetJointModelMats();
+
+	for (unsigned int jointIndex = 0; jointIndex < mPalette.size(); jointIndex++)
+	{
+		mPalette[jointIndex] = jointModelMats[jointIndex] * mInverseBindMats[jointIndex];
+	}
+}
+
+void SkinnedMesh::SkinVertices(unsigned int begin, unsigned int end)
+{
+	const Matrix4* palette = mPalette.data();
+
+	for (unsigned int vertexIndex = begin; vertexIndex < end; vertexIndex++)
+	{
+		const SkinningVertex& vertex = mVertices[vertexIndex];
+
+		// Blend the matrices of the influencing joints, then transform once
+		Matrix4 transform = palette[vertex.mJointIndices[0]] * vertex.mJointWeights[0];
+		for (unsigned int i = 1; i < mNumInfluences; i++)
+		{
+			transform += palette[vertex.mJointIndices[i]] * vertex.mJointWeights[i];
+		}
+
+		const Vector4 position = transform * Vector4(vertex.mPosition[0], vertex.mPosition[1], vertex.mPosition[2], 1.0f);
+		Vector4 normal = transform * Vector4(vertex.mNormal[0], vertex.mNormal[1], vertex.mNormal[2], 0.0f);
+
+		// Blended matrices scale the normals, renormalize them. Meshes without normals keep zero normals
+		const float normalLengthSqr = lengthSqr(normal);
+		if (normalLengthSqr > 0.0f)
+		{
+			normal /= sqrtf(normalLengthSqr);
+		}
+
+		SkinnedVertex& skinnedVertex = mSkinnedVertices[vertexIndex];
+		skinnedVertex.mPosition[0] = position.getX();
+		skinnedVertex.mPosition[1] = position.getY();
+		skinnedVertex.mPosition[2] = position.getZ();
+		skinnedVertex.mPosition[3] = 1.0f;
+		skinnedVertex.mNormal[0] = normal.getX();
+		skinnedVertex.mNormal[1] = normal.getY();
+		skinnedVertex.mNormal[2] = normal.getZ();
+		skinnedVertex.mNormal[3] = 0.0f;
+	}
+}
+
+void SkinnedMesh::SkinVerticesJob(void* pData)
+{
+	SkinningJobData* jobData = (SkinningJobData*)pData;
+	jobData->mSkinnedMesh->SkinVertices(jobData->mBegin, jobData->mEnd);
+}
+
+void SkinnedMesh::SkinCpu(ThreadPool* threadPool, unsigned int grainSize)
+{
+	ASSERT(0 < grainSize);
+
+	if (!threadPool || (mNumVertices <= grainSize))
+	{
+		SkinVertices(0, mNumVertices);
+		return;
+	}
+
+	const unsigned int numJobs = (mNumVertices + grainSize - 1) / grainSize;
+	if (mWorkItems.size() < numJobs)
+	{
+		mWorkItems.resize(numJobs);
+		mJobData.resize(numJobs);
+	}
+
+	for (unsigned int jobIndex = 0; jobIndex < numJobs; jobIndex++)
+	{
+		SkinningJobData& jobData = mJobData[jobIndex];
+		jobData.mSkinnedMesh = this;
+		jobData.mBegin = jobIndex * grainSize;
+		jobData.mEnd = (jobData.mBegin + grainSize < mNumVertices) ? jobData.mBegin + grainSize : mNumVertices;
+
+		mWorkItems[jobIndex] = WorkItem();
+		mWorkItems[jobIndex].pFunc = SkinVerticesJob;
+		mWorkItems[jobIndex].pData = &jobData;
+		threadPool->AddWorkItem(&mWorkItems[jobIndex]);
+	}
+
+	// Ensure all jobs are finished before the results are read
+	threadPool->Complete(0);
+}
+
+void SkinnedMesh::UpdateGpuPalette(const uint32_t& frameIndex)
+{
+	BufferUpdateDesc paletteUpdate = { mPaletteBuffers[frameIndex], mPalette.data() };
+	paletteUpdate.mSize = mPalette.size() * sizeof(Matrix4);
+	updateResource(&paletteUpdate);
+}
+
+void SkinnedMesh::Dispatch(Cmd* cmd, const uint32_t& frameIndex)
+{
+	ASSERT(mSkinningPipeline && mRootSignature);
+
+	cmdBeginDebugMarker(cmd, 1, 0, 1, "Skin Mesh");
+
+	BufferBarrier uavBarrier = { mSkinnedVertexBuffer, RESOURCE_STATE_UNORDERED_ACCESS };
+	cmdResourceBarrier(cmd, 1, &uavBarrier, 0, NULL, false);
+
+	const uint32_t numVertices = mNumVertices;
+	const uint32_t numInfluences = mNumInfluences;
+	const uint32_t rootConstants[2] = { numVertices, numInfluences };
+
+	DescriptorData params[4] = {};
+	params[0].pName = "SkinningRootConstants";
+	params[0].pRootConstant = (void*)rootConstants;
+	params[1].pName = "vertices";
+	params[1].ppBuffers = &mVertexBuffer;
+	params[2].pName = "palette";
+	params[2].ppBuffers = &mPaletteBuffers[frameIndex];
+	params[3].pName = "skinnedVertices";
+	params[3].ppBuffers = &mSkinnedVertexBuffer;
+	cmdBindDescriptors(cmd, mRootSignature, 4, params);
+
+	cmdBindPipeline(cmd, mSkinningPipeline);
+	cmdDispatch(cmd, (mNumVertices + SKINNING_THREAD_GROUP_SIZE - 1) / SKINNING_THREAD_GROUP_SIZE, 1, 1);
+
+	BufferBarrier vertexBarrier = { mSkinnedVertexBuffer, RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER };
+	cmdResourceBarrier(cmd, 1, &vertexBarrier, 0, NULL, false);
+
+	cmdEndDebugMarker(cmd);
+}
+
+void SkinnedMesh::ReadbackGpu(Cmd* cmd, const uint32_t& frameIndex)
+{
+	BufferBarrier copyBarrier = { mSkinnedVertexBuffer, RESOURCE_STATE_COPY_SOURCE };
+	cmdResourceBarrier(cmd, 1, &copyBarrier, 0, NULL, false);
+
+	cmdUpdateBuffer(cmd, 0, 0, mSkinnedVertexBuffer->mDesc.mSize, mSkinnedVertexBuffer, mReadbackBuffers[frameIndex]);
+
+	BufferBarrier vertexBarrier = { mSkinnedVertexBuffer, RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER };
+	cmdResourceBarrier(cmd, 1, &vertexBarrier, 0, NULL, false);
+}
+
+const SkinnedVertex* SkinnedMesh::MapGpuReadback(const uint32_t& frameIndex)
+{
+	ASSERT(mRenderer);
+
+	ReadRange range = { 0, mReadbackBuffers[frameIndex]->mDesc.mSize };
+	mapBuffer(mRenderer, mReadbackBuffers[frameIndex], &range);
+	return (const SkinnedVertex*)mReadbackBuffers[frameIndex]->pCpuMappedAddress;
+}
+
+void SkinnedMesh::UnmapGpuReadback(const uint32_t& frameIndex)
+{
+	unmapBuffer(mRenderer, mReadbackBuffers[frameIndex]);
+}
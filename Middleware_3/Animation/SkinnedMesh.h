@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/Renderer/IRenderer.h"
+#include "../../Common_3/Renderer/ResourceLoader.h"
+#include "../../Common_3/OS/Interfaces/IThread.h"
+
+#include "Rig.h"
+#include "SkeletonBatcher.h"
+
+// Maximum number of joints influencing a vertex. Must match with the skinning shaders.
+#define MAX_SKINNING_INFLUENCES 4
+
+// Number of vertices skinned by each thread group of the skinning shaders. Must match with the skinning shaders.
+#define SKINNING_THREAD_GROUP_SIZE 64
+
+// Bind pose vertex with its joint influences, as read by both the CPU and the GPU skinning
+struct SkinningVertex
+{
+	float mPosition[4];
+	float mNormal[4];
+	uint32_t mJointIndices[MAX_SKINNING_INFLUENCES];
+	float mJointWeights[MAX_SKINNING_INFLUENCES];
+};
+
+// Skinned vertex, as written by both the CPU and the GPU skinning. The w components are 1 for positions and 0 for normals.
+struct SkinnedVertex
+{
+	float mPosition[4];
+	float mNormal[4];
+};
+
+// Vertex streams needed to skin a mesh to a rig
+struct SkinnedMeshDesc
+{
+	// Rig whose joint model matrices pose the mesh
+	Rig* mRig;
+
+	unsigned int mNumVertices;
+
+	// Number of joints influencing each vertex, between 1 and MAX_SKINNING_INFLUENCES
+	unsigned int mNumInfluences;
+
+	// 3 floats per vertex
+	const float* mPositions;
+
+	// 3 floats per vertex, optional
+	const float* mNormals;
+
+	// mNumInfluences joint indices and weights per vertex. Weights of a vertex must sum to 1
+	const uint16_t* mJointIndices;
+	const float* mJointWeights;
+
+	// Inverse of the model space bind pose matrix of each joint, optional. Computed from the skeleton's bind pose if NULL
+	const Matrix4* mInverseBindMats;
+};
+
+// Application objects needed to skin on the GPU, created from the skinning shader in Middleware_3/Animation/Shaders
+struct SkinnedMeshGpuDesc
+{
+	// Renderer mapping the readback buffers
+	Renderer* mRenderer;
+
+	Pipeline* mSkinningPipeline;
+	RootSignature* mRootSignature;
+};
+
+// Skins a mesh with the joint model matrices of its Rig, either on the CPU split across a thread pool
+// or with a compute shader writing a vertex buffer. Both back ends take the same inputs and produce the same SkinnedVertex layout
+class SkinnedMesh
+{
+
+public:
+
+	// Copies the vertex streams and sets up the inverse bind matrices
+	void Initialize(const SkinnedMeshDesc& skinnedMeshDesc);
+
+	// Must be called to clean up the object if it was initialized
+	void Destroy();
+
+	// Creates the buffers used by the compute shader and the readback buffers. Must be called before UpdateGpuPalette and Dispatch
+	void InitializeGpu(const SkinnedMeshGpuDesc& skinnedMeshGpuDesc);
+
+	// Must be called to clean up the GPU buffers if InitializeGpu was called
+	void DestroyGpu();
+
+	// Update the mSkinningPipeline pointer now that the pipeline has been loaded
+	inline void LoadPipeline(Pipeline* pipeline) { mSkinningPipeline = pipeline; };
+
+	// Builds the skinning matrix palette from the rig's current joint model matrices
+	void UpdatePalette();
+
+	// Skins all vertices with the current palette on the CPU into GetSkinnedVertices.
+	// Vertices are split in jobs of grainSize vertices run on threadPool, or on the calling thread if threadPool is NULL
+	void SkinCpu(ThreadPool* threadPool = NULL, unsigned int grainSize = 2048);
+
+	// Uploads the current palette for the frame index
+	void UpdateGpuPalette(const uint32_t& frameIndex);
+
+	// Records the compute dispatch skinning all vertices into GetSkinnedVertexBuffer with the palette of the frame index
+	void Dispatch(Cmd* cmd, const uint32_t& frameIndex);
+
+	// Records a copy of the vertices written by the last Dispatch into the readback buffer of the frame index.
+	// Must be recorded after Dispatch, outside of a render pass
+	void ReadbackGpu(Cmd* cmd, const uint32_t& frameIndex);
+
+	// Maps the vertices copied by ReadbackGpu for the frame index. The commands of the frame must have completed
+	const SkinnedVertex* MapGpuReadback(const uint32_t& frameIndex);
+	void UnmapGpuReadback(const uint32_t& frameIndex);
+
+	// Gets the result of the last SkinCpu
+	inline const SkinnedVertex* GetSkinnedVertices() { return mSkinnedVertices.data(); };
+
+	// Gets the vertex buffer written by Dispatch, with a SkinnedVertex stride
+	inline Buffer* GetSkinnedVertexBuffer() { return mSkinnedVertexBuffer; };
+
+	// Gets the number of vertices of the mesh
+	inline unsigned int GetNumVertices() { return mNumVertices; };
+
+	// Gets the skinning matrix of each joint: the joint model matrix multiplied with the inverse bind matrix
+	inline const Matrix4* GetPalette() { return mPalette.data(); };
+
+private:
+
+	// Skins the vertices in [begin, end) with the current palette
+	void SkinVertices(unsigned int begin, unsigned int end);
+
+	// Job function for a range of vertices
+	static void SkinVerticesJob(void* pData);
+
+	struct SkinningJobData
+	{
+		SkinnedMesh* mSkinnedMesh;
+		unsigned int mBegin;
+		unsigned int mEnd;
+	};
+
+	// The Rig whose joints pose the mesh
+	Rig* mRig;
+
+	unsigned int mNumVertices;
+
+	unsigned int mNumInfluences;
+
+	// Bind pose vertices with their influences, also the input of the compute shader
+	tinystl::vector<SkinningVertex> mVertices;
+
+	// Inverse bind pose matrix of each joint
+	tinystl::vector<Matrix4> mInverseBindMats;
+
+	// Skinning matrix of each joint
+	tinystl::vector<Matrix4> mPalette;
+
+	// Output of the CPU skinning
+	tinystl::vector<SkinnedVertex> mSkinnedVertices;
+
+	// Jobs of the last SkinCpu, kept to avoid allocating every frame
+	tinystl::vector<WorkItem> mWorkItems;
+	tinystl::vector<SkinningJobData> mJobData;
+
+	// Application variables used to dispatch the compute shader
+	Renderer* mRenderer = NULL;
+	Pipeline* mSkinningPipeline = NULL;
+	RootSignature* mRootSignature = NULL;
+
+	// GPU copy of mVertices, a palette per frame index and the skinned vertices
+	Buffer* mVertexBuffer = NULL;
+	Buffer* mPaletteBuffers[ImageCount] = { NULL };
+	Buffer* mSkinnedVertexBuffer = NULL;
+
+	// CPU readable copies of mSkinnedVertexBuffer, one per frame index
+	Buffer* mReadbackBuffers[ImageCount] = { NULL };
+};
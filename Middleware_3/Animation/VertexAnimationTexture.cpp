@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "VertexAnimationTexture.h"
+
+#include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/runtime/local_to_model_job.h"
+
+// Largest integer the header can hold in a 16 bit float texel
+#define VAT_MAX_HALF_INTEGER 2048
+
+// Points transformed by the baked matrices to measure their error, spanning the unit meshes drawn with them
+static const Vector4 gErrorPoints[] = { Vector4(0.0f, 0.0f, 0.0f, 1.0f), Vector4(1.0f, 0.0f, 0.0f, 1.0f), Vector4(0.0f, 1.0f, 0.0f, 1.0f), Vector4(0.0f, 0.0f, 1.0f, 1.0f) };
+
+static unsigned int TexelsPerElement(VertexAnimationTextureType type)
+{
+	return type == VAT_TYPE_VERTICES ? 2 : 3;
+}
+
+// Samples the clip at timeRatio into the joint model matrices of the rig
+static bool SampleModelMats(Rig* rig, Clip* clip, ozz::animation::SamplingCache* cache, ozz::Range<SoaTransform>& localTrans, float timeRatio)
+{
+	if (!clip->Sample(cache, localTrans, timeRatio))
+		return false;
+
+	ozz::animation::LocalToModelJob ltmJob;
+	ltmJob.skeleton = rig->GetSkeleton();
+	ltmJob.input = localTrans;
+	ltmJob.output = rig->GetJointModelMats();
+	return ltmJob.Run();
+}
+
+// Finishes the live update of the sampled pose for the type of texture
+static void UpdateLivePose(const VertexAnimationTextureDesc& desc)
+{
+	if (desc.mType == VAT_TYPE_SKELETON)
+	{
+		desc.mRig->Pose(Matrix4::identity());
+	}
+	else
+	{
+		desc.mSkinnedMesh->UpdatePalette();
+		if (desc.mType == VAT_TYPE_VERTICES)
+			desc.mSkinnedMesh->SkinCpu();
+	}
+}
+
+// Gets the texels of an element from the current live pose
+static void GetLiveTexels(const VertexAnimationTextureDesc& desc, unsigned int element, Vector4* texels)
+{
+	if (desc.mType == VAT_TYPE_VERTICES)
+	{
+		const SkinnedVertex& vertex = desc.mSkinnedMesh->GetSkinnedVertices()[element];
+		texels[0] = Vector4(vertex.mPosition[0], vertex.mPosition[1], vertex.mPosition[2], 1.0f);
+		texels[1] = Vector4(vertex.mNormal[0], vertex.mNormal[1], vertex.mNormal[2], 0.0f);
+		return;
+	}
+
+	Matrix4 mat;
+	if (desc.mType == VAT_TYPE_PALETTE)
+	{
+		mat = desc.mSkinnedMesh->GetPalette()[element];
+	}
+	else
+	{
+		// Joints then bones, scaled like SkeletonBatcher draws them
+		const unsigned int numJoints = desc.mRig->GetNumJoints();
+		if (element < numJoints)
+			mat = desc.mRig->GetJointWorldMat(element) * Matrix4::scale(desc.mRig->GetJointScale(element));
+		else
+			mat = desc.mRig->GetBoneWorldMat(element - numJoints);
+	}
+
+	// Rows of the affine part, the last row is (0, 0, 0, 1)
+	const Matrix4 transposed = transpose(mat);
+	texels[0] = transposed.getCol0();
+	texels[1] = transposed.getCol1();
+	texels[2] = transposed.getCol2();
+}
+
+bool VertexAnimationTexture::Bake(const VertexAnimationTextureDesc& desc, VertexAnimationTextureStats* pStats)
+{
+	ASSERT(desc.mRig && desc.mClip && desc.mFrameRate > 0.0f);
+	ASSERT(desc.mType == VAT_TYPE_SKELETON || desc.mSkinnedMesh);
+	ASSERT(desc.mFormat == ImageFormat::RGBA16F || desc.mFormat == ImageFormat::RGBA32F);
+
+	const int64_t bakeStartTime = getUSec();
+
+	Destroy();
+
+	const float duration = desc.mClip->GetDuration();
+	const unsigned int numFrames = (unsigned int)ceilf(duration * desc.mFrameRate) + 1;
+	const unsigned int numElements = desc.mType == VAT_TYPE_SKELETON ? 2 * desc.mRig->GetNumJoints() :
+		(desc.mType == VAT_TYPE_PALETTE ? desc.mRig->GetNumJoints() : desc.mSkinnedMesh->GetNumVertices());
+
+	if (desc.mFormat == ImageFormat::RGBA16F && numFrames > VAT_MAX_HALF_INTEGER)
+	{
+		ErrorMsg("Too many frames for a RGBA16F vertex animation texture, lower the frame rate or use RGBA32F");
+		return false;
+	}
+
+	// Frames wrap onto as many rows as needed, the header needs a row of its own
+	const unsigned int texelsPerFrame = numElements * TexelsPerElement(desc.mType);
+	const unsigned int width = max(min(texelsPerFrame, desc.mMaxWidth), (unsigned int)VAT_NUM_HEADER_TEXELS);
+	const unsigned int rowsPerFrame = (texelsPerFrame + width - 1) / width;
+
+	unsigned char* pixels = mImage.Create(desc.mFormat, width, 1 + numFrames * rowsPerFrame, 1, 1);
+	memset(pixels, 0, mImage.GetMipMappedSize());
+
+	SetLayout(desc.mType, numElements, numFrames, duration);
+
+	// Header: frame count, element count split in two exact halves and type, then the duration split in a coarse and a fine part
+	const float durationHigh = (float)half(duration);
+	SetTexel(0, 0, Vector4((float)numFrames, (float)(numElements % VAT_MAX_HALF_INTEGER), (float)(numElements / VAT_MAX_HALF_INTEGER), (float)desc.mType));
+	SetTexel(1, 0, Vector4(durationHigh, duration - durationHigh, 0.0f, 0.0f));
+
+	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+	ozz::animation::SamplingCache* cache = allocator->New<ozz::animation::SamplingCache>(desc.mRig->GetNumJoints());
+	ozz::Range<SoaTransform> localTrans = allocator->AllocateRange<SoaTransform>(desc.mRig->GetNumSoaJoints());
+
+	bool success = true;
+	for (unsigned int frame = 0; frame < numFrames && success; frame++)
+	{
+		const float timeRatio = numFrames > 1 ? (float)frame / (numFrames - 1) : 0.0f;
+		success = SampleModelMats(desc.mRig, desc.mClip, cache, localTrans, timeRatio);
+		if (success)
+		{
+			UpdateLivePose(desc);
+			BakeFrame(desc, frame);
+		}
+	}
+
+	// Compare the playback with live sampling, between the frames as well
+	if (success && pStats)
+	{
+		pStats->mTextureSize = GetMemorySize();
+		pStats->mClipSize = desc.mClip->GetMemorySize();
+		pStats->mMaxError = 0.0f;
+
+		const unsigned int texelsPerElement = TexelsPerElement(desc.mType);
+		const unsigned int numErrorSamples = (numFrames - 1) * 4 + 1;
+		int64_t liveUpdateUSec = 0;
+
+		for (unsigned int sample = 0; sample < numErrorSamples && success; sample++)
+		{
+			const float timeRatio = numErrorSamples > 1 ? (float)sample / (numErrorSamples - 1) : 0.0f;
+
+			const int64_t liveUpdateStartTime = getUSec();
+			success = SampleModelMats(desc.mRig, desc.mClip, cache, localTrans, timeRatio);
+			UpdateLivePose(desc);
+			liveUpdateUSec += getUSec() - liveUpdateStartTime;
+
+			unsigned int frame0, frame1;
+			float weight;
+			GetFrames(timeRatio * duration, frame0, frame1, weight);
+			if (timeRatio == 1.0f)
+			{
+				// The end of the clip wraps to its start, which holds the same pose for looping clips only
+				frame0 = frame1 = numFrames - 1;
+				weight = 0.0f;
+			}
+
+			for (unsigned int element = 0; element < numElements; element++)
+			{
+				Vector4 liveTexels[3];
+				Vector4 bakedTexels[3];
+				GetLiveTexels(desc, element, liveTexels);
+				for (unsigned int texel = 0; texel < texelsPerElement; texel++)
+					bakedTexels[texel] = lerp(weight, GetTexel(frame0, element, texel), GetTexel(frame1, element, texel));
+
+				if (desc.mType == VAT_TYPE_VERTICES)
+				{
+					pStats->mMaxError = max(pStats->mMaxError, (float)length(liveTexels[0].getXYZ() - bakedTexels[0].getXYZ()));
+					continue;
+				}
+
+				for (unsigned int point = 0; point < sizeof(gErrorPoints) / sizeof(gErrorPoints[0]); point++)
+				{
+					const Vector3 live((float)dot(liveTexels[0], gErrorPoints[point]), (float)dot(liveTexels[1], gErrorPoints[point]), (float)dot(liveTexels[2], gErrorPoints[point]));
+					const Vector3 baked((float)dot(bakedTexels[0], gErrorPoints[point]), (float)dot(bakedTexels[1], gErrorPoints[point]), (float)dot(bakedTexels[2], gErrorPoints[point]));
+					pStats->mMaxError = max(pStats->mMaxError, (float)length(live - baked));
+				}
+			}
+		}
+
+		pStats->mLiveUpdateUs = (float)liveUpdateUSec / numErrorSamples;
+	}
+
+	allocator->Deallocate(localTrans);
+	allocator->Delete(cache);
+
+	if (!success)
+		Destroy();
+	else if (pStats)
+		pStats->mBakeMs = (getUSec() - bakeStartTime) / 1000.0f;
+
+	return success;
+}
+
+bool VertexAnimationTexture::Load(const char* fileName, FSRoot root)
+{
+	Destroy();
+
+	if (!mImage.loadImage(fileName, false, NULL, NULL, root))
+		return false;
+
+	if ((mImage.getFormat() != ImageFormat::RGBA16F && mImage.getFormat() != ImageFormat::RGBA32F) || mImage.GetWidth() < VAT_NUM_HEADER_TEXELS)
+	{
+		LOGERRORF("\"%s\": Not a vertex animation texture.", fileName);
+		Destroy();
+		return false;
+	}
+
+	const Vector4 header = ReadTexel(0, 0);
+	const Vector4 durationParts = ReadTexel(1, 0);
+	const unsigned int numElements = (unsigned int)header.getY() + (unsigned int)header.getZ() * VAT_MAX_HALF_INTEGER;
+	SetLayout((VertexAnimationTextureType)(unsigned int)header.getW(), numElements, (unsigned int)header.getX(), durationParts.getX() + durationParts.getY());
+
+	if (mType > VAT_TYPE_VERTICES || mNumFrames == 0 || mImage.GetHeight() < 1 + mNumFrames * mRowsPerFrame)
+	{
+		LOGERRORF("\"%s\": Invalid vertex animation texture header.", fileName);
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+bool VertexAnimationTexture::Save(const char* fileName, FSRoot root)
+{
+	ASSERT(mImage.GetPixels());
+
+	return mImage.iSaveDDS(fileName, root);
+}
+
+void VertexAnimationTexture::Destroy()
+{
+	mImage.Destroy();
+	mNumElements = 0;
+	mNumFrames = 0;
+	mRowsPerFrame = 0;
+}
+
+Vector4 VertexAnimationTexture::GetTexel(unsigned int frame, unsigned int element, unsigned int texel)
+{
+	ASSERT(frame < mNumFrames && element < mNumElements && texel < mTexelsPerElement);
+
+	const unsigned int frameTexel = element * mTexelsPerElement + texel;
+	return ReadTexel(frameTexel % GetWidth(), 1 + frame * mRowsPerFrame + frameTexel / GetWidth());
+}
+
+void VertexAnimationTexture::GetFrames(float time, unsigned int& frame0, unsigned int& frame1, float& weight)
+{
+	if (mNumFrames < 2 || mDuration <= 0.0f)
+	{
+		frame0 = frame1 = 0;
+		weight = 0.0f;
+		return;
+	}
+
+	float wrappedTime = fmodf(time, mDuration);
+	if (wrappedTime < 0.0f)
+		wrappedTime += mDuration;
+
+	const float frame = wrappedTime / mDuration * (mNumFrames - 1);
+	frame0 = min((unsigned int)frame, mNumFrames - 1);
+	frame1 = min(frame0 + 1, mNumFrames - 1);
+	weight = frame - frame0;
+}
+
+void VertexAnimationTexture::SetLayout(VertexAnimationTextureType type, unsigned int numElements, unsigned int numFrames, float duration)
+{
+	mType = type;
+	mNumElements = numElements;
+	mTexelsPerElement = TexelsPerElement(type);
+	mNumFrames = numFrames;
+	mRowsPerFrame = (numElements * mTexelsPerElement + GetWidth() - 1) / GetWidth();
+	mDuration = duration;
+}
+
+void VertexAnimationTexture::SetTexel(unsigned int x, unsigned int y, const Vector4& value)
+{
+	const unsigned int index = (y * GetWidth() + x) * 4;
+	if (mImage.getFormat() == ImageFormat::RGBA16F)
+	{
+		half* texel = (half*)mImage.GetPixels() + index;
+		texel[0] = half(value.getX());
+		texel[1] = half(value.getY());
+		texel[2] = half(value.getZ());
+		texel[3] = half(value.getW());
+	}
+	else
+	{
+		float* texel = (float*)mImage.GetPixels() + index;
+		texel[0] = value.getX();
+		texel[1] = value.getY();
+		texel[2] = value.getZ();
+		texel[3] = value.getW();
+	}
+}
+
+Vector4 VertexAnimationTexture::ReadTexel(unsigned int x, unsigned int y)
+{
+	const unsigned int index = (y * GetWidth() + x) * 4;
+	if (mImage.getFormat() == ImageFormat::RGBA16F)
+	{
+		const half* texel = (const half*)mImage.GetPixels() + index;
+		return Vector4(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	const float* texel = (const float*)mImage.GetPixels() + index;
+	return Vector4(texel[0], texel[1], texel[2], texel[3]);
+}
+
+void VertexAnimationTexture::BakeFrame(const VertexAnimationTextureDesc& desc, unsigned int frame)
+{
+	Vector4 texels[3];
+	for (unsigned int element = 0; element < mNumElements; element++)
+	{
+		GetLiveTexels(desc, element, texels);
+
+		const unsigned int frameTexel = element * mTexelsPerElement;
+		for (unsigned int texel = 0; texel < mTexelsPerElement; texel++)
+			SetTexel((frameTexel + texel) % GetWidth(), 1 + frame * mRowsPerFrame + (frameTexel + texel) / GetWidth(), texels[texel]);
+	}
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Image/Image.h"
+
+#include "Clip.h"
+#include "SkinnedMesh.h"
+
+// Number of texels at the start of the first row of a vertex animation texture holding its layout, the frames start on the second row
+#define VAT_NUM_HEADER_TEXELS 2
+
+// What is baked for each frame of a vertex animation texture. The texels of an element are consecutive
+enum VertexAnimationTextureType
+{
+	// Instance matrices of the joints then of the bones of the rig, as drawn by SkeletonBatcher. 3 texels per matrix holding its first 3 rows
+	VAT_TYPE_SKELETON = 0,
+
+	// Skinning matrices of the joints of a SkinnedMesh, 3 texels per matrix holding its first 3 rows
+	VAT_TYPE_PALETTE,
+
+	// Skinned position then normal of each vertex of a SkinnedMesh, 2 texels per vertex
+	VAT_TYPE_VERTICES,
+};
+
+// User will have to predefine to pass into VertexAnimationTexture's Bake function
+struct VertexAnimationTextureDesc
+{
+	VertexAnimationTextureType mType = VAT_TYPE_SKELETON;
+
+	// Rig the clip is sampled on, posed in model space
+	Rig* mRig = NULL;
+
+	Clip* mClip = NULL;
+
+	// Mesh skinned to mRig, needed by VAT_TYPE_PALETTE and VAT_TYPE_VERTICES
+	SkinnedMesh* mSkinnedMesh = NULL;
+
+	// Rate in Hz the clip is baked at. Rounded up so the last frame falls on the end of the clip
+	float mFrameRate = 30.0f;
+
+	// RGBA16F halves the memory of RGBA32F, which stores the transforms exactly
+	ImageFormat::Enum mFormat = ImageFormat::RGBA16F;
+
+	// Largest width of the texture, the texels of a frame wrap onto several rows past it
+	unsigned int mMaxWidth = 4096;
+};
+
+// Results of VertexAnimationTexture::Bake, comparing the playback of the texture with live sampling of the clip
+struct VertexAnimationTextureStats
+{
+	// Size in bytes of the texture and of the runtime animation it replaces
+	size_t mTextureSize;
+	size_t mClipSize;
+
+	// Largest distance in meters between a point transformed by the live and by the baked data, between frames included
+	float mMaxError;
+
+	// Time in microseconds the CPU spends on each live update of an instance, saved by the GPU playback
+	float mLiveUpdateUs;
+
+	// Time in milliseconds the bake took
+	float mBakeMs;
+};
+
+// Bakes a clip into a texture of per frame transforms so crowds can be played back entirely on the GPU,
+// each instance at its own time offset. The texture can be saved as DDS and loaded back without the clip or the rig.
+// Frame f of element e starts at texel e * GetTexelsPerElement() of the frame, which covers GetRowsPerFrame() rows from row 1 + f * GetRowsPerFrame().
+// Playback interpolates linearly between the two frames around the time of an instance
+class VertexAnimationTexture
+{
+
+public:
+
+	// Samples the clip on the rig at each frame and stores the transforms in the texture.
+	// Poses desc.mRig, and skins desc.mSkinnedMesh on the calling thread for VAT_TYPE_VERTICES
+	bool Bake(const VertexAnimationTextureDesc& desc, VertexAnimationTextureStats* pStats = NULL);
+
+	// Loads a texture saved by Save
+	bool Load(const char* fileName, FSRoot root = FSR_Textures);
+
+	// Saves the texture as DDS
+	bool Save(const char* fileName, FSRoot root = FSR_Textures);
+
+	// Must be called to clean up the object if it was baked or loaded
+	void Destroy();
+
+	// Reads back a texel of an element at a frame
+	Vector4 GetTexel(unsigned int frame, unsigned int element, unsigned int texel);
+
+	// Gets the frames around time in seconds, wrapped over the duration, and the weight of the second one
+	void GetFrames(float time, unsigned int& frame0, unsigned int& frame1, float& weight);
+
+	// Gets the image holding the texture, to create the GPU texture from
+	inline Image* GetImage() { return &mImage; };
+
+	inline VertexAnimationTextureType GetType() { return mType; };
+
+	// Gets the number of matrices or vertices baked for each frame
+	inline unsigned int GetNumElements() { return mNumElements; };
+
+	inline unsigned int GetTexelsPerElement() { return mTexelsPerElement; };
+
+	inline unsigned int GetNumFrames() { return mNumFrames; };
+
+	inline unsigned int GetRowsPerFrame() { return mRowsPerFrame; };
+
+	inline unsigned int GetWidth() { return mImage.GetWidth(); };
+
+	// Gets the duration of the baked clip
+	inline float GetDuration() { return mDuration; };
+
+	// Gets the size in bytes of the texture
+	inline size_t GetMemorySize() { return mImage.GetMipMappedSize(); };
+
+private:
+
+	// Sets the layout from the number of elements and frames
+	void SetLayout(VertexAnimationTextureType type, unsigned int numElements, unsigned int numFrames, float duration);
+
+	// Writes a texel of the texture
+	void SetTexel(unsigned int x, unsigned int y, const Vector4& value);
+
+	// Reads a texel of the texture
+	Vector4 ReadTexel(unsigned int x, unsigned int y);
+
+	// Writes the elements of a frame from the current pose of the rig or the mesh
+	void BakeFrame(const VertexAnimationTextureDesc& desc, unsigned int frame);
+
+	// Image holding the header row and the frames
+	Image mImage;
+
+	VertexAnimationTextureType mType = VAT_TYPE_SKELETON;
+
+	unsigned int mNumElements = 0;
+
+	unsigned int mTexelsPerElement = 0;
+
+	unsigned int mNumFrames = 0;
+
+	unsigned int mRowsPerFrame = 0;
+
+	float mDuration = 0.0f;
+};
@@ -315,7 +315,7 @@ int Fontstash::defineFont(const char* identification, const char* filename, uint
 
 	File file = File();
 	file.Open(filename, FileMode::FM_ReadBinary, (FSRoot)root);
-	unsigned bytes = file.GetSize();
+	unsigned bytes = (unsigned)file.GetSize();
 	void* buffer = conf_malloc(bytes);
 	file.Read(buffer, bytes);
 
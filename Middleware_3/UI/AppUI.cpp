@@ -268,6 +268,20 @@ IWidget* TextboxWidget::Clone() const
 	return pWidget;
 }
 
+uint32_t TextboxWidget::GetTextHash() const
+{
+	// Hashing the text is cheaper than keeping a copy of the whole buffer
+	uint32_t hash = 0;
+	for (uint32_t i = 0; i < mLength && pData[i]; ++i)
+		hash = (uint8_t)pData[i] + (hash << 6) + (hash << 16) - hash;
+	return hash;
+}
+
+void TextboxWidget::UpdateVersion()
+{
+	TrackValue(GetTextHash(), mLastHash);
+}
+
 IWidget* CheckboxWidget::Clone() const
 {
 	CheckboxWidget* pWidget = conf_placement_new<CheckboxWidget>(
@@ -43,10 +43,15 @@ public:
 		, pOnDeactivated(NULL)
 		, pOnDeactivatedAfterEdit(NULL)
 		, mLabel(_label)
+		, mVersion(0)
 	{}
 	virtual ~IWidget() {}
 	virtual IWidget* Clone() const = 0;
 	virtual void Draw() = 0;
+	// Bumps the version if the data bound to the widget changed since the last call.
+	// The GUI driver only rebuilds a window when the versions of its widgets changed
+	virtual void UpdateVersion() {}
+	uint32_t GetVersion() const { return mVersion; }
 
 	// Common callbacks that can be used by the clients
 	WidgetCallback pOnHover;					// Widget is hovered, usable, and not blocked by anything.
@@ -58,7 +63,23 @@ public:
 
 protected:
 	void ProcessCallbacks();
+
+	// Hidden ImGui label of the bound data, formatted once instead of every frame
+	void SetLabelId(const void* pData) { mLabelId = tinystl::string::format("##%llu", (uint64_t)pData); }
+
+	template <typename T>
+	void TrackValue(const T& value, T& lastValue)
+	{
+		if (memcmp(&value, &lastValue, sizeof(T)) != 0)
+		{
+			memcpy(&lastValue, &value, sizeof(T));
+			++mVersion;
+		}
+	}
+
 	tinystl::string mLabel;
+	tinystl::string mLabelId;
+	uint32_t mVersion;
 
 private:
 	// Disable copy
@@ -70,12 +91,23 @@ class CollapsingHeaderWidget : public IWidget
 {
 public:
 	CollapsingHeaderWidget(const tinystl::string& _label) :
-		IWidget(_label) {}
+		IWidget(_label),
+		mLastSubWidgetsVersion(0) {}
 
 	~CollapsingHeaderWidget() { RemoveAllSubWidgets(); }
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion()
+	{
+		uint32_t subWidgetsVersion = 0;
+		for (IWidget* pWidget : mGroupedWidgets)
+		{
+			pWidget->UpdateVersion();
+			subWidgetsVersion = subWidgetsVersion * 31 + (uint32_t)(uintptr_t)pWidget + pWidget->GetVersion();
+		}
+		TrackValue(subWidgetsVersion, mLastSubWidgetsVersion);
+	}
 
 	IWidget* AddSubWidget(const IWidget& widget)
 	{
@@ -106,6 +138,7 @@ public:
 
 private:
 	tinystl::vector<IWidget*> mGroupedWidgets;
+	uint32_t mLastSubWidgetsVersion;
 };
 
 class LabelWidget : public IWidget
@@ -147,10 +180,15 @@ public:
 		pData(_data),
 		mMin(_min),
 		mMax(_max),
-		mStep(_step) {}
+		mStep(_step),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 
 	tinystl::string mFormat;
@@ -158,6 +196,7 @@ protected:
 	float		   mMin;
 	float		   mMax;
 	float		   mStep;
+	float		   mLastValue;
 };
 
 class SliderFloat2Widget : public IWidget
@@ -169,16 +208,22 @@ public:
 		pData(_data),
 		mMin(_min),
 		mMax(_max),
-		mStep(_step) {}
+		mStep(_step),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 	tinystl::string mFormat;
 	float2*		 pData;
 	float2		  mMin;
 	float2		  mMax;
 	float2		  mStep;
+	float2		  mLastValue;
 };
 
 class SliderFloat3Widget : public IWidget
@@ -190,16 +235,22 @@ public:
 		pData(_data),
 		mMin(_min),
 		mMax(_max),
-		mStep(_step) {}
+		mStep(_step),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 	tinystl::string mFormat;
 	float3*		 pData;
 	float3		  mMin;
 	float3		  mMax;
 	float3		  mStep;
+	float3		  mLastValue;
 };
 
 class SliderFloat4Widget : public IWidget
@@ -211,16 +262,22 @@ public:
 		pData(_data),
 		mMin(_min),
 		mMax(_max),
-		mStep(_step) {}
+		mStep(_step),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 	tinystl::string mFormat;
 	float4*		 pData;
 	float4		  mMin;
 	float4		  mMax;
 	float4		  mStep;
+	float4		  mLastValue;
 };
 
 class SliderIntWidget : public IWidget
@@ -232,10 +289,15 @@ public:
 		pData(_data),
 		mMin(_min),
 		mMax(_max),
-		mStep(_step) {}
+		mStep(_step),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 
 	tinystl::string mFormat;
@@ -243,6 +305,7 @@ protected:
 	int32_t		 mMin;
 	int32_t		 mMax;
 	int32_t		 mStep;
+	int32_t		 mLastValue;
 };
 
 class SliderUintWidget : public IWidget
@@ -254,10 +317,15 @@ public:
 		pData(_data),
 		mMin(_min),
 		mMax(_max),
-		mStep(_step) {}
+		mStep(_step),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 
 	tinystl::string mFormat;
@@ -265,6 +333,7 @@ protected:
 	uint32_t		mMin;
 	uint32_t		mMax;
 	uint32_t		mStep;
+	uint32_t		mLastValue;
 };
 
 class RadioButtonWidget : public IWidget
@@ -273,13 +342,19 @@ public:
 	RadioButtonWidget(const tinystl::string& _label, int32_t* _data, const int32_t _radioId) :
 		IWidget(_label),
 		pData(_data),
-		mRadioId(_radioId) {}
+		mRadioId(_radioId),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 	int32_t*			pData;
 	int32_t		 mRadioId;
+	int32_t		 mLastValue;
 };
 
 class CheckboxWidget : public IWidget
@@ -287,13 +362,18 @@ class CheckboxWidget : public IWidget
 public:
 	CheckboxWidget(const tinystl::string& _label, bool* _data) :
 		IWidget(_label),
-		pData(_data)
-	{}
+		pData(_data),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 
 	bool* pData;
+	bool mLastValue;
 };
 
 class DropdownWidget : public IWidget
@@ -301,8 +381,10 @@ class DropdownWidget : public IWidget
 public:
 	DropdownWidget(const tinystl::string& _label, uint32_t* _data, const char** _names, const uint32_t* _values, uint32_t count) :
 		IWidget(_label),
-		pData(_data)
+		pData(_data),
+		mLastValue(*_data)
 	{
+		SetLabelId(_data);
 		mValues.resize(count);
 		mNames.resize(count);
 		for (uint32_t i = 0; i < count; ++i)
@@ -313,11 +395,13 @@ public:
 	}
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 protected:
 
 	uint32_t*						   pData;
 	tinystl::vector<uint32_t>		   mValues;
 	tinystl::vector<tinystl::string>	mNames;
+	uint32_t mLastValue;
 };
 
 class ProgressBarWidget : public IWidget
@@ -326,14 +410,20 @@ public:
 	ProgressBarWidget(const tinystl::string& _label, size_t* _data, size_t const _maxProgress) :
 		IWidget(_label),
 		pData(_data),
-		mMaxProgress(_maxProgress) {}
+		mMaxProgress(_maxProgress),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 
 protected:
 	size_t* pData;
 	size_t  mMaxProgress;
+	size_t  mLastValue;
 };
 
 class ColorSliderWidget : public IWidget
@@ -341,13 +431,19 @@ class ColorSliderWidget : public IWidget
 public:
 	ColorSliderWidget(const tinystl::string& _label, uint32_t* _data) :
 		IWidget(_label),
-		pData(_data) {}
+		pData(_data),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 
 protected:
 	uint32_t*   pData;
+	uint32_t mLastValue;
 };
 
 class ColorPickerWidget : public IWidget
@@ -355,13 +451,19 @@ class ColorPickerWidget : public IWidget
 public:
 	ColorPickerWidget(const tinystl::string& _label, uint32_t* _data) :
 		IWidget(_label),
-		pData(_data) {}
+		pData(_data),
+		mLastValue(*_data)
+	{
+		SetLabelId(_data);
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion() { TrackValue(*pData, mLastValue); }
 
 protected:
 	uint32_t*   pData;
+	uint32_t mLastValue;
 };
 
 class TextboxWidget : public IWidget
@@ -371,15 +473,23 @@ public:
 		IWidget(_label),
 		pData(_data),
 		mLength(_length),
-		mAutoSelectAll(_autoSelectAll) {}
+		mAutoSelectAll(_autoSelectAll)
+	{
+		SetLabelId(_data);
+		mLastHash = GetTextHash();
+	}
 
 	IWidget* Clone() const;
 	void Draw();
+	void UpdateVersion();
 
 protected:
+	uint32_t GetTextHash() const;
+
 	char*	   pData;
 	uint32_t	mLength;
 	bool		mAutoSelectAll;
+	uint32_t	mLastHash;
 };
 
 struct Renderer;
@@ -437,7 +547,8 @@ enum GuiComponentFlags
 	GUI_COMPONENT_FLAGS_ALWAYS_HORIZONTAL_SCROLLBAR	 = 1 << 12,  // Always show horizontal scrollbar (even if ContentSize.x < Size.x)
 	GUI_COMPONENT_FLAGS_ALWAYS_USE_WINDOW_PADDING	   = 1 << 13,  // Ensure child windows without border uses style.WindowPadding (ignored by default for non-bordered child windows, because more convenient)
 	GUI_COMPONENT_FLAGS_NO_NAV_INPUT					= 1 << 14,  // No gamepad/keyboard navigation within the window
-	GUI_COMPONENT_FLAGS_NO_NAV_FOCUS					= 1 << 15   // No focusing toward this window with gamepad/keyboard navigation (e.g. skipped by CTRL+TAB)
+	GUI_COMPONENT_FLAGS_NO_NAV_FOCUS					= 1 << 15,  // No focusing toward this window with gamepad/keyboard navigation (e.g. skipped by CTRL+TAB)
+	GUI_COMPONENT_FLAGS_IMMEDIATE					   = 1 << 16   // Rebuild the window every frame instead of reusing its draw data while its widgets and the input did not change
 };
 
 class GuiComponent
@@ -43,8 +43,9 @@
 
 #include "../../Common_3/OS/Interfaces/IMemoryManager.h" //NOTE: this should be the last include in a .cpp
 
-#define LABELID(prop) tinystl::string::format("##%llu", (uint64_t)(prop.pData))
-#define LABELID1(prop) tinystl::string::format("##%llu", (uint64_t)(prop))
+// Number of frames a window has to be rebuilt without changes before its draw data is reused.
+// ImGui needs a frame to resize windows to their content and one more to settle hover states
+#define UI_STABLE_FRAME_COUNT 2
 
 namespace ImGui
 {
@@ -111,11 +112,44 @@ public:
 
 
 protected:
+	// Draw command of the cached draw data, the offsets are relative to the cached ring buffer ranges
+	typedef struct UIDrawCmd
+	{
+		uint32_t			mScissor[4];
+		Texture*			pTexture;
+		uint32_t			mIndexCount;
+		uint32_t			mFirstIndex;
+		uint32_t			mFirstVertex;
+		// Only valid on the frame the draw data was built, draw data with callbacks is never reused
+		const ImDrawList*   pCallbackList;
+		const ImDrawCmd*	pCallbackCmd;
+	} UIDrawCmd;
+
+	void buildDrawCmds(ImDrawData* pDrawData);
+
 	ImGuiContext* context;
 	float4 mCurrentWindowRect;
 	Texture* pFontTexture;
 	float2 dpiScale;
 
+	// Retained state. The window is only rebuilt when its widgets, its settings or the input changed,
+	// otherwise the draw commands and ring buffer ranges of the last build are drawn again
+	tinystl::vector<UIDrawCmd>  mDrawCmds;
+	RingBufferOffset			mVertexOffset;
+	RingBufferOffset			mIndexOffset;
+	RingBufferOffset			mUniformOffset;
+	float2					  mDisplaySize;
+	float4					  mWindowRect;
+	tinystl::string			 mTitle;
+	int32_t					 mFlags;
+	uint32_t					mMenuCount;
+	uint32_t					mWidgetsVersion;
+	uint32_t					mStableFrameCount;
+	float					   mSkippedTime;
+	bool						mDrawCmdsValid;
+	bool						mInputDirty;
+	bool						mMouseHovering;
+
 	using PipelineMap = tinystl::unordered_map<uint64_t, Pipeline*>;
 
 	Renderer*				   pRenderer;
@@ -197,7 +231,7 @@ void CollapsingHeaderWidget::Draw()
 
 void LabelWidget::Draw()
 {
-	ImGui::Text("%s", mLabel.c_str());
+	ImGui::TextUnformatted(mLabel.c_str());
 	ProcessCallbacks();
 }
 
@@ -215,52 +249,58 @@ void ButtonWidget::Draw()
 
 void SliderFloatWidget::Draw()
 {
-	ImGui::Text("%s", mLabel.c_str());
-	ImGui::SliderFloatWithSteps(LABELID1(pData), pData, mMin, mMax, mStep, mFormat);
+	ImGui::TextUnformatted(mLabel.c_str());
+	ImGui::SliderFloatWithSteps(mLabelId, pData, mMin, mMax, mStep, mFormat);
 	ProcessCallbacks();
 }
 
 void SliderFloat2Widget::Draw()
 {
-	ImGui::Text("%s", mLabel.c_str());
+	ImGui::TextUnformatted(mLabel.c_str());
 	for (uint32_t i = 0; i < 2; ++i)
 	{
-		ImGui::SliderFloatWithSteps(LABELID1(&pData->operator[](i)), &pData->operator[](i), mMin[i], mMax[i], mStep[i], mFormat);
+		ImGui::PushID((int)i);
+		ImGui::SliderFloatWithSteps(mLabelId, &pData->operator[](i), mMin[i], mMax[i], mStep[i], mFormat);
+		ImGui::PopID();
 		ProcessCallbacks();
 	}
 }
 
 void SliderFloat3Widget::Draw()
 {
-	ImGui::Text("%s", mLabel.c_str());
+	ImGui::TextUnformatted(mLabel.c_str());
 	for (uint32_t i = 0; i < 3; ++i)
 	{
-		ImGui::SliderFloatWithSteps(LABELID1(&pData->operator[](i)), &pData->operator[](i), mMin[i], mMax[i], mStep[i], mFormat);
+		ImGui::PushID((int)i);
+		ImGui::SliderFloatWithSteps(mLabelId, &pData->operator[](i), mMin[i], mMax[i], mStep[i], mFormat);
+		ImGui::PopID();
 		ProcessCallbacks();
 	}
 }
 
 void SliderFloat4Widget::Draw()
 {
-	ImGui::Text("%s", mLabel.c_str());
+	ImGui::TextUnformatted(mLabel.c_str());
 	for (uint32_t i = 0; i < 4; ++i)
 	{
-		ImGui::SliderFloatWithSteps(LABELID1(&pData->operator[](i)), &pData->operator[](i), mMin[i], mMax[i], mStep[i], mFormat);
+		ImGui::PushID((int)i);
+		ImGui::SliderFloatWithSteps(mLabelId, &pData->operator[](i), mMin[i], mMax[i], mStep[i], mFormat);
+		ImGui::PopID();
 		ProcessCallbacks();
 	}
 }
 
 void SliderIntWidget::Draw()
 {
-	ImGui::Text("%s", mLabel.c_str());
-	ImGui::SliderIntWithSteps(LABELID1(pData), pData, mMin, mMax, mStep, mFormat);
+	ImGui::TextUnformatted(mLabel.c_str());
+	ImGui::SliderIntWithSteps(mLabelId, pData, mMin, mMax, mStep, mFormat);
 	ProcessCallbacks();
 }
 
 void SliderUintWidget::Draw()
 {
-	ImGui::Text("%s", mLabel.c_str());
-	ImGui::SliderIntWithSteps(LABELID1(pData), (int32_t*)pData, (int32_t)mMin, (int32_t)mMax, (int32_t)mStep, mFormat);
+	ImGui::TextUnformatted(mLabel.c_str());
+	ImGui::SliderIntWithSteps(mLabelId, (int32_t*)pData, (int32_t)mMin, (int32_t)mMax, (int32_t)mStep, mFormat);
 	ProcessCallbacks();
 }
 
@@ -272,16 +312,16 @@ void RadioButtonWidget::Draw()
 
 void CheckboxWidget::Draw()
 {
-	ImGui::Text("%s", mLabel.c_str());
-	ImGui::Checkbox(LABELID1(pData), pData);
+	ImGui::TextUnformatted(mLabel.c_str());
+	ImGui::Checkbox(mLabelId, pData);
 	ProcessCallbacks();
 }
 
 void DropdownWidget::Draw()
 {
 	uint32_t& current = *pData;
-	ImGui::Text("%s", mLabel.c_str());
-	if (ImGui::BeginCombo(LABELID1(pData), mNames[current]))
+	ImGui::TextUnformatted(mLabel.c_str());
+	if (ImGui::BeginCombo(mLabelId, mNames[current]))
 	{
 		for (uint32_t i = 0; i < (uint32_t)mNames.size(); ++i)
 		{
@@ -308,7 +348,7 @@ void DropdownWidget::Draw()
 void ProgressBarWidget::Draw()
 {
 	size_t currProgress = *pData;
-	ImGui::Text("%s", mLabel.c_str());
+	ImGui::TextUnformatted(mLabel.c_str());
 	ImGui::ProgressBar((float)currProgress / mMaxProgress);
 	ProcessCallbacks();
 }
@@ -319,8 +359,8 @@ void ColorSliderWidget::Draw()
 	float4 combo_color = ToFloat4Color(colorPick) / 255.0f;
 
 	float col[4] = { combo_color.x, combo_color.y, combo_color.z, combo_color.w };
-	ImGui::Text("%s", mLabel.c_str());
-	if (ImGui::ColorEdit4(LABELID1(pData), col, ImGuiColorEditFlags_AlphaPreview))
+	ImGui::TextUnformatted(mLabel.c_str());
+	if (ImGui::ColorEdit4(mLabelId, col, ImGuiColorEditFlags_AlphaPreview))
 	{
 		if (col[0] != combo_color.x || col[1] != combo_color.y || col[2] != combo_color.z || col[3] != combo_color.w)
 		{
@@ -337,8 +377,8 @@ void ColorPickerWidget::Draw()
 	float4 combo_color = ToFloat4Color(colorPick) / 255.0f;
 
 	float col[4] = { combo_color.x, combo_color.y, combo_color.z, combo_color.w };
-	ImGui::Text("%s", mLabel.c_str());
-	if (ImGui::ColorPicker4(LABELID1(pData), col, ImGuiColorEditFlags_AlphaPreview))
+	ImGui::TextUnformatted(mLabel.c_str());
+	if (ImGui::ColorPicker4(mLabelId, col, ImGuiColorEditFlags_AlphaPreview))
 	{
 		if (col[0] != combo_color.x || col[1] != combo_color.y || col[2] != combo_color.z || col[3] != combo_color.w)
 		{
@@ -351,7 +391,7 @@ void ColorPickerWidget::Draw()
 
 void TextboxWidget::Draw()
 {
-	ImGui::InputText(LABELID1(pData), (char*)pData, mLength, mAutoSelectAll ? ImGuiInputTextFlags_AutoSelectAll : 0);
+	ImGui::InputText(mLabelId, (char*)pData, mLength, mAutoSelectAll ? ImGuiInputTextFlags_AutoSelectAll : 0);
 	ProcessCallbacks();
 }
 
@@ -521,6 +561,7 @@ void ImguiGUIDriver::exit()
 	}
 
 	mPipelinesTextured.clear();
+	mDrawCmds.clear();
 
 	removeSampler(pRenderer, pDefaultSampler);
 	removeBlendState(pBlendAlpha);
@@ -596,6 +637,11 @@ bool ImguiGUIDriver::load(Fontstash* fontstash, float fontSize, Texture* cursorT
 	io.KeyMap[ImGuiKey_Y] = 'Y';
 	io.KeyMap[ImGuiKey_Z] = 'Z';
 
+	// The cached draw commands reference the font texture of the previous load
+	mDrawCmds.clear();
+	mDrawCmdsValid = false;
+	mInputDirty = true;
+
 	return true;
 }
 
@@ -614,6 +660,9 @@ bool ImguiGUIDriver::onInput(const ButtonData* data)
 {
 	ImGui::SetCurrentContext(context);
 	ImGuiIO& io = ImGui::GetIO();
+	// Mouse moves are handled below, every other event can change the UI
+	if (data->mUserId != KEY_UI_MOVE)
+		mInputDirty = true;
 	io.NavActive = true;
 	io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
 	if (GAINPUT_GAMEPAD & data->mActiveDevicesMask)
@@ -628,10 +677,15 @@ bool ImguiGUIDriver::onInput(const ButtonData* data)
 		io.MousePos.x *= (float)io.DisplaySize.x;
 		io.MousePos.y *= (float)io.DisplaySize.y;
 #endif
-		return ImGui::IsMouseHoveringAnyWindow() || ImGui::IsMouseHoveringRect(
+		const bool hovering = ImGui::IsMouseHoveringAnyWindow() || ImGui::IsMouseHoveringRect(
 			ImVec2(mCurrentWindowRect.x, mCurrentWindowRect.y),
 			ImVec2(mCurrentWindowRect.x + mCurrentWindowRect.z,
 				mCurrentWindowRect.y + mCurrentWindowRect.w), false);
+		// Moves away from the UI only change it when the mouse leaves a window
+		if (hovering || mMouseHovering)
+			mInputDirty = true;
+		mMouseHovering = hovering;
+		return hovering;
 	}
 	else if (data->mUserId == KEY_CONFIRM ||
 			data->mUserId == KEY_RIGHT_BUMPER ||
@@ -707,7 +761,6 @@ void ImguiGUIDriver::draw(Cmd* pCmd, float deltaTime,
 	ImGuiIO& io = ImGui::GetIO();
 	io.DisplaySize.x = (float)pCmd->mBoundWidth;
 	io.DisplaySize.y = (float)pCmd->mBoundHeight;
-	io.DeltaTime = deltaTime;
 
 	io.NavInputs[ImGuiNavInput_Activate] = InputSystem::GetButtonData(KEY_CONFIRM).mIsPressed ? 1.0f : 0.0f;
 	io.NavInputs[ImGuiNavInput_Cancel] = InputSystem::GetButtonData(KEY_CANCEL).mIsPressed ? 1.0f : 0.0f;
@@ -722,102 +775,155 @@ void ImguiGUIDriver::draw(Cmd* pCmd, float deltaTime,
 	io.NavInputs[ImGuiNavInput_TweakFast] = InputSystem::GetButtonData(KEY_RIGHT_BUMPER).mIsPressed ? 1.0f : 0.0f;
 	io.NavInputs[ImGuiNavInput_TweakSlow] = InputSystem::GetButtonData(KEY_LEFT_BUMPER).mIsPressed ? 1.0f : 0.0f;
 
-	ImGui::NewFrame();
 	/************************************************************************/
-	// Draw window
+	// Check if the window changed since it was last built
 	/************************************************************************/
-	if (showDemoWindow)
-		ImGui::ShowDemoWindow();
-
-	if (pTitle)
-	{
-		// Setup the ImGuiWindowFlags
-		ImGuiWindowFlags guiWinFlags = GUI_COMPONENT_FLAGS_NONE;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_TITLE_BAR)
-			guiWinFlags |= ImGuiWindowFlags_NoTitleBar;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_RESIZE)
-			guiWinFlags |= ImGuiWindowFlags_NoResize;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_MOVE)
-			guiWinFlags |= ImGuiWindowFlags_NoMove;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_SCROLLBAR)
-			guiWinFlags |= ImGuiWindowFlags_NoScrollbar;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_COLLAPSE)
-			guiWinFlags |= ImGuiWindowFlags_NoCollapse;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_AUTO_RESIZE)
-			guiWinFlags |= ImGuiWindowFlags_AlwaysAutoResize;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_INPUTS)
-			guiWinFlags |= ImGuiWindowFlags_NoInputs;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_MEMU_BAR)
-			guiWinFlags |= ImGuiWindowFlags_MenuBar;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_HORIZONTAL_SCROLLBAR)
-			guiWinFlags |= ImGuiWindowFlags_HorizontalScrollbar;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_FOCUS_ON_APPEARING)
-			guiWinFlags |= ImGuiWindowFlags_NoFocusOnAppearing;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_BRING_TO_FRONT_ON_FOCUS)
-			guiWinFlags |= ImGuiWindowFlags_NoBringToFrontOnFocus;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_VERTICAL_SCROLLBAR)
-			guiWinFlags |= ImGuiWindowFlags_AlwaysVerticalScrollbar;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_HORIZONTAL_SCROLLBAR)
-			guiWinFlags |= ImGuiWindowFlags_AlwaysHorizontalScrollbar;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_USE_WINDOW_PADDING)
-			guiWinFlags |= ImGuiWindowFlags_AlwaysUseWindowPadding;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_NAV_INPUT)
-			guiWinFlags |= ImGuiWindowFlags_NoNavInputs;
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_NAV_FOCUS)
-			guiWinFlags |= ImGuiWindowFlags_NoNavFocus;
-
-		bool result = ImGui::Begin(pTitle, pCloseButtonActiveValue, guiWinFlags);
-
-		// Setup the contextual menus
-		if (!contextualMenuLabels.empty() && ImGui::BeginPopupContextItem()) // <-- This is using IsItemHovered()
+	uint32_t widgetsVersion = propCount;
+	for (uint32_t i = 0; i < propCount; ++i)
+	{
+		if (pProps[i])
 		{
-			for (size_t i = 0; i < contextualMenuLabels.size(); i++)
+			pProps[i]->UpdateVersion();
+			widgetsVersion = widgetsVersion * 31 + (uint32_t)(uintptr_t)pProps[i] + pProps[i]->GetVersion();
+		}
+	}
+
+	bool changed = mInputDirty || showDemoWindow || (guiComponentFlags & GUI_COMPONENT_FLAGS_IMMEDIATE) ||
+		widgetsVersion != mWidgetsVersion || guiComponentFlags != mFlags || (uint32_t)contextualMenuLabels.size() != mMenuCount ||
+		io.DisplaySize.x != mDisplaySize.x || io.DisplaySize.y != mDisplaySize.y ||
+		x != mWindowRect.x || y != mWindowRect.y || w != mWindowRect.z || h != mWindowRect.w ||
+		strcmp(pTitle ? pTitle : "", mTitle.c_str()) != 0;
+	for (int i = 0; i < ImGuiNavInput_COUNT && !changed; ++i)
+		changed = io.NavInputs[i] > 0.0f;
+
+	if (changed)
+	{
+		mWidgetsVersion = widgetsVersion;
+		mFlags = guiComponentFlags;
+		mMenuCount = (uint32_t)contextualMenuLabels.size();
+		mDisplaySize = float2(io.DisplaySize.x, io.DisplaySize.y);
+		mWindowRect = float4(x, y, w, h);
+		mTitle = pTitle ? pTitle : "";
+		mInputDirty = false;
+		mStableFrameCount = 0;
+	}
+
+	if (!changed && mDrawCmdsValid && mStableFrameCount >= UI_STABLE_FRAME_COUNT)
+	{
+		// Time still has to advance for ImGui, for example for double clicks
+		mSkippedTime += deltaTime;
+	}
+	else
+	{
+		if (!changed)
+			++mStableFrameCount;
+
+		io.DeltaTime = deltaTime + mSkippedTime;
+		mSkippedTime = 0.0f;
+
+		ImGui::NewFrame();
+		/************************************************************************/
+		// Draw window
+		/************************************************************************/
+		if (showDemoWindow)
+			ImGui::ShowDemoWindow();
+
+		if (pTitle)
+		{
+			// Setup the ImGuiWindowFlags
+			ImGuiWindowFlags guiWinFlags = GUI_COMPONENT_FLAGS_NONE;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_TITLE_BAR)
+				guiWinFlags |= ImGuiWindowFlags_NoTitleBar;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_RESIZE)
+				guiWinFlags |= ImGuiWindowFlags_NoResize;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_MOVE)
+				guiWinFlags |= ImGuiWindowFlags_NoMove;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_SCROLLBAR)
+				guiWinFlags |= ImGuiWindowFlags_NoScrollbar;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_COLLAPSE)
+				guiWinFlags |= ImGuiWindowFlags_NoCollapse;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_AUTO_RESIZE)
+				guiWinFlags |= ImGuiWindowFlags_AlwaysAutoResize;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_INPUTS)
+				guiWinFlags |= ImGuiWindowFlags_NoInputs;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_MEMU_BAR)
+				guiWinFlags |= ImGuiWindowFlags_MenuBar;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_HORIZONTAL_SCROLLBAR)
+				guiWinFlags |= ImGuiWindowFlags_HorizontalScrollbar;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_FOCUS_ON_APPEARING)
+				guiWinFlags |= ImGuiWindowFlags_NoFocusOnAppearing;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_BRING_TO_FRONT_ON_FOCUS)
+				guiWinFlags |= ImGuiWindowFlags_NoBringToFrontOnFocus;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_VERTICAL_SCROLLBAR)
+				guiWinFlags |= ImGuiWindowFlags_AlwaysVerticalScrollbar;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_HORIZONTAL_SCROLLBAR)
+				guiWinFlags |= ImGuiWindowFlags_AlwaysHorizontalScrollbar;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_USE_WINDOW_PADDING)
+				guiWinFlags |= ImGuiWindowFlags_AlwaysUseWindowPadding;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_NAV_INPUT)
+				guiWinFlags |= ImGuiWindowFlags_NoNavInputs;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_NAV_FOCUS)
+				guiWinFlags |= ImGuiWindowFlags_NoNavFocus;
+
+			bool result = ImGui::Begin(pTitle, pCloseButtonActiveValue, guiWinFlags);
+
+			// Setup the contextual menus
+			if (!contextualMenuLabels.empty() && ImGui::BeginPopupContextItem()) // <-- This is using IsItemHovered()
 			{
-				if (ImGui::MenuItem(contextualMenuLabels[i].c_str()))
+				for (size_t i = 0; i < contextualMenuLabels.size(); i++)
 				{
-					if (i < contextualMenuCallbacks.size())
-						contextualMenuCallbacks[i]();
+					if (ImGui::MenuItem(contextualMenuLabels[i].c_str()))
+					{
+						if (i < contextualMenuCallbacks.size())
+							contextualMenuCallbacks[i]();
+					}
 				}
+				ImGui::EndPopup();
 			}
-			ImGui::EndPopup();
-		}
 
-		bool overrideSize = false;
-		bool overridePos = false;
+			bool overrideSize = false;
+			bool overridePos = false;
 
-		if ((guiComponentFlags & GUI_COMPONENT_FLAGS_NO_RESIZE) &&
-			!(guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_AUTO_RESIZE))
-			overrideSize = true;
+			if ((guiComponentFlags & GUI_COMPONENT_FLAGS_NO_RESIZE) &&
+				!(guiComponentFlags & GUI_COMPONENT_FLAGS_ALWAYS_AUTO_RESIZE))
+				overrideSize = true;
 
-		if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_MOVE)
-			overridePos = true;
+			if (guiComponentFlags & GUI_COMPONENT_FLAGS_NO_MOVE)
+				overridePos = true;
 
-		ImGui::SetWindowSize(ImVec2(w * dpiScale.x, h * dpiScale.y), overrideSize ? ImGuiCond_Always : ImGuiCond_Once);
-		ImGui::SetWindowPos(ImVec2(x * dpiScale.x, y * dpiScale.y), overridePos ? ImGuiCond_Always : ImGuiCond_Once);
+			ImGui::SetWindowSize(ImVec2(w * dpiScale.x, h * dpiScale.y), overrideSize ? ImGuiCond_Always : ImGuiCond_Once);
+			ImGui::SetWindowPos(ImVec2(x * dpiScale.x, y * dpiScale.y), overridePos ? ImGuiCond_Always : ImGuiCond_Once);
 
-		ImVec2 min = ImGui::GetWindowPos();
-		ImVec2 max = ImGui::GetWindowSize();
-		mCurrentWindowRect.x = min.x;
-		mCurrentWindowRect.y = min.y;
-		mCurrentWindowRect.z = max.x;
-		mCurrentWindowRect.w = max.y;
+			ImVec2 min = ImGui::GetWindowPos();
+			ImVec2 max = ImGui::GetWindowSize();
+			mCurrentWindowRect.x = min.x;
+			mCurrentWindowRect.y = min.y;
+			mCurrentWindowRect.z = max.x;
+			mCurrentWindowRect.w = max.y;
 
-		if (result)
-		{
-			for (uint32_t i = 0; i < propCount; ++i)
-				if (pProps[i])
-					pProps[i]->Draw();
+			if (result)
+			{
+				for (uint32_t i = 0; i < propCount; ++i)
+					if (pProps[i])
+						pProps[i]->Draw();
+			}
+
+			ImGui::End();
 		}
+		/************************************************************************/
+		/************************************************************************/
+		ImGui::EndFrame();
+		ImGui::Render();
+
+		// Hovered and active widgets have callbacks to process every frame and text input blinks its cursor
+		if (ImGui::IsAnyItemHovered() || ImGui::IsAnyItemActive() || io.WantTextInput)
+			mStableFrameCount = 0;
 
-		ImGui::End();
+		buildDrawCmds(ImGui::GetDrawData());
 	}
 	/************************************************************************/
+	// Draw the cached commands
 	/************************************************************************/
-	ImGui::EndFrame();
-	ImGui::Render();
-
-	ImDrawData* draw_data = ImGui::GetDrawData();
-
 	Pipeline* pPipeline = NULL;
 	GraphicsPipelineDesc pipelineDesc = {};
 	pipelineDesc.mDepthStencilFormat = (ImageFormat::Enum)pCmd->mBoundDepthStencilFormat;
@@ -843,6 +949,43 @@ void ImguiGUIDriver::draw(Cmd* pCmd, float deltaTime,
 	{
 		pPipeline = it.node->second;
 	}
+	if (mDrawCmds.empty())
+		return;
+
+	cmdSetViewport(pCmd, 0.0f, 0.0f, mDisplaySize.x, mDisplaySize.y, 0.0f, 1.0f);
+	cmdSetScissor(pCmd, 0, 0, (uint32_t)mDisplaySize.x, (uint32_t)mDisplaySize.y);
+	cmdBindPipeline(pCmd, pPipeline);
+	cmdBindIndexBuffer(pCmd, mIndexOffset.pBuffer, mIndexOffset.mOffset);
+	cmdBindVertexBuffer(pCmd, 1, &mVertexOffset.pBuffer, &mVertexOffset.mOffset);
+
+	DescriptorData params[1] = {};
+	params[0].pName = "uniformBlockVS";
+	params[0].pOffsets = &mUniformOffset.mOffset;
+	params[0].ppBuffers = &mUniformOffset.pBuffer;
+	cmdBindDescriptors(pCmd, pRootSignatureTextured, 1, params);
+
+	for (uint32_t i = 0; i < (uint32_t)mDrawCmds.size(); ++i)
+	{
+		const UIDrawCmd& drawCmd = mDrawCmds[i];
+		if (drawCmd.pCallbackCmd)
+		{
+			// User callback (registered via ImDrawList::AddCallback)
+			drawCmd.pCallbackCmd->UserCallback(drawCmd.pCallbackList, drawCmd.pCallbackCmd);
+			continue;
+		}
+
+		cmdSetScissor(pCmd, drawCmd.mScissor[0], drawCmd.mScissor[1], drawCmd.mScissor[2], drawCmd.mScissor[3]);
+
+		DescriptorData params[1] = {};
+		params[0].pName = "uTex";
+		params[0].ppTextures = (Texture**)&drawCmd.pTexture;
+		cmdBindDescriptors(pCmd, pRootSignatureTextured, 1, params);
+		cmdDrawIndexed(pCmd, drawCmd.mIndexCount, drawCmd.mFirstIndex, drawCmd.mFirstVertex);
+	}
+}
+
+void ImguiGUIDriver::buildDrawCmds(ImDrawData* draw_data)
+{
 	uint32_t vSize = 0;
 	uint32_t iSize = 0;
 	for (int n = 0; n < draw_data->CmdListsCount; n++)
@@ -852,17 +995,29 @@ void ImguiGUIDriver::draw(Cmd* pCmd, float deltaTime,
 		iSize += (cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
 	}
 
-	RingBufferOffset vOffset = getVertexBufferOffset(pPlainMeshRingBuffer, vSize);
-	RingBufferOffset iOffset = getIndexBufferOffset(pPlainMeshRingBuffer, iSize);
+	mDrawCmds.clear();
+	mDrawCmdsValid = true;
+	if (!vSize || !iSize)
+		return;
+
+	// The ranges stay valid while the draw data is reused since only this driver allocates from its ring buffers
+	mVertexOffset = getVertexBufferOffset(pPlainMeshRingBuffer, vSize);
+	mIndexOffset = getIndexBufferOffset(pPlainMeshRingBuffer, iSize);
+	if (!mVertexOffset.pBuffer || !mIndexOffset.pBuffer)
+	{
+		LOGERRORF("UI draw data (%u vertex bytes, %u index bytes) does not fit in the ring buffers", vSize, iSize);
+		mDrawCmdsValid = false;
+		return;
+	}
 	// Copy and convert all vertices into a single contiguous buffer
-	uint64_t vtx_dst = vOffset.mOffset;
-	uint64_t idx_dst = iOffset.mOffset;
+	uint64_t vtx_dst = mVertexOffset.mOffset;
+	uint64_t idx_dst = mIndexOffset.mOffset;
 	for (int n = 0; n < draw_data->CmdListsCount; n++)
 	{
 		const ImDrawList* cmd_list = draw_data->CmdLists[n];
-		BufferUpdateDesc update = { vOffset.pBuffer, cmd_list->VtxBuffer.Data, 0, vtx_dst, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert) };
+		BufferUpdateDesc update = { mVertexOffset.pBuffer, cmd_list->VtxBuffer.Data, 0, vtx_dst, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert) };
 		updateResource(&update);
-		update = { iOffset.pBuffer, cmd_list->IdxBuffer.Data, 0, idx_dst, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx) };
+		update = { mIndexOffset.pBuffer, cmd_list->IdxBuffer.Data, 0, idx_dst, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx) };
 		updateResource(&update);
 
 		vtx_dst += (cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
@@ -880,25 +1035,13 @@ void ImguiGUIDriver::draw(Cmd* pCmd, float deltaTime,
 		{ 0.0f,	  0.0f,		 0.5f,	   0.0f },
 		{ (R + L) / (L - R),  (T + B) / (B - T),	0.5f,	  1.0f },
 	};
-	RingBufferOffset offset = getUniformBufferOffset(pRingBuffer, sizeof(mvp));
-	BufferUpdateDesc update = { offset.pBuffer, mvp, 0, offset.mOffset, sizeof(mvp) };
+	mUniformOffset = getUniformBufferOffset(pRingBuffer, sizeof(mvp));
+	BufferUpdateDesc update = { mUniformOffset.pBuffer, mvp, 0, mUniformOffset.mOffset, sizeof(mvp) };
 	updateResource(&update);
 
-	cmdSetViewport(pCmd, 0.0f, 0.0f, draw_data->DisplaySize.x, draw_data->DisplaySize.y, 0.0f, 1.0f);
-	cmdSetScissor(pCmd, (uint32_t)draw_data->DisplayPos.x, (uint32_t)draw_data->DisplayPos.y, (uint32_t)draw_data->DisplaySize.x, (uint32_t)draw_data->DisplaySize.y);
-	cmdBindPipeline(pCmd, pPipeline);
-	cmdBindIndexBuffer(pCmd, pPlainMeshRingBuffer->pIndexBuffer, iOffset.mOffset);
-	cmdBindVertexBuffer(pCmd, 1, &pPlainMeshRingBuffer->pVertexBuffer, &vOffset.mOffset);
-
-	DescriptorData params[1] = {};
-	params[0].pName = "uniformBlockVS";
-	params[0].pOffsets = &offset.mOffset;
-	params[0].ppBuffers = &offset.pBuffer;
-	cmdBindDescriptors(pCmd, pRootSignatureTextured, 1, params);
-
 	// Render command lists
-	int vtx_offset = 0;
-	int idx_offset = 0;
+	uint32_t vtx_offset = 0;
+	uint32_t idx_offset = 0;
 	ImVec2 pos = draw_data->DisplayPos;
 	for (int n = 0; n < draw_data->CmdListsCount; n++)
 	{
@@ -906,25 +1049,26 @@ void ImguiGUIDriver::draw(Cmd* pCmd, float deltaTime,
 		for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
 		{
 			const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+			UIDrawCmd drawCmd = {};
 			if (pcmd->UserCallback)
 			{
-				// User callback (registered via ImDrawList::AddCallback)
-				pcmd->UserCallback(cmd_list, pcmd);
+				drawCmd.pCallbackList = cmd_list;
+				drawCmd.pCallbackCmd = pcmd;
+				mDrawCmdsValid = false;
 			}
 			else
 			{
 				// Apply scissor/clipping rectangle
-				//const D3D12_RECT r = { (LONG)(pcmd->ClipRect.x - pos.x), (LONG)(pcmd->ClipRect.y - pos.y), (LONG)(pcmd->ClipRect.z - pos.x), (LONG)(pcmd->ClipRect.w - pos.y) };
-				//pCmd->pDxCmdList->RSSetScissorRects(1, &r);
-				cmdSetScissor(pCmd, (uint32_t)(pcmd->ClipRect.x - pos.x), (uint32_t)(pcmd->ClipRect.y - pos.y),
-					(uint32_t)(pcmd->ClipRect.z - pcmd->ClipRect.x), (uint32_t)(pcmd->ClipRect.w - pcmd->ClipRect.y));
-
-				DescriptorData params[1] = {};
-				params[0].pName = "uTex";
-				params[0].ppTextures = (Texture**)&pcmd->TextureId;
-				cmdBindDescriptors(pCmd, pRootSignatureTextured, 1, params);
-				cmdDrawIndexed(pCmd, pcmd->ElemCount, idx_offset, vtx_offset);
+				drawCmd.mScissor[0] = (uint32_t)(pcmd->ClipRect.x - pos.x);
+				drawCmd.mScissor[1] = (uint32_t)(pcmd->ClipRect.y - pos.y);
+				drawCmd.mScissor[2] = (uint32_t)(pcmd->ClipRect.z - pcmd->ClipRect.x);
+				drawCmd.mScissor[3] = (uint32_t)(pcmd->ClipRect.w - pcmd->ClipRect.y);
+				drawCmd.pTexture = (Texture*)pcmd->TextureId;
+				drawCmd.mIndexCount = pcmd->ElemCount;
+				drawCmd.mFirstIndex = idx_offset;
+				drawCmd.mFirstVertex = vtx_offset;
 			}
+			mDrawCmds.push_back(drawCmd);
 			idx_offset += pcmd->ElemCount;
 		}
 		vtx_offset += cmd_list->VtxBuffer.Size;